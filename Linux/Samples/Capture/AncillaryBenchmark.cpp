@@ -0,0 +1,371 @@
+/* -LICENSE-START-
+** Copyright (c) 2022 Blackmagic Design
+**  
+** Permission is hereby granted, free of charge, to any person or organization 
+** obtaining a copy of the software and accompanying documentation (the 
+** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+** and transmit the Software, and to prepare derivative works of the Software, 
+** and to permit third-parties to whom the Software is furnished to do so, in 
+** accordance with:
+** 
+** (1) if the Software is obtained from Blackmagic Design, the End User License 
+** Agreement for the Software Development Kit (“EULA”) available at 
+** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+** 
+** (2) if the Software is obtained from any third party, such licensing terms 
+** as notified by that third party,
+** 
+** and all subject to the following:
+** 
+** (3) the copyright notices in the Software and this entire statement, 
+** including the above license grant, this restriction and the following 
+** disclaimer, must be included in all copies of the Software, in whole or in 
+** part, and all derivative works of the Software, unless such copies or 
+** derivative works are solely in the form of machine-executable object code 
+** generated by a source language processor.
+** 
+** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+** DEALINGS IN THE SOFTWARE.
+** 
+** A copy of the Software is available free of charge at 
+** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+** 
+** -LICENSE-END-
+*/
+
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#include "AncillaryBenchmark.h"
+#include "AncillaryCodec.h"
+
+static const double		kFrameRate				= 30000.0 / 1001.0;
+static const unsigned	kFramesPerSecond		= 30;
+static const unsigned	kSCTE104Interval		= 30;		// Frames between splice requests
+static const size_t		kMaximumPayloads		= 16;
+
+namespace
+{
+
+enum
+{
+	kPacketPayloadIdentifier = 0,
+	kPacketAFDBarData,
+	kPacketTimecode,
+	kPacketSCTE104,
+	kPacketCaptions,		// Unknown to the codec, skipped by DID/SDID
+	kPacketAudioMetadata,	// Likewise
+	kPacketCount
+};
+
+// Iterator and frame stand-ins, returning the packets of an input as a capture would
+class BenchmarkPacketIterator : public IDeckLinkAncillaryPacketIterator
+{
+public:
+	BenchmarkPacketIterator() : m_packets(NULL), m_count(0), m_next(0) { }
+
+	void					reset(OutputAncillaryPacket** packets, size_t count) { m_packets = packets; m_count = count; m_next = 0; }
+
+	virtual HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid, LPVOID *ppv) { *ppv = NULL; return E_NOINTERFACE; }
+	virtual ULONG STDMETHODCALLTYPE AddRef(void) { return 1; }
+	virtual ULONG STDMETHODCALLTYPE Release(void) { return 1; }
+
+	virtual HRESULT STDMETHODCALLTYPE Next(IDeckLinkAncillaryPacket** packet)
+	{
+		if (m_next == m_count)
+		{
+			*packet = NULL;
+			return S_FALSE;
+		}
+		*packet = m_packets[m_next++];
+		(*packet)->AddRef();
+		return S_OK;
+	}
+
+private:
+	OutputAncillaryPacket**		m_packets;
+	size_t						m_count;
+	size_t						m_next;
+};
+
+class BenchmarkVideoFrame : public IDeckLinkVideoFrame, public IDeckLinkVideoFrameAncillaryPackets
+{
+public:
+	BenchmarkVideoFrame() : m_packets(NULL), m_count(0) { }
+
+	void					setPackets(OutputAncillaryPacket** packets, size_t count) { m_packets = packets; m_count = count; }
+
+	virtual HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid, LPVOID *ppv)
+	{
+		if (memcmp(&iid, &IID_IDeckLinkVideoFrameAncillaryPackets, sizeof(REFIID)) == 0)
+		{
+			*ppv = static_cast<IDeckLinkVideoFrameAncillaryPackets*>(this);
+			return S_OK;
+		}
+		*ppv = NULL;
+		return E_NOINTERFACE;
+	}
+	virtual ULONG STDMETHODCALLTYPE AddRef(void) { return 1; }
+	virtual ULONG STDMETHODCALLTYPE Release(void) { return 1; }
+
+	// IDeckLinkVideoFrame
+	virtual long STDMETHODCALLTYPE GetWidth(void) { return 1920; }
+	virtual long STDMETHODCALLTYPE GetHeight(void) { return 1080; }
+	virtual long STDMETHODCALLTYPE GetRowBytes(void) { return 1920 * 2; }
+	virtual BMDPixelFormat STDMETHODCALLTYPE GetPixelFormat(void) { return bmdFormat8BitYUV; }
+	virtual BMDFrameFlags STDMETHODCALLTYPE GetFlags(void) { return bmdFrameFlagDefault; }
+	virtual HRESULT STDMETHODCALLTYPE GetBytes(void** buffer) { return E_NOTIMPL; }
+	virtual HRESULT STDMETHODCALLTYPE GetTimecode(BMDTimecodeFormat format, IDeckLinkTimecode** timecode) { return S_FALSE; }
+	virtual HRESULT STDMETHODCALLTYPE GetAncillaryData(IDeckLinkVideoFrameAncillary** ancillary) { return E_NOTIMPL; }
+
+	// IDeckLinkVideoFrameAncillaryPackets
+	virtual HRESULT STDMETHODCALLTYPE GetPacketIterator(IDeckLinkAncillaryPacketIterator** iterator)
+	{
+		m_iterator.reset(m_packets, m_count);
+		*iterator = &m_iterator;
+		return S_OK;
+	}
+	virtual HRESULT STDMETHODCALLTYPE GetFirstPacketByID(uint8_t DID, uint8_t SDID, IDeckLinkAncillaryPacket** packet) { return E_NOTIMPL; }
+	virtual HRESULT STDMETHODCALLTYPE AttachPacket(IDeckLinkAncillaryPacket* packet) { return E_NOTIMPL; }
+	virtual HRESULT STDMETHODCALLTYPE DetachPacket(IDeckLinkAncillaryPacket* packet) { return E_NOTIMPL; }
+	virtual HRESULT STDMETHODCALLTYPE DetachAllPackets(void) { return E_NOTIMPL; }
+
+private:
+	BenchmarkPacketIterator		m_iterator;
+	OutputAncillaryPacket**		m_packets;
+	size_t						m_count;
+};
+
+struct BenchmarkInput
+{
+	OutputAncillaryPacket*		packets[kPacketCount];
+	AncillaryPayload			payloads[kPacketCount];
+	BenchmarkVideoFrame			frame;
+	AncillaryDecoder			decoder;
+};
+
+void setRawPacket(OutputAncillaryPacket* packet, uint8_t did, uint8_t sdid, uint8_t size)
+{
+	AncillaryPacketBuffer& buffer = packet->getBuffer();
+
+	buffer.did = did;
+	buffer.sdid = sdid;
+	buffer.size = size;
+	for (uint8_t i = 0; i < size; i++)
+		buffer.data[i] = i;
+}
+
+void initializeInput(BenchmarkInput& input, unsigned index)
+{
+	static const uint8_t kPayloadIdentifier1080i[4] = { 0x85, 0x06, 0x00, 0x01 };
+
+	for (unsigned i = 0; i < kPacketCount; i++)
+	{
+		input.packets[i] = new OutputAncillaryPacket(i < kPacketCaptions ? 10 + i : 9);
+		memset(&input.payloads[i], 0, sizeof(input.payloads[i]));
+	}
+
+	input.payloads[kPacketPayloadIdentifier].type = kAncillaryPayloadPayloadIdentifier;
+	memcpy(input.payloads[kPacketPayloadIdentifier].payloadIdentifier.bytes, kPayloadIdentifier1080i, sizeof(kPayloadIdentifier1080i));
+
+	// Pillarboxed 4:3 in a 16:9 frame
+	AFDBarData& afd = input.payloads[kPacketAFDBarData].afdBarData;
+	input.payloads[kPacketAFDBarData].type = kAncillaryPayloadAFDBarData;
+	afd.afd = 0x9;
+	afd.aspectRatio16x9 = true;
+	afd.barFlags = AFDBarData::kBarFlagLeft | AFDBarData::kBarFlagRight;
+	afd.barValue1 = 240;
+	afd.barValue2 = 1680;
+
+	AncillaryTimecode& timecode = input.payloads[kPacketTimecode].timecode;
+	input.payloads[kPacketTimecode].type = kAncillaryPayloadTimecode;
+	timecode.type = AncillaryTimecode::kTypeLTC;
+	timecode.hours = (uint8_t)(index % 24);
+	timecode.dropFrame = true;
+	timecode.userBits = 0x12345678 + index;
+
+	SCTE104Message& message = input.payloads[kPacketSCTE104].scte104;
+	input.payloads[kPacketSCTE104].type = kAncillaryPayloadSCTE104;
+	message.asIndex = (uint8_t)index;
+	message.operationCount = 2;
+
+	SCTE104SpliceRequest request;
+	request.spliceInsertType = kSCTE104SpliceStartNormal;
+	request.spliceEventID = 0;
+	request.uniqueProgramID = (uint16_t)index;
+	request.preRollTimeMs = 4000;
+	request.breakDuration = 300;
+	request.availNum = 1;
+	request.availsExpected = 1;
+	request.autoReturn = true;
+	SCTE104EncodeSpliceRequest(request, &message.operations[0]);
+	message.operations[1].opID = kSCTE104OpSpliceNull;
+	message.operations[1].dataLength = 0;
+
+	EncodeAncillaryPayload(input.payloads[kPacketPayloadIdentifier], &input.packets[kPacketPayloadIdentifier]->getBuffer());
+	EncodeAncillaryPayload(input.payloads[kPacketAFDBarData], &input.packets[kPacketAFDBarData]->getBuffer());
+	setRawPacket(input.packets[kPacketCaptions], 0x61, 0x01, 73);
+	setRawPacket(input.packets[kPacketAudioMetadata], 0x45, 0x01, 32);
+}
+
+// Advance the time code by one frame, drop frame numbering skips frames 0 and 1 of each minute but every tenth
+void advanceTimecode(AncillaryTimecode& timecode)
+{
+	if (++timecode.frames < kFramesPerSecond)
+		return;
+	timecode.frames = 0;
+	if (++timecode.seconds < 60)
+		return;
+	timecode.seconds = 0;
+	if (++timecode.minutes == 60)
+	{
+		timecode.minutes = 0;
+		timecode.hours = (uint8_t)((timecode.hours + 1) % 24);
+	}
+	if (timecode.dropFrame && timecode.minutes % 10 != 0)
+		timecode.frames = 2;
+}
+
+bool payloadsMatch(const AncillaryPayload& encoded, const AncillaryPayload& decoded)
+{
+	if (encoded.type != decoded.type)
+		return false;
+
+	switch (encoded.type)
+	{
+		case kAncillaryPayloadTimecode:
+			return encoded.timecode.hours == decoded.timecode.hours && encoded.timecode.minutes == decoded.timecode.minutes &&
+				encoded.timecode.seconds == decoded.timecode.seconds && encoded.timecode.frames == decoded.timecode.frames &&
+				encoded.timecode.dropFrame == decoded.timecode.dropFrame && encoded.timecode.type == decoded.timecode.type &&
+				encoded.timecode.userBits == decoded.timecode.userBits;
+
+		case kAncillaryPayloadSCTE104:
+		{
+			SCTE104SpliceRequest encodedRequest, decodedRequest;
+			return decoded.scte104.operationCount == encoded.scte104.operationCount &&
+				SCTE104DecodeSpliceRequest(encoded.scte104.operations[0], &encodedRequest) &&
+				SCTE104DecodeSpliceRequest(decoded.scte104.operations[0], &decodedRequest) &&
+				encodedRequest.spliceEventID == decodedRequest.spliceEventID &&
+				encodedRequest.preRollTimeMs == decodedRequest.preRollTimeMs &&
+				decoded.scte104.operations[1].opID == kSCTE104OpSpliceNull;
+		}
+
+		case kAncillaryPayloadAFDBarData:
+			return encoded.afdBarData.afd == decoded.afdBarData.afd && encoded.afdBarData.barFlags == decoded.afdBarData.barFlags &&
+				encoded.afdBarData.barValue1 == decoded.afdBarData.barValue1 && encoded.afdBarData.barValue2 == decoded.afdBarData.barValue2;
+
+		case kAncillaryPayloadPayloadIdentifier:
+			return memcmp(encoded.payloadIdentifier.bytes, decoded.payloadIdentifier.bytes, sizeof(decoded.payloadIdentifier.bytes)) == 0;
+
+		default:
+			return false;
+	}
+}
+
+}
+
+bool RunAncillaryBenchmark(unsigned inputCount, unsigned secondsOfVideo)
+{
+	unsigned					frameCount = (unsigned)(secondsOfVideo * kFrameRate);
+	std::vector<BenchmarkInput>	inputs(inputCount);
+	AncillaryPayload			decoded[kMaximumPayloads];
+	std::chrono::nanoseconds	encodeTime(0);
+	std::chrono::nanoseconds	decodeTime(0);
+	uint64_t					encodedPackets = 0;
+	uint64_t					mismatches = 0;
+	bool						encodeFailed = false;
+
+	for (unsigned i = 0; i < inputCount; i++)
+		initializeInput(inputs[i], i);
+
+	printf("Encoding and decoding %u seconds of 29.97 fps ancillary packets from %u inputs\n", secondsOfVideo, inputCount);
+
+	for (unsigned frame = 0; frame < frameCount; frame++)
+	{
+		bool sendSCTE104 = (frame % kSCTE104Interval) == 0;
+
+		// Time code changes every frame, a splice request is sent once a second
+		auto startTime = std::chrono::steady_clock::now();
+		for (BenchmarkInput& input : inputs)
+		{
+			advanceTimecode(input.payloads[kPacketTimecode].timecode);
+			encodeFailed |= !EncodeAncillaryPayload(input.payloads[kPacketTimecode], &input.packets[kPacketTimecode]->getBuffer());
+			encodedPackets++;
+
+			if (sendSCTE104)
+			{
+				SCTE104Message& message = input.payloads[kPacketSCTE104].scte104;
+				message.messageNumber++;
+				message.operations[0].data[4] = (uint8_t)(frame / kSCTE104Interval);	// Low byte of splice_event_id
+				encodeFailed |= !EncodeAncillaryPayload(input.payloads[kPacketSCTE104], &input.packets[kPacketSCTE104]->getBuffer());
+				encodedPackets++;
+			}
+		}
+		auto decodeStartTime = std::chrono::steady_clock::now();
+		encodeTime += decodeStartTime - startTime;
+
+		for (BenchmarkInput& input : inputs)
+		{
+			// The SCTE-104 packet is only attached on the frames that carry one
+			OutputAncillaryPacket* packets[kPacketCount];
+			size_t count = 0;
+			for (unsigned i = 0; i < kPacketCount; i++)
+			{
+				if (i != kPacketSCTE104 || sendSCTE104)
+					packets[count++] = input.packets[i];
+			}
+			input.frame.setPackets(packets, count);
+
+			auto frameStartTime = std::chrono::steady_clock::now();
+			size_t decodedCount = input.decoder.decode(&input.frame, decoded, kMaximumPayloads);
+			decodeTime += std::chrono::steady_clock::now() - frameStartTime;
+
+			for (size_t i = 0; i < decodedCount; i++)
+			{
+				const AncillaryPayload* encoded = NULL;
+				for (unsigned j = 0; j < kPacketCaptions && encoded == NULL; j++)
+				{
+					if (input.payloads[j].type == decoded[i].type)
+						encoded = &input.payloads[j];
+				}
+				if (encoded == NULL || !payloadsMatch(*encoded, decoded[i]))
+					mismatches++;
+			}
+		}
+	}
+
+	AncillaryDecoder::Statistics total;
+	memset(&total, 0, sizeof(total));
+	for (BenchmarkInput& input : inputs)
+	{
+		const AncillaryDecoder::Statistics& statistics = input.decoder.getStatistics();
+		total.packets	+= statistics.packets;
+		total.decoded	+= statistics.decoded;
+		total.unknown	+= statistics.unknown;
+		total.malformed	+= statistics.malformed;
+		total.dropped	+= statistics.dropped;
+
+		for (unsigned i = 0; i < kPacketCount; i++)
+			input.packets[i]->Release();
+	}
+
+	double decodeNsPerPacket = (double)decodeTime.count() / (double)total.packets;
+	double encodeNsPerPacket = (double)encodeTime.count() / (double)encodedPackets;
+
+	printf("  Decode: %.0f ns per packet (%llu packets, %llu decoded, %llu unknown skipped), %.3f%% of one CPU for %u inputs at 29.97 fps\n",
+			decodeNsPerPacket, (unsigned long long)total.packets, (unsigned long long)total.decoded, (unsigned long long)total.unknown,
+			(double)decodeTime.count() * 1e-9 / (frameCount / kFrameRate) * 100.0, inputCount);
+	printf("  Encode: %.0f ns per packet (%llu packets)\n", encodeNsPerPacket, (unsigned long long)encodedPackets);
+	printf("  Errors: %llu malformed, %llu dropped, %llu round trip mismatches%s\n",
+			(unsigned long long)total.malformed, (unsigned long long)total.dropped, (unsigned long long)mismatches,
+			encodeFailed ? ", encode failed" : "");
+
+	return total.malformed == 0 && total.dropped == 0 && mismatches == 0 && !encodeFailed;
+}
@@ -0,0 +1,271 @@
+/* -LICENSE-START-
+** Copyright (c) 2022 Blackmagic Design
+**  
+** Permission is hereby granted, free of charge, to any person or organization 
+** obtaining a copy of the software and accompanying documentation (the 
+** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+** and transmit the Software, and to prepare derivative works of the Software, 
+** and to permit third-parties to whom the Software is furnished to do so, in 
+** accordance with:
+** 
+** (1) if the Software is obtained from Blackmagic Design, the End User License 
+** Agreement for the Software Development Kit (“EULA”) available at 
+** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+** 
+** (2) if the Software is obtained from any third party, such licensing terms 
+** as notified by that third party,
+** 
+** and all subject to the following:
+** 
+** (3) the copyright notices in the Software and this entire statement, 
+** including the above license grant, this restriction and the following 
+** disclaimer, must be included in all copies of the Software, in whole or in 
+** part, and all derivative works of the Software, unless such copies or 
+** derivative works are solely in the form of machine-executable object code 
+** generated by a source language processor.
+** 
+** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+** DEALINGS IN THE SOFTWARE.
+** 
+** A copy of the Software is available free of charge at 
+** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+** 
+** -LICENSE-END-
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "DeckLinkAPI.h"
+
+// Encoding and decoding of common SMPTE 291 ancillary data packets.
+//
+// Each payload type has one entry in a codec table, giving its DID/SDID, user data word limits and its encode and
+// decode functions.  A two-level DID then SDID lookup maps a packet to its entry in constant time, so packets of
+// unknown types are skipped without reading their user data words.  Packets are encoded into fixed-size buffers and
+// decoded into fixed-size structures, so neither allocates.
+
+enum AncillaryPayloadType
+{
+	kAncillaryPayloadUnknown = 0,
+	kAncillaryPayloadPayloadIdentifier,		// SMPTE 352 video payload identifier (VPID)
+	kAncillaryPayloadAFDBarData,			// SMPTE 2016-3 active format description and bar data
+	kAncillaryPayloadSCTE104,				// SMPTE 2010 SCTE-104 messages
+	kAncillaryPayloadTimecode,				// SMPTE 12-2 ancillary time code (ATC)
+	kAncillaryPayloadTypeCount
+};
+
+// User data words of one packet, the largest a SMPTE 291 type 2 packet can carry
+struct AncillaryPacketBuffer
+{
+	static const size_t kMaximumSize = 255;
+
+	uint8_t		did;
+	uint8_t		sdid;
+	uint8_t		size;
+	uint8_t		data[kMaximumSize];
+};
+
+// SMPTE 352, the 4 payload identifier bytes with accessors for the common fields
+struct PayloadIdentifier
+{
+	uint8_t		bytes[4];
+
+	uint8_t		getPayloadType() const { return bytes[0]; }					// Byte 1, e.g. 0x85 for 1080-line 1.5 Gb/s
+	bool		isProgressiveTransport() const { return (bytes[1] & 0x80) != 0; }
+	bool		isProgressivePicture() const { return (bytes[1] & 0x40) != 0; }
+	uint8_t		getPictureRate() const { return bytes[1] & 0x0F; }
+	uint8_t		getSamplingStructure() const { return bytes[2] & 0x0F; }
+	uint8_t		getBitDepth() const { return bytes[3] & 0x03; }
+};
+
+// SMPTE 2016-1 AFD code and SMPTE 2016-3 bar data
+struct AFDBarData
+{
+	static const uint8_t kBarFlagTop	= 0x8;
+	static const uint8_t kBarFlagBottom	= 0x4;
+	static const uint8_t kBarFlagLeft	= 0x2;
+	static const uint8_t kBarFlagRight	= 0x1;
+
+	uint8_t		afd;					// 4-bit active format description
+	bool		aspectRatio16x9;		// Coded frame is 16:9, otherwise 4:3
+	uint8_t		barFlags;				// Which of the bar values are present, kBarFlag*
+	uint16_t	barValue1;				// Top or left bar end line or pixel
+	uint16_t	barValue2;				// Bottom or right bar start line or pixel
+};
+
+// SCTE 104 operation identifiers
+enum
+{
+	kSCTE104OpSpliceRequest		= 0x0101,
+	kSCTE104OpSpliceNull		= 0x0102,
+	kSCTE104OpTimeSignal		= 0x0104
+};
+
+// SCTE 104 splice_insert_type
+enum
+{
+	kSCTE104SpliceStartNormal		= 1,
+	kSCTE104SpliceStartImmediate	= 2,
+	kSCTE104SpliceEndNormal			= 3,
+	kSCTE104SpliceEndImmediate		= 4,
+	kSCTE104SpliceCancel			= 5
+};
+
+// SCTE 104 splice_request_data
+struct SCTE104SpliceRequest
+{
+	uint8_t		spliceInsertType;
+	uint32_t	spliceEventID;
+	uint16_t	uniqueProgramID;
+	uint16_t	preRollTimeMs;
+	uint16_t	breakDuration;			// Tenths of a second
+	uint8_t		availNum;
+	uint8_t		availsExpected;
+	bool		autoReturn;
+};
+
+struct SCTE104Operation
+{
+	static const size_t kMaximumDataSize = 32;
+
+	uint16_t	opID;
+	uint16_t	dataLength;
+	uint8_t		data[kMaximumDataSize];
+};
+
+// SCTE 104 multiple_operation_message carried in one SMPTE 2010 packet
+struct SCTE104Message
+{
+	static const size_t kMaximumOperations = 4;
+
+	// timestamp() time_type
+	enum
+	{
+		kTimeTypeNone = 0,
+		kTimeTypeUTC,
+		kTimeTypeVITC,
+		kTimeTypeGPI
+	};
+
+	uint8_t				asIndex;
+	uint8_t				messageNumber;
+	uint16_t			dpiPIDIndex;
+	uint8_t				timeType;
+	uint8_t				timestamp[6];	// UTC seconds and microseconds, VITC hours, minutes, seconds and frames, or GPI number and edge
+	uint8_t				operationCount;
+	SCTE104Operation	operations[kMaximumOperations];
+};
+
+// SMPTE 12-2 ancillary time code, with the field layout of 30 fps and lower frame rates
+struct AncillaryTimecode
+{
+	// Distributed binary bit group 1, the ATC type
+	enum
+	{
+		kTypeLTC	= 0x00,
+		kTypeVITC1	= 0x01,
+		kTypeVITC2	= 0x02
+	};
+
+	uint8_t		type;
+	uint8_t		dbb2;
+	uint8_t		hours;
+	uint8_t		minutes;
+	uint8_t		seconds;
+	uint8_t		frames;
+	bool		dropFrame;
+	bool		colorFrame;
+	bool		fieldMark;
+	uint8_t		binaryGroupFlags;		// BGF0 to BGF2
+	uint32_t	userBits;				// Binary groups 1 to 8, group 1 in the low nibble
+};
+
+// One decoded packet
+struct AncillaryPayload
+{
+	AncillaryPayloadType	type;
+	uint32_t				lineNumber;
+	union
+	{
+		PayloadIdentifier	payloadIdentifier;
+		AFDBarData			afdBarData;
+		SCTE104Message		scte104;
+		AncillaryTimecode	timecode;
+	};
+};
+
+// SCTE 104 splice_request_data to and from the data of an operation
+void SCTE104EncodeSpliceRequest(const SCTE104SpliceRequest& request, SCTE104Operation* operation);
+bool SCTE104DecodeSpliceRequest(const SCTE104Operation& operation, SCTE104SpliceRequest* request);
+
+// Encode a payload into the user data words of a packet, returns false if the payload cannot be represented
+bool EncodeAncillaryPayload(const AncillaryPayload& payload, AncillaryPacketBuffer* packet);
+
+// Payload type of a DID/SDID, in constant time
+AncillaryPayloadType GetAncillaryPayloadType(uint8_t did, uint8_t sdid);
+
+const char* GetAncillaryPayloadName(AncillaryPayloadType type);
+
+// Decode the user data words of a packet of a known type, returns false if they are malformed
+bool DecodeAncillaryPayload(AncillaryPayloadType type, const uint8_t* data, uint32_t size, AncillaryPayload* payload);
+
+// Decode every known packet attached to a frame, in one pass over IDeckLinkAncillaryPacketIterator
+class AncillaryDecoder
+{
+public:
+	struct Statistics
+	{
+		uint64_t	packets;			// Packets seen on the iterator
+		uint64_t	decoded;
+		uint64_t	unknown;			// DID/SDID without a codec, skipped
+		uint64_t	malformed;
+		uint64_t	dropped;			// Decoded packets beyond the capacity of the output array
+	};
+
+	AncillaryDecoder();
+
+	// Returns the number of payloads written
+	size_t					decode(IDeckLinkVideoFrame* videoFrame, AncillaryPayload* payloads, size_t maximumPayloads);
+
+	const Statistics&		getStatistics() const { return m_statistics; }
+
+private:
+	Statistics				m_statistics;
+};
+
+// Preallocated packet for output, attach it to a frame's IDeckLinkVideoFrameAncillaryPackets once and re-encode
+// its buffer for each frame
+class OutputAncillaryPacket : public IDeckLinkAncillaryPacket
+{
+public:
+	explicit OutputAncillaryPacket(uint32_t lineNumber = 0);
+
+	AncillaryPacketBuffer&	getBuffer() { return m_buffer; }
+
+	// IUnknown
+	virtual HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid, LPVOID *ppv);
+	virtual ULONG STDMETHODCALLTYPE AddRef(void);
+	virtual ULONG STDMETHODCALLTYPE Release(void);
+
+	// IDeckLinkAncillaryPacket
+	virtual HRESULT STDMETHODCALLTYPE GetBytes(BMDAncillaryPacketFormat format, const void** data, uint32_t* size);
+	virtual uint8_t STDMETHODCALLTYPE GetDID(void);
+	virtual uint8_t STDMETHODCALLTYPE GetSDID(void);
+	virtual uint32_t STDMETHODCALLTYPE GetLineNumber(void);
+	virtual uint8_t STDMETHODCALLTYPE GetDataStreamIndex(void);
+
+protected:
+	virtual ~OutputAncillaryPacket() { }
+
+private:
+	int32_t					m_refCount;
+	uint32_t				m_lineNumber;
+	AncillaryPacketBuffer	m_buffer;
+};
@@ -0,0 +1,248 @@
+/* -LICENSE-START-
+** Copyright (c) 2022 Blackmagic Design
+**  
+** Permission is hereby granted, free of charge, to any person or organization 
+** obtaining a copy of the software and accompanying documentation (the 
+** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+** and transmit the Software, and to prepare derivative works of the Software, 
+** and to permit third-parties to whom the Software is furnished to do so, in 
+** accordance with:
+** 
+** (1) if the Software is obtained from Blackmagic Design, the End User License 
+** Agreement for the Software Development Kit (“EULA”) available at 
+** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+** 
+** (2) if the Software is obtained from any third party, such licensing terms 
+** as notified by that third party,
+** 
+** and all subject to the following:
+** 
+** (3) the copyright notices in the Software and this entire statement, 
+** including the above license grant, this restriction and the following 
+** disclaimer, must be included in all copies of the Software, in whole or in 
+** part, and all derivative works of the Software, unless such copies or 
+** derivative works are solely in the form of machine-executable object code 
+** generated by a source language processor.
+** 
+** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+** DEALINGS IN THE SOFTWARE.
+** 
+** A copy of the Software is available free of charge at 
+** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+** 
+** -LICENSE-END-
+*/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+
+// The AsyncLogger records binary log events from real-time threads (such as DeckLink callbacks) into
+// preallocated per-thread ring buffers. Each event holds the format string pointer (which identifies
+// the message), a timestamp and a copy of the arguments. A background thread drains the rings and
+// performs the printf formatting, so that logging never blocks or allocates on the calling thread.
+//
+// Format strings must have static storage duration (string literals).  Arguments must be trivially
+// copyable; string arguments that do not have static storage should be wrapped in LogString, so that
+// their contents are copied into the event.
+
+// Fixed-size copy of a string argument
+struct LogString
+{
+	static const size_t kMaxLength = 63;
+
+	LogString(const char* str)
+	{
+		if (str)
+		{
+			strncpy(text, str, kMaxLength);
+			text[kMaxLength] = '\0';
+		}
+		else
+			text[0] = '\0';
+	}
+
+	char	text[kMaxLength + 1];
+};
+
+// Limits the number of events logged per second from a single call site
+class LogRateLimiter
+{
+public:
+	LogRateLimiter(uint32_t maxEventsPerSecond);
+
+	bool							allow(int64_t timestampNs);
+
+private:
+	uint32_t						m_maxEventsPerSecond;
+	std::atomic<int64_t>			m_windowStart;
+	std::atomic<uint32_t>			m_eventCount;
+};
+
+class AsyncLogger
+{
+	using FormatFunction = void(*)(FILE*, const char*, const void*);
+
+	static const size_t kMaxArgumentBytes = 104;
+
+	struct LogEvent
+	{
+		const char*			format;
+		FormatFunction		formatFunction;
+		int64_t				timestamp;
+		alignas(8) unsigned char arguments[kMaxArgumentBytes];
+	};
+
+	// Single-producer/single-consumer ring, owned by one logging thread at a time
+	struct LogRing
+	{
+		std::unique_ptr<LogEvent[]>		events;
+		uint64_t						mask;
+		std::atomic<bool>				claimed;
+		std::atomic<uint64_t>			writeIndex;
+		char							padding[64];		// Keep producer and consumer indexes on separate cache lines
+		std::atomic<uint64_t>			readIndex;
+	};
+
+	// Preallocated producer rings. A thread returns its ring when it exits, events still pending in it are
+	// drained as usual. The pool is shared with the threads holding its rings, so that a thread outliving
+	// the logger can still return its ring.
+	struct RingPool
+	{
+		RingPool(size_t ringCount, uint64_t ringCapacity);
+
+		LogRing*						claim(void);
+		void							release(LogRing* ring);
+
+		std::unique_ptr<LogRing[]>		rings;
+		size_t							ringCount;
+		std::atomic<size_t>				ringsUsed;		// Rings below this index have been claimed at least once
+	};
+
+public:
+	static const size_t kDefaultRingCapacity	= 1024;		// Events per producer thread, rounded up to power of 2
+	static const size_t kDefaultMaxThreads		= 32;		// Number of preallocated producer rings
+	static const int	kDrainIntervalMs		= 10;		// Background thread wake-up period
+
+	AsyncLogger(FILE* output = stdout, size_t ringCapacity = kDefaultRingCapacity, size_t maxThreads = kDefaultMaxThreads);
+	virtual ~AsyncLogger();
+
+	template<typename... Args>
+	void				log(const char* format, Args... args);
+
+	template<typename... Args>
+	void				log(LogRateLimiter& rateLimiter, const char* format, Args... args);
+
+	// Synchronously format all pending events, should not be called from real-time threads
+	void				flush(void);
+
+	void				setTimestampsEnabled(bool enabled) { m_timestampsEnabled = enabled; }
+	uint64_t			getDroppedCount(void) const { return m_droppedCount.load(std::memory_order_relaxed); }
+	uint64_t			getSuppressedCount(void) const { return m_suppressedCount.load(std::memory_order_relaxed); }
+
+	static int64_t		getTimestamp(void)
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+private:
+	FILE*								m_output;
+	uint64_t							m_ringCapacity;
+	std::shared_ptr<RingPool>			m_ringPool;
+	//
+	std::atomic<uint64_t>				m_droppedCount;
+	std::atomic<uint64_t>				m_suppressedCount;
+	uint64_t							m_reportedDroppedCount;
+	bool								m_timestampsEnabled;
+	//
+	std::mutex							m_drainMutex;
+	std::mutex							m_writerMutex;
+	std::condition_variable				m_writerCondition;
+	bool								m_stopWriter;
+	std::thread							m_writerThread;
+
+	LogEvent*			beginEvent(LogRing* ring);
+	void				commitEvent(LogRing* ring);
+	LogRing*			getThreadRing(void);
+	void				drainRings(void);
+	void				writerThread(void);
+
+	// C++11 replacement for std::index_sequence
+	template<size_t... I> struct IndexSequence {};
+	template<size_t N, size_t... I> struct MakeIndexSequence : MakeIndexSequence<N - 1, N - 1, I...> {};
+	template<size_t... I> struct MakeIndexSequence<0, I...> { using type = IndexSequence<I...>; };
+
+	// std::tuple is not itself trivially copyable, so its elements are checked individually
+	template<typename... T> struct AllTriviallyCopyable : std::true_type {};
+	template<typename T, typename... Rest> struct AllTriviallyCopyable<T, Rest...> :
+		std::integral_constant<bool, std::is_trivially_copyable<T>::value && AllTriviallyCopyable<Rest...>::value> {};
+
+	template<typename T>
+	static T						formatArgument(const T& arg) { return arg; }
+	static const char*				formatArgument(const LogString& arg) { return arg.text; }
+
+	template<typename Tuple>
+	static void						formatArguments(FILE* output, const char* format, const Tuple&, IndexSequence<>) { fputs(format, output); }
+
+	template<typename Tuple, size_t... I>
+	static void						formatArguments(FILE* output, const char* format, const Tuple& arguments, IndexSequence<I...>)
+	{
+		fprintf(output, format, formatArgument(std::get<I>(arguments))...);
+	}
+
+	template<typename... Args>
+	static void						formatEvent(FILE* output, const char* format, const void* arguments)
+	{
+		using ArgumentTuple = std::tuple<Args...>;
+		formatArguments(output, format, *reinterpret_cast<const ArgumentTuple*>(arguments), typename MakeIndexSequence<sizeof...(Args)>::type());
+	}
+};
+
+template<typename... Args>
+void AsyncLogger::log(const char* format, Args... args)
+{
+	using ArgumentTuple = std::tuple<Args...>;
+	static_assert(sizeof(ArgumentTuple) <= kMaxArgumentBytes, "Too many log arguments");
+	static_assert(alignof(ArgumentTuple) <= 8, "Unsupported log argument alignment");
+	static_assert(AllTriviallyCopyable<Args...>::value, "Log arguments must be trivially copyable");
+
+	LogRing* ring = getThreadRing();
+	LogEvent* event = beginEvent(ring);
+	if (event == nullptr)
+		return;
+
+	event->format			= format;
+	event->formatFunction	= &AsyncLogger::formatEvent<Args...>;
+	event->timestamp		= getTimestamp();
+	new (event->arguments) ArgumentTuple(args...);
+
+	commitEvent(ring);
+}
+
+template<typename... Args>
+void AsyncLogger::log(LogRateLimiter& rateLimiter, const char* format, Args... args)
+{
+	if (!rateLimiter.allow(getTimestamp()))
+	{
+		m_suppressedCount.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	log(format, args...);
+}
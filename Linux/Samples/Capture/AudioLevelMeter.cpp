@@ -0,0 +1,924 @@
+/* -LICENSE-START-
+** Copyright (c) 2022 Blackmagic Design
+**  
+** Permission is hereby granted, free of charge, to any person or organization 
+** obtaining a copy of the software and accompanying documentation (the 
+** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+** and transmit the Software, and to prepare derivative works of the Software, 
+** and to permit third-parties to whom the Software is furnished to do so, in 
+** accordance with:
+** 
+** (1) if the Software is obtained from Blackmagic Design, the End User License 
+** Agreement for the Software Development Kit (“EULA”) available at 
+** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+** 
+** (2) if the Software is obtained from any third party, such licensing terms 
+** as notified by that third party,
+** 
+** and all subject to the following:
+** 
+** (3) the copyright notices in the Software and this entire statement, 
+** including the above license grant, this restriction and the following 
+** disclaimer, must be included in all copies of the Software, in whole or in 
+** part, and all derivative works of the Software, unless such copies or 
+** derivative works are solely in the form of machine-executable object code 
+** generated by a source language processor.
+** 
+** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+** DEALINGS IN THE SOFTWARE.
+** 
+** A copy of the Software is available free of charge at 
+** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+** 
+** -LICENSE-END-
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#include "AudioLevelMeter.h"
+
+static const float		kInt16Scale				= 1.0f / 32768.0f;
+static const float		kInt32Scale				= 1.0f / 2147483648.0f;
+static const uint32_t	kTruePeakPhases			= 4;
+static const uint32_t	kTruePeakTapsPerPhase	= 12;
+static const uint32_t	kVectorSamples			= 8;			// Accumulator lanes are a multiple of the widest vector
+static const double		kAbsoluteGate			= -70.0;		// LUFS
+static const double		kRelativeGate			= -10.0;		// LU below the absolute-gated loudness
+static const double		kGatingBinsPerLU		= 10.0;
+static const double		kDenormalThreshold		= 1e-20;
+
+// BS.1770-4 weights of mono, stereo, 5.1 and 7.1 programmes in SMPTE channel order.  Channels between 60 and 120
+// degrees azimuth (the 5.1 surrounds and 7.1 side surrounds) are weighted by 1.41, LFE is excluded.
+static const double		kMonoWeights[]			= { 1.0 };
+static const double		kStereoWeights[]		= { 1.0, 1.0 };
+static const double		k51Weights[]			= { 1.0, 1.0, 1.0, 0.0, 1.41, 1.41 };
+static const double		k71Weights[]			= { 1.0, 1.0, 1.0, 0.0, 1.41, 1.41, 1.0, 1.0 };
+
+static const double* getLoudnessWeights(uint32_t channelCount)
+{
+	switch (channelCount)
+	{
+		case 1:		return kMonoWeights;
+		case 2:		return kStereoWeights;
+		case 6:		return k51Weights;
+		case 8:		return k71Weights;
+		default:	return nullptr;
+	}
+}
+
+static uint32_t greatestCommonDivisor(uint32_t a, uint32_t b)
+{
+	while (b != 0)
+	{
+		uint32_t remainder = a % b;
+		a = b;
+		b = remainder;
+	}
+	return a;
+}
+
+static inline void accumulateSample(float sample, float* peak, float* sumSquares, uint32_t& lane, uint32_t period)
+{
+	peak[lane] = std::max(peak[lane], std::fabs(sample));
+	sumSquares[lane] += sample * sample;
+	if (++lane == period)
+		lane = 0;
+}
+
+// Measure kernels
+//
+// Convert count interleaved samples to float and accumulate their peak and sum of squares.  Accumulator lane i
+// holds every period'th sample starting at i, the period is a multiple of both the channel count and 8 so each
+// lane only sees one channel.
+
+static void measureSamples16Scalar(const void* input, float* output, size_t count, uint32_t period, float* peak, float* sumSquares)
+{
+	const int16_t*	samples = (const int16_t*)input;
+	uint32_t		lane = 0;
+
+	for (size_t i = 0; i < count; i++)
+	{
+		output[i] = samples[i] * kInt16Scale;
+		accumulateSample(output[i], peak, sumSquares, lane, period);
+	}
+}
+
+static void measureSamples32Scalar(const void* input, float* output, size_t count, uint32_t period, float* peak, float* sumSquares)
+{
+	const int32_t*	samples = (const int32_t*)input;
+	uint32_t		lane = 0;
+
+	for (size_t i = 0; i < count; i++)
+	{
+		output[i] = samples[i] * kInt32Scale;
+		accumulateSample(output[i], peak, sumSquares, lane, period);
+	}
+}
+
+// True-peak kernels
+//
+// Each sample is interpolated to 4 phases by a polyphase FIR filter, tap k of a phase is the same channel k frames
+// earlier.  samples must be preceded by kTruePeakTapsPerPhase - 1 frames of history.  Coefficients are ordered by
+// tap then phase.
+
+static inline float interpolatedPeak(const float* samples, uint32_t channelCount, const float* coefficients)
+{
+	float phase[kTruePeakPhases] = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+	for (uint32_t tap = 0; tap < kTruePeakTapsPerPhase; tap++, samples -= channelCount, coefficients += kTruePeakPhases)
+	{
+		float sample = *samples;
+		for (unsigned i = 0; i < kTruePeakPhases; i++)
+			phase[i] += sample * coefficients[i];
+	}
+
+	return std::max(std::max(std::fabs(phase[0]), std::fabs(phase[1])), std::max(std::fabs(phase[2]), std::fabs(phase[3])));
+}
+
+static void truePeakTail(const float* samples, size_t start, size_t count, uint32_t channelCount, const float* coefficients, uint32_t period, float* truePeak)
+{
+	uint32_t lane = start % period;
+
+	for (size_t i = start; i < count; i++)
+	{
+		truePeak[lane] = std::max(truePeak[lane], interpolatedPeak(samples + i, channelCount, coefficients));
+		if (++lane == period)
+			lane = 0;
+	}
+}
+
+static void truePeakScalar(const float* samples, size_t count, uint32_t channelCount, const float* coefficients, uint32_t period, float* truePeak)
+{
+	truePeakTail(samples, 0, count, channelCount, coefficients, period, truePeak);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("avx2")))
+static inline void accumulateAVX2(__m256 sample, float* peak, float* sumSquares)
+{
+	const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+
+	_mm256_storeu_ps(peak, _mm256_max_ps(_mm256_loadu_ps(peak), _mm256_and_ps(sample, absMask)));
+	_mm256_storeu_ps(sumSquares, _mm256_add_ps(_mm256_loadu_ps(sumSquares), _mm256_mul_ps(sample, sample)));
+}
+
+__attribute__((target("avx2")))
+static void measureSamples16AVX2(const void* input, float* output, size_t count, uint32_t period, float* peak, float* sumSquares)
+{
+	const int16_t*	samples = (const int16_t*)input;
+	const __m256	scale = _mm256_set1_ps(kInt16Scale);
+	uint32_t		lane = 0;
+	size_t			i = 0;
+
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256i integers = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(samples + i)));
+		__m256 sample = _mm256_mul_ps(_mm256_cvtepi32_ps(integers), scale);
+
+		_mm256_storeu_ps(output + i, sample);
+		accumulateAVX2(sample, peak + lane, sumSquares + lane);
+
+		lane += 8;
+		if (lane == period)
+			lane = 0;
+	}
+
+	for (; i < count; i++)
+	{
+		output[i] = samples[i] * kInt16Scale;
+		accumulateSample(output[i], peak, sumSquares, lane, period);
+	}
+}
+
+__attribute__((target("avx2")))
+static void measureSamples32AVX2(const void* input, float* output, size_t count, uint32_t period, float* peak, float* sumSquares)
+{
+	const int32_t*	samples = (const int32_t*)input;
+	const __m256	scale = _mm256_set1_ps(kInt32Scale);
+	uint32_t		lane = 0;
+	size_t			i = 0;
+
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256 sample = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_loadu_si256((const __m256i*)(samples + i))), scale);
+
+		_mm256_storeu_ps(output + i, sample);
+		accumulateAVX2(sample, peak + lane, sumSquares + lane);
+
+		lane += 8;
+		if (lane == period)
+			lane = 0;
+	}
+
+	for (; i < count; i++)
+	{
+		output[i] = samples[i] * kInt32Scale;
+		accumulateSample(output[i], peak, sumSquares, lane, period);
+	}
+}
+
+__attribute__((target("avx2")))
+static void truePeakAVX2(const float* samples, size_t count, uint32_t channelCount, const float* coefficients, uint32_t period, float* truePeak)
+{
+	const __m256	absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+	uint32_t		lane = 0;
+	size_t			i = 0;
+
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256 phase0 = _mm256_setzero_ps();
+		__m256 phase1 = _mm256_setzero_ps();
+		__m256 phase2 = _mm256_setzero_ps();
+		__m256 phase3 = _mm256_setzero_ps();
+		const float* tapSamples = samples + i;
+
+		for (uint32_t tap = 0; tap < kTruePeakTapsPerPhase; tap++, tapSamples -= channelCount)
+		{
+			__m256 sample = _mm256_loadu_ps(tapSamples);
+			phase0 = _mm256_add_ps(phase0, _mm256_mul_ps(sample, _mm256_broadcast_ss(coefficients + tap * 4 + 0)));
+			phase1 = _mm256_add_ps(phase1, _mm256_mul_ps(sample, _mm256_broadcast_ss(coefficients + tap * 4 + 1)));
+			phase2 = _mm256_add_ps(phase2, _mm256_mul_ps(sample, _mm256_broadcast_ss(coefficients + tap * 4 + 2)));
+			phase3 = _mm256_add_ps(phase3, _mm256_mul_ps(sample, _mm256_broadcast_ss(coefficients + tap * 4 + 3)));
+		}
+
+		__m256 peak = _mm256_max_ps(_mm256_max_ps(_mm256_and_ps(phase0, absMask), _mm256_and_ps(phase1, absMask)),
+									_mm256_max_ps(_mm256_and_ps(phase2, absMask), _mm256_and_ps(phase3, absMask)));
+		_mm256_storeu_ps(truePeak + lane, _mm256_max_ps(_mm256_loadu_ps(truePeak + lane), peak));
+
+		lane += 8;
+		if (lane == period)
+			lane = 0;
+	}
+
+	truePeakTail(samples, i, count, channelCount, coefficients, period, truePeak);
+}
+#elif defined(__aarch64__)
+static inline void accumulateNEON(float32x4_t sample, float* peak, float* sumSquares)
+{
+	vst1q_f32(peak, vmaxq_f32(vld1q_f32(peak), vabsq_f32(sample)));
+	vst1q_f32(sumSquares, vmlaq_f32(vld1q_f32(sumSquares), sample, sample));
+}
+
+static void measureSamples16NEON(const void* input, float* output, size_t count, uint32_t period, float* peak, float* sumSquares)
+{
+	const int16_t*	samples = (const int16_t*)input;
+	uint32_t		lane = 0;
+	size_t			i = 0;
+
+	for (; i + 8 <= count; i += 8)
+	{
+		int16x8_t integers = vld1q_s16(samples + i);
+		float32x4_t sampleLow = vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(integers))), kInt16Scale);
+		float32x4_t sampleHigh = vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(integers))), kInt16Scale);
+
+		vst1q_f32(output + i, sampleLow);
+		vst1q_f32(output + i + 4, sampleHigh);
+		accumulateNEON(sampleLow, peak + lane, sumSquares + lane);
+		accumulateNEON(sampleHigh, peak + lane + 4, sumSquares + lane + 4);
+
+		lane += 8;
+		if (lane == period)
+			lane = 0;
+	}
+
+	for (; i < count; i++)
+	{
+		output[i] = samples[i] * kInt16Scale;
+		accumulateSample(output[i], peak, sumSquares, lane, period);
+	}
+}
+
+static void measureSamples32NEON(const void* input, float* output, size_t count, uint32_t period, float* peak, float* sumSquares)
+{
+	const int32_t*	samples = (const int32_t*)input;
+	uint32_t		lane = 0;
+	size_t			i = 0;
+
+	for (; i + 8 <= count; i += 8)
+	{
+		float32x4_t sampleLow = vmulq_n_f32(vcvtq_f32_s32(vld1q_s32(samples + i)), kInt32Scale);
+		float32x4_t sampleHigh = vmulq_n_f32(vcvtq_f32_s32(vld1q_s32(samples + i + 4)), kInt32Scale);
+
+		vst1q_f32(output + i, sampleLow);
+		vst1q_f32(output + i + 4, sampleHigh);
+		accumulateNEON(sampleLow, peak + lane, sumSquares + lane);
+		accumulateNEON(sampleHigh, peak + lane + 4, sumSquares + lane + 4);
+
+		lane += 8;
+		if (lane == period)
+			lane = 0;
+	}
+
+	for (; i < count; i++)
+	{
+		output[i] = samples[i] * kInt32Scale;
+		accumulateSample(output[i], peak, sumSquares, lane, period);
+	}
+}
+
+static void truePeakNEON(const float* samples, size_t count, uint32_t channelCount, const float* coefficients, uint32_t period, float* truePeak)
+{
+	uint32_t	lane = 0;
+	size_t		i = 0;
+
+	for (; i + 4 <= count; i += 4)
+	{
+		float32x4_t phase0 = vdupq_n_f32(0.0f);
+		float32x4_t phase1 = vdupq_n_f32(0.0f);
+		float32x4_t phase2 = vdupq_n_f32(0.0f);
+		float32x4_t phase3 = vdupq_n_f32(0.0f);
+		const float* tapSamples = samples + i;
+
+		for (uint32_t tap = 0; tap < kTruePeakTapsPerPhase; tap++, tapSamples -= channelCount)
+		{
+			float32x4_t sample = vld1q_f32(tapSamples);
+			float32x4_t tapCoefficients = vld1q_f32(coefficients + tap * 4);
+			phase0 = vfmaq_laneq_f32(phase0, sample, tapCoefficients, 0);
+			phase1 = vfmaq_laneq_f32(phase1, sample, tapCoefficients, 1);
+			phase2 = vfmaq_laneq_f32(phase2, sample, tapCoefficients, 2);
+			phase3 = vfmaq_laneq_f32(phase3, sample, tapCoefficients, 3);
+		}
+
+		float32x4_t peak = vmaxq_f32(vmaxq_f32(vabsq_f32(phase0), vabsq_f32(phase1)), vmaxq_f32(vabsq_f32(phase2), vabsq_f32(phase3)));
+		vst1q_f32(truePeak + lane, vmaxq_f32(vld1q_f32(truePeak + lane), peak));
+
+		lane += 4;
+		if (lane == period)
+			lane = 0;
+	}
+
+	truePeakTail(samples, i, count, channelCount, coefficients, period, truePeak);
+}
+#endif
+
+// K-weighting filter coefficients for any sample rate, from the analogue prototypes of the BS.1770 pre-filter
+// (high shelf) and RLB filter (high-pass)
+
+static void designShelfFilter(double sampleRate, double* coefficients)
+{
+	const double	frequency	= 1681.974450955533;
+	const double	gain		= 3.999843853973347;
+	const double	q			= 0.7071752369554196;
+	double			k			= std::tan(M_PI * frequency / sampleRate);
+	double			vh			= std::pow(10.0, gain / 20.0);
+	double			vb			= std::pow(vh, 0.4996667741545416);
+	double			a0			= 1.0 + k / q + k * k;
+
+	coefficients[0] = (vh + vb * k / q + k * k) / a0;
+	coefficients[1] = 2.0 * (k * k - vh) / a0;
+	coefficients[2] = (vh - vb * k / q + k * k) / a0;
+	coefficients[3] = 2.0 * (k * k - 1.0) / a0;
+	coefficients[4] = (1.0 - k / q + k * k) / a0;
+}
+
+static void designHighPassFilter(double sampleRate, double* coefficients)
+{
+	const double	frequency	= 38.13547087602444;
+	const double	q			= 0.5003270373238773;
+	double			k			= std::tan(M_PI * frequency / sampleRate);
+	double			a0			= 1.0 + k / q + k * k;
+
+	coefficients[0] = 1.0;
+	coefficients[1] = -2.0;
+	coefficients[2] = 1.0;
+	coefficients[3] = 2.0 * (k * k - 1.0) / a0;
+	coefficients[4] = (1.0 - k / q + k * k) / a0;
+}
+
+static inline double processBiquad(double input, const double* coefficients, double& z1, double& z2)
+{
+	// Transposed direct form II
+	double output = coefficients[0] * input + z1;
+	z1 = coefficients[1] * input - coefficients[3] * output + z2;
+	z2 = coefficients[2] * input - coefficients[4] * output;
+	return output;
+}
+
+// K-weighting kernels
+//
+// Filter each channel with the shelf then the high-pass and accumulate the sum of squares of the output.  Filters are
+// recursive so channels, rather than samples, are processed in parallel.  state holds the shelf z1, z2 and high-pass
+// z1, z2 arrays of channelCount values each.
+
+static void kWeightingChannels(const float* samples, uint32_t frameCount, uint32_t channelCount, uint32_t firstChannel, const double* coefficients, double* state, double* sumSquares)
+{
+	for (uint32_t channel = firstChannel; channel < channelCount; channel++)
+	{
+		double	shelfZ1 = state[channel];
+		double	shelfZ2 = state[channelCount + channel];
+		double	highPassZ1 = state[channelCount * 2 + channel];
+		double	highPassZ2 = state[channelCount * 3 + channel];
+		double	sum = 0.0;
+
+		for (uint32_t frame = 0; frame < frameCount; frame++)
+		{
+			double output = processBiquad(samples[frame * channelCount + channel], coefficients, shelfZ1, shelfZ2);
+			output = processBiquad(output, coefficients + 5, highPassZ1, highPassZ2);
+			sum += output * output;
+		}
+
+		state[channel] = shelfZ1;
+		state[channelCount + channel] = shelfZ2;
+		state[channelCount * 2 + channel] = highPassZ1;
+		state[channelCount * 3 + channel] = highPassZ2;
+		sumSquares[channel] += sum;
+	}
+}
+
+static void kWeightingScalar(const float* samples, uint32_t frameCount, uint32_t channelCount, const double* coefficients, double* state, double* sumSquares)
+{
+	kWeightingChannels(samples, frameCount, channelCount, 0, coefficients, state, sumSquares);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("avx2")))
+static inline __m256d processBiquadAVX2(__m256d input, const __m256d* coefficients, __m256d& z1, __m256d& z2)
+{
+	__m256d output = _mm256_add_pd(_mm256_mul_pd(coefficients[0], input), z1);
+	z1 = _mm256_sub_pd(_mm256_add_pd(_mm256_mul_pd(coefficients[1], input), z2), _mm256_mul_pd(coefficients[3], output));
+	z2 = _mm256_sub_pd(_mm256_mul_pd(coefficients[2], input), _mm256_mul_pd(coefficients[4], output));
+	return output;
+}
+
+__attribute__((target("avx2")))
+static void kWeightingAVX2(const float* samples, uint32_t frameCount, uint32_t channelCount, const double* coefficients, double* state, double* sumSquares)
+{
+	__m256d		filter[10];
+	uint32_t	channel = 0;
+
+	for (unsigned i = 0; i < 10; i++)
+		filter[i] = _mm256_set1_pd(coefficients[i]);
+
+	// Two independent groups of 4 channels hide the latency of the recursive filters
+	for (; channel + 8 <= channelCount; channel += 8)
+	{
+		double*	shelfZ1 = state + channel;
+		double*	shelfZ2 = state + channelCount + channel;
+		double*	highPassZ1 = state + channelCount * 2 + channel;
+		double*	highPassZ2 = state + channelCount * 3 + channel;
+		__m256d	shelfZ1Low = _mm256_loadu_pd(shelfZ1), shelfZ1High = _mm256_loadu_pd(shelfZ1 + 4);
+		__m256d	shelfZ2Low = _mm256_loadu_pd(shelfZ2), shelfZ2High = _mm256_loadu_pd(shelfZ2 + 4);
+		__m256d	highPassZ1Low = _mm256_loadu_pd(highPassZ1), highPassZ1High = _mm256_loadu_pd(highPassZ1 + 4);
+		__m256d	highPassZ2Low = _mm256_loadu_pd(highPassZ2), highPassZ2High = _mm256_loadu_pd(highPassZ2 + 4);
+		__m256d	sumLow = _mm256_setzero_pd(), sumHigh = _mm256_setzero_pd();
+		const float* frameSamples = samples + channel;
+
+		for (uint32_t frame = 0; frame < frameCount; frame++, frameSamples += channelCount)
+		{
+			__m256d outputLow = processBiquadAVX2(_mm256_cvtps_pd(_mm_loadu_ps(frameSamples)), filter, shelfZ1Low, shelfZ2Low);
+			__m256d outputHigh = processBiquadAVX2(_mm256_cvtps_pd(_mm_loadu_ps(frameSamples + 4)), filter, shelfZ1High, shelfZ2High);
+			outputLow = processBiquadAVX2(outputLow, filter + 5, highPassZ1Low, highPassZ2Low);
+			outputHigh = processBiquadAVX2(outputHigh, filter + 5, highPassZ1High, highPassZ2High);
+			sumLow = _mm256_add_pd(sumLow, _mm256_mul_pd(outputLow, outputLow));
+			sumHigh = _mm256_add_pd(sumHigh, _mm256_mul_pd(outputHigh, outputHigh));
+		}
+
+		_mm256_storeu_pd(shelfZ1, shelfZ1Low);
+		_mm256_storeu_pd(shelfZ1 + 4, shelfZ1High);
+		_mm256_storeu_pd(shelfZ2, shelfZ2Low);
+		_mm256_storeu_pd(shelfZ2 + 4, shelfZ2High);
+		_mm256_storeu_pd(highPassZ1, highPassZ1Low);
+		_mm256_storeu_pd(highPassZ1 + 4, highPassZ1High);
+		_mm256_storeu_pd(highPassZ2, highPassZ2Low);
+		_mm256_storeu_pd(highPassZ2 + 4, highPassZ2High);
+		_mm256_storeu_pd(sumSquares + channel, _mm256_add_pd(_mm256_loadu_pd(sumSquares + channel), sumLow));
+		_mm256_storeu_pd(sumSquares + channel + 4, _mm256_add_pd(_mm256_loadu_pd(sumSquares + channel + 4), sumHigh));
+	}
+
+	kWeightingChannels(samples, frameCount, channelCount, channel, coefficients, state, sumSquares);
+}
+#elif defined(__aarch64__)
+static inline float64x2_t processBiquadNEON(float64x2_t input, const float64x2_t* coefficients, float64x2_t& z1, float64x2_t& z2)
+{
+	float64x2_t output = vfmaq_f64(z1, coefficients[0], input);
+	z1 = vfmsq_f64(vfmaq_f64(z2, coefficients[1], input), coefficients[3], output);
+	z2 = vfmsq_f64(vmulq_f64(coefficients[2], input), coefficients[4], output);
+	return output;
+}
+
+static void kWeightingNEON(const float* samples, uint32_t frameCount, uint32_t channelCount, const double* coefficients, double* state, double* sumSquares)
+{
+	float64x2_t	filter[10];
+	uint32_t	channel = 0;
+
+	for (unsigned i = 0; i < 10; i++)
+		filter[i] = vdupq_n_f64(coefficients[i]);
+
+	// Two independent groups of 2 channels hide the latency of the recursive filters
+	for (; channel + 4 <= channelCount; channel += 4)
+	{
+		double*		shelfZ1 = state + channel;
+		double*		shelfZ2 = state + channelCount + channel;
+		double*		highPassZ1 = state + channelCount * 2 + channel;
+		double*		highPassZ2 = state + channelCount * 3 + channel;
+		float64x2_t	shelfZ1Low = vld1q_f64(shelfZ1), shelfZ1High = vld1q_f64(shelfZ1 + 2);
+		float64x2_t	shelfZ2Low = vld1q_f64(shelfZ2), shelfZ2High = vld1q_f64(shelfZ2 + 2);
+		float64x2_t	highPassZ1Low = vld1q_f64(highPassZ1), highPassZ1High = vld1q_f64(highPassZ1 + 2);
+		float64x2_t	highPassZ2Low = vld1q_f64(highPassZ2), highPassZ2High = vld1q_f64(highPassZ2 + 2);
+		float64x2_t	sumLow = vdupq_n_f64(0.0), sumHigh = vdupq_n_f64(0.0);
+		const float* frameSamples = samples + channel;
+
+		for (uint32_t frame = 0; frame < frameCount; frame++, frameSamples += channelCount)
+		{
+			float32x4_t input = vld1q_f32(frameSamples);
+			float64x2_t outputLow = processBiquadNEON(vcvt_f64_f32(vget_low_f32(input)), filter, shelfZ1Low, shelfZ2Low);
+			float64x2_t outputHigh = processBiquadNEON(vcvt_high_f64_f32(input), filter, shelfZ1High, shelfZ2High);
+			outputLow = processBiquadNEON(outputLow, filter + 5, highPassZ1Low, highPassZ2Low);
+			outputHigh = processBiquadNEON(outputHigh, filter + 5, highPassZ1High, highPassZ2High);
+			sumLow = vfmaq_f64(sumLow, outputLow, outputLow);
+			sumHigh = vfmaq_f64(sumHigh, outputHigh, outputHigh);
+		}
+
+		vst1q_f64(shelfZ1, shelfZ1Low);
+		vst1q_f64(shelfZ1 + 2, shelfZ1High);
+		vst1q_f64(shelfZ2, shelfZ2Low);
+		vst1q_f64(shelfZ2 + 2, shelfZ2High);
+		vst1q_f64(highPassZ1, highPassZ1Low);
+		vst1q_f64(highPassZ1 + 2, highPassZ1High);
+		vst1q_f64(highPassZ2, highPassZ2Low);
+		vst1q_f64(highPassZ2 + 2, highPassZ2High);
+		vst1q_f64(sumSquares + channel, vaddq_f64(vld1q_f64(sumSquares + channel), sumLow));
+		vst1q_f64(sumSquares + channel + 2, vaddq_f64(vld1q_f64(sumSquares + channel + 2), sumHigh));
+	}
+
+	kWeightingChannels(samples, frameCount, channelCount, channel, coefficients, state, sumSquares);
+}
+#endif
+
+// AudioLevelMeter
+
+AudioLevelMeter::AudioLevelMeter() :
+	m_measure16Function(measureSamples16Scalar),
+	m_measure32Function(measureSamples32Scalar),
+	m_truePeakFunction(truePeakScalar),
+	m_kWeightingFunction(kWeightingScalar),
+	m_channelCount(0),
+	m_bytesPerSample(0),
+	m_period(0),
+	m_loudnessFirstChannel(0),
+	m_loudnessChannelCount(2),
+	m_truePeakCoefficients(kTruePeakTapsPerPhase * kTruePeakPhases),
+	m_blockFrames(0),
+	m_blockFrameCount(0),
+	m_blockCount(0),
+	m_pendingFrameCount(0),
+	m_levelsFrameCount(0)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	if (__builtin_cpu_supports("avx2"))
+	{
+		m_measure16Function = measureSamples16AVX2;
+		m_measure32Function = measureSamples32AVX2;
+		m_truePeakFunction = truePeakAVX2;
+		m_kWeightingFunction = kWeightingAVX2;
+	}
+#elif defined(__aarch64__)
+	m_measure16Function = measureSamples16NEON;
+	m_measure32Function = measureSamples32NEON;
+	m_truePeakFunction = truePeakNEON;
+	m_kWeightingFunction = kWeightingNEON;
+#endif
+
+	// 48 tap windowed sinc with a cutoff at the input Nyquist frequency.  Tap 24 is the centre, so phase 0
+	// passes the input samples through unchanged and phases 1-3 interpolate between them.
+	const uint32_t	tapCount = kTruePeakTapsPerPhase * kTruePeakPhases;
+	const double	centre = tapCount / 2;
+
+	for (uint32_t phase = 0; phase < kTruePeakPhases; phase++)
+	{
+		double sum = 0.0;
+		double taps[kTruePeakTapsPerPhase];
+
+		for (uint32_t tap = 0; tap < kTruePeakTapsPerPhase; tap++)
+		{
+			double n = tap * kTruePeakPhases + phase;
+			double x = (n - centre) / kTruePeakPhases;
+			double sinc = (x == 0.0) ? 1.0 : std::sin(M_PI * x) / (M_PI * x);
+			double window = 0.42 + 0.5 * std::cos(M_PI * (n - centre) / (centre + 1)) + 0.08 * std::cos(2.0 * M_PI * (n - centre) / (centre + 1));
+
+			taps[tap] = sinc * window;
+			sum += taps[tap];
+		}
+
+		// Unity gain for each phase
+		for (uint32_t tap = 0; tap < kTruePeakTapsPerPhase; tap++)
+			m_truePeakCoefficients[tap * kTruePeakPhases + phase] = (float)(taps[tap] / sum);
+	}
+
+	configure(kMinimumChannelCount, bmdAudioSampleType16bitInteger);
+}
+
+bool AudioLevelMeter::configure(uint32_t channelCount, BMDAudioSampleType sampleType, BMDAudioSampleRate sampleRate)
+{
+	if ((channelCount < kMinimumChannelCount) || (channelCount > kMaximumChannelCount))
+		return false;
+
+	if ((sampleType != bmdAudioSampleType16bitInteger) && (sampleType != bmdAudioSampleType32bitInteger))
+		return false;
+
+	if (m_loudnessFirstChannel + m_loudnessChannelCount > channelCount)
+		return false;
+
+	m_channelCount = channelCount;
+	m_bytesPerSample = (sampleType == bmdAudioSampleType16bitInteger) ? 2 : 4;
+	m_period = channelCount * kVectorSamples / greatestCommonDivisor(channelCount, kVectorSamples);
+	m_blockFrames = (uint32_t)sampleRate / 10;
+
+	designShelfFilter(sampleRate, m_kWeightingCoefficients);
+	designHighPassFilter(sampleRate, m_kWeightingCoefficients + 5);
+
+	m_samples.assign((kTruePeakTapsPerPhase - 1 + kChunkFrames) * channelCount, 0.0f);
+	m_chunkPeak.assign(m_period, 0.0f);
+	m_chunkSumSquares.assign(m_period, 0.0f);
+	m_chunkTruePeak.assign(m_period, 0.0f);
+	m_channelWeights.assign(channelCount, 0.0);
+	std::copy_n(getLoudnessWeights(m_loudnessChannelCount), m_loudnessChannelCount, m_channelWeights.begin() + m_loudnessFirstChannel);
+	m_filterState.resize(channelCount * 4);
+	m_blockSumSquares.resize(channelCount);
+	m_pendingLevels.resize(channelCount);
+	m_pendingSumSquares.resize(channelCount);
+
+	{
+		std::lock_guard<std::mutex> lock(m_levelsMutex);
+		m_levels.resize(channelCount);
+		m_levelsSumSquares.resize(channelCount);
+	}
+
+	reset();
+	return true;
+}
+
+void AudioLevelMeter::reset()
+{
+	std::fill(m_samples.begin(), m_samples.end(), 0.0f);
+	std::fill(m_filterState.begin(), m_filterState.end(), 0.0);
+	std::fill(m_blockSumSquares.begin(), m_blockSumSquares.end(), 0.0);
+	std::fill(m_pendingLevels.begin(), m_pendingLevels.end(), AudioChannelLevels());
+	std::fill(m_pendingSumSquares.begin(), m_pendingSumSquares.end(), 0.0);
+	m_pendingFrameCount = 0;
+
+	m_blockFrameCount = 0;
+	m_blockCount = 0;
+	std::fill(m_blockPowers, m_blockPowers + kShortTermBlocks, 0.0);
+	std::fill(m_gatingBlockCounts, m_gatingBlockCounts + kGatingHistogramBins, 0);
+	std::fill(m_gatingBlockPowers, m_gatingBlockPowers + kGatingHistogramBins, 0.0);
+
+	std::lock_guard<std::mutex> lock(m_levelsMutex);
+	std::fill(m_levels.begin(), m_levels.end(), AudioChannelLevels());
+	std::fill(m_levelsSumSquares.begin(), m_levelsSumSquares.end(), 0.0);
+	m_levelsFrameCount = 0;
+	m_loudness.momentary = -HUGE_VAL;
+	m_loudness.shortTerm = -HUGE_VAL;
+	m_loudness.integrated = -HUGE_VAL;
+	m_loudness.maxTruePeak = 0.0f;
+}
+
+bool AudioLevelMeter::setLoudnessChannels(uint32_t firstChannel, uint32_t channelCount)
+{
+	if ((getLoudnessWeights(channelCount) == nullptr) || (firstChannel > kMaximumChannelCount - channelCount))
+		return false;
+
+	m_loudnessFirstChannel = firstChannel;
+	m_loudnessChannelCount = channelCount;
+	return true;
+}
+
+void AudioLevelMeter::setChannelWeight(uint32_t channel, double weight)
+{
+	if (channel < m_channelWeights.size())
+		m_channelWeights[channel] = weight;
+}
+
+void AudioLevelMeter::processPacket(IDeckLinkAudioInputPacket* audioPacket)
+{
+	void* samples;
+
+	if (audioPacket->GetBytes(&samples) == S_OK)
+		processSamples(samples, (uint32_t)audioPacket->GetSampleFrameCount());
+}
+
+void AudioLevelMeter::processSamples(const void* samples, uint32_t sampleFrameCount)
+{
+	const uint8_t*	input = (const uint8_t*)samples;
+	uint32_t		frameBytes = m_channelCount * m_bytesPerSample;
+	bool			blockCompleted = false;
+
+	while (sampleFrameCount > 0)
+	{
+		// Chunks end on block boundaries so the loudness windows advance exactly every 100 ms
+		uint32_t frameCount = std::min(std::min(sampleFrameCount, (uint32_t)kChunkFrames), m_blockFrames - m_blockFrameCount);
+
+		measureChunk(input, frameCount);
+
+		input += frameCount * frameBytes;
+		sampleFrameCount -= frameCount;
+
+		m_blockFrameCount += frameCount;
+		if (m_blockFrameCount == m_blockFrames)
+		{
+			completeBlock();
+			blockCompleted = true;
+		}
+	}
+
+	double integrated = blockCompleted ? getIntegratedLoudness() : 0.0;
+
+	std::lock_guard<std::mutex> lock(m_levelsMutex);
+
+	for (uint32_t channel = 0; channel < m_channelCount; channel++)
+	{
+		AudioChannelLevels& levels = m_levels[channel];
+		AudioChannelLevels& pendingLevels = m_pendingLevels[channel];
+
+		levels.peak = std::max(levels.peak, pendingLevels.peak);
+		levels.truePeak = std::max(levels.truePeak, pendingLevels.truePeak);
+		m_levelsSumSquares[channel] += m_pendingSumSquares[channel];
+		m_loudness.maxTruePeak = std::max(m_loudness.maxTruePeak, pendingLevels.truePeak);
+
+		pendingLevels = AudioChannelLevels();
+		m_pendingSumSquares[channel] = 0.0;
+	}
+	m_levelsFrameCount += m_pendingFrameCount;
+	m_pendingFrameCount = 0;
+
+	if (blockCompleted)
+	{
+		uint32_t	momentaryBlocks = std::min(m_blockCount, (uint32_t)kMomentaryBlocks);
+		double		momentaryPower = 0.0;
+		double		shortTermPower = 0.0;
+
+		for (uint32_t i = 0; i < std::min(m_blockCount, (uint32_t)kShortTermBlocks); i++)
+		{
+			double power = m_blockPowers[(m_blockCount - 1 - i) % kShortTermBlocks];
+			if (i < momentaryBlocks)
+				momentaryPower += power;
+			shortTermPower += power;
+		}
+
+		m_loudness.momentary = (m_blockCount >= kMomentaryBlocks) ? powerToLoudness(momentaryPower / kMomentaryBlocks) : -HUGE_VAL;
+		m_loudness.shortTerm = (m_blockCount >= kShortTermBlocks) ? powerToLoudness(shortTermPower / kShortTermBlocks) : -HUGE_VAL;
+		m_loudness.integrated = integrated;
+	}
+}
+
+void AudioLevelMeter::measureChunk(const void* samples, uint32_t frameCount)
+{
+	const uint32_t	historyLength = (kTruePeakTapsPerPhase - 1) * m_channelCount;
+	const size_t	sampleCount = frameCount * m_channelCount;
+	float*			chunk = m_samples.data() + historyLength;
+
+	std::fill(m_chunkPeak.begin(), m_chunkPeak.end(), 0.0f);
+	std::fill(m_chunkSumSquares.begin(), m_chunkSumSquares.end(), 0.0f);
+	std::fill(m_chunkTruePeak.begin(), m_chunkTruePeak.end(), 0.0f);
+
+	if (m_bytesPerSample == 2)
+		m_measure16Function(samples, chunk, sampleCount, m_period, m_chunkPeak.data(), m_chunkSumSquares.data());
+	else
+		m_measure32Function(samples, chunk, sampleCount, m_period, m_chunkPeak.data(), m_chunkSumSquares.data());
+
+	m_truePeakFunction(chunk, sampleCount, m_channelCount, m_truePeakCoefficients.data(), m_period, m_chunkTruePeak.data());
+
+	// Fold the accumulator lanes into channels
+	for (uint32_t lane = 0; lane < m_period; lane++)
+	{
+		AudioChannelLevels& levels = m_pendingLevels[lane % m_channelCount];
+
+		levels.peak = std::max(levels.peak, m_chunkPeak[lane]);
+		levels.truePeak = std::max(levels.truePeak, m_chunkTruePeak[lane]);
+		m_pendingSumSquares[lane % m_channelCount] += m_chunkSumSquares[lane];
+	}
+	m_pendingFrameCount += frameCount;
+
+	m_kWeightingFunction(chunk, frameCount, m_channelCount, m_kWeightingCoefficients, m_filterState.data(), m_blockSumSquares.data());
+
+	// Keep the end of the chunk as history for the next true-peak filter
+	memmove(m_samples.data(), m_samples.data() + sampleCount, historyLength * sizeof(float));
+}
+
+void AudioLevelMeter::completeBlock()
+{
+	double power = 0.0;
+
+	for (uint32_t channel = 0; channel < m_channelCount; channel++)
+	{
+		double stateMagnitude = 0.0;
+
+		power += m_channelWeights[channel] * m_blockSumSquares[channel] / m_blockFrames;
+		m_blockSumSquares[channel] = 0.0;
+
+		// Filter state decays into denormals during silence, which are slow to process
+		for (uint32_t i = 0; i < 4; i++)
+			stateMagnitude += std::fabs(m_filterState[i * m_channelCount + channel]);
+
+		if (stateMagnitude < kDenormalThreshold)
+		{
+			for (uint32_t i = 0; i < 4; i++)
+				m_filterState[i * m_channelCount + channel] = 0.0;
+		}
+	}
+
+	m_blockPowers[m_blockCount % kShortTermBlocks] = power;
+	m_blockCount++;
+	m_blockFrameCount = 0;
+
+	if (m_blockCount < kMomentaryBlocks)
+		return;
+
+	// Each block completes a 400 ms gating block, add those above the absolute gate to the histogram
+	double gatingBlockPower = 0.0;
+	for (uint32_t i = 0; i < kMomentaryBlocks; i++)
+		gatingBlockPower += m_blockPowers[(m_blockCount - 1 - i) % kShortTermBlocks];
+	gatingBlockPower /= kMomentaryBlocks;
+
+	double loudness = powerToLoudness(gatingBlockPower);
+	if (loudness > kAbsoluteGate)
+	{
+		uint32_t bin = std::min((uint32_t)((loudness - kAbsoluteGate) * kGatingBinsPerLU), kGatingHistogramBins - 1);
+		m_gatingBlockCounts[bin]++;
+		m_gatingBlockPowers[bin] += gatingBlockPower;
+	}
+}
+
+double AudioLevelMeter::getIntegratedLoudness() const
+{
+	uint64_t	count = 0;
+	double		power = 0.0;
+
+	for (uint32_t bin = 0; bin < kGatingHistogramBins; bin++)
+	{
+		count += m_gatingBlockCounts[bin];
+		power += m_gatingBlockPowers[bin];
+	}
+
+	if (count == 0)
+		return -HUGE_VAL;
+
+	// Relative gate, blocks are compared at the resolution of the histogram bins
+	double		relativeGate = powerToLoudness(power / count) + kRelativeGate;
+	uint32_t	firstBin = (uint32_t)std::max(std::ceil((relativeGate - kAbsoluteGate) * kGatingBinsPerLU), 0.0);
+
+	count = 0;
+	power = 0.0;
+	for (uint32_t bin = firstBin; bin < kGatingHistogramBins; bin++)
+	{
+		count += m_gatingBlockCounts[bin];
+		power += m_gatingBlockPowers[bin];
+	}
+
+	return (count > 0) ? powerToLoudness(power / count) : -HUGE_VAL;
+}
+
+void AudioLevelMeter::getChannelLevels(std::vector<AudioChannelLevels>& channelLevels)
+{
+	std::lock_guard<std::mutex> lock(m_levelsMutex);
+
+	channelLevels = m_levels;
+	for (size_t channel = 0; channel < m_levels.size(); channel++)
+	{
+		channelLevels[channel].rms = (m_levelsFrameCount > 0) ? (float)std::sqrt(m_levelsSumSquares[channel] / m_levelsFrameCount) : 0.0f;
+		m_levels[channel] = AudioChannelLevels();
+		m_levelsSumSquares[channel] = 0.0;
+	}
+	m_levelsFrameCount = 0;
+}
+
+void AudioLevelMeter::getLoudness(AudioLoudness& loudness)
+{
+	std::lock_guard<std::mutex> lock(m_levelsMutex);
+	loudness = m_loudness;
+}
+
+const char* AudioLevelMeter::getKernelName() const
+{
+#if defined(__x86_64__) || defined(__i386__)
+	if (m_truePeakFunction == truePeakAVX2)
+		return "AVX2";
+#elif defined(__aarch64__)
+	if (m_truePeakFunction == truePeakNEON)
+		return "NEON";
+#endif
+	return "scalar";
+}
+
+double AudioLevelMeter::toDecibels(double level)
+{
+	return (level > 0.0) ? 20.0 * std::log10(level) : -HUGE_VAL;
+}
+
+double AudioLevelMeter::powerToLoudness(double power)
+{
+	return (power > 0.0) ? -0.691 + 10.0 * std::log10(power) : -HUGE_VAL;
+}
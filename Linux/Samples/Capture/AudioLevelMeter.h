@@ -0,0 +1,169 @@
+/* -LICENSE-START-
+** Copyright (c) 2022 Blackmagic Design
+**  
+** Permission is hereby granted, free of charge, to any person or organization 
+** obtaining a copy of the software and accompanying documentation (the 
+** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+** and transmit the Software, and to prepare derivative works of the Software, 
+** and to permit third-parties to whom the Software is furnished to do so, in 
+** accordance with:
+** 
+** (1) if the Software is obtained from Blackmagic Design, the End User License 
+** Agreement for the Software Development Kit (“EULA”) available at 
+** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+** 
+** (2) if the Software is obtained from any third party, such licensing terms 
+** as notified by that third party,
+** 
+** and all subject to the following:
+** 
+** (3) the copyright notices in the Software and this entire statement, 
+** including the above license grant, this restriction and the following 
+** disclaimer, must be included in all copies of the Software, in whole or in 
+** part, and all derivative works of the Software, unless such copies or 
+** derivative works are solely in the form of machine-executable object code 
+** generated by a source language processor.
+** 
+** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+** DEALINGS IN THE SOFTWARE.
+** 
+** A copy of the Software is available free of charge at 
+** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+** 
+** -LICENSE-END-
+*/
+
+#pragma once
+
+#include <mutex>
+#include <vector>
+#include <stdint.h>
+#include "DeckLinkAPI.h"
+
+struct AudioChannelLevels
+{
+	float				peak;				// Linear sample peak, 1.0 is full scale
+	float				rms;
+	float				truePeak;			// Linear peak of the 4x oversampled signal
+};
+
+struct AudioLoudness
+{
+	double				momentary;			// LUFS over the last 400 ms, -HUGE_VAL until 400 ms has been metered
+	double				shortTerm;			// LUFS over the last 3 s, -HUGE_VAL until 3 s has been metered
+	double				integrated;			// Gated LUFS since the meter was configured or reset
+	float				maxTruePeak;		// Linear true-peak of all channels since the meter was configured or reset
+};
+
+// The AudioLevelMeter measures interleaved 16-bit or 32-bit integer audio with 2 to 64 channels, as delivered by
+// IDeckLinkAudioInputPacket.  For each channel it measures the sample peak, RMS and true-peak (ITU-R BS.1770-4
+// Annex 2, with a 48 tap 4x oversampling filter), and for the programme it measures momentary, short-term and
+// gated integrated loudness (ITU-R BS.1770-4, EBU R 128) of a group of programme channels, by default channels 1-2.
+//
+// Packets are processed in chunks of up to kChunkFrames frames.  Each chunk is converted to float in its interleaved
+// layout and the peak, RMS and true-peak are accumulated across channels with AVX2 or NEON when the CPU supports it,
+// the accumulators repeat every lcm(channelCount, 8) samples so no deinterleaving is needed.  K-weighting is two
+// double precision biquads per channel, with groups of channels filtered in parallel.  100 ms blocks of K-weighted
+// power are kept for the sliding loudness windows, and a histogram of gating blocks for integrated loudness, so
+// metering does not allocate after configure().
+//
+// processPacket() must be called from one thread, in stream order, eg. from the input callback.  The get methods
+// are thread-safe, so a UI or metrics exporter can poll the latest levels on its own timer.
+class AudioLevelMeter
+{
+public:
+	static const uint32_t	kMinimumChannelCount	= 2;
+	static const uint32_t	kMaximumChannelCount	= 64;
+
+	AudioLevelMeter();
+	virtual ~AudioLevelMeter() = default;
+
+	// Reallocates the meter for a channel count and sample type and resets all measurements.  Channel weights are
+	// set for the loudness channels, returns false if the format is unsupported or does not contain them.
+	bool				configure(uint32_t channelCount, BMDAudioSampleType sampleType, BMDAudioSampleRate sampleRate = bmdAudioSampleRate48kHz);
+
+	// Programme channels measured for loudness from the next configure(), starting at zero based firstChannel.
+	// 1 (mono), 2 (stereo), 6 (5.1) or 8 (7.1) channels in SMPTE order, eg. L R C LFE Ls Rs Lrs Rrs, are given
+	// their BS.1770 weights of 1.41 for the side surrounds, 0.0 for LFE and 1.0 otherwise.  Other channels are
+	// excluded.  Returns false for other channel counts.
+	bool				setLoudnessChannels(uint32_t firstChannel, uint32_t channelCount);
+
+	// Reset measurements, eg. at the start of a new programme
+	void				reset(void);
+
+	// Overrides the BS.1770 loudness weight of a channel until the next configure()
+	void				setChannelWeight(uint32_t channel, double weight);
+
+	void				processPacket(IDeckLinkAudioInputPacket* audioPacket);
+	void				processSamples(const void* samples, uint32_t sampleFrameCount);
+
+	// Levels of each channel since the previous call, the peaks are reset after they are read
+	void				getChannelLevels(std::vector<AudioChannelLevels>& channelLevels);
+	void				getLoudness(AudioLoudness& loudness);
+
+	uint32_t			getChannelCount(void) const { return m_channelCount; }
+	uint32_t			getLoudnessFirstChannel(void) const { return m_loudnessFirstChannel; }
+	uint32_t			getLoudnessChannelCount(void) const { return m_loudnessChannelCount; }
+	const char*			getKernelName(void) const;
+
+	// Returns -HUGE_VAL for silence
+	static double		toDecibels(double level);
+
+private:
+	static const uint32_t	kChunkFrames			= 256;
+	static const uint32_t	kShortTermBlocks		= 30;			// 3 s of 100 ms blocks
+	static const uint32_t	kMomentaryBlocks		= 4;			// 400 ms gating blocks, overlapping by 75%
+	static const uint32_t	kGatingHistogramBins	= 1000;			// 0.1 LU bins from -70 LUFS to +30 LUFS
+
+	using MeasureFunction = void (*)(const void* input, float* output, size_t count, uint32_t period, float* peak, float* sumSquares);
+	using TruePeakFunction = void (*)(const float* samples, size_t count, uint32_t channelCount, const float* coefficients, uint32_t period, float* truePeak);
+	using KWeightingFunction = void (*)(const float* samples, uint32_t frameCount, uint32_t channelCount, const double* coefficients, double* state, double* sumSquares);
+
+	void				measureChunk(const void* samples, uint32_t frameCount);
+	void				completeBlock(void);
+	double				getIntegratedLoudness(void) const;
+	static double		powerToLoudness(double power);
+
+	MeasureFunction					m_measure16Function;
+	MeasureFunction					m_measure32Function;
+	TruePeakFunction				m_truePeakFunction;
+	KWeightingFunction				m_kWeightingFunction;
+
+	uint32_t						m_channelCount;
+	uint32_t						m_bytesPerSample;
+	uint32_t						m_period;						// lcm(channelCount, 8)
+	uint32_t						m_loudnessFirstChannel;
+	uint32_t						m_loudnessChannelCount;
+	std::vector<float>				m_truePeakCoefficients;			// 4 phases for each tap
+	double							m_kWeightingCoefficients[10];	// b0 b1 b2 a1 a2 of the shelf then the high-pass
+
+	// Metering state, only accessed by the thread calling processSamples()
+	std::vector<float>				m_samples;						// History for the true-peak filter followed by the current chunk
+	std::vector<float>				m_chunkPeak;					// Accumulators with m_period lanes
+	std::vector<float>				m_chunkSumSquares;
+	std::vector<float>				m_chunkTruePeak;
+	std::vector<double>				m_filterState;					// Shelf z1, z2 and high-pass z1, z2 arrays of each channel
+	std::vector<double>				m_channelWeights;
+	std::vector<double>				m_blockSumSquares;				// K-weighted sum of squares for the current block
+	uint32_t						m_blockFrames;
+	uint32_t						m_blockFrameCount;
+	double							m_blockPowers[kShortTermBlocks];	// Ring of weighted mean square of the most recent blocks
+	uint32_t						m_blockCount;
+	uint64_t						m_gatingBlockCounts[kGatingHistogramBins];
+	double							m_gatingBlockPowers[kGatingHistogramBins];
+	std::vector<AudioChannelLevels>	m_pendingLevels;
+	std::vector<double>				m_pendingSumSquares;
+	uint64_t						m_pendingFrameCount;
+
+	// Published levels, guarded by m_levelsMutex
+	std::mutex						m_levelsMutex;
+	std::vector<AudioChannelLevels>	m_levels;
+	std::vector<double>				m_levelsSumSquares;
+	uint64_t						m_levelsFrameCount;
+	AudioLoudness					m_loudness;
+};
@@ -0,0 +1,147 @@
+/* -LICENSE-START-
+** Copyright (c) 2022 Blackmagic Design
+**  
+** Permission is hereby granted, free of charge, to any person or organization 
+** obtaining a copy of the software and accompanying documentation (the 
+** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+** and transmit the Software, and to prepare derivative works of the Software, 
+** and to permit third-parties to whom the Software is furnished to do so, in 
+** accordance with:
+** 
+** (1) if the Software is obtained from Blackmagic Design, the End User License 
+** Agreement for the Software Development Kit (“EULA”) available at 
+** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+** 
+** (2) if the Software is obtained from any third party, such licensing terms 
+** as notified by that third party,
+** 
+** and all subject to the following:
+** 
+** (3) the copyright notices in the Software and this entire statement, 
+** including the above license grant, this restriction and the following 
+** disclaimer, must be included in all copies of the Software, in whole or in 
+** part, and all derivative works of the Software, unless such copies or 
+** derivative works are solely in the form of machine-executable object code 
+** generated by a source language processor.
+** 
+** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+** DEALINGS IN THE SOFTWARE.
+** 
+** A copy of the Software is available free of charge at 
+** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+** 
+** -LICENSE-END-
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "DeckLinkAPI.h"
+
+// One decoded piece of CEA-708 caption data.  Text is a run of G0/G1 characters; a command is a C0, C1 or
+// extended (EXT1) code with its parameters.  bytes points into the decoder and is valid until the next decode().
+struct CaptionElement
+{
+	enum Type
+	{
+		kText = 0,
+		kCommand
+	};
+
+	uint8_t			type;
+	uint8_t			serviceNumber;
+	uint8_t			code;			// First byte of a command, 0 for text
+	uint8_t			length;			// Bytes, including the code of a command
+	const uint8_t*	bytes;
+};
+
+// Validating decoder for the SMPTE 334-2 caption distribution packets (DID 0x61, SDID 0x01) of one input.
+//
+// The CDP is read in place from the ancillary packet, its length, section structure, footer, checksum and
+// sequence counter are checked, and the 708 cc_data triplets are reassembled into DTVCC packets.  The service
+// blocks of each complete DTVCC packet are split into text and command elements without copying them again.
+// A DTVCC packet may span several CDPs, so its bytes are held by the decoder until it is complete.
+class CaptionDecoder
+{
+public:
+	static const uint8_t	kCaptionDID		= 0x61;
+	static const uint8_t	kCaptionSDID	= 0x01;
+
+	struct Statistics
+	{
+		uint64_t	frames;				// decode() calls
+		uint64_t	cdps;				// Valid CDPs
+		uint64_t	invalidCDPs;		// Malformed or with a bad checksum, not decoded
+		uint64_t	checksumErrors;
+		uint64_t	sequenceErrors;		// CDP sequence counter discontinuities
+		uint64_t	dtvccPackets;
+		uint64_t	dtvccPacketErrors;	// Packets cut short by the next packet start or with a malformed service block
+		uint64_t	dtvccSequenceErrors;
+		uint64_t	serviceBlocks;
+		uint64_t	textBytes;
+		uint64_t	commands;
+		uint64_t	cc608Pairs;			// Valid CEA-608 byte pairs in either field
+	};
+
+	CaptionDecoder();
+
+	// Decode the CDP attached to a captured frame, returns false if the frame has no valid CDP
+	bool					decode(IDeckLinkVideoFrame* videoFrame);
+
+	// Decode the user data words of a caption distribution packet
+	bool					decode(const uint8_t* data, uint32_t size);
+
+	// Elements decoded from the DTVCC packets completed by the last CDP
+	size_t					getElementCount() const { return m_elementCount; }
+	const CaptionElement&	getElement(size_t index) const { return m_elements[index]; }
+
+	// True if the last CDP was valid and flagged a caption service as active
+	bool					isCaptionServiceActive() const { return m_captionServiceActive; }
+
+	// Frames since a service block with caption data was decoded, or -1 if none has been
+	int64_t					getFramesSinceCaptionData() const;
+
+	// Frame rate signalled by the last CDP, 0 if none
+	double					getFrameRate() const { return m_frameRate; }
+
+	const Statistics&		getStatistics() const { return m_statistics; }
+
+	// Name of a command code, or NULL if it is not a known command
+	static const char*		getCommandName(uint8_t code);
+
+private:
+	static const size_t		kMaximumDTVCCPacketSize	= 128;
+	static const size_t		kMaximumCCCount			= 31;
+	static const size_t		kPacketBufferSize		= kMaximumDTVCCPacketSize + kMaximumCCCount * 2;
+	static const size_t		kMaximumElements		= kPacketBufferSize;
+
+	void					beginFrame();
+	bool					decodeCDP(const uint8_t* data, uint32_t size);
+	void					decodeCCData(const uint8_t* section);
+	void					appendDTVCCBytes(uint8_t byte1, uint8_t byte2);
+	void					decodeDTVCCPacket(const uint8_t* packet, size_t size);
+	bool					decodeServiceBlock(uint8_t serviceNumber, const uint8_t* block, size_t size);
+	void					appendElement(uint8_t type, uint8_t serviceNumber, uint8_t code, const uint8_t* bytes, size_t length);
+
+	// DTVCC packets are laid out back to back, a packet still being received is moved to the front before each CDP
+	uint8_t					m_packetBuffer[kPacketBufferSize];
+	size_t					m_packetStart;
+	size_t					m_packetReceived;
+	size_t					m_packetSize;		// 0 when no packet is being received
+	int						m_lastDTVCCSequence;
+
+	CaptionElement			m_elements[kMaximumElements];
+	size_t					m_elementCount;
+
+	int32_t					m_lastCDPSequence;
+	bool					m_captionServiceActive;
+	double					m_frameRate;
+	int64_t					m_lastCaptionDataFrame;
+	Statistics				m_statistics;
+};
@@ -0,0 +1,304 @@
+/* -LICENSE-START-
+** Copyright (c) 2022 Blackmagic Design
+**  
+** Permission is hereby granted, free of charge, to any person or organization 
+** obtaining a copy of the software and accompanying documentation (the 
+** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+** and transmit the Software, and to prepare derivative works of the Software, 
+** and to permit third-parties to whom the Software is furnished to do so, in 
+** accordance with:
+** 
+** (1) if the Software is obtained from Blackmagic Design, the End User License 
+** Agreement for the Software Development Kit (“EULA”) available at 
+** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+** 
+** (2) if the Software is obtained from any third party, such licensing terms 
+** as notified by that third party,
+** 
+** and all subject to the following:
+** 
+** (3) the copyright notices in the Software and this entire statement, 
+** including the above license grant, this restriction and the following 
+** disclaimer, must be included in all copies of the Software, in whole or in 
+** part, and all derivative works of the Software, unless such copies or 
+** derivative works are solely in the form of machine-executable object code 
+** generated by a source language processor.
+** 
+** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+** DEALINGS IN THE SOFTWARE.
+** 
+** A copy of the Software is available free of charge at 
+** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+** 
+** -LICENSE-END-
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#include "CaptionDecoder.h"
+#include "CaptionDecoderBenchmark.h"
+
+// Each input cycles through prebuilt CDPs, the CDP sequence counter is written as each one is decoded
+static const unsigned	kCycleLength		= 128;
+static const unsigned	kFrameRateCode		= 4;		// 29.97 fps
+static const double		kFrameRate			= 30000.0 / 1001.0;
+static const unsigned	kCCCount			= 20;
+static const unsigned	kCC608Count			= 2;
+static const size_t		kDTVCCPacketSize	= (kCCCount - kCC608Count) * 2;
+static const size_t		kMaximumCDPSize		= 7 + 2 + 3 * 31 + 2 + 7 + 4;
+
+namespace
+{
+
+struct BenchmarkCDP
+{
+	uint8_t		data[kMaximumCDPSize];
+	uint32_t	size;
+};
+
+// Ancillary packet and frame stand-ins, returning the current CDP of an input as a capture would
+class BenchmarkAncillaryPacket : public IDeckLinkAncillaryPacket
+{
+public:
+	BenchmarkAncillaryPacket() : m_cdp(NULL) { }
+
+	void					setCDP(const BenchmarkCDP* cdp) { m_cdp = cdp; }
+
+	virtual HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid, LPVOID *ppv) { *ppv = NULL; return E_NOINTERFACE; }
+	virtual ULONG STDMETHODCALLTYPE AddRef(void) { return 1; }
+	virtual ULONG STDMETHODCALLTYPE Release(void) { return 1; }
+
+	virtual HRESULT STDMETHODCALLTYPE GetBytes(BMDAncillaryPacketFormat format, const void** data, uint32_t* size)
+	{
+		if (format != bmdAncillaryPacketFormatUInt8)
+			return E_NOTIMPL;
+		if (data)
+			*data = m_cdp->data;
+		if (size)
+			*size = m_cdp->size;
+		return S_OK;
+	}
+	virtual uint8_t STDMETHODCALLTYPE GetDID(void) { return CaptionDecoder::kCaptionDID; }
+	virtual uint8_t STDMETHODCALLTYPE GetSDID(void) { return CaptionDecoder::kCaptionSDID; }
+	virtual uint32_t STDMETHODCALLTYPE GetLineNumber(void) { return 9; }
+	virtual uint8_t STDMETHODCALLTYPE GetDataStreamIndex(void) { return 0; }
+
+private:
+	const BenchmarkCDP*		m_cdp;
+};
+
+class BenchmarkVideoFrame : public IDeckLinkVideoFrame, public IDeckLinkVideoFrameAncillaryPackets
+{
+public:
+	explicit BenchmarkVideoFrame(BenchmarkAncillaryPacket* packet) : m_packet(packet) { }
+
+	virtual HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid, LPVOID *ppv)
+	{
+		if (memcmp(&iid, &IID_IDeckLinkVideoFrameAncillaryPackets, sizeof(REFIID)) == 0)
+		{
+			*ppv = static_cast<IDeckLinkVideoFrameAncillaryPackets*>(this);
+			return S_OK;
+		}
+		*ppv = NULL;
+		return E_NOINTERFACE;
+	}
+	virtual ULONG STDMETHODCALLTYPE AddRef(void) { return 1; }
+	virtual ULONG STDMETHODCALLTYPE Release(void) { return 1; }
+
+	// IDeckLinkVideoFrame
+	virtual long STDMETHODCALLTYPE GetWidth(void) { return 1920; }
+	virtual long STDMETHODCALLTYPE GetHeight(void) { return 1080; }
+	virtual long STDMETHODCALLTYPE GetRowBytes(void) { return 1920 * 2; }
+	virtual BMDPixelFormat STDMETHODCALLTYPE GetPixelFormat(void) { return bmdFormat8BitYUV; }
+	virtual BMDFrameFlags STDMETHODCALLTYPE GetFlags(void) { return bmdFrameFlagDefault; }
+	virtual HRESULT STDMETHODCALLTYPE GetBytes(void** buffer) { return E_NOTIMPL; }
+	virtual HRESULT STDMETHODCALLTYPE GetTimecode(BMDTimecodeFormat format, IDeckLinkTimecode** timecode) { return S_FALSE; }
+	virtual HRESULT STDMETHODCALLTYPE GetAncillaryData(IDeckLinkVideoFrameAncillary** ancillary) { return E_NOTIMPL; }
+
+	// IDeckLinkVideoFrameAncillaryPackets
+	virtual HRESULT STDMETHODCALLTYPE GetPacketIterator(IDeckLinkAncillaryPacketIterator** iterator) { return E_NOTIMPL; }
+	virtual HRESULT STDMETHODCALLTYPE GetFirstPacketByID(uint8_t DID, uint8_t SDID, IDeckLinkAncillaryPacket** packet)
+	{
+		if (DID != CaptionDecoder::kCaptionDID || SDID != CaptionDecoder::kCaptionSDID)
+			return S_FALSE;
+		*packet = m_packet;
+		return S_OK;
+	}
+	virtual HRESULT STDMETHODCALLTYPE AttachPacket(IDeckLinkAncillaryPacket* packet) { return E_NOTIMPL; }
+	virtual HRESULT STDMETHODCALLTYPE DetachPacket(IDeckLinkAncillaryPacket* packet) { return E_NOTIMPL; }
+	virtual HRESULT STDMETHODCALLTYPE DetachAllPackets(void) { return E_NOTIMPL; }
+
+private:
+	BenchmarkAncillaryPacket*	m_packet;
+};
+
+// One DTVCC packet per CDP: a window definition every second, then 31 characters of text per frame
+void buildServiceBlock(unsigned input, unsigned frame, std::vector<uint8_t>& block)
+{
+	static const uint8_t kDefineWindow[] = { 0x98, 0x38, 0x5A, 0x32, 0x51, 0x1F, 0x11 };
+	static const uint8_t kWindowAttributes[] = { 0x97, 0x02, 0x00, 0x00, 0x00 };
+	static const uint8_t kPenLocation[] = { 0x92, 0x00, 0x00 };
+	static const uint8_t kDisplayWindows[] = { 0x89, 0x01 };
+	char text[64];
+
+	block.clear();
+	if (frame % 30 == 0)
+	{
+		block.insert(block.end(), kDefineWindow, kDefineWindow + sizeof(kDefineWindow));
+		block.insert(block.end(), kWindowAttributes, kWindowAttributes + sizeof(kWindowAttributes));
+		block.insert(block.end(), kPenLocation, kPenLocation + sizeof(kPenLocation));
+		block.insert(block.end(), kDisplayWindows, kDisplayWindows + sizeof(kDisplayWindows));
+	}
+	else
+	{
+		snprintf(text, sizeof(text), "Input %02u caption frame %03u, ok", input, frame);
+		block.insert(block.end(), text, text + std::min<size_t>(strlen(text), 31));
+	}
+}
+
+// Built with a sequence counter of 0
+void buildCDP(unsigned input, unsigned frame, BenchmarkCDP& cdp)
+{
+	std::vector<uint8_t>	block;
+	uint8_t					packet[kDTVCCPacketSize] = { 0 };
+	uint8_t*				p = cdp.data;
+	uint8_t					checksum = 0;
+
+	buildServiceBlock(input, frame, block);
+
+	// DTVCC packet header, then the service 1 block, padded with a null service block
+	packet[0] = (uint8_t)(((frame & 0x3) << 6) | (kDTVCCPacketSize / 2));
+	packet[1] = (uint8_t)((1 << 5) | block.size());
+	memcpy(packet + 2, block.data(), block.size());
+
+	*p++ = 0x96;
+	*p++ = 0x69;
+	*p++ = 0;										// cdp_length, filled below
+	*p++ = (kFrameRateCode << 4) | 0x0F;
+	*p++ = 0x40 | 0x20 | 0x10 | 0x04 | 0x02 | 0x01;	// ccdata_present, svcinfo_present, start, complete, active
+	*p++ = 0;
+	*p++ = 0;
+
+	*p++ = 0x72;
+	*p++ = 0xE0 | kCCCount;
+	for (unsigned i = 0; i < kCC608Count; i++)
+	{
+		*p++ = 0xFC | i;
+		*p++ = 0x80;
+		*p++ = 0x80;
+	}
+	for (unsigned i = 0; i < kCCCount - kCC608Count; i++)
+	{
+		*p++ = 0xFC | ((i == 0) ? 3 : 2);
+		*p++ = packet[2 * i];
+		*p++ = packet[2 * i + 1];
+	}
+
+	static const uint8_t kServiceInfo[] = { 0x73, 0xD1, 0x81, 'e', 'n', 'g', 0x81, 0x7F, 0xFF };
+	memcpy(p, kServiceInfo, sizeof(kServiceInfo));
+	p += sizeof(kServiceInfo);
+
+	*p++ = 0x74;
+	*p++ = 0;
+	*p++ = 0;
+
+	cdp.size = (uint32_t)(p - cdp.data) + 1;
+	cdp.data[2] = (uint8_t)cdp.size;
+	for (uint8_t* q = cdp.data; q < p; q++)
+		checksum += *q;
+	*p = (uint8_t)(256 - checksum);
+}
+
+// Write the sequence counter into the header and footer, and correct the checksum for the 4 bytes
+void setSequence(BenchmarkCDP& cdp, uint16_t sequence, uint8_t baseChecksum)
+{
+	uint8_t high = (uint8_t)(sequence >> 8);
+	uint8_t low = (uint8_t)sequence;
+
+	cdp.data[5] = cdp.data[cdp.size - 3] = high;
+	cdp.data[6] = cdp.data[cdp.size - 2] = low;
+	cdp.data[cdp.size - 1] = (uint8_t)(baseChecksum - 2 * (high + low));
+}
+
+}
+
+bool RunCaptionDecoderBenchmark(unsigned inputCount, unsigned secondsOfVideo)
+{
+	unsigned									frameCount = (unsigned)(secondsOfVideo * kFrameRate);
+	std::vector<BenchmarkCDP>					cdps(inputCount * kCycleLength);
+	std::vector<uint8_t>						baseChecksums(inputCount * kCycleLength);
+	std::vector<BenchmarkAncillaryPacket>		packets(inputCount);
+	std::vector<BenchmarkVideoFrame>			frames;
+	std::vector<CaptionDecoder>					decoders(inputCount);
+	uint64_t									elementCount = 0;
+
+	for (unsigned input = 0; input < inputCount; input++)
+	{
+		frames.push_back(BenchmarkVideoFrame(&packets[input]));
+		for (unsigned frame = 0; frame < kCycleLength; frame++)
+		{
+			BenchmarkCDP& cdp = cdps[input * kCycleLength + frame];
+			buildCDP(input, frame, cdp);
+			baseChecksums[input * kCycleLength + frame] = cdp.data[cdp.size - 1];
+		}
+	}
+
+	printf("Decoding %u seconds of 29.97 fps CDPs from %u inputs\n", secondsOfVideo, inputCount);
+
+	auto startTime = std::chrono::steady_clock::now();
+
+	for (unsigned frame = 0; frame < frameCount; frame++)
+	{
+		for (unsigned input = 0; input < inputCount; input++)
+		{
+			unsigned		index = input * kCycleLength + frame % kCycleLength;
+			BenchmarkCDP&	cdp = cdps[index];
+
+			setSequence(cdp, (uint16_t)frame, baseChecksums[index]);
+			packets[input].setCDP(&cdp);
+			decoders[input].decode(&frames[input]);
+			elementCount += decoders[input].getElementCount();
+		}
+	}
+
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+	double cdpCount = (double)frameCount * inputCount;
+	double nsPerCDP = elapsed.count() * 1e9 / cdpCount;
+
+	CaptionDecoder::Statistics total;
+	memset(&total, 0, sizeof(total));
+	for (const CaptionDecoder& decoder : decoders)
+	{
+		const CaptionDecoder::Statistics& statistics = decoder.getStatistics();
+		total.cdps					+= statistics.cdps;
+		total.invalidCDPs			+= statistics.invalidCDPs;
+		total.sequenceErrors		+= statistics.sequenceErrors;
+		total.dtvccPackets			+= statistics.dtvccPackets;
+		total.dtvccPacketErrors		+= statistics.dtvccPacketErrors;
+		total.dtvccSequenceErrors	+= statistics.dtvccSequenceErrors;
+		total.textBytes				+= statistics.textBytes;
+		total.commands				+= statistics.commands;
+	}
+
+	printf("  %.0f CDPs/s, %.0f ns per CDP, %.3f%% of one CPU for %u inputs at 29.97 fps and %.3f%% at 59.94 fps\n",
+			cdpCount / elapsed.count(), nsPerCDP,
+			nsPerCDP * 1e-9 * kFrameRate * inputCount * 100.0, inputCount,
+			nsPerCDP * 1e-9 * kFrameRate * 2.0 * inputCount * 100.0);
+	printf("  %llu CDPs, %llu DTVCC packets, %llu elements (%llu text bytes, %llu commands)\n",
+			(unsigned long long)total.cdps, (unsigned long long)total.dtvccPackets, (unsigned long long)elementCount,
+			(unsigned long long)total.textBytes, (unsigned long long)total.commands);
+	printf("  Errors: %llu invalid CDPs, %llu CDP sequence, %llu DTVCC packet, %llu DTVCC sequence\n",
+			(unsigned long long)total.invalidCDPs, (unsigned long long)total.sequenceErrors,
+			(unsigned long long)total.dtvccPacketErrors, (unsigned long long)total.dtvccSequenceErrors);
+
+	return total.invalidCDPs == 0 && total.sequenceErrors == 0 && total.dtvccPacketErrors == 0 && total.dtvccSequenceErrors == 0;
+}
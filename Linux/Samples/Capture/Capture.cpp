@@ -45,11 +45,28 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <csignal>
+#include <chrono>
 
 #include "DeckLinkAPI.h"
+#include "AncillaryBenchmark.h"
+#include "AncillaryCodec.h"
+#include "AsyncLogger.h"
+#include "AudioLevelMeter.h"
+#include "CaptionDecoder.h"
+#include "CaptionDecoderBenchmark.h"
 #include "Capture.h"
 #include "Config.h"
 
+// Per-frame messages are logged from the capture callback thread, so defer formatting to the logger thread
+static const uint32_t	kNoInputSignalMessagesPerSecond = 1;
+
+// Ancillary time code and decoder statistics are reported every kAncillaryReportFrames frames
+static const unsigned	kAncillaryReportFrames = 30;
+static const size_t		kMaxAncillaryPayloads = 16;
+
+// Audio loudness is reported every kAudioLevelReportFrames audio packets
+static const unsigned	kAudioLevelReportFrames = 30;
+
 static pthread_mutex_t	g_sleepMutex;
 static pthread_cond_t	g_sleepCond;
 static int				g_videoOutputFile = -1;
@@ -62,6 +79,217 @@ static IDeckLinkInput*	g_deckLinkInput = NULL;
 
 static unsigned long	g_frameCount = 0;
 
+static AsyncLogger		g_logger;
+static LogRateLimiter	g_noInputSignalRateLimiter(kNoInputSignalMessagesPerSecond);
+
+static CaptionDecoder	g_captionDecoder;
+static unsigned			g_captionFrameCount = 0;
+static int64_t			g_captionDecodeTotalNs = 0;
+static int64_t			g_captionDecodeMaxNs = 0;
+
+static AncillaryDecoder	g_ancillaryDecoder;
+static AncillaryPayload	g_ancillaryPayloads[kMaxAncillaryPayloads];
+static AncillaryPayload	g_lastPayloadIdentifier;
+static AncillaryPayload	g_lastAFDBarData;
+static AncillaryPayload	g_lastTimecode;
+static unsigned			g_ancillaryFrameCount = 0;
+
+static AudioLevelMeter	g_audioLevelMeter;
+static unsigned			g_audioLevelFrameCount = 0;
+
+// Convert CEA-708 G0/G1 caption text (ASCII with a music note at 0x7F, then Latin-1) to UTF-8
+static void CaptionTextToUTF8(const uint8_t* text, size_t length, char* utf8, size_t utf8Size)
+{
+	size_t out = 0;
+
+	for (size_t i = 0; i < length; i++)
+	{
+		uint8_t c = text[i];
+		size_t	size = (c == 0x7F) ? 3 : (c >= 0x80) ? 2 : 1;
+
+		if (out + size >= utf8Size)
+			break;
+
+		if (c == 0x7F)
+		{
+			utf8[out++] = (char)0xE2;
+			utf8[out++] = (char)0x99;
+			utf8[out++] = (char)0xAA;
+		}
+		else if (c >= 0x80)
+		{
+			utf8[out++] = (char)(0xC0 | (c >> 6));
+			utf8[out++] = (char)(0x80 | (c & 0x3F));
+		}
+		else
+			utf8[out++] = (char)c;
+	}
+
+	utf8[out] = '\0';
+}
+
+static void DecodeCaptions(IDeckLinkVideoFrame* videoFrame)
+{
+	auto	startTime = std::chrono::steady_clock::now();
+	bool	decoded = g_captionDecoder.decode(videoFrame);
+	int64_t	decodeNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - startTime).count();
+
+	g_captionDecodeTotalNs += decodeNs;
+	if (decodeNs > g_captionDecodeMaxNs)
+		g_captionDecodeMaxNs = decodeNs;
+
+	for (size_t i = 0; i < g_captionDecoder.getElementCount(); i++)
+	{
+		const CaptionElement& element = g_captionDecoder.getElement(i);
+
+		if (element.type == CaptionElement::kText)
+		{
+			char text[LogString::kMaxLength + 1];
+			CaptionTextToUTF8(element.bytes, element.length, text, sizeof(text));
+			g_logger.log("Captions: service %u \"%s\"\n", (unsigned)element.serviceNumber, LogString(text));
+		}
+		else
+		{
+			const char* name = CaptionDecoder::getCommandName(element.code);
+			if (name != NULL)
+				g_logger.log("Captions: service %u %s\n", (unsigned)element.serviceNumber, name);
+			else
+				g_logger.log("Captions: service %u command 0x%02x\n", (unsigned)element.serviceNumber, (unsigned)element.code);
+		}
+	}
+
+	// Report caption presence and decode time once a second
+	double		frameRate = g_captionDecoder.getFrameRate();
+	unsigned	framesPerSecond = (frameRate > 0.0) ? (unsigned)(frameRate + 0.5) : 30;
+
+	if (++g_captionFrameCount < framesPerSecond)
+		return;
+
+	const CaptionDecoder::Statistics& statistics = g_captionDecoder.getStatistics();
+
+	g_logger.log("Captions: %s, last caption data %lld frames ago, decode %lld ns average %lld ns max, errors %llu CDP, %llu CDP sequence, %llu DTVCC\n",
+		!decoded ? "no CDP" : g_captionDecoder.isCaptionServiceActive() ? "service active" : "no active service",
+		(long long)g_captionDecoder.getFramesSinceCaptionData(),
+		(long long)(g_captionDecodeTotalNs / g_captionFrameCount), (long long)g_captionDecodeMaxNs,
+		(unsigned long long)statistics.invalidCDPs, (unsigned long long)statistics.sequenceErrors,
+		(unsigned long long)(statistics.dtvccPacketErrors + statistics.dtvccSequenceErrors));
+
+	g_captionFrameCount = 0;
+	g_captionDecodeTotalNs = 0;
+	g_captionDecodeMaxNs = 0;
+}
+
+static void LogSCTE104Message(const SCTE104Message& message)
+{
+	for (uint8_t i = 0; i < message.operationCount; i++)
+	{
+		const SCTE104Operation&	operation = message.operations[i];
+		SCTE104SpliceRequest	request;
+
+		if (SCTE104DecodeSpliceRequest(operation, &request))
+			g_logger.log("SCTE-104: message %u splice_request type %u event %u program %u pre-roll %u ms break %u.%u s%s\n",
+				(unsigned)message.messageNumber, (unsigned)request.spliceInsertType, request.spliceEventID,
+				(unsigned)request.uniqueProgramID, (unsigned)request.preRollTimeMs,
+				(unsigned)(request.breakDuration / 10), (unsigned)(request.breakDuration % 10),
+				request.autoReturn ? " auto return" : "");
+		else
+			g_logger.log("SCTE-104: message %u operation 0x%04x, %u bytes\n",
+				(unsigned)message.messageNumber, (unsigned)operation.opID, (unsigned)operation.dataLength);
+	}
+}
+
+// VPID and AFD are logged when they change and SCTE-104 messages as they arrive
+static void DecodeAncillary(IDeckLinkVideoFrame* videoFrame)
+{
+	size_t count = g_ancillaryDecoder.decode(videoFrame, g_ancillaryPayloads, kMaxAncillaryPayloads);
+
+	for (size_t i = 0; i < count; i++)
+	{
+		const AncillaryPayload& payload = g_ancillaryPayloads[i];
+
+		switch (payload.type)
+		{
+			case kAncillaryPayloadPayloadIdentifier:
+				if (g_lastPayloadIdentifier.type != payload.type ||
+					memcmp(g_lastPayloadIdentifier.payloadIdentifier.bytes, payload.payloadIdentifier.bytes, sizeof(payload.payloadIdentifier.bytes)) != 0)
+				{
+					const PayloadIdentifier& vpid = payload.payloadIdentifier;
+					g_logger.log("VPID: line %u payload 0x%02x %s transport %s picture, picture rate %u, sampling %u, bit depth %u\n",
+						payload.lineNumber, (unsigned)vpid.getPayloadType(),
+						vpid.isProgressiveTransport() ? "progressive" : "interlaced",
+						vpid.isProgressivePicture() ? "progressive" : "interlaced",
+						(unsigned)vpid.getPictureRate(), (unsigned)vpid.getSamplingStructure(), (unsigned)vpid.getBitDepth());
+				}
+				g_lastPayloadIdentifier = payload;
+				break;
+
+			case kAncillaryPayloadAFDBarData:
+				if (g_lastAFDBarData.type != payload.type ||
+					g_lastAFDBarData.afdBarData.afd != payload.afdBarData.afd ||
+					g_lastAFDBarData.afdBarData.aspectRatio16x9 != payload.afdBarData.aspectRatio16x9 ||
+					g_lastAFDBarData.afdBarData.barFlags != payload.afdBarData.barFlags ||
+					g_lastAFDBarData.afdBarData.barValue1 != payload.afdBarData.barValue1 ||
+					g_lastAFDBarData.afdBarData.barValue2 != payload.afdBarData.barValue2)
+				{
+					const AFDBarData& afd = payload.afdBarData;
+					g_logger.log("AFD: line %u code %u in %s frame, bars 0x%x %u %u\n",
+						payload.lineNumber, (unsigned)afd.afd, afd.aspectRatio16x9 ? "16:9" : "4:3",
+						(unsigned)afd.barFlags, (unsigned)afd.barValue1, (unsigned)afd.barValue2);
+				}
+				g_lastAFDBarData = payload;
+				break;
+
+			case kAncillaryPayloadTimecode:
+				g_lastTimecode = payload;
+				break;
+
+			case kAncillaryPayloadSCTE104:
+				LogSCTE104Message(payload.scte104);
+				break;
+
+			default:
+				break;
+		}
+	}
+
+	if (++g_ancillaryFrameCount < kAncillaryReportFrames)
+		return;
+
+	const AncillaryDecoder::Statistics& statistics = g_ancillaryDecoder.getStatistics();
+
+	if (g_lastTimecode.type == kAncillaryPayloadTimecode)
+	{
+		const AncillaryTimecode& timecode = g_lastTimecode.timecode;
+		g_logger.log("ATC: line %u type %u %02u:%02u:%02u%c%02u user bits %08x\n",
+			g_lastTimecode.lineNumber, (unsigned)timecode.type,
+			(unsigned)timecode.hours, (unsigned)timecode.minutes, (unsigned)timecode.seconds,
+			timecode.dropFrame ? ';' : ':', (unsigned)timecode.frames, timecode.userBits);
+	}
+
+	g_logger.log("Ancillary data: %llu packets, %llu decoded, %llu unknown, %llu malformed\n",
+		(unsigned long long)statistics.packets, (unsigned long long)statistics.decoded,
+		(unsigned long long)statistics.unknown, (unsigned long long)statistics.malformed);
+
+	g_lastTimecode.type = kAncillaryPayloadUnknown;
+	g_ancillaryFrameCount = 0;
+}
+
+static void MeterAudio(IDeckLinkAudioInputPacket* audioFrame)
+{
+	AudioLoudness loudness;
+
+	g_audioLevelMeter.processPacket(audioFrame);
+
+	if (++g_audioLevelFrameCount < kAudioLevelReportFrames)
+		return;
+
+	g_audioLevelMeter.getLoudness(loudness);
+	g_logger.log("Audio loudness: Momentary = %.1f LUFS, Short-term = %.1f LUFS, Integrated = %.1f LUFS, Maximum True-Peak = %.1f dBTP\n",
+		loudness.momentary, loudness.shortTerm, loudness.integrated, AudioLevelMeter::toDecibels(loudness.maxTruePeak));
+
+	g_audioLevelFrameCount = 0;
+}
+
 DeckLinkCaptureDelegate::DeckLinkCaptureDelegate() : 
 	m_refCount(1),
 	m_pixelFormat(g_config.m_pixelFormat)
@@ -107,28 +335,42 @@ HRESULT DeckLinkCaptureDelegate::VideoInputFrameArrived(IDeckLinkVideoInputFrame
 
 		if (videoFrame->GetFlags() & bmdFrameHasNoInputSource)
 		{
-			printf("Frame received (#%lu) - No input signal detected\n", g_frameCount);
+			g_logger.log(g_noInputSignalRateLimiter, "Frame received (#%lu) - No input signal detected\n", g_frameCount);
 		}
 		else
 		{
-			const char *timecodeString = NULL;
-			if (g_config.m_timecodeFormat != 0)
+			IDeckLinkTimecode*	timecode = NULL;
+			uint8_t				hours, minutes, seconds, frames;
+
+			// Read the timecode components rather than IDeckLinkTimecode::GetString, which allocates the string
+			if ((g_config.m_timecodeFormat != 0) &&
+				(videoFrame->GetTimecode(g_config.m_timecodeFormat, &timecode) == S_OK) &&
+				(timecode->GetComponents(&hours, &minutes, &seconds, &frames) == S_OK))
 			{
-				IDeckLinkTimecode *timecode;
-				if (videoFrame->GetTimecode(g_config.m_timecodeFormat, &timecode) == S_OK)
-				{
-					timecode->GetString(&timecodeString);
-				}
+				g_logger.log("Frame received (#%lu) [%02u:%02u:%02u%c%02u] - %s - Size: %li bytes\n",
+					g_frameCount,
+					(unsigned)hours, (unsigned)minutes, (unsigned)seconds,
+					(timecode->GetFlags() & bmdTimecodeIsDropFrame) ? ';' : ':',
+					(unsigned)frames,
+					rightEyeFrame != NULL ? "Valid Frame (3D left/right)" : "Valid Frame",
+					videoFrame->GetRowBytes() * videoFrame->GetHeight());
 			}
+			else
+			{
+				g_logger.log("Frame received (#%lu) [No timecode] - %s - Size: %li bytes\n",
+					g_frameCount,
+					rightEyeFrame != NULL ? "Valid Frame (3D left/right)" : "Valid Frame",
+					videoFrame->GetRowBytes() * videoFrame->GetHeight());
+			}
+
+			if (timecode)
+				timecode->Release();
 
-			printf("Frame received (#%lu) [%s] - %s - Size: %li bytes\n",
-				g_frameCount,
-				timecodeString != NULL ? timecodeString : "No timecode",
-				rightEyeFrame != NULL ? "Valid Frame (3D left/right)" : "Valid Frame",
-				videoFrame->GetRowBytes() * videoFrame->GetHeight());
+			if (g_config.m_decodeCaptions)
+				DecodeCaptions(videoFrame);
 
-			if (timecodeString)
-				free((void*)timecodeString);
+			if (g_config.m_decodeAncillary)
+				DecodeAncillary(videoFrame);
 
 			if (g_videoOutputFile != -1)
 			{
@@ -152,6 +394,9 @@ HRESULT DeckLinkCaptureDelegate::VideoInputFrameArrived(IDeckLinkVideoInputFrame
 	// Handle Audio Frame
 	if (audioFrame)
 	{
+		if (g_config.m_loudnessFirstChannel > 0)
+			MeterAudio(audioFrame);
+
 		if (g_audioOutputFile != -1)
 		{
 			audioFrame->GetBytes(&audioFrameBytes);
@@ -257,6 +502,14 @@ int main(int argc, char *argv[])
 		goto bail;
 	}
 
+	if (g_config.m_benchmarkInputs > 0)
+	{
+		bool captionsPassed = RunCaptionDecoderBenchmark(g_config.m_benchmarkInputs, 600);
+		bool ancillaryPassed = RunAncillaryBenchmark(g_config.m_benchmarkInputs, 600);
+		exitStatus = (captionsPassed && ancillaryPassed) ? 0 : 1;
+		goto bail;
+	}
+
 	// Get the DeckLink device
 	deckLink = g_config.GetSelectedDeckLink();
 	if (deckLink == NULL)
@@ -366,6 +619,18 @@ int main(int argc, char *argv[])
 		}
 	}
 
+	// Configure the audio meter for the captured channels
+	if (g_config.m_loudnessFirstChannel > 0)
+	{
+		if (!g_audioLevelMeter.setLoudnessChannels(g_config.m_loudnessFirstChannel - 1, g_config.m_loudnessLastChannel - g_config.m_loudnessFirstChannel + 1) ||
+			!g_audioLevelMeter.configure(g_config.m_audioChannels, (BMDAudioSampleType)g_config.m_audioSampleDepth))
+		{
+			fprintf(stderr, "Unable to meter loudness of audio channels %d-%d, the group must be mono, stereo, 5.1 or 7.1\n",
+				g_config.m_loudnessFirstChannel, g_config.m_loudnessLastChannel);
+			goto bail;
+		}
+	}
+
 	// Block main thread until signal occurs
 	while (!g_do_exit)
 	{
@@ -398,6 +663,14 @@ int main(int argc, char *argv[])
 		g_deckLinkInput->DisableVideoInput();
 	}
 
+	if (g_config.m_loudnessFirstChannel > 0)
+	{
+		AudioLoudness loudness;
+		g_audioLevelMeter.getLoudness(loudness);
+		g_logger.log("Audio Integrated Loudness: %.1f LUFS, Maximum True-Peak = %.1f dBTP\n",
+			loudness.integrated, AudioLevelMeter::toDecibels(loudness.maxTruePeak));
+	}
+
 bail:
 	if (g_videoOutputFile != 0)
 		close(g_videoOutputFile);
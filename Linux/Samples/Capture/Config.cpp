@@ -51,6 +51,11 @@ BMDConfig::BMDConfig() :
 	m_audioChannels(2),
 	m_audioSampleDepth(16),
 	m_maxFrames(-1),
+	m_decodeCaptions(false),
+	m_decodeAncillary(false),
+	m_loudnessFirstChannel(0),
+	m_loudnessLastChannel(0),
+	m_benchmarkInputs(0),
 	m_inputFlags(bmdVideoInputFlagDefault),
 	m_pixelFormat(bmdFormat8BitYUV),
 	m_timecodeFormat(),
@@ -75,7 +80,7 @@ bool BMDConfig::ParseArguments(int argc,  char** argv)
 	int		ch;
 	bool	displayHelp = false;
 
-	while ((ch = getopt(argc, argv, "d:?h3c:s:v:a:m:n:p:t:")) != -1)
+	while ((ch = getopt(argc, argv, "d:?h3c:s:v:a:m:n:p:t:CAb:L:")) != -1)
 	{
 		switch (ch)
 		{
@@ -123,6 +128,32 @@ bool BMDConfig::ParseArguments(int argc,  char** argv)
 				m_inputFlags |= bmdVideoInputDualStream3D;
 				break;
 
+			case 'C':
+				m_decodeCaptions = true;
+				break;
+
+			case 'A':
+				m_decodeAncillary = true;
+				break;
+
+			case 'L':
+				if ((sscanf(optarg, "%d-%d", &m_loudnessFirstChannel, &m_loudnessLastChannel) != 2) ||
+					(m_loudnessFirstChannel < 1) || (m_loudnessLastChannel < m_loudnessFirstChannel))
+				{
+					fprintf(stderr, "Invalid argument: Loudness channels \"%s\" must be given as <first>-<last>, eg 1-2\n", optarg);
+					return false;
+				}
+				break;
+
+			case 'b':
+				m_benchmarkInputs = atoi(optarg);
+				if (m_benchmarkInputs <= 0)
+				{
+					fprintf(stderr, "Invalid argument: Number of benchmark inputs must be greater than 0\n");
+					return false;
+				}
+				break;
+
 			case 'p':
 				switch(atoi(optarg))
 				{
@@ -155,6 +186,10 @@ bool BMDConfig::ParseArguments(int argc,  char** argv)
 		}
 	}
 
+	// The decoder benchmarks do not use a device
+	if (m_benchmarkInputs > 0 && !displayHelp)
+		return true;
+
 	if (m_deckLinkIndex < 0)
 	{
 		fprintf(stderr, "You must select a device\n");
@@ -170,6 +205,13 @@ bool BMDConfig::ParseArguments(int argc,  char** argv)
 	if (displayHelp)
 		DisplayUsage(0);
 
+	if (m_loudnessLastChannel > m_audioChannels)
+	{
+		fprintf(stderr, "Invalid argument: Loudness channels %d-%d are not within the %d captured audio channels\n",
+			m_loudnessFirstChannel, m_loudnessLastChannel, m_audioChannels);
+		return false;
+	}
+
 	// Get device and display mode names
 	IDeckLink* deckLink = GetSelectedDeckLink();
 	if (deckLink != NULL)
@@ -448,6 +490,10 @@ bail:
 		"    -s <depth>           Audio Sample Depth (16 or 32 - default is 16)\n"
 		"    -n <frames>          Number of frames to capture (default is unlimited)\n"
 		"    -3                   Capture Stereoscopic 3D (Requires 3D Hardware support)\n"
+		"    -C                   Decode and print CEA-708 captions from the ancillary data of each frame\n"
+		"    -A                   Decode and print VPID, AFD, ATC and SCTE-104 ancillary packets of each frame\n"
+		"    -L <first>-<last>    Meter the loudness and true-peak of a mono, stereo, 5.1 or 7.1 channel group, eg 1-2\n"
+		"    -b <inputs>          Benchmark the caption and ancillary data decoders with the given number of inputs, without a device\n"
 		"\n"
 		"Capture video and/or audio to a file. Raw video and/or audio can be viewed with mplayer eg:\n"
 		"\n"
@@ -475,18 +521,29 @@ bail:
 
 void BMDConfig::DisplayConfiguration()
 {
+	char loudnessChannels[32] = "off";
+
+	if (m_loudnessFirstChannel > 0)
+		snprintf(loudnessChannels, sizeof(loudnessChannels), "channels %d-%d", m_loudnessFirstChannel, m_loudnessLastChannel);
+
 	fprintf(stderr, "Capturing with the following configuration:\n"
 		" - Capture device: %s\n"
 		" - Video mode: %s %s\n"
 		" - Pixel format: %s\n"
 		" - Audio channels: %u\n"
-		" - Audio sample depth: %u bit \n",
+		" - Audio sample depth: %u bit \n"
+		" - Caption decoding: %s\n"
+		" - Ancillary data decoding: %s\n"
+		" - Loudness metering: %s\n",
 		m_deckLinkName,
 		m_displayModeName,
 		(m_inputFlags & bmdVideoInputDualStream3D) ? "3D" : "",
 		GetPixelFormatName(m_pixelFormat),
 		m_audioChannels,
-		m_audioSampleDepth
+		m_audioSampleDepth,
+		m_decodeCaptions ? "CEA-708" : "off",
+		m_decodeAncillary ? "VPID, AFD, ATC, SCTE-104" : "off",
+		loudnessChannels
 	);
 }
 
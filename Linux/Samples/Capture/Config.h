@@ -61,6 +61,12 @@ public:
 
 	int						m_maxFrames;
 
+	bool					m_decodeCaptions;
+	bool					m_decodeAncillary;
+	int						m_loudnessFirstChannel;		// 1 based, 0 if audio is not metered
+	int						m_loudnessLastChannel;
+	int						m_benchmarkInputs;
+
 	BMDVideoInputFlags		m_inputFlags;
 	BMDPixelFormat			m_pixelFormat;
 	BMDTimecodeFormat		m_timecodeFormat;
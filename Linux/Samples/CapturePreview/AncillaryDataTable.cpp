@@ -38,6 +38,8 @@
 ** -LICENSE-END-
 */
 
+#include <algorithm>
+
 #include "AncillaryDataTable.h"
 
 AncillaryDataTable::AncillaryDataTable(QObject* parent)
@@ -47,41 +49,100 @@ AncillaryDataTable::AncillaryDataTable(QObject* parent)
 	m_metadataValues << "" << "" << "" << "" << "" << "" << "" << "" << "" << "" << "" << "" << "" << "";
 }
 
-void AncillaryDataTable::UpdateFrameData(AncillaryDataStruct* newAncData, MetadataStruct* newMetadata)
+void AncillaryDataTable::UpdateFrameData(const FrameMetadata& frameMetadata)
 {
-	// VITC timecodes
-	m_ancillaryDataValues.replace(0, newAncData->vitcF1Timecode);
-	m_ancillaryDataValues.replace(1, newAncData->vitcF1UserBits);
-	m_ancillaryDataValues.replace(2, newAncData->vitcF2Timecode);
-	m_ancillaryDataValues.replace(3, newAncData->vitcF2UserBits);
-
-	// RP188 timecodes and user bits
-	m_ancillaryDataValues.replace(4, newAncData->rp188vitc1Timecode);
-	m_ancillaryDataValues.replace(5, newAncData->rp188vitc1UserBits);
-	m_ancillaryDataValues.replace(6, newAncData->rp188vitc2Timecode);
-	m_ancillaryDataValues.replace(7, newAncData->rp188vitc2UserBits);
-	m_ancillaryDataValues.replace(8, newAncData->rp188ltcTimecode);
-	m_ancillaryDataValues.replace(9, newAncData->rp188ltcUserBits);
-	m_ancillaryDataValues.replace(10, newAncData->rp188hfrtcTimecode);
-	m_ancillaryDataValues.replace(11, newAncData->rp188hfrtcUserBits);
+	QStringList	ancillaryDataValues;
+	QStringList	metadataValues;
+	int			firstChangedRow = rowCount();
+	int			lastChangedRow = -1;
+
+	// Timecodes and user bits
+	for (int i = 0; i < kAncillaryTimecodeCount; i++)
+		ancillaryDataValues << FormatTimecode(frameMetadata.timecodes[i]) << FormatUserBits(frameMetadata.timecodes[i]);
 
 	// Static Metadata
-	m_metadataValues.replace(0, newMetadata->electroOpticalTransferFunction);
-	m_metadataValues.replace(1, newMetadata->displayPrimariesRedX);
-	m_metadataValues.replace(2, newMetadata->displayPrimariesRedY);
-	m_metadataValues.replace(3, newMetadata->displayPrimariesGreenX);
-	m_metadataValues.replace(4, newMetadata->displayPrimariesGreenY);
-	m_metadataValues.replace(5, newMetadata->displayPrimariesBlueX);
-	m_metadataValues.replace(6, newMetadata->displayPrimariesBlueY);
-	m_metadataValues.replace(7, newMetadata->whitePointX);
-	m_metadataValues.replace(8, newMetadata->whitePointY);
-	m_metadataValues.replace(9, newMetadata->maxDisplayMasteringLuminance);
-	m_metadataValues.replace(10, newMetadata->minDisplayMasteringLuminance);
-	m_metadataValues.replace(11, newMetadata->maximumContentLightLevel);
-	m_metadataValues.replace(12, newMetadata->maximumFrameAverageLightLevel);
-	m_metadataValues.replace(13, newMetadata->colorspace);
-
-	emit dataChanged(index(0, static_cast<int>(AncillaryHeader::Values)), index(rowCount()-1, static_cast<int>(AncillaryHeader::Values)));
+	metadataValues << FormatElectroOpticalTransferFunction(frameMetadata);
+	for (int i = 0; i < kHDRMetadataFloatCount; i++)
+		metadataValues << ((frameMetadata.hdrFloatValidMask & (1 << i)) ? QString::number(frameMetadata.hdrFloatValues[i], 'f', 4) : QString());
+	metadataValues << FormatColorspace(frameMetadata);
+
+	// Only notify the view of the rows that have changed
+	for (int row = 0; row < rowCount(); row++)
+	{
+		QStringList&	values = (row < kAncillaryDataTypes.size()) ? m_ancillaryDataValues : m_metadataValues;
+		QStringList&	newValues = (row < kAncillaryDataTypes.size()) ? ancillaryDataValues : metadataValues;
+		int				valueIndex = (row < kAncillaryDataTypes.size()) ? row : row - kAncillaryDataTypes.size();
+
+		if (values.at(valueIndex) != newValues.at(valueIndex))
+		{
+			values.replace(valueIndex, newValues.at(valueIndex));
+			firstChangedRow = std::min(firstChangedRow, row);
+			lastChangedRow = row;
+		}
+	}
+
+	if (lastChangedRow >= 0)
+		emit dataChanged(index(firstChangedRow, static_cast<int>(AncillaryHeader::Values)), index(lastChangedRow, static_cast<int>(AncillaryHeader::Values)));
+}
+
+QString AncillaryDataTable::FormatTimecode(const TimecodeData& timecode)
+{
+	if (!timecode.valid)
+		return QString();
+
+	// Drop frame timecodes use a semicolon before the frames
+	return QString("%1:%2:%3%4%5")
+		.arg(timecode.hours, 2, 10, QChar('0'))
+		.arg(timecode.minutes, 2, 10, QChar('0'))
+		.arg(timecode.seconds, 2, 10, QChar('0'))
+		.arg((timecode.flags & bmdTimecodeIsDropFrame) ? ';' : ':')
+		.arg(timecode.frames, 2, 10, QChar('0'));
+}
+
+QString AncillaryDataTable::FormatUserBits(const TimecodeData& timecode)
+{
+	if (!timecode.valid)
+		return QString();
+
+	return QString("0x%1").arg(timecode.userBits, 8, 16, QChar('0'));
+}
+
+QString AncillaryDataTable::FormatElectroOpticalTransferFunction(const FrameMetadata& frameMetadata)
+{
+	if (!frameMetadata.hasElectroOpticalTransferFunction)
+		return QString();
+
+	switch (frameMetadata.electroOpticalTransferFunction)
+	{
+	case 0:
+		return "SDR";
+	case 1:
+		return "HDR";
+	case 2:
+		return "PQ (ST2084)";
+	case 3:
+		return "HLG";
+	default:
+		return QString("Unknown EOTF: %1").arg((int32_t)frameMetadata.electroOpticalTransferFunction);
+	}
+}
+
+QString AncillaryDataTable::FormatColorspace(const FrameMetadata& frameMetadata)
+{
+	if (!frameMetadata.hasColorspace)
+		return QString();
+
+	switch (frameMetadata.colorspace)
+	{
+	case bmdColorspaceRec601:
+		return "Rec.601";
+	case bmdColorspaceRec709:
+		return "Rec.709";
+	case bmdColorspaceRec2020:
+		return "Rec.2020";
+	default:
+		return QString("Unknown Colorspace: %1").arg((int32_t)frameMetadata.colorspace);
+	}
 }
 
 QVariant AncillaryDataTable::data(const QModelIndex& index, int role) const
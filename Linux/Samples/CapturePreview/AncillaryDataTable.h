@@ -44,6 +44,8 @@
 #include <QMutex>
 #include <QStringList>
 
+#include "DeckLinkAPI.h"
+
 enum class AncillaryHeader : int { Types, Values };
 const int kAncillaryTableColumnCount = 2;
 
@@ -79,40 +81,57 @@ const QStringList kMetadataTypes = {
 	"Static Colorspace",
 };
 
-typedef struct {
-	// VITC timecodes and user bits for field 1 & 2
-	QString vitcF1Timecode;
-	QString vitcF1UserBits;
-	QString vitcF2Timecode;
-	QString vitcF2UserBits;
-
-	// RP188 timecodes and user bits (VITC1, VITC2, LTC and HFRTC)
-	QString rp188vitc1Timecode;
-	QString rp188vitc1UserBits;
-	QString rp188vitc2Timecode;
-	QString rp188vitc2UserBits;
-	QString rp188ltcTimecode;
-	QString rp188ltcUserBits;
-	QString rp188hfrtcTimecode;
-	QString rp188hfrtcUserBits;
-} AncillaryDataStruct;
-
-typedef struct {
-	QString electroOpticalTransferFunction;
-	QString displayPrimariesRedX;
-	QString displayPrimariesRedY;
-	QString displayPrimariesGreenX;
-	QString displayPrimariesGreenY;
-	QString displayPrimariesBlueX;
-	QString displayPrimariesBlueY;
-	QString whitePointX;
-	QString whitePointY;
-	QString maxDisplayMasteringLuminance;
-	QString minDisplayMasteringLuminance;
-	QString maximumContentLightLevel;
-	QString maximumFrameAverageLightLevel;
-	QString colorspace;
-} MetadataStruct;
+// Timecodes in the order of kAncillaryDataTypes, each has a timecode row and a user bits row
+const BMDTimecodeFormat kAncillaryTimecodeFormats[] = {
+	bmdTimecodeVITC,
+	bmdTimecodeVITCField2,
+	bmdTimecodeRP188VITC1,
+	bmdTimecodeRP188VITC2,
+	bmdTimecodeRP188LTC,
+	bmdTimecodeRP188HighFrameRate,
+};
+const int kAncillaryTimecodeCount = sizeof(kAncillaryTimecodeFormats) / sizeof(kAncillaryTimecodeFormats[0]);
+
+// Static HDR metadata values in the order of kMetadataTypes, following the EOTF row
+const BMDDeckLinkFrameMetadataID kHDRMetadataFloatIDs[] = {
+	bmdDeckLinkFrameMetadataHDRDisplayPrimariesRedX,
+	bmdDeckLinkFrameMetadataHDRDisplayPrimariesRedY,
+	bmdDeckLinkFrameMetadataHDRDisplayPrimariesGreenX,
+	bmdDeckLinkFrameMetadataHDRDisplayPrimariesGreenY,
+	bmdDeckLinkFrameMetadataHDRDisplayPrimariesBlueX,
+	bmdDeckLinkFrameMetadataHDRDisplayPrimariesBlueY,
+	bmdDeckLinkFrameMetadataHDRWhitePointX,
+	bmdDeckLinkFrameMetadataHDRWhitePointY,
+	bmdDeckLinkFrameMetadataHDRMaxDisplayMasteringLuminance,
+	bmdDeckLinkFrameMetadataHDRMinDisplayMasteringLuminance,
+	bmdDeckLinkFrameMetadataHDRMaximumContentLightLevel,
+	bmdDeckLinkFrameMetadataHDRMaximumFrameAverageLightLevel,
+};
+const int kHDRMetadataFloatCount = sizeof(kHDRMetadataFloatIDs) / sizeof(kHDRMetadataFloatIDs[0]);
+
+// Ancillary data and metadata of a captured frame, kept in binary form so that it can be captured for every frame
+// without allocating.  It is only formatted as text when the table is refreshed.
+struct TimecodeData {
+	bool				valid;
+	uint8_t				hours;
+	uint8_t				minutes;
+	uint8_t				seconds;
+	uint8_t				frames;
+	BMDTimecodeFlags	flags;
+	BMDTimecodeUserBits	userBits;
+};
+
+struct FrameMetadata {
+	bool				signalValid;
+	TimecodeData		timecodes[kAncillaryTimecodeCount];
+
+	bool				hasElectroOpticalTransferFunction;
+	int64_t				electroOpticalTransferFunction;
+	uint32_t			hdrFloatValidMask;						// Bit set for each valid entry of hdrFloatValues
+	double				hdrFloatValues[kHDRMetadataFloatCount];
+	bool				hasColorspace;
+	int64_t				colorspace;
+};
 
 class AncillaryDataTable : public QAbstractTableModel
 {
@@ -122,7 +141,7 @@ public:
 	AncillaryDataTable(QObject* parent = nullptr);
 	virtual ~AncillaryDataTable() {}
 
-	void UpdateFrameData(AncillaryDataStruct* newAncData, MetadataStruct* newMetadata);
+	void UpdateFrameData(const FrameMetadata& frameMetadata);
 
 	// QAbstractTableModel methods
 	int			rowCount(const QModelIndex& parent = QModelIndex()) const override { Q_UNUSED(parent); return kAncillaryDataTypes.size() + kMetadataTypes.size(); }
@@ -134,5 +153,10 @@ private:
 	QMutex			m_updateMutex;
 	QStringList		m_ancillaryDataValues;
 	QStringList		m_metadataValues;
+
+	static QString	FormatTimecode(const TimecodeData& timecode);
+	static QString	FormatUserBits(const TimecodeData& timecode);
+	static QString	FormatElectroOpticalTransferFunction(const FrameMetadata& frameMetadata);
+	static QString	FormatColorspace(const FrameMetadata& frameMetadata);
 };
 
@@ -38,6 +38,7 @@
 ** -LICENSE-END-
 */
 
+#include <algorithm>
 #include <QMessageBox>
 #include "CapturePreview.h"
 #include "ui_CapturePreview.h"
@@ -53,6 +54,9 @@ const QVector<QPair<BMDVideoConnection, QString>> kVideoInputConnections =
 	qMakePair(bmdVideoConnectionSVideo,		QString("S-Video")),
 };
 
+// Rate that the ancillary data table and signal status are refreshed while capturing, frames arriving between refreshes are not displayed
+const int kDefaultUIRefreshRate = 10;
+
 
 CapturePreview::CapturePreview(QWidget *parent) :
 	QDialog(parent),
@@ -79,6 +83,10 @@ CapturePreview::CapturePreview(QWidget *parent) :
 
 	ui->invalidSignalLabel->setVisible(false);
 
+	m_uiRefreshTimer = new QTimer(this);
+	setUIRefreshRate(kDefaultUIRefreshRate);
+
+	connect(m_uiRefreshTimer, &QTimer::timeout, this, &CapturePreview::refreshFrameMetadata);
 	connect(ui->startButton, &QPushButton::clicked, this, &CapturePreview::toggleStart);
 	connect(ui->inputDevicePopup, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &CapturePreview::inputDeviceChanged);
 	connect(ui->inputConnectionPopup, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &CapturePreview::inputConnectionChanged);
@@ -128,14 +136,6 @@ void CapturePreview::customEvent(QEvent *event)
 		DeckLinkInputFormatChangedEvent* formatEvent = dynamic_cast<DeckLinkInputFormatChangedEvent*>(event);
 		videoFormatChanged(formatEvent->DisplayMode());
 	}
-	else if (event->type() == kVideoFrameArrivedEvent)
-	{
-		DeckLinkInputFrameArrivedEvent* frameArrivedEvent = dynamic_cast<DeckLinkInputFrameArrivedEvent*>(event);
-		ui->invalidSignalLabel->setVisible(!frameArrivedEvent->SignalValid());
-		m_ancillaryDataTable->UpdateFrameData(frameArrivedEvent->AncillaryData(), frameArrivedEvent->Metadata());
-		delete frameArrivedEvent->AncillaryData();
-		delete frameArrivedEvent->Metadata();
-	}
 	else if (event->type() == kProfileActivatedEvent)
 	{
 		ProfileActivatedEvent* profileEvent = dynamic_cast<ProfileActivatedEvent*>(event);
@@ -161,6 +161,21 @@ void CapturePreview::closeEvent(QCloseEvent *)
 	m_deckLinkDiscovery->disable();
 }
 
+void CapturePreview::setUIRefreshRate(int refreshRate)
+{
+	m_uiRefreshTimer->setInterval(1000 / std::max(refreshRate, 1));
+}
+
+void CapturePreview::refreshFrameMetadata()
+{
+	// Only the latest frame's metadata is formatted, however many frames have arrived since the previous refresh
+	if (!m_selectedDevice || !m_selectedDevice->getLatestFrameMetadata(m_frameMetadata))
+		return;
+
+	ui->invalidSignalLabel->setVisible(!m_frameMetadata.signalValid);
+	m_ancillaryDataTable->UpdateFrameData(m_frameMetadata);
+}
+
 void CapturePreview::toggleStart()
 {
 	if (!m_selectedDevice)
@@ -186,6 +201,7 @@ void CapturePreview::startCapture()
 		// Update UI
 		ui->startButton->setText("Stop");
 		enableInterface(false);
+		m_uiRefreshTimer->start();
 	}
 }
 
@@ -195,6 +211,7 @@ void CapturePreview::stopCapture()
 		m_selectedDevice->stopCapture();
 
 	// Update UI
+	m_uiRefreshTimer->stop();
 	ui->invalidSignalLabel->setVisible(false);
 	ui->startButton->setText("Start");
 	enableInterface(true);
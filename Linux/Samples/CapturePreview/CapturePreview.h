@@ -42,6 +42,7 @@
 
 #include <QEvent>
 #include <QMainWindow>
+#include <QTimer>
 #include <QWidget>
 
 #include "DeckLinkInputDevice.h"
@@ -65,6 +66,7 @@ public:
 
 	void setup();
 	void enableInterface(bool);
+	void setUIRefreshRate(int refreshRate);
 
 	void startCapture();
 	void stopCapture();
@@ -86,6 +88,8 @@ private:
 	DeckLinkOpenGLWidget*				m_previewView;
 	com_ptr<ProfileCallback>			m_profileCallback;
 	AncillaryDataTable*					m_ancillaryDataTable;
+	QTimer*								m_uiRefreshTimer;
+	FrameMetadata						m_frameMetadata;
 	BMDVideoConnection					m_selectedInputConnection;
 
 	std::map<intptr_t, com_ptr<DeckLinkInputDevice>>		m_inputDevices;
@@ -94,4 +98,5 @@ public slots:
 	void inputDeviceChanged(int selectedDeviceIndex);
 	void inputConnectionChanged(int selectedConnectionIndex);
 	void toggleStart();
+	void refreshFrameMetadata();
 };
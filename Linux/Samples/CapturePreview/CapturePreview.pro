@@ -43,6 +43,7 @@ HEADERS += \
 	DeckLinkInputDevice.h \
 	DeckLinkOpenGLWidget.h \
 	AncillaryDataTable.h \
+	LatestValueSlot.h \
     ProfileCallback.h
 
 FORMS += \
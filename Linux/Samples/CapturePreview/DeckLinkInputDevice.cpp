@@ -294,171 +294,62 @@ HRESULT DeckLinkInputDevice::VideoInputFormatChanged (BMDVideoInputFormatChanged
 
 HRESULT DeckLinkInputDevice::VideoInputFrameArrived (IDeckLinkVideoInputFrame* videoFrame, IDeckLinkAudioInputPacket* /* audioPacket */)
 {
-	bool					validFrame;
-	AncillaryDataStruct*	ancillaryData;
-	MetadataStruct*			metadata;
-
 	if (videoFrame == nullptr)
 		return S_OK;
 
-	validFrame = (videoFrame->GetFlags() & bmdFrameHasNoInputSource) == 0;
+	// Capture the binary timecodes and metadata into the latest value slot, it is formatted for display when the UI refreshes
+	FrameMetadata& frameMetadata = m_frameMetadata.beginWrite();
 
-	// Get the various timecodes and userbits attached to this frame
-	ancillaryData = new AncillaryDataStruct();
-	GetAncillaryDataFromFrame(videoFrame, bmdTimecodeVITC,					&ancillaryData->vitcF1Timecode,		&ancillaryData->vitcF1UserBits);
-	GetAncillaryDataFromFrame(videoFrame, bmdTimecodeVITCField2,			&ancillaryData->vitcF2Timecode,		&ancillaryData->vitcF2UserBits);
-	GetAncillaryDataFromFrame(videoFrame, bmdTimecodeRP188VITC1,			&ancillaryData->rp188vitc1Timecode,	&ancillaryData->rp188vitc1UserBits);
-	GetAncillaryDataFromFrame(videoFrame, bmdTimecodeRP188VITC2,			&ancillaryData->rp188vitc2Timecode,	&ancillaryData->rp188vitc2UserBits);
-	GetAncillaryDataFromFrame(videoFrame, bmdTimecodeRP188LTC,				&ancillaryData->rp188ltcTimecode,	&ancillaryData->rp188ltcUserBits);
-	GetAncillaryDataFromFrame(videoFrame, bmdTimecodeRP188HighFrameRate,	&ancillaryData->rp188hfrtcTimecode,	&ancillaryData->rp188hfrtcUserBits);
+	frameMetadata.signalValid = (videoFrame->GetFlags() & bmdFrameHasNoInputSource) == 0;
 
-	metadata = new MetadataStruct();
-	GetMetadataFromFrame(videoFrame, metadata);
+	for (int i = 0; i < kAncillaryTimecodeCount; i++)
+		GetTimecodeFromFrame(videoFrame, kAncillaryTimecodeFormats[i], &frameMetadata.timecodes[i]);
 
-	// Update the UI with new Ancillary data
-	if (m_owner != nullptr)
-		QCoreApplication::postEvent(m_owner, new DeckLinkInputFrameArrivedEvent(ancillaryData, metadata, validFrame));
-	else
-	{
-		delete ancillaryData;
-		delete metadata;
-	}
+	GetMetadataFromFrame(videoFrame, &frameMetadata);
+
+	m_frameMetadata.endWrite();
 
 	return S_OK;
 }
 
-void DeckLinkInputDevice::GetAncillaryDataFromFrame(IDeckLinkVideoInputFrame* videoFrame, BMDTimecodeFormat timecodeFormat, QString* timecodeString, QString* userBitsString)
+void DeckLinkInputDevice::GetTimecodeFromFrame(IDeckLinkVideoInputFrame* videoFrame, BMDTimecodeFormat timecodeFormat, TimecodeData* timecodeData)
 {
 	com_ptr<IDeckLinkTimecode>		timecode;
-	const char*						timecodeStr;
-	BMDTimecodeUserBits				userBits	= 0;
 
-	if ((videoFrame != nullptr) && (timecodeString != nullptr) && (userBitsString != nullptr)
-		&& (videoFrame->GetTimecode(timecodeFormat, timecode.releaseAndGetAddressOf()) == S_OK))
-	{
-		if (timecode->GetString(&timecodeStr) == S_OK)
-		{
-			*timecodeString = timecodeStr;
-			free((void*)timecodeStr);
-		}
-		else
-		{
-			*timecodeString = "";
-		}
+	timecodeData->valid = (videoFrame->GetTimecode(timecodeFormat, timecode.releaseAndGetAddressOf()) == S_OK) &&
+		(timecode->GetComponents(&timecodeData->hours, &timecodeData->minutes, &timecodeData->seconds, &timecodeData->frames) == S_OK);
 
-		timecode->GetTimecodeUserBits(&userBits);
-		*userBitsString = QString("0x%1").arg(userBits, 8, 16, QChar('0'));
-	}
-	else
+	if (timecodeData->valid)
 	{
-		*timecodeString = "";
-		*userBitsString = "";
+		timecodeData->flags = timecode->GetFlags();
+		if (timecode->GetTimecodeUserBits(&timecodeData->userBits) != S_OK)
+			timecodeData->userBits = 0;
 	}
 }
 
-void DeckLinkInputDevice::GetMetadataFromFrame(IDeckLinkVideoInputFrame* videoFrame, MetadataStruct* metadata)
+void DeckLinkInputDevice::GetMetadataFromFrame(IDeckLinkVideoInputFrame* videoFrame, FrameMetadata* frameMetadata)
 {
 	com_ptr<IDeckLinkVideoFrameMetadataExtensions> metadataExtensions(IID_IDeckLinkVideoFrameMetadataExtensions, com_ptr<IDeckLinkVideoInputFrame>(videoFrame));
 
-	metadata->electroOpticalTransferFunction = "";
-	metadata->displayPrimariesRedX = "";
-	metadata->displayPrimariesRedY = "";
-	metadata->displayPrimariesGreenX = "";
-	metadata->displayPrimariesGreenY = "";
-	metadata->displayPrimariesBlueX = "";
-	metadata->displayPrimariesBlueY = "";
-	metadata->whitePointX = "";
-	metadata->whitePointY = "";
-	metadata->maxDisplayMasteringLuminance = "";
-	metadata->minDisplayMasteringLuminance = "";
-	metadata->maximumContentLightLevel = "";
-	metadata->maximumFrameAverageLightLevel = "";
-	metadata->colorspace = "";
+	frameMetadata->hasElectroOpticalTransferFunction = false;
+	frameMetadata->hdrFloatValidMask = 0;
+	frameMetadata->hasColorspace = false;
 
 	if (metadataExtensions)
 	{
-		double doubleValue = 0.0;
-		int64_t intValue = 0;
-
-		if (metadataExtensions->GetInt(bmdDeckLinkFrameMetadataHDRElectroOpticalTransferFunc, &intValue) == S_OK)
-		{
-			switch (intValue)
-			{
-			case 0:
-				metadata->electroOpticalTransferFunction = "SDR";
-				break;
-			case 1:
-				metadata->electroOpticalTransferFunction = "HDR";
-				break;
-			case 2:
-				metadata->electroOpticalTransferFunction = "PQ (ST2084)";
-				break;
-			case 3:
-				metadata->electroOpticalTransferFunction = "HLG";
-				break;
-			default:
-				metadata->electroOpticalTransferFunction = QString("Unknown EOTF: %1").arg((int32_t)intValue);
-				break;
-			}
-		}
+		frameMetadata->hasElectroOpticalTransferFunction =
+			(metadataExtensions->GetInt(bmdDeckLinkFrameMetadataHDRElectroOpticalTransferFunc, &frameMetadata->electroOpticalTransferFunction) == S_OK);
 
 		if (videoFrame->GetFlags() & bmdFrameContainsHDRMetadata)
 		{
-			if (metadataExtensions->GetFloat(bmdDeckLinkFrameMetadataHDRDisplayPrimariesRedX, &doubleValue) == S_OK)
-				metadata->displayPrimariesRedX = QString::number(doubleValue, 'f', 4);
-
-			if (metadataExtensions->GetFloat(bmdDeckLinkFrameMetadataHDRDisplayPrimariesRedY, &doubleValue) == S_OK)
-				metadata->displayPrimariesRedY = QString::number(doubleValue, 'f', 4);
-
-			if (metadataExtensions->GetFloat(bmdDeckLinkFrameMetadataHDRDisplayPrimariesGreenX, &doubleValue) == S_OK)
-				metadata->displayPrimariesGreenX = QString::number(doubleValue, 'f', 4);
-
-			if (metadataExtensions->GetFloat(bmdDeckLinkFrameMetadataHDRDisplayPrimariesGreenY, &doubleValue) == S_OK)
-				metadata->displayPrimariesGreenY = QString::number(doubleValue, 'f', 4);
-
-			if (metadataExtensions->GetFloat(bmdDeckLinkFrameMetadataHDRDisplayPrimariesBlueX, &doubleValue) == S_OK)
-				metadata->displayPrimariesBlueX = QString::number(doubleValue, 'f', 4);
-
-			if (metadataExtensions->GetFloat(bmdDeckLinkFrameMetadataHDRDisplayPrimariesBlueY, &doubleValue) == S_OK)
-				metadata->displayPrimariesBlueY = QString::number(doubleValue, 'f', 4);
-
-			if (metadataExtensions->GetFloat(bmdDeckLinkFrameMetadataHDRWhitePointX, &doubleValue) == S_OK)
-				metadata->whitePointX = QString::number(doubleValue, 'f', 4);
-
-			if (metadataExtensions->GetFloat(bmdDeckLinkFrameMetadataHDRWhitePointY, &doubleValue) == S_OK)
-				metadata->whitePointY = QString::number(doubleValue, 'f', 4);
-
-			if (metadataExtensions->GetFloat(bmdDeckLinkFrameMetadataHDRMaxDisplayMasteringLuminance, &doubleValue) == S_OK)
-				metadata->maxDisplayMasteringLuminance = QString::number(doubleValue, 'f', 4);
-
-			if (metadataExtensions->GetFloat(bmdDeckLinkFrameMetadataHDRMinDisplayMasteringLuminance, &doubleValue) == S_OK)
-				metadata->minDisplayMasteringLuminance = QString::number(doubleValue, 'f', 4);
-
-			if (metadataExtensions->GetFloat(bmdDeckLinkFrameMetadataHDRMaximumContentLightLevel, &doubleValue) == S_OK)
-				metadata->maximumContentLightLevel = QString::number(doubleValue, 'f', 4);
-
-			if (metadataExtensions->GetFloat(bmdDeckLinkFrameMetadataHDRMaximumFrameAverageLightLevel, &doubleValue) == S_OK)
-				metadata->maximumFrameAverageLightLevel = QString::number(doubleValue, 'f', 4);
-		}
-
-		if (metadataExtensions->GetInt(bmdDeckLinkFrameMetadataColorspace, &intValue) == S_OK)
-		{
-			switch (intValue)
+			for (int i = 0; i < kHDRMetadataFloatCount; i++)
 			{
-			case bmdColorspaceRec601:
-				metadata->colorspace = "Rec.601";
-				break;
-			case bmdColorspaceRec709:
-				metadata->colorspace = "Rec.709";
-				break;
-			case bmdColorspaceRec2020:
-				metadata->colorspace = "Rec.2020";
-				break;
-			default:
-				metadata->colorspace = QString("Unknown Colorspace: %1").arg((int32_t)intValue);
-				break;
+				if (metadataExtensions->GetFloat(kHDRMetadataFloatIDs[i], &frameMetadata->hdrFloatValues[i]) == S_OK)
+					frameMetadata->hdrFloatValidMask |= (1 << i);
 			}
 		}
+
+		frameMetadata->hasColorspace = (metadataExtensions->GetInt(bmdDeckLinkFrameMetadataColorspace, &frameMetadata->colorspace) == S_OK);
 	}
 }
 
@@ -466,10 +357,3 @@ DeckLinkInputFormatChangedEvent::DeckLinkInputFormatChangedEvent(BMDDisplayMode
 	: QEvent(kVideoFormatChangedEvent), m_displayMode(displayMode)
 {
 }
-
-DeckLinkInputFrameArrivedEvent::DeckLinkInputFrameArrivedEvent(AncillaryDataStruct* ancillaryData, MetadataStruct* metadata, bool signalValid)
-	: QEvent(kVideoFrameArrivedEvent), m_ancillaryData(ancillaryData), m_metadata(metadata), m_signalValid(signalValid)
-{
-}
-
-
@@ -48,6 +48,7 @@
 #include "com_ptr.h"
 #include "CapturePreviewEvents.h"
 #include "AncillaryDataTable.h"
+#include "LatestValueSlot.h"
 
 class DeckLinkInputDevice : public IDeckLinkInputCallback
 {
@@ -68,6 +69,9 @@ public:
 	bool						startCapture(BMDDisplayMode displayMode, IDeckLinkScreenPreviewCallback* screenPreviewCallback, bool applyDetectedInputMode);
 	void						stopCapture(void);
 
+	// Called from the UI thread when it refreshes, returns false if no frame has arrived since the previous call
+	bool						getLatestFrameMetadata(FrameMetadata& frameMetadata) { return m_frameMetadata.read(frameMetadata); }
+
 	com_ptr<IDeckLink>					getDeckLinkInstance() const { return m_deckLink; }
 	com_ptr<IDeckLinkInput>				getDeckLinkInput() const { return m_deckLinkInput; }
 	com_ptr<IDeckLinkConfiguration>		getDeckLinkConfiguration() const { return m_deckLinkConfig; }
@@ -98,8 +102,10 @@ private:
 	bool								m_applyDetectedInputMode;
 	int64_t								m_supportedInputConnections;
 	//
-	static void	GetAncillaryDataFromFrame(IDeckLinkVideoInputFrame* frame, BMDTimecodeFormat format, QString* timecodeString, QString* userBitsString);
-	static void	GetMetadataFromFrame(IDeckLinkVideoInputFrame* videoFrame, MetadataStruct* metadata);
+	LatestValueSlot<FrameMetadata>		m_frameMetadata;
+	//
+	static void	GetTimecodeFromFrame(IDeckLinkVideoInputFrame* videoFrame, BMDTimecodeFormat format, TimecodeData* timecodeData);
+	static void	GetMetadataFromFrame(IDeckLinkVideoInputFrame* videoFrame, FrameMetadata* frameMetadata);
 };
 
 class DeckLinkInputFormatChangedEvent : public QEvent
@@ -113,20 +119,3 @@ public:
 private:
 	BMDDisplayMode m_displayMode;
 };
-
-class DeckLinkInputFrameArrivedEvent : public QEvent
-{
-public:
-	DeckLinkInputFrameArrivedEvent(AncillaryDataStruct* ancillaryData, MetadataStruct* metadata, bool signalValid);
-	virtual ~DeckLinkInputFrameArrivedEvent() {}
-
-	AncillaryDataStruct*	AncillaryData(void) const { return m_ancillaryData; }
-	MetadataStruct*			Metadata(void) const { return m_metadata; }
-	bool					SignalValid(void) const { return m_signalValid; }
-
-private:
-	AncillaryDataStruct*	m_ancillaryData;
-	MetadataStruct*			m_metadata;
-	bool					m_signalValid;
-};
-
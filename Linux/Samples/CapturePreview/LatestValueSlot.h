@@ -0,0 +1,86 @@
+/* -LICENSE-START-
+** Copyright (c) 2019 Blackmagic Design
+**  
+** Permission is hereby granted, free of charge, to any person or organization 
+** obtaining a copy of the software and accompanying documentation (the 
+** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+** and transmit the Software, and to prepare derivative works of the Software, 
+** and to permit third-parties to whom the Software is furnished to do so, in 
+** accordance with:
+** 
+** (1) if the Software is obtained from Blackmagic Design, the End User License 
+** Agreement for the Software Development Kit (“EULA”) available at 
+** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+** 
+** (2) if the Software is obtained from any third party, such licensing terms 
+** as notified by that third party,
+** 
+** and all subject to the following:
+** 
+** (3) the copyright notices in the Software and this entire statement, 
+** including the above license grant, this restriction and the following 
+** disclaimer, must be included in all copies of the Software, in whole or in 
+** part, and all derivative works of the Software, unless such copies or 
+** derivative works are solely in the form of machine-executable object code 
+** generated by a source language processor.
+** 
+** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+** DEALINGS IN THE SOFTWARE.
+** 
+** A copy of the Software is available free of charge at 
+** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+** 
+** -LICENSE-END-
+*/
+
+#pragma once
+
+#include <atomic>
+
+// A LatestValueSlot passes the most recent value from one writer thread to one reader thread without locking or
+// allocating.  Values are triple buffered: the writer fills its own buffer and swaps it with the shared buffer, the
+// reader swaps the shared buffer for its own only when a new value has been written since it last read.  Values
+// written between reads are overwritten, the reader always sees the latest one.
+template <typename T>
+class LatestValueSlot
+{
+public:
+	LatestValueSlot() :
+		m_writeIndex(0),
+		m_sharedIndex(1),
+		m_readIndex(2)
+	{ }
+
+	// Writer thread only
+	T&		beginWrite(void) { return m_buffers[m_writeIndex]; }
+	void	endWrite(void)
+	{
+		// Publish the buffer just written, and take back whichever buffer was shared
+		m_writeIndex = m_sharedIndex.exchange(m_writeIndex | kNewValueFlag, std::memory_order_acq_rel) & kIndexMask;
+	}
+
+	// Reader thread only, returns false if no value has been written since the previous read
+	bool	read(T& value)
+	{
+		if ((m_sharedIndex.load(std::memory_order_relaxed) & kNewValueFlag) == 0)
+			return false;
+
+		m_readIndex = m_sharedIndex.exchange(m_readIndex, std::memory_order_acq_rel) & kIndexMask;
+		value = m_buffers[m_readIndex];
+		return true;
+	}
+
+private:
+	static const unsigned	kIndexMask		= 0x3;
+	static const unsigned	kNewValueFlag	= 0x4;
+
+	T						m_buffers[3];
+	unsigned				m_writeIndex;
+	std::atomic<unsigned>	m_sharedIndex;
+	unsigned				m_readIndex;
+};
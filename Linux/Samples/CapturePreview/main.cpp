@@ -40,11 +40,30 @@
 
 #include "CapturePreview.h"
 #include <QApplication>
+#include <QCommandLineParser>
 
 int main(int argc, char *argv[])
 {
 	QApplication a(argc, argv);
 
+	QCommandLineParser parser;
+	QCommandLineOption refreshRateOption(QStringList() << "r" << "refresh-rate", "Refresh the ancillary data table <rate> times per second (default 10).", "rate");
+	parser.addHelpOption();
+	parser.addOption(refreshRateOption);
+	parser.process(a);
+
+	int refreshRate = 0;
+	if (parser.isSet(refreshRateOption))
+	{
+		bool validRate;
+		refreshRate = parser.value(refreshRateOption).toInt(&validRate);
+		if (!validRate || (refreshRate <= 0))
+		{
+			qCritical("Invalid refresh rate: %s", qPrintable(parser.value(refreshRateOption)));
+			return 1;
+		}
+	}
+
 	qRegisterMetaType<com_ptr<IDeckLinkVideoFrame>>("com_ptr<IDeckLinkVideoFrame>");
 
 	QSurfaceFormat format = QSurfaceFormat::defaultFormat();
@@ -55,6 +74,8 @@ int main(int argc, char *argv[])
 	QSurfaceFormat::setDefaultFormat(format);
 
 	CapturePreview w;
+	if (refreshRate > 0)
+		w.setUIRefreshRate(refreshRate);
 	w.show();
 	w.setup();
 
@@ -41,6 +41,7 @@
 //
 
 #include <stdio.h>
+#include <chrono>
 #include <condition_variable>
 #include <mutex>
 #include <queue>
@@ -50,6 +51,7 @@
 
 #include "platform.h"
 #include "Bgra32VideoFrame.h"
+#include "CaptionDecoder.h"
 #include "DeckLinkInputDevice.h"
 #include "DeckLinkAPI.h"
 #include "ImageWriter.h"
@@ -72,8 +74,96 @@ enum {
 	kPixelFormatString
 };
 
+// Convert CEA-708 G0/G1 caption text (ASCII with a music note at 0x7F, then Latin-1) to UTF-8
+static void CaptionTextToUTF8(const uint8_t* text, size_t length, char* utf8, size_t utf8Size)
+{
+	size_t out = 0;
+
+	for (size_t i = 0; i < length; i++)
+	{
+		uint8_t c = text[i];
+		size_t	size = (c == 0x7F) ? 3 : (c >= 0x80) ? 2 : 1;
+
+		if (out + size >= utf8Size)
+			break;
+
+		if (c == 0x7F)
+		{
+			utf8[out++] = (char)0xE2;
+			utf8[out++] = (char)0x99;
+			utf8[out++] = (char)0xAA;
+		}
+		else if (c >= 0x80)
+		{
+			utf8[out++] = (char)(0xC0 | (c >> 6));
+			utf8[out++] = (char)(0x80 | (c & 0x3F));
+		}
+		else
+			utf8[out++] = (char)c;
+	}
+
+	utf8[out] = '\0';
+}
+
+
+// Caption presence and decode time are summarised once a second
+struct CaptionReport
+{
+	unsigned	frameCount;
+	int64_t		decodeTotalNs;
+	int64_t		decodeMaxNs;
+};
+
+static void DecodeCaptions(CaptionDecoder& captionDecoder, IDeckLinkVideoFrame* videoFrame, CaptionReport& report)
+{
+	auto	startTime = std::chrono::steady_clock::now();
+	bool	decoded = captionDecoder.decode(videoFrame);
+	int64_t	decodeNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - startTime).count();
+
+	report.decodeTotalNs += decodeNs;
+	if (decodeNs > report.decodeMaxNs)
+		report.decodeMaxNs = decodeNs;
+
+	for (size_t i = 0; i < captionDecoder.getElementCount(); i++)
+	{
+		const CaptionElement& element = captionDecoder.getElement(i);
+
+		if (element.type == CaptionElement::kText)
+		{
+			char text[256];
+			CaptionTextToUTF8(element.bytes, element.length, text, sizeof(text));
+			fprintf(stderr, "Captions: service %u \"%s\"\n", (unsigned)element.serviceNumber, text);
+		}
+		else
+		{
+			const char* name = CaptionDecoder::getCommandName(element.code);
+			if (name != NULL)
+				fprintf(stderr, "Captions: service %u %s\n", (unsigned)element.serviceNumber, name);
+			else
+				fprintf(stderr, "Captions: service %u command 0x%02x\n", (unsigned)element.serviceNumber, (unsigned)element.code);
+		}
+	}
+
+	double		frameRate = captionDecoder.getFrameRate();
+	unsigned	framesPerSecond = (frameRate > 0.0) ? (unsigned)(frameRate + 0.5) : 30;
+
+	if (++report.frameCount < framesPerSecond)
+		return;
+
+	const CaptionDecoder::Statistics& statistics = captionDecoder.getStatistics();
+
+	fprintf(stderr, "Captions: %s, last caption data %lld frames ago, decode %lld ns average %lld ns max, errors %llu CDP, %llu CDP sequence, %llu DTVCC\n",
+		!decoded ? "no CDP" : captionDecoder.isCaptionServiceActive() ? "service active" : "no active service",
+		(long long)captionDecoder.getFramesSinceCaptionData(),
+		(long long)(report.decodeTotalNs / report.frameCount), (long long)report.decodeMaxNs,
+		(unsigned long long)statistics.invalidCDPs, (unsigned long long)statistics.sequenceErrors,
+		(unsigned long long)(statistics.dtvccPacketErrors + statistics.dtvccSequenceErrors));
+
+	report = CaptionReport();
+}
+
 void CaptureStills(DeckLinkInputDevice* deckLinkInput, const int captureInterval, const int framesToCapture,
-				   const std::string& captureDirectory, const std::string& filenamePrefix)
+				   const std::string& captureDirectory, const std::string& filenamePrefix, const bool decodeCaptions)
 {
 	int							captureFrameCount		= 0;
 	HRESULT						result					= S_OK;
@@ -83,6 +173,9 @@ void CaptureStills(DeckLinkInputDevice* deckLinkInput, const int captureInterval
 	IDeckLinkVideoConversion*	deckLinkFrameConverter	= NULL;
 	IDeckLinkVideoFrame*		bgra32Frame				= NULL;
 
+	CaptionDecoder				captionDecoder;
+	CaptionReport				captionReport			= CaptionReport();
+
 	// Create frame conversion instance
 	result = GetDeckLinkVideoConversion(&deckLinkFrameConverter);
 	if (result != S_OK)
@@ -148,6 +241,10 @@ void CaptureStills(DeckLinkInputDevice* deckLinkInput, const int captureInterval
 			}
 		}
 
+		// Captions are decoded from every frame in turn, not only those captured as stills
+		if (decodeCaptions && (receivedVideoFrame != NULL))
+			DecodeCaptions(captionDecoder, receivedVideoFrame, captionReport);
+
 		if (receivedVideoFrame != NULL)
 		{
 			receivedVideoFrame->Release();
@@ -286,6 +383,7 @@ void DisplayUsage(DeckLinkInputDevice* selectedDeckLinkInput, const std::vector<
 		"    -n <frames>          Number of frames to capture (default is 1)\n"
 		"    -i <interval>        Capture frame interval rate (default is 1 - every frame)\n"
 		"    -f <prefix>          Filename prefix (default is \"image_\")\n"
+		"    -C                   Decode and print CEA-708 captions from the ancillary data of each frame\n"
 		"    <capturedirectory>\n"
 		"\n"
 		"Capture image stills to a specified directory. eg:\n"
@@ -305,6 +403,7 @@ int main(int argc, char* argv[])
 	int							captureInterval			= 1;
 	int							pixelFormatIndex		= 0;
 	bool						enableFormatDetection	= false;
+	bool						decodeCaptions			= false;
 	std::string					filenamePrefix;
 	std::string					captureDirectory;
 
@@ -349,6 +448,9 @@ int main(int argc, char* argv[])
 		else if (strcmp(argv[i], "-f") == 0)
 			filenamePrefix = argv[++i];
 
+		else if (strcmp(argv[i], "-C") == 0)
+			decodeCaptions = true;
+
 		else if ((strcmp(argv[i], "?") == 0) || (strcmp(argv[i], "-h") == 0))
 			displayHelp = true;
 
@@ -542,7 +644,7 @@ int main(int argc, char* argv[])
 
 	// Start thread for capture processing
 	captureStillsThread = std::thread([&]{
-		CaptureStills(selectedDeckLinkInput, captureInterval, framesToCapture, captureDirectory, filenamePrefix);
+		CaptureStills(selectedDeckLinkInput, captureInterval, framesToCapture, captureDirectory, filenamePrefix, decodeCaptions);
 	});
 
 	keyPressThread = std::thread([&]{
@@ -0,0 +1,479 @@
+/* -LICENSE-START-
+ ** Copyright (c) 2016 Blackmagic Design
+ **  
+ ** Permission is hereby granted, free of charge, to any person or organization 
+ ** obtaining a copy of the software and accompanying documentation (the 
+ ** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+ ** and transmit the Software, and to prepare derivative works of the Software, 
+ ** and to permit third-parties to whom the Software is furnished to do so, in 
+ ** accordance with:
+ ** 
+ ** (1) if the Software is obtained from Blackmagic Design, the End User License 
+ ** Agreement for the Software Development Kit (“EULA”) available at 
+ ** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+ ** 
+ ** (2) if the Software is obtained from any third party, such licensing terms 
+ ** as notified by that third party,
+ ** 
+ ** and all subject to the following:
+ ** 
+ ** (3) the copyright notices in the Software and this entire statement, 
+ ** including the above license grant, this restriction and the following 
+ ** disclaimer, must be included in all copies of the Software, in whole or in 
+ ** part, and all derivative works of the Software, unless such copies or 
+ ** derivative works are solely in the form of machine-executable object code 
+ ** generated by a source language processor.
+ ** 
+ ** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ ** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ ** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+ ** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+ ** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+ ** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ ** DEALINGS IN THE SOFTWARE.
+ ** 
+ ** A copy of the Software is available free of charge at 
+ ** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+ ** 
+ ** -LICENSE-END-
+ */
+
+#include "CEA608_Encoder.h"
+#include <algorithm>
+#include <cstring>
+
+namespace CEA608
+{
+
+const uint8_t kStandardCharacters[10][2] =
+{
+	{ 0x2A, 0xE1 }, { 0x5C, 0xE9 }, { 0x5E, 0xED }, { 0x5F, 0xF3 }, { 0x60, 0xFA },
+	{ 0x7B, 0xE7 }, { 0x7C, 0xF7 }, { 0x7D, 0xD1 }, { 0x7E, 0xF1 }, { 0x7F, 0x20 }
+};
+
+const uint8_t kSpecialCharacters[16] =
+{
+	0xAE, 0xB0, 0xBD, 0xBF, 0x00, 0xA2, 0xA3, 0x7F, 0xE0, 0x20, 0xE8, 0xE2, 0xEA, 0xEE, 0xF4, 0xFB
+};
+
+const uint8_t kExtendedCharacters[2][32] =
+{
+	{
+		0xC1, 0xC9, 0xD3, 0xDA, 0xDC, 0xFC, 0x27, 0xA1, 0x2A, 0x27, 0x2D, 0xA9, 0x00, 0xB7, 0x22, 0x22,
+		0xC0, 0xC2, 0xC7, 0xC8, 0xCA, 0xCB, 0xEB, 0xCE, 0xCF, 0xEF, 0xD4, 0xD9, 0xF9, 0xDB, 0xAB, 0xBB
+	},
+	{
+		0xC3, 0xE3, 0xCD, 0xCC, 0xEC, 0xD2, 0xF2, 0xD5, 0xF5, 0x7B, 0x7D, 0x5C, 0x5E, 0x5F, 0x7C, 0x7E,
+		0xC4, 0xE4, 0xD6, 0xF6, 0xDF, 0xA5, 0xA4, 0xA6, 0xC5, 0xE5, 0xD8, 0xF8, 0x2B, 0x2B, 0x2B, 0x2B
+	}
+};
+
+const uint8_t kPreambleRows[8][2] =
+{
+	{ 11, 11 }, { 1, 2 }, { 3, 4 }, { 12, 13 }, { 14, 15 }, { 5, 6 }, { 7, 8 }, { 9, 10 }
+};
+
+namespace
+{
+
+enum CharacterType
+{
+	characterType_Standard = 0,
+	characterType_Special,
+	characterType_Extended
+};
+
+struct CharacterCode
+{
+	uint8_t		type;
+	uint8_t		byte1;			// Standard character, or the first byte of a special or extended character
+	uint8_t		byte2;
+	uint8_t		fallback;		// Standard character sent before an extended character, for decoders without it
+};
+
+/* CEA-708 G0/G1 code to CEA-608 character, built once from the decoding tables.
+ * Standard characters are preferred, then special, then extended characters.  Characters with no 608
+ * equivalent are sent as a space. */
+class CharacterMap
+{
+public:
+	CharacterMap()
+	{
+		// Latin-1 letters without their accents, used as the fallback of extended characters
+		static const char kUnaccented[] = "AAAAAAACEEEEIIIIDNOOOOOxOUUUUYPsaaaaaaaceeeeiiiidnooooo/ouuuuypy";
+		
+		for (unsigned c = 0; c < 256; ++c)
+			m_codes[c] = { characterType_Standard, ' ', 0, 0 };
+		
+		bool mapped[256] = { false };
+		mapped[0] = true;
+		
+		for (unsigned c = 0x20; c < 0x7F; ++c)
+		{
+			m_codes[c].byte1 = c;
+			mapped[c] = true;
+		}
+		
+		for (const auto& mapping : kStandardCharacters)
+			mapped[mapping[0]] = false;
+		
+		for (const auto& mapping : kStandardCharacters)
+		{
+			if (!mapped[mapping[1]])
+			{
+				m_codes[mapping[1]] = { characterType_Standard, mapping[0], 0, 0 };
+				mapped[mapping[1]] = true;
+			}
+		}
+		
+		for (unsigned i = 0; i < 16; ++i)
+		{
+			uint8_t c = kSpecialCharacters[i];
+			if (!mapped[c])
+			{
+				m_codes[c] = { characterType_Special, 0x11, static_cast<uint8_t>(0x30 + i), 0 };
+				mapped[c] = true;
+			}
+		}
+		
+		for (unsigned table = 0; table < 2; ++table)
+		{
+			for (unsigned i = 0; i < 32; ++i)
+			{
+				uint8_t c = kExtendedCharacters[table][i];
+				if (!mapped[c])
+				{
+					uint8_t fallback = (c >= 0xC0) ? kUnaccented[c - 0xC0] : ' ';
+					m_codes[c] = { characterType_Extended, static_cast<uint8_t>(0x12 + table), static_cast<uint8_t>(0x20 + i), fallback };
+					mapped[c] = true;
+				}
+			}
+		}
+	}
+	
+	const CharacterCode& operator[](uint8_t c) const
+	{
+		return m_codes[c];
+	}
+	
+private:
+	CharacterCode	m_codes[256];
+};
+
+const CharacterMap& characterMap()
+{
+	static const CharacterMap map;
+	return map;
+}
+
+// Bytes are 7 bits with odd parity in bit 7
+inline uint8_t withParity(uint8_t byte)
+{
+	byte &= 0x7F;
+	uint8_t bits = byte;
+	bits ^= bits >> 4;
+	bits ^= bits >> 2;
+	bits ^= bits >> 1;
+	return (bits & 1) ? byte : (byte | 0x80);
+}
+
+inline Field channelField(Channel channel)
+{
+	return (channel == channel_CC3 || channel == channel_CC4) ? field_2 : field_1;
+}
+
+// Second data channel of a field (CC2, CC4) sets bit 3 of the first byte of its codes
+inline uint8_t channelBit(Channel channel)
+{
+	return (channel == channel_CC2 || channel == channel_CC4) ? 0x08 : 0x00;
+}
+
+}
+
+//=====================================================================
+
+BytePairQueue::BytePairQueue()
+: m_head(0), m_count(0), m_droppedCount(0)
+{
+}
+
+bool BytePairQueue::empty() const
+{
+	return m_count == 0;
+}
+
+std::size_t BytePairQueue::size() const
+{
+	return m_count;
+}
+
+uint64_t BytePairQueue::droppedCount() const
+{
+	return m_droppedCount;
+}
+
+bool BytePairQueue::push(const uint8_t (*pairs)[2], std::size_t pairCount)
+{
+	if (pairCount > kCapacity - m_count)
+	{
+		++m_droppedCount;
+		return false;
+	}
+	
+	for (std::size_t i = 0; i < pairCount; ++i)
+	{
+		uint8_t* pair = m_pairs[(m_head + m_count + i) % kCapacity];
+		pair[0] = pairs[i][0];
+		pair[1] = pairs[i][1];
+	}
+	m_count += pairCount;
+	return true;
+}
+
+bool BytePairQueue::pop(uint8_t pair[2])
+{
+	if (m_count == 0)
+		return false;
+	
+	pair[0] = m_pairs[m_head][0];
+	pair[1] = m_pairs[m_head][1];
+	m_head = (m_head + 1) % kCapacity;
+	--m_count;
+	return true;
+}
+
+//=====================================================================
+
+Encoder::Encoder()
+: m_unitPairs(0), m_unitOverflow(false), m_pendingCharacter(0)
+{
+	characterMap();
+}
+
+void Encoder::beginUnit()
+{
+	m_unitPairs = 0;
+	m_unitOverflow = false;
+	m_pendingCharacter = 0;
+}
+
+bool Encoder::commitUnit(Field field)
+{
+	flushCharacters();
+	
+	if (m_unitOverflow)
+		return false;
+	
+	return m_queues[field].push(m_unit, m_unitPairs);
+}
+
+void Encoder::appendPair(uint8_t byte1, uint8_t byte2)
+{
+	if (m_unitPairs == kMaximumUnitPairs)
+	{
+		m_unitOverflow = true;
+		return;
+	}
+	
+	m_unit[m_unitPairs][0] = withParity(byte1);
+	m_unit[m_unitPairs][1] = withParity(byte2);
+	++m_unitPairs;
+}
+
+void Encoder::appendControl(uint8_t byte1, uint8_t byte2)
+{
+	// Control codes start on a pair boundary and are sent twice
+	flushCharacters();
+	appendPair(byte1, byte2);
+	appendPair(byte1, byte2);
+}
+
+void Encoder::appendStandardCharacter(uint8_t character)
+{
+	if (m_pendingCharacter == 0)
+	{
+		m_pendingCharacter = character;
+		return;
+	}
+	
+	appendPair(m_pendingCharacter, character);
+	m_pendingCharacter = 0;
+}
+
+void Encoder::flushCharacters()
+{
+	if (m_pendingCharacter == 0)
+		return;
+	
+	appendPair(m_pendingCharacter, 0);
+	m_pendingCharacter = 0;
+}
+
+void Encoder::appendControlCode(Channel channel, ControlCode code)
+{
+	// Field 2 miscellaneous control codes set bit 0 of the first byte
+	uint8_t byte1 = 0x14 | channelBit(channel) | (channelField(channel) == field_2 ? 0x01 : 0x00);
+	appendControl(byte1, code);
+}
+
+void Encoder::appendPreambleAddress(Channel channel, uint8_t row, uint8_t column)
+{
+	row = std::min<uint8_t>(std::max<uint8_t>(row, 1), kRows);
+	column = std::min<uint8_t>(column, kColumns - 1);
+	
+	for (uint8_t code = 0; code < 8; ++code)
+	{
+		for (uint8_t half = 0; half < 2; ++half)
+		{
+			if (kPreambleRows[code][half] != row)
+				continue;
+			
+			// White, indented to the column rounded down to a multiple of 4, then a tab offset for the rest
+			appendControl(0x10 | channelBit(channel) | code, 0x40 | (half << 5) | 0x10 | ((column / 4) << 1));
+			if (column % 4 != 0)
+				appendControl(0x17 | channelBit(channel), 0x20 | (column % 4));
+			return;
+		}
+	}
+}
+
+void Encoder::appendText(Channel channel, const uint8_t* text, uint8_t length)
+{
+	const CharacterMap& map = characterMap();
+	
+	length = std::min<uint8_t>(length, kColumns);
+	for (uint8_t i = 0; i < length; ++i)
+	{
+		const CharacterCode& code = map[text[i]];
+		switch (code.type)
+		{
+			case characterType_Standard:
+				appendStandardCharacter(code.byte1);
+				break;
+				
+			case characterType_Special:
+				appendControl(code.byte1 | channelBit(channel), code.byte2);
+				break;
+				
+			case characterType_Extended:
+				// Extended characters replace the standard character before them
+				appendStandardCharacter(code.fallback);
+				appendControl(code.byte1 | channelBit(channel), code.byte2);
+				break;
+		}
+	}
+}
+
+bool Encoder::control(Channel channel, ControlCode code)
+{
+	beginUnit();
+	appendControlCode(channel, code);
+	return commitUnit(channelField(channel));
+}
+
+bool Encoder::preambleAddress(Channel channel, uint8_t row, uint8_t column)
+{
+	beginUnit();
+	appendPreambleAddress(channel, row, column);
+	return commitUnit(channelField(channel));
+}
+
+bool Encoder::text(Channel channel, const uint8_t* text, uint8_t length)
+{
+	beginUnit();
+	appendText(channel, text, length);
+	return commitUnit(channelField(channel));
+}
+
+bool Encoder::loadPopOn(Channel channel, const uint8_t* const lines[], const uint8_t lengths[], uint8_t lineCount)
+{
+	lineCount = std::min<uint8_t>(lineCount, kMaximumPopOnRows);
+	
+	beginUnit();
+	appendControlCode(channel, control_ResumeCaptionLoading);
+	appendControlCode(channel, control_EraseNonDisplayedMemory);
+	
+	for (uint8_t line = 0; line < lineCount; ++line)
+	{
+		uint8_t length = std::min<uint8_t>(lengths[line], kColumns);
+		appendPreambleAddress(channel, kRows - lineCount + 1 + line, (kColumns - length) / 2);
+		appendText(channel, lines[line], length);
+	}
+	
+	return commitUnit(channelField(channel));
+}
+
+bool Encoder::rollUp(Channel channel, uint8_t rows, const uint8_t* text, uint8_t length)
+{
+	static const ControlCode kRollUpCodes[] = { control_RollUp2, control_RollUp3, control_RollUp4 };
+	
+	rows = std::min<uint8_t>(std::max<uint8_t>(rows, 2), 4);
+	
+	beginUnit();
+	appendControlCode(channel, kRollUpCodes[rows - 2]);
+	appendControlCode(channel, control_CarriageReturn);
+	appendPreambleAddress(channel, kRows, 0);
+	appendText(channel, text, length);
+	return commitUnit(channelField(channel));
+}
+
+bool Encoder::paintOn(Channel channel, uint8_t row, uint8_t column, const uint8_t* text, uint8_t length)
+{
+	beginUnit();
+	appendControlCode(channel, control_ResumeDirectCaptioning);
+	appendPreambleAddress(channel, row, column);
+	appendText(channel, text, length);
+	return commitUnit(channelField(channel));
+}
+
+bool Encoder::xds(XDSClass xdsClass, uint8_t type, const uint8_t* data, uint8_t length)
+{
+	static const uint8_t kXDSEnd = 0x0F;
+	
+	// 9.5.2 Informational characters are ASCII, the checksum makes the 7-bit sum of the packet zero
+	length = std::min<uint8_t>(length, 32);
+	unsigned sum = xdsClass + type + kXDSEnd;
+	
+	beginUnit();
+	appendPair(xdsClass, type);
+	for (uint8_t i = 0; i < length; i += 2)
+	{
+		uint8_t byte1 = (data[i] >= 0x20 && data[i] < 0x7F) ? data[i] : ' ';
+		uint8_t byte2 = 0;
+		if (i + 1 < length)
+			byte2 = (data[i + 1] >= 0x20 && data[i + 1] < 0x7F) ? data[i + 1] : ' ';
+		
+		appendPair(byte1, byte2);
+		sum += byte1 + byte2;
+	}
+	appendPair(kXDSEnd, (128 - sum % 128) % 128);
+	
+	return commitUnit(field_2);
+}
+
+bool Encoder::empty(Field field) const
+{
+	return m_queues[field].empty();
+}
+
+std::size_t Encoder::pending(Field field) const
+{
+	return m_queues[field].size();
+}
+
+uint64_t Encoder::droppedCount() const
+{
+	return m_queues[field_1].droppedCount() + m_queues[field_2].droppedCount();
+}
+
+bool Encoder::pop(Field field, uint8_t pair[2])
+{
+	if (m_queues[field].pop(pair))
+		return true;
+	
+	pair[0] = withParity(0);
+	pair[1] = withParity(0);
+	return false;
+}
+
+}
@@ -0,0 +1,219 @@
+/* -LICENSE-START-
+ ** Copyright (c) 2016 Blackmagic Design
+ **  
+ ** Permission is hereby granted, free of charge, to any person or organization 
+ ** obtaining a copy of the software and accompanying documentation (the 
+ ** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+ ** and transmit the Software, and to prepare derivative works of the Software, 
+ ** and to permit third-parties to whom the Software is furnished to do so, in 
+ ** accordance with:
+ ** 
+ ** (1) if the Software is obtained from Blackmagic Design, the End User License 
+ ** Agreement for the Software Development Kit (“EULA”) available at 
+ ** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+ ** 
+ ** (2) if the Software is obtained from any third party, such licensing terms 
+ ** as notified by that third party,
+ ** 
+ ** and all subject to the following:
+ ** 
+ ** (3) the copyright notices in the Software and this entire statement, 
+ ** including the above license grant, this restriction and the following 
+ ** disclaimer, must be included in all copies of the Software, in whole or in 
+ ** part, and all derivative works of the Software, unless such copies or 
+ ** derivative works are solely in the form of machine-executable object code 
+ ** generated by a source language processor.
+ ** 
+ ** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ ** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ ** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+ ** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+ ** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+ ** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ ** DEALINGS IN THE SOFTWARE.
+ ** 
+ ** A copy of the Software is available free of charge at 
+ ** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+ ** 
+ ** -LICENSE-END-
+ */
+
+#ifndef __CEA608_ENCODER_H__
+#define __CEA608_ENCODER_H__
+#include <cstddef>
+#include <stdint.h>
+
+namespace CEA608
+{
+
+/* CEA-608 (line 21) captions, carried in the 608 cc_data triplets of a CDP alongside CEA-708 for legacy decoders.
+ *
+ * Briefly:
+ * - each field carries one byte pair per NTSC frame, each byte is 7 bits with odd parity
+ * - field 1 carries caption channels CC1 and CC2, field 2 carries CC3, CC4 and XDS
+ * - control codes are sent twice so that a decoder can ignore a corrupt repeat
+ * References below refer to CEA-608-E.
+ */
+
+enum Channel
+{
+	channel_CC1 = 0,
+	channel_CC2,
+	channel_CC3,
+	channel_CC4
+};
+
+enum Field
+{
+	field_1 = 0,
+	field_2
+};
+
+// Table 51 Miscellaneous Control Codes, second byte
+enum ControlCode
+{
+	control_ResumeCaptionLoading = 0x20,
+	control_Backspace = 0x21,
+	control_DeleteToEndOfRow = 0x24,
+	control_RollUp2 = 0x25,
+	control_RollUp3 = 0x26,
+	control_RollUp4 = 0x27,
+	control_FlashOn = 0x28,
+	control_ResumeDirectCaptioning = 0x29,
+	control_TextRestart = 0x2A,
+	control_ResumeTextDisplay = 0x2B,
+	control_EraseDisplayedMemory = 0x2C,
+	control_CarriageReturn = 0x2D,
+	control_EraseNonDisplayedMemory = 0x2E,
+	control_EndOfCaption = 0x2F
+};
+
+// 9.5 Extended Data Services, start codes of the current packet classes
+enum XDSClass
+{
+	xdsClass_Current = 0x01,
+	xdsClass_Future = 0x03,
+	xdsClass_Channel = 0x05,
+	xdsClass_Miscellaneous = 0x07,
+	xdsClass_PublicService = 0x09,
+	xdsClass_PrivateData = 0x0D
+};
+
+// XDS packet types used by this sample, the meaning of a type depends on its class
+enum XDSType
+{
+	xdsType_CurrentProgramName = 0x03,		// xdsClass_Current
+	xdsType_ChannelNetworkName = 0x01,		// xdsClass_Channel
+	xdsType_ChannelCallLetters = 0x02		// xdsClass_Channel
+};
+
+/* Characters shared with the SCC decoder, mapped to CEA-708 G0/G1 codes.  0 where there is no equivalent.
+ * Standard characters are { 608 code, 708 code } for the codes that differ from ASCII. */
+extern const uint8_t kStandardCharacters[10][2];
+extern const uint8_t kSpecialCharacters[16];		// 0x11 0x30 to 0x3F
+extern const uint8_t kExtendedCharacters[2][32];	// 0x12 0x20 to 0x3F then 0x13 0x20 to 0x3F
+
+// Preamble address code rows, indexed by the first byte & 7 then bit 5 of the second byte
+extern const uint8_t kPreambleRows[8][2];
+
+
+/* Fixed-capacity ring of byte pairs waiting to be sent in one field.
+ * Units are queued whole or not at all, so a full queue never leaves a partial caption command. */
+class BytePairQueue
+{
+public:
+	enum
+	{
+		kCapacity = 512
+	};
+	
+	BytePairQueue();
+	
+	bool empty() const;
+	std::size_t size() const;
+	
+	// Number of units dropped because the queue was full
+	uint64_t droppedCount() const;
+	
+	bool push(const uint8_t (*pairs)[2], std::size_t pairCount);
+	bool pop(uint8_t pair[2]);
+	
+private:
+	uint8_t			m_pairs[kCapacity][2];
+	std::size_t		m_head;
+	std::size_t		m_count;
+	uint64_t		m_droppedCount;
+};
+
+
+/* Encodes CEA-608 caption commands and XDS packets into byte pairs for each field.
+ * Each call queues one indivisible unit for the field of its channel, and returns false if the unit was dropped
+ * because the field's queue was full.  Caption text is in the CEA-708 G0/G1 code sets, characters that are not in
+ * the 608 character set are replaced by the nearest one. */
+class Encoder
+{
+public:
+	enum
+	{
+		kRows = 15,
+		kColumns = 32,
+		kMaximumPopOnRows = 4,
+		kMaximumUnitPairs = 4 + kMaximumPopOnRows * (4 + kColumns * 5 / 2)	// An extended character takes 2.5 pairs
+	};
+	
+	Encoder();
+	
+	// Table 51 Miscellaneous Control Codes
+	bool control(Channel channel, ControlCode code);
+	
+	// Move the cursor to a row (1 - 15) and column (0 - 31) with a preamble address code and tab offset
+	bool preambleAddress(Channel channel, uint8_t row, uint8_t column);
+	
+	// Write up to one row of text at the cursor
+	bool text(Channel channel, const uint8_t* text, uint8_t length);
+	
+	/* Load a caption of up to 4 rows into non-displayed memory, centered on the bottom rows.
+	 * The caption is shown by a later control_EndOfCaption, and removed by control_EraseDisplayedMemory. */
+	bool loadPopOn(Channel channel, const uint8_t* const lines[], const uint8_t lengths[], uint8_t lineCount);
+	
+	// Scroll a roll-up window of 2 to 4 rows with its base on the bottom row, then write one row of text
+	bool rollUp(Channel channel, uint8_t rows, const uint8_t* text, uint8_t length);
+	
+	// Write text straight to displayed memory at row (1 - 15) and column
+	bool paintOn(Channel channel, uint8_t row, uint8_t column, const uint8_t* text, uint8_t length);
+	
+	// 9.5 Extended Data Services packet of up to 32 characters, sent in field 2
+	bool xds(XDSClass xdsClass, uint8_t type, const uint8_t* data, uint8_t length);
+	
+	bool empty(Field field) const;
+	
+	// Number of byte pairs waiting to be sent in a field
+	std::size_t pending(Field field) const;
+	
+	// Number of units dropped because more were queued than could be sent
+	uint64_t droppedCount() const;
+	
+	// Take the next byte pair for a field.  Returns false, with a pair of NULs, if nothing is waiting.
+	bool pop(Field field, uint8_t pair[2]);
+	
+private:
+	BytePairQueue		m_queues[2];
+	uint8_t				m_unit[kMaximumUnitPairs][2];
+	std::size_t			m_unitPairs;
+	bool				m_unitOverflow;
+	uint8_t				m_pendingCharacter;		// Standard character waiting for the second byte of its pair
+	
+	void beginUnit();
+	bool commitUnit(Field field);
+	void appendPair(uint8_t byte1, uint8_t byte2);
+	void appendControl(uint8_t byte1, uint8_t byte2);
+	void appendStandardCharacter(uint8_t character);
+	void flushCharacters();
+	void appendControlCode(Channel channel, ControlCode code);
+	void appendPreambleAddress(Channel channel, uint8_t row, uint8_t column);
+	void appendText(Channel channel, const uint8_t* text, uint8_t length);
+};
+
+}
+
+#endif
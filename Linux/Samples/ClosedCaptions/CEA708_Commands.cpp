@@ -102,6 +102,14 @@ SyntacticElement DefineWindow(WindowID windowID, Priority priority, Anchor ancho
 	return cmd;
 }
 
+SyntacticElement ClearWindows(uint8_t windowMask)
+{
+	SyntacticElement cmd(2);
+	cmd[0] = 0x88;
+	cmd[1] = windowMask;
+	return cmd;
+}
+
 SyntacticElement DeleteWindows()
 {
 	SyntacticElement cmd(2);
@@ -119,10 +127,23 @@ SyntacticElement DisplayWindows(uint8_t windowMask)
 }
 
 SyntacticElement HideWindows()
+{
+	return HideWindows(0xFF);
+}
+
+SyntacticElement HideWindows(uint8_t windowMask)
 {
 	SyntacticElement cmd(2);
 	cmd[0] = 0x8A;
-	cmd[1] = 0xFF;
+	cmd[1] = windowMask;
+	return cmd;
+}
+
+SyntacticElement ToggleWindows(uint8_t windowMask)
+{
+	SyntacticElement cmd(2);
+	cmd[0] = 0x8B;
+	cmd[1] = windowMask;
 	return cmd;
 }
 
@@ -39,19 +39,28 @@
  */
 
 #include "CEA708_Encoder.h"
+#include <algorithm>
 #include <cstring>
 
 namespace CEA708
 {
 
-// SMPTE 334-2 Table 3 - CDP Frame Rate
-// CEA-708 4.4.1 Captioning Data Semantics
-static uint8_t FrameRateToCDPCCCount(int64_t frameDuration, int64_t timeScale)
+// CEA-708 4.4.1 Captioning Data Semantics, cc_count is 600 cc_data per second (9600bps / 16 bits per cc_data)
+// CEA-708 4.3.6 608 Compatibility Bytes, one 608 byte pair per field at 59.94 Hz in 3:2 cadence for 24 fps
+// Indexed by CDPFrameRate
+static const CCDataBudget kCCDataBudgets[] =
 {
-	static const unsigned kCDPPayloadRate = 600;	// 9600bps / 16 bits per cc_data
-	double cc_count = kCDPPayloadRate / (static_cast<double>(timeScale) / frameDuration);
-	return static_cast<uint8_t>(cc_count);
-}
+	{ cdpFrameRate_Forbidden,	0,	0, 1, { "" } },
+	{ cdpFrameRate_2397,		25,	3, 4, { "121", "21", "212", "12" } },
+	{ cdpFrameRate_24,			25,	3, 4, { "121", "21", "212", "12" } },
+	{ cdpFrameRate_25,			24,	2, 1, { "12" } },
+	{ cdpFrameRate_2997,		20,	2, 1, { "12" } },
+	{ cdpFrameRate_30,			20,	2, 1, { "12" } },
+	{ cdpFrameRate_50,			12,	1, 2, { "1", "2" } },
+	{ cdpFrameRate_5994,		10,	1, 2, { "1", "2" } },
+	{ cdpFrameRate_60,			10,	1, 2, { "1", "2" } }
+};
+
 static CDPFrameRate FrameRateToCDPFrameRate(int64_t frameDuration, int64_t timeScale)
 {
 	double fps = static_cast<double>(timeScale)/frameDuration;
@@ -80,6 +89,58 @@ static CDPFrameRate FrameRateToCDPFrameRate(int64_t frameDuration, int64_t timeS
 
 //=====================================================================
 
+CDPQueue::CDPQueue()
+: m_head(0), m_count(0), m_droppedCount(0)
+{
+}
+
+bool CDPQueue::empty() const
+{
+	return m_count == 0;
+}
+
+std::size_t CDPQueue::size() const
+{
+	return m_count;
+}
+
+uint64_t CDPQueue::droppedCount() const
+{
+	return m_droppedCount;
+}
+
+EncodedCaptionDistributionPacket& CDPQueue::reserve()
+{
+	if (m_count == kCapacity)
+		return m_packets[kCapacity];
+	
+	return m_packets[(m_head + m_count) % kCapacity];
+}
+
+void CDPQueue::commit()
+{
+	if (m_count == kCapacity)
+		++m_droppedCount;
+	else
+		++m_count;
+}
+
+const EncodedCaptionDistributionPacket& CDPQueue::front() const
+{
+	return m_packets[m_head];
+}
+
+void CDPQueue::pop()
+{
+	if (m_count == 0)
+		return;
+	
+	m_head = (m_head + 1) % kCapacity;
+	--m_count;
+}
+
+//=====================================================================
+
 ServiceBlockEncoder::ServiceBlockEncoder(CaptionChannelPacketEncoder& packetEncoder, uint8_t serviceNumber)
 : m_packetEncoder(packetEncoder), m_serviceNumber(serviceNumber)
 {
@@ -164,8 +225,9 @@ void CaptionChannelPacketEncoder::push(const uint8_t* block, uint8_t blockLength
 {
 	/* As service block data and caption packets cannot be fragmented,
 	   the maximum data which can be packed depends on the cc_count of the 
-	   cdp packet into which this caption packet will be encoded. */
-	std::size_t maxDataLength = std::min(m_CDPEncoder.maxPayloadSize(), static_cast<std::size_t>(kMaximumData));
+	   cdp packet into which this caption packet will be encoded.  The payload size is
+	   even, so the header and padding byte always fit alongside the data. */
+	std::size_t maxDataLength = std::min(m_CDPEncoder.maxPayloadSize() - kHeaderSize, static_cast<std::size_t>(kMaximumData));
 	
 	if (blockLength > maxDataLength)
 		return;	// service block cannot be larger than caption channel packet.
@@ -193,10 +255,9 @@ void CaptionChannelPacketEncoder::flush()
 
 //=====================================================================
 
-CaptionDistributionPacketEncoder::CaptionDistributionPacketEncoder(CDPQueue& cdpQueue, int64_t frameDuration, int64_t timeScale)
-: m_cdpQueue(cdpQueue), m_sequence(0), m_CCCount(FrameRateToCDPCCCount(frameDuration, timeScale)), m_frameRate(FrameRateToCDPFrameRate(frameDuration, timeScale))
+CaptionDistributionPacketEncoder::CaptionDistributionPacketEncoder(CDPQueue& cdpQueue, CEA608::Encoder& cea608Encoder, int64_t frameDuration, int64_t timeScale)
+: m_cdpQueue(cdpQueue), m_608Encoder(cea608Encoder), m_sequence(0), m_budget(kCCDataBudgets[FrameRateToCDPFrameRate(frameDuration, timeScale)]), m_cadencePosition(0), m_payloadSize(0)
 {
-
 }
 
 void CaptionDistributionPacketEncoder::encode_ccdata(uint8_t*& buffer)
@@ -211,19 +272,31 @@ void CaptionDistributionPacketEncoder::encode_ccdata(uint8_t*& buffer)
 		cc_type_708_start
 	};
 	
-	unsigned payloadPackets = static_cast<unsigned>(m_payload.size() / 2);
-	unsigned padPackets = m_CCCount - payloadPackets;
-	
-	if (payloadPackets > m_CCCount)
-		return;
+	const char* fields608 = m_budget.cadence[m_cadencePosition];
+	unsigned cc608Packets = static_cast<unsigned>(std::strlen(fields608));
+	unsigned payloadPackets = m_payloadSize / 2;
+	unsigned padPackets = m_budget.ccCount - cc608Packets - payloadPackets;
 	
 	uint8_t* ccdata_header = buffer;
 	ccdata_header[0] = CCDATA_ID;
-	ccdata_header[1] |= 0x7 << 5;		// marker
-	ccdata_header[1] |= m_CCCount & 0x1F;
+	ccdata_header[1] = 0x7 << 5;		// marker
+	ccdata_header[1] |= m_budget.ccCount & 0x1F;
 	buffer += 2;
 	
-	uint8_t* cc_data_x = m_payload.data();
+	// 608 triplets come first, NUL pairs keep legacy decoders locked to the field when there are no captions
+	for (const char* field = fields608; *field != '\0'; ++field)
+	{
+		CEA608::Field cc608Field = (*field == '1') ? CEA608::field_1 : CEA608::field_2;
+		uint8_t* ccdata = buffer;
+		ccdata[0] = 0x1F << 3;			// marker
+		ccdata[0] |= (1 << 2);			// cc_valid
+		ccdata[0] |= (cc608Field == CEA608::field_1) ? cc_type_608_1 : cc_type_608_2;
+		m_608Encoder.pop(cc608Field, ccdata + 1);
+		buffer += 3;
+	}
+	m_cadencePosition = (m_cadencePosition + 1) % m_budget.cadenceLength;
+	
+	const uint8_t* cc_data_x = m_payload;
 	for (unsigned i = 0; i < payloadPackets; ++i)
 	{
 		uint8_t* ccdata = buffer;
@@ -261,7 +334,7 @@ void CaptionDistributionPacketEncoder::encode_svcinfo(uint8_t*& buffer)
 	svcinfo_header[1] = 0x80;			// reserved
 	svcinfo_header[1] |= 1 << 6;		// svc_info_start
 	svcinfo_header[1] |= 1 << 4;		// svc_info_complete
-	svcinfo_header[1] |= 1;				// svc_count
+	svcinfo_header[1] |= 2;				// svc_count
 	buffer += kServiceInfoHeaderLength;
 	
 	// ATSC A/65 Table 6.26
@@ -279,9 +352,20 @@ void CaptionDistributionPacketEncoder::encode_svcinfo(uint8_t*& buffer)
 	svcinfo[5] = 0x7F;					// !easy_reader, 16:9 aspect ratio, 6 reserved bits
 	svcinfo[6] = 0xFF;					// reserved
 	buffer += kServiceDataLength;
+	
+	// 608 service on CC1
+	uint8_t* svcinfo608 = buffer;
+	svcinfo608[0] = 0x80;				// reserved | csn_size == 0, caption_service_number 0
+	svcinfo608[1] = 'e';
+	svcinfo608[2] = 'n';
+	svcinfo608[3] = 'g';
+	svcinfo608[4] = 0x7E;				// !digital_cc, reserved, line21_field == 0
+	svcinfo608[5] = 0x7F;				// !easy_reader, 16:9 aspect ratio, 6 reserved bits
+	svcinfo608[6] = 0xFF;				// reserved
+	buffer += kServiceDataLength;
 }
 
-EncodedCaptionDistributionPacket CaptionDistributionPacketEncoder::encode()
+void CaptionDistributionPacketEncoder::encode()
 {
 	static const uint16_t	CDP_IDENTIFIER = 0x9669;
 	static const uint8_t	CDP_FOOTER_ID = 0x74;
@@ -289,19 +373,20 @@ EncodedCaptionDistributionPacket CaptionDistributionPacketEncoder::encode()
 	enum
 	{
 		kCDPHeaderLength = 7,
-		kServiceInfoLength = 9,
+		kServiceInfoLength = 2 + 2 * 7,
 		kCDPFooterLength = 4
 	};
 	
-	if (m_frameRate == cdpFrameRate_Forbidden)
-		return EncodedCaptionDistributionPacket();
+	if (m_budget.frameRate == cdpFrameRate_Forbidden)
+		return;
 	
-	uint8_t cc_data_length = 2 + 3 * m_CCCount;
+	uint8_t cc_data_length = 2 + 3 * m_budget.ccCount;
 	uint8_t cdp_length = kCDPHeaderLength + cc_data_length + kServiceInfoLength + kCDPFooterLength;
 	
-	EncodedCaptionDistributionPacket encoded;
-	encoded.resize(cdp_length);
-	uint8_t* buffer = encoded.data();
+	// Encode in place into the queue's preallocated slot, every byte is written below
+	EncodedCaptionDistributionPacket& encoded = m_cdpQueue.reserve();
+	encoded.size = cdp_length;
+	uint8_t* buffer = encoded.data;
 	
 	enum cdp_flags
 	{
@@ -318,9 +403,9 @@ EncodedCaptionDistributionPacket CaptionDistributionPacketEncoder::encode()
 	cdp_header[0] = (CDP_IDENTIFIER & 0xFF00) >> 8;
 	cdp_header[1] = (CDP_IDENTIFIER & 0x00FF);
 	cdp_header[2] = cdp_length;
-	cdp_header[3] |= m_frameRate << 4;
+	cdp_header[3] = m_budget.frameRate << 4;
 	cdp_header[3] |= 0x0F;		// reserved
-	cdp_header[4] |= ccdata_present | caption_service_active | svcinfo_present | svc_info_start | svc_info_complete;
+	cdp_header[4] = ccdata_present | caption_service_active | svcinfo_present | svc_info_start | svc_info_complete;
 	cdp_header[4] |= 1 << 0;	// reserved
 	cdp_header[5] = (m_sequence & 0xFF00) >> 8;
 	cdp_header[6] = (m_sequence & 0x00FF);
@@ -335,45 +420,47 @@ EncodedCaptionDistributionPacket CaptionDistributionPacketEncoder::encode()
 	cdp_footer[2] = (m_sequence & 0x00FF);
 	cdp_footer[3] = 0 /* checksum filled below */;
 	
-	for (unsigned i = 0; i < encoded.size()-1; ++i)
-		cdp_footer[3] += encoded[i];
+	for (unsigned i = 0; i < encoded.size-1u; ++i)
+		cdp_footer[3] += encoded.data[i];
 	cdp_footer[3] = cdp_footer[3] ? 256 - cdp_footer[3] : 0;
 	
 	buffer += kCDPFooterLength;
 	
 	++m_sequence;
 	
-	return encoded;
+	m_cdpQueue.commit();
 }
 
 void CaptionDistributionPacketEncoder::reset()
 {
-	m_payload.clear();
+	m_payloadSize = 0;
 }
 
 void CaptionDistributionPacketEncoder::push(const uint8_t* packet, uint8_t packetLength)
 {
-	if (m_payload.size() + packetLength > maxPayloadSize())
+	if (packetLength > maxPayloadSize())
+		return;
+	
+	if (m_payloadSize + packetLength > maxPayloadSize())
 	{
-		EncodedCaptionDistributionPacket packet = encode();
-		m_cdpQueue.push(packet);
+		encode();
 		reset();
 	}
 	
-	m_payload.insert(m_payload.end(), packet, packet + packetLength);
+	std::memcpy(m_payload + m_payloadSize, packet, packetLength);
+	m_payloadSize += packetLength;
 }
 
 void CaptionDistributionPacketEncoder::flush()
 {
-	EncodedCaptionDistributionPacket packet = encode();
-	m_cdpQueue.push(packet);
+	encode();
 	reset();
 }
 
 //=====================================================================
 
 Encoder::Encoder(int64_t frameDuration, int64_t timeScale)
-: m_cdpQueue(), m_cdpEncoder(m_cdpQueue, frameDuration, timeScale), m_packetEncoder(m_cdpEncoder), m_serviceBlockEncoder(m_packetEncoder, serviceNumber_PrimaryCaptionService)
+: m_cdpQueue(), m_608Encoder(), m_cdpEncoder(m_cdpQueue, m_608Encoder, frameDuration, timeScale), m_packetEncoder(m_cdpEncoder), m_serviceBlockEncoder(m_packetEncoder, serviceNumber_PrimaryCaptionService)
 {
 }
 
@@ -396,6 +483,23 @@ Encoder& Encoder::operator<<(const char* captionText)
 	return *this;
 }
 
+CEA608::Encoder& Encoder::cea608()
+{
+	return m_608Encoder;
+}
+
+Encoder& Encoder::push(const uint8_t* unit, uint8_t size)
+{
+	m_serviceBlockEncoder.push(unit, size);
+	return *this;
+}
+
+std::size_t Encoder::frameCapacity() const
+{
+	// One service block, less its header and the caption channel packet header
+	return std::min<std::size_t>(m_cdpEncoder.maxPayloadSize() - 2, 31);
+}
+
 bool Encoder::empty() const
 {
 	return m_cdpQueue.empty();
@@ -405,13 +509,20 @@ bool Encoder::pop(EncodedCaptionDistributionPacket* packet)
 {
 	if (!m_cdpQueue.empty())
 	{
-		*packet = m_cdpQueue.front();
+		const EncodedCaptionDistributionPacket& front = m_cdpQueue.front();
+		std::memcpy(packet->data, front.data, front.size);
+		packet->size = front.size;
 		m_cdpQueue.pop();
 		return true;
 	}
 	return false;
 }
 
+uint64_t Encoder::droppedCount() const
+{
+	return m_cdpQueue.droppedCount();
+}
+
 void Encoder::flush()
 {
 	m_serviceBlockEncoder.flush();
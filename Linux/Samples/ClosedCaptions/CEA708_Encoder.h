@@ -40,10 +40,10 @@
 
 #ifndef __CEA708_ENCODER_H__
 #define __CEA708_ENCODER_H__
-#include <queue>
-#include <vector>
+#include <cstddef>
 #include <stdint.h>
 #include "CEA708_Commands.h"
+#include "CEA608_Encoder.h"
 
 namespace CEA708
 {
@@ -73,8 +73,51 @@ enum CDPFrameRate
 	cdpFrameRate_60				// '0b1000'
 };
 
-typedef std::vector<uint8_t> EncodedCaptionDistributionPacket;
-typedef std::queue<EncodedCaptionDistributionPacket> CDPQueue;
+// An encoded CDP, sized for the largest cc_count (a 5-bit field) so that it never needs to allocate
+struct EncodedCaptionDistributionPacket
+{
+	enum
+	{
+		kMaximumSize = 7 + 2 + 3 * 31 + 2 + 2 * 7 + 4	// header, cc_data section, svcinfo section and footer
+	};
+	
+	uint8_t		data[kMaximumSize];
+	uint8_t		size;
+};
+
+/* Fixed-capacity ring of preallocated CDPs.
+ * CDPs are encoded in place into the slot returned by reserve(), so queueing and popping never allocate.
+ * If the ring is full the CDP is encoded into a scratch slot and dropped. */
+class CDPQueue
+{
+public:
+	enum
+	{
+		kCapacity = 64
+	};
+	
+	CDPQueue();
+	
+	bool empty() const;
+	std::size_t size() const;
+	
+	// Number of CDPs dropped because the ring was full
+	uint64_t droppedCount() const;
+	
+	// Returns the slot to encode the next CDP into, then commit() it to the back of the queue
+	EncodedCaptionDistributionPacket& reserve();
+	void commit();
+	
+	const EncodedCaptionDistributionPacket& front() const;
+	void pop();
+	
+private:
+	EncodedCaptionDistributionPacket	m_packets[kCapacity + 1];	// Last slot is scratch for CDPs dropped when full
+	std::size_t							m_head;
+	std::size_t							m_count;
+	uint64_t							m_droppedCount;
+};
+
 class ServiceBlockEncoder;
 class CaptionChannelPacketEncoder;
 class CaptionDistributionPacketEncoder;
@@ -147,46 +190,77 @@ public:
 };
 
 	
+/* cc_data triplets of each CDP, shared between CEA-608 and CEA-708 for a frame rate.
+ * 608 carries one byte pair per field of 59.94 Hz video, so at frame rates other than 29.97 its triplets follow
+ * a cadence of CDPs (3:2 for 24 fps, alternate fields for 60 fps).  The triplets after the most 608 triplets in
+ * any CDP of the cadence carry 708, so the 708 bandwidth is the same in every CDP. */
+struct CCDataBudget
+{
+	enum
+	{
+		kMaximumCadenceLength = 4
+	};
+	
+	CDPFrameRate	frameRate;
+	uint8_t			ccCount;
+	uint8_t			cc608Count;
+	uint8_t			cadenceLength;
+	const char*		cadence[kMaximumCadenceLength];	// Field of each 608 triplet in a CDP, '1' or '2'
+};
+
 // SMPTE 334-2 5 CDP Detailed Specification
 class CaptionDistributionPacketEncoder
 {
 private:
+	enum
+	{
+		kMaximumCCCount = 31
+	};
+	
 	CDPQueue&				m_cdpQueue;
+	CEA608::Encoder&		m_608Encoder;
 	uint16_t				m_sequence;
-	uint8_t					m_CCCount;
-	CDPFrameRate			m_frameRate;
-	std::vector<uint8_t>	m_payload;
+	const CCDataBudget&		m_budget;
+	uint8_t					m_cadencePosition;
+	uint8_t					m_payload[kMaximumCCCount * 2];
+	uint8_t					m_payloadSize;
 	
 	void encode_ccdata(uint8_t*& buffer);
 	void encode_svcinfo(uint8_t*& buffer);
 	
-	EncodedCaptionDistributionPacket encode();
+	// Encode the CDP into the next slot of the CDPQueue
+	void encode();
 	
 	void reset();
 	
 public:
-	CaptionDistributionPacketEncoder(CDPQueue& cdpQueue, int64_t frameDuration, int64_t timeScale);
+	CaptionDistributionPacketEncoder(CDPQueue& cdpQueue, CEA608::Encoder& cea608Encoder, int64_t frameDuration, int64_t timeScale);
 	
+	// 708 caption channel packet bytes in each CDP
 	inline std::size_t maxPayloadSize() const
 	{
-		return m_CCCount * 2;
+		return (m_budget.ccCount - m_budget.cc608Count) * 2;
 	}
 	
 	/* Add an encoded caption channel packet to the caption distribution packet.
-	 * When full, encodes the cdp and pushes the completed CDP onto the CDPQueue. */
+	 * When full, encodes the cdp and pushes the completed CDP onto the CDPQueue.
+	 * packetLength must be <= maxPayloadSize(). */
 	void push(const uint8_t* packet, uint8_t packetLength);
 	
-	/* Encodes CDP and pushes the completed CDP onto the CDPQueue */
+	/* Encodes CDP and pushes the completed CDP onto the CDPQueue.
+	 * Each CDP takes the next 608 byte pairs for its frame from the CEA608::Encoder. */
 	void flush();
 };
 
 
 /* Helper class which initialises the encoder stack and provides a simple (limited)
- * iostream-like interface to generate closed caption data. */
+ * iostream-like interface to generate closed caption data.
+ * CEA-608 captions for legacy decoders are queued with cea608(), and sent in the same CDPs. */
 class Encoder
 {
 private:
 	CDPQueue							m_cdpQueue;
+	CEA608::Encoder						m_608Encoder;
 	CaptionDistributionPacketEncoder	m_cdpEncoder;
 	CaptionChannelPacketEncoder			m_packetEncoder;
 	ServiceBlockEncoder					m_serviceBlockEncoder;
@@ -198,12 +272,25 @@ public:
 	Encoder& operator<<(const SyntacticElement& command);
 	Encoder& operator<<(const char* captionText);
 	
+	// 608 caption channels and XDS, sent in the cc_data of the CDPs that follow
+	CEA608::Encoder& cea608();
+	
+	// Push one indivisible unit of caption data (a character or a command), size must be <= 31 bytes
+	Encoder& push(const uint8_t* unit, uint8_t size);
+	
+	/* Number of bytes of caption data that are sent in one CDP when pushed between calls to flush().
+	 * Callers that keep to this budget get exactly one CDP from each flush(). */
+	std::size_t frameCapacity() const;
+	
 	// True if there are no fully-encoded packets in the queue.
 	bool empty() const;
 	
-	// Pop an encoded CDP from the queue
+	// Pop an encoded CDP from the queue into packet, which can be the storage of an ancillary packet
 	bool pop(EncodedCaptionDistributionPacket* packet);
 	
+	// Number of CDPs dropped because more were encoded than the queue could hold
+	uint64_t droppedCount() const;
+	
 	// Flush any remaining data through the encoder stack.
 	// If there was no partial data a pad packet is generated.
 	void flush();
@@ -0,0 +1,903 @@
+/* -LICENSE-START-
+ ** Copyright (c) 2016 Blackmagic Design
+ **  
+ ** Permission is hereby granted, free of charge, to any person or organization 
+ ** obtaining a copy of the software and accompanying documentation (the 
+ ** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+ ** and transmit the Software, and to prepare derivative works of the Software, 
+ ** and to permit third-parties to whom the Software is furnished to do so, in 
+ ** accordance with:
+ ** 
+ ** (1) if the Software is obtained from Blackmagic Design, the End User License 
+ ** Agreement for the Software Development Kit (“EULA”) available at 
+ ** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+ ** 
+ ** (2) if the Software is obtained from any third party, such licensing terms 
+ ** as notified by that third party,
+ ** 
+ ** and all subject to the following:
+ ** 
+ ** (3) the copyright notices in the Software and this entire statement, 
+ ** including the above license grant, this restriction and the following 
+ ** disclaimer, must be included in all copies of the Software, in whole or in 
+ ** part, and all derivative works of the Software, unless such copies or 
+ ** derivative works are solely in the form of machine-executable object code 
+ ** generated by a source language processor.
+ ** 
+ ** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ ** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ ** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+ ** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+ ** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+ ** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ ** DEALINGS IN THE SOFTWARE.
+ ** 
+ ** A copy of the Software is available free of charge at 
+ ** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+ ** 
+ ** -LICENSE-END-
+ */
+
+#include "CaptionFileReader.h"
+#include "CEA608_Encoder.h"
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+
+// SCC byte pairs are sent one per 29.97 fps frame
+const int64_t kSCCFrameDuration = CaptionCue::kTimeScale * 1001 / 30000;
+
+uint8_t standardCharacter(uint8_t character)
+{
+	for (const auto& mapping : CEA608::kStandardCharacters)
+	{
+		if (mapping[0] == character)
+			return mapping[1];
+	}
+	return character;
+}
+
+inline bool isDigit(char c)
+{
+	return c >= '0' && c <= '9';
+}
+
+int hexValue(char c)
+{
+	if (c >= '0' && c <= '9')
+		return c - '0';
+	if (c >= 'a' && c <= 'f')
+		return c - 'a' + 10;
+	if (c >= 'A' && c <= 'F')
+		return c - 'A' + 10;
+	return -1;
+}
+
+const char* skipSpace(const char* p)
+{
+	while (*p == ' ' || *p == '\t')
+		++p;
+	return p;
+}
+
+void clearText(CaptionCue& cue)
+{
+	cue.lineCount = 0;
+}
+
+// Start a new line, scrolling the top line out when all lines are in use
+void newLine(CaptionCue& cue)
+{
+	if (cue.lineCount == CaptionCue::kMaximumLines)
+	{
+		std::memmove(cue.lines[0], cue.lines[1], sizeof(cue.lines[0]) * (CaptionCue::kMaximumLines - 1));
+		std::memmove(cue.lineLength, cue.lineLength + 1, CaptionCue::kMaximumLines - 1);
+		--cue.lineCount;
+	}
+	cue.lineLength[cue.lineCount++] = 0;
+}
+
+void appendCharacter(CaptionCue& cue, uint8_t character)
+{
+	if (cue.lineCount == 0)
+		newLine(cue);
+	
+	uint8_t& length = cue.lineLength[cue.lineCount - 1];
+	if (length < CaptionCue::kMaximumColumns)
+		cue.lines[cue.lineCount - 1][length++] = character;
+}
+
+void backspace(CaptionCue& cue)
+{
+	if (cue.lineCount > 0 && cue.lineLength[cue.lineCount - 1] > 0)
+		--cue.lineLength[cue.lineCount - 1];
+}
+
+bool sameText(const CaptionCue& a, const CaptionCue& b)
+{
+	if (a.lineCount != b.lineCount)
+		return false;
+	
+	for (uint8_t line = 0; line < a.lineCount; ++line)
+	{
+		if (a.lineLength[line] != b.lineLength[line] || std::memcmp(a.lines[line], b.lines[line], a.lineLength[line]) != 0)
+			return false;
+	}
+	return true;
+}
+
+// Append a character to timed text, word wrapping at the last space when the line is full.
+// Characters that do not fit in the last line are dropped.
+void appendWrapped(CaptionCue& cue, uint8_t character)
+{
+	if (cue.lineCount == 0)
+		newLine(cue);
+	
+	uint8_t line = cue.lineCount - 1;
+	uint8_t& length = cue.lineLength[line];
+	
+	if (character == ' ' && length == 0)
+		return;
+	
+	if (length < CaptionCue::kMaximumColumns)
+	{
+		cue.lines[line][length++] = character;
+		return;
+	}
+	
+	if (cue.lineCount == CaptionCue::kMaximumLines)
+		return;
+	
+	if (character == ' ')
+	{
+		newLine(cue);
+		return;
+	}
+	
+	// Move the partial word to the next line
+	uint8_t wordStart = length;
+	while (wordStart > 0 && cue.lines[line][wordStart - 1] != ' ')
+		--wordStart;
+	if (wordStart == 0)
+		wordStart = length;
+	
+	newLine(cue);
+	uint8_t wordLength = length - wordStart;
+	std::memcpy(cue.lines[line + 1], cue.lines[line] + wordStart, wordLength);
+	cue.lineLength[line + 1] = wordLength;
+	
+	length = wordStart;
+	while (length > 0 && cue.lines[line][length - 1] == ' ')
+		--length;
+	
+	appendWrapped(cue, character);
+}
+
+// Map a Unicode code point to CEA-708 G0/G1 codes
+void appendCodePoint(CaptionCue& cue, uint32_t codePoint)
+{
+	if (codePoint == '\t')
+		appendWrapped(cue, ' ');
+	else if ((codePoint >= 0x20 && codePoint < 0x7F) || (codePoint >= 0xA0 && codePoint <= 0xFF))
+		appendWrapped(cue, static_cast<uint8_t>(codePoint));
+	else if (codePoint == 0x2018 || codePoint == 0x2019)
+		appendWrapped(cue, '\'');
+	else if (codePoint == 0x201C || codePoint == 0x201D)
+		appendWrapped(cue, '"');
+	else if (codePoint == 0x2013 || codePoint == 0x2014)
+		appendWrapped(cue, '-');
+	else if (codePoint == 0x2026)
+	{
+		for (int i = 0; i < 3; ++i)
+			appendWrapped(cue, '.');
+	}
+	else if (codePoint == 0x266A || codePoint == 0x266B)
+		appendWrapped(cue, 0x7F);
+	else if (codePoint >= 0x100 && codePoint != 0xFEFF && (codePoint < 0x200B || codePoint > 0x200F))
+		appendWrapped(cue, '?');
+}
+
+// Decode one line of SRT or WebVTT cue text, removing markup
+void appendTimedTextLine(CaptionCue& cue, const char* text, bool webVTT)
+{
+	const uint8_t* p = reinterpret_cast<const uint8_t*>(text);
+	
+	if (cue.lineCount > 0 && cue.lineLength[cue.lineCount - 1] > 0)
+	{
+		if (cue.lineCount == CaptionCue::kMaximumLines)
+			return;
+		newLine(cue);
+	}
+	
+	while (*p)
+	{
+		if (*p == '<')
+		{
+			// Tags such as <i>, <c.class> and <00:00:01.000>
+			const uint8_t* end = reinterpret_cast<const uint8_t*>(std::strchr(reinterpret_cast<const char*>(p), '>'));
+			if (end == NULL)
+				break;
+			p = end + 1;
+		}
+		else if (!webVTT && p[0] == '{' && p[1] == '\\')
+		{
+			// SSA style override such as {\an8}
+			const uint8_t* end = reinterpret_cast<const uint8_t*>(std::strchr(reinterpret_cast<const char*>(p), '}'));
+			if (end == NULL)
+				break;
+			p = end + 1;
+		}
+		else if (webVTT && *p == '&')
+		{
+			static const struct { const char* name; uint32_t codePoint; } kEntities[] =
+			{
+				{ "&amp;", '&' }, { "&lt;", '<' }, { "&gt;", '>' }, { "&nbsp;", ' ' }, { "&quot;", '"' },
+				{ "&apos;", '\'' }, { "&lrm;", 0x200E }, { "&rlm;", 0x200F }
+			};
+			
+			bool decoded = false;
+			for (const auto& entity : kEntities)
+			{
+				size_t length = std::strlen(entity.name);
+				if (std::strncmp(reinterpret_cast<const char*>(p), entity.name, length) == 0)
+				{
+					appendCodePoint(cue, entity.codePoint);
+					p += length;
+					decoded = true;
+					break;
+				}
+			}
+			if (!decoded)
+				appendCodePoint(cue, *p++);
+		}
+		else if (*p < 0x80)
+		{
+			appendCodePoint(cue, *p++);
+		}
+		else
+		{
+			// UTF-8, bytes that are not valid UTF-8 are taken as Latin-1
+			int extraBytes = (*p & 0xE0) == 0xC0 ? 1 : (*p & 0xF0) == 0xE0 ? 2 : (*p & 0xF8) == 0xF0 ? 3 : 0;
+			uint32_t codePoint = *p & (0x3F >> extraBytes);
+			int i = 1;
+			for (; extraBytes > 0 && i <= extraBytes; ++i)
+			{
+				if ((p[i] & 0xC0) != 0x80)
+					break;
+				codePoint = (codePoint << 6) | (p[i] & 0x3F);
+			}
+			
+			if (extraBytes > 0 && i > extraBytes)
+			{
+				appendCodePoint(cue, codePoint);
+				p += i;
+			}
+			else
+			{
+				appendCodePoint(cue, *p++);
+			}
+		}
+	}
+	
+	// Trailing spaces left by removed tags
+	if (cue.lineCount > 0)
+	{
+		uint8_t& length = cue.lineLength[cue.lineCount - 1];
+		while (length > 0 && cue.lines[cue.lineCount - 1][length - 1] == ' ')
+			--length;
+	}
+}
+
+// [HH:]MM:SS[.,]mmm
+bool parseTimestamp(const char*& p, int64_t* time)
+{
+	int64_t	fields[3];
+	int		fieldCount = 0;
+	
+	p = skipSpace(p);
+	for (;;)
+	{
+		if (!isDigit(*p))
+			return false;
+		
+		int64_t value = 0;
+		while (isDigit(*p))
+			value = value * 10 + (*p++ - '0');
+		fields[fieldCount++] = value;
+		
+		if (*p != ':' || fieldCount == 3)
+			break;
+		++p;
+	}
+	
+	if (fieldCount < 2 || (*p != '.' && *p != ','))
+		return false;
+	++p;
+	
+	int64_t milliseconds = 0;
+	int digits = 0;
+	for (; isDigit(*p); ++p)
+	{
+		if (digits++ < 3)
+			milliseconds = milliseconds * 10 + (*p - '0');
+	}
+	if (digits == 0)
+		return false;
+	for (; digits < 3; ++digits)
+		milliseconds *= 10;
+	
+	int64_t seconds = (fieldCount == 3) ? fields[0] * 3600 + fields[1] * 60 + fields[2] : fields[0] * 60 + fields[1];
+	*time = (seconds * 1000 + milliseconds) * (CaptionCue::kTimeScale / 1000);
+	return true;
+}
+
+// HH:MM:SS:FF, or HH:MM:SS;FF for drop frame, as a count of 29.97 fps frames
+bool parseTimecode(const char*& p, int64_t* frameCount)
+{
+	int		fields[4];
+	bool	dropFrame = false;
+	
+	for (int i = 0; i < 4; ++i)
+	{
+		if (!isDigit(p[0]) || !isDigit(p[1]))
+			return false;
+		fields[i] = (p[0] - '0') * 10 + (p[1] - '0');
+		p += 2;
+		
+		if (i < 3)
+		{
+			if (*p == ';' || *p == '.')
+				dropFrame = true;
+			else if (*p != ':')
+				return false;
+			++p;
+		}
+	}
+	
+	int64_t totalMinutes = fields[0] * 60 + fields[1];
+	*frameCount = (totalMinutes * 60 + fields[2]) * 30 + fields[3];
+	if (dropFrame)
+		*frameCount -= 2 * (totalMinutes - totalMinutes / 10);
+	return true;
+}
+
+}
+
+//=====================================================================
+
+CaptionFileReader::CaptionFileReader()
+: m_file(NULL), m_ownsFile(false), m_format(format_Unknown)
+{
+	close();
+}
+
+CaptionFileReader::~CaptionFileReader()
+{
+	close();
+}
+
+bool CaptionFileReader::open(const char* path)
+{
+	FILE* file = std::fopen(path, "rb");
+	if (file == NULL)
+		return false;
+	
+	if (!open(file))
+	{
+		std::fclose(file);
+		return false;
+	}
+	
+	m_ownsFile = true;
+	return true;
+}
+
+bool CaptionFileReader::open(FILE* file)
+{
+	close();
+	m_file = file;
+	
+	if (!detectFormat())
+	{
+		m_file = NULL;
+		close();
+		return false;
+	}
+	return true;
+}
+
+void CaptionFileReader::close()
+{
+	if (m_file != NULL && m_ownsFile)
+		std::fclose(m_file);
+	
+	m_file = NULL;
+	m_ownsFile = false;
+	m_format = format_Unknown;
+	m_line[0] = '\0';
+	m_linePending = false;
+	m_lineCount = 0;
+	m_skippedCount = 0;
+	
+	m_sccPosition = NULL;
+	m_sccTime = 0;
+	m_sccMode = captionMode_PopOn;
+	m_sccRollUpRows = 2;
+	m_sccRow = 0;
+	m_sccChannel = 1;
+	m_sccLastControl = 0;
+	clearText(m_displayed);
+	clearText(m_nonDisplayed);
+	m_displayedChanged = false;
+	m_displayedChangeTime = 0;
+	m_sccCuePending = false;
+	m_sccCueReady = false;
+}
+
+CaptionFileReader::Format CaptionFileReader::format() const
+{
+	return m_format;
+}
+
+uint64_t CaptionFileReader::lineCount() const
+{
+	return m_lineCount;
+}
+
+uint64_t CaptionFileReader::skippedCount() const
+{
+	return m_skippedCount;
+}
+
+bool CaptionFileReader::readLine()
+{
+	if (m_linePending)
+	{
+		m_linePending = false;
+		return true;
+	}
+	
+	if (m_file == NULL || std::fgets(m_line, sizeof(m_line), m_file) == NULL)
+		return false;
+	
+	++m_lineCount;
+	
+	size_t length = std::strlen(m_line);
+	if (length > 0 && m_line[length - 1] != '\n' && !std::feof(m_file))
+	{
+		// Truncate lines longer than the buffer
+		int c;
+		while ((c = std::fgetc(m_file)) != EOF && c != '\n')
+		{ }
+	}
+	
+	while (length > 0 && (m_line[length - 1] == '\n' || m_line[length - 1] == '\r'))
+		m_line[--length] = '\0';
+	
+	return true;
+}
+
+bool CaptionFileReader::detectFormat()
+{
+	static const char kByteOrderMark[] = "\xEF\xBB\xBF";
+	
+	while (readLine())
+	{
+		if (std::strncmp(m_line, kByteOrderMark, 3) == 0)
+			std::memmove(m_line, m_line + 3, std::strlen(m_line + 3) + 1);
+		
+		if (*skipSpace(m_line) == '\0')
+			continue;
+		
+		if (std::strncmp(m_line, "WEBVTT", 6) == 0)
+		{
+			m_format = format_WebVTT;
+		}
+		else if (std::strncmp(m_line, "Scenarist_SCC", 13) == 0)
+		{
+			m_format = format_SCC;
+		}
+		else
+		{
+			// SRT has no header, the first line is a cue number
+			m_format = format_SRT;
+			m_linePending = true;
+		}
+		return true;
+	}
+	
+	return false;
+}
+
+bool CaptionFileReader::read(CaptionCue* cue)
+{
+	switch (m_format)
+	{
+		case format_SRT:
+		case format_WebVTT:
+			return readTimedText(cue);
+		case format_SCC:
+			return readSCC(cue);
+		default:
+			return false;
+	}
+}
+
+//=====================================================================
+// SRT and WebVTT
+
+bool CaptionFileReader::readTimedText(CaptionCue* cue)
+{
+	while (readLine())
+	{
+		// Cue numbers and identifiers, the WebVTT header and NOTE, STYLE and REGION blocks do not contain "-->"
+		const char* arrow = std::strstr(m_line, "-->");
+		if (arrow == NULL)
+			continue;
+		
+		const char* p = m_line;
+		const char* end = arrow + 3;
+		if (!parseTimestamp(p, &cue->startTime) || skipSpace(p) != arrow || !parseTimestamp(end, &cue->endTime))
+		{
+			++m_skippedCount;
+			continue;
+		}
+		
+		clearText(*cue);
+		while (readLine() && m_line[0] != '\0')
+		{
+			// A timing line without a blank line before it starts the next cue
+			if (std::strstr(m_line, "-->") != NULL)
+			{
+				m_linePending = true;
+				break;
+			}
+			appendTimedTextLine(*cue, m_line, m_format == format_WebVTT);
+		}
+		
+		while (cue->lineCount > 0 && cue->lineLength[cue->lineCount - 1] == 0)
+			--cue->lineCount;
+		
+		if (cue->endTime <= cue->startTime || cue->lineCount == 0)
+		{
+			++m_skippedCount;
+			continue;
+		}
+		
+		return true;
+	}
+	
+	return false;
+}
+
+//=====================================================================
+// SCC
+
+bool CaptionFileReader::readSCC(CaptionCue* cue)
+{
+	for (;;)
+	{
+		if (m_sccCueReady)
+		{
+			*cue = m_sccReadyCue;
+			m_sccCueReady = false;
+			return true;
+		}
+		
+		if (m_sccPosition == NULL)
+		{
+			// Roll-up and paint-on text written during the line is shown from the first change
+			if (m_displayedChanged)
+			{
+				commitDisplayed(m_displayedChangeTime);
+				continue;
+			}
+			
+			if (!startSCCLine())
+			{
+				// The last cue ends after the last byte pair
+				if (m_sccCuePending)
+				{
+					m_sccReadyCue = m_sccCue;
+					m_sccReadyCue.endTime = std::max(m_sccTime, m_sccCue.startTime + kSCCFrameDuration);
+					m_sccCuePending = false;
+					m_sccCueReady = true;
+					continue;
+				}
+				return false;
+			}
+		}
+		
+		const char* p = m_sccPosition;
+		int digits[4];
+		for (int i = 0; i < 4; ++i)
+			digits[i] = hexValue(p[i]);
+		
+		if (digits[0] < 0 || digits[1] < 0 || digits[2] < 0 || digits[3] < 0)
+		{
+			++m_skippedCount;
+			m_sccPosition = NULL;
+			continue;
+		}
+		
+		uint8_t byte1 = static_cast<uint8_t>((digits[0] << 4) | digits[1]) & 0x7F;	// Remove parity
+		uint8_t byte2 = static_cast<uint8_t>((digits[2] << 4) | digits[3]) & 0x7F;
+		
+		// Show roll-up or paint-on text written so far before a command that changes the displayed memory,
+		// then decode the command
+		if (m_displayedChanged && commitsDisplayed(byte1, byte2))
+		{
+			commitDisplayed(m_displayedChangeTime);
+			continue;
+		}
+		
+		decodeSCCPair(byte1, byte2, m_sccTime);
+		m_sccTime += kSCCFrameDuration;
+		
+		p = skipSpace(p + 4);
+		m_sccPosition = (*p != '\0') ? p : NULL;
+	}
+}
+
+bool CaptionFileReader::startSCCLine()
+{
+	while (readLine())
+	{
+		const char* p = skipSpace(m_line);
+		int64_t frameCount;
+		
+		if (*p == '\0')
+			continue;
+		
+		if (!parseTimecode(p, &frameCount))
+		{
+			++m_skippedCount;
+			continue;
+		}
+		
+		p = skipSpace(p);
+		if (*p == '\0')
+			continue;
+		
+		// Byte pairs still being sent from the previous line delay this line
+		m_sccTime = std::max(m_sccTime, frameCount * kSCCFrameDuration);
+		m_sccPosition = p;
+		return true;
+	}
+	
+	return false;
+}
+
+bool CaptionFileReader::commitsDisplayed(uint8_t byte1, uint8_t byte2) const
+{
+	uint8_t command = byte1 & ~0x08;
+	
+	if ((command != 0x14 && command != 0x15) || (byte1 & 0x08) || ((byte1 << 8) | byte2) == m_sccLastControl)
+		return false;
+	
+	// EDM, CR, EOC and roll-up mode changes
+	return byte2 == 0x2C || byte2 == 0x2D || byte2 == 0x2F || (byte2 >= 0x25 && byte2 <= 0x27);
+}
+
+CaptionCue& CaptionFileReader::sccMemory()
+{
+	return (m_sccMode == captionMode_PopOn) ? m_nonDisplayed : m_displayed;
+}
+
+void CaptionFileReader::decodeSCCPair(uint8_t byte1, uint8_t byte2, int64_t time)
+{
+	if (byte1 >= 0x10 && byte1 <= 0x1F)
+	{
+		// Control codes are sent twice for redundancy, only the first of a repeated pair is decoded
+		uint16_t control = (byte1 << 8) | byte2;
+		if (control == m_sccLastControl)
+		{
+			m_sccLastControl = 0;
+			return;
+		}
+		m_sccLastControl = control;
+		
+		m_sccChannel = (byte1 & 0x08) ? 2 : 1;
+		if (m_sccChannel == 1)
+			decodeSCCControl(byte1, byte2, time);
+		return;
+	}
+	
+	m_sccLastControl = 0;
+	
+	if (byte1 >= 0x20)
+		appendSCCCharacter(standardCharacter(byte1), time);
+	if (byte2 >= 0x20)
+		appendSCCCharacter(standardCharacter(byte2), time);
+}
+
+void CaptionFileReader::decodeSCCControl(uint8_t byte1, uint8_t byte2, int64_t time)
+{
+	if ((byte1 == 0x14 || byte1 == 0x15) && byte2 >= 0x20 && byte2 <= 0x2F)
+	{
+		switch (byte2)
+		{
+			case 0x20:	// RCL, resume caption loading
+				m_sccMode = captionMode_PopOn;
+				break;
+				
+			case 0x21:	// BS, backspace
+				if (m_sccMode != captionMode_Text)
+				{
+					backspace(sccMemory());
+					if (m_sccMode != captionMode_PopOn)
+						changeDisplayed(time);
+				}
+				break;
+				
+			case 0x25:	// RU2, RU3, RU4, roll-up captions
+			case 0x26:
+			case 0x27:
+				if (m_sccMode != captionMode_RollUp)
+				{
+					clearText(m_displayed);
+					clearText(m_nonDisplayed);
+					changeDisplayed(time);
+				}
+				m_sccMode = captionMode_RollUp;
+				m_sccRollUpRows = byte2 - 0x23;
+				while (m_displayed.lineCount > m_sccRollUpRows)
+				{
+					std::memmove(m_displayed.lines[0], m_displayed.lines[1], sizeof(m_displayed.lines[0]) * (CaptionCue::kMaximumLines - 1));
+					std::memmove(m_displayed.lineLength, m_displayed.lineLength + 1, CaptionCue::kMaximumLines - 1);
+					--m_displayed.lineCount;
+					changeDisplayed(time);
+				}
+				if (m_displayedChanged)
+					commitDisplayed(time);
+				break;
+				
+			case 0x29:	// RDC, resume direct captioning
+				m_sccMode = captionMode_PaintOn;
+				break;
+				
+			case 0x2A:	// TR, RTD, text mode is not captioning
+			case 0x2B:
+				m_sccMode = captionMode_Text;
+				break;
+				
+			case 0x2C:	// EDM, erase displayed memory
+				clearText(m_displayed);
+				m_sccRow = 0;
+				changeDisplayed(time);
+				commitDisplayed(time);
+				break;
+				
+			case 0x2D:	// CR, carriage return
+				if (m_sccMode == captionMode_RollUp)
+				{
+					if (m_displayed.lineCount >= m_sccRollUpRows)
+					{
+						std::memmove(m_displayed.lines[0], m_displayed.lines[1], sizeof(m_displayed.lines[0]) * (CaptionCue::kMaximumLines - 1));
+						std::memmove(m_displayed.lineLength, m_displayed.lineLength + 1, CaptionCue::kMaximumLines - 1);
+						--m_displayed.lineCount;
+					}
+					newLine(m_displayed);
+					changeDisplayed(time);
+					commitDisplayed(time);
+				}
+				break;
+				
+			case 0x2E:	// ENM, erase non-displayed memory
+				clearText(m_nonDisplayed);
+				if (m_sccMode == captionMode_PopOn)
+					m_sccRow = 0;
+				break;
+				
+			case 0x2F:	// EOC, end of caption, swap memories
+				std::swap(m_displayed, m_nonDisplayed);
+				m_sccMode = captionMode_PopOn;
+				m_sccRow = 0;
+				changeDisplayed(time);
+				commitDisplayed(time);
+				break;
+				
+			default:	// AOF, AON, DER, FON
+				break;
+		}
+	}
+	else if (byte1 == 0x11 && byte2 >= 0x20 && byte2 <= 0x2F)
+	{
+		// Mid-row codes display as a space
+		appendSCCCharacter(' ', time);
+	}
+	else if (byte1 == 0x11 && byte2 >= 0x30 && byte2 <= 0x3F)
+	{
+		uint8_t character = CEA608::kSpecialCharacters[byte2 - 0x30];
+		if (character != 0)
+			appendSCCCharacter(character, time);
+	}
+	else if ((byte1 == 0x12 || byte1 == 0x13) && byte2 >= 0x20 && byte2 <= 0x3F)
+	{
+		// Extended characters replace the standard character sent before them for older decoders
+		uint8_t character = CEA608::kExtendedCharacters[byte1 - 0x12][byte2 - 0x20];
+		if (character != 0 && m_sccMode != captionMode_Text)
+		{
+			backspace(sccMemory());
+			appendSCCCharacter(character, time);
+		}
+	}
+	else if (byte2 >= 0x40 && (byte1 != 0x10 || byte2 < 0x60))
+	{
+		// Preamble address code, a new row starts a new line.  Roll-up captions always write to the base row.
+		uint8_t row = CEA608::kPreambleRows[byte1 & 0x7][(byte2 >> 5) & 1];
+		if (m_sccMode == captionMode_PopOn || m_sccMode == captionMode_PaintOn)
+		{
+			CaptionCue& memory = sccMemory();
+			if (memory.lineCount == 0 || row != m_sccRow)
+			{
+				newLine(memory);
+				if (m_sccMode == captionMode_PaintOn)
+					changeDisplayed(time);
+			}
+			m_sccRow = row;
+		}
+	}
+	// Tab offsets and the remaining codes do not change the caption text
+}
+
+void CaptionFileReader::appendSCCCharacter(uint8_t character, int64_t time)
+{
+	if (m_sccChannel != 1 || m_sccMode == captionMode_Text)
+		return;
+	
+	appendCharacter(sccMemory(), character);
+	
+	if (m_sccMode != captionMode_PopOn)
+		changeDisplayed(time);
+}
+
+void CaptionFileReader::changeDisplayed(int64_t time)
+{
+	if (!m_displayedChanged)
+	{
+		m_displayedChanged = true;
+		m_displayedChangeTime = time;
+	}
+}
+
+void CaptionFileReader::commitDisplayed(int64_t time)
+{
+	CaptionCue shown;
+	
+	m_displayedChanged = false;
+	
+	// Blank lines are not part of the cue
+	clearText(shown);
+	for (uint8_t line = 0; line < m_displayed.lineCount; ++line)
+	{
+		uint8_t length = m_displayed.lineLength[line];
+		while (length > 0 && m_displayed.lines[line][length - 1] == ' ')
+			--length;
+		if (length == 0)
+			continue;
+		
+		std::memcpy(shown.lines[shown.lineCount], m_displayed.lines[line], length);
+		shown.lineLength[shown.lineCount++] = length;
+	}
+	
+	if (m_sccCuePending && sameText(shown, m_sccCue))
+		return;
+	
+	if (m_sccCuePending && time > m_sccCue.startTime)
+	{
+		m_sccReadyCue = m_sccCue;
+		m_sccReadyCue.endTime = time;
+		m_sccCueReady = true;
+	}
+	
+	m_sccCuePending = shown.lineCount > 0;
+	if (m_sccCuePending)
+	{
+		m_sccCue = shown;
+		m_sccCue.startTime = time;
+		m_sccCue.endTime = time;
+	}
+}
@@ -0,0 +1,162 @@
+/* -LICENSE-START-
+ ** Copyright (c) 2016 Blackmagic Design
+ **  
+ ** Permission is hereby granted, free of charge, to any person or organization 
+ ** obtaining a copy of the software and accompanying documentation (the 
+ ** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+ ** and transmit the Software, and to prepare derivative works of the Software, 
+ ** and to permit third-parties to whom the Software is furnished to do so, in 
+ ** accordance with:
+ ** 
+ ** (1) if the Software is obtained from Blackmagic Design, the End User License 
+ ** Agreement for the Software Development Kit (“EULA”) available at 
+ ** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+ ** 
+ ** (2) if the Software is obtained from any third party, such licensing terms 
+ ** as notified by that third party,
+ ** 
+ ** and all subject to the following:
+ ** 
+ ** (3) the copyright notices in the Software and this entire statement, 
+ ** including the above license grant, this restriction and the following 
+ ** disclaimer, must be included in all copies of the Software, in whole or in 
+ ** part, and all derivative works of the Software, unless such copies or 
+ ** derivative works are solely in the form of machine-executable object code 
+ ** generated by a source language processor.
+ ** 
+ ** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ ** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ ** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+ ** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+ ** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+ ** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ ** DEALINGS IN THE SOFTWARE.
+ ** 
+ ** A copy of the Software is available free of charge at 
+ ** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+ ** 
+ ** -LICENSE-END-
+ */
+
+#ifndef __CAPTION_FILE_READER_H__
+#define __CAPTION_FILE_READER_H__
+#include <cstdio>
+#include <stdint.h>
+
+/* One caption cue.
+ * Times are in 90 kHz units, which represent both millisecond (SRT, WebVTT) and 29.97 fps (SCC) timing exactly.
+ * Text is in the CEA-708 G0 and G1 code sets: ASCII with 0x7F as a music note, and Latin-1 from 0xA0.
+ * Lines are at most 32 columns, the width of a CEA-608 caption row and of a 4:3 CEA-708 window. */
+struct CaptionCue
+{
+	enum
+	{
+		kTimeScale = 90000,
+		kMaximumLines = 4,
+		kMaximumColumns = 32
+	};
+	
+	int64_t		startTime;
+	int64_t		endTime;
+	uint8_t		lineCount;
+	uint8_t		lineLength[kMaximumLines];
+	uint8_t		lines[kMaximumLines][kMaximumColumns];
+};
+
+/* Stream parser for SCC, SRT and WebVTT caption files.
+ *
+ * The file is read a line at a time into a fixed buffer, and only the cue being built is held, so files of any
+ * length are read in constant memory.  Cues are returned in file order.
+ *
+ * SRT and WebVTT cue text is decoded from UTF-8 (or Latin-1), markup tags are removed and long lines are word
+ * wrapped.  WebVTT cue settings, NOTE, STYLE and REGION blocks are ignored.
+ *
+ * SCC files carry CEA-608 byte pairs for 29.97 fps frames.  The caption channel 1 pop-on, roll-up and paint-on
+ * commands are decoded into cues that start when the displayed memory changes and end at its next change. */
+class CaptionFileReader
+{
+public:
+	enum Format
+	{
+		format_Unknown = 0,
+		format_SCC,
+		format_SRT,
+		format_WebVTT
+	};
+	
+	CaptionFileReader();
+	~CaptionFileReader();
+	
+	// Open a file, the format is detected from its first line
+	bool open(const char* path);
+	
+	// Read from a file positioned at its start, which is not closed by the reader
+	bool open(FILE* file);
+	
+	void close();
+	
+	Format format() const;
+	
+	// Read the next cue, returns false at the end of the file
+	bool read(CaptionCue* cue);
+	
+	// Number of lines read, and of malformed cues or lines that were skipped
+	uint64_t lineCount() const;
+	uint64_t skippedCount() const;
+	
+private:
+	enum
+	{
+		kMaximumLineLength = 1024
+	};
+	
+	enum CaptionMode
+	{
+		captionMode_PopOn = 0,
+		captionMode_RollUp,
+		captionMode_PaintOn,
+		captionMode_Text
+	};
+	
+	FILE*			m_file;
+	bool			m_ownsFile;
+	Format			m_format;
+	char			m_line[kMaximumLineLength];
+	bool			m_linePending;		// m_line has been read but not consumed
+	uint64_t		m_lineCount;
+	uint64_t		m_skippedCount;
+	
+	// SCC decoder state
+	const char*		m_sccPosition;		// Next byte pair in m_line, or NULL when the line is consumed
+	int64_t			m_sccTime;			// Time of the next byte pair
+	CaptionMode		m_sccMode;
+	uint8_t			m_sccRollUpRows;
+	uint8_t			m_sccRow;			// CEA-608 row of the last line in the memory being written
+	uint8_t			m_sccChannel;
+	uint16_t		m_sccLastControl;	// Control codes are transmitted twice, the repeat is ignored
+	CaptionCue		m_displayed;
+	CaptionCue		m_nonDisplayed;
+	bool			m_displayedChanged;
+	int64_t			m_displayedChangeTime;
+	CaptionCue		m_sccCue;			// Cue showing the displayed memory, waiting for its end time
+	bool			m_sccCuePending;
+	CaptionCue		m_sccReadyCue;		// Completed cue, returned before the next byte pair is decoded
+	bool			m_sccCueReady;
+	
+	bool readLine();
+	bool detectFormat();
+	
+	bool readTimedText(CaptionCue* cue);
+	
+	bool readSCC(CaptionCue* cue);
+	bool startSCCLine();
+	bool commitsDisplayed(uint8_t byte1, uint8_t byte2) const;
+	void decodeSCCPair(uint8_t byte1, uint8_t byte2, int64_t time);
+	void decodeSCCControl(uint8_t byte1, uint8_t byte2, int64_t time);
+	void appendSCCCharacter(uint8_t character, int64_t time);
+	void changeDisplayed(int64_t time);
+	void commitDisplayed(int64_t time);
+	CaptionCue& sccMemory();
+};
+
+#endif
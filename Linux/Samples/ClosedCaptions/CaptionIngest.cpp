@@ -0,0 +1,247 @@
+/* -LICENSE-START-
+ ** Copyright (c) 2016 Blackmagic Design
+ **  
+ ** Permission is hereby granted, free of charge, to any person or organization 
+ ** obtaining a copy of the software and accompanying documentation (the 
+ ** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+ ** and transmit the Software, and to prepare derivative works of the Software, 
+ ** and to permit third-parties to whom the Software is furnished to do so, in 
+ ** accordance with:
+ ** 
+ ** (1) if the Software is obtained from Blackmagic Design, the End User License 
+ ** Agreement for the Software Development Kit (“EULA”) available at 
+ ** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+ ** 
+ ** (2) if the Software is obtained from any third party, such licensing terms 
+ ** as notified by that third party,
+ ** 
+ ** and all subject to the following:
+ ** 
+ ** (3) the copyright notices in the Software and this entire statement, 
+ ** including the above license grant, this restriction and the following 
+ ** disclaimer, must be included in all copies of the Software, in whole or in 
+ ** part, and all derivative works of the Software, unless such copies or 
+ ** derivative works are solely in the form of machine-executable object code 
+ ** generated by a source language processor.
+ ** 
+ ** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ ** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ ** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+ ** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+ ** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+ ** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ ** DEALINGS IN THE SOFTWARE.
+ ** 
+ ** A copy of the Software is available free of charge at 
+ ** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+ ** 
+ ** -LICENSE-END-
+ */
+
+#include "CaptionIngest.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace CEA708;
+
+CaptionIngest::CaptionIngest(Encoder& encoder, CaptionFileReader& reader, int64_t frameDuration, int64_t timeScale, int64_t timeOffset)
+: m_encoder(encoder), m_reader(reader), m_frameDuration(frameDuration), m_timeScale(timeScale), m_timeOffset(timeOffset),
+  m_nextEncodeFrame(0), m_nextPopFrame(0), m_resetPending(true),
+  m_shownWindow(kNoWindow), m_shownEndFrame(0),
+  m_loadState(loadState_Empty), m_loadWindow(window_0), m_loadStartFrame(0), m_loadEndFrame(0),
+  m_unitCount(0), m_unitBytesUsed(0), m_nextUnit(0), m_nextUnitByte(0)
+{
+	std::memset(&m_statistics, 0, sizeof(m_statistics));
+}
+
+const CaptionIngest::Statistics& CaptionIngest::statistics() const
+{
+	return m_statistics;
+}
+
+bool CaptionIngest::finished() const
+{
+	return m_loadState == loadState_EndOfFile && m_shownWindow == kNoWindow;
+}
+
+int64_t CaptionIngest::timeToFrame(int64_t time) const
+{
+	// Nearest frame
+	int64_t scale = CaptionCue::kTimeScale * m_frameDuration;
+	int64_t scaledTime = (time - m_timeOffset) * m_timeScale;
+	return (scaledTime >= 0) ? (scaledTime + scale / 2) / scale : -((-scaledTime + scale / 2) / scale);
+}
+
+void CaptionIngest::addUnit(const uint8_t* unit, uint8_t size)
+{
+	if (m_unitCount == kMaximumUnits || m_unitBytesUsed + size > kMaximumUnitBytes)
+		return;
+	
+	std::memcpy(m_unitBytes + m_unitBytesUsed, unit, size);
+	m_unitBytesUsed += size;
+	m_unitSizes[m_unitCount++] = size;
+}
+
+void CaptionIngest::addUnit(const SyntacticElement& command)
+{
+	addUnit(command.data(), command.size());
+}
+
+void CaptionIngest::loadNextCue()
+{
+	CaptionCue cue;
+	
+	if (!m_reader.read(&cue))
+	{
+		m_loadState = loadState_EndOfFile;
+		return;
+	}
+	
+	++m_statistics.cuesRead;
+	
+	uint8_t columnCount = 1;
+	for (uint8_t line = 0; line < cue.lineCount; ++line)
+		columnCount = std::max(columnCount, cue.lineLength[line]);
+	
+	m_loadWindow = (m_shownWindow == window_0) ? window_1 : window_0;
+	m_loadStartFrame = timeToFrame(cue.startTime);
+	m_loadEndFrame = timeToFrame(cue.endTime);
+	m_unitCount = 0;
+	m_unitBytesUsed = 0;
+	m_nextUnit = 0;
+	m_nextUnitByte = 0;
+	
+	// 8.11 Proper Order of Data.  The window is defined hidden, row and column counts are encoded as count - 1.
+	WindowID window = static_cast<WindowID>(m_loadWindow);
+	addUnit(DefineWindow(window, priority_Highest, anchor_BottomCenter, true, 90, 50, cue.lineCount - 1, columnCount - 1, true, true, false, windowStyle_NTSCPopup, penStyle_NTSCProportionalSans));
+	addUnit(SetWindowAttributes(justify_Center, printDirection_LeftToRight, scrollDirection_BottomToTop, false, displayEffect_Snap, effectDirection_LeftToRight, 0, colour_Black, opacity_Solid, borderType_None, colour_Black));
+	addUnit(ClearWindows(1 << m_loadWindow));
+	
+	for (uint8_t line = 0; line < cue.lineCount; ++line)
+	{
+		addUnit(SetPenLocation(line, 0));
+		for (uint8_t column = 0; column < cue.lineLength[line]; ++column)
+			addUnit(&cue.lines[line][column], 1);
+	}
+	
+	// The 608 caption is sent as one unit, it is loaded before the 708 window at 2 characters per frame
+	const uint8_t* lines[CaptionCue::kMaximumLines];
+	for (uint8_t line = 0; line < cue.lineCount; ++line)
+		lines[line] = cue.lines[line];
+	m_encoder.cea608().loadPopOn(CEA608::channel_CC1, lines, cue.lineLength, cue.lineCount);
+	
+	m_loadState = loadState_Loading;
+}
+
+void CaptionIngest::encodeFrame(int64_t frame)
+{
+	std::size_t	budget = m_encoder.frameCapacity();
+	uint8_t		hideMask = 0;
+	uint8_t		showMask = 0;
+	
+	// Start from a known decoder state
+	if (m_resetPending)
+	{
+		m_encoder << DeleteWindows();
+		budget -= DeleteWindows().size();
+		m_encoder.cea608().control(CEA608::channel_CC1, CEA608::control_EraseDisplayedMemory);
+		m_resetPending = false;
+	}
+	
+	if (m_shownWindow != kNoWindow && frame >= m_shownEndFrame)
+	{
+		hideMask = 1 << m_shownWindow;
+		m_shownWindow = kNoWindow;
+	}
+	
+	if (m_loadState == loadState_Loaded && frame >= m_loadStartFrame)
+	{
+		if (frame >= m_loadEndFrame)
+		{
+			++m_statistics.cuesDropped;
+		}
+		else
+		{
+			if (m_shownWindow != kNoWindow)
+				hideMask |= 1 << m_shownWindow;
+			showMask = 1 << m_loadWindow;
+			
+			if (frame > m_loadStartFrame)
+			{
+				++m_statistics.cuesLate;
+				m_statistics.maximumLateFrames = std::max(m_statistics.maximumLateFrames, frame - m_loadStartFrame);
+			}
+			++m_statistics.cuesShown;
+			
+			if (!m_encoder.cea608().empty(CEA608::field_1))
+				++m_statistics.cues608Late;
+			
+			m_shownWindow = m_loadWindow;
+			m_shownEndFrame = m_loadEndFrame;
+		}
+		m_loadState = loadState_Empty;
+	}
+	
+	// End Of Caption swaps 608 memories in the same way, otherwise the displayed caption is erased
+	if (showMask != 0)
+		m_encoder.cea608().control(CEA608::channel_CC1, CEA608::control_EndOfCaption);
+	else if (hideMask != 0)
+		m_encoder.cea608().control(CEA608::channel_CC1, CEA608::control_EraseDisplayedMemory);
+	
+	// Swap the windows with one command so that there is no gap or overlap between cues
+	if (hideMask != 0 && showMask != 0)
+		m_encoder << ToggleWindows(hideMask | showMask);
+	else if (showMask != 0)
+		m_encoder << DisplayWindows(showMask);
+	else if (hideMask != 0)
+		m_encoder << HideWindows(hideMask);
+	
+	if (hideMask != 0 || showMask != 0)
+		budget -= 2;
+	
+	if (m_loadState == loadState_Empty)
+		loadNextCue();
+	
+	while (m_loadState == loadState_Loading && m_unitSizes[m_nextUnit] <= budget)
+	{
+		uint8_t size = m_unitSizes[m_nextUnit];
+		m_encoder.push(m_unitBytes + m_nextUnitByte, size);
+		m_nextUnitByte += size;
+		budget -= size;
+		
+		if (++m_nextUnit == m_unitCount)
+			m_loadState = loadState_Loaded;
+	}
+	
+	// One CDP for this frame, with a null service block when there is no caption data
+	m_encoder.flush();
+	++m_statistics.framesEncoded;
+}
+
+void CaptionIngest::encodeUntil(int64_t lastFrame)
+{
+	lastFrame = std::min<int64_t>(lastFrame, m_nextPopFrame + CDPQueue::kCapacity - 1);
+	
+	while (m_nextEncodeFrame <= lastFrame)
+		encodeFrame(m_nextEncodeFrame++);
+}
+
+bool CaptionIngest::pop(int64_t frame, EncodedCaptionDistributionPacket* packet)
+{
+	if (frame < m_nextPopFrame)
+		return false;
+	
+	for (;;)
+	{
+		if (m_nextEncodeFrame <= m_nextPopFrame)
+			encodeFrame(m_nextEncodeFrame++);
+		
+		if (!m_encoder.pop(packet))
+			return false;
+		
+		if (m_nextPopFrame++ == frame)
+			return true;
+		
+		++m_statistics.framesSkipped;
+	}
+}
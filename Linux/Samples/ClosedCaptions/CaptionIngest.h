@@ -0,0 +1,140 @@
+/* -LICENSE-START-
+ ** Copyright (c) 2016 Blackmagic Design
+ **  
+ ** Permission is hereby granted, free of charge, to any person or organization 
+ ** obtaining a copy of the software and accompanying documentation (the 
+ ** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+ ** and transmit the Software, and to prepare derivative works of the Software, 
+ ** and to permit third-parties to whom the Software is furnished to do so, in 
+ ** accordance with:
+ ** 
+ ** (1) if the Software is obtained from Blackmagic Design, the End User License 
+ ** Agreement for the Software Development Kit (“EULA”) available at 
+ ** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+ ** 
+ ** (2) if the Software is obtained from any third party, such licensing terms 
+ ** as notified by that third party,
+ ** 
+ ** and all subject to the following:
+ ** 
+ ** (3) the copyright notices in the Software and this entire statement, 
+ ** including the above license grant, this restriction and the following 
+ ** disclaimer, must be included in all copies of the Software, in whole or in 
+ ** part, and all derivative works of the Software, unless such copies or 
+ ** derivative works are solely in the form of machine-executable object code 
+ ** generated by a source language processor.
+ ** 
+ ** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ ** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ ** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+ ** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+ ** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+ ** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ ** DEALINGS IN THE SOFTWARE.
+ ** 
+ ** A copy of the Software is available free of charge at 
+ ** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+ ** 
+ ** -LICENSE-END-
+ */
+
+#ifndef __CAPTION_INGEST_H__
+#define __CAPTION_INGEST_H__
+#include "CEA708_Encoder.h"
+#include "CaptionFileReader.h"
+
+/* Drives the CEA-708 encoder from a caption file, producing exactly one CDP for each output frame.
+ *
+ * Each cue is written into a hidden window with DefineWindow, SetPenLocation and its text, a frame's worth of caption
+ * data at a time, while the previous cue is on screen.  Two windows are used in turn, so the loaded cue is shown and
+ * the previous one hidden with a single command in the CDP of the cue's start frame.  A cue that is not fully loaded
+ * by its start frame is shown as soon as it is, and counted as late.
+ *
+ * The same cue is sent as a CEA-608 pop-on caption on CC1, loaded into non-displayed memory when the cue is read
+ * and shown with End Of Caption on its start frame.  608 carries only two characters per frame, so a 608 caption
+ * still loading at its start frame is shown late, after the rest of its text.
+ *
+ * Cues are read from the file one at a time as they are needed, so memory use does not depend on the file length.
+ * CDPs are encoded ahead of playout with encodeUntil() into the encoder's queue, and taken with pop() as each frame
+ * is scheduled. */
+class CaptionIngest
+{
+public:
+	struct Statistics
+	{
+		uint64_t	framesEncoded;
+		uint64_t	cuesRead;
+		uint64_t	cuesShown;
+		uint64_t	cuesLate;			// Shown after their start frame
+		uint64_t	cuesDropped;		// Not loaded before their end frame
+		uint64_t	cues608Late;		// 608 caption still loading at its start frame
+		int64_t		maximumLateFrames;
+		uint64_t	framesSkipped;		// CDPs discarded because their frame was not scheduled
+	};
+	
+	// timeOffset is the time in the caption file of frame 0, in CaptionCue::kTimeScale units
+	CaptionIngest(CEA708::Encoder& encoder, CaptionFileReader& reader, int64_t frameDuration, int64_t timeScale, int64_t timeOffset = 0);
+	
+	/* Encode the CDPs of every frame up to and including lastFrame.
+	 * At most CDPQueue::kCapacity frames are encoded ahead of the next frame to pop. */
+	void encodeUntil(int64_t lastFrame);
+	
+	/* Pop the CDP for frame into packet, encoding it now if encodeUntil() has not.
+	 * CDPs for any earlier frames that were not popped are discarded.  Returns false if frame was already popped. */
+	bool pop(int64_t frame, CEA708::EncodedCaptionDistributionPacket* packet);
+	
+	// True when every cue in the file has been shown or dropped, and the last one has ended
+	bool finished() const;
+	
+	const Statistics& statistics() const;
+	
+private:
+	enum LoadState
+	{
+		loadState_Empty = 0,
+		loadState_Loading,
+		loadState_Loaded,
+		loadState_EndOfFile
+	};
+	
+	enum
+	{
+		kNoWindow = -1,
+		kMaximumUnits = 4 + CaptionCue::kMaximumLines * (1 + CaptionCue::kMaximumColumns),
+		kMaximumUnitBytes = 7 + 5 + 2 + 2 + CaptionCue::kMaximumLines * (3 + CaptionCue::kMaximumColumns)
+	};
+	
+	CEA708::Encoder&	m_encoder;
+	CaptionFileReader&	m_reader;
+	int64_t				m_frameDuration;
+	int64_t				m_timeScale;
+	int64_t				m_timeOffset;
+	int64_t				m_nextEncodeFrame;
+	int64_t				m_nextPopFrame;
+	bool				m_resetPending;
+	
+	int					m_shownWindow;
+	int64_t				m_shownEndFrame;
+	
+	// Cue being written into the hidden window, as indivisible units of caption data
+	LoadState			m_loadState;
+	int					m_loadWindow;
+	int64_t				m_loadStartFrame;
+	int64_t				m_loadEndFrame;
+	uint8_t				m_unitBytes[kMaximumUnitBytes];
+	uint8_t				m_unitSizes[kMaximumUnits];
+	unsigned			m_unitCount;
+	unsigned			m_unitBytesUsed;
+	unsigned			m_nextUnit;
+	unsigned			m_nextUnitByte;
+	
+	Statistics			m_statistics;
+	
+	int64_t timeToFrame(int64_t time) const;
+	void addUnit(const uint8_t* unit, uint8_t size);
+	void addUnit(const CEA708::SyntacticElement& command);
+	void loadNextCue();
+	void encodeFrame(int64_t frame);
+};
+
+#endif
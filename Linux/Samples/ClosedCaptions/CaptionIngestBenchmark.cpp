@@ -0,0 +1,201 @@
+/* -LICENSE-START-
+ ** Copyright (c) 2016 Blackmagic Design
+ **  
+ ** Permission is hereby granted, free of charge, to any person or organization 
+ ** obtaining a copy of the software and accompanying documentation (the 
+ ** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+ ** and transmit the Software, and to prepare derivative works of the Software, 
+ ** and to permit third-parties to whom the Software is furnished to do so, in 
+ ** accordance with:
+ ** 
+ ** (1) if the Software is obtained from Blackmagic Design, the End User License 
+ ** Agreement for the Software Development Kit (“EULA”) available at 
+ ** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+ ** 
+ ** (2) if the Software is obtained from any third party, such licensing terms 
+ ** as notified by that third party,
+ ** 
+ ** and all subject to the following:
+ ** 
+ ** (3) the copyright notices in the Software and this entire statement, 
+ ** including the above license grant, this restriction and the following 
+ ** disclaimer, must be included in all copies of the Software, in whole or in 
+ ** part, and all derivative works of the Software, unless such copies or 
+ ** derivative works are solely in the form of machine-executable object code 
+ ** generated by a source language processor.
+ ** 
+ ** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ ** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ ** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+ ** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+ ** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+ ** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ ** DEALINGS IN THE SOFTWARE.
+ ** 
+ ** A copy of the Software is available free of charge at 
+ ** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+ ** 
+ ** -LICENSE-END-
+ */
+
+#include "CaptionIngestBenchmark.h"
+#include "CaptionIngest.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <sys/resource.h>
+
+namespace
+{
+
+const int64_t	kFrameDuration = 1001;
+const int64_t	kTimeScale = 30000;
+const int64_t	kCueIntervalFrames = 90;		// A new cue every 3 seconds
+const int64_t	kCueDurationFrames = 75;
+const int64_t	kLookaheadFrames = 30;
+
+const char* const kCueLines[2] =
+{
+	"Caption number %llu of the",
+	"benchmark, two lines of text."
+};
+
+// CEA-608 bytes have odd parity
+unsigned withParity(unsigned byte)
+{
+	return (__builtin_popcount(byte) & 1) ? byte : byte | 0x80;
+}
+
+void writeTimestamp(FILE* file, int64_t milliseconds, bool webVTT)
+{
+	std::fprintf(file, "%02lld:%02lld:%02lld%c%03lld", (long long)(milliseconds / 3600000), (long long)(milliseconds / 60000 % 60),
+				 (long long)(milliseconds / 1000 % 60), webVTT ? '.' : ',', (long long)(milliseconds % 1000));
+}
+
+// Non drop frame timecode of a 29.97 fps frame count
+void writeTimecode(FILE* file, int64_t frame)
+{
+	std::fprintf(file, "%02lld:%02lld:%02lld:%02lld", (long long)(frame / 108000), (long long)(frame / 1800 % 60),
+				 (long long)(frame / 30 % 60), (long long)(frame % 30));
+}
+
+void writeSCCPairs(FILE* file, const unsigned* pairs, unsigned count)
+{
+	for (unsigned i = 0; i < count; ++i)
+		std::fprintf(file, " %02x%02x", withParity(pairs[i] >> 8), withParity(pairs[i] & 0xFF));
+	std::fprintf(file, "\n\n");
+}
+
+FILE* writeCaptionFile(CaptionFileReader::Format format, int64_t frameCount)
+{
+	FILE* file = std::tmpfile();
+	if (file == NULL)
+		return NULL;
+	
+	if (format == CaptionFileReader::format_SCC)
+		std::fprintf(file, "Scenarist_SCC V1.0\n\n");
+	else if (format == CaptionFileReader::format_WebVTT)
+		std::fprintf(file, "WEBVTT\n\n");
+	
+	unsigned long long cueNumber = 1;
+	for (int64_t startFrame = kCueIntervalFrames; startFrame + kCueDurationFrames < frameCount; startFrame += kCueIntervalFrames, ++cueNumber)
+	{
+		char lines[2][64];
+		std::snprintf(lines[0], sizeof(lines[0]), kCueLines[0], cueNumber);
+		std::snprintf(lines[1], sizeof(lines[1]), "%s", kCueLines[1]);
+		
+		if (format == CaptionFileReader::format_SCC)
+		{
+			// Pop-on caption: ENM, RCL, then a preamble address code and the text of each row, ending with EOC on
+			// the start frame.  Control codes are sent twice.
+			unsigned pairs[64];
+			unsigned count = 0;
+			pairs[count++] = 0x142E; pairs[count++] = 0x142E;
+			pairs[count++] = 0x1420; pairs[count++] = 0x1420;
+			for (int line = 0; line < 2; ++line)
+			{
+				unsigned preamble = (line == 0) ? 0x1440 : 0x1460;	// Rows 14 and 15
+				pairs[count++] = preamble; pairs[count++] = preamble;
+				size_t length = std::strlen(lines[line]);
+				for (size_t i = 0; i < length; i += 2)
+					pairs[count++] = (lines[line][i] << 8) | ((i + 1 < length) ? lines[line][i + 1] : 0);
+			}
+			pairs[count++] = 0x142F; pairs[count++] = 0x142F;
+			
+			writeTimecode(file, startFrame - count + 1);
+			writeSCCPairs(file, pairs, count);
+			
+			const unsigned erase[2] = { 0x142C, 0x142C };
+			writeTimecode(file, startFrame + kCueDurationFrames);
+			writeSCCPairs(file, erase, 2);
+		}
+		else
+		{
+			bool webVTT = (format == CaptionFileReader::format_WebVTT);
+			int64_t startMilliseconds = startFrame * kFrameDuration / (kTimeScale / 1000);
+			int64_t endMilliseconds = (startFrame + kCueDurationFrames) * kFrameDuration / (kTimeScale / 1000);
+			
+			std::fprintf(file, "%llu\n", cueNumber);
+			writeTimestamp(file, startMilliseconds, webVTT);
+			std::fprintf(file, " --> ");
+			writeTimestamp(file, endMilliseconds, webVTT);
+			std::fprintf(file, "\n<i>%s</i>\n%s\n\n", lines[0], lines[1]);
+		}
+	}
+	
+	std::rewind(file);
+	return file;
+}
+
+}
+
+bool RunCaptionIngestBenchmark(unsigned hours)
+{
+	const CaptionFileReader::Format	formats[] = { CaptionFileReader::format_SCC, CaptionFileReader::format_SRT, CaptionFileReader::format_WebVTT };
+	const char*						formatNames[] = { "SCC", "SRT", "WebVTT" };
+	int64_t							frameCount = static_cast<int64_t>(hours) * 3600 * kTimeScale / kFrameDuration;
+	
+	std::printf("Ingesting %u hour caption files into CEA-608/708 CDPs for %lld frames at 29.97 fps\n", hours, (long long)frameCount);
+	
+	for (size_t i = 0; i < sizeof(formats) / sizeof(formats[0]); ++i)
+	{
+		FILE*								file = writeCaptionFile(formats[i], frameCount);
+		CaptionFileReader					reader;
+		CEA708::Encoder						encoder(kFrameDuration, kTimeScale);
+		CaptionIngest						ingest(encoder, reader, kFrameDuration, kTimeScale);
+		CEA708::EncodedCaptionDistributionPacket	packet;
+		uint64_t							cdpBytes = 0;
+		
+		if (file == NULL || !reader.open(file) || reader.format() != formats[i])
+		{
+			std::fprintf(stderr, "Unable to create %s benchmark file\n", formatNames[i]);
+			if (file != NULL)
+				std::fclose(file);
+			return false;
+		}
+		
+		auto startTime = std::chrono::steady_clock::now();
+		
+		for (int64_t frame = 0; frame < frameCount; ++frame)
+		{
+			ingest.encodeUntil(frame + kLookaheadFrames);
+			if (ingest.pop(frame, &packet))
+				cdpBytes += packet.size;
+		}
+		
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+		const CaptionIngest::Statistics& statistics = ingest.statistics();
+		struct rusage usage;
+		getrusage(RUSAGE_SELF, &usage);
+		
+		std::printf("  %-6s  %9.0f CDPs/s (%6.0fx real time)  %llu cues: %llu shown, %llu late (max %lld frames), %llu dropped, %llu late in 608;  %llu bytes of CDPs, peak RSS %ld KB\n",
+					formatNames[i], frameCount / elapsed.count(), frameCount / elapsed.count() / (double(kTimeScale) / kFrameDuration),
+					(unsigned long long)statistics.cuesRead, (unsigned long long)statistics.cuesShown, (unsigned long long)statistics.cuesLate,
+					(long long)statistics.maximumLateFrames, (unsigned long long)statistics.cuesDropped, (unsigned long long)statistics.cues608Late, (unsigned long long)cdpBytes, usage.ru_maxrss);
+		
+		reader.close();
+		std::fclose(file);
+	}
+	
+	return true;
+}
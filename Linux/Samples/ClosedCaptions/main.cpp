@@ -42,6 +42,7 @@
 #include <condition_variable>
 #include <cstring>
 #include <cstdio>
+#include <cstdlib>
 #include <functional>
 #include <mutex>
 
@@ -49,6 +50,8 @@
 // basic encoding of caption data using the CEA 708 spec, before passing that data to the DeckLinkAPI. Other caption
 // encodings used by receiving equipment, or more advanced usage of CEA-708, are out of the scope of this sample.
 #include "CEA708_Encoder.h"
+#include "CaptionIngest.h"
+#include "CaptionIngestBenchmark.h"
 
 // Video mode parameters
 const BMDDisplayMode      kDisplayMode = bmdModeHD1080i50;
@@ -71,6 +74,12 @@ const uint32_t kBlueData[] = { 0x40aa298, 0x2a8a62a8, 0x298aa040, 0x2a8102a8 };
 const uint8_t kCaptionDistributionPacketDID = 0x61;
 const uint8_t kCaptionDistributionPacketSDID = 0x1;
 
+// Number of frames scheduled before playback starts, each frame is recycled when it completes
+const uint32_t kFramePoolSize = 3;
+
+// Caption CDPs from a file are encoded up to a second ahead of the frame being scheduled
+const int64_t kCaptionLookaheadFrames = kTimeScale / kFrameDuration;
+
 // Keep track of the number of scheduled frames
 uint32_t gTotalFramesScheduled = 0;
 
@@ -92,13 +101,22 @@ static void FillBlue(IDeckLinkMutableVideoFrame* theFrame)
 	}
 }
 
+// Each output frame owns one caption packet, created with the frame.  The CDP for the next frame is popped straight
+// into the packet's storage when the frame is rescheduled, so captions need no per-frame allocations.  The packet is
+// detached from frames scheduled without a CDP.
 class CaptionAncillaryPacket: public IDeckLinkAncillaryPacket
 {
 public:
-	CaptionAncillaryPacket(const CEA708::EncodedCaptionDistributionPacket& userData)
+	CaptionAncillaryPacket()
 	{
 		m_refCount = 1;
-		m_userData = userData;
+		m_userData.size = 0;
+	}
+	
+	// Storage for the CDP carried by this packet, only modified while the frame is not scheduled
+	CEA708::EncodedCaptionDistributionPacket* GetCDP()
+	{
+		return &m_userData;
 	}
 	
 	// IDeckLinkAncillaryPacket
@@ -111,9 +129,9 @@ public:
 			return E_NOTIMPL;
 		}
 		if (size) // Optional
-			*size = (uint32_t)m_userData.size();
+			*size = m_userData.size;
 		if (data) // Optional
-			*data = m_userData.data();
+			*data = m_userData.data;
 		return S_OK;
 	}
 	
@@ -171,6 +189,26 @@ private:
 	CEA708::EncodedCaptionDistributionPacket m_userData;
 };
 
+// Output frames and their caption packets, fixed at startup
+struct CaptionFrame
+{
+	IDeckLinkVideoFrame*		videoFrame;
+	CaptionAncillaryPacket*		captionPacket;
+	bool						captionAttached;		// The packet is only attached while it holds a CDP
+};
+
+CaptionFrame gCaptionFrames[kFramePoolSize] = {};
+
+static CaptionFrame* FindCaptionFrame(IDeckLinkVideoFrame* videoFrame)
+{
+	for (auto& captionFrame : gCaptionFrames)
+	{
+		if (captionFrame.videoFrame == videoFrame)
+			return &captionFrame;
+	}
+	return NULL;
+}
+
 class OutputCallback: public IDeckLinkVideoOutputCallback
 {
 	using ScheduledFrameCompletedCallback = std::function<void(IDeckLinkVideoFrame*)>;
@@ -249,10 +287,12 @@ public:
 	}
 };
 
-static IDeckLinkMutableVideoFrame* CreateFrame(IDeckLinkOutput* deckLinkOutput)
+static IDeckLinkMutableVideoFrame* CreateFrame(IDeckLinkOutput* deckLinkOutput, CaptionFrame& captionFrame)
 {
-	HRESULT                         result;
-	IDeckLinkMutableVideoFrame*     frame = NULL;
+	HRESULT                                 result;
+	IDeckLinkMutableVideoFrame*             frame = NULL;
+	IDeckLinkVideoFrameAncillaryPackets*    frameAncillaryPackets = NULL;
+	CaptionAncillaryPacket*                 captionPacket = NULL;
 	
 	result = deckLinkOutput->CreateVideoFrame(kFrameWidth, kFrameHeight, kRowBytes, kPixelFormat, bmdFrameFlagDefault, &frame);
 	if (result != S_OK)
@@ -263,17 +303,119 @@ static IDeckLinkMutableVideoFrame* CreateFrame(IDeckLinkOutput* deckLinkOutput)
 	
 	FillBlue(frame);
 	
+	result = frame->QueryInterface(IID_IDeckLinkVideoFrameAncillaryPackets, (void**)&frameAncillaryPackets);
+	if (result != S_OK)
+	{
+		fprintf(stderr, "Could not get ancillary packet store = %08x\n", result);
+		goto bail;
+	}
+	
+	// The packet is refilled each time the frame is rescheduled, and detached while there is no CDP to send
+	captionPacket = new CaptionAncillaryPacket();
+	result = frameAncillaryPackets->AttachPacket(captionPacket);
+	if (result != S_OK)
+	{
+		fprintf(stderr, "Could not attach packet = %08x\n", result);
+		goto bail;
+	}
+	
+	captionFrame.videoFrame = frame;
+	captionFrame.captionPacket = captionPacket;
+	captionFrame.captionAttached = true;
+	captionPacket = NULL;
+	
 bail:
 	
+	if (captionPacket != NULL)
+		captionPacket->Release();
+	
+	if (frameAncillaryPackets != NULL)
+		frameAncillaryPackets->Release();
+	
+	if (result != S_OK && frame != NULL)
+	{
+		frame->Release();
+		frame = NULL;
+	}
+	
 	return frame;
 }
 
-HRESULT ScheduleNextFrame(CEA708::Encoder& CC708Encoder, IDeckLinkOutput* deckLinkOutput, IDeckLinkVideoFrame* videoFrame)
+static HRESULT ScheduleCaptionFrame(IDeckLinkOutput* deckLinkOutput, IDeckLinkVideoFrame* videoFrame)
 {
-	HRESULT										result = S_OK;
-	IDeckLinkVideoFrameAncillaryPackets*		frameAncillaryPackets = NULL;
-	IDeckLinkAncillaryPacket*					ancillaryPacket = NULL;
-	CEA708::EncodedCaptionDistributionPacket	packet;
+	HRESULT result;
+	
+	// When a video frame completes,reschedule another frame
+	result = deckLinkOutput->ScheduleVideoFrame(videoFrame, gTotalFramesScheduled*kFrameDuration, kFrameDuration, kTimeScale);
+	if (result != S_OK)
+	{
+		fprintf(stderr, "Could not schedule video frame = %08x\n", result);
+		return result;
+	}
+	
+	gTotalFramesScheduled++;
+	
+	return result;
+}
+
+// Attach the frame's caption packet when it holds a CDP and detach it when it does not, so that a frame without
+// captions carries no empty caption distribution packet
+static HRESULT UpdateCaptionAttachment(CaptionFrame& captionFrame)
+{
+	HRESULT									result;
+	IDeckLinkVideoFrameAncillaryPackets*	frameAncillaryPackets = NULL;
+	bool									hasCDP = captionFrame.captionPacket->GetCDP()->size > 0;
+	
+	if (hasCDP == captionFrame.captionAttached)
+		return S_OK;
+	
+	result = captionFrame.videoFrame->QueryInterface(IID_IDeckLinkVideoFrameAncillaryPackets, (void**)&frameAncillaryPackets);
+	if (result != S_OK)
+	{
+		fprintf(stderr, "Could not get ancillary packet store = %08x\n", result);
+		return result;
+	}
+	
+	if (hasCDP)
+		result = frameAncillaryPackets->AttachPacket(captionFrame.captionPacket);
+	else
+		result = frameAncillaryPackets->DetachPacket(captionFrame.captionPacket);
+	
+	if (result == S_OK)
+		captionFrame.captionAttached = hasCDP;
+	else
+		fprintf(stderr, "Could not %s caption packet = %08x\n", hasCDP ? "attach" : "detach", result);
+	
+	frameAncillaryPackets->Release();
+	return result;
+}
+
+HRESULT ScheduleNextFrame(CEA708::Encoder& CC708Encoder, CaptionIngest* captionIngest, IDeckLinkOutput* deckLinkOutput, IDeckLinkVideoFrame* videoFrame)
+{
+	HRESULT										result;
+	CaptionFrame*								captionFrame = FindCaptionFrame(videoFrame);
+	CaptionAncillaryPacket*						captionPacket;
+	
+	if (captionFrame == NULL)
+	{
+		fprintf(stderr, "Could not find caption packet for frame\n");
+		return E_FAIL;
+	}
+	captionPacket = captionFrame->captionPacket;
+	
+	if (captionIngest != NULL)
+	{
+		// Captions from a file have one CDP for each frame, encoded ahead of the frame that needs it
+		captionIngest->encodeUntil(gTotalFramesScheduled + kCaptionLookaheadFrames);
+		if (!captionIngest->pop(gTotalFramesScheduled, captionPacket->GetCDP()))
+			captionPacket->GetCDP()->size = 0;
+		
+		result = UpdateCaptionAttachment(*captionFrame);
+		if (result != S_OK)
+			return result;
+		
+		return ScheduleCaptionFrame(deckLinkOutput, videoFrame);
+	}
 	
 	// Resend the given caption data every second.
 	unsigned fps = kTimeScale / kFrameDuration;
@@ -294,6 +436,25 @@ HRESULT ScheduleNextFrame(CEA708::Encoder& CC708Encoder, IDeckLinkOutput* deckLi
 		cc << EndOfText();
 		
 		cc << DisplayWindows(1 << window_0);
+		
+		// The same caption for CEA-608 decoders, at 2 characters per frame it is resent once the last one is sent
+		CEA608::Encoder& cc608 = cc.cea608();
+		if (cc608.empty(CEA608::field_1))
+		{
+			static const uint8_t	line1[] = "CEA-608 Closed Captions";
+			static const uint8_t	line2[] = "Second line of text!";
+			const uint8_t*			lines[] = { line1, line2 };
+			const uint8_t			lengths[] = { sizeof(line1) - 1, sizeof(line2) - 1 };
+			
+			cc608.loadPopOn(CEA608::channel_CC1, lines, lengths, 2);
+			cc608.control(CEA608::channel_CC1, CEA608::control_EndOfCaption);
+		}
+		if (cc608.empty(CEA608::field_2))
+		{
+			static const uint8_t	programName[] = "DeckLink Closed Captions";
+			cc608.xds(CEA608::xdsClass_Current, CEA608::xdsType_CurrentProgramName, programName, sizeof(programName) - 1);
+		}
+		
 		cc.flush();
 	}
 	
@@ -305,53 +466,16 @@ HRESULT ScheduleNextFrame(CEA708::Encoder& CC708Encoder, IDeckLinkOutput* deckLi
 		CC708Encoder.flush();
 	}
 	
-	if (CC708Encoder.pop(&packet))
-	{
-	
-		result = videoFrame->QueryInterface(IID_IDeckLinkVideoFrameAncillaryPackets, (void**)&frameAncillaryPackets);
-		if (result != S_OK)
-		{
-			fprintf(stderr, "Could not get ancillary packet store = %08x\n", result);
-			goto bail;
-		}
+	// We're recycling our frames via ScheduledFrameCompleted(), so the frame's caption packet is no longer in use and
+	// the next CDP can be written straight into it, replacing the last captions we sent
+	if (!CC708Encoder.pop(captionPacket->GetCDP()))
+		captionPacket->GetCDP()->size = 0;
 
-		// DeckLink won't remove any pre-existing packets from a frame or replace those with a similar DID/SDID
-		// We're recycling our frames via ScheduledFrameCompleted(), so ensure the last captions we added are removed
-		result = frameAncillaryPackets->GetFirstPacketByID(kCaptionDistributionPacketDID, kCaptionDistributionPacketSDID, &ancillaryPacket);
-		if (result == S_OK)
-		{
-			frameAncillaryPackets->DetachPacket(ancillaryPacket);
-			ancillaryPacket->Release();
-			ancillaryPacket = NULL;
-		}
-		
-		result = frameAncillaryPackets->AttachPacket(new CaptionAncillaryPacket(packet));
-		if (result != S_OK)
-		{
-			fprintf(stderr, "Could not attach packet = %08x\n", result);
-			goto bail;
-		}
-	}
-
-	// When a video frame completes,reschedule another frame
-	result = deckLinkOutput->ScheduleVideoFrame(videoFrame, gTotalFramesScheduled*kFrameDuration, kFrameDuration, kTimeScale);
+	result = UpdateCaptionAttachment(*captionFrame);
 	if (result != S_OK)
-	{
-		fprintf(stderr, "Could not schedule video frame = %08x\n", result);
-		goto bail;
-	}
-	
-	gTotalFramesScheduled++;
-	
-bail:
-	
-	if (frameAncillaryPackets != NULL)
-	{
-		frameAncillaryPackets->Release();
-		frameAncillaryPackets = NULL;
-	}
-	
-	return result;
+		return result;
+
+	return ScheduleCaptionFrame(deckLinkOutput, videoFrame);
 }
 
 HRESULT GetDeckLinkIterator(IDeckLinkIterator **deckLinkIterator)
@@ -369,7 +493,19 @@ HRESULT GetDeckLinkIterator(IDeckLinkIterator **deckLinkIterator)
 	return result;
 }
 
-int main()
+static void PrintUsage(const char* name)
+{
+	printf("%s [options]\n"
+		   "\n"
+		   "Options:\n"
+		   "    -h, --help                Display this help message\n"
+		   "    -f, --file <path>         Caption an SCC, SRT or WebVTT file instead of the fixed caption text\n"
+		   "    -s, --start <seconds>     Time in the caption file of the first frame (default 0)\n"
+		   "    -b, --benchmark <hours>   Ingest synthetic caption files of the given length and print the CDP\n"
+		   "                              encode rate, without a DeckLink device\n", name);
+}
+
+int main(int argc, const char* argv[])
 {
 	IDeckLinkIterator*      deckLinkIterator = NULL;
 	IDeckLink*              deckLink         = NULL;
@@ -377,6 +513,42 @@ int main()
 	OutputCallback*         outputCallback   = NULL;
 	CEA708::Encoder			CC708Encoder(kFrameDuration, kTimeScale);
 	HRESULT                 result;
+	const char*             captionFilePath  = NULL;
+	double                  captionStartTime = 0.0;
+	unsigned                benchmarkHours   = 0;
+	
+	for (int i = 1; i < argc; ++i)
+	{
+		if ((strcmp(argv[i], "--file") == 0 || strcmp(argv[i], "-f") == 0) && (i + 1 < argc))
+			captionFilePath = argv[++i];
+		else if ((strcmp(argv[i], "--start") == 0 || strcmp(argv[i], "-s") == 0) && (i + 1 < argc))
+			captionStartTime = strtod(argv[++i], NULL);
+		else if ((strcmp(argv[i], "--benchmark") == 0 || strcmp(argv[i], "-b") == 0) && (i + 1 < argc))
+			benchmarkHours = (unsigned)strtoul(argv[++i], NULL, 10);
+		else if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0)
+		{
+			PrintUsage(argv[0]);
+			return 0;
+		}
+		else
+		{
+			fprintf(stderr, "Unknown argument: %s\n", argv[i]);
+			PrintUsage(argv[0]);
+			return 1;
+		}
+	}
+	
+	if (benchmarkHours > 0)
+		return RunCaptionIngestBenchmark(benchmarkHours) ? 0 : 1;
+	
+	CaptionFileReader       captionReader;
+	CaptionIngest           captionIngest(CC708Encoder, captionReader, kFrameDuration, kTimeScale, (int64_t)(captionStartTime * CaptionCue::kTimeScale));
+	
+	if (captionFilePath != NULL && !captionReader.open(captionFilePath))
+	{
+		fprintf(stderr, "Could not open caption file %s\n", captionFilePath);
+		return 1;
+	}
 	
 	// Create an IDeckLinkIterator object to enumerate all DeckLink cards in the system
 	result = GetDeckLinkIterator(&deckLinkIterator);
@@ -410,7 +582,7 @@ int main()
 		goto bail;
 	}
 
-	outputCallback->onScheduledFrameCompleted([&](IDeckLinkVideoFrame* videoFrame) { ScheduleNextFrame(CC708Encoder, deckLinkOutput, videoFrame); });
+	outputCallback->onScheduledFrameCompleted([&](IDeckLinkVideoFrame* videoFrame) { ScheduleNextFrame(CC708Encoder, captionFilePath ? &captionIngest : NULL, deckLinkOutput, videoFrame); });
 	
 	// Set the callback object to the DeckLink device's output interface
 	result = deckLinkOutput->SetScheduledFrameCompletionCallback(outputCallback);
@@ -429,16 +601,16 @@ int main()
 	}
 	
 	// Schedule a blue frame 3 times
-	for (int i = 0; i < 3; i++)
+	for (uint32_t i = 0; i < kFramePoolSize; i++)
 	{
 		IDeckLinkVideoFrame*    videoFrameBlue   = NULL;
 		
-		// Create a frame with defined format
-		videoFrameBlue = CreateFrame(deckLinkOutput);
+		// Create a frame with defined format and a caption packet
+		videoFrameBlue = CreateFrame(deckLinkOutput, gCaptionFrames[i]);
 		if (!videoFrameBlue)
 			goto bail;
 		
-		result = ScheduleNextFrame(CC708Encoder, deckLinkOutput, videoFrameBlue);
+		result = ScheduleNextFrame(CC708Encoder, captionFilePath ? &captionIngest : NULL, deckLinkOutput, videoFrameBlue);
 		if (result != S_OK)
 		{
 			videoFrameBlue->Release();
@@ -446,7 +618,6 @@ int main()
 			fprintf(stderr, "Could not schedule video frame - result = %08x\n", result);
 			goto bail;
 		}
-		gTotalFramesScheduled ++;
 	}
 	
 	// Start
@@ -468,6 +639,15 @@ int main()
 	result = deckLinkOutput->StopScheduledPlayback(0, NULL, 0);
 
 	outputCallback->waitForPlaybackStopped();
+	
+	if (captionFilePath != NULL)
+	{
+		const CaptionIngest::Statistics& statistics = captionIngest.statistics();
+		printf("Captions: %llu cues read, %llu shown, %llu late (up to %lld frames), %llu dropped, %llu late in 608\n",
+			   (unsigned long long)statistics.cuesRead, (unsigned long long)statistics.cuesShown,
+			   (unsigned long long)statistics.cuesLate, (long long)statistics.maximumLateFrames,
+			   (unsigned long long)statistics.cuesDropped, (unsigned long long)statistics.cues608Late);
+	}
 
 	result = deckLinkOutput->SetScheduledFrameCompletionCallback(NULL);
 	
@@ -491,6 +671,16 @@ bail:
 		deckLink = NULL;
 	}
 	
+	// Release our references to the caption packets, the frames hold their own
+	for (auto& captionFrame : gCaptionFrames)
+	{
+		if (captionFrame.captionPacket != NULL)
+		{
+			captionFrame.captionPacket->Release();
+			captionFrame.captionPacket = NULL;
+		}
+	}
+	
 	// Release the outputCallback callback object
 	if (outputCallback != NULL)
 	{
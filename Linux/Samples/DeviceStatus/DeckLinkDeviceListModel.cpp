@@ -167,6 +167,8 @@ void DeckLinkDeviceListModel::addDevice(com_ptr<IDeckLink> device)
 	if (device->GetDisplayName(&deviceNameStr) != S_OK)
 		return;
 
+	emit deviceAdded(device);
+
 	beginInsertRows(QModelIndex(), index, index);
 	m_deviceList.push_back({ DlToQString(deviceNameStr), std::move(device) });
 	endInsertRows();
@@ -181,6 +183,7 @@ void DeckLinkDeviceListModel::removeDevice(com_ptr<IDeckLink> device)
 			beginRemoveRows(QModelIndex(), i, i);
 			m_deviceList.erase(m_deviceList.begin() + i);
 			endRemoveRows();
+			emit deviceRemoved(device);
 			break;
 		}
 	}
@@ -101,6 +101,11 @@ public:
 	QVariant								data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
 	QVariant								headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
 
+signals:
+	// Emitted before the device's row is inserted and after it is removed
+	void									deviceAdded(com_ptr<IDeckLink> deckLink);
+	void									deviceRemoved(com_ptr<IDeckLink> deckLink);
+
 private slots:
 	void									addDevice(com_ptr<IDeckLink> device);
 	void									removeDevice(com_ptr<IDeckLink> device);
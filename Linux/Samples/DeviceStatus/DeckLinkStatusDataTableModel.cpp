@@ -39,146 +39,161 @@
 */
 
 #include <QFont>
+#include <QStringList>
+#include <algorithm>
 #include "DeckLinkStatusDataTableModel.h"
 
-using namespace std::placeholders;
+enum class StatusFormat : int
+{
+	Flag,
+	Int,
+	Bytes,
+	PanelType,
+	Busy,
+	VideoInputMode,
+	VideoOutputMode,
+	PixelFormat,
+	VideoFlags,
+	DetectedVideoInputFormatFlags,
+	DynamicRange,
+	FieldDominance,
+	Colorspace,
+	LinkConfiguration,
+};
 
-using GetStatusDataFunc = std::function<QString(com_ptr<IDeckLinkStatus>&)>;
+using StatusFlagNames = std::vector<std::pair<int64_t, const char*>>;
 
-// Map of status IDs against getter function and display name
-static const std::map<BMDDeckLinkStatusID, std::pair<GetStatusDataFunc, QString>> kStatusItems =
+static const StatusFlagNames kBusyStateNames =
 {
-	{ bmdDeckLinkStatusDetectedVideoInputMode,				std::make_pair(std::bind(getStatusVideoInputMode, _1, bmdDeckLinkStatusDetectedVideoInputMode),				"Detected video input display mode") },
-	{ bmdDeckLinkStatusDetectedVideoInputFormatFlags,		std::make_pair(getStatusDetectedVideoInputFormatFlags,														"Detected video input format flags") },
-	{ bmdDeckLinkStatusDetectedVideoInputFieldDominance,	std::make_pair(std::bind(getStatusFieldDominance, _1, bmdDeckLinkStatusDetectedVideoInputFieldDominance),	"Detected video input field dominance") },
-	{ bmdDeckLinkStatusDetectedVideoInputColorspace,		std::make_pair(std::bind(getStatusColorspace, _1, bmdDeckLinkStatusDetectedVideoInputColorspace),			"Detected video input colorspace") },
-	{ bmdDeckLinkStatusDetectedVideoInputDynamicRange,		std::make_pair(std::bind(getStatusDynamicRange, _1, bmdDeckLinkStatusDetectedVideoInputDynamicRange),		"Detected video input dynamic range") },
-	{ bmdDeckLinkStatusDetectedSDILinkConfiguration,		std::make_pair(std::bind(getStatusLinkConfiguration, _1, bmdDeckLinkStatusDetectedSDILinkConfiguration),	"Detected SDI video input link width") },
-	{ bmdDeckLinkStatusCurrentVideoInputMode,				std::make_pair(std::bind(getStatusVideoInputMode, _1, bmdDeckLinkStatusCurrentVideoInputMode),				"Video input display mode") },
-	{ bmdDeckLinkStatusCurrentVideoInputPixelFormat,		std::make_pair(std::bind(getStatusPixelFormat, _1, bmdDeckLinkStatusCurrentVideoInputPixelFormat),			"Video input pixel format") },
-	{ bmdDeckLinkStatusCurrentVideoInputFlags,				std::make_pair(std::bind(getStatusVideoFlags, _1, bmdDeckLinkStatusCurrentVideoInputFlags),					"Video input flags") },
-	{ bmdDeckLinkStatusCurrentVideoOutputMode,				std::make_pair(std::bind(getStatusVideoOutputMode, _1, bmdDeckLinkStatusCurrentVideoOutputMode),			"Video output display mode") },
-	{ bmdDeckLinkStatusCurrentVideoOutputFlags,				std::make_pair(std::bind(getStatusVideoFlags, _1, bmdDeckLinkStatusCurrentVideoOutputFlags),				"Video output flags") },
-	{ bmdDeckLinkStatusPCIExpressLinkWidth,					std::make_pair(std::bind(getStatusInt, _1, bmdDeckLinkStatusPCIExpressLinkWidth),							"PCIe link width") },
-	{ bmdDeckLinkStatusPCIExpressLinkSpeed,					std::make_pair(std::bind(getStatusInt, _1, bmdDeckLinkStatusPCIExpressLinkSpeed),							"PCIe link speed") },
-	{ bmdDeckLinkStatusLastVideoOutputPixelFormat,			std::make_pair(std::bind(getStatusPixelFormat, _1, bmdDeckLinkStatusLastVideoOutputPixelFormat),			"Video output pixel format") },
-	{ bmdDeckLinkStatusReferenceSignalMode,					std::make_pair(std::bind(getStatusVideoOutputMode, _1, bmdDeckLinkStatusReferenceSignalMode),				"Detected reference video mode") },
-	{ bmdDeckLinkStatusBusy,								std::make_pair(getStatusBusy,																				"Busy state") },
-	{ bmdDeckLinkStatusVideoInputSignalLocked,				std::make_pair(std::bind(getStatusFlag, _1, bmdDeckLinkStatusVideoInputSignalLocked),						"Video input locked") },
-	{ bmdDeckLinkStatusReferenceSignalLocked,				std::make_pair(std::bind(getStatusFlag, _1, bmdDeckLinkStatusReferenceSignalLocked),						"Reference input locked") },
-	{ bmdDeckLinkStatusReferenceSignalFlags,				std::make_pair(std::bind(getStatusVideoFlags, _1, bmdDeckLinkStatusReferenceSignalFlags),					"Reference input video flags") },
-	{ bmdDeckLinkStatusInterchangeablePanelType,			std::make_pair(getStatusPanelType,																			"Panel Installed") },
-	{ bmdDeckLinkStatusReceivedEDID,						std::make_pair(std::bind(getStatusBytes, _1, bmdDeckLinkStatusReceivedEDID),								"Received EDID of connected HDMI sink") },
-	{ bmdDeckLinkStatusDeviceTemperature,					std::make_pair(std::bind(getStatusInt, _1, bmdDeckLinkStatusDeviceTemperature),								"On-board temperature (°C)") },
+	{ bmdDeviceCaptureBusy,				"Capture active" },
+	{ bmdDevicePlaybackBusy,			"Playback active" },
+	{ bmdDeviceSerialPortBusy,			"Serial port active" },
 };
 
-DeckLinkNotificationCallback::DeckLinkNotificationCallback() :
-	m_refCount(1)
+static const StatusFlagNames kVideoStatusFlagNames =
 {
-}
+	{ bmdDeckLinkVideoStatusPsF,			"Progressive frames are PsF" },
+	{ bmdDeckLinkVideoStatusDualStream3D,	"Dual-stream 3D video" },
+};
 
-// IUnknown methods
+static const StatusFlagNames kDetectedVideoInputFormatFlagNames =
+{
+	{ bmdDetectedVideoInputYCbCr422,		"YCbCr 4:2:2" },
+	{ bmdDetectedVideoInputRGB444,			"RGB 4:4:4" },
+	{ bmdDetectedVideoInputDualStream3D,	"Dual-stream 3D" },
+	{ bmdDetectedVideoInput12BitDepth,		"12-bit depth" },
+	{ bmdDetectedVideoInput10BitDepth,		"10-bit depth" },
+	{ bmdDetectedVideoInput8BitDepth,		"8-bit depth" },
+};
 
-HRESULT DeckLinkNotificationCallback::QueryInterface(REFIID iid, LPVOID *ppv)
+static StatusFormat getStatusFormat(const StatusItemInfo& itemInfo)
 {
-	HRESULT result = S_OK;
+	switch (itemInfo.id)
+	{
+		case bmdDeckLinkStatusDetectedVideoInputMode:
+		case bmdDeckLinkStatusCurrentVideoInputMode:
+			return StatusFormat::VideoInputMode;
 
-	if (ppv == nullptr)
-		return E_POINTER;
+		case bmdDeckLinkStatusCurrentVideoOutputMode:
+		case bmdDeckLinkStatusReferenceSignalMode:
+			return StatusFormat::VideoOutputMode;
 
-	// Obtain the IUnknown interface and compare it the provided REFIID
-	if (iid == IID_IUnknown)
-	{
-		*ppv = this;
-		AddRef();
-	}
-	else if (iid == IID_IDeckLinkNotificationCallback)
-	{
-		*ppv = static_cast<IDeckLinkNotificationCallback*>(this);
-		AddRef();
-	}
-	else
-	{
-		*ppv = nullptr;
-		result = E_NOINTERFACE;
-	}
+		case bmdDeckLinkStatusCurrentVideoInputPixelFormat:
+		case bmdDeckLinkStatusLastVideoOutputPixelFormat:
+			return StatusFormat::PixelFormat;
 
-	return result;
-}
+		case bmdDeckLinkStatusCurrentVideoInputFlags:
+		case bmdDeckLinkStatusCurrentVideoOutputFlags:
+		case bmdDeckLinkStatusReferenceSignalFlags:
+			return StatusFormat::VideoFlags;
 
-ULONG DeckLinkNotificationCallback::AddRef()
-{
-	return ++m_refCount;
-}
+		case bmdDeckLinkStatusDetectedVideoInputFormatFlags:
+			return StatusFormat::DetectedVideoInputFormatFlags;
 
-ULONG DeckLinkNotificationCallback::Release()
-{
-	ULONG newRefValue = --m_refCount;
-	if (newRefValue == 0)
-		delete this;
+		case bmdDeckLinkStatusDetectedVideoInputFieldDominance:
+			return StatusFormat::FieldDominance;
 
-	return newRefValue;
-}
+		case bmdDeckLinkStatusDetectedVideoInputColorspace:
+			return StatusFormat::Colorspace;
 
-// IDeckLinkNotificationCallback
+		case bmdDeckLinkStatusDetectedVideoInputDynamicRange:
+			return StatusFormat::DynamicRange;
 
-HRESULT DeckLinkNotificationCallback::Notify(BMDNotifications topic, uint64_t param1, uint64_t /*param2*/)
-{
-	if (topic == bmdStatusChanged)
-		emit statusChanged(static_cast<BMDDeckLinkStatusID>(param1));
+		case bmdDeckLinkStatusDetectedSDILinkConfiguration:
+			return StatusFormat::LinkConfiguration;
+
+		case bmdDeckLinkStatusBusy:
+			return StatusFormat::Busy;
 
-	else if (topic == bmdPreferencesChanged)
-		emit preferencesChanged();
+		case bmdDeckLinkStatusInterchangeablePanelType:
+			return StatusFormat::PanelType;
 
-	return S_OK;
+		default:
+			break;
+	}
+
+	switch (itemInfo.type)
+	{
+		case StatusValueType::Flag:
+			return StatusFormat::Flag;
+
+		case StatusValueType::Bytes:
+			return StatusFormat::Bytes;
+
+		default:
+			return StatusFormat::Int;
+	}
 }
 
-DeckLinkStatusDataTableModel::DeckLinkStatusDataTableModel(QObject* parent) :
-	QAbstractTableModel(parent)
+DeckLinkStatusDataTableModel::DeckLinkStatusDataTableModel(QObject* parent, DeckLinkStatusStore& statusStore) :
+	QAbstractTableModel(parent),
+	m_statusStore(statusStore),
+	m_deviceID(DeckLinkStatusStore::kInvalidDevice)
 {
-	m_delegate = make_com_ptr<DeckLinkNotificationCallback>();
+	m_itemRows.fill(-1);
+
+	connect(this, &DeckLinkStatusDataTableModel::statusChanged, this, &DeckLinkStatusDataTableModel::updateItem, Qt::QueuedConnection);
 
-	connect(m_delegate.get(), &DeckLinkNotificationCallback::statusChanged, this, &DeckLinkStatusDataTableModel::statusChanged, Qt::QueuedConnection);
+	m_statusStore.setChangeCallback([this](DeckLinkStatusStore::DeviceID deviceID, int item) {
+		emit statusChanged(deviceID, item);
+	});
 }
 
-IDeckLinkNotificationCallback* DeckLinkStatusDataTableModel::delegate()
+DeckLinkStatusDataTableModel::~DeckLinkStatusDataTableModel()
 {
-	return m_delegate.get();
+	// The store may outlive the model, stop notifications and wait for any in flight before the model goes away
+	m_statusStore.setChangeCallback(nullptr);
 }
 
-void DeckLinkStatusDataTableModel::reset(com_ptr<IDeckLink>& deckLink)
+void DeckLinkStatusDataTableModel::setDevice(DeckLinkStatusStore::DeviceID deviceID)
 {
-	// Called whenever new device is selected
+	// Called whenever new device is selected, the store already holds its values
 	beginResetModel();
-	m_statusData.clear();
 
-	m_deckLinkStatus = com_ptr<IDeckLinkStatus>(IID_IDeckLinkStatus, deckLink);
-	if (!m_deckLinkStatus)
-	{
-		endResetModel();
-		return;
-	}
+	m_deviceID = deviceID;
+	m_deckLink = m_statusStore.getDevice(deviceID);
+	m_rowItems.clear();
+	m_itemRows.fill(-1);
+	m_valueTextValid.reset();
 
-	// Scan all status IDs and fill any non-empty data values
-	for (auto& item : kStatusItems)
+	for (int item = 0; item < kStatusItemCount; item++)
 	{
-		GetStatusDataFunc	getStatusDataFunc;
-		QString				statusData;
-		std::tie(getStatusDataFunc, std::ignore) = item.second;
+		StatusValue value;
 
-		statusData = getStatusDataFunc(m_deckLinkStatus);
-		if (!statusData.isEmpty())
-			m_statusData.push_back(std::make_pair(item.first, statusData));
+		if (m_statusStore.getValue(deviceID, item, &value) && isStatusValueShown(DeckLinkStatusStore::getItem(item), value))
+		{
+			m_itemRows[item] = static_cast<int>(m_rowItems.size());
+			m_rowItems.push_back(item);
+		}
 	}
 
 	endResetModel();
 }
 
-
 int DeckLinkStatusDataTableModel::rowCount(const QModelIndex& parent) const
 {
 	Q_UNUSED(parent)
-	return static_cast<int>(m_statusData.size());
+	return static_cast<int>(m_rowItems.size());
 }
 
 int DeckLinkStatusDataTableModel::columnCount(const QModelIndex& parent) const
@@ -189,29 +204,31 @@ int DeckLinkStatusDataTableModel::columnCount(const QModelIndex& parent) const
 
 QVariant DeckLinkStatusDataTableModel::data(const QModelIndex& index, int role) const
 {
-	if (role == Qt::DisplayRole)
+	if ((role != Qt::DisplayRole) || (index.row() < 0) || (index.row() >= static_cast<int>(m_rowItems.size())))
+		return QVariant();
+
+	int						item = m_rowItems[index.row()];
+	const StatusItemInfo&	itemInfo = DeckLinkStatusStore::getItem(item);
+
+	if (index.column() == static_cast<int>(StatusDataTableHeader::Item))
+		return QString::fromUtf8(itemInfo.name);
+
+	if (index.column() == static_cast<int>(StatusDataTableHeader::Value))
 	{
-		int rowIndex = 0;
-		for (auto iter = m_statusData.begin(); iter != m_statusData.end(); ++iter)
+		// Format on first paint after the value changes
+		if (!m_valueTextValid[item])
 		{
-			if (rowIndex++ == index.row())
-			{
-				if (index.column() == static_cast<int>(StatusDataTableHeader::Item))
-				{
-					auto search = kStatusItems.find(iter->first);
-					if (search != kStatusItems.end())
-					{
-						QString statusIDName;
-						std::tie(std::ignore, statusIDName) = search->second;
-						return statusIDName;
-					}
-				}
-				else if (index.column() == static_cast<int>(StatusDataTableHeader::Value))
-				{
-					return iter->second;
-				}
-			}
+			StatusValue value;
+
+			if (m_statusStore.getValue(m_deviceID, item, &value))
+				m_valueText[item] = formatStatusValue(m_deckLink, itemInfo, value);
+			else
+				m_valueText[item].clear();
+
+			m_valueTextValid[item] = true;
 		}
+
+		return m_valueText[item];
 	}
 
 	return QVariant();
@@ -239,102 +256,80 @@ QVariant DeckLinkStatusDataTableModel::headerData(int section, Qt::Orientation o
 	return QVariant();
 }
 
-void DeckLinkStatusDataTableModel::statusChanged(BMDDeckLinkStatusID statusID)
+void DeckLinkStatusDataTableModel::updateItem(DeckLinkStatusStore::DeviceID deviceID, int item)
 {
-	GetStatusDataFunc	getStatusDataFunc;
-	QString				statusData;
+	StatusValue	value;
+	bool		shown;
+	int			row = m_itemRows[item];
 
-	// Get updated status value
-	auto search = kStatusItems.find(statusID);
-	if (search == kStatusItems.end())
+	// Other devices are kept up to date by the store, and read when selected
+	if (deviceID != m_deviceID)
 		return;
 
-	std::tie(getStatusDataFunc, std::ignore) = search->second;
-	statusData = getStatusDataFunc(m_deckLinkStatus);
-
-	// Check if status ID was already valid.
-	auto iter = std::find_if(m_statusData.begin(), m_statusData.end(),
-		[&statusID](const std::pair<BMDDeckLinkStatusID, QString> statusItem) { return statusItem.first == statusID; });
+	shown = m_statusStore.getValue(deviceID, item, &value) && isStatusValueShown(DeckLinkStatusStore::getItem(item), value);
+	m_valueTextValid[item] = false;
 
-	if (iter != m_statusData.end())
+	if ((row >= 0) && shown)
 	{
-		// Status ID is existing, get index
-		int statusDataIndex = std::distance(m_statusData.begin(), iter);
-
-		if (statusData.isEmpty())
-		{
-			// Status data has become invalid, remove from vector
-			beginRemoveRows(QModelIndex(), statusDataIndex, statusDataIndex);
-			m_statusData.erase(iter);
-			endRemoveRows();
-		}
-		else
-		{
-			// Update stored status data in vector
-			iter->second = statusData;
-			emit dataChanged(index(statusDataIndex, static_cast<int>(StatusDataTableHeader::Value)), index(statusDataIndex, static_cast<int>(StatusDataTableHeader::Value)));
-		}
+		// Update shown value
+		QModelIndex valueIndex = index(row, static_cast<int>(StatusDataTableHeader::Value));
+		emit dataChanged(valueIndex, valueIndex);
+	}
+	else if (row >= 0)
+	{
+		// Status data has become invalid, remove row
+		beginRemoveRows(QModelIndex(), row, row);
+		m_rowItems.erase(m_rowItems.begin() + row);
+		m_itemRows[item] = -1;
+		updateItemRows(row);
+		endRemoveRows();
 	}
-	else if (!statusData.isEmpty())
+	else if (shown)
 	{
-		// New status ID data, add new row to vector
-		beginInsertRows(QModelIndex(), m_statusData.size(), m_statusData.size());
-		m_statusData.push_back(std::make_pair(statusID, statusData));
+		// New status data, insert row in item order
+		row = static_cast<int>(std::lower_bound(m_rowItems.begin(), m_rowItems.end(), item) - m_rowItems.begin());
+
+		beginInsertRows(QModelIndex(), row, row);
+		m_rowItems.insert(m_rowItems.begin() + row, item);
+		updateItemRows(row);
 		endInsertRows();
 	}
 }
 
-// Status data getter functions
-
-QString getStatusFlag(com_ptr<IDeckLinkStatus>& deckLinkStatus, const BMDDeckLinkStatusID id)
+void DeckLinkStatusDataTableModel::updateItemRows(int firstRow)
 {
-	dlbool_t statusFlag;
-
-	if (deckLinkStatus->GetFlag(id, &statusFlag) != S_OK)
-		return QString();
-
-	return statusFlag ? "Yes" : "No";
+	for (int row = firstRow; row < static_cast<int>(m_rowItems.size()); row++)
+		m_itemRows[m_rowItems[row]] = row;
 }
 
-QString getStatusBytes(com_ptr<IDeckLinkStatus>& deckLinkStatus, const BMDDeckLinkStatusID id)
-{
-	uint32_t				bytesSize = 0;
-	std::vector<uint8_t>	bytes;
-	QStringList				bytesStringList;
-
-	// Get required size of buffer
-	if (deckLinkStatus->GetBytes(id, nullptr, &bytesSize) != S_OK)
-		return QString();
-
-	bytes.resize(bytesSize);
+// Status value formatting functions
 
-	if (deckLinkStatus->GetBytes(id, bytes.data(), &bytesSize) != S_OK)
-		return QString();
-
-	// Convert each byte to QStringList to display as hex
-	for (auto byte : bytes)
-		bytesStringList << QString("%1").arg(byte, 2, 16, QChar('0'));
+static bool hasFlagNames(int64_t statusInt, const StatusFlagNames& flagNames)
+{
+	for (auto& flagName : flagNames)
+	{
+		if (statusInt & flagName.first)
+			return true;
+	}
 
-	return bytesStringList.join(" ");
+	return false;
 }
 
-QString getStatusInt(com_ptr<IDeckLinkStatus>& deckLinkStatus, const BMDDeckLinkStatusID id)
+static QString getFlagNames(int64_t statusInt, const StatusFlagNames& flagNames)
 {
-	int64_t statusInt;
+	QStringList flagStringList;
 
-	if (deckLinkStatus->GetInt(id, &statusInt) != S_OK)
-		return QString();
+	for (auto& flagName : flagNames)
+	{
+		if (statusInt & flagName.first)
+			flagStringList << flagName.second;
+	}
 
-	return QString::number(statusInt);
+	return flagStringList.join("\n");
 }
 
-QString getStatusPanelType(com_ptr<IDeckLinkStatus>& deckLinkStatus)
+static const char* getPanelTypeName(int64_t statusInt)
 {
-	int64_t statusInt;
-
-	if (deckLinkStatus->GetInt(bmdDeckLinkStatusInterchangeablePanelType, &statusInt) != S_OK)
-		return QString();
-
 	switch ((BMDPanelType)statusInt)
 	{
 		case bmdPanelNotDetected:
@@ -344,65 +339,12 @@ QString getStatusPanelType(com_ptr<IDeckLinkStatus>& deckLinkStatus)
 			return "Teranex Mini panel detected";
 
 		default:
-			return QString();
+			return nullptr;
 	}
 }
 
-QString getStatusBusy(com_ptr<IDeckLinkStatus>& deckLinkStatus)
-{
-	QStringList busyStringList;
-	int64_t statusInt;
-
-	if (deckLinkStatus->GetInt(bmdDeckLinkStatusBusy, &statusInt) != S_OK)
-		return QString();
-
-	if ((BMDDeviceBusyState)statusInt & bmdDeviceCaptureBusy)
-		busyStringList << "Capture active";
-
-	if ((BMDDeviceBusyState)statusInt & bmdDevicePlaybackBusy)
-		busyStringList << "Playback active";
-
-	if ((BMDDeviceBusyState)statusInt & bmdDeviceSerialPortBusy)
-		busyStringList << "Serial port active";
-
-	return busyStringList.size() ? busyStringList.join("\n") : "Inactive";
-}
-
-QString getStatusVideoOutputMode(com_ptr<IDeckLinkStatus>& deckLinkStatus, const BMDDeckLinkStatusID id)
+static const char* getPixelFormatName(int64_t statusInt)
 {
-	int64_t							statusInt;
-	com_ptr<IDeckLinkOutput>		deckLinkOutput(IID_IDeckLinkOutput, deckLinkStatus);
-	com_ptr<IDeckLinkDisplayMode>	displayMode;
-	dlstring_t						displayModeName;
-	QString							displayModeString;
-
-	if (!deckLinkOutput)
-		return QString();
-
-	if (deckLinkStatus->GetInt(id, &statusInt) != S_OK)
-		return QString();
-
-	if ((BMDDisplayMode)statusInt == bmdModeUnknown)
-		return QString();
-
-	if (deckLinkOutput->GetDisplayMode((BMDDisplayMode)statusInt, displayMode.releaseAndGetAddressOf()) != S_OK)
-		return QString();
-
-	if (displayMode->GetName(&displayModeName) != S_OK)
-		return QString();
-
-	displayModeString = DlToQString(displayModeName);
-	DeleteString(displayModeName);
-	return displayModeString;
-}
-
-QString getStatusPixelFormat(com_ptr<IDeckLinkStatus>& deckLinkStatus, const BMDDeckLinkStatusID id)
-{
-	int64_t statusInt;
-
-	if (deckLinkStatus->GetInt(id, &statusInt) != S_OK)
-		return QString();
-
 	switch ((BMDPixelFormat)statusInt)
 	{
 		case bmdFormat8BitYUV:
@@ -439,74 +381,97 @@ QString getStatusPixelFormat(com_ptr<IDeckLinkStatus>& deckLinkStatus, const BMD
 			return "DNxHR Encoded Video Data";
 
 		default:
-			return QString();
+			return nullptr;
 	}
 }
 
-QString getStatusVideoFlags(com_ptr<IDeckLinkStatus>& deckLinkStatus, const BMDDeckLinkStatusID id)
+static const char* getDynamicRangeName(int64_t statusInt)
 {
-	QStringList busyStringList;
-	int64_t statusInt;
-
-	if (deckLinkStatus->GetInt(id, &statusInt) != S_OK)
-		return QString();
+	switch ((BMDDynamicRange)statusInt)
+	{
+		case bmdDynamicRangeSDR:
+			return "SDR";
 
-	if ((BMDDeckLinkVideoStatusFlags)statusInt & bmdDeckLinkVideoStatusPsF)
-		busyStringList << "Progressive frames are PsF";
+		case bmdDynamicRangeHDRStaticPQ:
+			return "PQ (ST 2084)";
 
-	if ((BMDDeckLinkVideoStatusFlags)statusInt & bmdDeckLinkVideoStatusDualStream3D)
-		busyStringList << "Dual-stream 3D video";
+		case bmdDynamicRangeHDRStaticHLG:
+			return "HLG";
 
-	return busyStringList.join("\n");
+		default:
+			return nullptr;
+	}
 }
 
-QString getStatusDetectedVideoInputFormatFlags(com_ptr<IDeckLinkStatus>& deckLinkStatus)
+static const char* getFieldDominanceName(int64_t statusInt)
 {
-	QStringList busyStringList;
-	int64_t statusInt;
+	switch ((BMDFieldDominance)statusInt)
+	{
+		case bmdUpperFieldFirst:
+			return "Upper field first";
 
-	if (deckLinkStatus->GetInt(bmdDeckLinkStatusDetectedVideoInputFormatFlags, &statusInt) != S_OK)
-		return QString();
+		case bmdLowerFieldFirst:
+			return "Lower field first";
 
-	if ((BMDDetectedVideoInputFormatFlags)statusInt & bmdDetectedVideoInputYCbCr422)
-		busyStringList << "YCbCr 4:2:2";
+		case bmdProgressiveFrame:
+			return "Progressive frame";
 
-	if ((BMDDetectedVideoInputFormatFlags)statusInt & bmdDetectedVideoInputRGB444)
-		busyStringList << "RGB 4:4:4";
+		case bmdProgressiveSegmentedFrame:
+			return "Progressive segmented frame";
 
-	if ((BMDDetectedVideoInputFormatFlags)statusInt & bmdDetectedVideoInputDualStream3D)
-		busyStringList << "Dual-stream 3D";
+		default:
+			return nullptr;
+	}
+}
 
-	if ((BMDDetectedVideoInputFormatFlags)statusInt & bmdDetectedVideoInput12BitDepth)
-		busyStringList << "12-bit depth";
+static const char* getColorspaceName(int64_t statusInt)
+{
+	switch ((BMDColorspace)statusInt)
+	{
+		case bmdColorspaceRec601:
+			return "Rec.601";
+
+		case bmdColorspaceRec709:
+			return "Rec.709";
+
+		case bmdColorspaceRec2020:
+			return "Rec.2020";
+
+		default:
+			return nullptr;
+	}
+}
+
+static const char* getLinkConfigurationName(int64_t statusInt)
+{
+	switch ((BMDLinkConfiguration)statusInt)
+	{
+		case bmdLinkConfigurationSingleLink:
+			return "Single-link";
 
-	if ((BMDDetectedVideoInputFormatFlags)statusInt & bmdDetectedVideoInput10BitDepth)
-		busyStringList << "10-bit depth";
+		case bmdLinkConfigurationDualLink:
+			return "Dual-link";
 
-	if ((BMDDetectedVideoInputFormatFlags)statusInt & bmdDetectedVideoInput8BitDepth)
-		busyStringList << "8-bit depth";
+		case bmdLinkConfigurationQuadLink:
+			return "Quad-link";
 
-	return busyStringList.join("\n");
+		default:
+			return nullptr;
+	}
 }
 
-QString getStatusVideoInputMode(com_ptr<IDeckLinkStatus>& deckLinkStatus, const BMDDeckLinkStatusID id)
+template<typename T>
+static QString getDisplayModeName(const com_ptr<IDeckLink>& deckLink, REFIID iid, int64_t statusInt)
 {
-	int64_t							statusInt;
-	com_ptr<IDeckLinkInput>			deckLinkInput(IID_IDeckLinkInput, deckLinkStatus);
+	com_ptr<T>						deckLinkIO(iid, deckLink);
 	com_ptr<IDeckLinkDisplayMode>	displayMode;
 	dlstring_t						displayModeName;
 	QString							displayModeString;
 
-	if (!deckLinkInput)
-		return QString();
-
-	if (deckLinkStatus->GetInt(id, &statusInt) != S_OK)
+	if (!deckLinkIO)
 		return QString();
 
-	if ((BMDDisplayMode)statusInt == bmdModeUnknown)
-		return QString();
-
-	if (deckLinkInput->GetDisplayMode((BMDDisplayMode)statusInt, displayMode.releaseAndGetAddressOf()) != S_OK)
+	if (deckLinkIO->GetDisplayMode((BMDDisplayMode)statusInt, displayMode.releaseAndGetAddressOf()) != S_OK)
 		return QString();
 
 	if (displayMode->GetName(&displayModeName) != S_OK)
@@ -517,97 +482,103 @@ QString getStatusVideoInputMode(com_ptr<IDeckLinkStatus>& deckLinkStatus, const
 	return displayModeString;
 }
 
-QString getStatusDynamicRange(com_ptr<IDeckLinkStatus>& deckLinkStatus, const BMDDeckLinkStatusID id)
+bool isStatusValueShown(const StatusItemInfo& itemInfo, const StatusValue& value)
 {
-	int64_t statusInt;
-
-	if (deckLinkStatus->GetInt(id, &statusInt) != S_OK)
-		return QString();
+	if (!value.valid)
+		return false;
 
-	switch ((BMDDynamicRange)statusInt)
+	switch (getStatusFormat(itemInfo))
 	{
-		case bmdDynamicRangeSDR:
-			return "SDR";
+		case StatusFormat::Bytes:
+			return !value.bytes.empty();
 
-		case bmdDynamicRangeHDRStaticPQ:
-			return "PQ (ST 2084)";
+		case StatusFormat::PanelType:
+			return getPanelTypeName(value.intValue) != nullptr;
 
-		case bmdDynamicRangeHDRStaticHLG:
-			return "HLG";
+		case StatusFormat::VideoInputMode:
+		case StatusFormat::VideoOutputMode:
+			return (BMDDisplayMode)value.intValue != bmdModeUnknown;
 
-		default:
-			return QString();
-	}
-}
+		case StatusFormat::PixelFormat:
+			return getPixelFormatName(value.intValue) != nullptr;
 
-QString getStatusFieldDominance(com_ptr<IDeckLinkStatus>& deckLinkStatus, const BMDDeckLinkStatusID id)
-{
-	int64_t statusInt;
+		case StatusFormat::VideoFlags:
+			return hasFlagNames(value.intValue, kVideoStatusFlagNames);
 
-	if (deckLinkStatus->GetInt(id, &statusInt) != S_OK)
-		return QString();
+		case StatusFormat::DetectedVideoInputFormatFlags:
+			return hasFlagNames(value.intValue, kDetectedVideoInputFormatFlagNames);
 
-	switch ((BMDFieldDominance)statusInt)
-	{
-		case bmdUpperFieldFirst:
-			return "Upper field first";
+		case StatusFormat::DynamicRange:
+			return getDynamicRangeName(value.intValue) != nullptr;
 
-		case bmdLowerFieldFirst:
-			return "Lower field first";
+		case StatusFormat::FieldDominance:
+			return getFieldDominanceName(value.intValue) != nullptr;
 
-		case bmdProgressiveFrame:
-			return "Progressive frame";
+		case StatusFormat::Colorspace:
+			return getColorspaceName(value.intValue) != nullptr;
 
-		case bmdProgressiveSegmentedFrame:
-			return "Progressive segmented frame";
+		case StatusFormat::LinkConfiguration:
+			return getLinkConfigurationName(value.intValue) != nullptr;
 
 		default:
-			return QString();
+			return true;
 	}
 }
 
-QString getStatusColorspace(com_ptr<IDeckLinkStatus>& deckLinkStatus, const BMDDeckLinkStatusID id)
+QString formatStatusValue(const com_ptr<IDeckLink>& deckLink, const StatusItemInfo& itemInfo, const StatusValue& value)
 {
-	int64_t statusInt;
+	QStringList bytesStringList;
 
-	if (deckLinkStatus->GetInt(id, &statusInt) != S_OK)
+	if (!value.valid)
 		return QString();
 
-	switch ((BMDColorspace)statusInt)
+	switch (getStatusFormat(itemInfo))
 	{
-		case bmdColorspaceRec601:
-			return "Rec.601";
+		case StatusFormat::Flag:
+			return value.intValue ? "Yes" : "No";
 
-		case bmdColorspaceRec709:
-			return "Rec.709";
+		case StatusFormat::Int:
+			return QString::number(value.intValue);
 
-		case bmdColorspaceRec2020:
-			return "Rec.2020";
+		case StatusFormat::Bytes:
+			// Convert each byte to QStringList to display as hex
+			for (auto byte : value.bytes)
+				bytesStringList << QString("%1").arg(byte, 2, 16, QChar('0'));
+			return bytesStringList.join(" ");
 
-		default:
-			return QString();
-	}
-}
+		case StatusFormat::PanelType:
+			return getPanelTypeName(value.intValue);
 
-QString getStatusLinkConfiguration(com_ptr<IDeckLinkStatus>& deckLinkStatus, const BMDDeckLinkStatusID id)
-{
-	int64_t statusInt;
+		case StatusFormat::Busy:
+			return hasFlagNames(value.intValue, kBusyStateNames) ? getFlagNames(value.intValue, kBusyStateNames) : "Inactive";
 
-	if (deckLinkStatus->GetInt(id, &statusInt) != S_OK)
-		return QString();
+		case StatusFormat::VideoInputMode:
+			return getDisplayModeName<IDeckLinkInput>(deckLink, IID_IDeckLinkInput, value.intValue);
 
-	switch ((BMDLinkConfiguration)statusInt)
-	{
-		case bmdLinkConfigurationSingleLink:
-			return "Single-link";
+		case StatusFormat::VideoOutputMode:
+			return getDisplayModeName<IDeckLinkOutput>(deckLink, IID_IDeckLinkOutput, value.intValue);
 
-		case bmdLinkConfigurationDualLink:
-			return "Dual-link";
+		case StatusFormat::PixelFormat:
+			return getPixelFormatName(value.intValue);
 
-		case bmdLinkConfigurationQuadLink:
-			return "Quad-link";
+		case StatusFormat::VideoFlags:
+			return getFlagNames(value.intValue, kVideoStatusFlagNames);
 
-		default:
-			return QString();
+		case StatusFormat::DetectedVideoInputFormatFlags:
+			return getFlagNames(value.intValue, kDetectedVideoInputFormatFlagNames);
+
+		case StatusFormat::DynamicRange:
+			return getDynamicRangeName(value.intValue);
+
+		case StatusFormat::FieldDominance:
+			return getFieldDominanceName(value.intValue);
+
+		case StatusFormat::Colorspace:
+			return getColorspaceName(value.intValue);
+
+		case StatusFormat::LinkConfiguration:
+			return getLinkConfigurationName(value.intValue);
 	}
+
+	return QString();
 }
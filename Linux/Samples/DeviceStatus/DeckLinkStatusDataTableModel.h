@@ -42,48 +42,28 @@
 
 #include <QAbstractTableModel>
 
-#include <atomic>
+#include <array>
+#include <bitset>
 #include <vector>
 
 #include "com_ptr.h"
 #include "platform.h"
 #include "DeckLinkAPI.h"
-
-class DeckLinkNotificationCallback : public QObject, public IDeckLinkNotificationCallback
-{
-	Q_OBJECT
-
-public:
-	DeckLinkNotificationCallback();
-	virtual ~DeckLinkNotificationCallback() = default;
-
-	// IUnknown interface
-	HRESULT	QueryInterface(REFIID iid, LPVOID *ppv) override;
-	ULONG	AddRef() override;
-	ULONG	Release() override;
-
-	// IDeckLinkNotificationCallback interface
-	HRESULT Notify(BMDNotifications topic, uint64_t param1, uint64_t param2) override;
-
-signals:
-	void	statusChanged(BMDDeckLinkStatusID statusID);
-	void	preferencesChanged(void);
-
-private:
-	std::atomic<ULONG>	m_refCount;
-};
+#include "DeckLinkStatusStore.h"
 
 enum class StatusDataTableHeader : int { Item, Value, Count };
 
+// Shows the status of one device from the status store.  Rows map to items through arrays in both directions and
+// values are only formatted when a cell is painted, so each cell is O(1).
 class DeckLinkStatusDataTableModel : public QAbstractTableModel
 {
 	Q_OBJECT
 
 public:
-	DeckLinkStatusDataTableModel(QObject* parent);
+	DeckLinkStatusDataTableModel(QObject* parent, DeckLinkStatusStore& statusStore);
+	virtual ~DeckLinkStatusDataTableModel();
 
-	IDeckLinkNotificationCallback*		delegate();
-	void								reset(com_ptr<IDeckLink>& deckLink);
+	void								setDevice(DeckLinkStatusStore::DeviceID deviceID);
 
 	// QAbstractTableModel methods
 	int									rowCount(const QModelIndex& parent = QModelIndex()) const override;
@@ -91,30 +71,27 @@ public:
 	QVariant							data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
 	QVariant							headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
 
+signals:
+	// Emitted on the notification thread for any device, handled on the model's thread
+	void								statusChanged(DeckLinkStatusStore::DeviceID deviceID, int item);
+
 private slots:
-	void								statusChanged(BMDDeckLinkStatusID statusID);
+	void								updateItem(DeckLinkStatusStore::DeviceID deviceID, int item);
 
 private:
-	com_ptr<IDeckLinkStatus>								m_deckLinkStatus;
-	com_ptr<DeckLinkNotificationCallback>					m_delegate;
+	void								updateItemRows(int firstRow);
 
-	std::vector<std::pair<BMDDeckLinkStatusID, QString>>	m_statusData;
-};
+	DeckLinkStatusStore&						m_statusStore;
+	DeckLinkStatusStore::DeviceID				m_deviceID;
+	com_ptr<IDeckLink>							m_deckLink;
 
-// Status item getter functions
-QString		getStatusFlag(com_ptr<IDeckLinkStatus>& deckLinkStatus, const BMDDeckLinkStatusID id);
-QString		getStatusInt(com_ptr<IDeckLinkStatus>& deckLinkStatus, const BMDDeckLinkStatusID id);
-QString		getStatusBytes(com_ptr<IDeckLinkStatus>& deckLinkStatus, const BMDDeckLinkStatusID id);
-
-QString		getStatusPanelType(com_ptr<IDeckLinkStatus>& deckLinkStatus);
-QString		getStatusBusy(com_ptr<IDeckLinkStatus>& deckLinkStatus);
-QString		getStatusVideoOutputMode(com_ptr<IDeckLinkStatus>& deckLinkStatus, const BMDDeckLinkStatusID id);
-QString		getStatusPixelFormat(com_ptr<IDeckLinkStatus>& deckLinkStatus, const BMDDeckLinkStatusID id);
-QString		getStatusVideoFlags(com_ptr<IDeckLinkStatus>& deckLinkStatus, const BMDDeckLinkStatusID id);
-QString		getStatusDetectedVideoInputFormatFlags(com_ptr<IDeckLinkStatus>& deckLinkStatus);
-QString		getStatusVideoInputMode(com_ptr<IDeckLinkStatus>& deckLinkStatus, const BMDDeckLinkStatusID id);
-QString		getStatusDynamicRange(com_ptr<IDeckLinkStatus>& deckLinkStatus, const BMDDeckLinkStatusID id);
-QString		getStatusFieldDominance(com_ptr<IDeckLinkStatus>& deckLinkStatus, const BMDDeckLinkStatusID id);
-QString		getStatusColorspace(com_ptr<IDeckLinkStatus>& deckLinkStatus, const BMDDeckLinkStatusID id);
-QString		getStatusLinkConfiguration(com_ptr<IDeckLinkStatus>& deckLinkStatus, const BMDDeckLinkStatusID id);
+	std::vector<int>							m_rowItems;			// Item shown in each row, in item order
+	std::array<int, kStatusItemCount>			m_itemRows;			// Row showing each item, or -1
+
+	mutable std::array<QString, kStatusItemCount>	m_valueText;
+	mutable std::bitset<kStatusItemCount>		m_valueTextValid;	// Cleared when the value changes
+};
 
+// Status value formatting functions
+bool		isStatusValueShown(const StatusItemInfo& itemInfo, const StatusValue& value);
+QString		formatStatusValue(const com_ptr<IDeckLink>& deckLink, const StatusItemInfo& itemInfo, const StatusValue& value);
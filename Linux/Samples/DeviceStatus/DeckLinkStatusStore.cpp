@@ -0,0 +1,461 @@
+/* -LICENSE-START-
+** Copyright (c) 2020 Blackmagic Design
+**  
+** Permission is hereby granted, free of charge, to any person or organization 
+** obtaining a copy of the software and accompanying documentation (the 
+** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+** and transmit the Software, and to prepare derivative works of the Software, 
+** and to permit third-parties to whom the Software is furnished to do so, in 
+** accordance with:
+** 
+** (1) if the Software is obtained from Blackmagic Design, the End User License 
+** Agreement for the Software Development Kit (“EULA”) available at 
+** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+** 
+** (2) if the Software is obtained from any third party, such licensing terms 
+** as notified by that third party,
+** 
+** and all subject to the following:
+** 
+** (3) the copyright notices in the Software and this entire statement, 
+** including the above license grant, this restriction and the following 
+** disclaimer, must be included in all copies of the Software, in whole or in 
+** part, and all derivative works of the Software, unless such copies or 
+** derivative works are solely in the form of machine-executable object code 
+** generated by a source language processor.
+** 
+** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+** DEALINGS IN THE SOFTWARE.
+** 
+** A copy of the Software is available free of charge at 
+** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+** 
+** -LICENSE-END-
+*/
+
+
+#include "DeckLinkStatusStore.h"
+
+// Status items stored for each device, in display order
+static const StatusItemInfo kStatusItems[] =
+{
+	{ bmdDeckLinkStatusDetectedVideoInputMode,				StatusValueType::Int,	"Detected video input display mode" },
+	{ bmdDeckLinkStatusDetectedVideoInputFormatFlags,		StatusValueType::Int,	"Detected video input format flags" },
+	{ bmdDeckLinkStatusDetectedVideoInputFieldDominance,	StatusValueType::Int,	"Detected video input field dominance" },
+	{ bmdDeckLinkStatusDetectedVideoInputColorspace,		StatusValueType::Int,	"Detected video input colorspace" },
+	{ bmdDeckLinkStatusDetectedVideoInputDynamicRange,		StatusValueType::Int,	"Detected video input dynamic range" },
+	{ bmdDeckLinkStatusDetectedSDILinkConfiguration,		StatusValueType::Int,	"Detected SDI video input link width" },
+	{ bmdDeckLinkStatusCurrentVideoInputMode,				StatusValueType::Int,	"Video input display mode" },
+	{ bmdDeckLinkStatusCurrentVideoInputPixelFormat,		StatusValueType::Int,	"Video input pixel format" },
+	{ bmdDeckLinkStatusCurrentVideoInputFlags,				StatusValueType::Int,	"Video input flags" },
+	{ bmdDeckLinkStatusCurrentVideoOutputMode,				StatusValueType::Int,	"Video output display mode" },
+	{ bmdDeckLinkStatusCurrentVideoOutputFlags,				StatusValueType::Int,	"Video output flags" },
+	{ bmdDeckLinkStatusPCIExpressLinkWidth,					StatusValueType::Int,	"PCIe link width" },
+	{ bmdDeckLinkStatusPCIExpressLinkSpeed,					StatusValueType::Int,	"PCIe link speed" },
+	{ bmdDeckLinkStatusLastVideoOutputPixelFormat,			StatusValueType::Int,	"Video output pixel format" },
+	{ bmdDeckLinkStatusReferenceSignalMode,					StatusValueType::Int,	"Detected reference video mode" },
+	{ bmdDeckLinkStatusBusy,								StatusValueType::Int,	"Busy state" },
+	{ bmdDeckLinkStatusVideoInputSignalLocked,				StatusValueType::Flag,	"Video input locked" },
+	{ bmdDeckLinkStatusReferenceSignalLocked,				StatusValueType::Flag,	"Reference input locked" },
+	{ bmdDeckLinkStatusReferenceSignalFlags,				StatusValueType::Int,	"Reference input video flags" },
+	{ bmdDeckLinkStatusInterchangeablePanelType,			StatusValueType::Int,	"Panel Installed" },
+	{ bmdDeckLinkStatusReceivedEDID,						StatusValueType::Bytes,	"Received EDID of connected HDMI sink" },
+	{ bmdDeckLinkStatusDeviceTemperature,					StatusValueType::Int,	"On-board temperature (°C)" },
+};
+
+static_assert(sizeof(kStatusItems) / sizeof(kStatusItems[0]) == kStatusItemCount, "kStatusItemCount must match kStatusItems");
+
+// Status IDs are sparse FourCC values, so items are found through an open addressed hash table
+class StatusItemLookup
+{
+public:
+	StatusItemLookup()
+	{
+		m_slots.fill(-1);
+
+		for (int item = 0; item < kStatusItemCount; item++)
+		{
+			uint32_t slot = hash(kStatusItems[item].id);
+			while (m_slots[slot] >= 0)
+				slot = (slot + 1) % kSlotCount;
+			m_slots[slot] = item;
+		}
+	}
+
+	int find(BMDDeckLinkStatusID statusID) const
+	{
+		for (uint32_t slot = hash(statusID); m_slots[slot] >= 0; slot = (slot + 1) % kSlotCount)
+		{
+			if (kStatusItems[m_slots[slot]].id == statusID)
+				return m_slots[slot];
+		}
+
+		return -1;
+	}
+
+private:
+	static constexpr uint32_t kSlotCount = 64;
+
+	static uint32_t hash(BMDDeckLinkStatusID statusID)
+	{
+		// Fibonacci hashing, the top 6 bits index the 64 slots
+		return ((uint32_t)statusID * 2654435761u) >> 26;
+	}
+
+	std::array<int, kSlotCount>		m_slots;
+};
+
+static const StatusItemLookup kStatusItemLookup;
+
+static void readStatusValue(com_ptr<IDeckLinkStatus>& deckLinkStatus, const StatusItemInfo& itemInfo, StatusValue* value)
+{
+	value->valid = false;
+	value->intValue = 0;
+	value->bytes.clear();
+
+	switch (itemInfo.type)
+	{
+		case StatusValueType::Flag:
+		{
+			dlbool_t statusFlag;
+			if (deckLinkStatus->GetFlag(itemInfo.id, &statusFlag) == S_OK)
+			{
+				value->intValue = statusFlag ? 1 : 0;
+				value->valid = true;
+			}
+			break;
+		}
+
+		case StatusValueType::Int:
+			value->valid = (deckLinkStatus->GetInt(itemInfo.id, &value->intValue) == S_OK);
+			break;
+
+		case StatusValueType::Bytes:
+		{
+			// Get required size of buffer
+			uint32_t bytesSize = 0;
+			if (deckLinkStatus->GetBytes(itemInfo.id, nullptr, &bytesSize) != S_OK)
+				break;
+
+			value->bytes.resize(bytesSize);
+			if (deckLinkStatus->GetBytes(itemInfo.id, value->bytes.data(), &bytesSize) == S_OK)
+			{
+				value->bytes.resize(bytesSize);
+				value->valid = true;
+			}
+			else
+			{
+				value->bytes.clear();
+			}
+			break;
+		}
+	}
+}
+
+static bool operator==(const StatusValue& lhs, const StatusValue& rhs)
+{
+	return (lhs.valid == rhs.valid) && (lhs.intValue == rhs.intValue) && (lhs.bytes == rhs.bytes);
+}
+
+static void unsubscribe(com_ptr<IDeckLink>& deckLink, com_ptr<DeckLinkStatusNotifier>& notifier)
+{
+	com_ptr<IDeckLinkNotification> deckLinkNotification(IID_IDeckLinkNotification, deckLink);
+
+	if (deckLinkNotification)
+		deckLinkNotification->Unsubscribe(bmdStatusChanged, notifier.get());
+}
+
+/// DeckLinkStatusNotifier class
+
+DeckLinkStatusNotifier::DeckLinkStatusNotifier(DeckLinkStatusStore* statusStore, uint32_t deviceID) :
+	m_refCount(1),
+	m_statusStore(statusStore),
+	m_deviceID(deviceID)
+{
+}
+
+// IUnknown methods
+
+HRESULT DeckLinkStatusNotifier::QueryInterface(REFIID iid, LPVOID *ppv)
+{
+	HRESULT result = S_OK;
+
+	if (ppv == nullptr)
+		return E_POINTER;
+
+	// Obtain the IUnknown interface and compare it the provided REFIID
+	if (iid == IID_IUnknown)
+	{
+		*ppv = this;
+		AddRef();
+	}
+	else if (iid == IID_IDeckLinkNotificationCallback)
+	{
+		*ppv = static_cast<IDeckLinkNotificationCallback*>(this);
+		AddRef();
+	}
+	else
+	{
+		*ppv = nullptr;
+		result = E_NOINTERFACE;
+	}
+
+	return result;
+}
+
+ULONG DeckLinkStatusNotifier::AddRef()
+{
+	return ++m_refCount;
+}
+
+ULONG DeckLinkStatusNotifier::Release()
+{
+	ULONG newRefValue = --m_refCount;
+	if (newRefValue == 0)
+		delete this;
+
+	return newRefValue;
+}
+
+// IDeckLinkNotificationCallback
+
+HRESULT DeckLinkStatusNotifier::Notify(BMDNotifications topic, uint64_t param1, uint64_t /*param2*/)
+{
+	if (topic == bmdStatusChanged)
+		m_statusStore->statusChanged(m_deviceID, this, static_cast<BMDDeckLinkStatusID>(param1));
+
+	return S_OK;
+}
+
+/// DeckLinkStatusStore class
+
+DeckLinkStatusStore::~DeckLinkStatusStore()
+{
+	removeAllDevices();
+}
+
+const StatusItemInfo& DeckLinkStatusStore::getItem(int item)
+{
+	return kStatusItems[item];
+}
+
+int DeckLinkStatusStore::findItem(BMDDeckLinkStatusID statusID)
+{
+	return kStatusItemLookup.find(statusID);
+}
+
+DeckLinkStatusStore::DeviceID DeckLinkStatusStore::addDevice(com_ptr<IDeckLink>& deckLink)
+{
+	com_ptr<IDeckLinkStatus>		deckLinkStatus(IID_IDeckLinkStatus, deckLink);
+	com_ptr<IDeckLinkNotification>	deckLinkNotification(IID_IDeckLinkNotification, deckLink);
+	com_ptr<DeckLinkStatusNotifier>	notifier;
+	DeviceID						deviceID;
+
+	if (!deckLinkStatus)
+		return kInvalidDevice;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		for (deviceID = 0; deviceID < m_devices.size(); deviceID++)
+		{
+			if (m_devices[deviceID].deckLink == deckLink)
+				return deviceID;
+		}
+
+		// Reuse the first free entry, so the array stays as small as the most devices attached at once
+		for (deviceID = 0; deviceID < m_devices.size(); deviceID++)
+		{
+			if (!m_devices[deviceID].deckLink)
+				break;
+		}
+
+		if (deviceID == m_devices.size())
+			m_devices.emplace_back();
+
+		notifier = make_com_ptr<DeckLinkStatusNotifier>(this, deviceID);
+
+		DeviceEntry& entry = m_devices[deviceID];
+		entry.deckLink			= deckLink;
+		entry.deckLinkStatus	= deckLinkStatus;
+		entry.notifier			= notifier;
+		entry.changeCount		= 0;
+		for (auto& value : entry.values)
+			value = StatusValue{ false, 0, {} };
+	}
+
+	// Subscribe before the first read, so that no change is missed in between
+	if (deckLinkNotification)
+		deckLinkNotification->Subscribe(bmdStatusChanged, notifier.get());
+
+	for (int item = 0; item < kStatusItemCount; item++)
+		refreshItem(deviceID, notifier.get(), item);
+
+	return deviceID;
+}
+
+void DeckLinkStatusStore::removeDevice(com_ptr<IDeckLink>& deckLink)
+{
+	com_ptr<DeckLinkStatusNotifier> notifier;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		for (auto& entry : m_devices)
+		{
+			if (entry.deckLink == deckLink)
+			{
+				notifier = std::move(entry.notifier);
+				entry = DeviceEntry();
+				break;
+			}
+		}
+	}
+
+	// Any notification still in flight no longer matches the entry's notifier and is ignored
+	if (notifier)
+		unsubscribe(deckLink, notifier);
+}
+
+void DeckLinkStatusStore::removeAllDevices()
+{
+	std::vector<DeviceEntry> devices;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		devices.swap(m_devices);
+	}
+
+	for (auto& entry : devices)
+	{
+		if (entry.deckLink)
+			unsubscribe(entry.deckLink, entry.notifier);
+	}
+}
+
+DeckLinkStatusStore::DeviceID DeckLinkStatusStore::findDevice(IDeckLink* deckLink) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (deckLink == nullptr)
+		return kInvalidDevice;
+
+	for (DeviceID deviceID = 0; deviceID < m_devices.size(); deviceID++)
+	{
+		if (m_devices[deviceID].deckLink.get() == deckLink)
+			return deviceID;
+	}
+
+	return kInvalidDevice;
+}
+
+com_ptr<IDeckLink> DeckLinkStatusStore::getDevice(DeviceID deviceID) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (deviceID >= m_devices.size())
+		return nullptr;
+
+	return m_devices[deviceID].deckLink;
+}
+
+std::vector<DeckLinkStatusStore::DeviceID> DeckLinkStatusStore::getDeviceIDs() const
+{
+	std::lock_guard<std::mutex>	lock(m_mutex);
+	std::vector<DeviceID>		deviceIDs;
+
+	for (DeviceID deviceID = 0; deviceID < m_devices.size(); deviceID++)
+	{
+		if (m_devices[deviceID].deckLink)
+			deviceIDs.push_back(deviceID);
+	}
+
+	return deviceIDs;
+}
+
+bool DeckLinkStatusStore::getValue(DeviceID deviceID, int item, StatusValue* value) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if ((deviceID >= m_devices.size()) || !m_devices[deviceID].deckLink || (item < 0) || (item >= kStatusItemCount))
+		return false;
+
+	*value = m_devices[deviceID].values[item];
+	return value->valid;
+}
+
+uint64_t DeckLinkStatusStore::getChangeCount(DeviceID deviceID) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (deviceID >= m_devices.size())
+		return 0;
+
+	return m_devices[deviceID].changeCount;
+}
+
+void DeckLinkStatusStore::setChangeCallback(ChangeCallback callback)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_changeCallback = std::move(callback);
+	m_changeCallbacksIdle.wait(lock, [this] { return m_changeCallbacksRunning == 0; });
+}
+
+void DeckLinkStatusStore::statusChanged(DeviceID deviceID, DeckLinkStatusNotifier* notifier, BMDDeckLinkStatusID statusID)
+{
+	int item = findItem(statusID);
+	if (item >= 0)
+		refreshItem(deviceID, notifier, item);
+}
+
+void DeckLinkStatusStore::refreshItem(DeviceID deviceID, DeckLinkStatusNotifier* notifier, int item)
+{
+	com_ptr<IDeckLinkStatus>	deckLinkStatus;
+	StatusValue					value;
+	ChangeCallback				changeCallback;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		if ((deviceID >= m_devices.size()) || (m_devices[deviceID].notifier.get() != notifier))
+			return;
+
+		deckLinkStatus = m_devices[deviceID].deckLinkStatus;
+	}
+
+	// Read from the driver without holding the lock, so readers of other devices aren't blocked
+	readStatusValue(deckLinkStatus, kStatusItems[item], &value);
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		// The device may have been removed while reading
+		if ((deviceID >= m_devices.size()) || (m_devices[deviceID].notifier.get() != notifier))
+			return;
+
+		DeviceEntry& entry = m_devices[deviceID];
+		if (entry.values[item] == value)
+			return;
+
+		entry.values[item] = std::move(value);
+		entry.changeCount++;
+		if (!m_changeCallback)
+			return;
+
+		changeCallback = m_changeCallback;
+		m_changeCallbacksRunning++;
+	}
+
+	changeCallback(deviceID, item);
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (--m_changeCallbacksRunning == 0)
+			m_changeCallbacksIdle.notify_all();
+	}
+}
@@ -0,0 +1,154 @@
+/* -LICENSE-START-
+** Copyright (c) 2020 Blackmagic Design
+**  
+** Permission is hereby granted, free of charge, to any person or organization 
+** obtaining a copy of the software and accompanying documentation (the 
+** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+** and transmit the Software, and to prepare derivative works of the Software, 
+** and to permit third-parties to whom the Software is furnished to do so, in 
+** accordance with:
+** 
+** (1) if the Software is obtained from Blackmagic Design, the End User License 
+** Agreement for the Software Development Kit (“EULA”) available at 
+** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+** 
+** (2) if the Software is obtained from any third party, such licensing terms 
+** as notified by that third party,
+** 
+** and all subject to the following:
+** 
+** (3) the copyright notices in the Software and this entire statement, 
+** including the above license grant, this restriction and the following 
+** disclaimer, must be included in all copies of the Software, in whole or in 
+** part, and all derivative works of the Software, unless such copies or 
+** derivative works are solely in the form of machine-executable object code 
+** generated by a source language processor.
+** 
+** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+** DEALINGS IN THE SOFTWARE.
+** 
+** A copy of the Software is available free of charge at 
+** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+** 
+** -LICENSE-END-
+*/
+
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include "com_ptr.h"
+#include "platform.h"
+#include "DeckLinkAPI.h"
+
+enum class StatusValueType : int { Flag, Int, Bytes };
+
+struct StatusItemInfo
+{
+	BMDDeckLinkStatusID		id;
+	StatusValueType			type;
+	const char*				name;		// UTF-8 display name
+};
+
+// Value of a status item as last read from IDeckLinkStatus, unformatted
+struct StatusValue
+{
+	bool					valid;		// The Get call succeeded
+	int64_t					intValue;	// Flags are 0 or 1
+	std::vector<uint8_t>	bytes;
+};
+
+constexpr int kStatusItemCount = 22;
+
+class DeckLinkStatusStore;
+
+// IDeckLinkNotification doesn't say which device a notification is for, so each device has its own callback
+class DeckLinkStatusNotifier : public IDeckLinkNotificationCallback
+{
+public:
+	DeckLinkStatusNotifier(DeckLinkStatusStore* statusStore, uint32_t deviceID);
+	virtual ~DeckLinkStatusNotifier() = default;
+
+	// IUnknown interface
+	HRESULT	QueryInterface(REFIID iid, LPVOID *ppv) override;
+	ULONG	AddRef() override;
+	ULONG	Release() override;
+
+	// IDeckLinkNotificationCallback interface
+	HRESULT	Notify(BMDNotifications topic, uint64_t param1, uint64_t param2) override;
+
+private:
+	std::atomic<ULONG>		m_refCount;
+	DeckLinkStatusStore*	m_statusStore;
+	uint32_t				m_deviceID;
+};
+
+// Typed status values for every attached device, kept up to date by bmdStatusChanged notifications.  Devices are
+// held in a flat array indexed by device ID and items in a fixed array indexed by item, so reads are O(1).  The store
+// has no GUI dependencies and its reads are thread safe, so it can be polled to monitor many devices headless.
+class DeckLinkStatusStore
+{
+public:
+	using DeviceID = uint32_t;
+	static constexpr DeviceID kInvalidDevice = UINT32_MAX;
+
+	// Called on the notification thread when an item's value changes
+	using ChangeCallback = std::function<void(DeviceID deviceID, int item)>;
+
+	DeckLinkStatusStore() = default;
+	~DeckLinkStatusStore();
+
+	static const StatusItemInfo&	getItem(int item);
+	// The item for a status ID, or -1 if it isn't stored
+	static int						findItem(BMDDeckLinkStatusID statusID);
+
+	// Reads every item and subscribes to changes, the ID of a removed device may be reused
+	DeviceID						addDevice(com_ptr<IDeckLink>& deckLink);
+	void							removeDevice(com_ptr<IDeckLink>& deckLink);
+	void							removeAllDevices();
+
+	DeviceID						findDevice(IDeckLink* deckLink) const;
+	com_ptr<IDeckLink>				getDevice(DeviceID deviceID) const;
+	std::vector<DeviceID>			getDeviceIDs() const;
+
+	bool							getValue(DeviceID deviceID, int item, StatusValue* value) const;
+	// Incremented whenever one of the device's values changes, so pollers can skip unchanged devices
+	uint64_t						getChangeCount(DeviceID deviceID) const;
+
+	// Waits for any call of the previous callback to return, so that its captures may be destroyed once this
+	// returns.  Must not be called from the callback itself.
+	void							setChangeCallback(ChangeCallback callback);
+
+	// Called by the device's notifier
+	void							statusChanged(DeviceID deviceID, DeckLinkStatusNotifier* notifier, BMDDeckLinkStatusID statusID);
+
+private:
+	struct DeviceEntry
+	{
+		com_ptr<IDeckLink>								deckLink;		// Null once the device is removed
+		com_ptr<IDeckLinkStatus>						deckLinkStatus;
+		com_ptr<DeckLinkStatusNotifier>					notifier;
+		std::array<StatusValue, kStatusItemCount>		values;
+		uint64_t										changeCount;
+	};
+
+	void							refreshItem(DeviceID deviceID, DeckLinkStatusNotifier* notifier, int item);
+
+	mutable std::mutex				m_mutex;
+	std::vector<DeviceEntry>		m_devices;
+	ChangeCallback					m_changeCallback;
+	unsigned						m_changeCallbacksRunning = 0;
+	std::condition_variable			m_changeCallbacksIdle;
+};
@@ -63,9 +63,11 @@ DeviceStatus::DeviceStatus(QWidget *parent) :
 
 	m_deviceListModel = new DeckLinkDeviceListModel(this);
 	m_ui->deviceComboBox->setModel(m_deviceListModel);
+	connect(m_deviceListModel, &DeckLinkDeviceListModel::deviceAdded, this, &DeviceStatus::deviceAdded);
+	connect(m_deviceListModel, &DeckLinkDeviceListModel::deviceRemoved, this, &DeviceStatus::deviceRemoved);
 	connect(m_ui->deviceComboBox,  QOverload<int>::of(&QComboBox::currentIndexChanged), this, &DeviceStatus::deviceChanged);
 
-	m_statusDataTableModel = new DeckLinkStatusDataTableModel(this);
+	m_statusDataTableModel = new DeckLinkStatusDataTableModel(this, m_statusStore);
 	m_ui->statusDataTableView->setModel(m_statusDataTableModel);
 	m_ui->statusDataTableView->verticalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
 	m_ui->statusDataTableView->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
@@ -98,35 +100,39 @@ void DeviceStatus::closeEvent(QCloseEvent* event)
 	if (m_selectedDeckLink)
 	{
 		com_ptr<IDeckLinkProfileManager>	deckLinkProfileManager(IID_IDeckLinkProfileManager, m_selectedDeckLink);
-		com_ptr<IDeckLinkNotification>		deckLinkNotification(IID_IDeckLinkNotification, m_selectedDeckLink);
 
 		// Unsubscribe to profile callback
 		if (deckLinkProfileManager)
 			deckLinkProfileManager->SetCallback(nullptr);
-
-		// Unsubscribe to status changed callback
-		if (deckLinkNotification)
-			deckLinkNotification->Unsubscribe(bmdStatusChanged, m_statusDataTableModel->delegate());
 	}
 
+	// Unsubscribe every device from status changed callbacks
+	m_statusStore.removeAllDevices();
+
 	// Uninstall device discovery notifications
 	m_deckLinkDiscovery->UninstallDeviceNotifications();
 }
 
+void DeviceStatus::deviceAdded(com_ptr<IDeckLink> deckLink)
+{
+	// Read and track the status of every device, not just the selected one
+	m_statusStore.addDevice(deckLink);
+}
+
+void DeviceStatus::deviceRemoved(com_ptr<IDeckLink> deckLink)
+{
+	m_statusStore.removeDevice(deckLink);
+}
+
 void DeviceStatus::deviceChanged(int selectedDeviceIndex)
 {
 	if (m_selectedDeckLink)
 	{
 		com_ptr<IDeckLinkProfileManager>	deckLinkProfileManager(IID_IDeckLinkProfileManager, m_selectedDeckLink);
-		com_ptr<IDeckLinkNotification>		deckLinkNotification(IID_IDeckLinkNotification, m_selectedDeckLink);
 
 		// Unsubscribe to profile callback
 		if (deckLinkProfileManager)
 			deckLinkProfileManager->SetCallback(nullptr);
-
-		// Unsubscribe to status changed callback
-		if (deckLinkNotification)
-			deckLinkNotification->Unsubscribe(bmdStatusChanged, m_statusDataTableModel->delegate());
 	}
 
 	QVariant selectedDeviceVariant = m_ui->deviceComboBox->itemData(selectedDeviceIndex, DeckLinkDeviceRole);
@@ -135,21 +141,16 @@ void DeviceStatus::deviceChanged(int selectedDeviceIndex)
 	if (m_selectedDeckLink)
 	{
 		com_ptr<IDeckLinkProfileManager>	deckLinkProfileManager(IID_IDeckLinkProfileManager, m_selectedDeckLink);
-		com_ptr<IDeckLinkNotification>		deckLinkNotification(IID_IDeckLinkNotification, m_selectedDeckLink);
 
 		// Subscribe the selected device to profile callback
 		if (deckLinkProfileManager)
 			deckLinkProfileManager->SetCallback(m_profileCallback.get());
-
-		// Subscribe the selected device to status changed callback
-		if (deckLinkNotification)
-			deckLinkNotification->Subscribe(bmdStatusChanged, m_statusDataTableModel->delegate());
 	}
 
 	updateDuplexMode(m_selectedDeckLink);
 
-	// Reset status data table with initial status values
-	m_statusDataTableModel->reset(m_selectedDeckLink);
+	// Show the selected device's status, which the store has been tracking since it arrived
+	m_statusDataTableModel->setDevice(m_statusStore.findDevice(m_selectedDeckLink.get()));
 }
 
 void DeviceStatus::profileActivated(com_ptr<IDeckLinkProfile> deckLinkProfile)
@@ -48,6 +48,7 @@
 #include "DeckLinkProfileCallback.h"
 #include "DeckLinkDeviceListModel.h"
 #include "DeckLinkStatusDataTableModel.h"
+#include "DeckLinkStatusStore.h"
 
 #include "ui_DeviceStatus.h"
 
@@ -68,6 +69,8 @@ public:
 	void	setup();
 
 public slots:
+	void	deviceAdded(com_ptr<IDeckLink> deckLink);
+	void	deviceRemoved(com_ptr<IDeckLink> deckLink);
 	void	deviceChanged(int selectedDeviceIndex);
 	void	profileActivated(com_ptr<IDeckLinkProfile> deckLinkProfile);
 
@@ -77,6 +80,7 @@ private:
 	Ui::DeviceStatusDialog*				m_ui;
 	DeckLinkDeviceListModel*			m_deviceListModel;
 	DeckLinkStatusDataTableModel*		m_statusDataTableModel;
+	DeckLinkStatusStore					m_statusStore;
 
 	com_ptr<IDeckLinkDiscovery>			m_deckLinkDiscovery;
 	com_ptr<IDeckLink>					m_selectedDeckLink;
@@ -70,6 +70,7 @@ SOURCES += main.cpp \
     DeckLinkDeviceListModel.cpp \
     DeckLinkProfileCallback.cpp \
     DeckLinkStatusDataTableModel.cpp \
+    DeckLinkStatusStore.cpp \
     DeviceStatus.cpp \
     platform.cpp
 
@@ -80,6 +81,7 @@ HEADERS += \
     DeckLinkDeviceListModel.h \
     DeckLinkProfileCallback.h \
     DeckLinkStatusDataTableModel.h \
+    DeckLinkStatusStore.h \
     com_ptr.h \
     DeviceStatus.h \
     platform.h
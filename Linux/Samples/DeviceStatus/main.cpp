@@ -48,7 +48,6 @@ int main(int argc, char *argv[])
 
 	qRegisterMetaType<com_ptr<IDeckLink>>("com_ptr<IDeckLink>");
 	qRegisterMetaType<com_ptr<IDeckLinkProfile>>("com_ptr<IDeckLinkProfile>");
-	qRegisterMetaType<BMDDeckLinkStatusID>("BMDDeckLinkStatusID");
 
 	DeviceStatus w;
 	w.show();
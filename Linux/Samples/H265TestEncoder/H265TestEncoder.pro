@@ -48,6 +48,7 @@ INCLUDEPATH += .\
 }
 
 QT += widgets
+CONFIG += c++11
 
 TARGET = H265TestEncoder
 TEMPLATE = app
@@ -57,6 +58,17 @@ SOURCES += "src/main.cpp"\
            "src/ControllerImp.cpp"\
            "src/ControllerWidget.cpp"\
            "src/VideoWriter.cpp"\
+           "src/AsyncFileWriter.cpp"\
+           "src/MP4Muxer.cpp"\
+           "src/HEVCParser.cpp"\
+           "src/KeyframeIndex.cpp"\
+           "src/MP4SyncCheck.cpp"\
+           "src/AudioPacketQueue.cpp"\
+           "src/EncoderTelemetry.cpp"\
+           "src/MetricsRegistry.cpp"\
+           "src/MetricsServer.cpp"\
+           "src/ReplayEncoderInput.cpp"\
+           "src/ReplayBenchmark.cpp"\
            "src/DeckLinkDevice.cpp"\
            "src/CommonGui.cpp"\
            "src/ColourPalette.cpp"\
@@ -67,6 +79,17 @@ HEADERS += "src/MainWindow.h"\
            "src/ControllerImp.h"\
            "src/ControllerWidget.h"\
            "src/VideoWriter.h"\
+           "src/AsyncFileWriter.h"\
+           "src/MP4Muxer.h"\
+           "src/HEVCParser.h"\
+           "src/KeyframeIndex.h"\
+           "src/MP4SyncCheck.h"\
+           "src/AudioPacketQueue.h"\
+           "src/EncoderTelemetry.h"\
+           "src/MetricsRegistry.h"\
+           "src/MetricsServer.h"\
+           "src/ReplayEncoderInput.h"\
+           "src/ReplayBenchmark.h"\
            "src/DeckLinkDevice.h"\
            "src/CommonGui.h"\
            "src/ColourPalette.h"\
@@ -78,4 +101,4 @@ ICON    = Encoder_icon.icns
 
 RESOURCES += H265TestEncoder.qrc
 
-LIBS += -ldl -fPIC
+LIBS += -ldl -lrt -fPIC
@@ -0,0 +1,343 @@
+/* -LICENSE-START-
+ ** Copyright (c) 2016 Blackmagic Design
+ **  
+ ** Permission is hereby granted, free of charge, to any person or organization 
+ ** obtaining a copy of the software and accompanying documentation (the 
+ ** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+ ** and transmit the Software, and to prepare derivative works of the Software, 
+ ** and to permit third-parties to whom the Software is furnished to do so, in 
+ ** accordance with:
+ ** 
+ ** (1) if the Software is obtained from Blackmagic Design, the End User License 
+ ** Agreement for the Software Development Kit (“EULA”) available at 
+ ** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+ ** 
+ ** (2) if the Software is obtained from any third party, such licensing terms 
+ ** as notified by that third party,
+ ** 
+ ** and all subject to the following:
+ ** 
+ ** (3) the copyright notices in the Software and this entire statement, 
+ ** including the above license grant, this restriction and the following 
+ ** disclaimer, must be included in all copies of the Software, in whole or in 
+ ** part, and all derivative works of the Software, unless such copies or 
+ ** derivative works are solely in the form of machine-executable object code 
+ ** generated by a source language processor.
+ ** 
+ ** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ ** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ ** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+ ** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+ ** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+ ** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ ** DEALINGS IN THE SOFTWARE.
+ ** 
+ ** A copy of the Software is available free of charge at 
+ ** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+ ** 
+ ** -LICENSE-END-
+ */
+
+#include "AsyncFileWriter.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+AsyncFileWriter::AsyncFileWriter(size_t blockSize, size_t blockCount) :
+	m_blockSize(blockSize),
+	m_blocks(blockCount),
+	m_currentBlock(NULL),
+	m_queue(blockCount * 2 + 1),		// Every block, with a file start before each and one more after the last
+	m_queueHead(0),
+	m_queueSize(0),
+	m_queuedBlockCount(0),
+	m_stopping(false),
+	m_fileNameFormat(NULL),
+	m_isOpen(false),
+	m_fd(-1)
+{
+	memset(&m_statistics, 0, sizeof(m_statistics));
+}
+
+AsyncFileWriter::~AsyncFileWriter()
+{
+	close();
+}
+
+bool AsyncFileWriter::open(const char* path)
+{
+	m_fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (m_fd < 0)
+		return false;
+
+	// Allocate all of the blocks up front, the producer never allocates
+	m_freeBlocks.clear();
+	for (Block& block : m_blocks)
+	{
+		block.data.resize(m_blockSize);
+		block.used = 0;
+		m_freeBlocks.push_back(&block);
+	}
+
+	m_stopping = false;
+	m_isOpen = true;
+	m_writerThread = std::thread(&AsyncFileWriter::writerThread, this);
+	return true;
+}
+
+void AsyncFileWriter::close()
+{
+	if (!m_isOpen)
+		return;
+
+	flush();
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+	m_blockQueued.notify_one();
+	m_writerThread.join();
+
+	if (m_fd >= 0)
+		::close(m_fd);
+	m_fd = -1;
+	m_isOpen = false;
+}
+
+bool AsyncFileWriter::write(const void* data, size_t size)
+{
+	struct iovec part = { const_cast<void*>(data), size };
+	return write(&part, 1);
+}
+
+bool AsyncFileWriter::write(const struct iovec* parts, int partCount)
+{
+	size_t size = 0;
+	for (int i = 0; i < partCount; i++)
+		size += parts[i].iov_len;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		size_t available = m_freeBlocks.size() * m_blockSize;
+		if (m_currentBlock != NULL)
+			available += m_blockSize - m_currentBlock->used;
+
+		if (!m_isOpen || size > available)
+		{
+			m_statistics.bytesDropped += size;
+			return false;
+		}
+
+		m_statistics.bytesQueued += size;
+	}
+
+	for (int i = 0; i < partCount; i++)
+	{
+		const uint8_t*	data = (const uint8_t*)parts[i].iov_base;
+		size_t			remaining = parts[i].iov_len;
+
+		while (remaining > 0)
+		{
+			if (m_currentBlock == NULL)
+			{
+				// Reserved above, the writer thread only adds to the free blocks
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_currentBlock = m_freeBlocks.back();
+				m_freeBlocks.pop_back();
+				m_currentBlock->used = 0;
+			}
+
+			size_t length = std::min(remaining, m_blockSize - m_currentBlock->used);
+			memcpy(&m_currentBlock->data[m_currentBlock->used], data, length);
+			m_currentBlock->used += length;
+			data += length;
+			remaining -= length;
+
+			if (m_currentBlock->used == m_blockSize)
+				queueCurrentBlock();
+		}
+	}
+
+	return true;
+}
+
+void AsyncFileWriter::flush()
+{
+	if (m_currentBlock != NULL && m_currentBlock->used > 0)
+		queueCurrentBlock();
+}
+
+bool AsyncFileWriter::writeAt(uint64_t offset, const void* data, size_t size)
+{
+	Block* block;
+
+	// The data goes in a block of its own, so that it is not appended with the current block
+	flush();
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		if (!m_isOpen || size > m_blockSize || m_freeBlocks.empty())
+		{
+			m_statistics.bytesDropped += size;
+			return false;
+		}
+
+		m_statistics.bytesQueued += size;
+		block = m_freeBlocks.back();
+		m_freeBlocks.pop_back();
+	}
+
+	memcpy(block->data.data(), data, size);
+	block->used = size;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		QueueEntry entry = { block, (int64_t)offset, 0 };
+		queueEntry(entry);
+	}
+	m_blockQueued.notify_one();
+
+	return true;
+}
+
+void AsyncFileWriter::setFileNames(const std::string& directory, const char* nameFormat)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_fileDirectory = directory;
+	m_fileNameFormat = nameFormat;
+}
+
+void AsyncFileWriter::startFile(uint32_t index)
+{
+	if (!m_isOpen)
+		return;
+
+	flush();
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		// A file with nothing written to it is skipped, so that there is never more than one file start between
+		// blocks and the queue can't overflow
+		size_t newest = (m_queueHead + m_queueSize + m_queue.size() - 1) % m_queue.size();
+		if (m_queueSize > 0 && m_queue[newest].block == NULL)
+		{
+			m_queue[newest].fileIndex = index;
+		}
+		else
+		{
+			QueueEntry entry = { NULL, -1, index };
+			queueEntry(entry);
+		}
+	}
+	m_blockQueued.notify_one();
+}
+
+void AsyncFileWriter::queueCurrentBlock()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		QueueEntry entry = { m_currentBlock, -1, 0 };
+		queueEntry(entry);
+	}
+	m_blockQueued.notify_one();
+	m_currentBlock = NULL;
+}
+
+void AsyncFileWriter::queueEntry(const QueueEntry& entry)
+{
+	// Called with m_mutex locked
+	m_queue[(m_queueHead + m_queueSize) % m_queue.size()] = entry;
+	m_queueSize++;
+
+	if (entry.block != NULL)
+	{
+		m_queuedBlockCount++;
+		m_statistics.peakBlocksQueued = std::max(m_statistics.peakBlocksQueued, m_queuedBlockCount);
+	}
+}
+
+void AsyncFileWriter::writerThread()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	while (true)
+	{
+		m_blockQueued.wait(lock, [this]{ return m_stopping || m_queueSize > 0; });
+
+		if (m_queueSize == 0)
+			break;
+
+		QueueEntry entry = m_queue[m_queueHead];
+		m_queueHead = (m_queueHead + 1) % m_queue.size();
+		m_queueSize--;
+
+		if (entry.block == NULL)
+		{
+			std::string path;
+			if (m_fileNameFormat != NULL)
+			{
+				char name[256];
+				snprintf(name, sizeof(name), m_fileNameFormat, entry.fileIndex);
+				path = m_fileDirectory + "/" + name;
+			}
+
+			lock.unlock();
+
+			if (m_fd >= 0)
+				::close(m_fd);
+			m_fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+			lock.lock();
+			if (m_fd < 0)
+				m_statistics.writeErrors++;
+			continue;
+		}
+
+		Block* block = entry.block;
+		m_queuedBlockCount--;
+
+		lock.unlock();
+
+		const uint8_t*	data = block->data.data();
+		size_t			remaining = block->used;
+		int64_t			offset = entry.offset;
+
+		while (remaining > 0 && m_fd >= 0)
+		{
+			// pwrite leaves the file position at the end of the file for the blocks that follow
+			ssize_t written = (offset < 0) ? ::write(m_fd, data, remaining) : ::pwrite(m_fd, data, remaining, offset);
+			if (written < 0)
+			{
+				if (errno == EINTR)
+					continue;
+				break;
+			}
+			data += written;
+			remaining -= written;
+			if (offset >= 0)
+				offset += written;
+		}
+
+		lock.lock();
+
+		m_statistics.bytesWritten += block->used - remaining;
+		if (remaining > 0)
+			m_statistics.writeErrors++;
+
+		block->used = 0;
+		m_freeBlocks.push_back(block);
+	}
+}
+
+AsyncFileWriter::Statistics AsyncFileWriter::getStatistics()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_statistics;
+}
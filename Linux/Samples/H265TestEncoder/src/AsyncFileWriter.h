@@ -0,0 +1,138 @@
+/* -LICENSE-START-
+ ** Copyright (c) 2016 Blackmagic Design
+ **  
+ ** Permission is hereby granted, free of charge, to any person or organization 
+ ** obtaining a copy of the software and accompanying documentation (the 
+ ** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+ ** and transmit the Software, and to prepare derivative works of the Software, 
+ ** and to permit third-parties to whom the Software is furnished to do so, in 
+ ** accordance with:
+ ** 
+ ** (1) if the Software is obtained from Blackmagic Design, the End User License 
+ ** Agreement for the Software Development Kit (“EULA”) available at 
+ ** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+ ** 
+ ** (2) if the Software is obtained from any third party, such licensing terms 
+ ** as notified by that third party,
+ ** 
+ ** and all subject to the following:
+ ** 
+ ** (3) the copyright notices in the Software and this entire statement, 
+ ** including the above license grant, this restriction and the following 
+ ** disclaimer, must be included in all copies of the Software, in whole or in 
+ ** part, and all derivative works of the Software, unless such copies or 
+ ** derivative works are solely in the form of machine-executable object code 
+ ** generated by a source language processor.
+ ** 
+ ** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ ** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ ** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+ ** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+ ** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+ ** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ ** DEALINGS IN THE SOFTWARE.
+ ** 
+ ** A copy of the Software is available free of charge at 
+ ** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+ ** 
+ ** -LICENSE-END-
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/uio.h>
+
+// Buffered file writer for the encoder callback thread.  Data is copied into large preallocated blocks that a
+// background thread writes to disk, so write() never waits for the disk.  When every block is in use write() drops
+// the data instead and returns false.  write(), writeAt() and flush() must be called from one thread.
+class AsyncFileWriter
+{
+public:
+	static const size_t		kDefaultBlockSize	= 4 * 1024 * 1024;
+	static const size_t		kDefaultBlockCount	= 16;
+
+	struct Statistics
+	{
+		uint64_t			bytesQueued;
+		uint64_t			bytesWritten;
+		uint64_t			bytesDropped;
+		uint64_t			writeErrors;		// Including files that could not be created
+		size_t				peakBlocksQueued;
+	};
+
+	AsyncFileWriter(size_t blockSize = kDefaultBlockSize, size_t blockCount = kDefaultBlockCount);
+	~AsyncFileWriter();
+
+	bool					open(const char* path);
+	// Writes everything queued before returning
+	void					close();
+
+	// Queue all of the parts or none of them
+	bool					write(const struct iovec* parts, int partCount);
+	bool					write(const void* data, size_t size);
+
+	// Pass the partly filled block to the writer thread, so that a reader of the file sees everything queued so far
+	void					flush();
+
+	// Overwrite size bytes at offset in the current file, after everything queued so far.  Later writes still append
+	// to the end of the file.  size must fit in one block.
+	bool					writeAt(uint64_t offset, const void* data, size_t size);
+
+	// Name the files started by startFile(), nameFormat is a printf format for the file index such as
+	// "segment_%05u.m4s".  Set before the first startFile().
+	void					setFileNames(const std::string& directory, const char* nameFormat);
+
+	// Write everything queued so far to the current file, then close it and write to the file named for index.
+	// The name is built by the writer thread, so this does not allocate.  A file that nothing is written to before the
+	// next startFile() is not created.
+	void					startFile(uint32_t index);
+
+	Statistics				getStatistics();
+
+private:
+	struct Block
+	{
+		std::vector<uint8_t>	data;
+		size_t					used;
+	};
+
+	// Either a block to write, or when block is NULL, the index of the next file to write to
+	struct QueueEntry
+	{
+		Block*					block;
+		int64_t					offset;			// Where to write the block, or -1 to append it
+		uint32_t				fileIndex;
+	};
+
+	void					writerThread();
+	void					queueCurrentBlock();
+	void					queueEntry(const QueueEntry& entry);
+
+	size_t					m_blockSize;
+	std::vector<Block>		m_blocks;
+	Block*					m_currentBlock;		// Only used by the producer
+
+	std::mutex				m_mutex;
+	std::condition_variable	m_blockQueued;
+	std::vector<Block*>		m_freeBlocks;
+	std::vector<QueueEntry>	m_queue;			// Ring of entries for the writer thread, allocated up front
+	size_t					m_queueHead;		// Oldest entry
+	size_t					m_queueSize;
+	size_t					m_queuedBlockCount;
+	bool					m_stopping;
+	Statistics				m_statistics;
+
+	std::string				m_fileDirectory;
+	const char*				m_fileNameFormat;
+
+	bool					m_isOpen;			// Only used by the producer
+	int						m_fd;				// Owned by the writer thread while it runs
+	std::thread				m_writerThread;
+};
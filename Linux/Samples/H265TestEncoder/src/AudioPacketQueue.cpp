@@ -0,0 +1,115 @@
+/* -LICENSE-START-
+ ** Copyright (c) 2016 Blackmagic Design
+ **  
+ ** Permission is hereby granted, free of charge, to any person or organization 
+ ** obtaining a copy of the software and accompanying documentation (the 
+ ** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+ ** and transmit the Software, and to prepare derivative works of the Software, 
+ ** and to permit third-parties to whom the Software is furnished to do so, in 
+ ** accordance with:
+ ** 
+ ** (1) if the Software is obtained from Blackmagic Design, the End User License 
+ ** Agreement for the Software Development Kit (“EULA”) available at 
+ ** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+ ** 
+ ** (2) if the Software is obtained from any third party, such licensing terms 
+ ** as notified by that third party,
+ ** 
+ ** and all subject to the following:
+ ** 
+ ** (3) the copyright notices in the Software and this entire statement, 
+ ** including the above license grant, this restriction and the following 
+ ** disclaimer, must be included in all copies of the Software, in whole or in 
+ ** part, and all derivative works of the Software, unless such copies or 
+ ** derivative works are solely in the form of machine-executable object code 
+ ** generated by a source language processor.
+ ** 
+ ** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ ** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ ** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+ ** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+ ** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+ ** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ ** DEALINGS IN THE SOFTWARE.
+ ** 
+ ** A copy of the Software is available free of charge at 
+ ** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+ ** 
+ ** -LICENSE-END-
+ */
+
+#include "AudioPacketQueue.h"
+
+#include <algorithm>
+#include <string.h>
+
+AudioPacketQueue::AudioPacketQueue(uint32_t slotCount, uint32_t framesPerSlot, uint32_t bytesPerFrame) :
+	m_packets(slotCount + 1),		// One slot is always empty to tell a full queue from an empty one
+	m_framesPerSlot(framesPerSlot),
+	m_bytesPerFrame(bytesPerFrame),
+	m_head(0),
+	m_tail(0),
+	m_droppedFrames(0)
+{
+	for (Packet& packet : m_packets)
+	{
+		packet.samples.resize(framesPerSlot * bytesPerFrame);
+		packet.frameCount = 0;
+		packet.streamTime = 0;
+	}
+}
+
+bool AudioPacketQueue::push(const void* samples, uint32_t frameCount, int64_t streamTime)
+{
+	const uint8_t*	data = (const uint8_t*)samples;
+	uint32_t		slotsNeeded = (frameCount + m_framesPerSlot - 1) / m_framesPerSlot;
+
+	// Queue all of the packet or none of it
+	if (slotsNeeded > capacity() - size())
+	{
+		m_droppedFrames.fetch_add(frameCount, std::memory_order_relaxed);
+		return false;
+	}
+
+	while (frameCount > 0)
+	{
+		uint32_t	head = m_head.load(std::memory_order_relaxed);
+		Packet&		packet = m_packets[head];
+		uint32_t	frames = std::min(frameCount, m_framesPerSlot);
+
+		memcpy(packet.samples.data(), data, frames * m_bytesPerFrame);
+		packet.frameCount = frames;
+		packet.streamTime = streamTime;
+
+		m_head.store((head + 1) % m_packets.size(), std::memory_order_release);
+
+		data += frames * m_bytesPerFrame;
+		frameCount -= frames;
+		streamTime += frames;
+	}
+
+	return true;
+}
+
+const AudioPacketQueue::Packet* AudioPacketQueue::front() const
+{
+	uint32_t tail = m_tail.load(std::memory_order_relaxed);
+	if (tail == m_head.load(std::memory_order_acquire))
+		return NULL;
+
+	return &m_packets[tail];
+}
+
+void AudioPacketQueue::pop()
+{
+	uint32_t tail = m_tail.load(std::memory_order_relaxed);
+	if (tail != m_head.load(std::memory_order_acquire))
+		m_tail.store((tail + 1) % m_packets.size(), std::memory_order_release);
+}
+
+uint32_t AudioPacketQueue::size() const
+{
+	uint32_t head = m_head.load(std::memory_order_acquire);
+	uint32_t tail = m_tail.load(std::memory_order_acquire);
+	return (head + m_packets.size() - tail) % m_packets.size();
+}
@@ -0,0 +1,81 @@
+/* -LICENSE-START-
+ ** Copyright (c) 2016 Blackmagic Design
+ **  
+ ** Permission is hereby granted, free of charge, to any person or organization 
+ ** obtaining a copy of the software and accompanying documentation (the 
+ ** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+ ** and transmit the Software, and to prepare derivative works of the Software, 
+ ** and to permit third-parties to whom the Software is furnished to do so, in 
+ ** accordance with:
+ ** 
+ ** (1) if the Software is obtained from Blackmagic Design, the End User License 
+ ** Agreement for the Software Development Kit (“EULA”) available at 
+ ** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+ ** 
+ ** (2) if the Software is obtained from any third party, such licensing terms 
+ ** as notified by that third party,
+ ** 
+ ** and all subject to the following:
+ ** 
+ ** (3) the copyright notices in the Software and this entire statement, 
+ ** including the above license grant, this restriction and the following 
+ ** disclaimer, must be included in all copies of the Software, in whole or in 
+ ** part, and all derivative works of the Software, unless such copies or 
+ ** derivative works are solely in the form of machine-executable object code 
+ ** generated by a source language processor.
+ ** 
+ ** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ ** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ ** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+ ** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+ ** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+ ** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ ** DEALINGS IN THE SOFTWARE.
+ ** 
+ ** A copy of the Software is available free of charge at 
+ ** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+ ** 
+ ** -LICENSE-END-
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <vector>
+
+// Single producer, single consumer queue of interleaved PCM audio.  The audio callback pushes packets without
+// locking or allocating, the thread that writes the file pops them.  Packets larger than a slot are split across
+// slots, and packets that don't fit in the free slots are dropped.
+class AudioPacketQueue
+{
+public:
+	struct Packet
+	{
+		std::vector<uint8_t>	samples;
+		uint32_t				frameCount;
+		int64_t					streamTime;		// In sample frames
+	};
+
+	AudioPacketQueue(uint32_t slotCount, uint32_t framesPerSlot, uint32_t bytesPerFrame);
+
+	// Producer
+	bool						push(const void* samples, uint32_t frameCount, int64_t streamTime);
+
+	// Consumer, the packet from front() stays valid until pop()
+	const Packet*				front() const;
+	void						pop();
+
+	uint32_t					size() const;
+	uint32_t					capacity() const { return m_packets.size() - 1; }
+	uint64_t					getDroppedFrames() const { return m_droppedFrames.load(std::memory_order_relaxed); }
+
+private:
+	std::vector<Packet>			m_packets;
+	uint32_t					m_framesPerSlot;
+	uint32_t					m_bytesPerFrame;
+
+	std::atomic<uint32_t>		m_head;			// Next slot to push, written by the producer
+	std::atomic<uint32_t>		m_tail;			// Next slot to pop, written by the consumer
+	std::atomic<uint64_t>		m_droppedFrames;
+};
@@ -43,12 +43,22 @@
 
 #include <QMessageBox>
 #include <QObject>
+#include <QTimer>
+
+#include <stdio.h>
 
 #include <DeckLinkAPI.h>
 
 static const int kMegabit = 1000000;
 
-ControllerImp::ControllerImp()
+// Encoder telemetry is served for scraping at http://localhost:<kMetricsHttpPort>/metrics
+static const uint16_t kMetricsHttpPort = 9465;
+static const int kTelemetryUpdateIntervalMs = 500;
+
+ControllerImp::ControllerImp() :
+	m_encoderTelemetry(m_metricsRegistry),
+	m_metricsServer(m_metricsRegistry),
+	m_telemetryTimer(NULL)
 {
 	m_currentBitrate = 20 * kMegabit;
 	m_selectedDevice = -1;
@@ -75,11 +85,25 @@ void ControllerImp::init(QObject* delegate)
 	Q_ASSERT(connected);
 	connected = QObject::connect(this, SIGNAL(restartCapture(uint32_t)), this, SLOT(restartCaptureRequested(uint32_t)));
 	Q_ASSERT(connected);
+	connected = QObject::connect(this, SIGNAL(telemetryUpdated(EncoderTelemetry::Summary)), m_uiDelegate, SLOT(telemetryUpdated(EncoderTelemetry::Summary)));
+	Q_ASSERT(connected);
+
+	m_telemetryTimer = new QTimer(this);
+	connected = QObject::connect(m_telemetryTimer, SIGNAL(timeout()), this, SLOT(onTelemetryTimer()));
+	Q_ASSERT(connected);
+
+	m_encoderTelemetry.setTargetBitrate(m_currentBitrate);
+
+	if (m_metricsServer.listenHttp(kMetricsHttpPort))
+		m_metricsServer.start();
+	else
+		fprintf(stderr, "Warning: Unable to listen for metrics requests on port %u\n", (unsigned)kMetricsHttpPort);
 }
 
 int ControllerImp::changeTargetRate(int rate)
 {
 	m_currentBitrate = rate;
+	m_encoderTelemetry.setTargetBitrate(rate);
 	return kNoError;
 }
 
@@ -109,13 +133,14 @@ int ControllerImp::startCapture(uint32_t mode)
 	if (device->isCapturing())
 		return kInvalidOpError;
 
-	if (!device->startCapture(m_selectedMode, m_currentBitrate))
+	if (!device->startCapture(m_selectedMode, m_currentBitrate, &m_encoderTelemetry))
 	{
 		m_selectedMode = device->defaultMode();
 		return kUnknownError;
 	}
 
 	emit recordingStarted(device->getDisplayModeName(m_selectedMode), device->getDisplayModeFrameRate(m_selectedMode));
+	m_telemetryTimer->start(kTelemetryUpdateIntervalMs);
 
 	return kNoError;
 }
@@ -128,6 +153,7 @@ int ControllerImp::stopCapture(bool deleteFile)
 	DeckLinkDevice* device = m_deviceList[m_selectedDevice];
 	if (device->isCapturing())
 	{
+		m_telemetryTimer->stop();
 		device->stopCapture(deleteFile);
 		emit recordingFinished();
 	}
@@ -142,6 +168,11 @@ void ControllerImp::restartCaptureRequested(uint32_t mode)
 	startCapture(mode);
 }
 
+void ControllerImp::onTelemetryTimer()
+{
+	emit telemetryUpdated(m_encoderTelemetry.getSummary());
+}
+
 void ControllerImp::newDeviceSelected()
 {
 	m_selectedDevice = 0;
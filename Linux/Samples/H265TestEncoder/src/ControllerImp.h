@@ -43,9 +43,14 @@
 #include <vector>
 #include <QObject>
 
+#include "EncoderTelemetry.h"
+#include "MetricsRegistry.h"
+#include "MetricsServer.h"
+
 class DeckLinkDeviceDiscovery;
 class DeckLinkDevice;
 class IDeckLink;
+class QTimer;
 
 class ControllerImp : public QObject
 {
@@ -85,6 +90,11 @@ public:
 	int m_selectedMode;
 	int m_currentBitrate;
 
+	MetricsRegistry m_metricsRegistry;
+	EncoderTelemetry m_encoderTelemetry;
+	MetricsServer m_metricsServer;
+	QTimer* m_telemetryTimer;
+
 public slots:
 	int		startStopCapture();
 	int		startStopCapture(uint32_t);
@@ -96,10 +106,14 @@ signals:
 	void	recordingFinished(void);
 	void	displayErrorMessage(const QString&, const QString&);
 	void	restartCapture(uint32_t);
+	void	telemetryUpdated(EncoderTelemetry::Summary);
 
 private:
 	int		startCapture(uint32_t);
 
 private slots:
 	void	restartCaptureRequested(uint32_t);
+	void	onTelemetryTimer();
 };
+
+Q_DECLARE_METATYPE(EncoderTelemetry::Summary)
@@ -54,7 +54,7 @@ static const int kMegabit = 1000000;
 ControlsWidget::ControlsWidget() : m_frameRate(0)
 {
 	setObjectName("ControlsWidget");
-	setFixedSize(598, 200);
+	setFixedSize(598, 244);
 	setStyleSheet(PSS(
 					  "QWidget { background: kColour3; }"
 					  "QLabel { margin: 0; spacing: 0;}"
@@ -135,6 +135,16 @@ ControlsWidget::ControlsWidget() : m_frameRate(0)
 	line->setStyleSheet(PSS("QWidget { background: kColour2; }"));
 	layout->addWidget(line, 0, Qt::AlignHCenter);
 
+	// What the encoder actually produces, updated while recording
+	QHBoxLayout* layoutR2 = new TightHBoxLayout;
+	layout->addSpacing(12);
+
+	m_bitrateLabel = addTelemetryColumn(layoutR2, "ACTUAL BITRATE");
+	m_latencyLabel = addTelemetryColumn(layoutR2, "ENCODE LATENCY");
+	m_keyframeIntervalLabel = addTelemetryColumn(layoutR2, "KEYFRAME INTERVAL");
+
+	layout->addLayout(layoutR2);
+
 	QHBoxLayout* layoutR3 = new TightHBoxLayout;
 	layoutR3->addSpacing(18);
 
@@ -160,6 +170,30 @@ ControlsWidget::ControlsWidget() : m_frameRate(0)
 	connect(m_updateTimer, SIGNAL(timeout()), this, SLOT(onUpdateTime()));
 }
 
+QLabel* ControlsWidget::addTelemetryColumn(QHBoxLayout* layout, const QString& title)
+{
+	QVBoxLayout* vertLayout = new TightVBoxLayout;
+
+	QLabel* titleLabel = new QLabel(title);
+	titleLabel->setFont(CommonGui::font(CommonGui::kIcemanSemibold));
+	titleLabel->setStyleSheet(PSS("QLabel { color: kColour5; padding-top: -3px;}"));
+	titleLabel->setAlignment(Qt::AlignTop | Qt::AlignLeft);
+	titleLabel->setIndent(0);
+	titleLabel->setFixedSize(186, 22);
+	vertLayout->addWidget(titleLabel);
+
+	QLabel* valueLabel = new QLabel("-");
+	valueLabel->setFont(CommonGui::font(CommonGui::kGalactusLight));
+	valueLabel->setStyleSheet(PSS("QLabel { color: kColour4; padding-top: -3px;}"));
+	valueLabel->setAlignment(Qt::AlignTop | Qt::AlignLeft);
+	valueLabel->setIndent(0);
+	valueLabel->setFixedWidth(186);
+	vertLayout->addWidget(valueLabel);
+
+	layout->addLayout(vertLayout);
+	return valueLabel;
+}
+
 void ControlsWidget::onSpeedChanged(int value)
 {
 	int bitrate = value * kSpeedStepSize;
@@ -175,6 +209,10 @@ void ControlsWidget::onRecordingStarted(QString displayMode, uint32_t frameRate)
 	m_speedSlider->setEnabled(false);
 	m_recordButton->setImage(":/Record_stop");
 
+	m_bitrateLabel->setText("-");
+	m_latencyLabel->setText("-");
+	m_keyframeIntervalLabel->setText("-");
+
 	m_recordTime.start();
 	m_updateTimer->start(1000 / frameRate);
 }
@@ -190,6 +228,21 @@ void ControlsWidget::onRecordingStopped()
 	m_frameRate = 0;
 }
 
+void ControlsWidget::onTelemetryUpdated(const EncoderTelemetry::Summary& summary)
+{
+	// One second averages, the bitrate of single frames swings too far between keyframes and inter frames
+	QString bitrate = QString("%1Mb/s").arg(summary.windowBitrate / kMegabit, 0, 'f', 1);
+	if (summary.targetBitrate > 0)
+		bitrate += QString(" (%1%)").arg(qRound(100.0 * summary.windowBitrate / summary.targetBitrate));
+	m_bitrateLabel->setText(bitrate);
+
+	if (summary.windowLatencyMs > 0)
+		m_latencyLabel->setText(QString("%1ms (max %2)").arg(qRound(summary.windowLatencyMs)).arg(qRound(summary.maxWindowLatencyMs)));
+
+	if (summary.keyframeInterval > 0)
+		m_keyframeIntervalLabel->setText(QString("%1 frames").arg(summary.keyframeInterval));
+}
+
 void ControlsWidget::onUpdateTime()
 {
 	updateTimeLabel(m_recordTime.elapsed());
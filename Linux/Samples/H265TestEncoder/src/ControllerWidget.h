@@ -47,6 +47,9 @@
 #include <QTime>
 #include <vector>
 
+#include "EncoderTelemetry.h"
+
+class QHBoxLayout;
 class QTimer;
 class FlatImageButton;
 
@@ -76,6 +79,7 @@ public:
 
 	void onRecordingStarted(QString, uint32_t);
 	void onRecordingStopped();
+	void onTelemetryUpdated(const EncoderTelemetry::Summary& summary);
 
 signals:
 	void speedChanged(int bitrate);
@@ -88,10 +92,14 @@ private:
 	static const int kSpeedStepSize = 500000; // bits
 
 	void updateTimeLabel(int ms);
+	QLabel* addTelemetryColumn(QHBoxLayout* layout, const QString& title);
 
 	QLabel* m_speedLabel;
 	TimeCodeLabel* m_tcLabel;
 	QLabel* m_modeLabel;
+	QLabel* m_bitrateLabel;
+	QLabel* m_latencyLabel;
+	QLabel* m_keyframeIntervalLabel;
 
 	QTime m_recordTime;
 	int m_recordedDurationMs;
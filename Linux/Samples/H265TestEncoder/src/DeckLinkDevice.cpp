@@ -46,11 +46,21 @@ using namespace std;
 #include <QStandardPaths>
 #include <QTime>
 
+// Stereo 16-bit PCM, recorded alongside the encoded video
+static const BMDAudioSampleRate	kAudioSampleRate		= bmdAudioSampleRate48kHz;
+static const BMDAudioSampleType	kAudioSampleType		= bmdAudioSampleType16bitInteger;
+static const uint32_t			kAudioChannelCount		= 2;
+
+// Recordings are split into segments of about this many seconds, cut at keyframes, with an HLS playlist
+static const uint32_t			kSegmentDuration		= 6;
+
 DeckLinkDevice::DeckLinkDevice(ControllerImp* ui, IDeckLink* device) :
 	m_deckLink(device),
 	m_deckLinkEncoderInput(NULL),
 	m_deckLinkEncoderConfiguration(NULL),
 	m_videoWriter(NULL),
+	m_telemetry(NULL),
+	m_timeScale(0),
 	m_currentlyCapturing(false),
 	m_uiDelegate(ui),
 	m_defaultMode(0),
@@ -155,7 +165,7 @@ bool DeckLinkDevice::init()
 	return true;
 }
 
-bool DeckLinkDevice::startCapture(int videoModeIndex, uint32_t bitrate)
+bool DeckLinkDevice::startCapture(int videoModeIndex, uint32_t bitrate, EncoderTelemetry* telemetry)
 {
 	BMDVideoInputFlags videoInputFlags;
 	
@@ -171,9 +181,10 @@ bool DeckLinkDevice::startCapture(int videoModeIndex, uint32_t bitrate)
 	m_modeList[videoModeIndex]->GetFrameRate(&duration, &timeScale);
 
 	QString filePath = QStandardPaths::writableLocation(QStandardPaths::MoviesLocation);
-	QString fileName = filePath + "/BlackmagicDesign_Recording " + QDateTime::currentDateTime().toString("yyyy-MM-dd HH.mm.ss") + ".hevc";
+	QString fileName = filePath + "/BlackmagicDesign_Recording " + QDateTime::currentDateTime().toString("yyyy-MM-dd HH.mm.ss");
 
-	m_videoWriter = new VideoWriter(fileName);
+	m_timeScale = timeScale;
+	m_videoWriter = new VideoWriter(fileName, duration, timeScale, kAudioSampleRate, kAudioChannelCount, kAudioSampleType, kSegmentDuration);
 	if (!m_videoWriter)
 	{
 		m_uiDelegate->showErrorMessage("Error starting recording", "Failed to allocate video writer");
@@ -182,7 +193,7 @@ bool DeckLinkDevice::startCapture(int videoModeIndex, uint32_t bitrate)
 
 	if (!m_videoWriter->open())
 	{
-		m_uiDelegate->showErrorMessage("Error starting recording", "Failed to open output file");
+		m_uiDelegate->showErrorMessage("Error starting recording", "Failed to create output files");
 		return false;
 	}
 
@@ -220,6 +231,16 @@ bool DeckLinkDevice::startCapture(int videoModeIndex, uint32_t bitrate)
 		return false;
 	}
 
+	if (m_deckLinkEncoderInput->EnableAudioInput(bmdAudioFormatPCM, kAudioSampleRate, kAudioSampleType, kAudioChannelCount) != S_OK)
+	{
+		m_uiDelegate->showErrorMessage("Error starting recording", "This application was unable to enable audio input.");
+		return false;
+	}
+
+	m_telemetry = telemetry;
+	if (m_telemetry)
+		m_telemetry->start(duration, timeScale, bitrate);
+
 	if (m_deckLinkEncoderInput->StartStreams() != S_OK)
 	{
 		m_uiDelegate->showErrorMessage("Error starting the capture", "This application was unable to start the capture. Perhaps, the selected device is currently in-use.");
@@ -236,6 +257,13 @@ void DeckLinkDevice::stopCapture(bool deleteFile)
 	m_deckLinkEncoderInput->StopStreams();
 	m_deckLinkEncoderInput->SetCallback(NULL);
 	m_deckLinkEncoderInput->DisableVideoInput();
+	m_deckLinkEncoderInput->DisableAudioInput();
+
+	if (m_telemetry)
+	{
+		m_telemetry->stop();
+		m_telemetry = NULL;
+	}
 
 	if (m_videoWriter)
 	{
@@ -293,20 +321,61 @@ QString DeckLinkDevice::getDisplayModeName(int displayModeIndex)
 
 HRESULT DeckLinkDevice::VideoPacketArrived(IDeckLinkEncoderVideoPacket* videoPacket)
 {
-	void* buffer = NULL;
-	videoPacket->GetBytes(&buffer);
+	if (!m_videoWriter || videoPacket->GetPacketType() != bmdPacketTypeStreamData)
+		return S_OK;
 
-	if (buffer && m_videoWriter)
+	// Each packet is a single NAL unit, the muxer groups them into access units by stream time
+	IDeckLinkH265NALPacket* nalPacket = NULL;
+	if (videoPacket->QueryInterface(IID_IDeckLinkH265NALPacket, (void**)&nalPacket) != S_OK)
+		return S_OK;
+
+	uint8_t			unitType = 0;
+	void*			buffer = NULL;
+	BMDTimeValue	streamTime = 0;
+
+	if (nalPacket->GetUnitType(&unitType) == S_OK &&
+		nalPacket->GetBytesNoPrefix(&buffer) == S_OK && buffer &&
+		nalPacket->GetStreamTime(&streamTime, m_timeScale) == S_OK)
 	{
-		if (videoPacket->GetPacketType() == bmdPacketTypeStreamData)
-			m_videoWriter->writeVideo((uint8_t*)buffer, videoPacket->GetSize());
+		if (m_telemetry)
+			m_telemetry->addVideoPacket(unitType, videoPacket->GetSize(), streamTime, getEncodeLatency(videoPacket));
+
+		m_videoWriter->writeVideo(unitType, (uint8_t*)buffer, nalPacket->GetSizeNoPrefix(), streamTime);
 	}
 
+	nalPacket->Release();
 	return S_OK;
 }
 
-HRESULT DeckLinkDevice::AudioPacketArrived(IDeckLinkEncoderAudioPacket*)
+int64_t DeckLinkDevice::getEncodeLatency(IDeckLinkEncoderVideoPacket* videoPacket)
 {
+	// Time since the frame was input, both read from the hardware reference clock, or -1 if unavailable
+	BMDTimeValue	frameTime = 0;
+	BMDTimeValue	frameDuration = 0;
+	BMDTimeValue	hardwareTime = 0;
+	BMDTimeValue	timeInFrame = 0;
+	BMDTimeValue	ticksPerFrame = 0;
+
+	if (videoPacket->GetHardwareReferenceTimestamp(m_timeScale, &frameTime, &frameDuration) != S_OK ||
+		m_deckLinkEncoderInput->GetHardwareReferenceClock(m_timeScale, &hardwareTime, &timeInFrame, &ticksPerFrame) != S_OK)
+		return -1;
+
+	return (hardwareTime >= frameTime) ? hardwareTime - frameTime : -1;
+}
+
+HRESULT DeckLinkDevice::AudioPacketArrived(IDeckLinkEncoderAudioPacket* audioPacket)
+{
+	if (!m_videoWriter || audioPacket->GetAudioFormat() != bmdAudioFormatPCM)
+		return S_OK;
+
+	// Stream time in sample frames, on the same clock as the video packets' stream time
+	void*			buffer = NULL;
+	BMDTimeValue	streamTime = 0;
+
+	if (audioPacket->GetBytes(&buffer) == S_OK && buffer &&
+		audioPacket->GetStreamTime(&streamTime, kAudioSampleRate) == S_OK)
+		m_videoWriter->writeAudio(buffer, audioPacket->GetSize(), streamTime);
+
 	return S_OK;
 }
 
@@ -40,6 +40,7 @@
 #pragma once
 
 #include "ControllerImp.h"
+#include "EncoderTelemetry.h"
 #include "VideoWriter.h"
 
 #include "DeckLinkAPI.h"
@@ -73,7 +74,7 @@ public:
 	QString						getDisplayModeName(int displayModeIndex);
 
 	bool						isCapturing() { return m_currentlyCapturing; }
-	bool						startCapture(int videoModeIndex, uint32_t bitrate) ;
+	bool						startCapture(int videoModeIndex, uint32_t bitrate, EncoderTelemetry* telemetry = NULL);
 	void						stopCapture(bool deleteFile = false);
 	
 	int							defaultMode() { return m_defaultMode; }
@@ -84,12 +85,16 @@ public:
 	IDeckLinkEncoderConfiguration*	m_deckLinkEncoderConfiguration;
 
 	VideoWriter*				m_videoWriter;
+	EncoderTelemetry*			m_telemetry;
+	BMDTimeScale				m_timeScale;
 
 	bool						m_currentlyCapturing;
 
 	
 private:
 
+	int64_t					getEncodeLatency(IDeckLinkEncoderVideoPacket* videoPacket);
+
 	ControllerImp*			m_uiDelegate;
 	std::vector<IDeckLinkDisplayMode*>	m_modeList;
 	int					m_defaultMode;
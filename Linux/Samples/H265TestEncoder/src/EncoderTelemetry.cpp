@@ -0,0 +1,238 @@
+/* -LICENSE-START-
+ ** Copyright (c) 2016 Blackmagic Design
+ **  
+ ** Permission is hereby granted, free of charge, to any person or organization 
+ ** obtaining a copy of the software and accompanying documentation (the 
+ ** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+ ** and transmit the Software, and to prepare derivative works of the Software, 
+ ** and to permit third-parties to whom the Software is furnished to do so, in 
+ ** accordance with:
+ ** 
+ ** (1) if the Software is obtained from Blackmagic Design, the End User License 
+ ** Agreement for the Software Development Kit (“EULA”) available at 
+ ** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+ ** 
+ ** (2) if the Software is obtained from any third party, such licensing terms 
+ ** as notified by that third party,
+ ** 
+ ** and all subject to the following:
+ ** 
+ ** (3) the copyright notices in the Software and this entire statement, 
+ ** including the above license grant, this restriction and the following 
+ ** disclaimer, must be included in all copies of the Software, in whole or in 
+ ** part, and all derivative works of the Software, unless such copies or 
+ ** derivative works are solely in the form of machine-executable object code 
+ ** generated by a source language processor.
+ ** 
+ ** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ ** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ ** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+ ** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+ ** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+ ** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ ** DEALINGS IN THE SOFTWARE.
+ ** 
+ ** A copy of the Software is available free of charge at 
+ ** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+ ** 
+ ** -LICENSE-END-
+ */
+
+#include "EncoderTelemetry.h"
+#include "HEVCParser.h"
+
+#include <algorithm>
+
+static const uint32_t	kMaxWindowFrames			= 240;		// One second at the highest frame rate
+
+static const std::vector<double>	kPacketSizeBuckets			= { 64, 256, 1024, 4096, 16384, 65536, 262144, 1048576, 4194304 };
+static const std::vector<double>	kFrameSizeBuckets			= { 4096, 16384, 32768, 65536, 131072, 262144, 524288, 1048576, 2097152, 4194304, 8388608 };
+static const std::vector<double>	kLatencyBuckets				= { 5, 10, 15, 20, 25, 30, 40, 50, 60, 80, 100, 150, 200, 300, 500, 1000 };
+static const std::vector<double>	kKeyframeIntervalBuckets	= { 1, 2, 4, 8, 12, 15, 16, 24, 25, 30, 32, 48, 50, 60, 64, 120, 240, 300, 600 };
+
+EncoderTelemetry::EncoderTelemetry(MetricsRegistry& registry) :
+	m_frameDuration(1),
+	m_timeScale(1),
+	m_hasFrame(false),
+	m_frameStreamTime(0),
+	m_frameSize(0),
+	m_frameLatency(-1),
+	m_frameIsKeyframe(false),
+	m_framesSinceKeyframe(-1),
+	m_window(kMaxWindowFrames),
+	m_windowLength(1),
+	m_windowNext(0),
+	m_windowCount(0),
+	m_windowSize(0),
+	m_windowLatencySum(0),
+	m_windowLatencyCount(0),
+	m_activeMetric(registry.addGauge("decklink_encoder_active", "Set to 1 while the encoder is recording")),
+	m_packetsMetric(registry.addCounter("decklink_encoder_packets_total", "Number of NAL unit packets from the encoder")),
+	m_bytesMetric(registry.addCounter("decklink_encoder_bytes_total", "Number of bytes of encoded video")),
+	m_keyframesMetric(registry.addCounter("decklink_encoder_keyframes_total", "Number of IRAP frames from the encoder")),
+	m_packetSizeMetric(registry.addHistogram("decklink_encoder_packet_size_bytes", "Size of each NAL unit packet", kPacketSizeBuckets)),
+	m_keyframeSizeMetric(registry.addHistogram("decklink_encoder_frame_size_bytes", "Size of each encoded frame", kFrameSizeBuckets, "type=\"keyframe\"")),
+	m_interFrameSizeMetric(registry.addHistogram("decklink_encoder_frame_size_bytes", "Size of each encoded frame", kFrameSizeBuckets, "type=\"inter\"")),
+	m_latencyMetric(registry.addHistogram("decklink_encoder_latency_milliseconds", "Time from frame input to its last packet, on the hardware reference clock", kLatencyBuckets)),
+	m_keyframeIntervalMetric(registry.addHistogram("decklink_encoder_keyframe_interval_frames", "Frames between consecutive keyframes", kKeyframeIntervalBuckets)),
+	m_targetBitrateMetric(registry.addGauge("decklink_encoder_target_bitrate_bits_per_second", "Bitrate requested from the encoder")),
+	m_frameBitrateMetric(registry.addFloatGauge("decklink_encoder_bitrate_bits_per_second", "Encoded bitrate", "window=\"frame\"")),
+	m_windowBitrateMetric(registry.addFloatGauge("decklink_encoder_bitrate_bits_per_second", "Encoded bitrate", "window=\"1s\"")),
+	m_lastLatencyMetric(registry.addFloatGauge("decklink_encoder_recent_latency_milliseconds", "Encode latency of recent frames", "window=\"frame\",statistic=\"last\"")),
+	m_meanLatencyMetric(registry.addFloatGauge("decklink_encoder_recent_latency_milliseconds", "Encode latency of recent frames", "window=\"1s\",statistic=\"mean\"")),
+	m_maxLatencyMetric(registry.addFloatGauge("decklink_encoder_recent_latency_milliseconds", "Encode latency of recent frames", "window=\"1s\",statistic=\"max\"")),
+	m_lastKeyframeIntervalMetric(registry.addGauge("decklink_encoder_last_keyframe_interval_frames", "Frames between the last two keyframes"))
+{
+}
+
+void EncoderTelemetry::start(int64_t frameDuration, int64_t timeScale, uint32_t targetBitrate)
+{
+	m_frameDuration	= std::max<int64_t>(frameDuration, 1);
+	m_timeScale		= std::max<int64_t>(timeScale, 1);
+	m_windowLength	= (uint32_t)std::min<int64_t>(std::max<int64_t>((m_timeScale + m_frameDuration / 2) / m_frameDuration, 1), kMaxWindowFrames);
+
+	m_hasFrame				= false;
+	m_framesSinceKeyframe	= -1;
+	m_windowNext			= 0;
+	m_windowCount			= 0;
+	m_windowSize			= 0;
+	m_windowLatencySum		= 0;
+	m_windowLatencyCount	= 0;
+
+	m_frameBitrateMetric.set(0.0);
+	m_windowBitrateMetric.set(0.0);
+	m_lastLatencyMetric.set(0.0);
+	m_meanLatencyMetric.set(0.0);
+	m_maxLatencyMetric.set(0.0);
+	m_lastKeyframeIntervalMetric.set(0);
+
+	setTargetBitrate(targetBitrate);
+	m_activeMetric.set(1);
+}
+
+void EncoderTelemetry::stop()
+{
+	// Streams have stopped, so the callback thread has delivered the last packet of the last frame
+	if (m_hasFrame)
+		completeFrame();
+
+	m_activeMetric.set(0);
+}
+
+void EncoderTelemetry::setTargetBitrate(uint32_t targetBitrate)
+{
+	m_targetBitrateMetric.set(targetBitrate);
+}
+
+void EncoderTelemetry::addVideoPacket(uint8_t nalType, uint32_t size, int64_t streamTime, int64_t latency)
+{
+	// All of a frame's NAL units share its stream time
+	if (m_hasFrame && streamTime != m_frameStreamTime)
+		completeFrame();
+
+	if (!m_hasFrame)
+	{
+		m_hasFrame			= true;
+		m_frameStreamTime	= streamTime;
+		m_frameSize			= 0;
+		m_frameLatency		= -1;
+		m_frameIsKeyframe	= false;
+	}
+
+	m_frameSize += size;
+	if (nalType >= kHEVCNALTypeBLAWithLeadingPictures && nalType <= kHEVCNALTypeCRA)
+		m_frameIsKeyframe = true;
+
+	// The frame is complete when its last packet arrives
+	if (latency >= 0)
+		m_frameLatency = latency;
+
+	m_packetsMetric.increment();
+	m_bytesMetric.increment(size);
+	m_packetSizeMetric.observe(size);
+}
+
+void EncoderTelemetry::completeFrame()
+{
+	m_hasFrame = false;
+
+	if (m_frameIsKeyframe)
+	{
+		m_keyframesMetric.increment();
+		m_keyframeSizeMetric.observe(m_frameSize);
+
+		if (m_framesSinceKeyframe > 0)
+		{
+			m_keyframeIntervalMetric.observe((double)m_framesSinceKeyframe);
+			m_lastKeyframeIntervalMetric.set(m_framesSinceKeyframe);
+		}
+		m_framesSinceKeyframe = 0;
+	}
+	else
+	{
+		m_interFrameSizeMetric.observe(m_frameSize);
+	}
+
+	if (m_framesSinceKeyframe >= 0)
+		m_framesSinceKeyframe++;
+
+	// Replace the oldest frame in the window once it is full
+	FrameRecord& record = m_window[m_windowNext];
+
+	if (m_windowCount == m_windowLength)
+	{
+		m_windowSize -= record.size;
+		if (record.latency >= 0)
+		{
+			m_windowLatencySum -= record.latency;
+			m_windowLatencyCount--;
+		}
+	}
+	else
+	{
+		m_windowCount++;
+	}
+
+	record.size		= m_frameSize;
+	record.latency	= m_frameLatency;
+	m_windowNext	= (m_windowNext + 1) % m_windowLength;
+
+	m_windowSize += record.size;
+	if (record.latency >= 0)
+	{
+		m_windowLatencySum += record.latency;
+		m_windowLatencyCount++;
+	}
+
+	double frameSeconds = (double)m_frameDuration / m_timeScale;
+
+	m_frameBitrateMetric.set(m_frameSize * 8.0 / frameSeconds);
+	m_windowBitrateMetric.set(m_windowSize * 8.0 / (m_windowCount * frameSeconds));
+
+	if (m_frameLatency >= 0)
+	{
+		int64_t maxLatency = 0;
+		for (uint32_t i = 0; i < m_windowCount; i++)
+			maxLatency = std::max(maxLatency, m_window[i].latency);
+
+		m_latencyMetric.observe(toMilliseconds(m_frameLatency));
+		m_lastLatencyMetric.set(toMilliseconds(m_frameLatency));
+		m_meanLatencyMetric.set(toMilliseconds(m_windowLatencySum) / m_windowLatencyCount);
+		m_maxLatencyMetric.set(toMilliseconds(maxLatency));
+	}
+}
+
+EncoderTelemetry::Summary EncoderTelemetry::getSummary() const
+{
+	Summary summary;
+
+	summary.targetBitrate		= (double)m_targetBitrateMetric.getValue();
+	summary.frameBitrate		= m_frameBitrateMetric.getValue();
+	summary.windowBitrate		= m_windowBitrateMetric.getValue();
+	summary.latencyMs			= m_lastLatencyMetric.getValue();
+	summary.windowLatencyMs		= m_meanLatencyMetric.getValue();
+	summary.maxWindowLatencyMs	= m_maxLatencyMetric.getValue();
+	summary.keyframeInterval	= m_lastKeyframeIntervalMetric.getValue();
+
+	return summary;
+}
@@ -0,0 +1,123 @@
+/* -LICENSE-START-
+ ** Copyright (c) 2016 Blackmagic Design
+ **  
+ ** Permission is hereby granted, free of charge, to any person or organization 
+ ** obtaining a copy of the software and accompanying documentation (the 
+ ** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+ ** and transmit the Software, and to prepare derivative works of the Software, 
+ ** and to permit third-parties to whom the Software is furnished to do so, in 
+ ** accordance with:
+ ** 
+ ** (1) if the Software is obtained from Blackmagic Design, the End User License 
+ ** Agreement for the Software Development Kit (“EULA”) available at 
+ ** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+ ** 
+ ** (2) if the Software is obtained from any third party, such licensing terms 
+ ** as notified by that third party,
+ ** 
+ ** and all subject to the following:
+ ** 
+ ** (3) the copyright notices in the Software and this entire statement, 
+ ** including the above license grant, this restriction and the following 
+ ** disclaimer, must be included in all copies of the Software, in whole or in 
+ ** part, and all derivative works of the Software, unless such copies or 
+ ** derivative works are solely in the form of machine-executable object code 
+ ** generated by a source language processor.
+ ** 
+ ** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ ** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ ** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+ ** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+ ** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+ ** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ ** DEALINGS IN THE SOFTWARE.
+ ** 
+ ** A copy of the Software is available free of charge at 
+ ** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+ ** 
+ ** -LICENSE-END-
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <vector>
+
+#include "MetricsRegistry.h"
+
+// Measures what the hardware encoder actually produces: packet and frame sizes, bitrate over the last frame and
+// the last second, keyframe interval and encode latency.  Packets are added on the encoder callback thread
+// without locking or allocating, the results are published as metrics that any thread can read.
+class EncoderTelemetry
+{
+public:
+	struct Summary
+	{
+		double					targetBitrate;			// Bits per second
+		double					frameBitrate;			// Last frame's size at the frame rate, bits per second
+		double					windowBitrate;			// Over the last second, bits per second
+		double					latencyMs;				// Input to the last packet of the last frame
+		double					windowLatencyMs;		// Mean over the last second
+		double					maxWindowLatencyMs;		// Maximum over the last second
+		int64_t					keyframeInterval;		// Frames between the last two keyframes, 0 before the second
+	};
+
+	EncoderTelemetry(MetricsRegistry& registry);
+
+	// frameDuration and timeScale are those of the display mode, latencies are given in the same time scale
+	void						start(int64_t frameDuration, int64_t timeScale, uint32_t targetBitrate);
+	void						stop();
+	void						setTargetBitrate(uint32_t targetBitrate);
+
+	// Called on the encoder callback thread for each NAL unit, latency is negative when it is unknown
+	void						addVideoPacket(uint8_t nalType, uint32_t size, int64_t streamTime, int64_t latency);
+
+	Summary						getSummary() const;
+
+private:
+	struct FrameRecord
+	{
+		uint32_t				size;
+		int64_t					latency;
+	};
+
+	void						completeFrame();
+	double						toMilliseconds(int64_t duration) const { return duration * 1000.0 / m_timeScale; }
+
+	int64_t						m_frameDuration;
+	int64_t						m_timeScale;
+
+	// Frame being assembled, and the frames in the last second, owned by the encoder callback thread
+	bool						m_hasFrame;
+	int64_t						m_frameStreamTime;
+	uint32_t					m_frameSize;
+	int64_t						m_frameLatency;
+	bool						m_frameIsKeyframe;
+	int64_t						m_framesSinceKeyframe;	// Negative before the first keyframe
+
+	std::vector<FrameRecord>	m_window;
+	uint32_t					m_windowLength;			// Frames in a full window
+	uint32_t					m_windowNext;
+	uint32_t					m_windowCount;
+	uint64_t					m_windowSize;
+	int64_t						m_windowLatencySum;
+	uint32_t					m_windowLatencyCount;
+
+	MetricGauge&				m_activeMetric;
+	MetricCounter&				m_packetsMetric;
+	MetricCounter&				m_bytesMetric;
+	MetricCounter&				m_keyframesMetric;
+	MetricHistogram&			m_packetSizeMetric;
+	MetricHistogram&			m_keyframeSizeMetric;
+	MetricHistogram&			m_interFrameSizeMetric;
+	MetricHistogram&			m_latencyMetric;
+	MetricHistogram&			m_keyframeIntervalMetric;
+	MetricGauge&				m_targetBitrateMetric;
+	MetricFloatGauge&			m_frameBitrateMetric;
+	MetricFloatGauge&			m_windowBitrateMetric;
+	MetricFloatGauge&			m_lastLatencyMetric;
+	MetricFloatGauge&			m_meanLatencyMetric;
+	MetricFloatGauge&			m_maxLatencyMetric;
+	MetricGauge&				m_lastKeyframeIntervalMetric;
+};
@@ -0,0 +1,336 @@
+/* -LICENSE-START-
+ ** Copyright (c) 2016 Blackmagic Design
+ **  
+ ** Permission is hereby granted, free of charge, to any person or organization 
+ ** obtaining a copy of the software and accompanying documentation (the 
+ ** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+ ** and transmit the Software, and to prepare derivative works of the Software, 
+ ** and to permit third-parties to whom the Software is furnished to do so, in 
+ ** accordance with:
+ ** 
+ ** (1) if the Software is obtained from Blackmagic Design, the End User License 
+ ** Agreement for the Software Development Kit (“EULA”) available at 
+ ** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+ ** 
+ ** (2) if the Software is obtained from any third party, such licensing terms 
+ ** as notified by that third party,
+ ** 
+ ** and all subject to the following:
+ ** 
+ ** (3) the copyright notices in the Software and this entire statement, 
+ ** including the above license grant, this restriction and the following 
+ ** disclaimer, must be included in all copies of the Software, in whole or in 
+ ** part, and all derivative works of the Software, unless such copies or 
+ ** derivative works are solely in the form of machine-executable object code 
+ ** generated by a source language processor.
+ ** 
+ ** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ ** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ ** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+ ** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+ ** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+ ** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ ** DEALINGS IN THE SOFTWARE.
+ ** 
+ ** A copy of the Software is available free of charge at 
+ ** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+ ** 
+ ** -LICENSE-END-
+ */
+
+#include "HEVCParser.h"
+
+#include <stddef.h>
+#include <algorithm>
+
+namespace
+{
+	// Reads an RBSP, skipping emulation prevention bytes
+	class BitReader
+	{
+	public:
+		BitReader(const uint8_t* data, size_t size) : m_data(data), m_size(size), m_offset(0), m_bit(0), m_zeros(0) { }
+
+		uint32_t readBits(int count)
+		{
+			uint32_t value = 0;
+			while (count-- > 0)
+			{
+				if (m_offset >= m_size)
+					return value << (count + 1);
+
+				value = (value << 1) | ((m_data[m_offset] >> (7 - m_bit)) & 1);
+				if (++m_bit == 8)
+					nextByte();
+			}
+			return value;
+		}
+
+		uint32_t readExpGolomb()
+		{
+			int leadingZeros = 0;
+			while (readBits(1) == 0 && leadingZeros < 32)
+				leadingZeros++;
+			return ((1u << leadingZeros) - 1) + readBits(leadingZeros);
+		}
+
+		bool isValid() const { return m_offset < m_size; }
+
+	private:
+		void nextByte()
+		{
+			m_zeros = (m_data[m_offset] == 0) ? m_zeros + 1 : 0;
+			m_bit = 0;
+			m_offset++;
+			if (m_zeros >= 2 && m_offset < m_size && m_data[m_offset] == 3)
+			{
+				m_zeros = 0;
+				m_offset++;
+			}
+		}
+
+		const uint8_t*	m_data;
+		size_t			m_size;
+		size_t			m_offset;
+		int				m_bit;
+		int				m_zeros;
+	};
+}
+
+bool HEVCParseSPS(const std::vector<uint8_t>& sps, HEVCSequenceInfo* info)
+{
+	if (sps.size() < 16)
+		return false;
+
+	// Skip the two byte NAL unit header
+	BitReader reader(sps.data() + 2, sps.size() - 2);
+
+	reader.readBits(4);		// sps_video_parameter_set_id
+	info->maxSubLayersMinus1 = reader.readBits(3);
+	info->temporalIdNesting = reader.readBits(1);
+
+	for (int i = 0; i < 12; i++)
+		info->profileTierLevel[i] = reader.readBits(8);
+
+	bool subLayerProfilePresent[8];
+	bool subLayerLevelPresent[8];
+	for (int i = 0; i < info->maxSubLayersMinus1; i++)
+	{
+		subLayerProfilePresent[i] = reader.readBits(1);
+		subLayerLevelPresent[i] = reader.readBits(1);
+	}
+	if (info->maxSubLayersMinus1 > 0)
+	{
+		for (int i = info->maxSubLayersMinus1; i < 8; i++)
+			reader.readBits(2);
+	}
+	for (int i = 0; i < info->maxSubLayersMinus1; i++)
+	{
+		if (subLayerProfilePresent[i])
+		{
+			reader.readBits(32);
+			reader.readBits(32);
+			reader.readBits(24);
+		}
+		if (subLayerLevelPresent[i])
+			reader.readBits(8);
+	}
+
+	reader.readExpGolomb();		// sps_seq_parameter_set_id
+	info->chromaFormat = reader.readExpGolomb();
+	info->separateColourPlane = (info->chromaFormat == 3) ? reader.readBits(1) : 0;
+
+	info->width = reader.readExpGolomb();
+	info->height = reader.readExpGolomb();
+
+	if (reader.readBits(1))
+	{
+		// Conformance window offsets are in chroma sample units
+		uint32_t subWidth = (info->chromaFormat == 1 || info->chromaFormat == 2) ? 2 : 1;
+		uint32_t subHeight = (info->chromaFormat == 1) ? 2 : 1;
+		uint32_t left = reader.readExpGolomb();
+		uint32_t right = reader.readExpGolomb();
+		uint32_t top = reader.readExpGolomb();
+		uint32_t bottom = reader.readExpGolomb();
+		info->width -= subWidth * (left + right);
+		info->height -= subHeight * (top + bottom);
+	}
+
+	info->bitDepthLumaMinus8 = reader.readExpGolomb();
+	info->bitDepthChromaMinus8 = reader.readExpGolomb();
+	info->log2MaxPicOrderCountLsb = reader.readExpGolomb() + 4;
+
+	return reader.isValid() && info->chromaFormat <= 3 && info->bitDepthLumaMinus8 <= 8 && info->width > 0 && info->height > 0 &&
+		info->log2MaxPicOrderCountLsb <= 16;
+}
+
+bool HEVCParsePPS(const std::vector<uint8_t>& pps, HEVCPictureInfo* info)
+{
+	if (pps.size() < 4)
+		return false;
+
+	BitReader reader(pps.data() + 2, pps.size() - 2);
+
+	reader.readExpGolomb();		// pps_pic_parameter_set_id
+	reader.readExpGolomb();		// pps_seq_parameter_set_id
+	info->dependentSliceSegmentsEnabled = reader.readBits(1);
+	info->outputFlagPresent = reader.readBits(1);
+	info->numExtraSliceHeaderBits = reader.readBits(3);
+
+	return reader.isValid();
+}
+
+bool HEVCParsePicOrderCountLsb(const uint8_t* slice, uint32_t size, const HEVCSequenceInfo& sps, const HEVCPictureInfo& pps, uint32_t* picOrderCountLsb)
+{
+	if (size < 3)
+		return false;
+
+	uint8_t		nalType = (slice[0] >> 1) & 0x3f;
+	BitReader	reader(slice + 2, size - 2);
+
+	if (!reader.readBits(1))	// first_slice_segment_in_pic_flag
+		return false;
+
+	if (nalType >= kHEVCNALTypeBLAWithLeadingPictures && nalType <= kHEVCNALTypeReservedIRAP23)
+		reader.readBits(1);		// no_output_of_prior_pics_flag
+
+	reader.readExpGolomb();		// slice_pic_parameter_set_id
+	reader.readBits(pps.numExtraSliceHeaderBits);
+	reader.readExpGolomb();		// slice_type
+	if (pps.outputFlagPresent)
+		reader.readBits(1);		// pic_output_flag
+	if (sps.separateColourPlane)
+		reader.readBits(2);		// colour_plane_id
+
+	if (nalType == kHEVCNALTypeIDRWithRADL || nalType == kHEVCNALTypeIDRNoLeadingPictures)
+		*picOrderCountLsb = 0;
+	else
+		*picOrderCountLsb = reader.readBits(sps.log2MaxPicOrderCountLsb);
+
+	return reader.isValid();
+}
+
+HEVCPicOrderCounter::HEVCPicOrderCounter() :
+	m_isFirstPicture(true),
+	m_prevTid0PicOrderCount(0)
+{
+}
+
+int32_t HEVCPicOrderCounter::addPicture(uint8_t nalType, uint8_t temporalId, uint32_t picOrderCountLsb, uint8_t log2MaxPicOrderCountLsb)
+{
+	int32_t	maxLsb = 1 << log2MaxPicOrderCountLsb;
+	int32_t	lsb = (int32_t)picOrderCountLsb;
+	int32_t	msb = 0;
+	bool	isIRAP = (nalType >= kHEVCNALTypeBLAWithLeadingPictures && nalType <= kHEVCNALTypeReservedIRAP23);
+
+	// IDR and BLA pictures, and a CRA picture that starts the stream, reset the MSBs
+	if (!isIRAP || (nalType == kHEVCNALTypeCRA && !m_isFirstPicture))
+	{
+		int32_t prevLsb = m_prevTid0PicOrderCount & (maxLsb - 1);
+		int32_t prevMsb = m_prevTid0PicOrderCount - prevLsb;
+
+		if (lsb < prevLsb && prevLsb - lsb >= maxLsb / 2)
+			msb = prevMsb + maxLsb;
+		else if (lsb > prevLsb && lsb - prevLsb > maxLsb / 2)
+			msb = prevMsb - maxLsb;
+		else
+			msb = prevMsb;
+	}
+
+	int32_t picOrderCount = msb + lsb;
+
+	// RADL, RASL and sub-layer non-reference pictures are not used to derive the MSBs of later pictures
+	bool isLeading = (nalType >= kHEVCNALTypeRADLNonReference && nalType <= kHEVCNALTypeRASLReference);
+	bool isSubLayerNonReference = (nalType <= kHEVCNALTypeReservedVCL14 && (nalType & 1) == 0);
+
+	if (temporalId == 0 && !isLeading && !isSubLayerNonReference)
+		m_prevTid0PicOrderCount = picOrderCount;
+
+	m_isFirstPicture = false;
+	return picOrderCount;
+}
+
+HEVCAccessUnitParser::HEVCAccessUnitParser() :
+	m_hasCurrentAccessUnit(false),
+	m_currentHasSlice(false)
+{
+}
+
+bool HEVCAccessUnitParser::addNAL(uint8_t nalType, const uint8_t* nalUnit, uint32_t size, int64_t streamTime)
+{
+	bool isSlice = nalType < kHEVCNALTypeVPS;
+	bool firstSliceInPicture = isSlice && size > 2 && (nalUnit[2] & 0x80);
+	bool completed = false;
+
+	// The encoder gives each NAL unit of an access unit the same stream time
+	if (m_hasCurrentAccessUnit && m_currentHasSlice &&
+		(nalType == kHEVCNALTypeAUD || streamTime != m_currentAccessUnit.presentationTime || firstSliceInPicture))
+	{
+		std::swap(m_currentAccessUnit, m_completedAccessUnit);
+		m_hasCurrentAccessUnit = false;
+		completed = true;
+	}
+
+	if (!m_hasCurrentAccessUnit)
+	{
+		m_currentAccessUnit.data.clear();
+		m_currentAccessUnit.sliceType = 0;
+		m_currentAccessUnit.keyframe = false;
+		m_currentAccessUnit.hasParameterSets = false;
+		m_currentAccessUnit.hasAUD = false;
+		m_hasCurrentAccessUnit = true;
+		m_currentHasSlice = false;
+	}
+
+	// NAL units before the first slice take the slice's time
+	if (!m_currentHasSlice)
+		m_currentAccessUnit.presentationTime = streamTime;
+
+	if (isSlice)
+	{
+		if (!m_currentHasSlice)
+		{
+			m_currentAccessUnit.sliceType = nalType;
+			m_currentAccessUnit.keyframe = (nalType >= kHEVCNALTypeBLAWithLeadingPictures && nalType <= kHEVCNALTypeCRA);
+		}
+		m_currentHasSlice = true;
+	}
+	else if (nalType == kHEVCNALTypeVPS)
+	{
+		m_vps.assign(nalUnit, nalUnit + size);
+		m_currentAccessUnit.hasParameterSets = true;
+	}
+	else if (nalType == kHEVCNALTypeSPS)
+	{
+		m_sps.assign(nalUnit, nalUnit + size);
+		m_currentAccessUnit.hasParameterSets = true;
+	}
+	else if (nalType == kHEVCNALTypePPS)
+	{
+		m_pps.assign(nalUnit, nalUnit + size);
+		m_currentAccessUnit.hasParameterSets = true;
+	}
+	else if (nalType == kHEVCNALTypeAUD)
+	{
+		m_currentAccessUnit.hasAUD = true;
+	}
+
+	std::vector<uint8_t>& data = m_currentAccessUnit.data;
+	data.push_back(size >> 24);
+	data.push_back(size >> 16);
+	data.push_back(size >> 8);
+	data.push_back(size);
+	data.insert(data.end(), nalUnit, nalUnit + size);
+
+	return completed;
+}
+
+bool HEVCAccessUnitParser::flush()
+{
+	if (!m_hasCurrentAccessUnit || !m_currentHasSlice)
+		return false;
+
+	std::swap(m_currentAccessUnit, m_completedAccessUnit);
+	m_hasCurrentAccessUnit = false;
+	return true;
+}
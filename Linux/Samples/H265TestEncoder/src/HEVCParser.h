@@ -0,0 +1,147 @@
+/* -LICENSE-START-
+ ** Copyright (c) 2016 Blackmagic Design
+ **  
+ ** Permission is hereby granted, free of charge, to any person or organization 
+ ** obtaining a copy of the software and accompanying documentation (the 
+ ** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+ ** and transmit the Software, and to prepare derivative works of the Software, 
+ ** and to permit third-parties to whom the Software is furnished to do so, in 
+ ** accordance with:
+ ** 
+ ** (1) if the Software is obtained from Blackmagic Design, the End User License 
+ ** Agreement for the Software Development Kit (“EULA”) available at 
+ ** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+ ** 
+ ** (2) if the Software is obtained from any third party, such licensing terms 
+ ** as notified by that third party,
+ ** 
+ ** and all subject to the following:
+ ** 
+ ** (3) the copyright notices in the Software and this entire statement, 
+ ** including the above license grant, this restriction and the following 
+ ** disclaimer, must be included in all copies of the Software, in whole or in 
+ ** part, and all derivative works of the Software, unless such copies or 
+ ** derivative works are solely in the form of machine-executable object code 
+ ** generated by a source language processor.
+ ** 
+ ** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ ** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ ** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+ ** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+ ** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+ ** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ ** DEALINGS IN THE SOFTWARE.
+ ** 
+ ** A copy of the Software is available free of charge at 
+ ** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+ ** 
+ ** -LICENSE-END-
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+enum HEVCNALType
+{
+	kHEVCNALTypeRADLNonReference		= 6,
+	kHEVCNALTypeRASLReference			= 9,
+	kHEVCNALTypeReservedVCL14			= 14,	// Last of the sub-layer non-reference types, which are even
+	kHEVCNALTypeBLAWithLeadingPictures	= 16,
+	kHEVCNALTypeBLAWithRADL				= 17,
+	kHEVCNALTypeBLANoLeadingPictures	= 18,
+	kHEVCNALTypeIDRWithRADL				= 19,
+	kHEVCNALTypeIDRNoLeadingPictures	= 20,
+	kHEVCNALTypeCRA						= 21,
+	kHEVCNALTypeReservedIRAP23			= 23,
+	kHEVCNALTypeVPS						= 32,
+	kHEVCNALTypeSPS						= 33,
+	kHEVCNALTypePPS						= 34,
+	kHEVCNALTypeAUD						= 35
+};
+
+// Fields of the SPS needed for an hvcC box and to find the picture order count
+struct HEVCSequenceInfo
+{
+	uint8_t		profileTierLevel[12];	// general_profile_space to general_level_idc
+	uint8_t		maxSubLayersMinus1;
+	uint8_t		temporalIdNesting;
+	uint8_t		chromaFormat;
+	uint8_t		bitDepthLumaMinus8;
+	uint8_t		bitDepthChromaMinus8;
+	uint32_t	width;					// After the conformance window
+	uint32_t	height;
+	uint8_t		separateColourPlane;
+	uint8_t		log2MaxPicOrderCountLsb;
+};
+
+// Fields of the PPS needed to find the picture order count in a slice header
+struct HEVCPictureInfo
+{
+	uint8_t		dependentSliceSegmentsEnabled;
+	uint8_t		outputFlagPresent;
+	uint8_t		numExtraSliceHeaderBits;
+};
+
+// sps, pps and slice include the two byte NAL unit header
+bool HEVCParseSPS(const std::vector<uint8_t>& sps, HEVCSequenceInfo* info);
+bool HEVCParsePPS(const std::vector<uint8_t>& pps, HEVCPictureInfo* info);
+// Only the first slice segment of a picture is parsed, IDR pictures have a picture order count LSB of 0
+bool HEVCParsePicOrderCountLsb(const uint8_t* slice, uint32_t size, const HEVCSequenceInfo& sps, const HEVCPictureInfo& pps, uint32_t* picOrderCountLsb);
+
+// Derives each picture's order count from the LSBs in its slice header (H.265 clause 8.3.1).  Pictures must be
+// added in decode order, each coded video sequence counts from the POC of its IRAP picture.
+class HEVCPicOrderCounter
+{
+public:
+	HEVCPicOrderCounter();
+
+	int32_t						addPicture(uint8_t nalType, uint8_t temporalId, uint32_t picOrderCountLsb, uint8_t log2MaxPicOrderCountLsb);
+
+private:
+	bool						m_isFirstPicture;
+	int32_t						m_prevTid0PicOrderCount;
+};
+
+struct HEVCAccessUnit
+{
+	std::vector<uint8_t>	data;				// NAL units with 32-bit length prefixes
+	int64_t					presentationTime;
+	uint8_t					sliceType;			// NAL unit type of the first slice
+	bool					keyframe;			// IRAP picture: IDR, CRA or BLA
+	bool					hasParameterSets;
+	bool					hasAUD;
+};
+
+// Groups the NAL units from IDeckLinkH265NALPacket into access units, looking only at NAL unit headers so it can run
+// on the encoder callback thread.  An access unit ends at an AUD, a change of stream time, or the first slice of the
+// next picture, and always contains at least one slice.  The latest parameter sets are kept for the file header.
+class HEVCAccessUnitParser
+{
+public:
+	HEVCAccessUnitParser();
+
+	// Returns true when nalUnit starts a new access unit, completing the previous one
+	bool						addNAL(uint8_t nalType, const uint8_t* nalUnit, uint32_t size, int64_t streamTime);
+	// Returns true if the last access unit was completed
+	bool						flush();
+
+	// Valid until the next call to addNAL or flush.  The caller may swap out the data to avoid a copy.
+	HEVCAccessUnit&				completedAccessUnit() { return m_completedAccessUnit; }
+
+	bool						hasParameterSets() const { return !m_vps.empty() && !m_sps.empty() && !m_pps.empty(); }
+	const std::vector<uint8_t>&	getVPS() const { return m_vps; }
+	const std::vector<uint8_t>&	getSPS() const { return m_sps; }
+	const std::vector<uint8_t>&	getPPS() const { return m_pps; }
+
+private:
+	HEVCAccessUnit				m_currentAccessUnit;
+	HEVCAccessUnit				m_completedAccessUnit;
+	bool						m_hasCurrentAccessUnit;
+	bool						m_currentHasSlice;
+
+	std::vector<uint8_t>		m_vps;
+	std::vector<uint8_t>		m_sps;
+	std::vector<uint8_t>		m_pps;
+};
@@ -0,0 +1,815 @@
+/* -LICENSE-START-
+ ** Copyright (c) 2016 Blackmagic Design
+ **  
+ ** Permission is hereby granted, free of charge, to any person or organization 
+ ** obtaining a copy of the software and accompanying documentation (the 
+ ** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+ ** and transmit the Software, and to prepare derivative works of the Software, 
+ ** and to permit third-parties to whom the Software is furnished to do so, in 
+ ** accordance with:
+ ** 
+ ** (1) if the Software is obtained from Blackmagic Design, the End User License 
+ ** Agreement for the Software Development Kit (“EULA”) available at 
+ ** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+ ** 
+ ** (2) if the Software is obtained from any third party, such licensing terms 
+ ** as notified by that third party,
+ ** 
+ ** and all subject to the following:
+ ** 
+ ** (3) the copyright notices in the Software and this entire statement, 
+ ** including the above license grant, this restriction and the following 
+ ** disclaimer, must be included in all copies of the Software, in whole or in 
+ ** part, and all derivative works of the Software, unless such copies or 
+ ** derivative works are solely in the form of machine-executable object code 
+ ** generated by a source language processor.
+ ** 
+ ** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ ** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ ** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+ ** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+ ** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+ ** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ ** DEALINGS IN THE SOFTWARE.
+ ** 
+ ** A copy of the Software is available free of charge at 
+ ** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+ ** 
+ ** -LICENSE-END-
+ */
+
+#include "MP4Muxer.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+const char MP4Muxer::kInitSegmentName[]	= "init.mp4";
+const char MP4Muxer::kPlaylistName[]		= "playlist.m3u8";
+
+namespace
+{
+	const uint32_t kSyncSampleFlags		= 0x02000000;	// sample_depends_on = 2
+	const uint32_t kNonSyncSampleFlags	= 0x01010000;	// sample_depends_on = 1, sample_is_non_sync_sample
+
+	// The playlist starts with the prefix and the target duration, which has a fixed number of digits so that it can
+	// be rewritten in place
+	const char kPlaylistTargetDurationPrefix[]	= "#EXTM3U\n#EXT-X-VERSION:7\n#EXT-X-TARGETDURATION:";
+	const int kTargetDurationDigits				= 5;
+	const uint32_t kMaxTargetDuration			= 99999;	// seconds
+
+	const char kSegmentNameFormat[]				= "segment_%05u.m4s";
+
+	const uint32_t kUnityMatrix[9] = { 0x00010000, 0, 0, 0, 0x00010000, 0, 0, 0, 0x40000000 };
+
+	void put8(std::vector<uint8_t>& box, uint8_t value)
+	{
+		box.push_back(value);
+	}
+
+	void put16(std::vector<uint8_t>& box, uint16_t value)
+	{
+		box.push_back(value >> 8);
+		box.push_back(value);
+	}
+
+	void put32(std::vector<uint8_t>& box, uint32_t value)
+	{
+		box.push_back(value >> 24);
+		box.push_back(value >> 16);
+		box.push_back(value >> 8);
+		box.push_back(value);
+	}
+
+	void put64(std::vector<uint8_t>& box, uint64_t value)
+	{
+		put32(box, value >> 32);
+		put32(box, value);
+	}
+
+	void putBytes(std::vector<uint8_t>& box, const void* data, size_t size)
+	{
+		box.insert(box.end(), (const uint8_t*)data, (const uint8_t*)data + size);
+	}
+
+	void putZeros(std::vector<uint8_t>& box, size_t count)
+	{
+		box.insert(box.end(), count, 0);
+	}
+
+	void putFourCC(std::vector<uint8_t>& box, const char* fourCC)
+	{
+		putBytes(box, fourCC, 4);
+	}
+
+	// Returns the offset of the box, to be passed to endBox once its contents are written
+	size_t beginBox(std::vector<uint8_t>& box, const char* type)
+	{
+		size_t offset = box.size();
+		put32(box, 0);
+		putFourCC(box, type);
+		return offset;
+	}
+
+	size_t beginFullBox(std::vector<uint8_t>& box, const char* type, uint8_t version, uint32_t flags)
+	{
+		size_t offset = beginBox(box, type);
+		put32(box, ((uint32_t)version << 24) | flags);
+		return offset;
+	}
+
+	void endBox(std::vector<uint8_t>& box, size_t offset)
+	{
+		uint32_t size = box.size() - offset;
+		box[offset + 0] = size >> 24;
+		box[offset + 1] = size >> 16;
+		box[offset + 2] = size >> 8;
+		box[offset + 3] = size;
+	}
+
+	void putMatrix(std::vector<uint8_t>& box)
+	{
+		for (int i = 0; i < 9; i++)
+			put32(box, kUnityMatrix[i]);
+	}
+}
+
+MP4Muxer::MP4Muxer(AsyncFileWriter* writer, int64_t frameDuration, int64_t timeScale) :
+	m_writer(writer),
+	m_frameDuration(frameDuration),
+	m_timeScale(timeScale),
+	m_hasAudio(false),
+	m_audioChannelCount(0),
+	m_audioBitsPerSample(0),
+	m_firstAudioTime(0),
+	m_nextAudioTime(0),
+	m_headerWritten(false),
+	m_waitingForKeyframe(false),
+	m_firstStreamTime(0),
+	m_lastDecodeTime(-frameDuration),
+	m_hasPendingAccessUnit(false),
+	m_fragmentSequence(1),
+	m_fileOffset(0),
+	m_segmentDuration(0),
+	m_playlistWriter(NULL),
+	m_segmentNumber(0),
+	m_segmentStartTime(0),
+	m_targetDuration(0)
+{
+	m_videoTrack.trackID = 1;
+	m_videoTrack.handlerType = "vide";
+	m_videoTrack.timeScale = timeScale;
+	m_videoTrack.sampleSize = 0;
+	m_videoTrack.baseDecodeTime = 0;
+
+	m_audioTrack.trackID = 2;
+	m_audioTrack.handlerType = "soun";
+	m_audioTrack.timeScale = 0;
+	m_audioTrack.sampleSize = 0;
+	m_audioTrack.baseDecodeTime = 0;
+
+	memset(&m_statistics, 0, sizeof(m_statistics));
+}
+
+void MP4Muxer::setSegments(const std::string& directory, uint32_t segmentDuration, AsyncFileWriter* playlistWriter)
+{
+	if (m_headerWritten)
+		return;
+
+	m_segmentDuration = segmentDuration;
+	m_playlistWriter = playlistWriter;
+
+	// The writer names each segment file, so that starting a segment doesn't allocate
+	m_writer->setFileNames(directory, kSegmentNameFormat);
+}
+
+void MP4Muxer::addAudioTrack(uint32_t sampleRate, uint32_t channelCount, uint32_t bitsPerSample)
+{
+	if (m_headerWritten)
+		return;
+
+	m_audioTrack.timeScale = sampleRate;
+	m_audioTrack.sampleSize = channelCount * bitsPerSample / 8;		// Each sample is one frame of PCM
+
+	m_audioChannelCount = channelCount;
+	m_audioBitsPerSample = bitsPerSample;
+	m_hasAudio = true;
+}
+
+void MP4Muxer::addVideoNAL(uint8_t nalType, const uint8_t* nalUnit, uint32_t size, int64_t streamTime)
+{
+	if (size < 2)
+		return;
+
+	if (m_parser.addNAL(nalType, nalUnit, size, streamTime))
+		endAccessUnit(m_parser.completedAccessUnit());
+}
+
+void MP4Muxer::endAccessUnit(HEVCAccessUnit& accessUnit)
+{
+	if (!m_headerWritten)
+	{
+		if (!accessUnit.keyframe || !m_parser.hasParameterSets() || !writeHeader())
+		{
+			m_statistics.droppedAccessUnits++;
+			return;
+		}
+		m_firstStreamTime = accessUnit.presentationTime;
+		m_firstAudioTime = (m_firstStreamTime * m_audioTrack.timeScale + m_timeScale / 2) / m_timeScale;
+	}
+
+	int64_t presentationTime = accessUnit.presentationTime - m_firstStreamTime;
+	if (presentationTime < 0)
+	{
+		// Leading pictures of the first CRA reference pictures before the start of the recording
+		m_statistics.droppedAccessUnits++;
+		return;
+	}
+
+	// Decode times advance by at least a frame, and stay within kMaxReorderFrames of the presentation time
+	int64_t decodeTime = std::max(m_lastDecodeTime + m_frameDuration, presentationTime - kMaxReorderFrames * m_frameDuration);
+
+	if (m_hasPendingAccessUnit)
+		commitAccessUnit(decodeTime - m_pendingAccessUnit.decodeTime);
+
+	// Take the parser's buffer rather than copying it, and give it the old one to reuse
+	std::swap(accessUnit.data, m_pendingAccessUnit.data);
+	m_pendingAccessUnit.presentationTime = presentationTime;
+	m_pendingAccessUnit.decodeTime = decodeTime;
+	m_pendingAccessUnit.keyframe = accessUnit.keyframe;
+	m_hasPendingAccessUnit = true;
+	m_lastDecodeTime = decodeTime;
+}
+
+void MP4Muxer::commitAccessUnit(uint32_t duration)
+{
+	Track& track = m_videoTrack;
+
+	if (!track.samples.empty())
+	{
+		int64_t fragmentDuration = m_pendingAccessUnit.decodeTime - track.baseDecodeTime;
+		if ((m_pendingAccessUnit.keyframe && fragmentDuration >= kMinFragmentDuration * m_timeScale) ||
+			fragmentDuration >= kMaxFragmentDuration * m_timeScale)
+			writeFragment();
+	}
+
+	if (m_waitingForKeyframe)
+	{
+		if (!m_pendingAccessUnit.keyframe)
+		{
+			m_statistics.droppedAccessUnits++;
+			return;
+		}
+		m_waitingForKeyframe = false;
+	}
+
+	if (track.samples.empty())
+		track.baseDecodeTime = m_pendingAccessUnit.decodeTime;
+
+	Sample sample;
+	sample.duration = duration;
+	sample.size = m_pendingAccessUnit.data.size();
+	sample.flags = m_pendingAccessUnit.keyframe ? kSyncSampleFlags : kNonSyncSampleFlags;
+	sample.compositionOffset = m_pendingAccessUnit.presentationTime - m_pendingAccessUnit.decodeTime;
+
+	track.samples.push_back(sample);
+	putBytes(track.data, m_pendingAccessUnit.data.data(), m_pendingAccessUnit.data.size());
+
+	m_statistics.accessUnits++;
+}
+
+void MP4Muxer::finish()
+{
+	if (m_parser.flush())
+		endAccessUnit(m_parser.completedAccessUnit());
+
+	if (m_hasPendingAccessUnit)
+	{
+		commitAccessUnit(m_frameDuration);
+		m_hasPendingAccessUnit = false;
+	}
+
+	if (!m_videoTrack.samples.empty() || !m_audioTrack.data.empty())
+		writeFragment();
+
+	if (m_segmentDuration == 0 && m_headerWritten)
+	{
+		writeFragmentRandomAccess();
+	}
+	else if (m_segmentNumber > 0)
+	{
+		writePlaylistEntry(m_lastDecodeTime + m_frameDuration);
+
+		static const char kPlaylistEnd[] = "#EXT-X-ENDLIST\n";
+		m_playlistWriter->write(kPlaylistEnd, sizeof(kPlaylistEnd) - 1);
+		m_playlistWriter->flush();
+	}
+}
+
+void MP4Muxer::addAudio(const uint8_t* samples, uint32_t frameCount, int64_t streamTime)
+{
+	if (!m_hasAudio)
+		return;
+
+	if (!m_headerWritten)
+	{
+		m_statistics.droppedAudioFrames += frameCount;
+		return;
+	}
+
+	Track&		track = m_audioTrack;
+	int64_t		time = streamTime - m_firstAudioTime;
+
+	// Trim audio from before the first video frame, or that overlaps audio already written
+	if (time < m_nextAudioTime)
+	{
+		int64_t overlap = m_nextAudioTime - time;
+		if (overlap >= frameCount)
+		{
+			m_statistics.droppedAudioFrames += frameCount;
+			return;
+		}
+
+		samples += overlap * track.sampleSize;
+		frameCount -= overlap;
+		time = m_nextAudioTime;
+		m_statistics.droppedAudioFrames += overlap;
+	}
+
+	// Fill gaps with silence so the audio stays continuous, except after a long gap such as a dropped fragment,
+	// where the next fragment's tfdt restarts the audio at its stream time
+	int64_t gap = time - m_nextAudioTime;
+	if (track.data.empty())
+	{
+		if (gap > kMaxFragmentDuration * (int64_t)track.timeScale)
+			gap = 0;
+		track.baseDecodeTime = time - gap;
+	}
+
+	if (gap > 0)
+	{
+		putZeros(track.data, gap * track.sampleSize);
+		m_statistics.paddedAudioFrames += gap;
+	}
+
+	putBytes(track.data, samples, frameCount * track.sampleSize);
+	m_nextAudioTime = time + frameCount;
+	m_statistics.audioFrames += frameCount;
+}
+
+bool MP4Muxer::writeHeader()
+{
+	HEVCSequenceInfo config;
+	if (!HEVCParseSPS(m_parser.getSPS(), &config))
+		return false;
+
+	std::vector<uint8_t> header;
+
+	size_t ftyp = beginBox(header, "ftyp");
+	putFourCC(header, "isom");
+	put32(header, 0x200);
+	putFourCC(header, "isom");
+	putFourCC(header, "iso6");
+	putFourCC(header, "mp41");
+	endBox(header, ftyp);
+
+	size_t moov = beginBox(header, "moov");
+
+	size_t mvhd = beginFullBox(header, "mvhd", 0, 0);
+	put32(header, 0);							// creation_time
+	put32(header, 0);							// modification_time
+	put32(header, m_timeScale);
+	put32(header, 0);							// duration, given by the fragments
+	put32(header, 0x00010000);					// rate
+	put16(header, 0x0100);						// volume
+	putZeros(header, 10);
+	putMatrix(header);
+	putZeros(header, 24);						// pre_defined
+	put32(header, m_hasAudio ? m_audioTrack.trackID + 1 : m_videoTrack.trackID + 1);	// next_track_ID
+	endBox(header, mvhd);
+
+	writeTrack(header, m_videoTrack, config.width, config.height);
+	if (m_hasAudio)
+		writeTrack(header, m_audioTrack, 0, 0);
+
+	size_t mvex = beginBox(header, "mvex");
+	for (const Track* track : { &m_videoTrack, &m_audioTrack })
+	{
+		if (track == &m_audioTrack && !m_hasAudio)
+			continue;
+
+		size_t trex = beginFullBox(header, "trex", 0, 0);
+		put32(header, track->trackID);
+		put32(header, 1);						// default_sample_description_index
+		put32(header, 0);
+		put32(header, 0);
+		put32(header, 0);
+		endBox(header, trex);
+	}
+	endBox(header, mvex);
+
+	endBox(header, moov);
+
+	// Without the header the file is unplayable, so wait for the next IRAP access unit if it can't be queued
+	if (!m_writer->write(header.data(), header.size()))
+		return false;
+
+	m_writer->flush();
+	m_fileOffset = header.size();
+	m_headerWritten = true;
+
+	if (m_segmentDuration > 0)
+	{
+		// Segments can be a keyframe interval longer than the segment duration, writePlaylistEntry() raises the
+		// target duration to the longest segment before listing it
+		char playlistHeader[256];
+		m_targetDuration = std::min(m_segmentDuration, kMaxTargetDuration);
+		int length = snprintf(playlistHeader, sizeof(playlistHeader),
+							  "%s%0*u\n#EXT-X-PLAYLIST-TYPE:EVENT\n#EXT-X-MAP:URI=\"%s\"\n",
+							  kPlaylistTargetDurationPrefix, kTargetDurationDigits, m_targetDuration, kInitSegmentName);
+		m_playlistWriter->write(playlistHeader, length);
+		m_playlistWriter->flush();
+	}
+
+	return true;
+}
+
+void MP4Muxer::writeTrack(std::vector<uint8_t>& box, const Track& track, uint32_t width, uint32_t height) const
+{
+	bool isAudio = (&track == &m_audioTrack);
+
+	size_t trak = beginBox(box, "trak");
+
+	size_t tkhd = beginFullBox(box, "tkhd", 0, 0x000003);		// track_enabled, track_in_movie
+	put32(box, 0);
+	put32(box, 0);
+	put32(box, track.trackID);
+	put32(box, 0);
+	put32(box, 0);								// duration
+	putZeros(box, 8);
+	put16(box, 0);								// layer
+	put16(box, 0);								// alternate_group
+	put16(box, isAudio ? 0x0100 : 0);			// volume
+	put16(box, 0);
+	putMatrix(box);
+	put32(box, width << 16);
+	put32(box, height << 16);
+	endBox(box, tkhd);
+
+	size_t mdia = beginBox(box, "mdia");
+
+	size_t mdhd = beginFullBox(box, "mdhd", 0, 0);
+	put32(box, 0);
+	put32(box, 0);
+	put32(box, track.timeScale);
+	put32(box, 0);
+	put16(box, 0x55C4);							// 'und'
+	put16(box, 0);
+	endBox(box, mdhd);
+
+	size_t hdlr = beginFullBox(box, "hdlr", 0, 0);
+	put32(box, 0);
+	putFourCC(box, track.handlerType);
+	putZeros(box, 12);
+	if (isAudio)
+		putBytes(box, "SoundHandler", 13);
+	else
+		putBytes(box, "VideoHandler", 13);
+	endBox(box, hdlr);
+
+	size_t minf = beginBox(box, "minf");
+
+	if (isAudio)
+	{
+		size_t smhd = beginFullBox(box, "smhd", 0, 0);
+		putZeros(box, 4);						// balance
+		endBox(box, smhd);
+	}
+	else
+	{
+		size_t vmhd = beginFullBox(box, "vmhd", 0, 0x000001);
+		putZeros(box, 8);						// graphicsmode, opcolor
+		endBox(box, vmhd);
+	}
+
+	size_t dinf = beginBox(box, "dinf");
+	size_t dref = beginFullBox(box, "dref", 0, 0);
+	put32(box, 1);
+	size_t url = beginFullBox(box, "url ", 0, 0x000001);		// Media data is in this file
+	endBox(box, url);
+	endBox(box, dref);
+	endBox(box, dinf);
+
+	size_t stbl = beginBox(box, "stbl");
+
+	size_t stsd = beginFullBox(box, "stsd", 0, 0);
+	put32(box, 1);
+	if (isAudio)
+		writeAudioSampleEntry(box);
+	else
+		writeVideoSampleEntry(box);
+	endBox(box, stsd);
+
+	// The samples are described by the fragments
+	size_t stts = beginFullBox(box, "stts", 0, 0);
+	put32(box, 0);
+	endBox(box, stts);
+	size_t stsc = beginFullBox(box, "stsc", 0, 0);
+	put32(box, 0);
+	endBox(box, stsc);
+	size_t stsz = beginFullBox(box, "stsz", 0, 0);
+	put32(box, 0);
+	put32(box, 0);
+	endBox(box, stsz);
+	size_t stco = beginFullBox(box, "stco", 0, 0);
+	put32(box, 0);
+	endBox(box, stco);
+
+	endBox(box, stbl);
+	endBox(box, minf);
+	endBox(box, mdia);
+	endBox(box, trak);
+}
+
+void MP4Muxer::writeVideoSampleEntry(std::vector<uint8_t>& box) const
+{
+	HEVCSequenceInfo config;
+	HEVCParseSPS(m_parser.getSPS(), &config);
+
+	size_t hev1 = beginBox(box, "hev1");
+	putZeros(box, 6);
+	put16(box, 1);								// data_reference_index
+	putZeros(box, 16);
+	put16(box, config.width);
+	put16(box, config.height);
+	put32(box, 0x00480000);						// 72 dpi
+	put32(box, 0x00480000);
+	put32(box, 0);
+	put16(box, 1);								// frame_count
+	putZeros(box, 32);							// compressorname
+	put16(box, 0x0018);							// depth
+	put16(box, 0xFFFF);
+
+	size_t hvcC = beginBox(box, "hvcC");
+	put8(box, 1);								// configurationVersion
+	putBytes(box, config.profileTierLevel, sizeof(config.profileTierLevel));
+	put16(box, 0xF000);							// min_spatial_segmentation_idc
+	put8(box, 0xFC);							// parallelismType unknown
+	put8(box, 0xFC | config.chromaFormat);
+	put8(box, 0xF8 | config.bitDepthLumaMinus8);
+	put8(box, 0xF8 | config.bitDepthChromaMinus8);
+	put16(box, 0);								// avgFrameRate
+	put8(box, ((config.maxSubLayersMinus1 + 1) << 3) | (config.temporalIdNesting << 2) | 3);	// 4 byte NAL unit lengths
+
+	const std::vector<uint8_t>* parameterSets[] = { &m_parser.getVPS(), &m_parser.getSPS(), &m_parser.getPPS() };
+	const uint8_t parameterSetTypes[] = { kHEVCNALTypeVPS, kHEVCNALTypeSPS, kHEVCNALTypePPS };
+
+	put8(box, 3);								// numOfArrays
+	for (int i = 0; i < 3; i++)
+	{
+		put8(box, parameterSetTypes[i]);		// array_completeness is 0 for 'hev1'
+		put16(box, 1);
+		put16(box, parameterSets[i]->size());
+		putBytes(box, parameterSets[i]->data(), parameterSets[i]->size());
+	}
+	endBox(box, hvcC);
+
+	endBox(box, hev1);
+}
+
+void MP4Muxer::writeAudioSampleEntry(std::vector<uint8_t>& box) const
+{
+	size_t ipcm = beginBox(box, "ipcm");
+	putZeros(box, 6);
+	put16(box, 1);								// data_reference_index
+	putZeros(box, 8);
+	put16(box, m_audioChannelCount);
+	put16(box, m_audioBitsPerSample);
+	put32(box, 0);
+	put32(box, m_audioTrack.timeScale << 16);
+
+	size_t pcmC = beginFullBox(box, "pcmC", 0, 0);
+	put8(box, 1);								// format_flags little-endian
+	put8(box, m_audioBitsPerSample);
+	endBox(box, pcmC);
+
+	endBox(box, ipcm);
+}
+
+// Returns the offset of the trun data_offset, which writeFragment fills in once the size of the moof is known
+size_t MP4Muxer::writeTrackFragment(std::vector<uint8_t>& box, const Track& track) const
+{
+	size_t dataOffset;
+	size_t traf = beginBox(box, "traf");
+
+	if (track.sampleSize != 0)
+	{
+		// default-base-is-moof, default sample duration, size and flags
+		size_t tfhd = beginFullBox(box, "tfhd", 0, 0x020038);
+		put32(box, track.trackID);
+		put32(box, 1);
+		put32(box, track.sampleSize);
+		put32(box, kSyncSampleFlags);
+		endBox(box, tfhd);
+
+		size_t tfdt = beginFullBox(box, "tfdt", 1, 0);
+		put64(box, track.baseDecodeTime);
+		endBox(box, tfdt);
+
+		size_t trun = beginFullBox(box, "trun", 0, 0x000001);	// data offset present
+		put32(box, track.data.size() / track.sampleSize);
+		dataOffset = box.size();
+		put32(box, 0);
+		endBox(box, trun);
+
+		endBox(box, traf);
+		return dataOffset;
+	}
+
+	size_t tfhd = beginFullBox(box, "tfhd", 0, 0x020000);		// default-base-is-moof
+	put32(box, track.trackID);
+	endBox(box, tfhd);
+
+	size_t tfdt = beginFullBox(box, "tfdt", 1, 0);
+	put64(box, track.baseDecodeTime);
+	endBox(box, tfdt);
+
+	// Version 1 for signed composition offsets; data offset, sample duration, size, flags and composition offset present
+	size_t trun = beginFullBox(box, "trun", 1, 0x000F01);
+	put32(box, track.samples.size());
+	dataOffset = box.size();
+	put32(box, 0);
+	for (const Sample& sample : track.samples)
+	{
+		put32(box, sample.duration);
+		put32(box, sample.size);
+		put32(box, sample.flags);
+		put32(box, sample.compositionOffset);
+	}
+	endBox(box, trun);
+
+	endBox(box, traf);
+	return dataOffset;
+}
+
+void MP4Muxer::writeFragment()
+{
+	Track*	tracks[] = { &m_videoTrack, &m_audioTrack };
+	size_t	dataOffsets[2] = { 0, 0 };
+
+	// Segments start with a keyframe, so that each one can be decoded on its own
+	if (m_segmentDuration > 0 && !m_videoTrack.samples.empty() && m_videoTrack.samples[0].flags == kSyncSampleFlags)
+	{
+		int64_t startTime = m_videoTrack.baseDecodeTime;
+		if (m_segmentNumber == 0 || startTime - m_segmentStartTime >= m_segmentDuration * m_timeScale)
+			startSegment(startTime);
+	}
+
+	m_moof.clear();
+
+	size_t moof = beginBox(m_moof, "moof");
+	size_t mfhd = beginFullBox(m_moof, "mfhd", 0, 0);
+	put32(m_moof, m_fragmentSequence);
+	endBox(m_moof, mfhd);
+
+	for (int i = 0; i < 2; i++)
+	{
+		if (!tracks[i]->data.empty())
+			dataOffsets[i] = writeTrackFragment(m_moof, *tracks[i]);
+	}
+
+	endBox(m_moof, moof);
+
+	// Sample data follows the mdat header, one track after the other
+	uint32_t offset = m_moof.size() + 8;
+	for (int i = 0; i < 2; i++)
+	{
+		if (tracks[i]->data.empty())
+			continue;
+
+		m_moof[dataOffsets[i] + 0] = offset >> 24;
+		m_moof[dataOffsets[i] + 1] = offset >> 16;
+		m_moof[dataOffsets[i] + 2] = offset >> 8;
+		m_moof[dataOffsets[i] + 3] = offset;
+		offset += tracks[i]->data.size();
+	}
+
+	uint8_t mdatHeader[8];
+	uint32_t mdatSize = 8 + m_videoTrack.data.size() + m_audioTrack.data.size();
+	mdatHeader[0] = mdatSize >> 24;
+	mdatHeader[1] = mdatSize >> 16;
+	mdatHeader[2] = mdatSize >> 8;
+	mdatHeader[3] = mdatSize;
+	memcpy(&mdatHeader[4], "mdat", 4);
+
+	struct iovec parts[] =
+	{
+		{ m_moof.data(), m_moof.size() },
+		{ mdatHeader, sizeof(mdatHeader) },
+		{ m_videoTrack.data.data(), m_videoTrack.data.size() },
+		{ m_audioTrack.data.data(), m_audioTrack.data.size() }
+	};
+
+	if (m_writer->write(parts, 4))
+	{
+		m_writer->flush();
+
+		int64_t decodeTime = m_videoTrack.baseDecodeTime;
+		for (size_t i = 0; i < m_videoTrack.samples.size(); i++)
+		{
+			const Sample& sample = m_videoTrack.samples[i];
+			if (sample.flags == kSyncSampleFlags)
+			{
+				KeyframeIndex::Entry entry = { decodeTime + sample.compositionOffset, m_segmentNumber, m_fileOffset, (uint32_t)i + 1 };
+				m_keyframeIndex.add(entry);
+			}
+			decodeTime += sample.duration;
+		}
+
+		m_fileOffset += m_moof.size() + mdatSize;
+		m_fragmentSequence++;
+		m_statistics.fragments++;
+	}
+	else
+	{
+		// The next fragment must start with a keyframe, the decode times in each tfdt bridge the gap
+		m_statistics.droppedFragments++;
+		m_waitingForKeyframe = true;
+	}
+
+	for (Track* track : tracks)
+	{
+		track->samples.clear();
+		track->data.clear();
+	}
+}
+
+void MP4Muxer::startSegment(int64_t startTime)
+{
+	if (m_segmentNumber > 0)
+		writePlaylistEntry(startTime);
+
+	m_segmentNumber++;
+	m_segmentStartTime = startTime;
+
+	m_writer->startFile(m_segmentNumber);
+	m_fileOffset = 0;
+
+	m_statistics.segments++;
+}
+
+void MP4Muxer::writePlaylistEntry(int64_t endTime)
+{
+	double duration = (double)(endTime - m_segmentStartTime) / m_timeScale;
+
+	// Each segment's duration rounded to the nearest second must not exceed the target duration
+	uint32_t roundedDuration = (uint32_t)std::min(llround(duration), (long long)kMaxTargetDuration);
+	if (roundedDuration > m_targetDuration)
+	{
+		char targetDuration[16];
+		snprintf(targetDuration, sizeof(targetDuration), "%0*u", kTargetDurationDigits, roundedDuration);
+
+		if (m_playlistWriter->writeAt(sizeof(kPlaylistTargetDurationPrefix) - 1, targetDuration, kTargetDurationDigits))
+			m_targetDuration = roundedDuration;
+	}
+
+	char name[32];
+	snprintf(name, sizeof(name), kSegmentNameFormat, m_segmentNumber);
+
+	char entry[64];
+	int length = snprintf(entry, sizeof(entry), "#EXTINF:%.3f,\n%s\n", duration, name);
+
+	m_playlistWriter->write(entry, length);
+	m_playlistWriter->flush();
+}
+
+void MP4Muxer::writeFragmentRandomAccess()
+{
+	const std::vector<KeyframeIndex::Entry>& entries = m_keyframeIndex.getEntries();
+	std::vector<uint8_t> box;
+
+	size_t mfra = beginBox(box, "mfra");
+
+	size_t tfra = beginFullBox(box, "tfra", 1, 0);
+	put32(box, m_videoTrack.trackID);
+	put32(box, 0x3F);							// 32-bit traf, trun and sample numbers
+	put32(box, entries.size());
+	for (const KeyframeIndex::Entry& entry : entries)
+	{
+		put64(box, entry.presentationTime);
+		put64(box, entry.fragmentOffset);
+		put32(box, 1);							// The video traf is first in each moof
+		put32(box, 1);
+		put32(box, entry.sampleNumber);
+	}
+	endBox(box, tfra);
+
+	size_t mfro = beginFullBox(box, "mfro", 0, 0);
+	put32(box, box.size() - mfra + 4);			// Size of the mfra, including this field
+	endBox(box, mfro);
+
+	endBox(box, mfra);
+
+	m_writer->write(box.data(), box.size());
+	m_writer->flush();
+}
@@ -0,0 +1,183 @@
+/* -LICENSE-START-
+ ** Copyright (c) 2016 Blackmagic Design
+ **  
+ ** Permission is hereby granted, free of charge, to any person or organization 
+ ** obtaining a copy of the software and accompanying documentation (the 
+ ** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+ ** and transmit the Software, and to prepare derivative works of the Software, 
+ ** and to permit third-parties to whom the Software is furnished to do so, in 
+ ** accordance with:
+ ** 
+ ** (1) if the Software is obtained from Blackmagic Design, the End User License 
+ ** Agreement for the Software Development Kit (“EULA”) available at 
+ ** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+ ** 
+ ** (2) if the Software is obtained from any third party, such licensing terms 
+ ** as notified by that third party,
+ ** 
+ ** and all subject to the following:
+ ** 
+ ** (3) the copyright notices in the Software and this entire statement, 
+ ** including the above license grant, this restriction and the following 
+ ** disclaimer, must be included in all copies of the Software, in whole or in 
+ ** part, and all derivative works of the Software, unless such copies or 
+ ** derivative works are solely in the form of machine-executable object code 
+ ** generated by a source language processor.
+ ** 
+ ** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ ** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ ** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+ ** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+ ** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+ ** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ ** DEALINGS IN THE SOFTWARE.
+ ** 
+ ** A copy of the Software is available free of charge at 
+ ** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+ ** 
+ ** -LICENSE-END-
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "AsyncFileWriter.h"
+#include "HEVCParser.h"
+#include "KeyframeIndex.h"
+
+// Writes HEVC NAL units to a fragmented MP4 file.  The movie header is written once the first IRAP access unit
+// brings the VPS, SPS and PPS, then a fragment (moof and mdat) is written at the first keyframe after each
+// kMinFragmentDuration, so the file can be played while it is still being recorded.  Samples use the 'hev1'
+// sample entry, so the parameter sets stay in-band as well as in the hvcC box.  An optional PCM audio track is
+// written to the same fragments, with its timeline starting at the first video frame.
+//
+// A single file recording ends with an mfra box listing every keyframe.  A segmented recording writes the movie
+// header to kInitSegmentName, starts a new segment file at the first keyframe after each segment duration, and lists
+// the segments in an HLS playlist.
+class MP4Muxer
+{
+public:
+	static const char			kInitSegmentName[];
+	static const char			kPlaylistName[];
+
+	struct Statistics
+	{
+		uint64_t				accessUnits;
+		uint64_t				droppedAccessUnits;		// Before the first IRAP, or while recovering from a dropped fragment
+		uint64_t				fragments;
+		uint64_t				droppedFragments;		// No room in the writer's queue
+		uint64_t				segments;
+		uint64_t				audioFrames;
+		uint64_t				droppedAudioFrames;		// Before the first video frame, or overlapping earlier audio
+		uint64_t				paddedAudioFrames;		// Silence written for gaps between audio packets
+	};
+
+	MP4Muxer(AsyncFileWriter* writer, int64_t frameDuration, int64_t timeScale);
+
+	// Write segmentDuration seconds of fragments to each segment file in directory, instead of one file.  The writer
+	// must be writing to kInitSegmentName in directory and playlistWriter to kPlaylistName.  Set before the first
+	// video NAL unit.
+	void						setSegments(const std::string& directory, uint32_t segmentDuration, AsyncFileWriter* playlistWriter);
+
+	// Interleaved little-endian PCM, added before the first video NAL unit
+	void						addAudioTrack(uint32_t sampleRate, uint32_t channelCount, uint32_t bitsPerSample);
+
+	// nalUnit excludes the start code prefix, streamTime is the presentation time in the time scale
+	void						addVideoNAL(uint8_t nalType, const uint8_t* nalUnit, uint32_t size, int64_t streamTime);
+
+	// streamTime is in sample frames, on the same stream clock as the video.  Audio is dropped until hasStarted()
+	void						addAudio(const uint8_t* samples, uint32_t frameCount, int64_t streamTime);
+
+	bool						hasStarted() const { return m_headerWritten; }
+
+	// Write the access unit and fragment still being assembled
+	void						finish();
+
+	Statistics					getStatistics() const { return m_statistics; }
+	const KeyframeIndex&		getKeyframeIndex() const { return m_keyframeIndex; }
+
+private:
+	// Fragments are cut at the first keyframe after kMinFragmentDuration, or at any frame after kMaxFragmentDuration
+	static const int			kMinFragmentDuration	= 1;		// seconds
+	static const int			kMaxFragmentDuration	= 4;		// seconds
+	// Frames that a B-frame may be displayed ahead of its decode order
+	static const int			kMaxReorderFrames		= 3;
+
+	struct Sample
+	{
+		uint32_t				duration;
+		uint32_t				size;
+		uint32_t				flags;
+		int32_t					compositionOffset;
+	};
+
+	struct Track
+	{
+		uint32_t				trackID;
+		const char*				handlerType;
+		uint32_t				timeScale;
+		uint32_t				sampleSize;			// Size of every sample, or 0 when each sample has its own
+		uint64_t				baseDecodeTime;		// Decode time of the first sample in the current fragment
+		std::vector<Sample>		samples;			// Only when sampleSize is 0
+		std::vector<uint8_t>	data;
+	};
+
+	struct PendingAccessUnit
+	{
+		std::vector<uint8_t>	data;				// NAL units with 32-bit length prefixes
+		int64_t					presentationTime;	// Relative to the first video frame
+		int64_t					decodeTime;
+		bool					keyframe;
+	};
+
+	bool						writeHeader();
+	void						writeTrack(std::vector<uint8_t>& box, const Track& track, uint32_t width, uint32_t height) const;
+	void						writeVideoSampleEntry(std::vector<uint8_t>& box) const;
+	void						writeAudioSampleEntry(std::vector<uint8_t>& box) const;
+	size_t						writeTrackFragment(std::vector<uint8_t>& box, const Track& track) const;
+	void						endAccessUnit(HEVCAccessUnit& accessUnit);
+	void						commitAccessUnit(uint32_t duration);
+	void						writeFragment();
+	void						startSegment(int64_t startTime);
+	void						writePlaylistEntry(int64_t endTime);
+	void						writeFragmentRandomAccess();
+
+	AsyncFileWriter*			m_writer;
+	int64_t						m_frameDuration;
+	int64_t						m_timeScale;
+
+	Track						m_videoTrack;
+	HEVCAccessUnitParser		m_parser;
+
+	Track						m_audioTrack;
+	bool						m_hasAudio;
+	uint32_t					m_audioChannelCount;
+	uint32_t					m_audioBitsPerSample;
+	int64_t						m_firstAudioTime;		// Stream time of the first video frame, in sample frames
+	int64_t						m_nextAudioTime;		// Relative to m_firstAudioTime
+
+	bool						m_headerWritten;
+	bool						m_waitingForKeyframe;
+	int64_t						m_firstStreamTime;
+	int64_t						m_lastDecodeTime;
+
+	// The last access unit is held until the next decode time gives its duration
+	PendingAccessUnit			m_pendingAccessUnit;
+	bool						m_hasPendingAccessUnit;
+
+	uint32_t					m_fragmentSequence;
+	std::vector<uint8_t>		m_moof;
+	uint64_t					m_fileOffset;			// Bytes queued to the current file or segment
+	KeyframeIndex				m_keyframeIndex;
+
+	uint32_t					m_segmentDuration;		// seconds, 0 for a single file
+	AsyncFileWriter*			m_playlistWriter;
+	uint32_t					m_segmentNumber;		// From 1, 0 before the first segment
+	int64_t						m_segmentStartTime;
+	uint32_t					m_targetDuration;		// seconds, in the playlist header
+
+	Statistics					m_statistics;
+};
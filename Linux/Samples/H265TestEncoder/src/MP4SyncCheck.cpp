@@ -0,0 +1,475 @@
+/* -LICENSE-START-
+ ** Copyright (c) 2016 Blackmagic Design
+ **  
+ ** Permission is hereby granted, free of charge, to any person or organization 
+ ** obtaining a copy of the software and accompanying documentation (the 
+ ** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+ ** and transmit the Software, and to prepare derivative works of the Software, 
+ ** and to permit third-parties to whom the Software is furnished to do so, in 
+ ** accordance with:
+ ** 
+ ** (1) if the Software is obtained from Blackmagic Design, the End User License 
+ ** Agreement for the Software Development Kit (“EULA”) available at 
+ ** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+ ** 
+ ** (2) if the Software is obtained from any third party, such licensing terms 
+ ** as notified by that third party,
+ ** 
+ ** and all subject to the following:
+ ** 
+ ** (3) the copyright notices in the Software and this entire statement, 
+ ** including the above license grant, this restriction and the following 
+ ** disclaimer, must be included in all copies of the Software, in whole or in 
+ ** part, and all derivative works of the Software, unless such copies or 
+ ** derivative works are solely in the form of machine-executable object code 
+ ** generated by a source language processor.
+ ** 
+ ** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ ** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ ** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+ ** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+ ** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+ ** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ ** DEALINGS IN THE SOFTWARE.
+ ** 
+ ** A copy of the Software is available free of charge at 
+ ** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+ ** 
+ ** -LICENSE-END-
+ */
+
+#include "MP4SyncCheck.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace
+{
+	struct TrackTimeline
+	{
+		uint32_t	trackID;
+		uint32_t	handlerType;
+		uint32_t	timeScale;
+		uint32_t	defaultDuration;
+		uint64_t	sampleCount;
+		int64_t		firstPresentationTime;
+		int64_t		nextDecodeTime;				// End of the previous fragment, -1 before the first
+		uint64_t	gapCount;
+		double		gapSeconds;
+
+		double		fragmentStart;				// Presentation interval of the current fragment, in seconds
+		double		fragmentEnd;
+		bool		inFragment;
+		bool		discontinuous;				// This fragment doesn't follow on from the previous one
+	};
+
+	const uint32_t kHandlerVideo = 0x76696465;	// 'vide'
+	const uint32_t kHandlerSound = 0x736F756E;	// 'soun'
+
+	uint32_t fourCC(const char* name)
+	{
+		return ((uint32_t)name[0] << 24) | (name[1] << 16) | (name[2] << 8) | name[3];
+	}
+
+	class BoxReader
+	{
+	public:
+		BoxReader() : m_data(NULL), m_size(0), m_offset(0) { }
+		BoxReader(const uint8_t* data, size_t size) : m_data(data), m_size(size), m_offset(0) { }
+
+		bool		atEnd() const { return m_offset >= m_size; }
+		size_t		remaining() const { return m_size - std::min(m_offset, m_size); }
+		void		skip(size_t count) { m_offset += count; }
+
+		uint32_t	read8() { return (m_offset < m_size) ? m_data[m_offset++] : 0; }
+		uint32_t	read16() { uint32_t value = read8() << 8; return value | read8(); }
+		uint32_t	read32() { uint32_t value = read16() << 16; return value | read16(); }
+		uint64_t	read64() { uint64_t value = (uint64_t)read32() << 32; return value | read32(); }
+
+		// Returns a reader over the contents of the next child box
+		bool nextBox(uint32_t* type, BoxReader* contents)
+		{
+			if (remaining() < 8)
+				return false;
+
+			uint64_t size = read32();
+			*type = read32();
+			size_t header = 8;
+			if (size == 1)
+			{
+				size = read64();
+				header = 16;
+			}
+			else if (size == 0)
+			{
+				size = remaining() + header;
+			}
+
+			if (size < header || size - header > remaining())
+				return false;
+
+			*contents = BoxReader(m_data + m_offset, size - header);
+			m_offset += size - header;
+			return true;
+		}
+
+		// Find the first child box of the given type
+		bool findBox(const char* name, BoxReader* contents)
+		{
+			uint32_t wanted = fourCC(name);
+			BoxReader reader(m_data, m_size);
+			uint32_t type;
+			while (reader.nextBox(&type, contents))
+			{
+				if (type == wanted)
+					return true;
+			}
+			return false;
+		}
+
+	private:
+		const uint8_t*	m_data;
+		size_t			m_size;
+		size_t			m_offset;
+	};
+
+	void parseMovie(BoxReader moov, std::vector<TrackTimeline>& tracks)
+	{
+		BoxReader	box;
+		uint32_t	type;
+
+		while (moov.nextBox(&type, &box))
+		{
+			if (type == fourCC("trak"))
+			{
+				TrackTimeline track;
+				memset(&track, 0, sizeof(track));
+				track.firstPresentationTime = INT64_MAX;
+				track.nextDecodeTime = -1;
+
+				BoxReader tkhd, mdia, mdhd, hdlr;
+				if (!box.findBox("tkhd", &tkhd) || !box.findBox("mdia", &mdia) ||
+					!mdia.findBox("mdhd", &mdhd) || !mdia.findBox("hdlr", &hdlr))
+					continue;
+
+				uint32_t version = tkhd.read32() >> 24;
+				tkhd.skip(version == 1 ? 16 : 8);
+				track.trackID = tkhd.read32();
+
+				version = mdhd.read32() >> 24;
+				mdhd.skip(version == 1 ? 16 : 8);
+				track.timeScale = mdhd.read32();
+
+				hdlr.skip(8);
+				track.handlerType = hdlr.read32();
+
+				if (track.timeScale != 0)
+					tracks.push_back(track);
+			}
+			else if (type == fourCC("mvex"))
+			{
+				BoxReader trex;
+				uint32_t childType;
+				while (box.nextBox(&childType, &trex))
+				{
+					if (childType != fourCC("trex"))
+						continue;
+
+					trex.skip(4);
+					uint32_t trackID = trex.read32();
+					trex.skip(4);
+					uint32_t defaultDuration = trex.read32();
+					for (TrackTimeline& track : tracks)
+					{
+						if (track.trackID == trackID)
+							track.defaultDuration = defaultDuration;
+					}
+				}
+			}
+		}
+	}
+
+	void parseTrackFragment(BoxReader traf, std::vector<TrackTimeline>& tracks)
+	{
+		BoxReader tfhd, tfdt;
+		if (!traf.findBox("tfhd", &tfhd) || !traf.findBox("tfdt", &tfdt))
+			return;
+
+		uint32_t flags = tfhd.read32() & 0xFFFFFF;
+		uint32_t trackID = tfhd.read32();
+
+		TrackTimeline* track = NULL;
+		for (TrackTimeline& candidate : tracks)
+		{
+			if (candidate.trackID == trackID)
+				track = &candidate;
+		}
+		if (!track)
+			return;
+
+		uint32_t defaultDuration = track->defaultDuration;
+		if (flags & 0x000001)
+			tfhd.skip(8);						// base_data_offset
+		if (flags & 0x000002)
+			tfhd.skip(4);						// sample_description_index
+		if (flags & 0x000008)
+			defaultDuration = tfhd.read32();
+
+		uint32_t version = tfdt.read32() >> 24;
+		int64_t decodeTime = (version == 1) ? tfdt.read64() : tfdt.read32();
+
+		if (track->nextDecodeTime >= 0 && decodeTime != track->nextDecodeTime)
+		{
+			track->gapCount++;
+			track->gapSeconds += (double)(decodeTime - track->nextDecodeTime) / track->timeScale;
+			track->discontinuous = true;
+		}
+
+		int64_t startTime = INT64_MAX;
+		int64_t endTime = INT64_MIN;
+
+		BoxReader	trun;
+		uint32_t	type;
+		while (traf.nextBox(&type, &trun))
+		{
+			if (type != fourCC("trun"))
+				continue;
+
+			uint32_t versionAndFlags = trun.read32();
+			uint32_t trunFlags = versionAndFlags & 0xFFFFFF;
+			uint32_t sampleCount = trun.read32();
+			if (trunFlags & 0x000001)
+				trun.skip(4);					// data_offset
+			if (trunFlags & 0x000004)
+				trun.skip(4);					// first_sample_flags
+
+			for (uint32_t i = 0; i < sampleCount; i++)
+			{
+				uint32_t	duration = (trunFlags & 0x000100) ? trun.read32() : defaultDuration;
+				int64_t		compositionOffset = 0;
+
+				if (trunFlags & 0x000200)
+					trun.skip(4);
+				if (trunFlags & 0x000400)
+					trun.skip(4);
+				if (trunFlags & 0x000800)
+					compositionOffset = (versionAndFlags >> 24) ? (int64_t)(int32_t)trun.read32() : trun.read32();
+
+				int64_t presentationTime = decodeTime + compositionOffset;
+				startTime = std::min(startTime, presentationTime);
+				endTime = std::max(endTime, presentationTime + duration);
+				decodeTime += duration;
+			}
+
+			track->sampleCount += sampleCount;
+		}
+
+		track->nextDecodeTime = decodeTime;
+		if (startTime <= endTime)
+		{
+			track->firstPresentationTime = std::min(track->firstPresentationTime, startTime);
+			track->fragmentStart = (double)startTime / track->timeScale;
+			track->fragmentEnd = (double)endTime / track->timeScale;
+			track->inFragment = true;
+		}
+	}
+
+	// A playlist lists its initialization segment and media segments, which read in order are a single recording
+	bool listRecordingFiles(const std::string& path, std::vector<std::string>& files)
+	{
+		static const char kPlaylistExtension[] = ".m3u8";
+		static const char kMapTag[] = "#EXT-X-MAP:URI=\"";
+
+		if (path.size() < sizeof(kPlaylistExtension) ||
+			path.compare(path.size() - sizeof(kPlaylistExtension) + 1, std::string::npos, kPlaylistExtension) != 0)
+		{
+			files.push_back(path);
+			return true;
+		}
+
+		FILE* playlist = fopen(path.c_str(), "r");
+		if (!playlist)
+			return false;
+
+		size_t		separator = path.rfind('/');
+		std::string	directory = (separator == std::string::npos) ? std::string() : path.substr(0, separator + 1);
+		char		line[1024];
+
+		while (fgets(line, sizeof(line), playlist))
+		{
+			std::string entry(line);
+			entry.erase(entry.find_last_not_of("\r\n") + 1);
+
+			if (entry.compare(0, sizeof(kMapTag) - 1, kMapTag) == 0)
+				files.push_back(directory + entry.substr(sizeof(kMapTag) - 1, entry.find('"', sizeof(kMapTag) - 1) - (sizeof(kMapTag) - 1)));
+			else if (!entry.empty() && entry[0] != '#')
+				files.push_back(directory + entry);
+		}
+
+		fclose(playlist);
+		return !files.empty();
+	}
+}
+
+bool CheckAudioVideoSync(const char* path, double toleranceMs)
+{
+	std::vector<std::string> files;
+	if (!listRecordingFiles(path, files))
+	{
+		fprintf(stderr, "Could not open %s\n", path);
+		return false;
+	}
+
+	std::vector<TrackTimeline>	tracks;
+	std::vector<uint8_t>		box;
+	uint64_t					fragmentCount = 0;
+	double						maxAudioLead = 0.0;
+	double						maxAudioLag = 0.0;
+	double						maxAudioJump = 0.0;
+	bool						success = true;
+
+	for (const std::string& fileName : files)
+	{
+		FILE* file = fopen(fileName.c_str(), "rb");
+		if (!file)
+		{
+			fprintf(stderr, "Could not open %s\n", fileName.c_str());
+			return false;
+		}
+
+		// Read the boxes at the top level of the file, skipping the media data
+		while (true)
+		{
+			uint8_t header[16];
+			if (fread(header, 1, 8, file) != 8)
+				break;
+
+			uint64_t	size = ((uint32_t)header[0] << 24) | (header[1] << 16) | (header[2] << 8) | header[3];
+			uint32_t	type = ((uint32_t)header[4] << 24) | (header[5] << 16) | (header[6] << 8) | header[7];
+			uint64_t	headerSize = 8;
+
+			if (size == 1)
+			{
+				if (fread(header + 8, 1, 8, file) != 8)
+					break;
+				size = BoxReader(header + 8, 8).read64();
+				headerSize = 16;
+			}
+
+			if (size == 0 || size < headerSize)
+				break;
+
+			if (type != fourCC("moov") && type != fourCC("moof"))
+			{
+				if (fseeko(file, size - headerSize, SEEK_CUR) != 0)
+					break;
+				continue;
+			}
+
+			box.resize(size - headerSize);
+			if (fread(box.data(), 1, box.size(), file) != box.size())
+			{
+				fprintf(stderr, "%s is truncated\n", fileName.c_str());
+				break;
+			}
+
+			BoxReader contents(box.data(), box.size());
+
+			if (type == fourCC("moov"))
+			{
+				parseMovie(contents, tracks);
+				continue;
+			}
+
+			for (TrackTimeline& track : tracks)
+			{
+				track.inFragment = false;
+				track.discontinuous = false;
+			}
+
+			BoxReader	traf;
+			uint32_t	childType;
+			while (contents.nextBox(&childType, &traf))
+			{
+				if (childType == fourCC("traf"))
+					parseTrackFragment(traf, tracks);
+			}
+			fragmentCount++;
+
+			const TrackTimeline* video = NULL;
+			const TrackTimeline* audio = NULL;
+			for (const TrackTimeline& track : tracks)
+			{
+				if (track.handlerType == kHandlerVideo && track.inFragment)
+					video = &track;
+				else if (track.handlerType == kHandlerSound && track.inFragment)
+					audio = &track;
+			}
+
+			if (video && audio)
+			{
+				// Positive when the audio in the fragment runs past the end of the video
+				double lead = audio->fragmentEnd - video->fragmentEnd;
+				maxAudioLead = std::max(maxAudioLead, lead);
+				maxAudioLag = std::max(maxAudioLag, -lead);
+
+				// A gap in the audio alone moves it relative to the video for players that ignore the tfdt
+				if (audio->discontinuous && !video->discontinuous)
+					maxAudioJump = std::max(maxAudioJump, audio->gapSeconds);
+			}
+		}
+
+		fclose(file);
+	}
+
+	const TrackTimeline* video = NULL;
+	const TrackTimeline* audio = NULL;
+	for (const TrackTimeline& track : tracks)
+	{
+		if (track.handlerType == kHandlerVideo && !video)
+			video = &track;
+		else if (track.handlerType == kHandlerSound && !audio)
+			audio = &track;
+	}
+
+	if (!video || !audio || video->sampleCount == 0 || audio->sampleCount == 0)
+	{
+		fprintf(stderr, "%s needs both a video and an audio track with samples\n", path);
+		return false;
+	}
+
+	double videoStart = (double)video->firstPresentationTime / video->timeScale;
+	double audioStart = (double)audio->firstPresentationTime / audio->timeScale;
+	double videoEnd = (double)video->nextDecodeTime / video->timeScale;
+	double audioEnd = (double)audio->nextDecodeTime / audio->timeScale;
+	double startOffsetMs = (audioStart - videoStart) * 1000.0;
+
+	printf("%s: %llu fragments\n", path, (unsigned long long)fragmentCount);
+	printf("  Video: %llu frames, %.3f s to %.3f s, %llu gaps totalling %.3f s\n",
+			(unsigned long long)video->sampleCount, videoStart, videoEnd, (unsigned long long)video->gapCount, video->gapSeconds);
+	printf("  Audio: %llu sample frames, %.3f s to %.3f s, %llu gaps totalling %.3f s\n",
+			(unsigned long long)audio->sampleCount, audioStart, audioEnd, (unsigned long long)audio->gapCount, audio->gapSeconds);
+	printf("  Audio starts %+.2f ms from the video, leads by up to %.2f ms and lags by up to %.2f ms per fragment\n",
+			startOffsetMs, maxAudioLead * 1000.0, maxAudioLag * 1000.0);
+
+	if (startOffsetMs > toleranceMs || startOffsetMs < -toleranceMs)
+	{
+		printf("  FAIL: audio starts more than %.2f ms from the video\n", toleranceMs);
+		success = false;
+	}
+
+	if (maxAudioJump * 1000.0 > toleranceMs)
+	{
+		printf("  FAIL: audio jumps by %.2f ms where the video is continuous\n", maxAudioJump * 1000.0);
+		success = false;
+	}
+
+	if (success)
+		printf("  PASS: audio is within %.2f ms of the video\n", toleranceMs);
+
+	return success;
+}
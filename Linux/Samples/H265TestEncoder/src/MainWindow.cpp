@@ -99,8 +99,8 @@ protected:
 
 MainWindow::MainWindow()
 {
-	setMinimumSize(682, 538 - 50 + 76);
-	setMaximumSize(682, 538 - 50 + 76);
+	setMinimumSize(682, 538 - 50 + 76 + 44);
+	setMaximumSize(682, 538 - 50 + 76 + 44);
 	QFontDatabase::addApplicationFont(":/gotham-xlight");
 	QFontDatabase::addApplicationFont(":/OpenSans-Light");
 	QFontDatabase::addApplicationFont(":/OpenSans-Semibold");
@@ -160,4 +160,9 @@ void MainWindow::recordingFinished()
 	m_controlsWidget->onRecordingStopped();
 }
 
+void MainWindow::telemetryUpdated(EncoderTelemetry::Summary summary)
+{
+	m_controlsWidget->onTelemetryUpdated(summary);
+}
+
 
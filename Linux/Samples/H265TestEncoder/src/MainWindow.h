@@ -42,6 +42,8 @@
 #include <stdint.h>
 #include <QMainWindow>
 
+#include "EncoderTelemetry.h"
+
 class ControlsWidget;
 class DeckLinkDevice;
 
@@ -61,6 +63,7 @@ private:
 public slots:
 	void recordingStarted(QString displayMode, uint32_t frameRate);
 	void recordingFinished();
+	void telemetryUpdated(EncoderTelemetry::Summary summary);
 
 };
 
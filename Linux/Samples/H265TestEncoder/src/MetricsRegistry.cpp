@@ -0,0 +1,217 @@
+/* -LICENSE-START-
+** Copyright (c) 2022 Blackmagic Design
+**  
+** Permission is hereby granted, free of charge, to any person or organization 
+** obtaining a copy of the software and accompanying documentation (the 
+** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+** and transmit the Software, and to prepare derivative works of the Software, 
+** and to permit third-parties to whom the Software is furnished to do so, in 
+** accordance with:
+** 
+** (1) if the Software is obtained from Blackmagic Design, the End User License 
+** Agreement for the Software Development Kit (“EULA”) available at 
+** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+** 
+** (2) if the Software is obtained from any third party, such licensing terms 
+** as notified by that third party,
+** 
+** and all subject to the following:
+** 
+** (3) the copyright notices in the Software and this entire statement, 
+** including the above license grant, this restriction and the following 
+** disclaimer, must be included in all copies of the Software, in whole or in 
+** part, and all derivative works of the Software, unless such copies or 
+** derivative works are solely in the form of machine-executable object code 
+** generated by a source language processor.
+** 
+** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+** DEALINGS IN THE SOFTWARE.
+** 
+** A copy of the Software is available free of charge at 
+** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+** 
+** -LICENSE-END-
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <set>
+#include <stdexcept>
+#include <stdio.h>
+
+#include "MetricsRegistry.h"
+
+static const double kHistogramSumScale = 1000000.0;
+
+// MetricHistogram
+
+MetricHistogram::MetricHistogram(const std::vector<double>& bucketBounds) :
+	m_bucketBounds(bucketBounds),
+	m_bucketCounts(new std::atomic<uint64_t>[bucketBounds.size() + 1]),
+	m_count(0),
+	m_sumMicroUnits(0)
+{
+	if (!std::is_sorted(m_bucketBounds.begin(), m_bucketBounds.end()))
+		throw std::invalid_argument("Histogram bucket bounds must be in increasing order");
+
+	for (size_t i = 0; i <= m_bucketBounds.size(); i++)
+		m_bucketCounts[i] = 0;
+}
+
+void MetricHistogram::observe(double value)
+{
+	// Binary search for first bucket with upper bound >= value, the final bucket is +Inf
+	size_t bucket = std::lower_bound(m_bucketBounds.begin(), m_bucketBounds.end(), value) - m_bucketBounds.begin();
+
+	m_bucketCounts[bucket].fetch_add(1, std::memory_order_relaxed);
+	m_sumMicroUnits.fetch_add((int64_t)std::llround(value * kHistogramSumScale), std::memory_order_relaxed);
+	m_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+uint64_t MetricHistogram::getCumulativeCount(size_t bucket) const
+{
+	uint64_t count = 0;
+
+	for (size_t i = 0; (i <= bucket) && (i <= m_bucketBounds.size()); i++)
+		count += m_bucketCounts[i].load(std::memory_order_relaxed);
+
+	return count;
+}
+
+double MetricHistogram::getSum() const
+{
+	return (double)m_sumMicroUnits.load(std::memory_order_relaxed) / kHistogramSumScale;
+}
+
+// MetricsRegistry
+
+void MetricsRegistry::addMetric(Metric&& metric)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_metrics.push_back(std::move(metric));
+}
+
+MetricCounter& MetricsRegistry::addCounter(const std::string& name, const std::string& help, const std::string& labels)
+{
+	MetricCounter*	counter = new MetricCounter();
+	Metric			metric = { MetricType::Counter, name, help, labels, std::unique_ptr<MetricCounter>(counter), nullptr, nullptr, nullptr };
+
+	addMetric(std::move(metric));
+	return *counter;
+}
+
+MetricGauge& MetricsRegistry::addGauge(const std::string& name, const std::string& help, const std::string& labels)
+{
+	MetricGauge*	gauge = new MetricGauge();
+	Metric			metric = { MetricType::Gauge, name, help, labels, nullptr, std::unique_ptr<MetricGauge>(gauge), nullptr, nullptr };
+
+	addMetric(std::move(metric));
+	return *gauge;
+}
+
+MetricFloatGauge& MetricsRegistry::addFloatGauge(const std::string& name, const std::string& help, const std::string& labels)
+{
+	MetricFloatGauge*	gauge = new MetricFloatGauge();
+	Metric				metric = { MetricType::FloatGauge, name, help, labels, nullptr, nullptr, std::unique_ptr<MetricFloatGauge>(gauge), nullptr };
+
+	addMetric(std::move(metric));
+	return *gauge;
+}
+
+MetricHistogram& MetricsRegistry::addHistogram(const std::string& name, const std::string& help, const std::vector<double>& bucketBounds, const std::string& labels)
+{
+	MetricHistogram*	histogram = new MetricHistogram(bucketBounds);
+	Metric				metric = { MetricType::Histogram, name, help, labels, nullptr, nullptr, nullptr, std::unique_ptr<MetricHistogram>(histogram) };
+
+	addMetric(std::move(metric));
+	return *histogram;
+}
+
+void MetricsRegistry::forEachSample(const Metric& metric, const std::function<void(const std::string&, double)>& sampleFunction)
+{
+	std::string labels = metric.labels.empty() ? "" : "{" + metric.labels + "}";
+
+	switch (metric.type)
+	{
+		case MetricType::Counter:
+			sampleFunction(metric.name + labels, (double)metric.counter->getValue());
+			break;
+
+		case MetricType::Gauge:
+			sampleFunction(metric.name + labels, (double)metric.gauge->getValue());
+			break;
+
+		case MetricType::FloatGauge:
+			sampleFunction(metric.name + labels, metric.floatGauge->getValue());
+			break;
+
+		case MetricType::Histogram:
+		{
+			std::string labelPrefix = metric.labels.empty() ? "{" : "{" + metric.labels + ",";
+			char		bound[32];
+
+			for (size_t i = 0; i < metric.histogram->getBucketCount(); i++)
+			{
+				snprintf(bound, sizeof(bound), "%g", metric.histogram->getBucketBound(i));
+				sampleFunction(metric.name + "_bucket" + labelPrefix + "le=\"" + bound + "\"}", (double)metric.histogram->getCumulativeCount(i));
+			}
+			sampleFunction(metric.name + "_bucket" + labelPrefix + "le=\"+Inf\"}", (double)metric.histogram->getCumulativeCount(metric.histogram->getBucketCount()));
+			sampleFunction(metric.name + "_sum" + labels, metric.histogram->getSum());
+			sampleFunction(metric.name + "_count" + labels, (double)metric.histogram->getCount());
+			break;
+		}
+	}
+}
+
+std::string MetricsRegistry::getPrometheusText()
+{
+	std::lock_guard<std::mutex>	lock(m_mutex);
+	std::set<std::string>		describedMetrics;
+	std::string					text;
+	char						value[32];
+
+	// Samples for each metric name must be grouped together, in order of first registration
+	for (auto& family : m_metrics)
+	{
+		if (!describedMetrics.insert(family.name).second)
+			continue;
+
+		const char* typeName = (family.type == MetricType::Counter) ? "counter" : (family.type == MetricType::Histogram) ? "histogram" : "gauge";
+
+		text += "# HELP " + family.name + " " + family.help + "\n";
+		text += "# TYPE " + family.name + " " + typeName + "\n";
+
+		for (auto& metric : m_metrics)
+		{
+			if (metric.name != family.name)
+				continue;
+
+			forEachSample(metric, [&](const std::string& sampleName, double sampleValue)
+			{
+				snprintf(value, sizeof(value), "%.17g", sampleValue);
+				text += sampleName + " " + value + "\n";
+			});
+		}
+	}
+
+	return text;
+}
+
+void MetricsRegistry::getSamples(std::vector<MetricSample>& samples)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	samples.clear();
+	for (auto& metric : m_metrics)
+	{
+		forEachSample(metric, [&](const std::string& sampleName, double sampleValue)
+		{
+			samples.push_back({ sampleName, sampleValue });
+		});
+	}
+}
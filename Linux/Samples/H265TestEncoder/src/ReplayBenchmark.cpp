@@ -0,0 +1,147 @@
+/* -LICENSE-START-
+ ** Copyright (c) 2016 Blackmagic Design
+ **  
+ ** Permission is hereby granted, free of charge, to any person or organization 
+ ** obtaining a copy of the software and accompanying documentation (the 
+ ** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+ ** and transmit the Software, and to prepare derivative works of the Software, 
+ ** and to permit third-parties to whom the Software is furnished to do so, in 
+ ** accordance with:
+ ** 
+ ** (1) if the Software is obtained from Blackmagic Design, the End User License 
+ ** Agreement for the Software Development Kit (“EULA”) available at 
+ ** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+ ** 
+ ** (2) if the Software is obtained from any third party, such licensing terms 
+ ** as notified by that third party,
+ ** 
+ ** and all subject to the following:
+ ** 
+ ** (3) the copyright notices in the Software and this entire statement, 
+ ** including the above license grant, this restriction and the following 
+ ** disclaimer, must be included in all copies of the Software, in whole or in 
+ ** part, and all derivative works of the Software, unless such copies or 
+ ** derivative works are solely in the form of machine-executable object code 
+ ** generated by a source language processor.
+ ** 
+ ** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ ** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ ** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+ ** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+ ** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+ ** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ ** DEALINGS IN THE SOFTWARE.
+ ** 
+ ** A copy of the Software is available free of charge at 
+ ** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+ ** 
+ ** -LICENSE-END-
+ */
+
+#include <stdio.h>
+#include <QObject>
+
+#include "ReplayBenchmark.h"
+#include "ReplayEncoderInput.h"
+#include "ControllerImp.h"
+#include "DeckLinkDevice.h"
+
+static const uint32_t	kBenchmarkBitrate	= 20 * 1000 * 1000;
+
+// Prints the upper bound of the histogram bucket holding the given fraction of observations
+static void printPercentile(const char* name, const MetricHistogram& histogram, double fraction)
+{
+	uint64_t target = (uint64_t)(fraction * histogram.getCount());
+
+	for (size_t i = 0; i < histogram.getBucketCount(); i++)
+	{
+		if (histogram.getCumulativeCount(i) >= target)
+		{
+			printf(" %s <= %.0f us", name, histogram.getBucketBound(i));
+			return;
+		}
+	}
+
+	printf(" %s > %.0f us", name, histogram.getBucketBound(histogram.getBucketCount() - 1));
+}
+
+bool RunReplayBenchmark(const char* path, int64_t frameDuration, int64_t timeScale, double speed, uint32_t loopCount)
+{
+	ControllerImp			controller;
+	ReplayEncoderInput*		encoderInput;
+	bool					success = false;
+
+	if (loopCount == 0)
+		loopCount = 1;
+	encoderInput = new ReplayEncoderInput(path, frameDuration, timeScale, speed, loopCount);
+
+	// Without a window the controller's error messages go to stderr
+	QObject::connect(&controller, &ControllerImp::displayErrorMessage, [](const QString& title, const QString& message) {
+		fprintf(stderr, "%s: %s\n", title.toUtf8().constData(), message.toUtf8().constData());
+	});
+
+	if (!encoderInput->init())
+	{
+		fprintf(stderr, "Unable to read an HEVC stream from %s\n", path);
+		encoderInput->Release();
+		return false;
+	}
+
+	ReplayDeckLink*		deckLink = new ReplayDeckLink(encoderInput);
+	DeckLinkDevice*		device = new DeckLinkDevice(&controller, deckLink);
+
+	if (!device->init())
+	{
+		fprintf(stderr, "Unable to initialise the replay device\n");
+		device->Release();
+		encoderInput->Release();
+		return false;
+	}
+
+	if (device->startCapture(device->defaultMode(), kBenchmarkBitrate, &controller.m_encoderTelemetry))
+	{
+		if (speed > 0.0)
+			printf("Replaying %s as %s at %gx real time, %u loop(s)\n", path, encoderInput->getDisplayModeName().c_str(), speed, loopCount);
+		else
+			printf("Replaying %s as %s as fast as possible, %u loop(s)\n", path, encoderInput->getDisplayModeName().c_str(), loopCount);
+
+		encoderInput->waitForEnd();
+
+		ReplayEncoderInput::Statistics	statistics = encoderInput->getStatistics();
+		AsyncFileWriter::Statistics		writerStatistics = device->m_videoWriter->getFileWriterStatistics();
+		MP4Muxer::Statistics			muxerStatistics = device->m_videoWriter->getMuxerStatistics();
+		EncoderTelemetry::Summary		summary = controller.m_encoderTelemetry.getSummary();
+		const MetricHistogram&			callbackTime = encoderInput->getCallbackTimeHistogram();
+		double							elapsed = (statistics.elapsedSeconds > 0.0) ? statistics.elapsedSeconds : 1e-6;
+
+		printf("  Delivered %llu frames, %llu NAL units, %.1f MB in %.3f s: %.1f frames/s, %.1f Mb/s\n",
+				(unsigned long long)statistics.frames, (unsigned long long)statistics.packets, statistics.bytes / 1e6,
+				statistics.elapsedSeconds, statistics.frames / elapsed, statistics.bytes * 8 / elapsed / 1e6);
+		printf("  Callback time per frame: mean %.1f us, max %.0f us,", statistics.meanCallbackMicroseconds, statistics.maxCallbackMicroseconds);
+		printPercentile("p50", callbackTime, 0.50);
+		printPercentile("p99", callbackTime, 0.99);
+		printf("\n  Late frames %llu, audio packets %llu\n",
+				(unsigned long long)statistics.lateFrames, (unsigned long long)statistics.audioPackets);
+		printf("  Muxer: %llu access units (%llu dropped), %llu fragments (%llu dropped), %llu segments\n",
+				(unsigned long long)muxerStatistics.accessUnits, (unsigned long long)muxerStatistics.droppedAccessUnits,
+				(unsigned long long)muxerStatistics.fragments, (unsigned long long)muxerStatistics.droppedFragments,
+				(unsigned long long)muxerStatistics.segments);
+		printf("  Writer: %.1f MB queued, %.1f MB dropped, peak %zu blocks queued\n",
+				writerStatistics.bytesQueued / 1e6, writerStatistics.bytesDropped / 1e6, writerStatistics.peakBlocksQueued);
+		printf("  Telemetry: %.2f Mb/s over the last second, latency %.1f ms (max %.1f ms), keyframe interval %lld frames\n",
+				summary.windowBitrate / 1e6, summary.windowLatencyMs, summary.maxWindowLatencyMs, (long long)summary.keyframeInterval);
+
+		// Unpaced replay measures the callback, the writer is expected to fall behind
+		success = (speed <= 0.0) || (statistics.lateFrames == 0 && writerStatistics.bytesDropped == 0 &&
+									 muxerStatistics.droppedFragments == 0 && writerStatistics.writeErrors == 0);
+		if (!success)
+			fprintf(stderr, "Replay at %gx real time did not keep up\n", speed);
+	}
+
+	// The recording is only needed for the writer statistics
+	device->stopCapture(true);
+	device->Release();
+	encoderInput->Release();
+
+	return success;
+}
@@ -0,0 +1,927 @@
+/* -LICENSE-START-
+ ** Copyright (c) 2016 Blackmagic Design
+ **  
+ ** Permission is hereby granted, free of charge, to any person or organization 
+ ** obtaining a copy of the software and accompanying documentation (the 
+ ** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+ ** and transmit the Software, and to prepare derivative works of the Software, 
+ ** and to permit third-parties to whom the Software is furnished to do so, in 
+ ** accordance with:
+ ** 
+ ** (1) if the Software is obtained from Blackmagic Design, the End User License 
+ ** Agreement for the Software Development Kit (“EULA”) available at 
+ ** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+ ** 
+ ** (2) if the Software is obtained from any third party, such licensing terms 
+ ** as notified by that third party,
+ ** 
+ ** and all subject to the following:
+ ** 
+ ** (3) the copyright notices in the Software and this entire statement, 
+ ** including the above license grant, this restriction and the following 
+ ** disclaimer, must be included in all copies of the Software, in whole or in 
+ ** part, and all derivative works of the Software, unless such copies or 
+ ** derivative works are solely in the form of machine-executable object code 
+ ** generated by a source language processor.
+ ** 
+ ** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ ** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ ** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+ ** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+ ** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+ ** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ ** DEALINGS IN THE SOFTWARE.
+ ** 
+ ** A copy of the Software is available free of charge at 
+ ** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+ ** 
+ ** -LICENSE-END-
+ */
+
+#include "ReplayEncoderInput.h"
+#include "HEVCParser.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+// Frames the encoder takes to deliver a picture after the last frame it waits for has been input
+static const int64_t	kEncodeDelayFrames			= 1;
+
+static const std::vector<double>	kCallbackTimeBuckets	= { 10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000, 20000, 50000, 100000 };
+
+namespace
+{
+	const uint8_t	kHEVCNALTypeEndOfSequence	= 36;
+	const uint8_t	kHEVCNALTypeEndOfBitstream	= 37;
+	const uint8_t	kHEVCNALTypeFillerData		= 38;
+	const uint8_t	kHEVCNALTypeSuffixSEI		= 40;
+
+	struct DisplayModeInfo
+	{
+		BMDDisplayMode	mode;
+		long			width;
+		long			height;
+		BMDTimeScale	timeScale;
+		BMDTimeValue	frameDuration;
+		const char*		name;
+	};
+
+	const DisplayModeInfo kDisplayModes[] =
+	{
+		{ bmdModeHD720p50,		1280,	720,	50000,	1000,	"720p50" },
+		{ bmdModeHD720p5994,	1280,	720,	60000,	1001,	"720p59.94" },
+		{ bmdModeHD720p60,		1280,	720,	60000,	1000,	"720p60" },
+		{ bmdModeHD1080p2398,	1920,	1080,	24000,	1001,	"1080p23.98" },
+		{ bmdModeHD1080p24,		1920,	1080,	24000,	1000,	"1080p24" },
+		{ bmdModeHD1080p25,		1920,	1080,	25000,	1000,	"1080p25" },
+		{ bmdModeHD1080p2997,	1920,	1080,	30000,	1001,	"1080p29.97" },
+		{ bmdModeHD1080p30,		1920,	1080,	30000,	1000,	"1080p30" },
+		{ bmdModeHD1080p50,		1920,	1080,	50000,	1000,	"1080p50" },
+		{ bmdModeHD1080p5994,	1920,	1080,	60000,	1001,	"1080p59.94" },
+		{ bmdModeHD1080p6000,	1920,	1080,	60000,	1000,	"1080p60" },
+		{ bmdMode4K2160p2398,	3840,	2160,	24000,	1001,	"2160p23.98" },
+		{ bmdMode4K2160p24,		3840,	2160,	24000,	1000,	"2160p24" },
+		{ bmdMode4K2160p25,		3840,	2160,	25000,	1000,	"2160p25" },
+		{ bmdMode4K2160p2997,	3840,	2160,	30000,	1001,	"2160p29.97" },
+		{ bmdMode4K2160p30,		3840,	2160,	30000,	1000,	"2160p30" },
+		{ bmdMode4K2160p50,		3840,	2160,	50000,	1000,	"2160p50" },
+		{ bmdMode4K2160p5994,	3840,	2160,	60000,	1001,	"2160p59.94" },
+		{ bmdMode4K2160p60,		3840,	2160,	60000,	1000,	"2160p60" },
+	};
+
+	bool isIID(REFIID iid, REFIID other)
+	{
+		return memcmp(&iid, &other, sizeof(REFIID)) == 0;
+	}
+
+	int64_t rescale(int64_t time, int64_t fromTimeScale, int64_t toTimeScale)
+	{
+		return (fromTimeScale == toTimeScale) ? time : time * toTimeScale / fromTimeScale;
+	}
+
+	class ReplayDisplayMode : public IDeckLinkDisplayMode
+	{
+	public:
+		ReplayDisplayMode(BMDDisplayMode mode, const std::string& name, long width, long height, BMDTimeValue frameDuration, BMDTimeScale timeScale) :
+			m_mode(mode), m_name(name), m_width(width), m_height(height), m_frameDuration(frameDuration), m_timeScale(timeScale), m_refCount(1) { }
+
+		virtual HRESULT				GetName(const char** name) { *name = strdup(m_name.c_str()); return S_OK; }
+		virtual BMDDisplayMode		GetDisplayMode() { return m_mode; }
+		virtual long				GetWidth() { return m_width; }
+		virtual long				GetHeight() { return m_height; }
+		virtual HRESULT				GetFrameRate(BMDTimeValue* frameDuration, BMDTimeScale* timeScale) { *frameDuration = m_frameDuration; *timeScale = m_timeScale; return S_OK; }
+		virtual BMDFieldDominance	GetFieldDominance() { return bmdProgressiveFrame; }
+		virtual BMDDisplayModeFlags	GetFlags() { return (m_height > 1080) ? (bmdDisplayModeColorspaceRec709 | bmdDisplayModeColorspaceRec2020) : bmdDisplayModeColorspaceRec709; }
+
+		virtual HRESULT				QueryInterface(REFIID iid, LPVOID *ppv)
+		{
+			*ppv = NULL;
+			if (!isIID(iid, IID_IUnknown) && !isIID(iid, IID_IDeckLinkDisplayMode))
+				return E_NOINTERFACE;
+
+			*ppv = this;
+			AddRef();
+			return S_OK;
+		}
+		virtual ULONG				AddRef() { return ++m_refCount; }
+		virtual ULONG				Release()
+		{
+			int32_t refCount = --m_refCount;
+			if (refCount == 0)
+				delete this;
+			return refCount;
+		}
+
+	private:
+		BMDDisplayMode				m_mode;
+		std::string					m_name;
+		long						m_width;
+		long						m_height;
+		BMDTimeValue				m_frameDuration;
+		BMDTimeScale				m_timeScale;
+		std::atomic<int32_t>		m_refCount;
+	};
+
+	// Iterates over the single display mode of the replayed stream
+	class ReplayDisplayModeIterator : public IDeckLinkDisplayModeIterator
+	{
+	public:
+		ReplayDisplayModeIterator(IDeckLinkDisplayMode* displayMode) : m_displayMode(displayMode), m_refCount(1) { }
+		virtual ~ReplayDisplayModeIterator()
+		{
+			if (m_displayMode)
+				m_displayMode->Release();
+		}
+
+		virtual HRESULT				Next(IDeckLinkDisplayMode** deckLinkDisplayMode)
+		{
+			// The caller takes the iterator's reference
+			*deckLinkDisplayMode = m_displayMode;
+			m_displayMode = NULL;
+			return *deckLinkDisplayMode ? S_OK : S_FALSE;
+		}
+
+		virtual HRESULT				QueryInterface(REFIID iid, LPVOID *ppv)
+		{
+			*ppv = NULL;
+			if (!isIID(iid, IID_IUnknown) && !isIID(iid, IID_IDeckLinkDisplayModeIterator))
+				return E_NOINTERFACE;
+
+			*ppv = this;
+			AddRef();
+			return S_OK;
+		}
+		virtual ULONG				AddRef() { return ++m_refCount; }
+		virtual ULONG				Release()
+		{
+			int32_t refCount = --m_refCount;
+			if (refCount == 0)
+				delete this;
+			return refCount;
+		}
+
+	private:
+		IDeckLinkDisplayMode*		m_displayMode;
+		std::atomic<int32_t>		m_refCount;
+	};
+
+	// A NAL unit in the replayed stream, the bytes stay valid for as long as the ReplayEncoderInput
+	class ReplayNALPacket : public IDeckLinkH265NALPacket
+	{
+	public:
+		ReplayNALPacket(const uint8_t* bytes, uint32_t prefixSize, uint32_t size, uint8_t unitType,
+						int64_t streamTime, int64_t inputTime, int64_t frameDuration, int64_t timeScale) :
+			m_bytes(bytes), m_prefixSize(prefixSize), m_size(size), m_unitType(unitType),
+			m_streamTime(streamTime), m_inputTime(inputTime), m_frameDuration(frameDuration), m_timeScale(timeScale), m_refCount(1) { }
+
+		virtual HRESULT				GetBytes(void** buffer) { *buffer = (void*)m_bytes; return S_OK; }
+		virtual long				GetSize() { return m_prefixSize + m_size; }
+		virtual HRESULT				GetStreamTime(BMDTimeValue* frameTime, BMDTimeScale timeScale)
+		{
+			*frameTime = rescale(m_streamTime, m_timeScale, timeScale);
+			return S_OK;
+		}
+		virtual BMDPacketType		GetPacketType() { return bmdPacketTypeStreamData; }
+		virtual BMDPixelFormat		GetPixelFormat() { return bmdFormatH265; }
+		virtual HRESULT				GetHardwareReferenceTimestamp(BMDTimeScale timeScale, BMDTimeValue* frameTime, BMDTimeValue* frameDuration)
+		{
+			*frameTime = rescale(m_inputTime, m_timeScale, timeScale);
+			*frameDuration = rescale(m_frameDuration, m_timeScale, timeScale);
+			return S_OK;
+		}
+		virtual HRESULT				GetTimecode(BMDTimecodeFormat, IDeckLinkTimecode** timecode) { *timecode = NULL; return S_FALSE; }
+		virtual HRESULT				GetUnitType(uint8_t* unitType) { *unitType = m_unitType; return S_OK; }
+		virtual HRESULT				GetBytesNoPrefix(void** buffer) { *buffer = (void*)(m_bytes + m_prefixSize); return S_OK; }
+		virtual long				GetSizeNoPrefix() { return m_size; }
+
+		virtual HRESULT				QueryInterface(REFIID iid, LPVOID *ppv)
+		{
+			*ppv = NULL;
+			if (!isIID(iid, IID_IUnknown) && !isIID(iid, IID_IDeckLinkEncoderPacket) &&
+				!isIID(iid, IID_IDeckLinkEncoderVideoPacket) && !isIID(iid, IID_IDeckLinkH265NALPacket))
+				return E_NOINTERFACE;
+
+			*ppv = this;
+			AddRef();
+			return S_OK;
+		}
+		virtual ULONG				AddRef() { return ++m_refCount; }
+		virtual ULONG				Release()
+		{
+			int32_t refCount = --m_refCount;
+			if (refCount == 0)
+				delete this;
+			return refCount;
+		}
+
+	private:
+		const uint8_t*				m_bytes;
+		uint32_t					m_prefixSize;
+		uint32_t					m_size;
+		uint8_t						m_unitType;
+		int64_t						m_streamTime;
+		int64_t						m_inputTime;
+		int64_t						m_frameDuration;
+		int64_t						m_timeScale;
+		std::atomic<int32_t>		m_refCount;
+	};
+
+	class ReplayAudioPacket : public IDeckLinkEncoderAudioPacket
+	{
+	public:
+		ReplayAudioPacket(const uint8_t* samples, uint32_t size, int64_t streamTime, int64_t sampleRate) :
+			m_samples(samples), m_size(size), m_streamTime(streamTime), m_sampleRate(sampleRate), m_refCount(1) { }
+
+		virtual HRESULT				GetBytes(void** buffer) { *buffer = (void*)m_samples; return S_OK; }
+		virtual long				GetSize() { return m_size; }
+		virtual HRESULT				GetStreamTime(BMDTimeValue* frameTime, BMDTimeScale timeScale)
+		{
+			*frameTime = rescale(m_streamTime, m_sampleRate, timeScale);
+			return S_OK;
+		}
+		virtual BMDPacketType		GetPacketType() { return bmdPacketTypeStreamData; }
+		virtual BMDAudioFormat		GetAudioFormat() { return bmdAudioFormatPCM; }
+
+		virtual HRESULT				QueryInterface(REFIID iid, LPVOID *ppv)
+		{
+			*ppv = NULL;
+			if (!isIID(iid, IID_IUnknown) && !isIID(iid, IID_IDeckLinkEncoderPacket) && !isIID(iid, IID_IDeckLinkEncoderAudioPacket))
+				return E_NOINTERFACE;
+
+			*ppv = this;
+			AddRef();
+			return S_OK;
+		}
+		virtual ULONG				AddRef() { return ++m_refCount; }
+		virtual ULONG				Release()
+		{
+			int32_t refCount = --m_refCount;
+			if (refCount == 0)
+				delete this;
+			return refCount;
+		}
+
+	private:
+		const uint8_t*				m_samples;
+		uint32_t					m_size;
+		int64_t						m_streamTime;		// In sample frames
+		int64_t						m_sampleRate;
+		std::atomic<int32_t>		m_refCount;
+	};
+}
+
+// ReplayEncoderInput
+
+ReplayEncoderInput::ReplayEncoderInput(const std::string& path, int64_t frameDuration, int64_t timeScale, double speed, uint32_t loopCount) :
+	m_path(path),
+	m_frameDuration(frameDuration),
+	m_timeScale(timeScale),
+	m_speed(speed),
+	m_loopCount(loopCount),
+	m_displayMode(bmdModeUnknown),
+	m_width(0),
+	m_height(0),
+	m_frameCount(0),
+	m_videoEnabled(false),
+	m_audioEnabled(false),
+	m_audioSampleRate(0),
+	m_audioFrameSize(0),
+	m_callback(NULL),
+	m_stopReplay(false),
+	m_replayEnded(false),
+	m_startTime(std::chrono::steady_clock::now()),
+	m_virtualTime(0),
+	m_frames(0),
+	m_packets(0),
+	m_bytes(0),
+	m_audioPackets(0),
+	m_lateFrames(0),
+	m_elapsedMicroseconds(0),
+	m_maxCallbackMicroseconds(0),
+	m_callbackTimeHistogram(kCallbackTimeBuckets),
+	m_refCount(1)
+{
+}
+
+ReplayEncoderInput::~ReplayEncoderInput()
+{
+	StopStreams();
+	SetCallback(NULL);
+}
+
+bool ReplayEncoderInput::init()
+{
+	FILE* file = fopen(m_path.c_str(), "rb");
+	if (!file)
+		return false;
+
+	uint8_t buffer[64 * 1024];
+	size_t	bytesRead;
+
+	while ((bytesRead = fread(buffer, 1, sizeof(buffer), file)) > 0)
+		m_stream.insert(m_stream.end(), buffer, buffer + bytesRead);
+	fclose(file);
+
+	if (m_frameDuration <= 0 || m_timeScale <= 0 || !splitNALUnits() || !orderPictures())
+		return false;
+
+	return true;
+}
+
+bool ReplayEncoderInput::splitNALUnits()
+{
+	const uint8_t*	data = m_stream.data();
+	size_t			size = m_stream.size();
+	size_t			offset = 0;
+
+	// Find each start code, a zero byte before one is part of a four byte start code
+	while (offset + 3 <= size)
+	{
+		if (data[offset] != 0 || data[offset + 1] != 0 || data[offset + 2] != 1)
+		{
+			offset++;
+			continue;
+		}
+
+		NALUnit nalUnit;
+		nalUnit.offset = (offset > 0 && data[offset - 1] == 0) ? offset - 1 : offset;
+		nalUnit.prefixSize = (uint32_t)(offset + 3 - nalUnit.offset);
+		nalUnit.size = 0;
+		nalUnit.type = (offset + 3 < size) ? (data[offset + 3] >> 1) & 0x3f : 0;
+
+		if (!m_nalUnits.empty())
+		{
+			NALUnit& previous = m_nalUnits.back();
+			previous.size = (uint32_t)(nalUnit.offset - previous.offset - previous.prefixSize);
+		}
+
+		m_nalUnits.push_back(nalUnit);
+		offset += 3;
+	}
+
+	if (m_nalUnits.empty())
+		return false;
+
+	NALUnit& last = m_nalUnits.back();
+	last.size = (uint32_t)(size - last.offset - last.prefixSize);
+
+	// Trailing zero bytes belong to no NAL unit
+	for (NALUnit& nalUnit : m_nalUnits)
+	{
+		while (nalUnit.size > 2 && data[nalUnit.offset + nalUnit.prefixSize + nalUnit.size - 1] == 0)
+			nalUnit.size--;
+	}
+
+	return true;
+}
+
+bool ReplayEncoderInput::orderPictures()
+{
+	const uint8_t*			data = m_stream.data();
+	HEVCSequenceInfo		sequenceInfo;
+	HEVCPictureInfo			pictureInfo;
+	HEVCPicOrderCounter		picOrderCounter;
+	bool					hasSequenceInfo = false;
+	bool					hasPictureInfo = false;
+	std::vector<int32_t>	picOrderCounts;
+	std::vector<bool>		startsSequence;
+	int64_t					pendingStart = -1;		// Non-VCL NAL units that go before the next picture
+
+	for (uint32_t i = 0; i < m_nalUnits.size(); i++)
+	{
+		const NALUnit&	nalUnit = m_nalUnits[i];
+		const uint8_t*	bytes = data + nalUnit.offset + nalUnit.prefixSize;
+
+		if (nalUnit.size < 2)
+			continue;
+
+		if (nalUnit.type >= kHEVCNALTypeVPS)
+		{
+			// The encoder uses a single SPS and PPS, so the most recent ones apply
+			if (nalUnit.type == kHEVCNALTypeSPS)
+				hasSequenceInfo = HEVCParseSPS(std::vector<uint8_t>(bytes, bytes + nalUnit.size), &sequenceInfo);
+			else if (nalUnit.type == kHEVCNALTypePPS)
+				hasPictureInfo = HEVCParsePPS(std::vector<uint8_t>(bytes, bytes + nalUnit.size), &pictureInfo);
+
+			bool followsPicture = (nalUnit.type == kHEVCNALTypeEndOfSequence || nalUnit.type == kHEVCNALTypeEndOfBitstream ||
+								   nalUnit.type == kHEVCNALTypeFillerData || nalUnit.type == kHEVCNALTypeSuffixSEI);
+			if (!followsPicture && pendingStart < 0)
+				pendingStart = i;
+			continue;
+		}
+
+		// Slices after the first of their picture only extend the picture
+		bool firstSliceInPicture = (nalUnit.size > 2) && (bytes[2] & 0x80);
+		if (!firstSliceInPicture)
+		{
+			pendingStart = -1;
+			continue;
+		}
+
+		uint32_t picOrderCountLsb = 0;
+		if (!hasSequenceInfo || !hasPictureInfo ||
+			!HEVCParsePicOrderCountLsb(bytes, nalUnit.size, sequenceInfo, pictureInfo, &picOrderCountLsb))
+		{
+			fprintf(stderr, "Unable to read the picture order count of the slice at offset %zu\n", nalUnit.offset);
+			return false;
+		}
+
+		bool	isIRAP = (nalUnit.type >= kHEVCNALTypeBLAWithLeadingPictures && nalUnit.type <= kHEVCNALTypeReservedIRAP23);
+		uint8_t	temporalId = (bytes[1] & 0x07) - 1;
+
+		Picture picture;
+		picture.firstNALUnit = (pendingStart >= 0) ? (uint32_t)pendingStart : i;
+		picture.nalUnitCount = 0;
+		picture.displayIndex = 0;
+		picture.deliveryIndex = 0;
+
+		if (!m_pictures.empty())
+			m_pictures.back().nalUnitCount = picture.firstNALUnit - m_pictures.back().firstNALUnit;
+		else
+			picture.firstNALUnit = 0;
+
+		picOrderCounts.push_back(picOrderCounter.addPicture(nalUnit.type, temporalId, picOrderCountLsb, sequenceInfo.log2MaxPicOrderCountLsb));
+		startsSequence.push_back(m_pictures.empty() || (isIRAP && nalUnit.type != kHEVCNALTypeCRA));
+		m_pictures.push_back(picture);
+		pendingStart = -1;
+
+		if (m_pictures.size() == 1)
+		{
+			char name[64];
+			snprintf(name, sizeof(name), "%ux%up %.2f (replay)", sequenceInfo.width, sequenceInfo.height, (double)m_timeScale / m_frameDuration);
+			m_displayModeName = name;
+			m_width = sequenceInfo.width;
+			m_height = sequenceInfo.height;
+
+			for (const DisplayModeInfo& info : kDisplayModes)
+			{
+				if (info.width == (long)sequenceInfo.width && info.height == (long)sequenceInfo.height &&
+					info.timeScale * m_frameDuration == info.frameDuration * m_timeScale)
+				{
+					m_displayMode = info.mode;
+					m_displayModeName = std::string(info.name) + " (replay)";
+				}
+			}
+		}
+	}
+
+	if (m_pictures.empty())
+		return false;
+
+	m_pictures.back().nalUnitCount = (uint32_t)m_nalUnits.size() - m_pictures.back().firstNALUnit;
+
+	// Each coded video sequence is displayed in picture order count order after the previous one
+	size_t sequenceStart = 0;
+	while (sequenceStart < m_pictures.size())
+	{
+		size_t sequenceEnd = sequenceStart + 1;
+		while (sequenceEnd < m_pictures.size() && !startsSequence[sequenceEnd])
+			sequenceEnd++;
+
+		std::vector<std::pair<int32_t, size_t> > displayOrder;
+		for (size_t i = sequenceStart; i < sequenceEnd; i++)
+			displayOrder.push_back(std::make_pair(picOrderCounts[i], i));
+		std::sort(displayOrder.begin(), displayOrder.end());
+
+		for (size_t i = 0; i < displayOrder.size(); i++)
+			m_pictures[displayOrder[i].second].displayIndex = (int64_t)(sequenceStart + i);
+
+		sequenceStart = sequenceEnd;
+	}
+
+	// A picture can't be delivered until the last frame displayed before it has been input
+	int64_t lastInputIndex = -1;
+	for (Picture& picture : m_pictures)
+	{
+		lastInputIndex = std::max(lastInputIndex, picture.displayIndex);
+		picture.deliveryIndex = lastInputIndex + 1 + kEncodeDelayFrames;
+	}
+
+	m_frameCount = (int64_t)m_pictures.size();
+	return true;
+}
+
+void ReplayEncoderInput::waitForEnd()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_condition.wait(lock, [this] { return m_replayEnded || m_stopReplay || !m_replayThread.joinable(); });
+}
+
+ReplayEncoderInput::Statistics ReplayEncoderInput::getStatistics() const
+{
+	Statistics statistics;
+
+	statistics.frames						= m_frames.load(std::memory_order_relaxed);
+	statistics.packets						= m_packets.load(std::memory_order_relaxed);
+	statistics.bytes						= m_bytes.load(std::memory_order_relaxed);
+	statistics.audioPackets					= m_audioPackets.load(std::memory_order_relaxed);
+	statistics.lateFrames					= m_lateFrames.load(std::memory_order_relaxed);
+	statistics.elapsedSeconds				= m_elapsedMicroseconds.load(std::memory_order_relaxed) / 1000000.0;
+	statistics.meanCallbackMicroseconds		= (statistics.frames > 0) ? m_callbackTimeHistogram.getSum() / m_callbackTimeHistogram.getCount() : 0.0;
+	statistics.maxCallbackMicroseconds		= (double)m_maxCallbackMicroseconds.load(std::memory_order_relaxed);
+
+	return statistics;
+}
+
+int64_t ReplayEncoderInput::getHardwareTime() const
+{
+	if (m_speed <= 0.0)
+		return m_virtualTime.load(std::memory_order_relaxed);
+
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - m_startTime;
+	return (int64_t)(elapsed.count() * m_speed * m_timeScale);
+}
+
+bool ReplayEncoderInput::waitUntil(int64_t hardwareTime)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	if (m_speed <= 0.0)
+	{
+		m_virtualTime.store(std::max(m_virtualTime.load(std::memory_order_relaxed), hardwareTime), std::memory_order_relaxed);
+		return !m_stopReplay;
+	}
+
+	auto deadline = m_startTime + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+		std::chrono::duration<double>((double)hardwareTime / m_timeScale / m_speed));
+
+	m_condition.wait_until(lock, deadline, [this] { return m_stopReplay; });
+	return !m_stopReplay;
+}
+
+void ReplayEncoderInput::replayThread()
+{
+	size_t	nextPicture = 0;
+	int64_t	loop = 0;
+	int64_t	audioPacketIndex = 0;
+
+	while (m_loopCount == 0 || loop < m_loopCount)
+	{
+		const Picture&	picture = m_pictures[nextPicture];
+		int64_t			loopOffset = loop * m_frameCount;
+		int64_t			videoTime = (picture.deliveryIndex + loopOffset) * m_frameDuration;
+		int64_t			audioTime = (audioPacketIndex + 1) * m_frameDuration;
+
+		// Each frame period of audio is delivered at the end of the period
+		if (m_audioEnabled && audioTime <= videoTime)
+		{
+			if (!waitUntil(audioTime))
+				break;
+
+			deliverAudio(audioPacketIndex++);
+			continue;
+		}
+
+		if (!waitUntil(videoTime))
+			break;
+
+		if (m_speed > 0.0 && getHardwareTime() - videoTime > m_frameDuration)
+			m_lateFrames.fetch_add(1, std::memory_order_relaxed);
+
+		deliverPicture(picture, loopOffset);
+
+		if (++nextPicture == m_pictures.size())
+		{
+			nextPicture = 0;
+			loop++;
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_replayEnded = true;
+	m_condition.notify_all();
+}
+
+void ReplayEncoderInput::deliverPicture(const Picture& picture, int64_t loopOffset)
+{
+	// Stream times and hardware timestamps are the frame's input time, in presentation order
+	int64_t	inputTime = (picture.displayIndex + loopOffset) * m_frameDuration;
+	auto	startTime = std::chrono::steady_clock::now();
+
+	for (uint32_t i = picture.firstNALUnit; i < picture.firstNALUnit + picture.nalUnitCount; i++)
+	{
+		const NALUnit&		nalUnit = m_nalUnits[i];
+		ReplayNALPacket*	packet = new ReplayNALPacket(m_stream.data() + nalUnit.offset, nalUnit.prefixSize, nalUnit.size, nalUnit.type,
+														 inputTime, inputTime, m_frameDuration, m_timeScale);
+
+		if (m_callback)
+			m_callback->VideoPacketArrived(packet);
+		packet->Release();
+
+		m_packets.fetch_add(1, std::memory_order_relaxed);
+		m_bytes.fetch_add(nalUnit.prefixSize + nalUnit.size, std::memory_order_relaxed);
+	}
+
+	auto	endTime = std::chrono::steady_clock::now();
+	int64_t	callbackMicroseconds = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime).count();
+
+	m_callbackTimeHistogram.observe((double)callbackMicroseconds);
+	if (callbackMicroseconds > m_maxCallbackMicroseconds.load(std::memory_order_relaxed))
+		m_maxCallbackMicroseconds.store(callbackMicroseconds, std::memory_order_relaxed);
+
+	m_frames.fetch_add(1, std::memory_order_relaxed);
+	m_elapsedMicroseconds.store(std::chrono::duration_cast<std::chrono::microseconds>(endTime - m_startTime).count(), std::memory_order_relaxed);
+}
+
+void ReplayEncoderInput::deliverAudio(int64_t audioPacketIndex)
+{
+	// Sample frames in each frame period, spread evenly for fractional frame rates
+	int64_t				samplesPerPeriod = (int64_t)m_audioSampleRate * m_frameDuration;
+	int64_t				streamTime = audioPacketIndex * samplesPerPeriod / m_timeScale;
+	int64_t				frameCount = (audioPacketIndex + 1) * samplesPerPeriod / m_timeScale - streamTime;
+	ReplayAudioPacket*	packet = new ReplayAudioPacket(m_silence.data(), (uint32_t)(frameCount * m_audioFrameSize), streamTime, m_audioSampleRate);
+
+	if (m_callback)
+		m_callback->AudioPacketArrived(packet);
+	packet->Release();
+
+	m_audioPackets.fetch_add(1, std::memory_order_relaxed);
+}
+
+HRESULT ReplayEncoderInput::DoesSupportVideoMode(BMDVideoConnection, BMDDisplayMode requestedMode, BMDPixelFormat requestedCodec, uint32_t, BMDSupportedVideoModeFlags, bool* supported)
+{
+	*supported = (requestedMode == m_displayMode) && (requestedCodec == bmdFormatH265);
+	return S_OK;
+}
+
+HRESULT ReplayEncoderInput::GetDisplayMode(BMDDisplayMode displayMode, IDeckLinkDisplayMode** resultDisplayMode)
+{
+	*resultDisplayMode = NULL;
+	if (m_pictures.empty() || displayMode != m_displayMode)
+		return E_INVALIDARG;
+
+	*resultDisplayMode = new ReplayDisplayMode(m_displayMode, m_displayModeName, m_width, m_height, m_frameDuration, m_timeScale);
+	return S_OK;
+}
+
+HRESULT ReplayEncoderInput::GetDisplayModeIterator(IDeckLinkDisplayModeIterator** iterator)
+{
+	IDeckLinkDisplayMode* displayMode = NULL;
+
+	if (GetDisplayMode(m_displayMode, &displayMode) != S_OK)
+		return E_FAIL;
+
+	*iterator = new ReplayDisplayModeIterator(displayMode);
+	return S_OK;
+}
+
+HRESULT ReplayEncoderInput::EnableVideoInput(BMDDisplayMode displayMode, BMDPixelFormat pixelFormat, BMDVideoInputFlags)
+{
+	if (m_pictures.empty() || displayMode != m_displayMode || pixelFormat != bmdFormatH265)
+		return E_INVALIDARG;
+
+	m_videoEnabled = true;
+	return S_OK;
+}
+
+HRESULT ReplayEncoderInput::DisableVideoInput()
+{
+	m_videoEnabled = false;
+	return S_OK;
+}
+
+HRESULT ReplayEncoderInput::GetAvailablePacketsCount(uint32_t* availablePacketsCount)
+{
+	*availablePacketsCount = 0;
+	return S_OK;
+}
+
+HRESULT ReplayEncoderInput::SetMemoryAllocator(IDeckLinkMemoryAllocator*)
+{
+	// Packets refer to the stream in memory
+	return E_NOTIMPL;
+}
+
+HRESULT ReplayEncoderInput::EnableAudioInput(BMDAudioFormat audioFormat, BMDAudioSampleRate sampleRate, BMDAudioSampleType sampleType, uint32_t channelCount)
+{
+	if (audioFormat != bmdAudioFormatPCM || channelCount == 0)
+		return E_INVALIDARG;
+
+	m_audioSampleRate	= sampleRate;
+	m_audioFrameSize	= channelCount * (uint32_t)sampleType / 8;
+	m_audioEnabled		= true;
+
+	// Enough silence for the longest frame period
+	m_silence.assign((((int64_t)sampleRate * m_frameDuration + m_timeScale - 1) / m_timeScale + 1) * m_audioFrameSize, 0);
+	return S_OK;
+}
+
+HRESULT ReplayEncoderInput::DisableAudioInput()
+{
+	m_audioEnabled = false;
+	return S_OK;
+}
+
+HRESULT ReplayEncoderInput::GetAvailableAudioSampleFrameCount(uint32_t* availableSampleFrameCount)
+{
+	*availableSampleFrameCount = 0;
+	return S_OK;
+}
+
+HRESULT ReplayEncoderInput::StartStreams()
+{
+	if (!m_videoEnabled || m_replayThread.joinable())
+		return E_ACCESSDENIED;
+
+	m_stopReplay	= false;
+	m_replayEnded	= false;
+	m_startTime		= std::chrono::steady_clock::now();
+	m_virtualTime	= 0;
+
+	m_replayThread = std::thread(&ReplayEncoderInput::replayThread, this);
+	return S_OK;
+}
+
+HRESULT ReplayEncoderInput::StopStreams()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopReplay = true;
+		m_condition.notify_all();
+	}
+
+	if (m_replayThread.joinable())
+		m_replayThread.join();
+
+	return S_OK;
+}
+
+HRESULT ReplayEncoderInput::PauseStreams()
+{
+	return E_NOTIMPL;
+}
+
+HRESULT ReplayEncoderInput::FlushStreams()
+{
+	return S_OK;
+}
+
+HRESULT ReplayEncoderInput::SetCallback(IDeckLinkEncoderInputCallback* theCallback)
+{
+	// Only called while the streams are stopped, as by DeckLinkDevice
+	if (m_replayThread.joinable())
+		return E_ACCESSDENIED;
+
+	if (theCallback)
+		theCallback->AddRef();
+	if (m_callback)
+		m_callback->Release();
+
+	m_callback = theCallback;
+	return S_OK;
+}
+
+HRESULT ReplayEncoderInput::GetHardwareReferenceClock(BMDTimeScale desiredTimeScale, BMDTimeValue* hardwareTime, BMDTimeValue* timeInFrame, BMDTimeValue* ticksPerFrame)
+{
+	*hardwareTime	= rescale(getHardwareTime(), m_timeScale, desiredTimeScale);
+	*ticksPerFrame	= rescale(m_frameDuration, m_timeScale, desiredTimeScale);
+	*timeInFrame	= (*ticksPerFrame > 0) ? *hardwareTime % *ticksPerFrame : 0;
+	return S_OK;
+}
+
+HRESULT ReplayEncoderInput::SetFlag(BMDDeckLinkEncoderConfigurationID, bool)
+{
+	return S_OK;
+}
+
+HRESULT ReplayEncoderInput::GetFlag(BMDDeckLinkEncoderConfigurationID, bool*)
+{
+	return E_NOTIMPL;
+}
+
+HRESULT ReplayEncoderInput::SetInt(BMDDeckLinkEncoderConfigurationID, int64_t)
+{
+	return S_OK;
+}
+
+HRESULT ReplayEncoderInput::GetInt(BMDDeckLinkEncoderConfigurationID, int64_t*)
+{
+	return E_NOTIMPL;
+}
+
+HRESULT ReplayEncoderInput::SetFloat(BMDDeckLinkEncoderConfigurationID, double)
+{
+	return S_OK;
+}
+
+HRESULT ReplayEncoderInput::GetFloat(BMDDeckLinkEncoderConfigurationID, double*)
+{
+	return E_NOTIMPL;
+}
+
+HRESULT ReplayEncoderInput::SetString(BMDDeckLinkEncoderConfigurationID, const char*)
+{
+	return S_OK;
+}
+
+HRESULT ReplayEncoderInput::GetString(BMDDeckLinkEncoderConfigurationID, const char**)
+{
+	return E_NOTIMPL;
+}
+
+HRESULT ReplayEncoderInput::GetBytes(BMDDeckLinkEncoderConfigurationID, void*, uint32_t*)
+{
+	return E_NOTIMPL;
+}
+
+HRESULT ReplayEncoderInput::QueryInterface(REFIID iid, LPVOID *ppv)
+{
+	*ppv = NULL;
+
+	if (isIID(iid, IID_IUnknown) || isIID(iid, IID_IDeckLinkEncoderInput))
+		*ppv = static_cast<IDeckLinkEncoderInput*>(this);
+	else if (isIID(iid, IID_IDeckLinkEncoderConfiguration))
+		*ppv = static_cast<IDeckLinkEncoderConfiguration*>(this);
+	else
+		return E_NOINTERFACE;
+
+	AddRef();
+	return S_OK;
+}
+
+ULONG ReplayEncoderInput::AddRef()
+{
+	return ++m_refCount;
+}
+
+ULONG ReplayEncoderInput::Release()
+{
+	int32_t refCount = --m_refCount;
+	if (refCount == 0)
+		delete this;
+	return refCount;
+}
+
+// ReplayDeckLink
+
+ReplayDeckLink::ReplayDeckLink(ReplayEncoderInput* encoderInput) :
+	m_encoderInput(encoderInput),
+	m_refCount(1)
+{
+	m_encoderInput->AddRef();
+}
+
+ReplayDeckLink::~ReplayDeckLink()
+{
+	m_encoderInput->Release();
+}
+
+HRESULT ReplayDeckLink::GetModelName(const char** modelName)
+{
+	*modelName = strdup("H.265 Replay");
+	return S_OK;
+}
+
+HRESULT ReplayDeckLink::GetDisplayName(const char** displayName)
+{
+	*displayName = strdup("H.265 Replay");
+	return S_OK;
+}
+
+HRESULT ReplayDeckLink::QueryInterface(REFIID iid, LPVOID *ppv)
+{
+	*ppv = NULL;
+
+	if (isIID(iid, IID_IUnknown) || isIID(iid, IID_IDeckLink))
+	{
+		*ppv = this;
+		AddRef();
+		return S_OK;
+	}
+
+	return m_encoderInput->QueryInterface(iid, ppv);
+}
+
+ULONG ReplayDeckLink::AddRef()
+{
+	return ++m_refCount;
+}
+
+ULONG ReplayDeckLink::Release()
+{
+	int32_t refCount = --m_refCount;
+	if (refCount == 0)
+		delete this;
+	return refCount;
+}
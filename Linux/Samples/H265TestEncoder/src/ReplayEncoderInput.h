@@ -0,0 +1,211 @@
+/* -LICENSE-START-
+ ** Copyright (c) 2016 Blackmagic Design
+ **  
+ ** Permission is hereby granted, free of charge, to any person or organization 
+ ** obtaining a copy of the software and accompanying documentation (the 
+ ** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+ ** and transmit the Software, and to prepare derivative works of the Software, 
+ ** and to permit third-parties to whom the Software is furnished to do so, in 
+ ** accordance with:
+ ** 
+ ** (1) if the Software is obtained from Blackmagic Design, the End User License 
+ ** Agreement for the Software Development Kit (“EULA”) available at 
+ ** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+ ** 
+ ** (2) if the Software is obtained from any third party, such licensing terms 
+ ** as notified by that third party,
+ ** 
+ ** and all subject to the following:
+ ** 
+ ** (3) the copyright notices in the Software and this entire statement, 
+ ** including the above license grant, this restriction and the following 
+ ** disclaimer, must be included in all copies of the Software, in whole or in 
+ ** part, and all derivative works of the Software, unless such copies or 
+ ** derivative works are solely in the form of machine-executable object code 
+ ** generated by a source language processor.
+ ** 
+ ** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ ** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ ** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+ ** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+ ** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+ ** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ ** DEALINGS IN THE SOFTWARE.
+ ** 
+ ** A copy of the Software is available free of charge at 
+ ** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+ ** 
+ ** -LICENSE-END-
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "DeckLinkAPI.h"
+#include "MetricsRegistry.h"
+
+// Stands in for a hardware encoder by replaying a recorded Annex-B HEVC stream.  Each NAL unit is delivered to the
+// IDeckLinkEncoderInputCallback as an IDeckLinkH265NALPacket with the timing of the encoder: frames are input at the
+// frame rate and delivered in decode order once every frame they display after has been input, with stream times
+// and hardware reference timestamps in presentation order.  PCM silence is delivered if audio input is enabled.
+// A speed of 1 is real time, 0 delivers packets as fast as the callback returns them.
+class ReplayEncoderInput : public IDeckLinkEncoderInput, public IDeckLinkEncoderConfiguration
+{
+public:
+	struct Statistics
+	{
+		uint64_t					frames;
+		uint64_t					packets;
+		uint64_t					bytes;
+		uint64_t					audioPackets;
+		uint64_t					lateFrames;				// Delivered more than a frame after their time
+		double						elapsedSeconds;			// From StartStreams to the last packet
+		double						meanCallbackMicroseconds;	// Per frame, all of its packets
+		double						maxCallbackMicroseconds;
+	};
+
+	// loopCount of 0 repeats the stream until StopStreams
+	ReplayEncoderInput(const std::string& path, int64_t frameDuration, int64_t timeScale, double speed, uint32_t loopCount);
+	virtual ~ReplayEncoderInput();
+
+	// Reads the stream and works out the presentation order of its pictures
+	bool						init();
+
+	BMDDisplayMode				getDisplayMode() const { return m_displayMode; }
+	const std::string&			getDisplayModeName() const { return m_displayModeName; }
+
+	// Returns when every loop has been delivered, or the streams are stopped
+	void						waitForEnd();
+	Statistics					getStatistics() const;
+	// Time spent in the callback for each frame, in microseconds
+	const MetricHistogram&		getCallbackTimeHistogram() const { return m_callbackTimeHistogram; }
+
+	// IDeckLinkEncoderInput interface
+	virtual HRESULT				DoesSupportVideoMode(BMDVideoConnection connection, BMDDisplayMode requestedMode, BMDPixelFormat requestedCodec, uint32_t requestedCodecProfile, BMDSupportedVideoModeFlags flags, bool* supported);
+	virtual HRESULT				GetDisplayMode(BMDDisplayMode displayMode, IDeckLinkDisplayMode** resultDisplayMode);
+	virtual HRESULT				GetDisplayModeIterator(IDeckLinkDisplayModeIterator** iterator);
+	virtual HRESULT				EnableVideoInput(BMDDisplayMode displayMode, BMDPixelFormat pixelFormat, BMDVideoInputFlags flags);
+	virtual HRESULT				DisableVideoInput();
+	virtual HRESULT				GetAvailablePacketsCount(uint32_t* availablePacketsCount);
+	virtual HRESULT				SetMemoryAllocator(IDeckLinkMemoryAllocator* theAllocator);
+	virtual HRESULT				EnableAudioInput(BMDAudioFormat audioFormat, BMDAudioSampleRate sampleRate, BMDAudioSampleType sampleType, uint32_t channelCount);
+	virtual HRESULT				DisableAudioInput();
+	virtual HRESULT				GetAvailableAudioSampleFrameCount(uint32_t* availableSampleFrameCount);
+	virtual HRESULT				StartStreams();
+	virtual HRESULT				StopStreams();
+	virtual HRESULT				PauseStreams();
+	virtual HRESULT				FlushStreams();
+	virtual HRESULT				SetCallback(IDeckLinkEncoderInputCallback* theCallback);
+	virtual HRESULT				GetHardwareReferenceClock(BMDTimeScale desiredTimeScale, BMDTimeValue* hardwareTime, BMDTimeValue* timeInFrame, BMDTimeValue* ticksPerFrame);
+
+	// IDeckLinkEncoderConfiguration interface, settings are accepted and ignored and can't be read back
+	virtual HRESULT				SetFlag(BMDDeckLinkEncoderConfigurationID cfgID, bool value);
+	virtual HRESULT				GetFlag(BMDDeckLinkEncoderConfigurationID cfgID, bool* value);
+	virtual HRESULT				SetInt(BMDDeckLinkEncoderConfigurationID cfgID, int64_t value);
+	virtual HRESULT				GetInt(BMDDeckLinkEncoderConfigurationID cfgID, int64_t* value);
+	virtual HRESULT				SetFloat(BMDDeckLinkEncoderConfigurationID cfgID, double value);
+	virtual HRESULT				GetFloat(BMDDeckLinkEncoderConfigurationID cfgID, double* value);
+	virtual HRESULT				SetString(BMDDeckLinkEncoderConfigurationID cfgID, const char* value);
+	virtual HRESULT				GetString(BMDDeckLinkEncoderConfigurationID cfgID, const char** value);
+	virtual HRESULT				GetBytes(BMDDeckLinkEncoderConfigurationID cfgID, void* buffer, uint32_t* bufferSize);
+
+	// IUnknown interface
+	virtual HRESULT				QueryInterface(REFIID iid, LPVOID *ppv);
+	virtual ULONG				AddRef();
+	virtual ULONG				Release();
+
+private:
+	struct NALUnit
+	{
+		size_t					offset;					// Of the start code
+		uint32_t				prefixSize;
+		uint32_t				size;					// Without the start code
+		uint8_t					type;
+	};
+
+	struct Picture
+	{
+		uint32_t				firstNALUnit;			// Including any parameter sets, SEI and AUD before the first slice
+		uint32_t				nalUnitCount;
+		int64_t					displayIndex;			// Frames from the start of the stream, in presentation order
+		int64_t					deliveryIndex;			// Frame period in which the encoder delivers the picture
+	};
+
+	bool						splitNALUnits();
+	bool						orderPictures();
+	void						replayThread();
+	void						deliverPicture(const Picture& picture, int64_t loopOffset);
+	void						deliverAudio(int64_t audioPacketIndex);
+	bool						waitUntil(int64_t hardwareTime);
+	int64_t						getHardwareTime() const;
+
+	std::string					m_path;
+	int64_t						m_frameDuration;
+	int64_t						m_timeScale;
+	double						m_speed;
+	uint32_t					m_loopCount;
+	BMDDisplayMode				m_displayMode;
+	std::string					m_displayModeName;
+	long						m_width;
+	long						m_height;
+
+	std::vector<uint8_t>		m_stream;
+	std::vector<NALUnit>		m_nalUnits;
+	std::vector<Picture>		m_pictures;
+	int64_t						m_frameCount;			// Display frames in one loop
+
+	bool						m_videoEnabled;
+	bool						m_audioEnabled;
+	uint32_t					m_audioSampleRate;
+	uint32_t					m_audioFrameSize;
+	std::vector<uint8_t>		m_silence;
+
+	IDeckLinkEncoderInputCallback*	m_callback;
+	std::thread					m_replayThread;
+	std::mutex					m_mutex;
+	std::condition_variable		m_condition;
+	bool						m_stopReplay;
+	bool						m_replayEnded;
+	std::chrono::steady_clock::time_point	m_startTime;
+	std::atomic<int64_t>		m_virtualTime;			// Hardware time when replaying as fast as possible
+
+	std::atomic<uint64_t>		m_frames;
+	std::atomic<uint64_t>		m_packets;
+	std::atomic<uint64_t>		m_bytes;
+	std::atomic<uint64_t>		m_audioPackets;
+	std::atomic<uint64_t>		m_lateFrames;
+	std::atomic<int64_t>		m_elapsedMicroseconds;
+	std::atomic<int64_t>		m_maxCallbackMicroseconds;
+	MetricHistogram				m_callbackTimeHistogram;
+
+	std::atomic<int32_t>		m_refCount;
+};
+
+// An IDeckLink for ReplayEncoderInput, so the replay can be used in place of a discovered device
+class ReplayDeckLink : public IDeckLink
+{
+public:
+	ReplayDeckLink(ReplayEncoderInput* encoderInput);
+	virtual ~ReplayDeckLink();
+
+	// IDeckLink interface, names are allocated as by the driver and freed by the caller
+	virtual HRESULT				GetModelName(const char** modelName);
+	virtual HRESULT				GetDisplayName(const char** displayName);
+
+	// IUnknown interface
+	virtual HRESULT				QueryInterface(REFIID iid, LPVOID *ppv);
+	virtual ULONG				AddRef();
+	virtual ULONG				Release();
+
+private:
+	ReplayEncoderInput*			m_encoderInput;
+	std::atomic<int32_t>		m_refCount;
+};
@@ -39,52 +39,129 @@
  */
 
 #include "VideoWriter.h"
-#include <fcntl.h>
+#include <cstdio>
+#include <QDir>
 
-VideoWriter::VideoWriter(const QString& filename)
+// Enough queued audio to cover the video callback thread stalling for a few seconds
+static const uint32_t kAudioQueueSlots			= 64;
+static const uint32_t kAudioQueueSlotsPerSecond	= 10;
+
+// The playlist only has a line or two per segment
+static const size_t kPlaylistBlockSize			= 64 * 1024;
+static const size_t kPlaylistBlockCount			= 4;
+
+VideoWriter::VideoWriter(const QString& filename, int64_t frameDuration, int64_t timeScale,
+						 uint32_t audioSampleRate, uint32_t audioChannelCount, uint32_t audioBitsPerSample, uint32_t segmentDuration)
 :
-	m_filename(filename)
+	m_filename(filename),
+	m_frameDuration(frameDuration),
+	m_timeScale(timeScale),
+	m_audioSampleRate(audioSampleRate),
+	m_audioChannelCount(audioChannelCount),
+	m_audioBitsPerSample(audioBitsPerSample),
+	m_audioFrameSize(audioChannelCount * audioBitsPerSample / 8),
+	m_audioQueue(kAudioQueueSlots, audioSampleRate / kAudioQueueSlotsPerSecond, m_audioFrameSize),
+	m_segmentDuration(segmentDuration),
+	m_playlistWriter(kPlaylistBlockSize, kPlaylistBlockCount),
+	m_muxer(NULL)
 {
 }
 
 VideoWriter::~VideoWriter()
 {	
+	delete m_muxer;
 }
 
-bool VideoWriter::writeVideo(uint8_t* buffer, uint32_t length)
+bool VideoWriter::writeVideo(uint8_t nalType, const uint8_t* nalUnit, uint32_t size, int64_t streamTime)
 {
-	fwrite(buffer, 1, length, m_file);
+	if (!m_muxer)
+		return false;
+
+	// Audio and video reach the muxer on this thread, so it needs no locking
+	drainAudio();
+
+	m_muxer->addVideoNAL(nalType, nalUnit, size, streamTime);
 	return true;
 }
 
-bool VideoWriter::writeAudio(uint64_t)
+bool VideoWriter::writeAudio(const void* samples, uint32_t size, int64_t streamTime)
 {
-	return true;
+	if (!m_muxer)
+		return false;
+
+	return m_audioQueue.push(samples, size / m_audioFrameSize, streamTime);
+}
+
+void VideoWriter::drainAudio()
+{
+	if (!m_muxer->hasStarted())
+	{
+		// Until the first video frame only the most recent audio can be used, keep room for more to arrive
+		while (m_audioQueue.size() > m_audioQueue.capacity() / 2)
+			m_audioQueue.pop();
+		return;
+	}
+
+	while (const AudioPacketQueue::Packet* packet = m_audioQueue.front())
+	{
+		m_muxer->addAudio(packet->samples.data(), packet->frameCount, packet->streamTime);
+		m_audioQueue.pop();
+	}
 }
 
 bool VideoWriter::addVideoStream()
 {
+	m_muxer = new MP4Muxer(&m_fileWriter, m_frameDuration, m_timeScale);
+	if (m_segmentDuration > 0)
+		m_muxer->setSegments(m_filename.toStdString(), m_segmentDuration, &m_playlistWriter);
 	return true;
 }
 
 bool VideoWriter::addAudioStream()
 {
+	m_muxer->addAudioTrack(m_audioSampleRate, m_audioChannelCount, m_audioBitsPerSample);
 	return true;
 }
 
 bool VideoWriter::open()
 {
-	m_file = fopen(m_filename.toStdString().c_str(), "wb");
-	if (!m_file)
+	if (m_segmentDuration > 0)
+	{
+		QDir directory(m_filename);
+		if (!directory.mkpath("."))
+			return false;
+
+		if (!m_fileWriter.open(directory.filePath(MP4Muxer::kInitSegmentName).toStdString().c_str()) ||
+			!m_playlistWriter.open(directory.filePath(MP4Muxer::kPlaylistName).toStdString().c_str()))
+			return false;
+	}
+	else if (!m_fileWriter.open(m_filename.toStdString().c_str()))
+	{
 		return false;
+	}
 	
-	return true;
+	return addVideoStream() && addAudioStream();
 }
 
 void VideoWriter::close(bool deleteFile)
 {
-	fclose(m_file);
+	if (m_muxer)
+	{
+		// The streams have stopped, so no more audio will be queued
+		drainAudio();
+		m_muxer->finish();
+		delete m_muxer;
+		m_muxer = NULL;
+	}
+
+	m_fileWriter.close();
+	m_playlistWriter.close();
+
 	if (deleteFile)
-		remove(m_filename.toStdString().c_str());
-	m_file = 0;
+	{
+		if (m_segmentDuration > 0)
+			QDir(m_filename).removeRecursively();
+		else
+			remove(m_filename.toStdString().c_str());
+	}
 }
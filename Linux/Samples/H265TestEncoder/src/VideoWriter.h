@@ -41,27 +41,49 @@
 #pragma once
 
 #include <stdint.h>
-#include <cstdio>
 #include <QString>
 
+#include "AsyncFileWriter.h"
+#include "AudioPacketQueue.h"
+#include "MP4Muxer.h"
+
 class VideoWriter
 {
 public:
-	VideoWriter(const QString& filename);
+	// With a segment duration, filename is a directory for the segments and their playlist
+	VideoWriter(const QString& filename, int64_t frameDuration, int64_t timeScale,
+				uint32_t audioSampleRate, uint32_t audioChannelCount, uint32_t audioBitsPerSample, uint32_t segmentDuration = 0);
 	~VideoWriter();
 
 	bool					open();
 	void					close(bool deleteFile = false);
 
-	bool					writeVideo(uint8_t* buffer, uint32_t length);
-	bool					writeAudio(uint64_t seq);
+	// Called on the encoder callback thread, never waits for the disk
+	bool					writeVideo(uint8_t nalType, const uint8_t* nalUnit, uint32_t size, int64_t streamTime);
+	// Called on the encoder callback thread, queues the audio for the next writeVideo()
+	bool					writeAudio(const void* samples, uint32_t size, int64_t streamTime);
+
+	// Read while the encoder callback is not writing, eg after its packets have been delivered and before close()
+	AsyncFileWriter::Statistics	getFileWriterStatistics() { return m_fileWriter.getStatistics(); }
+	MP4Muxer::Statistics	getMuxerStatistics() const { return m_muxer ? m_muxer->getStatistics() : MP4Muxer::Statistics(); }
 
 private:
 
 	bool					addVideoStream();
 	bool					addAudioStream();
+	void					drainAudio();
 
 	QString					m_filename;
-	FILE*					m_file;
+	int64_t					m_frameDuration;
+	int64_t					m_timeScale;
+	uint32_t				m_audioSampleRate;
+	uint32_t				m_audioChannelCount;
+	uint32_t				m_audioBitsPerSample;
+	uint32_t				m_audioFrameSize;
+	AudioPacketQueue		m_audioQueue;
+	uint32_t				m_segmentDuration;
+	AsyncFileWriter			m_playlistWriter;
+	AsyncFileWriter			m_fileWriter;
+	MP4Muxer*				m_muxer;
 };
 
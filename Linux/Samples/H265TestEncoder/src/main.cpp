@@ -39,19 +39,83 @@
  */
 #include "MainWindow.h"
 #include "ControllerImp.h"
+#include "MP4SyncCheck.h"
+#include "ReplayBenchmark.h"
+#include "ReplayEncoderInput.h"
 
 #include <QApplication>
+#include <QCoreApplication>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+static const double kDefaultSyncToleranceMs = 20.0;
+
+// Frame rate as "timeScale/frameDuration", eg "24000/1001", or a whole number of frames per second
+static bool parseFrameRate(const char* rate, int64_t* frameDuration, int64_t* timeScale)
+{
+	char* end;
+
+	*timeScale = strtoll(rate, &end, 10);
+	*frameDuration = 1;
+	if (*end == '/')
+		*frameDuration = strtoll(end + 1, &end, 10);
+
+	return (*end == '\0') && (*timeScale > 0) && (*frameDuration > 0);
+}
 
 int	main(int argc, char** argv)
 {
+	// H265TestEncoder --check-av-sync <recording.mp4> [tolerance ms] checks a recording without opening a window
+	if (argc >= 3 && strcmp(argv[1], "--check-av-sync") == 0)
+	{
+		double toleranceMs = (argc >= 4) ? atof(argv[3]) : kDefaultSyncToleranceMs;
+		return CheckAudioVideoSync(argv[2], toleranceMs) ? 0 : 1;
+	}
+
+	// H265TestEncoder --replay-benchmark <stream.h265> [rate] [speed] [loops] records a replayed stream without a window
+	if (argc >= 3 && strcmp(argv[1], "--replay-benchmark") == 0)
+	{
+		int64_t frameDuration, timeScale;
+		if (!parseFrameRate((argc >= 4) ? argv[3] : "30000/1001", &frameDuration, &timeScale))
+		{
+			fprintf(stderr, "Invalid frame rate %s\n", argv[3]);
+			return 1;
+		}
+
+		QCoreApplication app(argc, argv);
+		double speed = (argc >= 5) ? atof(argv[4]) : 1.0;
+		uint32_t loopCount = (argc >= 6) ? (uint32_t)atoi(argv[5]) : 1;
+		return RunReplayBenchmark(argv[2], frameDuration, timeScale, speed, loopCount) ? 0 : 1;
+	}
+
 	QApplication app(argc, argv);
 
 	qRegisterMetaType<uint32_t>("uint32_t");
+	qRegisterMetaType<EncoderTelemetry::Summary>("EncoderTelemetry::Summary");
 
 	MainWindow mainWindow;
 
 	ControllerImp* controller = new ControllerImp();
 
+	// H265TestEncoder --replay <stream.h265> [rate] offers the replayed stream as the first device, looping until stopped
+	if (argc >= 3 && strcmp(argv[1], "--replay") == 0)
+	{
+		int64_t frameDuration, timeScale;
+		ReplayEncoderInput* encoderInput = NULL;
+
+		if (parseFrameRate((argc >= 4) ? argv[3] : "30000/1001", &frameDuration, &timeScale))
+			encoderInput = new ReplayEncoderInput(argv[2], frameDuration, timeScale, 1.0, 0);
+
+		if (encoderInput && encoderInput->init())
+			controller->addDevice(new ReplayDeckLink(encoderInput));
+		else
+			fprintf(stderr, "Unable to replay %s\n", argv[2]);
+
+		if (encoderInput)
+			encoderInput->Release();
+	}
+
 	controller->init(&mainWindow);
 	mainWindow.init(controller);
 
@@ -0,0 +1,274 @@
+/* -LICENSE-START-
+** Copyright (c) 2022 Blackmagic Design
+**  
+** Permission is hereby granted, free of charge, to any person or organization 
+** obtaining a copy of the software and accompanying documentation (the 
+** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+** and transmit the Software, and to prepare derivative works of the Software, 
+** and to permit third-parties to whom the Software is furnished to do so, in 
+** accordance with:
+** 
+** (1) if the Software is obtained from Blackmagic Design, the End User License 
+** Agreement for the Software Development Kit (“EULA”) available at 
+** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+** 
+** (2) if the Software is obtained from any third party, such licensing terms 
+** as notified by that third party,
+** 
+** and all subject to the following:
+** 
+** (3) the copyright notices in the Software and this entire statement, 
+** including the above license grant, this restriction and the following 
+** disclaimer, must be included in all copies of the Software, in whole or in 
+** part, and all derivative works of the Software, unless such copies or 
+** derivative works are solely in the form of machine-executable object code 
+** generated by a source language processor.
+** 
+** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+** DEALINGS IN THE SOFTWARE.
+** 
+** A copy of the Software is available free of charge at 
+** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+** 
+** -LICENSE-END-
+*/
+
+#include <inttypes.h>
+#include "AsyncLogger.h"
+
+static const int64_t kNanoSecondsPerSecond = 1000000000;
+
+// LogRateLimiter
+
+LogRateLimiter::LogRateLimiter(uint32_t maxEventsPerSecond) :
+	m_maxEventsPerSecond(maxEventsPerSecond),
+	m_windowStart(0),
+	m_eventCount(0)
+{
+}
+
+bool LogRateLimiter::allow(int64_t timestampNs)
+{
+	int64_t windowStart = m_windowStart.load(std::memory_order_relaxed);
+
+	if (timestampNs - windowStart >= kNanoSecondsPerSecond)
+	{
+		// Start a new one second window, only one caller wins the exchange and resets the count
+		if (m_windowStart.compare_exchange_strong(windowStart, timestampNs, std::memory_order_relaxed))
+			m_eventCount.store(0, std::memory_order_relaxed);
+	}
+
+	return m_eventCount.fetch_add(1, std::memory_order_relaxed) < m_maxEventsPerSecond;
+}
+
+// AsyncLogger::RingPool
+
+AsyncLogger::RingPool::RingPool(size_t ringCount, uint64_t ringCapacity) :
+	rings(new LogRing[ringCount]),
+	ringCount(ringCount),
+	ringsUsed(0)
+{
+	// Preallocate all producer rings so that a thread logging for the first time does not allocate
+	for (size_t i = 0; i < ringCount; i++)
+	{
+		rings[i].events.reset(new LogEvent[ringCapacity]);
+		rings[i].mask = ringCapacity - 1;
+		rings[i].claimed = false;
+		rings[i].writeIndex = 0;
+		rings[i].readIndex = 0;
+	}
+}
+
+AsyncLogger::LogRing* AsyncLogger::RingPool::claim()
+{
+	for (size_t i = 0; i < ringCount; i++)
+	{
+		bool claimed = false;
+
+		// Acquire pairs with the release in release(), so the write index left by the previous owner is visible
+		if (!rings[i].claimed.compare_exchange_strong(claimed, true, std::memory_order_acquire, std::memory_order_relaxed))
+			continue;
+
+		size_t used = ringsUsed.load(std::memory_order_relaxed);
+		while (used <= i && !ringsUsed.compare_exchange_weak(used, i + 1, std::memory_order_release, std::memory_order_relaxed))
+			;
+
+		return &rings[i];
+	}
+
+	return nullptr;
+}
+
+void AsyncLogger::RingPool::release(LogRing* ring)
+{
+	ring->claimed.store(false, std::memory_order_release);
+}
+
+// AsyncLogger
+
+AsyncLogger::AsyncLogger(FILE* output, size_t ringCapacity, size_t maxThreads) :
+	m_output(output),
+	m_ringCapacity(1),
+	m_droppedCount(0),
+	m_suppressedCount(0),
+	m_reportedDroppedCount(0),
+	m_timestampsEnabled(false),
+	m_stopWriter(false)
+{
+	while (m_ringCapacity < ringCapacity)
+		m_ringCapacity <<= 1;
+
+	m_ringPool = std::make_shared<RingPool>(maxThreads, m_ringCapacity);
+
+	m_writerThread = std::thread(&AsyncLogger::writerThread, this);
+}
+
+AsyncLogger::~AsyncLogger()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_writerMutex);
+		m_stopWriter = true;
+	}
+	m_writerCondition.notify_all();
+
+	if (m_writerThread.joinable())
+		m_writerThread.join();
+
+	// Format any events that were logged after the writer thread stopped
+	flush();
+}
+
+void AsyncLogger::flush()
+{
+	drainRings();
+	fflush(m_output);
+}
+
+AsyncLogger::LogRing* AsyncLogger::getThreadRing()
+{
+	// Returns the thread's ring to its pool when the thread exits
+	struct ThreadRing
+	{
+		~ThreadRing()
+		{
+			if (ring != nullptr)
+				pool->release(ring);
+		}
+
+		std::shared_ptr<RingPool>	pool;
+		LogRing*					ring = nullptr;
+	};
+	static thread_local ThreadRing threadRing;
+
+	if (threadRing.pool != m_ringPool)
+	{
+		// First event from this thread to this logger, give back any ring held from another logger
+		if (threadRing.ring != nullptr)
+			threadRing.pool->release(threadRing.ring);
+		threadRing.pool = m_ringPool;
+		threadRing.ring = nullptr;
+	}
+
+	// Claim a preallocated ring, retried on later events while every ring is held by a running thread
+	if (threadRing.ring == nullptr)
+		threadRing.ring = m_ringPool->claim();
+
+	return threadRing.ring;
+}
+
+AsyncLogger::LogEvent* AsyncLogger::beginEvent(LogRing* ring)
+{
+	if (ring == nullptr)
+	{
+		// All rings are held by other running threads
+		m_droppedCount.fetch_add(1, std::memory_order_relaxed);
+		return nullptr;
+	}
+
+	uint64_t writeIndex = ring->writeIndex.load(std::memory_order_relaxed);
+	if (writeIndex - ring->readIndex.load(std::memory_order_acquire) >= m_ringCapacity)
+	{
+		// Ring is full, drop the event rather than wait for the writer thread
+		m_droppedCount.fetch_add(1, std::memory_order_relaxed);
+		return nullptr;
+	}
+
+	return &ring->events[writeIndex & ring->mask];
+}
+
+void AsyncLogger::commitEvent(LogRing* ring)
+{
+	ring->writeIndex.store(ring->writeIndex.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+void AsyncLogger::drainRings()
+{
+	std::lock_guard<std::mutex> lock(m_drainMutex);
+
+	LogRing*	rings = m_ringPool->rings.get();
+	size_t		ringCount = m_ringPool->ringsUsed.load(std::memory_order_acquire);
+
+	while (true)
+	{
+		// Merge events from each ring in timestamp order
+		LogRing*	nextRing = nullptr;
+		int64_t		nextTimestamp = INT64_MAX;
+
+		for (size_t i = 0; i < ringCount; i++)
+		{
+			LogRing* ring = &rings[i];
+			uint64_t readIndex = ring->readIndex.load(std::memory_order_relaxed);
+
+			if (readIndex != ring->writeIndex.load(std::memory_order_acquire))
+			{
+				LogEvent* event = &ring->events[readIndex & ring->mask];
+				if (event->timestamp < nextTimestamp)
+				{
+					nextTimestamp = event->timestamp;
+					nextRing = ring;
+				}
+			}
+		}
+
+		if (nextRing == nullptr)
+			break;
+
+		uint64_t readIndex = nextRing->readIndex.load(std::memory_order_relaxed);
+		LogEvent* event = &nextRing->events[readIndex & nextRing->mask];
+
+		if (m_timestampsEnabled)
+			fprintf(m_output, "[%" PRId64 ".%06" PRId64 "] ", event->timestamp / kNanoSecondsPerSecond, (event->timestamp % kNanoSecondsPerSecond) / 1000);
+
+		event->formatFunction(m_output, event->format, event->arguments);
+
+		nextRing->readIndex.store(readIndex + 1, std::memory_order_release);
+	}
+
+	uint64_t droppedCount = m_droppedCount.load(std::memory_order_relaxed);
+	if (droppedCount != m_reportedDroppedCount)
+	{
+		fprintf(m_output, "[%" PRIu64 " log messages dropped]\n", droppedCount - m_reportedDroppedCount);
+		m_reportedDroppedCount = droppedCount;
+	}
+}
+
+void AsyncLogger::writerThread()
+{
+	std::chrono::milliseconds drainInterval(kDrainIntervalMs);
+
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_writerMutex);
+			if (m_writerCondition.wait_for(lock, drainInterval, [this] { return m_stopWriter; }))
+				break;
+		}
+
+		flush();
+	}
+}
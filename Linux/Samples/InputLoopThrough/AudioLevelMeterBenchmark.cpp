@@ -0,0 +1,132 @@
+/* -LICENSE-START-
+** Copyright (c) 2022 Blackmagic Design
+**  
+** Permission is hereby granted, free of charge, to any person or organization 
+** obtaining a copy of the software and accompanying documentation (the 
+** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+** and transmit the Software, and to prepare derivative works of the Software, 
+** and to permit third-parties to whom the Software is furnished to do so, in 
+** accordance with:
+** 
+** (1) if the Software is obtained from Blackmagic Design, the End User License 
+** Agreement for the Software Development Kit (“EULA”) available at 
+** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+** 
+** (2) if the Software is obtained from any third party, such licensing terms 
+** as notified by that third party,
+** 
+** and all subject to the following:
+** 
+** (3) the copyright notices in the Software and this entire statement, 
+** including the above license grant, this restriction and the following 
+** disclaimer, must be included in all copies of the Software, in whole or in 
+** part, and all derivative works of the Software, unless such copies or 
+** derivative works are solely in the form of machine-executable object code 
+** generated by a source language processor.
+** 
+** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+** DEALINGS IN THE SOFTWARE.
+** 
+** A copy of the Software is available free of charge at 
+** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+** 
+** -LICENSE-END-
+*/
+
+#include <chrono>
+#include <cmath>
+#include <stdio.h>
+#include <vector>
+
+#include "AudioLevelMeter.h"
+#include "AudioLevelMeterBenchmark.h"
+
+static const uint32_t	kSampleRate			= 48000;
+static const uint32_t	kPacketFrames		= kSampleRate / 60;
+static const double		kToneFrequency		= 997.0;
+static const double		kToneLevel			= -23.0;		// dBFS, stereo tone measures -23 LUFS (EBU Tech 3341 case 1)
+
+// Fill interleaved samples with a tone on every channel, quarter sample rate tones are sampled 45 degrees from their
+// peaks so the sample peak is 3 dB below the true-peak
+template<typename T>
+static void generateTone(std::vector<T>& samples, uint32_t channelCount, double frequency, double level, double phase)
+{
+	double amplitude = std::pow(10.0, level / 20.0) * (double)(1ull << (sizeof(T) * 8 - 1));
+
+	for (size_t frame = 0; frame < samples.size() / channelCount; frame++)
+	{
+		T sample = (T)std::lrint(amplitude * std::sin(2.0 * M_PI * frequency * frame / kSampleRate + phase));
+		for (uint32_t channel = 0; channel < channelCount; channel++)
+			samples[frame * channelCount + channel] = sample;
+	}
+}
+
+template<typename T>
+static bool measure(uint32_t channelCount, BMDAudioSampleType sampleType, unsigned seconds)
+{
+	AudioLevelMeter					meter;
+	std::vector<T>					samples(kSampleRate * channelCount);
+	std::vector<AudioChannelLevels>	channelLevels;
+	AudioLoudness					loudness;
+
+	if (!meter.configure(channelCount, sampleType))
+	{
+		fprintf(stderr, "Unable to configure meter for %u channels\n", channelCount);
+		return false;
+	}
+
+	// Quarter sample rate tone for the true-peak, then the loudness reference tone
+	generateTone(samples, channelCount, kSampleRate / 4.0, -6.0, M_PI / 4.0);
+	meter.processSamples(samples.data(), kSampleRate);
+	meter.getChannelLevels(channelLevels);
+
+	printf("  %2u channels %2u-bit  fs/4 tone at -6.0 dBTP: sample peak %6.2f dBFS, true-peak %6.2f dBTP\n",
+			channelCount, (unsigned)sizeof(T) * 8,
+			AudioLevelMeter::toDecibels(channelLevels[0].peak), AudioLevelMeter::toDecibels(channelLevels[0].truePeak));
+
+	generateTone(samples, channelCount, kToneFrequency, kToneLevel, 0.0);
+	meter.reset();
+
+	auto startTime = std::chrono::steady_clock::now();
+
+	for (unsigned second = 0; second < seconds; second++)
+	{
+		for (uint32_t frame = 0; frame < kSampleRate; frame += kPacketFrames)
+			meter.processSamples(samples.data() + frame * channelCount, kPacketFrames);
+	}
+
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+	double packetCount = (double)seconds * kSampleRate / kPacketFrames;
+
+	meter.getChannelLevels(channelLevels);
+	meter.getLoudness(loudness);
+
+	printf("  %2u channels %2u-bit  %5.1f Hz tone: RMS %6.2f dBFS, M %6.2f S %6.2f I %6.2f LUFS  %6.2f us/packet (%.3f%% of real time)\n",
+			channelCount, (unsigned)sizeof(T) * 8, kToneFrequency,
+			AudioLevelMeter::toDecibels(channelLevels[0].rms), loudness.momentary, loudness.shortTerm, loudness.integrated,
+			elapsed.count() * 1000000.0 / packetCount, elapsed.count() * 100.0 / seconds);
+
+	return true;
+}
+
+bool RunAudioLevelMeterBenchmark(unsigned seconds)
+{
+	const uint32_t	channelCounts[] = { 2, 16, 64 };
+	AudioLevelMeter	meter;
+
+	printf("Metering %u s of 48 kHz audio in %u frame packets using %s kernels\n", seconds, kPacketFrames, meter.getKernelName());
+
+	for (uint32_t channelCount : channelCounts)
+	{
+		if (!measure<int16_t>(channelCount, bmdAudioSampleType16bitInteger, seconds) ||
+			!measure<int32_t>(channelCount, bmdAudioSampleType32bitInteger, seconds))
+			return false;
+	}
+
+	return true;
+}
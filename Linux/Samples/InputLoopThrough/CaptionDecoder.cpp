@@ -0,0 +1,487 @@
+/* -LICENSE-START-
+** Copyright (c) 2022 Blackmagic Design
+**  
+** Permission is hereby granted, free of charge, to any person or organization 
+** obtaining a copy of the software and accompanying documentation (the 
+** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+** and transmit the Software, and to prepare derivative works of the Software, 
+** and to permit third-parties to whom the Software is furnished to do so, in 
+** accordance with:
+** 
+** (1) if the Software is obtained from Blackmagic Design, the End User License 
+** Agreement for the Software Development Kit (“EULA”) available at 
+** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+** 
+** (2) if the Software is obtained from any third party, such licensing terms 
+** as notified by that third party,
+** 
+** and all subject to the following:
+** 
+** (3) the copyright notices in the Software and this entire statement, 
+** including the above license grant, this restriction and the following 
+** disclaimer, must be included in all copies of the Software, in whole or in 
+** part, and all derivative works of the Software, unless such copies or 
+** derivative works are solely in the form of machine-executable object code 
+** generated by a source language processor.
+** 
+** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+** DEALINGS IN THE SOFTWARE.
+** 
+** A copy of the Software is available free of charge at 
+** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+** 
+** -LICENSE-END-
+*/
+
+#include <string.h>
+#include "CaptionDecoder.h"
+
+// SMPTE 334-2 section identifiers
+static const uint8_t	kCDPIdentifier0		= 0x96;
+static const uint8_t	kCDPIdentifier1		= 0x69;
+static const uint8_t	kTimeCodeSectionID	= 0x71;
+static const uint8_t	kCCDataSectionID	= 0x72;
+static const uint8_t	kSvcInfoSectionID	= 0x73;
+static const uint8_t	kFooterSectionID	= 0x74;
+static const uint8_t	kFutureSectionFirst	= 0x75;
+static const uint8_t	kFutureSectionLast	= 0xEF;
+
+static const size_t		kCDPHeaderLength	= 7;
+static const size_t		kCDPFooterLength	= 4;
+
+// SMPTE 334-2 Table 2 cdp_flags
+static const uint8_t	kCDPFlagCaptionServiceActive	= 1 << 1;
+
+// SMPTE 334-2 Table 3 CDP frame rate, 0 where forbidden or reserved
+static const double		kCDPFrameRates[16] =
+{
+	0.0, 24000.0 / 1001.0, 24.0, 25.0, 30000.0 / 1001.0, 30.0, 50.0, 60000.0 / 1001.0, 60.0
+};
+
+// CEA-708 4.4 cc_type
+enum
+{
+	kCCType608Field1 = 0,
+	kCCType608Field2,
+	kCCTypeDTVCCData,
+	kCCTypeDTVCCStart
+};
+
+static inline bool isCaptionText(uint8_t code)
+{
+	// G0 (including the music note at 0x7F) and G1
+	return (code >= 0x20 && code < 0x80) || code >= 0xA0;
+}
+
+// CEA-708 7.1 Code Space Organization, length of the code starting at p including its parameters,
+// or 0 if it is truncated by the end of the service block
+static size_t getCodeLength(const uint8_t* p, size_t remaining)
+{
+	// C1 command lengths, 0x80 to 0x9F
+	static const uint8_t kC1Lengths[32] =
+	{
+		1, 1, 1, 1, 1, 1, 1, 1,		// SetCurrentWindow0-7
+		2, 2, 2, 2, 2, 2, 1, 1,		// ClearWindows, DisplayWindows, HideWindows, ToggleWindows, DeleteWindows, Delay, DelayCancel, Reset
+		3, 4, 3, 1, 1, 1, 1, 5,		// SetPenAttributes, SetPenColor, SetPenLocation, reserved, SetWindowAttributes
+		7, 7, 7, 7, 7, 7, 7, 7		// DefineWindow0-7
+	};
+
+	uint8_t	code = p[0];
+	size_t	length;
+
+	if (code < 0x10)
+		length = 1;
+	else if (code == 0x10)
+	{
+		// EXT1 followed by a C2, G2, C3 or G3 code
+		if (remaining < 2)
+			return 0;
+
+		uint8_t extended = p[1];
+		if (extended < 0x20)
+			length = 2 + (extended >> 3);
+		else if (extended < 0x80 || extended >= 0xA0)
+			length = 2;
+		else if (extended < 0x88)
+			length = 6;
+		else if (extended < 0x90)
+			length = 7;
+		else
+		{
+			// Variable length C3 command, the length is in the low bits of the next byte
+			if (remaining < 3)
+				return 0;
+			length = 3 + (p[2] & 0x1F);
+		}
+	}
+	else if (code < 0x18)
+		length = 2;
+	else if (code < 0x20)
+		length = 3;
+	else if (code >= 0x80 && code < 0xA0)
+		length = kC1Lengths[code - 0x80];
+	else
+		length = 1;
+
+	return (length <= remaining) ? length : 0;
+}
+
+CaptionDecoder::CaptionDecoder() :
+	m_packetStart(0),
+	m_packetReceived(0),
+	m_packetSize(0),
+	m_lastDTVCCSequence(-1),
+	m_elementCount(0),
+	m_lastCDPSequence(-1),
+	m_captionServiceActive(false),
+	m_frameRate(0.0),
+	m_lastCaptionDataFrame(-1)
+{
+	memset(&m_statistics, 0, sizeof(m_statistics));
+}
+
+void CaptionDecoder::beginFrame()
+{
+	++m_statistics.frames;
+	m_elementCount = 0;
+	m_captionServiceActive = false;
+
+	// Keep the bytes of a DTVCC packet that continues in the next CDP, completed packets are no longer referenced
+	if (m_packetStart != 0 && m_packetReceived != 0)
+		memmove(m_packetBuffer, m_packetBuffer + m_packetStart, m_packetReceived);
+	m_packetStart = 0;
+}
+
+bool CaptionDecoder::decode(IDeckLinkVideoFrame* videoFrame)
+{
+	IDeckLinkVideoFrameAncillaryPackets*	ancillaryPackets = NULL;
+	IDeckLinkAncillaryPacket*				packet = NULL;
+	const void*								data = NULL;
+	uint32_t								size = 0;
+	bool									decoded = false;
+
+	beginFrame();
+
+	if ((videoFrame->QueryInterface(IID_IDeckLinkVideoFrameAncillaryPackets, (void**)&ancillaryPackets) == S_OK) &&
+		(ancillaryPackets->GetFirstPacketByID(kCaptionDID, kCaptionSDID, &packet) == S_OK) &&
+		(packet->GetBytes(bmdAncillaryPacketFormatUInt8, &data, &size) == S_OK))
+	{
+		// The user data words are read in place
+		decoded = decodeCDP((const uint8_t*)data, size);
+	}
+
+	if (packet)
+		packet->Release();
+
+	if (ancillaryPackets)
+		ancillaryPackets->Release();
+
+	return decoded;
+}
+
+bool CaptionDecoder::decode(const uint8_t* data, uint32_t size)
+{
+	beginFrame();
+	return decodeCDP(data, size);
+}
+
+bool CaptionDecoder::decodeCDP(const uint8_t* data, uint32_t size)
+{
+	const uint8_t*	ccDataSection = NULL;
+	uint8_t			checksum = 0;
+
+	// SMPTE 334-2 5.2 cdp_header
+	if (size < kCDPHeaderLength + kCDPFooterLength || data[0] != kCDPIdentifier0 || data[1] != kCDPIdentifier1)
+		goto invalid;
+
+	{
+		size_t			cdpLength	= data[2];
+		uint8_t			flags		= data[4];
+		uint16_t		sequence	= (data[5] << 8) | data[6];
+		double			frameRate	= kCDPFrameRates[data[3] >> 4];
+		const uint8_t*	footer		= data + cdpLength - kCDPFooterLength;
+		const uint8_t*	section		= data + kCDPHeaderLength;
+
+		if (cdpLength < kCDPHeaderLength + kCDPFooterLength || cdpLength > size || frameRate == 0.0)
+			goto invalid;
+
+		for (size_t i = 0; i < cdpLength; i++)
+			checksum += data[i];
+		if (checksum != 0)
+		{
+			++m_statistics.checksumErrors;
+			goto invalid;
+		}
+
+		// 5.4 cdp_footer repeats the sequence counter
+		if (footer[0] != kFooterSectionID || footer[1] != data[5] || footer[2] != data[6])
+			goto invalid;
+
+		// Sections are in a fixed order, but each is optional
+		while (section < footer)
+		{
+			size_t sectionLength;
+
+			if (footer - section < 2)
+				goto invalid;
+
+			switch (section[0])
+			{
+				case kTimeCodeSectionID:
+					sectionLength = 5;
+					break;
+
+				case kCCDataSectionID:
+					if ((section[1] & 0xE0) != 0xE0)
+						goto invalid;
+					sectionLength = 2 + 3 * (section[1] & 0x1F);
+					ccDataSection = section;
+					break;
+
+				case kSvcInfoSectionID:
+					sectionLength = 2 + 7 * (section[1] & 0x0F);
+					break;
+
+				default:
+					if (section[0] < kFutureSectionFirst || section[0] > kFutureSectionLast)
+						goto invalid;
+					sectionLength = 2 + section[1];
+					break;
+			}
+
+			if ((size_t)(footer - section) < sectionLength)
+				goto invalid;
+			section += sectionLength;
+		}
+
+		if (m_lastCDPSequence >= 0 && sequence != (uint16_t)(m_lastCDPSequence + 1))
+			++m_statistics.sequenceErrors;
+		m_lastCDPSequence = sequence;
+
+		m_captionServiceActive = (flags & kCDPFlagCaptionServiceActive) != 0;
+		m_frameRate = frameRate;
+		++m_statistics.cdps;
+	}
+
+	if (ccDataSection != NULL)
+		decodeCCData(ccDataSection);
+
+	return true;
+
+invalid:
+	++m_statistics.invalidCDPs;
+	return false;
+}
+
+void CaptionDecoder::decodeCCData(const uint8_t* section)
+{
+	const uint8_t*	triplet	= section + 2;
+	unsigned		ccCount	= section[1] & 0x1F;
+
+	for (unsigned i = 0; i < ccCount; i++, triplet += 3)
+	{
+		bool	valid	= (triplet[0] & 0x04) != 0;
+		uint8_t	type	= triplet[0] & 0x03;
+
+		if (!valid)
+			continue;
+
+		switch (type)
+		{
+			case kCCType608Field1:
+			case kCCType608Field2:
+				++m_statistics.cc608Pairs;
+				break;
+
+			case kCCTypeDTVCCStart:
+			{
+				if (m_packetSize != 0)
+				{
+					// The previous packet was cut short, drop it
+					++m_statistics.dtvccPacketErrors;
+					m_packetReceived = 0;
+				}
+
+				// CEA-708 5 packet header, the size code is in 2 byte units and 0 for 128 bytes
+				int		sequence	= triplet[1] >> 6;
+				uint8_t	sizeCode	= triplet[1] & 0x3F;
+
+				if (m_lastDTVCCSequence >= 0 && sequence != ((m_lastDTVCCSequence + 1) & 0x3))
+					++m_statistics.dtvccSequenceErrors;
+				m_lastDTVCCSequence = sequence;
+
+				m_packetSize = (sizeCode == 0) ? kMaximumDTVCCPacketSize : sizeCode * 2;
+				appendDTVCCBytes(triplet[1], triplet[2]);
+				break;
+			}
+
+			case kCCTypeDTVCCData:
+				if (m_packetSize != 0)
+					appendDTVCCBytes(triplet[1], triplet[2]);
+				break;
+		}
+	}
+}
+
+void CaptionDecoder::appendDTVCCBytes(uint8_t byte1, uint8_t byte2)
+{
+	uint8_t* packet = m_packetBuffer + m_packetStart;
+
+	if (m_packetStart + m_packetReceived + 2 > kPacketBufferSize)
+	{
+		++m_statistics.dtvccPacketErrors;
+		m_packetSize = 0;
+		m_packetReceived = 0;
+		return;
+	}
+
+	packet[m_packetReceived++] = byte1;
+	packet[m_packetReceived++] = byte2;
+
+	if (m_packetReceived < m_packetSize)
+		return;
+
+	decodeDTVCCPacket(packet, m_packetSize);
+
+	// The next packet follows this one, so that the elements of this one remain valid
+	m_packetStart += m_packetReceived;
+	m_packetReceived = 0;
+	m_packetSize = 0;
+}
+
+void CaptionDecoder::decodeDTVCCPacket(const uint8_t* packet, size_t size)
+{
+	const uint8_t*	block	= packet + 1;
+	const uint8_t*	end		= packet + size;
+
+	++m_statistics.dtvccPackets;
+
+	// CEA-708 6.2 service blocks
+	while (block < end)
+	{
+		uint8_t	serviceNumber	= block[0] >> 5;
+		size_t	blockSize		= block[0] & 0x1F;
+
+		// A null service block header ends the packet, the remaining bytes are padding
+		if (serviceNumber == 0)
+			break;
+
+		++block;
+		if (serviceNumber == 7)
+		{
+			// Extended service block header
+			if (block == end)
+				goto malformed;
+			serviceNumber = block[0] & 0x3F;
+			++block;
+		}
+
+		if ((size_t)(end - block) < blockSize)
+			goto malformed;
+
+		++m_statistics.serviceBlocks;
+		if (!decodeServiceBlock(serviceNumber, block, blockSize))
+			goto malformed;
+
+		block += blockSize;
+	}
+	return;
+
+malformed:
+	++m_statistics.dtvccPacketErrors;
+}
+
+bool CaptionDecoder::decodeServiceBlock(uint8_t serviceNumber, const uint8_t* block, size_t size)
+{
+	size_t i = 0;
+
+	if (size != 0)
+		m_lastCaptionDataFrame = m_statistics.frames;
+
+	while (i < size)
+	{
+		if (isCaptionText(block[i]))
+		{
+			size_t start = i;
+			while (i < size && isCaptionText(block[i]))
+				++i;
+
+			appendElement(CaptionElement::kText, serviceNumber, 0, block + start, i - start);
+			m_statistics.textBytes += i - start;
+			continue;
+		}
+
+		size_t length = getCodeLength(block + i, size - i);
+		if (length == 0)
+			return false;
+
+		// NUL is padding
+		if (block[i] != 0x00)
+		{
+			appendElement(CaptionElement::kCommand, serviceNumber, block[i], block + i, length);
+			++m_statistics.commands;
+		}
+		i += length;
+	}
+
+	return true;
+}
+
+void CaptionDecoder::appendElement(uint8_t type, uint8_t serviceNumber, uint8_t code, const uint8_t* bytes, size_t length)
+{
+	if (m_elementCount == kMaximumElements)
+		return;
+
+	CaptionElement& element = m_elements[m_elementCount++];
+	element.type			= type;
+	element.serviceNumber	= serviceNumber;
+	element.code			= code;
+	element.length			= (uint8_t)length;
+	element.bytes			= bytes;
+}
+
+int64_t CaptionDecoder::getFramesSinceCaptionData() const
+{
+	if (m_lastCaptionDataFrame < 0)
+		return -1;
+
+	return m_statistics.frames - m_lastCaptionDataFrame;
+}
+
+const char* CaptionDecoder::getCommandName(uint8_t code)
+{
+	if (code >= 0x80 && code <= 0x87)
+		return "SetCurrentWindow";
+	if (code >= 0x98 && code <= 0x9F)
+		return "DefineWindow";
+
+	switch (code)
+	{
+		case 0x03:	return "EndOfText";
+		case 0x08:	return "Backspace";
+		case 0x0C:	return "FormFeed";
+		case 0x0D:	return "CarriageReturn";
+		case 0x0E:	return "HorizontalCarriageReturn";
+		case 0x10:	return "Extended";
+		case 0x18:	return "P16";
+		case 0x88:	return "ClearWindows";
+		case 0x89:	return "DisplayWindows";
+		case 0x8A:	return "HideWindows";
+		case 0x8B:	return "ToggleWindows";
+		case 0x8C:	return "DeleteWindows";
+		case 0x8D:	return "Delay";
+		case 0x8E:	return "DelayCancel";
+		case 0x8F:	return "Reset";
+		case 0x90:	return "SetPenAttributes";
+		case 0x91:	return "SetPenColor";
+		case 0x92:	return "SetPenLocation";
+		case 0x97:	return "SetWindowAttributes";
+	}
+
+	return NULL;
+}
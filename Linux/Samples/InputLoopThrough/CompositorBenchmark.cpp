@@ -0,0 +1,137 @@
+/* -LICENSE-START-
+** Copyright (c) 2022 Blackmagic Design
+**  
+** Permission is hereby granted, free of charge, to any person or organization 
+** obtaining a copy of the software and accompanying documentation (the 
+** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+** and transmit the Software, and to prepare derivative works of the Software, 
+** and to permit third-parties to whom the Software is furnished to do so, in 
+** accordance with:
+** 
+** (1) if the Software is obtained from Blackmagic Design, the End User License 
+** Agreement for the Software Development Kit (“EULA”) available at 
+** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+** 
+** (2) if the Software is obtained from any third party, such licensing terms 
+** as notified by that third party,
+** 
+** and all subject to the following:
+** 
+** (3) the copyright notices in the Software and this entire statement, 
+** including the above license grant, this restriction and the following 
+** disclaimer, must be included in all copies of the Software, in whole or in 
+** part, and all derivative works of the Software, unless such copies or 
+** derivative works are solely in the form of machine-executable object code 
+** generated by a source language processor.
+** 
+** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+** DEALINGS IN THE SOFTWARE.
+** 
+** A copy of the Software is available free of charge at 
+** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+** 
+** -LICENSE-END-
+*/
+
+#include <chrono>
+#include <functional>
+#include <stdio.h>
+#include <thread>
+#include <vector>
+
+#include "CompositorBenchmark.h"
+#include "CompositorScene.h"
+#include "CpuCompositor.h"
+
+static const double		kTargetFrameRate	= 60.0;
+static const unsigned	kConcurrentFrames	= 3;		// Frames composited at once, one per InputLoopThrough video dispatch thread
+
+static double measureFrameRate(CpuCompositor& compositor, const CompositorScene& scene, std::vector<uint8_t>& frame,
+							   uint32_t width, uint32_t height, BMDPixelFormat pixelFormat, unsigned frameCount)
+{
+	uint32_t rowBytes = CpuCompositor::getRowBytes(width, pixelFormat);
+
+	// First frame allocates the compositor's working rows
+	compositor.composite(frame.data(), rowBytes, width, height, pixelFormat, scene.getLayers());
+
+	auto startTime = std::chrono::steady_clock::now();
+
+	for (unsigned i = 0; i < frameCount; i++)
+		compositor.composite(frame.data(), rowBytes, width, height, pixelFormat, scene.getLayers());
+
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+	return frameCount / elapsed.count();
+}
+
+static double measureConcurrentFrameRate(CpuCompositor& compositor, const CompositorScene& scene, const std::vector<uint8_t>& frame,
+										 uint32_t width, uint32_t height, BMDPixelFormat pixelFormat, unsigned frameCount)
+{
+	// Each thread composites its own copy of the frame, as the dispatch threads do with captured frames
+	std::vector<std::vector<uint8_t>>	frames(kConcurrentFrames, frame);
+	std::vector<std::thread>			threads;
+
+	auto startTime = std::chrono::steady_clock::now();
+
+	for (auto& threadFrame : frames)
+		threads.emplace_back(measureFrameRate, std::ref(compositor), std::cref(scene), std::ref(threadFrame), width, height, pixelFormat, frameCount);
+
+	for (auto& thread : threads)
+		thread.join();
+
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+	return (kConcurrentFrames * (frameCount + 1)) / elapsed.count();
+}
+
+bool RunCompositorBenchmark(uint32_t width, uint32_t height, unsigned frameCount, unsigned threadCount)
+{
+	const BMDPixelFormat	pixelFormats[] = { bmdFormat8BitYUV, bmdFormat10BitYUV, bmdFormat8BitBGRA };
+	const char*				pixelFormatNames[] = { "8-bit YUV", "10-bit YUV", "8-bit BGRA" };
+	CpuCompositor			singleThreadCompositor(1);
+	CpuCompositor			compositor(threadCount);
+	CompositorScene			scene;
+
+	printf("Compositing picture-in-picture, lower third and keyed logo layers over %u %ux%u frames using %s kernels\n",
+			frameCount, width, height, compositor.getKernelName());
+
+	for (size_t i = 0; i < sizeof(pixelFormats) / sizeof(pixelFormats[0]); i++)
+	{
+		BMDPixelFormat			pixelFormat = pixelFormats[i];
+		uint32_t				rowBytes = CpuCompositor::getRowBytes(width, pixelFormat);
+		std::vector<uint8_t>	frame(rowBytes * height);
+		std::vector<uint16_t>	greyRow(width * 4, 0);
+
+		if (!scene.configure(width, height, pixelFormat))
+		{
+			fprintf(stderr, "Unable to create layers for %ux%u frames\n", width, height);
+			return false;
+		}
+
+		// Mid grey background, 10-bit component values for either YUV or RGB
+		for (uint32_t x = 0; x < width; x++)
+		{
+			greyRow[x * 4 + 0] = 502;
+			greyRow[x * 4 + 1] = (pixelFormat == bmdFormat8BitBGRA) ? 502 : 512;
+			greyRow[x * 4 + 2] = (pixelFormat == bmdFormat8BitBGRA) ? 502 : 512;
+			greyRow[x * 4 + 3] = 1023;
+		}
+		for (uint32_t y = 0; y < height; y++)
+			CpuCompositor::packRow(greyRow.data(), width, pixelFormat, &frame[y * rowBytes]);
+
+		double singleThreadFrameRate = measureFrameRate(singleThreadCompositor, scene, frame, width, height, pixelFormat, frameCount);
+		double frameRate = measureFrameRate(compositor, scene, frame, width, height, pixelFormat, frameCount);
+		double concurrentFrameRate = measureConcurrentFrameRate(compositor, scene, frame, width, height, pixelFormat, frameCount);
+
+		// Real-time is judged by the concurrent rate, the way frames arrive from the dispatch threads
+		printf("  %-10s  1 thread: %7.1f frames/s (%6.2f ms/frame)  %2u threads: %7.1f frames/s (%6.2f ms/frame)  %u frames at once: %7.1f frames/s  %s\n",
+				pixelFormatNames[i], singleThreadFrameRate, 1000.0 / singleThreadFrameRate,
+				compositor.getThreadCount(), frameRate, 1000.0 / frameRate, kConcurrentFrames, concurrentFrameRate,
+				(concurrentFrameRate >= kTargetFrameRate) ? "real-time at 60 fps" : "below 60 fps");
+	}
+
+	return true;
+}
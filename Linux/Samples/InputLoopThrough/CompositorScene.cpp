@@ -0,0 +1,179 @@
+/* -LICENSE-START-
+** Copyright (c) 2022 Blackmagic Design
+**  
+** Permission is hereby granted, free of charge, to any person or organization 
+** obtaining a copy of the software and accompanying documentation (the 
+** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+** and transmit the Software, and to prepare derivative works of the Software, 
+** and to permit third-parties to whom the Software is furnished to do so, in 
+** accordance with:
+** 
+** (1) if the Software is obtained from Blackmagic Design, the End User License 
+** Agreement for the Software Development Kit (“EULA”) available at 
+** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+** 
+** (2) if the Software is obtained from any third party, such licensing terms 
+** as notified by that third party,
+** 
+** and all subject to the following:
+** 
+** (3) the copyright notices in the Software and this entire statement, 
+** including the above license grant, this restriction and the following 
+** disclaimer, must be included in all copies of the Software, in whole or in 
+** part, and all derivative works of the Software, unless such copies or 
+** derivative works are solely in the form of machine-executable object code 
+** generated by a source language processor.
+** 
+** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+** DEALINGS IN THE SOFTWARE.
+** 
+** A copy of the Software is available free of charge at 
+** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+** 
+** -LICENSE-END-
+*/
+
+#include <algorithm>
+#include "CompositorScene.h"
+
+// 75% colour bars as Rec.709 10-bit Y Cb Cr and 10-bit B G R
+static const uint16_t kColourBarsYUV[8][3] =
+{
+	{ 721, 512, 512 }, { 646, 176, 567 }, { 525, 625, 176 }, { 450, 289, 231 },
+	{ 335, 735, 793 }, { 260, 399, 848 }, { 139, 848, 457 }, {  64, 512, 512 },
+};
+
+static const uint16_t kColourBarsRGB[8][3] =
+{
+	{ 767, 767, 767 }, {   0, 767, 767 }, { 767, 767,   0 }, {   0, 767,   0 },
+	{ 767,   0, 767 }, {   0,   0, 767 }, { 767,   0,   0 }, {   0,   0,   0 },
+};
+
+static CompositorLayer makeLayer(const std::vector<uint8_t>& pixels, uint32_t width, uint32_t height, BMDPixelFormat pixelFormat,
+								 int32_t x, int32_t y, uint32_t scaledWidth, uint32_t scaledHeight, float opacity)
+{
+	CompositorLayer layer = {};
+
+	layer.pixels		= pixels.data();
+	layer.rowBytes		= CpuCompositor::getRowBytes(width, pixelFormat);
+	layer.width			= width;
+	layer.height		= height;
+	layer.pixelFormat	= pixelFormat;
+	layer.x				= x;
+	layer.y				= y;
+	layer.scaledWidth	= scaledWidth;
+	layer.scaledHeight	= scaledHeight;
+	layer.opacity		= opacity;
+	layer.key			= CompositorKey::None;
+
+	return layer;
+}
+
+CompositorScene::CompositorScene() :
+	m_width(0),
+	m_height(0),
+	m_pixelFormat(bmdFormatUnspecified)
+{
+}
+
+bool CompositorScene::isConfiguredFor(uint32_t width, uint32_t height, BMDPixelFormat pixelFormat) const
+{
+	return (width == m_width) && (height == m_height) && (pixelFormat == m_pixelFormat);
+}
+
+bool CompositorScene::configure(uint32_t width, uint32_t height, BMDPixelFormat pixelFormat)
+{
+	if (!CpuCompositor::isPixelFormatSupported(pixelFormat) || (width < 32) || (height < 32))
+		return false;
+
+	const bool				isRGB = (pixelFormat == bmdFormat8BitBGRA);
+	std::vector<uint16_t>	row(width * 4);
+
+	m_layers.clear();
+
+	// Colour bars at half size, scaled to a third of the frame in the top right corner
+	uint32_t pipWidth = width / 2;
+	uint32_t pipHeight = height / 2;
+	uint32_t pipRowBytes = CpuCompositor::getRowBytes(pipWidth, pixelFormat);
+
+	m_pictureInPicture.assign(pipRowBytes * pipHeight, 0);
+	for (uint32_t x = 0; x < pipWidth; x++)
+	{
+		const uint16_t* colour = isRGB ? kColourBarsRGB[(x * 8) / pipWidth] : kColourBarsYUV[(x * 8) / pipWidth];
+		std::copy(colour, colour + 3, &row[x * 4]);
+		row[x * 4 + 3] = 1023;
+	}
+	for (uint32_t y = 0; y < pipHeight; y++)
+		CpuCompositor::packRow(row.data(), pipWidth, pixelFormat, &m_pictureInPicture[y * pipRowBytes]);
+
+	m_layers.push_back(makeLayer(m_pictureInPicture, pipWidth, pipHeight, pixelFormat,
+								 width - width / 3 - width / 20, height / 20, width / 3, height / 3, 1.0f));
+
+	// Blue BGRA lower third, fading from mostly opaque on the left to mostly transparent on the right, with a lighter top edge
+	uint32_t lowerThirdHeight = height / 6;
+	uint32_t lowerThirdRowBytes = CpuCompositor::getRowBytes(width, bmdFormat8BitBGRA);
+
+	m_lowerThird.assign(lowerThirdRowBytes * lowerThirdHeight, 0);
+	for (uint32_t y = 0; y < lowerThirdHeight; y++)
+	{
+		bool isEdge = y < lowerThirdHeight / 10;
+
+		for (uint32_t x = 0; x < width; x++)
+		{
+			row[x * 4 + 0] = isEdge ? 960 : 560;
+			row[x * 4 + 1] = isEdge ? 640 : 160;
+			row[x * 4 + 2] = isEdge ? 320 : 40;
+			row[x * 4 + 3] = (uint16_t)(920 - (x * 620) / width);
+		}
+		CpuCompositor::packRow(row.data(), width, bmdFormat8BitBGRA, &m_lowerThird[y * lowerThirdRowBytes]);
+	}
+
+	m_layers.push_back(makeLayer(m_lowerThird, width, lowerThirdHeight, bmdFormat8BitBGRA, 0, (height * 2) / 3, width, lowerThirdHeight, 1.0f));
+
+	// Logo of a white disc inside a grey ring on black, the black is removed by the luma key
+	uint32_t logoSize = std::max(height / 6, 2u) & ~1u;
+	uint32_t logoRowBytes = CpuCompositor::getRowBytes(logoSize, pixelFormat);
+	int		 radius = logoSize / 2;
+
+	m_logo.assign(logoRowBytes * logoSize, 0);
+	for (uint32_t y = 0; y < logoSize; y++)
+	{
+		for (uint32_t x = 0; x < logoSize; x++)
+		{
+			int dx = (int)x - radius;
+			int dy = (int)y - radius;
+			int distanceSquared = dx * dx + dy * dy;
+			uint16_t level;
+
+			if (distanceSquared < (radius * radius) / 4)
+				level = isRGB ? 1023 : 940;
+			else if (distanceSquared < (radius * radius * 9) / 10)
+				level = isRGB ? 512 : 502;
+			else
+				level = isRGB ? 0 : 64;
+
+			row[x * 4 + 0] = level;
+			row[x * 4 + 1] = isRGB ? level : 512;
+			row[x * 4 + 2] = isRGB ? level : 512;
+			row[x * 4 + 3] = 1023;
+		}
+		CpuCompositor::packRow(row.data(), logoSize, pixelFormat, &m_logo[y * logoRowBytes]);
+	}
+
+	CompositorLayer logo = makeLayer(m_logo, logoSize, logoSize, pixelFormat, width / 20, height / 20, logoSize, logoSize, 0.8f);
+	logo.key		= CompositorKey::Luma;
+	logo.keyLow		= 0.1f;
+	logo.keyHigh	= 0.2f;
+	m_layers.push_back(logo);
+
+	m_width = width;
+	m_height = height;
+	m_pixelFormat = pixelFormat;
+
+	return true;
+}
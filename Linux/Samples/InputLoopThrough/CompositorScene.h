@@ -0,0 +1,70 @@
+/* -LICENSE-START-
+** Copyright (c) 2022 Blackmagic Design
+**  
+** Permission is hereby granted, free of charge, to any person or organization 
+** obtaining a copy of the software and accompanying documentation (the 
+** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+** and transmit the Software, and to prepare derivative works of the Software, 
+** and to permit third-parties to whom the Software is furnished to do so, in 
+** accordance with:
+** 
+** (1) if the Software is obtained from Blackmagic Design, the End User License 
+** Agreement for the Software Development Kit (“EULA”) available at 
+** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+** 
+** (2) if the Software is obtained from any third party, such licensing terms 
+** as notified by that third party,
+** 
+** and all subject to the following:
+** 
+** (3) the copyright notices in the Software and this entire statement, 
+** including the above license grant, this restriction and the following 
+** disclaimer, must be included in all copies of the Software, in whole or in 
+** part, and all derivative works of the Software, unless such copies or 
+** derivative works are solely in the form of machine-executable object code 
+** generated by a source language processor.
+** 
+** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+** DEALINGS IN THE SOFTWARE.
+** 
+** A copy of the Software is available free of charge at 
+** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+** 
+** -LICENSE-END-
+*/
+
+#pragma once
+
+#include <vector>
+#include <stdint.h>
+#include "CpuCompositor.h"
+#include "DeckLinkAPI.h"
+
+// The CompositorScene generates three layers to composite over the loop-through video: a scaled
+// picture-in-picture of colour bars, a BGRA lower third with alpha, and a luma keyed logo.
+class CompositorScene
+{
+public:
+	CompositorScene();
+	virtual ~CompositorScene() = default;
+
+	// Create layers for frames of the given size and pixel format, returns false if the format is not supported
+	bool									configure(uint32_t width, uint32_t height, BMDPixelFormat pixelFormat);
+	bool									isConfiguredFor(uint32_t width, uint32_t height, BMDPixelFormat pixelFormat) const;
+
+	const std::vector<CompositorLayer>&		getLayers(void) const { return m_layers; }
+
+private:
+	uint32_t								m_width;
+	uint32_t								m_height;
+	BMDPixelFormat							m_pixelFormat;
+	std::vector<CompositorLayer>			m_layers;
+	std::vector<uint8_t>					m_pictureInPicture;
+	std::vector<uint8_t>					m_lowerThird;
+	std::vector<uint8_t>					m_logo;
+};
@@ -0,0 +1,1201 @@
+/* -LICENSE-START-
+** Copyright (c) 2022 Blackmagic Design
+**  
+** Permission is hereby granted, free of charge, to any person or organization 
+** obtaining a copy of the software and accompanying documentation (the 
+** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+** and transmit the Software, and to prepare derivative works of the Software, 
+** and to permit third-parties to whom the Software is furnished to do so, in 
+** accordance with:
+** 
+** (1) if the Software is obtained from Blackmagic Design, the End User License 
+** Agreement for the Software Development Kit (“EULA”) available at 
+** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+** 
+** (2) if the Software is obtained from any third party, such licensing terms 
+** as notified by that third party,
+** 
+** and all subject to the following:
+** 
+** (3) the copyright notices in the Software and this entire statement, 
+** including the above license grant, this restriction and the following 
+** disclaimer, must be included in all copies of the Software, in whole or in 
+** part, and all derivative works of the Software, unless such copies or 
+** derivative works are solely in the form of machine-executable object code 
+** generated by a source language processor.
+** 
+** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+** DEALINGS IN THE SOFTWARE.
+** 
+** A copy of the Software is available free of charge at 
+** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+** 
+** -LICENSE-END-
+*/
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#include "CpuCompositor.h"
+
+static const uint32_t	kBandRowCount		= 16;		// Rows in each band of the frame processed by a thread
+static const uint16_t	kOpaqueAlpha		= 1023;
+
+// Working pixels are 4 x uint16_t: Y Cb Cr A for YUV, B G R A for RGB
+static const uint32_t	kComponentsPerPixel	= 4;
+
+static inline uint16_t clampComponent(int value, int minimum, int maximum)
+{
+	return (uint16_t)std::min(std::max(value, minimum), maximum);
+}
+
+static inline uint32_t v210Component(uint32_t word, unsigned component)
+{
+	return (word >> (component * 10)) & 0x3ff;
+}
+
+static inline bool isRGBFormat(BMDPixelFormat pixelFormat)
+{
+	return pixelFormat == bmdFormat8BitBGRA;
+}
+
+// Blend kernels
+//
+// For each pixel, destination += (source - destination) * source alpha * opacity, on the colour components only
+// so that the frame's alpha is kept.  Alpha and opacity are Q15 fixed point, the rounding multiply matches
+// _mm256_mulhrs_epi16 and vqrdmulhq_s16 so all kernels give identical results.
+
+static void blendPixelsScalar(uint16_t* destination, const uint16_t* source, uint32_t pixelCount, int16_t opacity)
+{
+	for (uint32_t i = 0; i < pixelCount; i++, destination += kComponentsPerPixel, source += kComponentsPerPixel)
+	{
+		int alpha = (source[3] << 5) | (source[3] >> 5);
+		alpha = (alpha * opacity + 0x4000) >> 15;
+
+		for (unsigned component = 0; component < 3; component++)
+			destination[component] += (((int)source[component] - (int)destination[component]) * alpha + 0x4000) >> 15;
+	}
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("avx2")))
+static void blendPixelsAVX2(uint16_t* destination, const uint16_t* source, uint32_t pixelCount, int16_t opacity)
+{
+	// Copy the alpha of each pixel to its three colour components, and zero the alpha component
+	const __m256i	alphaShuffle	= _mm256_setr_epi8(6, 7, 6, 7, 6, 7, -1, -1, 14, 15, 14, 15, 14, 15, -1, -1,
+													   6, 7, 6, 7, 6, 7, -1, -1, 14, 15, 14, 15, 14, 15, -1, -1);
+	const __m256i	opacityQ15		= _mm256_set1_epi16(opacity);
+	uint32_t		i = 0;
+
+	for (; i + 4 <= pixelCount; i += 4, destination += 16, source += 16)
+	{
+		__m256i src = _mm256_loadu_si256((const __m256i*)source);
+		__m256i dst = _mm256_loadu_si256((const __m256i*)destination);
+
+		__m256i alpha = _mm256_or_si256(_mm256_slli_epi16(src, 5), _mm256_srli_epi16(src, 5));
+		alpha = _mm256_mulhrs_epi16(_mm256_shuffle_epi8(alpha, alphaShuffle), opacityQ15);
+
+		dst = _mm256_add_epi16(dst, _mm256_mulhrs_epi16(_mm256_sub_epi16(src, dst), alpha));
+		_mm256_storeu_si256((__m256i*)destination, dst);
+	}
+
+	blendPixelsScalar(destination, source, pixelCount - i, opacity);
+}
+#elif defined(__aarch64__)
+static void blendPixelsNEON(uint16_t* destination, const uint16_t* source, uint32_t pixelCount, int16_t opacity)
+{
+	// Copy the alpha of each pixel to its three colour components, out of range indices zero the alpha component
+	static const uint8_t	kAlphaShuffle[16]	= { 6, 7, 6, 7, 6, 7, 0xff, 0xff, 14, 15, 14, 15, 14, 15, 0xff, 0xff };
+	const uint8x16_t		alphaShuffle		= vld1q_u8(kAlphaShuffle);
+	const int16x8_t			opacityQ15			= vdupq_n_s16(opacity);
+	uint32_t				i = 0;
+
+	for (; i + 2 <= pixelCount; i += 2, destination += 8, source += 8)
+	{
+		uint16x8_t src = vld1q_u16(source);
+		int16x8_t dst = vreinterpretq_s16_u16(vld1q_u16(destination));
+
+		uint16x8_t alphaQ15 = vorrq_u16(vshlq_n_u16(src, 5), vshrq_n_u16(src, 5));
+		int16x8_t alpha = vreinterpretq_s16_u8(vqtbl1q_u8(vreinterpretq_u8_u16(alphaQ15), alphaShuffle));
+		alpha = vqrdmulhq_s16(alpha, opacityQ15);
+
+		int16x8_t difference = vsubq_s16(vreinterpretq_s16_u16(src), dst);
+		dst = vaddq_s16(dst, vqrdmulhq_s16(difference, alpha));
+		vst1q_u16(destination, vreinterpretq_u16_s16(dst));
+	}
+
+	blendPixelsScalar(destination, source, pixelCount - i, opacity);
+}
+#endif
+
+// Row unpacking, 8-bit values are scaled to 10-bit and chroma is repeated for both pixels of each pair
+
+static void unpackRowUYVY(const uint8_t* row, uint16_t* pixels, uint32_t width)
+{
+	for (uint32_t x = 0; x < width; x += 2, row += 4, pixels += 8)
+	{
+		uint16_t cb = row[0] << 2;
+		uint16_t cr = row[2] << 2;
+
+		pixels[0] = row[1] << 2;	pixels[1] = cb;		pixels[2] = cr;		pixels[3] = kOpaqueAlpha;
+		if (x + 1 < width)
+		{
+			pixels[4] = row[3] << 2;	pixels[5] = cb;		pixels[6] = cr;		pixels[7] = kOpaqueAlpha;
+		}
+	}
+}
+
+static void unpackRowV210(const uint8_t* row, uint16_t* pixels, uint32_t width)
+{
+	const uint32_t* words = (const uint32_t*)row;
+
+	for (uint32_t x = 0; x < width; x += 6, words += 4)
+	{
+		uint16_t y[6]	= {	(uint16_t)v210Component(words[0], 1), (uint16_t)v210Component(words[1], 0),
+							(uint16_t)v210Component(words[1], 2), (uint16_t)v210Component(words[2], 1),
+							(uint16_t)v210Component(words[3], 0), (uint16_t)v210Component(words[3], 2) };
+		uint16_t cb[3]	= {	(uint16_t)v210Component(words[0], 0), (uint16_t)v210Component(words[1], 1), (uint16_t)v210Component(words[2], 2) };
+		uint16_t cr[3]	= {	(uint16_t)v210Component(words[0], 2), (uint16_t)v210Component(words[2], 0), (uint16_t)v210Component(words[3], 1) };
+
+		uint32_t count = std::min(width - x, 6u);
+		for (uint32_t i = 0; i < count; i++, pixels += kComponentsPerPixel)
+		{
+			pixels[0] = y[i];
+			pixels[1] = cb[i / 2];
+			pixels[2] = cr[i / 2];
+			pixels[3] = kOpaqueAlpha;
+		}
+	}
+}
+
+static void unpackRowBGRA(const uint8_t* row, uint16_t* pixels, uint32_t width)
+{
+	for (uint32_t x = 0; x < width; x++, row += 4, pixels += kComponentsPerPixel)
+	{
+		pixels[0] = row[0] << 2;
+		pixels[1] = row[1] << 2;
+		pixels[2] = row[2] << 2;
+		pixels[3] = (row[3] << 2) | (row[3] >> 6);
+	}
+}
+
+// Row packing, chroma of each pair is averaged.  YUV values are kept out of the ranges reserved for timing references.
+
+static void packRowUYVY(const uint16_t* pixels, uint8_t* row, uint32_t width)
+{
+	for (uint32_t x = 0; x < width; x += 2, row += 4, pixels += 8)
+	{
+		const uint16_t* next = (x + 1 < width) ? pixels + kComponentsPerPixel : pixels;
+
+		row[0] = (uint8_t)clampComponent((pixels[1] + next[1] + 4) >> 3, 1, 254);
+		row[1] = (uint8_t)clampComponent((pixels[0] + 2) >> 2, 1, 254);
+		row[2] = (uint8_t)clampComponent((pixels[2] + next[2] + 4) >> 3, 1, 254);
+		row[3] = (uint8_t)clampComponent((next[0] + 2) >> 2, 1, 254);
+	}
+}
+
+static void packRowV210(const uint16_t* pixels, uint8_t* row, uint32_t width)
+{
+	uint32_t* words = (uint32_t*)row;
+
+	for (uint32_t x = 0; x < width; x += 6, words += 4)
+	{
+		uint32_t y[6], cb[3], cr[3];
+
+		// Pixels past the end of the row repeat the last pixel
+		for (uint32_t i = 0; i < 6; i++)
+			y[i] = clampComponent(pixels[std::min(x + i, width - 1) * kComponentsPerPixel], 4, 1019);
+
+		for (uint32_t i = 0; i < 3; i++)
+		{
+			const uint16_t* p0 = pixels + std::min(x + i * 2, width - 1) * kComponentsPerPixel;
+			const uint16_t* p1 = pixels + std::min(x + i * 2 + 1, width - 1) * kComponentsPerPixel;
+			cb[i] = clampComponent((p0[1] + p1[1] + 1) >> 1, 4, 1019);
+			cr[i] = clampComponent((p0[2] + p1[2] + 1) >> 1, 4, 1019);
+		}
+
+		words[0] = cb[0] | (y[0] << 10) | (cr[0] << 20);
+		words[1] = y[1] | (cb[1] << 10) | (y[2] << 20);
+		words[2] = cr[1] | (y[3] << 10) | (cb[2] << 20);
+		words[3] = y[4] | (cr[2] << 10) | (y[5] << 20);
+	}
+}
+
+static void packRowBGRA(const uint16_t* pixels, uint8_t* row, uint32_t width)
+{
+	for (uint32_t x = 0; x < width; x++, row += 4, pixels += kComponentsPerPixel)
+	{
+		row[0] = (uint8_t)std::min((pixels[0] + 2) >> 2, 255);
+		row[1] = (uint8_t)std::min((pixels[1] + 2) >> 2, 255);
+		row[2] = (uint8_t)std::min((pixels[2] + 2) >> 2, 255);
+		row[3] = (uint8_t)(pixels[3] >> 2);
+	}
+}
+
+// Rec.709 conversion between 10-bit video range YCbCr and 10-bit full range RGB, coefficients are Q12 fixed point
+
+static void convertRowYUVToRGB(uint16_t* pixels, uint32_t pixelCount)
+{
+	for (uint32_t i = 0; i < pixelCount; i++, pixels += kComponentsPerPixel)
+	{
+		int y = (pixels[0] - 64) * 4783;
+		int cb = pixels[1] - 512;
+		int cr = pixels[2] - 512;
+
+		pixels[0] = clampComponent((y + 8678 * cb + 2048) >> 12, 0, 1023);
+		pixels[1] = clampComponent((y - 876 * cb - 2189 * cr + 2048) >> 12, 0, 1023);
+		pixels[2] = clampComponent((y + 7365 * cr + 2048) >> 12, 0, 1023);
+	}
+}
+
+static inline void rgbToYCbCr(const uint16_t* pixel, int& y, int& cb, int& cr)
+{
+	int b = pixel[0];
+	int g = pixel[1];
+	int r = pixel[2];
+
+	y = 64 + ((746 * r + 2509 * g + 253 * b + 2048) >> 12);
+	cb = 512 + ((-411 * r - 1383 * g + 1794 * b + 2048) >> 12);
+	cr = 512 + ((1794 * r - 1629 * g - 165 * b + 2048) >> 12);
+}
+
+static void convertRowRGBToYUV(uint16_t* pixels, uint32_t pixelCount)
+{
+	for (uint32_t i = 0; i < pixelCount; i++, pixels += kComponentsPerPixel)
+	{
+		int y, cb, cr;
+		rgbToYCbCr(pixels, y, cb, cr);
+
+		pixels[0] = clampComponent(y, 0, 1023);
+		pixels[1] = clampComponent(cb, 0, 1023);
+		pixels[2] = clampComponent(cr, 0, 1023);
+	}
+}
+
+// Keying multiplies each pixel's alpha by the key value
+
+static inline uint16_t multiplyAlpha(uint16_t alpha, int key)
+{
+	// alpha * key / 1023, 1025 / 2^20 is close enough to 1 / 1023 for 10-bit values
+	return (uint16_t)((alpha * key * 1025 + (1 << 19)) >> 20);
+}
+
+// Luma key threshold and scale.  Differences from the low threshold are clamped to maxDifference, the smallest
+// difference with a fully opaque key, so that vector kernels can scale them in 32 bits.
+struct LumaKeyRange
+{
+	int		low;
+	int		scale;
+	int		maxDifference;
+};
+
+static LumaKeyRange getLumaKeyRange(const CompositorLayer& layer)
+{
+	LumaKeyRange	range;
+	int				high;
+
+	range.low			= 64 + (int)lroundf(std::min(std::max(layer.keyLow, 0.0f), 1.0f) * 876.0f);
+	high				= std::max(64 + (int)lroundf(std::min(std::max(layer.keyHigh, 0.0f), 1.0f) * 876.0f), range.low + 1);
+	range.scale			= (int)(((int64_t)1023 << 16) / (high - range.low));
+	range.maxDifference	= (int)((((int64_t)1023 << 16) + range.scale - 1) / range.scale);
+
+	return range;
+}
+
+static void applyLumaKey(uint16_t* pixels, uint32_t pixelCount, bool isRGB, const CompositorLayer& layer)
+{
+	LumaKeyRange range = getLumaKeyRange(layer);
+
+	for (uint32_t i = 0; i < pixelCount; i++, pixels += kComponentsPerPixel)
+	{
+		int y = pixels[0], cb, cr;
+		if (isRGB)
+			rgbToYCbCr(pixels, y, cb, cr);
+
+		int key = (int)std::min(std::max(((int64_t)(y - range.low) * range.scale) >> 16, (int64_t)0), (int64_t)1023);
+		pixels[3] = multiplyAlpha(pixels[3], key);
+	}
+}
+
+static void applyChromaKey(uint16_t* pixels, uint32_t pixelCount, bool isRGB, const CompositorLayer& layer)
+{
+	float softness = std::max(layer.keySoftness, 1.0f / 1023.0f);
+
+	for (uint32_t i = 0; i < pixelCount; i++, pixels += kComponentsPerPixel)
+	{
+		int y, cb = pixels[1], cr = pixels[2];
+		if (isRGB)
+			rgbToYCbCr(pixels, y, cb, cr);
+
+		float cbDistance = (cb - 512) / 896.0f - layer.keyCb;
+		float crDistance = (cr - 512) / 896.0f - layer.keyCr;
+		float distance = sqrtf(cbDistance * cbDistance + crDistance * crDistance);
+		float key = std::min(std::max((distance - layer.keyTolerance) / softness, 0.0f), 1.0f);
+
+		pixels[3] = multiplyAlpha(pixels[3], (int)(key * 1023.0f + 0.5f));
+	}
+}
+
+// Vector unpacking, packing and keying
+//
+// The vector kernels process whole groups of pixels and leave the rest of the row to the scalar kernels above.
+// They use the same fixed point arithmetic as the scalar kernels, so results do not depend on the CPU.
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("avx2")))
+static void unpackRowUYVYAVX2(const uint8_t* row, uint16_t* pixels, uint32_t width)
+{
+	// Gather Y Cb Cr of 4 pixels from each 8 bytes, the alpha component is zeroed and then set opaque
+	const __m128i	lowPixels	= _mm_setr_epi8(1, 0, 2, -1, 3, 0, 2, -1, 5, 4, 6, -1, 7, 4, 6, -1);
+	const __m128i	highPixels	= _mm_setr_epi8(9, 8, 10, -1, 11, 8, 10, -1, 13, 12, 14, -1, 15, 12, 14, -1);
+	const __m256i	opaque		= _mm256_set1_epi64x((int64_t)kOpaqueAlpha << 48);
+	uint32_t		x = 0;
+
+	for (; x + 8 <= width; x += 8, row += 16, pixels += 32)
+	{
+		__m128i packed = _mm_loadu_si128((const __m128i*)row);
+		__m256i low = _mm256_slli_epi16(_mm256_cvtepu8_epi16(_mm_shuffle_epi8(packed, lowPixels)), 2);
+		__m256i high = _mm256_slli_epi16(_mm256_cvtepu8_epi16(_mm_shuffle_epi8(packed, highPixels)), 2);
+
+		_mm256_storeu_si256((__m256i*)pixels, _mm256_or_si256(low, opaque));
+		_mm256_storeu_si256((__m256i*)(pixels + 16), _mm256_or_si256(high, opaque));
+	}
+
+	unpackRowUYVY(row, pixels, width - x);
+}
+
+__attribute__((target("avx2")))
+static void unpackRowV210AVX2(const uint8_t* row, uint16_t* pixels, uint32_t width)
+{
+	// Each 128-bit lane holds a group of 4 words and 6 pixels.  The components of each word are packed to 16 bits,
+	// component 0 and 1 of words 0-3 in one vector and component 2 in another, then shuffled into 3 pairs of pixels.
+	const __m256i	componentMask	= _mm256_set1_epi32(0x3ff);
+	const __m256i	pair0Shuffle01	= _mm256_broadcastsi128_si256(_mm_setr_epi8(8, 9, 0, 1, -1, -1, -1, -1, 2, 3, 0, 1, -1, -1, -1, -1));
+	const __m256i	pair0Shuffle2	= _mm256_broadcastsi128_si256(_mm_setr_epi8(-1, -1, -1, -1, 0, 1, -1, -1, -1, -1, -1, -1, 0, 1, -1, -1));
+	const __m256i	pair1Shuffle01	= _mm256_broadcastsi128_si256(_mm_setr_epi8(-1, -1, 10, 11, 4, 5, -1, -1, 12, 13, 10, 11, 4, 5, -1, -1));
+	const __m256i	pair1Shuffle2	= _mm256_broadcastsi128_si256(_mm_setr_epi8(2, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1));
+	const __m256i	pair2Shuffle01	= _mm256_broadcastsi128_si256(_mm_setr_epi8(6, 7, -1, -1, 14, 15, -1, -1, -1, -1, -1, -1, 14, 15, -1, -1));
+	const __m256i	pair2Shuffle2	= _mm256_broadcastsi128_si256(_mm_setr_epi8(-1, -1, 4, 5, -1, -1, -1, -1, 6, 7, 4, 5, -1, -1, -1, -1));
+	const __m256i	opaque			= _mm256_set1_epi64x((int64_t)kOpaqueAlpha << 48);
+	uint32_t		x = 0;
+
+	for (; x + 12 <= width; x += 12, row += 32, pixels += 48)
+	{
+		__m256i words = _mm256_loadu_si256((const __m256i*)row);
+		__m256i components01 = _mm256_packus_epi32(_mm256_and_si256(words, componentMask),
+													_mm256_and_si256(_mm256_srli_epi32(words, 10), componentMask));
+		__m256i components2 = _mm256_and_si256(_mm256_srli_epi32(words, 20), componentMask);
+		components2 = _mm256_packus_epi32(components2, components2);
+
+		__m256i pair0 = _mm256_or_si256(_mm256_or_si256(_mm256_shuffle_epi8(components01, pair0Shuffle01), _mm256_shuffle_epi8(components2, pair0Shuffle2)), opaque);
+		__m256i pair1 = _mm256_or_si256(_mm256_or_si256(_mm256_shuffle_epi8(components01, pair1Shuffle01), _mm256_shuffle_epi8(components2, pair1Shuffle2)), opaque);
+		__m256i pair2 = _mm256_or_si256(_mm256_or_si256(_mm256_shuffle_epi8(components01, pair2Shuffle01), _mm256_shuffle_epi8(components2, pair2Shuffle2)), opaque);
+
+		// The low lanes hold pixels 0-5 and the high lanes pixels 6-11
+		_mm256_storeu_si256((__m256i*)pixels, _mm256_permute2x128_si256(pair0, pair1, 0x20));
+		_mm256_storeu_si256((__m256i*)(pixels + 16), _mm256_permute2x128_si256(pair2, pair0, 0x30));
+		_mm256_storeu_si256((__m256i*)(pixels + 32), _mm256_permute2x128_si256(pair1, pair2, 0x31));
+	}
+
+	unpackRowV210(row, pixels, width - x);
+}
+
+__attribute__((target("avx2")))
+static void unpackRowBGRAAVX2(const uint8_t* row, uint16_t* pixels, uint32_t width)
+{
+	const __m256i	alphaMask = _mm256_set1_epi64x((int64_t)0xffff << 48);
+	uint32_t		x = 0;
+
+	for (; x + 8 <= width; x += 8, row += 32, pixels += 32)
+	{
+		__m256i low = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)row));
+		__m256i high = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(row + 16)));
+
+		// The top bits of alpha are repeated so that 255 becomes 1023
+		low = _mm256_or_si256(_mm256_slli_epi16(low, 2), _mm256_and_si256(_mm256_srli_epi16(low, 6), alphaMask));
+		high = _mm256_or_si256(_mm256_slli_epi16(high, 2), _mm256_and_si256(_mm256_srli_epi16(high, 6), alphaMask));
+
+		_mm256_storeu_si256((__m256i*)pixels, low);
+		_mm256_storeu_si256((__m256i*)(pixels + 16), high);
+	}
+
+	unpackRowBGRA(row, pixels, width - x);
+}
+
+// Rounded luma of each pixel and rounded chroma of the pair starting at each even pixel, in the pixel's Y, Cb and
+// Cr components
+__attribute__((target("avx2")))
+static inline __m256i roundPairsAVX2(__m256i pixels, int lumaShift, int chromaShift)
+{
+	const __m128i	lumaCount	= _mm_cvtsi32_si128(lumaShift);
+	const __m128i	chromaCount	= _mm_cvtsi32_si128(chromaShift);
+	__m256i			luma		= _mm256_srl_epi16(_mm256_add_epi16(pixels, _mm256_set1_epi16((1 << lumaShift) >> 1)), lumaCount);
+	__m256i			sums		= _mm256_add_epi16(pixels, _mm256_bsrli_epi128(pixels, 8));
+	__m256i			chroma		= _mm256_srl_epi16(_mm256_add_epi16(sums, _mm256_set1_epi16((1 << chromaShift) >> 1)), chromaCount);
+
+	return _mm256_blend_epi16(luma, chroma, 0x06);
+}
+
+__attribute__((target("avx2")))
+static void packRowUYVYAVX2(const uint16_t* pixels, uint8_t* row, uint32_t width)
+{
+	// Each 128-bit lane holds a pair, shuffled to Cb Y0 Cr Y1 and clamped, then the 4 pairs are narrowed to bytes
+	const __m256i	pairShuffle	= _mm256_broadcastsi128_si256(_mm_setr_epi8(2, 3, 0, 1, 4, 5, 8, 9, -1, -1, -1, -1, -1, -1, -1, -1));
+	const __m256i	pairOrder	= _mm256_setr_epi32(0, 4, 2, 6, 1, 3, 5, 7);
+	const __m256i	minimum		= _mm256_set1_epi16(1);
+	const __m256i	maximum		= _mm256_set1_epi16(254);
+	uint32_t		x = 0;
+
+	for (; x + 8 <= width; x += 8, pixels += 32, row += 16)
+	{
+		__m256i pairs01 = _mm256_shuffle_epi8(roundPairsAVX2(_mm256_loadu_si256((const __m256i*)pixels), 2, 3), pairShuffle);
+		__m256i pairs23 = _mm256_shuffle_epi8(roundPairsAVX2(_mm256_loadu_si256((const __m256i*)(pixels + 16)), 2, 3), pairShuffle);
+
+		pairs01 = _mm256_min_epi16(_mm256_max_epi16(pairs01, minimum), maximum);
+		pairs23 = _mm256_min_epi16(_mm256_max_epi16(pairs23, minimum), maximum);
+
+		__m256i packed = _mm256_permutevar8x32_epi32(_mm256_packus_epi16(pairs01, pairs23), pairOrder);
+		_mm_storeu_si128((__m128i*)row, _mm256_castsi256_si128(packed));
+	}
+
+	packRowUYVY(pixels, row, width - x);
+}
+
+__attribute__((target("avx2")))
+static void packRowV210AVX2(const uint16_t* pixels, uint8_t* row, uint32_t width)
+{
+	// Each 128-bit lane holds the same pair of a group of 6 pixels, with pixels 0-5 in the low lanes and 6-11 in the
+	// high lanes.  Components are gathered from the 3 pairs into 32-bit lanes for each of the 3 components of the
+	// group's 4 words.
+	const __m256i	minimum			= _mm256_set1_epi16(4);
+	const __m256i	maximum			= _mm256_set1_epi16(1019);
+	const __m256i	word0Pair0		= _mm256_broadcastsi128_si256(_mm_setr_epi8(2, 3, -1, -1, 8, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1));
+	const __m256i	word0Pair1		= _mm256_broadcastsi128_si256(_mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, 4, 5, -1, -1, -1, -1, -1, -1));
+	const __m256i	word0Pair2		= _mm256_broadcastsi128_si256(_mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 1, -1, -1));
+	const __m256i	word1Pair0		= _mm256_broadcastsi128_si256(_mm_setr_epi8(0, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1));
+	const __m256i	word1Pair1		= _mm256_broadcastsi128_si256(_mm_setr_epi8(-1, -1, -1, -1, 2, 3, -1, -1, 8, 9, -1, -1, -1, -1, -1, -1));
+	const __m256i	word1Pair2		= _mm256_broadcastsi128_si256(_mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 4, 5, -1, -1));
+	const __m256i	word2Pair0		= _mm256_broadcastsi128_si256(_mm_setr_epi8(4, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1));
+	const __m256i	word2Pair1		= _mm256_broadcastsi128_si256(_mm_setr_epi8(-1, -1, -1, -1, 0, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1));
+	const __m256i	word2Pair2		= _mm256_broadcastsi128_si256(_mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, 2, 3, -1, -1, 8, 9, -1, -1));
+	uint32_t		x = 0;
+
+	for (; x + 12 <= width; x += 12, pixels += 48, row += 32)
+	{
+		__m256i pairs[3];
+
+		for (int i = 0; i < 3; i++)
+		{
+			__m256i pair = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)(pixels + i * 8))),
+												   _mm_loadu_si128((const __m128i*)(pixels + 24 + i * 8)), 1);
+			pairs[i] = _mm256_min_epi16(_mm256_max_epi16(roundPairsAVX2(pair, 0, 1), minimum), maximum);
+		}
+
+		__m256i component0 = _mm256_or_si256(_mm256_or_si256(_mm256_shuffle_epi8(pairs[0], word0Pair0), _mm256_shuffle_epi8(pairs[1], word0Pair1)), _mm256_shuffle_epi8(pairs[2], word0Pair2));
+		__m256i component1 = _mm256_or_si256(_mm256_or_si256(_mm256_shuffle_epi8(pairs[0], word1Pair0), _mm256_shuffle_epi8(pairs[1], word1Pair1)), _mm256_shuffle_epi8(pairs[2], word1Pair2));
+		__m256i component2 = _mm256_or_si256(_mm256_or_si256(_mm256_shuffle_epi8(pairs[0], word2Pair0), _mm256_shuffle_epi8(pairs[1], word2Pair1)), _mm256_shuffle_epi8(pairs[2], word2Pair2));
+
+		__m256i words = _mm256_or_si256(component0, _mm256_or_si256(_mm256_slli_epi32(component1, 10), _mm256_slli_epi32(component2, 20)));
+		_mm256_storeu_si256((__m256i*)row, words);
+	}
+
+	packRowV210(pixels, row, width - x);
+}
+
+__attribute__((target("avx2")))
+static void packRowBGRAAVX2(const uint16_t* pixels, uint8_t* row, uint32_t width)
+{
+	// Colour components are rounded, alpha is truncated, and narrowing saturates to 255
+	const __m256i	rounding = _mm256_set1_epi64x(0x0000000200020002);
+	uint32_t		x = 0;
+
+	for (; x + 8 <= width; x += 8, pixels += 32, row += 32)
+	{
+		__m256i low = _mm256_srli_epi16(_mm256_add_epi16(_mm256_loadu_si256((const __m256i*)pixels), rounding), 2);
+		__m256i high = _mm256_srli_epi16(_mm256_add_epi16(_mm256_loadu_si256((const __m256i*)(pixels + 16)), rounding), 2);
+
+		__m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(low, high), _MM_SHUFFLE(3, 1, 2, 0));
+		_mm256_storeu_si256((__m256i*)row, packed);
+	}
+
+	packRowBGRA(pixels, row, width - x);
+}
+
+// A component of 8 pixels, from 2 vectors of 4 pixels, in 32-bit lanes ordered as pixels 0 4 1 5 2 6 3 7
+__attribute__((target("avx2")))
+static inline __m256i gatherComponentAVX2(__m256i pixels0123, __m256i pixels4567, int component)
+{
+	const __m256i	mask	= _mm256_set1_epi64x(0xffff);
+	const __m128i	shift	= _mm_cvtsi32_si128(component * 16);
+
+	return _mm256_or_si256(_mm256_and_si256(_mm256_srl_epi64(pixels0123, shift), mask),
+						   _mm256_slli_epi64(_mm256_and_si256(_mm256_srl_epi64(pixels4567, shift), mask), 32));
+}
+
+// Replace the alpha of 8 pixels with 32-bit lanes ordered as gatherComponentAVX2
+__attribute__((target("avx2")))
+static inline void scatterAlphaAVX2(__m256i& pixels0123, __m256i& pixels4567, __m256i alpha)
+{
+	const __m256i colourMask = _mm256_set1_epi64x(0x0000ffffffffffff);
+
+	pixels0123 = _mm256_or_si256(_mm256_and_si256(pixels0123, colourMask), _mm256_slli_epi64(alpha, 48));
+	pixels4567 = _mm256_or_si256(_mm256_and_si256(pixels4567, colourMask), _mm256_slli_epi64(_mm256_srli_epi64(alpha, 32), 48));
+}
+
+// Weighted sum of B G R in Q12, with the same rounding as rgbToYCbCr
+__attribute__((target("avx2")))
+static inline __m256i weightRGBAVX2(__m256i b, __m256i g, __m256i r, int bWeight, int gWeight, int rWeight, int offset)
+{
+	__m256i sum = _mm256_add_epi32(_mm256_add_epi32(_mm256_mullo_epi32(r, _mm256_set1_epi32(rWeight)), _mm256_mullo_epi32(g, _mm256_set1_epi32(gWeight))),
+								   _mm256_add_epi32(_mm256_mullo_epi32(b, _mm256_set1_epi32(bWeight)), _mm256_set1_epi32(2048)));
+
+	return _mm256_add_epi32(_mm256_srai_epi32(sum, 12), _mm256_set1_epi32(offset));
+}
+
+__attribute__((target("avx2")))
+static inline __m256i multiplyAlphaAVX2(__m256i alpha, __m256i key)
+{
+	__m256i product = _mm256_mullo_epi32(_mm256_mullo_epi32(alpha, key), _mm256_set1_epi32(1025));
+	return _mm256_srli_epi32(_mm256_add_epi32(product, _mm256_set1_epi32(1 << 19)), 20);
+}
+
+__attribute__((target("avx2")))
+static void applyLumaKeyAVX2(uint16_t* pixels, uint32_t pixelCount, bool isRGB, const CompositorLayer& layer)
+{
+	LumaKeyRange	range			= getLumaKeyRange(layer);
+	const __m256i	low				= _mm256_set1_epi32(range.low);
+	const __m256i	scale			= _mm256_set1_epi32(range.scale);
+	const __m256i	maxDifference	= _mm256_set1_epi32(range.maxDifference);
+	const __m256i	opaqueKey		= _mm256_set1_epi32(1023);
+	uint32_t		i = 0;
+
+	for (; i + 8 <= pixelCount; i += 8, pixels += 32)
+	{
+		__m256i pixels0123 = _mm256_loadu_si256((const __m256i*)pixels);
+		__m256i pixels4567 = _mm256_loadu_si256((const __m256i*)(pixels + 16));
+		__m256i y;
+
+		if (isRGB)
+			y = weightRGBAVX2(gatherComponentAVX2(pixels0123, pixels4567, 0), gatherComponentAVX2(pixels0123, pixels4567, 1),
+							  gatherComponentAVX2(pixels0123, pixels4567, 2), 253, 2509, 746, 64);
+		else
+			y = gatherComponentAVX2(pixels0123, pixels4567, 0);
+
+		__m256i difference = _mm256_min_epi32(_mm256_max_epi32(_mm256_sub_epi32(y, low), _mm256_setzero_si256()), maxDifference);
+		__m256i key = _mm256_min_epi32(_mm256_srai_epi32(_mm256_mullo_epi32(difference, scale), 16), opaqueKey);
+
+		scatterAlphaAVX2(pixels0123, pixels4567, multiplyAlphaAVX2(gatherComponentAVX2(pixels0123, pixels4567, 3), key));
+		_mm256_storeu_si256((__m256i*)pixels, pixels0123);
+		_mm256_storeu_si256((__m256i*)(pixels + 16), pixels4567);
+	}
+
+	applyLumaKey(pixels, pixelCount - i, isRGB, layer);
+}
+
+__attribute__((target("avx2")))
+static void applyChromaKeyAVX2(uint16_t* pixels, uint32_t pixelCount, bool isRGB, const CompositorLayer& layer)
+{
+	const __m256	softness	= _mm256_set1_ps(std::max(layer.keySoftness, 1.0f / 1023.0f));
+	const __m256	tolerance	= _mm256_set1_ps(layer.keyTolerance);
+	const __m256	keyCb		= _mm256_set1_ps(layer.keyCb);
+	const __m256	keyCr		= _mm256_set1_ps(layer.keyCr);
+	const __m256	chromaScale	= _mm256_set1_ps(896.0f);
+	const __m256i	chromaZero	= _mm256_set1_epi32(512);
+	uint32_t		i = 0;
+
+	for (; i + 8 <= pixelCount; i += 8, pixels += 32)
+	{
+		__m256i pixels0123 = _mm256_loadu_si256((const __m256i*)pixels);
+		__m256i pixels4567 = _mm256_loadu_si256((const __m256i*)(pixels + 16));
+		__m256i cb, cr;
+
+		if (isRGB)
+		{
+			__m256i b = gatherComponentAVX2(pixels0123, pixels4567, 0);
+			__m256i g = gatherComponentAVX2(pixels0123, pixels4567, 1);
+			__m256i r = gatherComponentAVX2(pixels0123, pixels4567, 2);
+			cb = weightRGBAVX2(b, g, r, 1794, -1383, -411, 512);
+			cr = weightRGBAVX2(b, g, r, -165, -1629, 1794, 512);
+		}
+		else
+		{
+			cb = gatherComponentAVX2(pixels0123, pixels4567, 1);
+			cr = gatherComponentAVX2(pixels0123, pixels4567, 2);
+		}
+
+		__m256 cbDistance = _mm256_sub_ps(_mm256_div_ps(_mm256_cvtepi32_ps(_mm256_sub_epi32(cb, chromaZero)), chromaScale), keyCb);
+		__m256 crDistance = _mm256_sub_ps(_mm256_div_ps(_mm256_cvtepi32_ps(_mm256_sub_epi32(cr, chromaZero)), chromaScale), keyCr);
+		__m256 distance = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(cbDistance, cbDistance), _mm256_mul_ps(crDistance, crDistance)));
+		__m256 key = _mm256_div_ps(_mm256_sub_ps(distance, tolerance), softness);
+		key = _mm256_min_ps(_mm256_max_ps(key, _mm256_setzero_ps()), _mm256_set1_ps(1.0f));
+
+		__m256i keyValue = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(key, _mm256_set1_ps(1023.0f)), _mm256_set1_ps(0.5f)));
+
+		scatterAlphaAVX2(pixels0123, pixels4567, multiplyAlphaAVX2(gatherComponentAVX2(pixels0123, pixels4567, 3), keyValue));
+		_mm256_storeu_si256((__m256i*)pixels, pixels0123);
+		_mm256_storeu_si256((__m256i*)(pixels + 16), pixels4567);
+	}
+
+	applyChromaKey(pixels, pixelCount - i, isRGB, layer);
+}
+#elif defined(__aarch64__)
+static void unpackRowUYVYNEON(const uint8_t* row, uint16_t* pixels, uint32_t width)
+{
+	const uint16x8_t	opaque = vdupq_n_u16(kOpaqueAlpha);
+	uint32_t			x = 0;
+
+	for (; x + 16 <= width; x += 16, row += 32, pixels += 64)
+	{
+		// Cb, Y0, Cr and Y1 of 8 pairs, chroma is repeated for both pixels of each pair
+		uint8x8x4_t		packed	= vld4_u8(row);
+		uint16x8_t		cb		= vshll_n_u8(packed.val[0], 2);
+		uint16x8_t		cr		= vshll_n_u8(packed.val[2], 2);
+		uint16x8x2_t	y		= vzipq_u16(vshll_n_u8(packed.val[1], 2), vshll_n_u8(packed.val[3], 2));
+		uint16x8x2_t	cbPixels = vzipq_u16(cb, cb);
+		uint16x8x2_t	crPixels = vzipq_u16(cr, cr);
+
+		for (int half = 0; half < 2; half++)
+		{
+			uint16x8x4_t unpacked;
+			unpacked.val[0] = y.val[half];
+			unpacked.val[1] = cbPixels.val[half];
+			unpacked.val[2] = crPixels.val[half];
+			unpacked.val[3] = opaque;
+			vst4q_u16(pixels + half * 32, unpacked);
+		}
+	}
+
+	unpackRowUYVY(row, pixels, width - x);
+}
+
+static void unpackRowV210NEON(const uint8_t* row, uint16_t* pixels, uint32_t width)
+{
+	// Components 0 and 1 of the group's 4 words are packed to 16 bits in the first 16 bytes of the table and
+	// component 2 in the next, then looked up for each pair of pixels
+	static const uint8_t	kPairLookup[3][16]	= {
+		{ 8, 9, 0, 1, 16, 17, 0xff, 0xff, 2, 3, 0, 1, 16, 17, 0xff, 0xff },
+		{ 18, 19, 10, 11, 4, 5, 0xff, 0xff, 12, 13, 10, 11, 4, 5, 0xff, 0xff },
+		{ 6, 7, 20, 21, 14, 15, 0xff, 0xff, 22, 23, 20, 21, 14, 15, 0xff, 0xff } };
+	const uint32x4_t		componentMask		= vdupq_n_u32(0x3ff);
+	const uint16x8_t		opaque				= vreinterpretq_u16_u64(vdupq_n_u64((uint64_t)kOpaqueAlpha << 48));
+	uint32_t				x = 0;
+
+	for (; x + 6 <= width; x += 6, row += 16, pixels += 24)
+	{
+		uint32x4_t		words = vld1q_u32((const uint32_t*)row);
+		uint16x4_t		component2 = vmovn_u32(vandq_u32(vshrq_n_u32(words, 20), componentMask));
+		uint8x16x2_t	table;
+
+		table.val[0] = vreinterpretq_u8_u16(vcombine_u16(vmovn_u32(vandq_u32(words, componentMask)),
+														 vmovn_u32(vandq_u32(vshrq_n_u32(words, 10), componentMask))));
+		table.val[1] = vreinterpretq_u8_u16(vcombine_u16(component2, component2));
+
+		for (int pair = 0; pair < 3; pair++)
+			vst1q_u16(pixels + pair * 8, vorrq_u16(vreinterpretq_u16_u8(vqtbl2q_u8(table, vld1q_u8(kPairLookup[pair]))), opaque));
+	}
+
+	unpackRowV210(row, pixels, width - x);
+}
+
+static void unpackRowBGRANEON(const uint8_t* row, uint16_t* pixels, uint32_t width)
+{
+	uint32_t x = 0;
+
+	for (; x + 8 <= width; x += 8, row += 32, pixels += 32)
+	{
+		uint8x8x4_t		bgra = vld4_u8(row);
+		uint16x8x4_t	unpacked;
+
+		unpacked.val[0] = vshll_n_u8(bgra.val[0], 2);
+		unpacked.val[1] = vshll_n_u8(bgra.val[1], 2);
+		unpacked.val[2] = vshll_n_u8(bgra.val[2], 2);
+		unpacked.val[3] = vorrq_u16(vshll_n_u8(bgra.val[3], 2), vmovl_u8(vshr_n_u8(bgra.val[3], 6)));
+		vst4q_u16(pixels, unpacked);
+	}
+
+	unpackRowBGRA(row, pixels, width - x);
+}
+
+static void packRowUYVYNEON(const uint16_t* pixels, uint8_t* row, uint32_t width)
+{
+	const uint16x8_t	minimum = vdupq_n_u16(1);
+	const uint16x8_t	maximum = vdupq_n_u16(254);
+	uint32_t			x = 0;
+
+	for (; x + 16 <= width; x += 16, pixels += 64, row += 32)
+	{
+		uint16x8x4_t	pixels0 = vld4q_u16(pixels);
+		uint16x8x4_t	pixels1 = vld4q_u16(pixels + 32);
+		uint16x8x2_t	y = vuzpq_u16(pixels0.val[0], pixels1.val[0]);
+		uint8x8x4_t		packed;
+
+		packed.val[0] = vmovn_u16(vminq_u16(vmaxq_u16(vrshrq_n_u16(vpaddq_u16(pixels0.val[1], pixels1.val[1]), 3), minimum), maximum));
+		packed.val[1] = vmovn_u16(vminq_u16(vmaxq_u16(vrshrq_n_u16(y.val[0], 2), minimum), maximum));
+		packed.val[2] = vmovn_u16(vminq_u16(vmaxq_u16(vrshrq_n_u16(vpaddq_u16(pixels0.val[2], pixels1.val[2]), 3), minimum), maximum));
+		packed.val[3] = vmovn_u16(vminq_u16(vmaxq_u16(vrshrq_n_u16(y.val[1], 2), minimum), maximum));
+		vst4_u8(row, packed);
+	}
+
+	packRowUYVY(pixels, row, width - x);
+}
+
+static void packRowV210NEON(const uint16_t* pixels, uint8_t* row, uint32_t width)
+{
+	// The luma of each pixel and the chroma of each pair are clamped in the 3 pairs of the group, then the
+	// 3 components of the group's 4 words are looked up from the pairs into 32-bit lanes
+	static const uint16_t	kChromaLanes[8]			= { 0, 0xffff, 0xffff, 0, 0, 0, 0, 0 };
+	static const uint8_t	kComponentLookup[3][16]	= {
+		{ 2, 3, 0xff, 0xff, 8, 9, 0xff, 0xff, 20, 21, 0xff, 0xff, 32, 33, 0xff, 0xff },
+		{ 0, 1, 0xff, 0xff, 18, 19, 0xff, 0xff, 24, 25, 0xff, 0xff, 36, 37, 0xff, 0xff },
+		{ 4, 5, 0xff, 0xff, 16, 17, 0xff, 0xff, 34, 35, 0xff, 0xff, 40, 41, 0xff, 0xff } };
+	const uint16x8_t		chromaLanes	= vld1q_u16(kChromaLanes);
+	const uint16x8_t		minimum		= vdupq_n_u16(4);
+	const uint16x8_t		maximum		= vdupq_n_u16(1019);
+	uint32_t				x = 0;
+
+	for (; x + 6 <= width; x += 6, pixels += 24, row += 16)
+	{
+		uint8x16x3_t	pairs;
+		uint32x4_t		components[3];
+
+		for (int pair = 0; pair < 3; pair++)
+		{
+			uint16x8_t pixelPair = vld1q_u16(pixels + pair * 8);
+			uint16x8_t chroma = vrshrq_n_u16(vaddq_u16(pixelPair, vextq_u16(pixelPair, pixelPair, 4)), 1);
+			pairs.val[pair] = vreinterpretq_u8_u16(vminq_u16(vmaxq_u16(vbslq_u16(chromaLanes, chroma, pixelPair), minimum), maximum));
+		}
+
+		for (int component = 0; component < 3; component++)
+			components[component] = vreinterpretq_u32_u8(vqtbl3q_u8(pairs, vld1q_u8(kComponentLookup[component])));
+
+		vst1q_u32((uint32_t*)row, vorrq_u32(components[0], vorrq_u32(vshlq_n_u32(components[1], 10), vshlq_n_u32(components[2], 20))));
+	}
+
+	packRowV210(pixels, row, width - x);
+}
+
+static void packRowBGRANEON(const uint16_t* pixels, uint8_t* row, uint32_t width)
+{
+	uint32_t x = 0;
+
+	for (; x + 8 <= width; x += 8, pixels += 32, row += 32)
+	{
+		// Colour components are rounded and saturated, alpha is truncated
+		uint16x8x4_t	unpacked = vld4q_u16(pixels);
+		uint8x8x4_t		bgra;
+
+		bgra.val[0] = vqrshrn_n_u16(unpacked.val[0], 2);
+		bgra.val[1] = vqrshrn_n_u16(unpacked.val[1], 2);
+		bgra.val[2] = vqrshrn_n_u16(unpacked.val[2], 2);
+		bgra.val[3] = vshrn_n_u16(unpacked.val[3], 2);
+		vst4_u8(row, bgra);
+	}
+
+	packRowBGRA(pixels, row, width - x);
+}
+
+// Weighted sum of B G R in Q12, with the same rounding as rgbToYCbCr
+static inline int32x4_t weightRGBNEON(int32x4_t b, int32x4_t g, int32x4_t r, int bWeight, int gWeight, int rWeight, int offset)
+{
+	int32x4_t sum = vmlaq_n_s32(vmlaq_n_s32(vmlaq_n_s32(vdupq_n_s32(2048), r, rWeight), g, gWeight), b, bWeight);
+	return vaddq_s32(vshrq_n_s32(sum, 12), vdupq_n_s32(offset));
+}
+
+static inline uint16x4_t multiplyAlphaNEON(uint16x4_t alpha, int32x4_t key)
+{
+	uint32x4_t product = vmulq_n_u32(vmulq_u32(vmovl_u16(alpha), vreinterpretq_u32_s32(key)), 1025);
+	return vmovn_u32(vrshrq_n_u32(product, 20));
+}
+
+static inline int32x4_t widenComponent(uint16x4_t component)
+{
+	return vreinterpretq_s32_u32(vmovl_u16(component));
+}
+
+static void applyLumaKeyNEON(uint16_t* pixels, uint32_t pixelCount, bool isRGB, const CompositorLayer& layer)
+{
+	LumaKeyRange	range = getLumaKeyRange(layer);
+	uint32_t		i = 0;
+
+	for (; i + 4 <= pixelCount; i += 4, pixels += 16)
+	{
+		uint16x4x4_t	components = vld4_u16(pixels);
+		int32x4_t		y;
+
+		if (isRGB)
+			y = weightRGBNEON(widenComponent(components.val[0]), widenComponent(components.val[1]), widenComponent(components.val[2]), 253, 2509, 746, 64);
+		else
+			y = widenComponent(components.val[0]);
+
+		int32x4_t difference = vminq_s32(vmaxq_s32(vsubq_s32(y, vdupq_n_s32(range.low)), vdupq_n_s32(0)), vdupq_n_s32(range.maxDifference));
+		int32x4_t key = vminq_s32(vshrq_n_s32(vmulq_n_s32(difference, range.scale), 16), vdupq_n_s32(1023));
+
+		components.val[3] = multiplyAlphaNEON(components.val[3], key);
+		vst4_u16(pixels, components);
+	}
+
+	applyLumaKey(pixels, pixelCount - i, isRGB, layer);
+}
+
+static void applyChromaKeyNEON(uint16_t* pixels, uint32_t pixelCount, bool isRGB, const CompositorLayer& layer)
+{
+	const float32x4_t	softness	= vdupq_n_f32(std::max(layer.keySoftness, 1.0f / 1023.0f));
+	const float32x4_t	chromaScale	= vdupq_n_f32(896.0f);
+	uint32_t			i = 0;
+
+	for (; i + 4 <= pixelCount; i += 4, pixels += 16)
+	{
+		uint16x4x4_t	components = vld4_u16(pixels);
+		int32x4_t		cb, cr;
+
+		if (isRGB)
+		{
+			int32x4_t b = widenComponent(components.val[0]);
+			int32x4_t g = widenComponent(components.val[1]);
+			int32x4_t r = widenComponent(components.val[2]);
+			cb = weightRGBNEON(b, g, r, 1794, -1383, -411, 512);
+			cr = weightRGBNEON(b, g, r, -165, -1629, 1794, 512);
+		}
+		else
+		{
+			cb = widenComponent(components.val[1]);
+			cr = widenComponent(components.val[2]);
+		}
+
+		float32x4_t cbDistance = vsubq_f32(vdivq_f32(vcvtq_f32_s32(vsubq_s32(cb, vdupq_n_s32(512))), chromaScale), vdupq_n_f32(layer.keyCb));
+		float32x4_t crDistance = vsubq_f32(vdivq_f32(vcvtq_f32_s32(vsubq_s32(cr, vdupq_n_s32(512))), chromaScale), vdupq_n_f32(layer.keyCr));
+		float32x4_t distance = vsqrtq_f32(vaddq_f32(vmulq_f32(cbDistance, cbDistance), vmulq_f32(crDistance, crDistance)));
+		float32x4_t key = vdivq_f32(vsubq_f32(distance, vdupq_n_f32(layer.keyTolerance)), softness);
+		key = vminq_f32(vmaxq_f32(key, vdupq_n_f32(0.0f)), vdupq_n_f32(1.0f));
+
+		components.val[3] = multiplyAlphaNEON(components.val[3], vcvtq_s32_f32(vaddq_f32(vmulq_n_f32(key, 1023.0f), vdupq_n_f32(0.5f))));
+		vst4_u16(pixels, components);
+	}
+
+	applyChromaKey(pixels, pixelCount - i, isRGB, layer);
+}
+#endif
+
+// CpuCompositor
+
+CpuCompositor::CpuCompositor(unsigned threadCount) :
+	m_stopWorkers(false)
+{
+	m_kernels = { "scalar", blendPixelsScalar, unpackRowUYVY, unpackRowV210, unpackRowBGRA,
+				  packRowUYVY, packRowV210, packRowBGRA, applyLumaKey, applyChromaKey };
+
+#if defined(__x86_64__) || defined(__i386__)
+	if (__builtin_cpu_supports("avx2"))
+	{
+		m_kernels = { "AVX2", blendPixelsAVX2, unpackRowUYVYAVX2, unpackRowV210AVX2, unpackRowBGRAAVX2,
+					  packRowUYVYAVX2, packRowV210AVX2, packRowBGRAAVX2, applyLumaKeyAVX2, applyChromaKeyAVX2 };
+	}
+#elif defined(__aarch64__)
+	m_kernels = { "NEON", blendPixelsNEON, unpackRowUYVYNEON, unpackRowV210NEON, unpackRowBGRANEON,
+				  packRowUYVYNEON, packRowV210NEON, packRowBGRANEON, applyLumaKeyNEON, applyChromaKeyNEON };
+#endif
+
+	if (threadCount == 0)
+		threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+
+	m_workerScratch.resize(threadCount - 1);
+
+	// Reserve for a frame from each thread so that composite() does not allocate once the callers are known
+	m_jobs.reserve(threadCount);
+	m_callerScratch.reserve(threadCount);
+
+	for (unsigned i = 0; i < threadCount - 1; i++)
+		m_workerThreads.emplace_back(&CpuCompositor::workerThread, this, i);
+}
+
+CpuCompositor::~CpuCompositor()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopWorkers = true;
+	}
+	m_workCondition.notify_all();
+
+	for (auto& worker : m_workerThreads)
+		worker.join();
+}
+
+const char* CpuCompositor::getKernelName() const
+{
+	return m_kernels.name;
+}
+
+bool CpuCompositor::isPixelFormatSupported(BMDPixelFormat pixelFormat)
+{
+	return (pixelFormat == bmdFormat8BitYUV) || (pixelFormat == bmdFormat10BitYUV) || (pixelFormat == bmdFormat8BitBGRA);
+}
+
+uint32_t CpuCompositor::getRowBytes(uint32_t width, BMDPixelFormat pixelFormat)
+{
+	switch (pixelFormat)
+	{
+		case bmdFormat8BitYUV:		return ((width + 1) / 2) * 4;
+		case bmdFormat10BitYUV:		return ((width + 47) / 48) * 128;
+		case bmdFormat8BitBGRA:		return width * 4;
+		default:					return 0;
+	}
+}
+
+void CpuCompositor::packRow(const uint16_t* pixels, uint32_t width, BMDPixelFormat pixelFormat, void* row)
+{
+	switch (pixelFormat)
+	{
+		case bmdFormat8BitYUV:		packRowUYVY(pixels, (uint8_t*)row, width);	break;
+		case bmdFormat10BitYUV:		packRowV210(pixels, (uint8_t*)row, width);	break;
+		case bmdFormat8BitBGRA:		packRowBGRA(pixels, (uint8_t*)row, width);	break;
+		default:					break;
+	}
+}
+
+CpuCompositor::UnpackFunction CpuCompositor::getUnpackFunction(BMDPixelFormat pixelFormat) const
+{
+	switch (pixelFormat)
+	{
+		case bmdFormat8BitYUV:		return m_kernels.unpackUYVY;
+		case bmdFormat10BitYUV:		return m_kernels.unpackV210;
+		default:					return m_kernels.unpackBGRA;
+	}
+}
+
+CpuCompositor::PackFunction CpuCompositor::getPackFunction(BMDPixelFormat pixelFormat) const
+{
+	switch (pixelFormat)
+	{
+		case bmdFormat8BitYUV:		return m_kernels.packUYVY;
+		case bmdFormat10BitYUV:		return m_kernels.packV210;
+		default:					return m_kernels.packBGRA;
+	}
+}
+
+bool CpuCompositor::composite(void* frame, uint32_t rowBytes, uint32_t width, uint32_t height, BMDPixelFormat pixelFormat, const std::vector<CompositorLayer>& layers)
+{
+	CompositeJob					job;
+	std::unique_ptr<ThreadScratch>	scratch;
+	uint32_t						band;
+
+	if (!frame || width == 0 || height == 0 || !isPixelFormatSupported(pixelFormat))
+		return false;
+
+	job.frame			= (uint8_t*)frame;
+	job.rowBytes		= rowBytes;
+	job.width			= width;
+	job.height			= height;
+	job.pixelFormat		= pixelFormat;
+	job.layers			= &layers;
+	job.maxLayerWidth	= 0;
+	job.bandCount		= (height + kBandRowCount - 1) / kBandRowCount;
+	job.nextBand		= 0;
+	job.completedBands	= 0;
+
+	for (auto& layer : layers)
+	{
+		if (!layer.pixels || !isPixelFormatSupported(layer.pixelFormat))
+			return false;
+
+		job.maxLayerWidth = std::max(job.maxLayerWidth, layer.width);
+	}
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	if (!m_callerScratch.empty())
+	{
+		scratch = std::move(m_callerScratch.back());
+		m_callerScratch.pop_back();
+	}
+	else
+	{
+		scratch.reset(new ThreadScratch());
+	}
+
+	// Queue the frame behind any others in progress, the workers finish older frames first
+	m_jobs.push_back(&job);
+	m_workCondition.notify_all();
+
+	while (claimBand(job, band))
+	{
+		lock.unlock();
+		compositeBand(job, *scratch, band);
+		lock.lock();
+
+		job.completedBands++;
+	}
+
+	m_doneCondition.wait(lock, [&] { return job.completedBands == job.bandCount; });
+
+	m_callerScratch.push_back(std::move(scratch));
+
+	return true;
+}
+
+bool CpuCompositor::claimBand(CompositeJob& job, uint32_t& band)
+{
+	if (job.nextBand == job.bandCount)
+		return false;
+
+	band = job.nextBand++;
+
+	// Once every band is claimed, the frame is no longer offered to the workers
+	if (job.nextBand == job.bandCount)
+		m_jobs.erase(std::find(m_jobs.begin(), m_jobs.end(), &job));
+
+	return true;
+}
+
+void CpuCompositor::workerThread(unsigned index)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	while (true)
+	{
+		m_workCondition.wait(lock, [&] { return m_stopWorkers || !m_jobs.empty(); });
+		if (m_stopWorkers)
+			break;
+
+		CompositeJob&	job = *m_jobs.front();
+		uint32_t		band;
+
+		claimBand(job, band);
+
+		lock.unlock();
+		compositeBand(job, m_workerScratch[index], band);
+		lock.lock();
+
+		if (++job.completedBands == job.bandCount)
+			m_doneCondition.notify_all();
+	}
+}
+
+void CpuCompositor::compositeBand(const CompositeJob& job, ThreadScratch& scratch, uint32_t band)
+{
+	uint32_t endRow = std::min((band + 1) * kBandRowCount, job.height);
+
+	if (scratch.frameRow.size() < job.width * kComponentsPerPixel)
+	{
+		scratch.frameRow.resize(job.width * kComponentsPerPixel);
+		scratch.layerRow.resize(job.width * kComponentsPerPixel);
+	}
+
+	if (scratch.sourceRow0.size() < job.maxLayerWidth * kComponentsPerPixel)
+	{
+		scratch.sourceRow0.resize(job.maxLayerWidth * kComponentsPerPixel);
+		scratch.sourceRow1.resize(job.maxLayerWidth * kComponentsPerPixel);
+	}
+
+	for (uint32_t row = band * kBandRowCount; row < endRow; row++)
+		compositeRow(job, scratch, row);
+}
+
+void CpuCompositor::compositeRow(const CompositeJob& job, ThreadScratch& scratch, uint32_t row)
+{
+	uint8_t*	frameRow = job.frame + (size_t)row * job.rowBytes;
+	bool		rowUnpacked = false;
+
+	for (auto& layer : *job.layers)
+	{
+		int64_t left = std::max((int64_t)layer.x, (int64_t)0);
+		int64_t right = std::min((int64_t)layer.x + layer.scaledWidth, (int64_t)job.width);
+
+		if (((int64_t)row < layer.y) || ((int64_t)row >= (int64_t)layer.y + layer.scaledHeight) || (left >= right) || (layer.opacity <= 0.0f))
+			continue;
+
+		// Only unpack and pack rows that have layers over them
+		if (!rowUnpacked)
+		{
+			getUnpackFunction(job.pixelFormat)(frameRow, scratch.frameRow.data(), job.width);
+			rowUnpacked = true;
+		}
+
+		const uint16_t* layerPixels = prepareLayerRow(job, scratch, layer, row, (uint32_t)left, (uint32_t)(right - left));
+		int16_t opacity = (int16_t)lroundf(std::min(layer.opacity, 1.0f) * 32767.0f);
+
+		m_kernels.blend(scratch.frameRow.data() + left * kComponentsPerPixel, layerPixels, (uint32_t)(right - left), opacity);
+	}
+
+	if (rowUnpacked)
+		getPackFunction(job.pixelFormat)(scratch.frameRow.data(), frameRow, job.width);
+}
+
+const uint16_t* CpuCompositor::prepareLayerRow(const CompositeJob& job, ThreadScratch& scratch, const CompositorLayer& layer, uint32_t row, uint32_t left, uint32_t count)
+{
+	const uint8_t*	pixels = (const uint8_t*)layer.pixels;
+	uint32_t		layerRow = row - layer.y;
+	uint32_t		layerColumn = left - layer.x;
+	uint16_t*		result;
+	UnpackFunction	unpack = getUnpackFunction(layer.pixelFormat);
+
+	if ((layer.scaledWidth == layer.width) && (layer.scaledHeight == layer.height))
+	{
+		unpack(pixels + (size_t)layerRow * layer.rowBytes, scratch.sourceRow0.data(), layer.width);
+		result = scratch.sourceRow0.data() + layerColumn * kComponentsPerPixel;
+	}
+	else
+	{
+		// Bilinear scaling with 8-bit weights, positions are sampled at pixel centres
+		int64_t		sourceY = ((int64_t)(2 * layerRow + 1) * layer.height * 128) / layer.scaledHeight - 128;
+		uint32_t	y0 = (sourceY < 0) ? 0 : std::min((uint32_t)(sourceY >> 8), layer.height - 1);
+		uint32_t	y1 = std::min(y0 + 1, layer.height - 1);
+		int			yWeight = (sourceY < 0) ? 0 : (int)(sourceY & 0xff);
+		uint16_t*	source0 = scratch.sourceRow0.data();
+		uint16_t*	source1 = scratch.sourceRow1.data();
+
+		unpack(pixels + (size_t)y0 * layer.rowBytes, source0, layer.width);
+
+		if ((yWeight != 0) && (y1 != y0))
+		{
+			unpack(pixels + (size_t)y1 * layer.rowBytes, source1, layer.width);
+
+			for (uint32_t i = 0; i < layer.width * kComponentsPerPixel; i++)
+				source0[i] += ((source1[i] - source0[i]) * yWeight + 128) >> 8;
+		}
+
+		int64_t	step = ((int64_t)layer.width << 16) / layer.scaledWidth;
+		int64_t	sourceX = ((int64_t)(2 * layerColumn + 1) * layer.width * 32768) / layer.scaledWidth - 32768;
+
+		result = scratch.layerRow.data();
+
+		for (uint32_t i = 0; i < count; i++, sourceX += step)
+		{
+			uint32_t	x0 = (sourceX < 0) ? 0 : std::min((uint32_t)(sourceX >> 16), layer.width - 1);
+			uint32_t	x1 = std::min(x0 + 1, layer.width - 1);
+			int			xWeight = (sourceX < 0) ? 0 : (int)((sourceX >> 8) & 0xff);
+			uint16_t*	p0 = source0 + x0 * kComponentsPerPixel;
+			uint16_t*	p1 = source0 + x1 * kComponentsPerPixel;
+
+			for (unsigned component = 0; component < kComponentsPerPixel; component++)
+				result[i * kComponentsPerPixel + component] = p0[component] + (((p1[component] - p0[component]) * xWeight + 128) >> 8);
+		}
+	}
+
+	bool isRGB = isRGBFormat(job.pixelFormat);
+
+	if (isRGBFormat(layer.pixelFormat) != isRGB)
+	{
+		if (isRGB)
+			convertRowYUVToRGB(result, count);
+		else
+			convertRowRGBToYUV(result, count);
+	}
+
+	if (layer.key == CompositorKey::Luma)
+		m_kernels.lumaKey(result, count, isRGB, layer);
+	else if (layer.key == CompositorKey::Chroma)
+		m_kernels.chromaKey(result, count, isRGB, layer);
+
+	return result;
+}
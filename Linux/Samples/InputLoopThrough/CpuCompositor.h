@@ -0,0 +1,182 @@
+/* -LICENSE-START-
+** Copyright (c) 2022 Blackmagic Design
+**  
+** Permission is hereby granted, free of charge, to any person or organization 
+** obtaining a copy of the software and accompanying documentation (the 
+** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+** and transmit the Software, and to prepare derivative works of the Software, 
+** and to permit third-parties to whom the Software is furnished to do so, in 
+** accordance with:
+** 
+** (1) if the Software is obtained from Blackmagic Design, the End User License 
+** Agreement for the Software Development Kit (“EULA”) available at 
+** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+** 
+** (2) if the Software is obtained from any third party, such licensing terms 
+** as notified by that third party,
+** 
+** and all subject to the following:
+** 
+** (3) the copyright notices in the Software and this entire statement, 
+** including the above license grant, this restriction and the following 
+** disclaimer, must be included in all copies of the Software, in whole or in 
+** part, and all derivative works of the Software, unless such copies or 
+** derivative works are solely in the form of machine-executable object code 
+** generated by a source language processor.
+** 
+** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+** DEALINGS IN THE SOFTWARE.
+** 
+** A copy of the Software is available free of charge at 
+** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+** 
+** -LICENSE-END-
+*/
+
+#pragma once
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+#include "DeckLinkAPI.h"
+
+enum class CompositorKey
+{
+	None,
+	Luma,					// Transparent below keyLow, opaque above keyHigh
+	Chroma,					// Transparent within keyTolerance of the key colour, opaque beyond keyTolerance + keySoftness
+};
+
+// A layer is drawn over the frame at position (x, y), scaled to scaledWidth x scaledHeight.  The pixels are
+// not copied, they must remain valid until composite() returns.  BGRA layers use their alpha channel, YUV
+// layers are opaque.  Layers may have a different pixel format to the frame, they are converted between
+// Rec.709 YCbCr and RGB as needed.
+struct CompositorLayer
+{
+	const void*			pixels;
+	uint32_t			rowBytes;
+	uint32_t			width;
+	uint32_t			height;
+	BMDPixelFormat		pixelFormat;
+
+	int32_t				x;
+	int32_t				y;
+	uint32_t			scaledWidth;
+	uint32_t			scaledHeight;
+
+	float				opacity;			// 0.0 to 1.0, multiplied with the layer alpha
+
+	CompositorKey		key;
+	float				keyLow;				// Luma key thresholds, 0.0 (black) to 1.0 (white)
+	float				keyHigh;
+	float				keyCb;				// Chroma key colour, -0.5 to 0.5
+	float				keyCr;
+	float				keyTolerance;		// Chroma key distance in the CbCr plane
+	float				keySoftness;
+};
+
+// The CpuCompositor blends layers over 8-bit YUV, 10-bit YUV or 8-bit BGRA frames without a GPU.
+//
+// Each frame is split into bands of rows which are processed in parallel by a pool of worker threads and the
+// calling thread.  Each row is unpacked to 16 bits per component with one alpha component per pixel (Y Cb Cr A
+// for YUV frames, B G R A for BGRA frames, all as 10-bit values), each layer is scaled, converted and keyed
+// into the same layout and blended over the row, and the row is packed back into the frame.  Unpacking, keying,
+// blending and packing use AVX2 or NEON when the CPU supports it.
+//
+// Several threads may composite frames at once, eg. one for each video dispatch thread.  The bands of every frame
+// in progress are shared with the workers, oldest frame first, so concurrent frames are composited in parallel
+// rather than in turn.
+class CpuCompositor
+{
+public:
+	// threadCount is the number of threads compositing each frame including the thread calling composite(),
+	// 0 uses one thread per CPU
+	CpuCompositor(unsigned threadCount = 0);
+	virtual ~CpuCompositor();
+
+	// Blend layers in order over the frame, in place.  Thread-safe, returns false if the frame or a layer has an
+	// unsupported pixel format.
+	bool				composite(void* frame, uint32_t rowBytes, uint32_t width, uint32_t height, BMDPixelFormat pixelFormat, const std::vector<CompositorLayer>& layers);
+
+	unsigned			getThreadCount(void) const { return (unsigned)m_workerThreads.size() + 1; }
+	const char*			getKernelName(void) const;
+
+	static bool			isPixelFormatSupported(BMDPixelFormat pixelFormat);
+	static uint32_t		getRowBytes(uint32_t width, BMDPixelFormat pixelFormat);
+
+	// Pack a row of pixels in the compositor's working layout (4 x uint16_t per pixel, see above) to a pixel format
+	static void			packRow(const uint16_t* pixels, uint32_t width, BMDPixelFormat pixelFormat, void* row);
+
+private:
+	using BlendFunction = void (*)(uint16_t* destination, const uint16_t* source, uint32_t pixelCount, int16_t opacity);
+	using UnpackFunction = void (*)(const uint8_t* row, uint16_t* pixels, uint32_t width);
+	using PackFunction = void (*)(const uint16_t* pixels, uint8_t* row, uint32_t width);
+	using KeyFunction = void (*)(uint16_t* pixels, uint32_t pixelCount, bool isRGB, const CompositorLayer& layer);
+
+	// Kernels selected for the CPU when the compositor is created
+	struct Kernels
+	{
+		const char*		name;
+		BlendFunction	blend;
+		UnpackFunction	unpackUYVY;
+		UnpackFunction	unpackV210;
+		UnpackFunction	unpackBGRA;
+		PackFunction	packUYVY;
+		PackFunction	packV210;
+		PackFunction	packBGRA;
+		KeyFunction		lumaKey;
+		KeyFunction		chromaKey;
+	};
+
+	// Working rows, allocated when the frame or layers grow so compositing does not allocate.  Each worker has its
+	// own, and each thread calling composite() takes one from m_callerScratch for the duration of the call.
+	struct ThreadScratch
+	{
+		std::vector<uint16_t>	frameRow;
+		std::vector<uint16_t>	layerRow;
+		std::vector<uint16_t>	sourceRow0;
+		std::vector<uint16_t>	sourceRow1;
+	};
+
+	// A frame being composited, owned by the composite() call
+	struct CompositeJob
+	{
+		uint8_t*							frame;
+		uint32_t							rowBytes;
+		uint32_t							width;
+		uint32_t							height;
+		BMDPixelFormat						pixelFormat;
+		const std::vector<CompositorLayer>*	layers;
+		uint32_t							maxLayerWidth;
+		uint32_t							bandCount;
+		uint32_t							nextBand;			// Guarded by m_mutex
+		uint32_t							completedBands;		// Guarded by m_mutex
+	};
+
+	Kernels										m_kernels;
+	std::vector<ThreadScratch>					m_workerScratch;
+	//
+	std::vector<std::thread>					m_workerThreads;
+	std::mutex									m_mutex;
+	std::condition_variable						m_workCondition;
+	std::condition_variable						m_doneCondition;
+	std::vector<CompositeJob*>					m_jobs;				// Frames with unclaimed bands, oldest first
+	std::vector<std::unique_ptr<ThreadScratch>>	m_callerScratch;	// Scratch rows not in use by a composite() call
+	bool										m_stopWorkers;
+
+	void				workerThread(unsigned index);
+	bool				claimBand(CompositeJob& job, uint32_t& band);
+	void				compositeBand(const CompositeJob& job, ThreadScratch& scratch, uint32_t band);
+	void				compositeRow(const CompositeJob& job, ThreadScratch& scratch, uint32_t row);
+	const uint16_t*		prepareLayerRow(const CompositeJob& job, ThreadScratch& scratch, const CompositorLayer& layer, uint32_t row, uint32_t left, uint32_t count);
+	UnpackFunction		getUnpackFunction(BMDPixelFormat pixelFormat) const;
+	PackFunction		getPackFunction(BMDPixelFormat pixelFormat) const;
+};
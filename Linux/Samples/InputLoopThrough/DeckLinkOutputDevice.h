@@ -86,6 +86,7 @@ public:
 
 	void						cancelWaitForReference();
 
+	BMDTimeValue				getFrameDuration(void) const { return m_frameDuration; }
 	BMDTimeScale				getFrameTimescale(void) const { return m_frameTimescale; }
 	com_ptr<IDeckLinkOutput>	getDeckLinkOutput(void) const { return m_deckLinkOutput; }
 	bool						getReferenceSignalMode(BMDDisplayMode* mode);
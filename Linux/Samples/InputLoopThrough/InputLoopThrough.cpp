@@ -68,9 +68,20 @@
 // * Ensure that a valid input source is provided with a display mode that is supported by
 //     both input and output devices
 // * Out of the box, the video processing thread, defined by function processVideo(),
-//     injects a random sleep time into the pipeline.  The time's mean and standard
-//     deviation can be adjusted by constants kProcessingAdditionalTimeMean and
-//     kProcessingAdditionalTimeStdDev respectively
+//     composites a picture-in-picture, a lower third and a keyed logo over 8-bit YUV,
+//     10-bit YUV and 8-bit BGRA frames with the CPU compositor (see CpuCompositor.h).
+//     When kCompositeOverlays is false, or for other pixel formats, it instead injects a
+//     random sleep time into the pipeline.  The time's mean and standard deviation can be
+//     adjusted by constants kProcessingAdditionalTimeMean and kProcessingAdditionalTimeStdDev
+//     respectively
+// * Run with --benchmark to measure the compositor's frame rate without DeckLink devices
+// * Captured audio is metered in the input callback by AudioLevelMeter (see AudioLevelMeter.h).  Each channel's
+//     peak, RMS and true-peak, and the programme loudness, are published as metrics every
+//     kAudioLevelUpdateRateMs.  Loudness is measured for channels 1-2, or for the mono, stereo, 5.1
+//     or 7.1 channel group selected with --loudness-channels.  Run with --audio-benchmark to measure
+//     the metering cost
+// * Run with --captions to decode the CEA-708 captions in the ancillary data of each captured frame (see
+//     CaptionDecoder.h), printing their text and commands and a once a second summary of caption presence
 // * The sample has 2 console output modes of operation, defined by constant kPrintRollingAverage
 //   - When set to true, a rolling average of latency is displayed to stdout with ms
 //     interval defined by constant kRollingAverageUpdateRateMs with rolling average
@@ -78,11 +89,22 @@
 //   - When set to false, the latency for every output frame is displayed to stdout
 //   - In both modes or operation, a full statistical summary is displayed when application
 //     completes
+// * Each stage of the pipeline for every video frame and audio packet is recorded as a trace span.
+//     The most recent kTraceSpanCapacity spans are written in Chrome trace JSON format to the
+//     file defined by constant kTraceFilePath when the process receives SIGUSR1, and on exit
+//     when kWriteTraceOnExit is true.  Open the file with chrome://tracing or ui.perfetto.dev
+// * Capture and playout counters and latency histograms are served in Prometheus text format
+//     at http://localhost:<port>/metrics, and published as a binary snapshot (see MetricsServer.h)
+//     to a POSIX shared memory object.  The port and object name default to kDefaultMetricsHttpPort
+//     and kDefaultMetricsSharedMemoryName, and can be set with --metrics-port and --metrics-shm so
+//     that several instances can run side by side.  The application exits if either is in use
 //*************************************************************************************/
 
 
+#include <cerrno>
 #include <chrono>
 #include <condition_variable>
+#include <csignal>
 #include <functional>
 #include <map>
 #include <memory>
@@ -90,12 +112,22 @@
 #include <random>
 #include <thread>
 
+#include "AsyncLogger.h"
+#include "AudioLevelMeter.h"
+#include "AudioLevelMeterBenchmark.h"
+#include "CaptionDecoder.h"
+#include "CompositorBenchmark.h"
+#include "CompositorScene.h"
+#include "CpuCompositor.h"
 #include "DeckLinkInputDevice.h"
 #include "DeckLinkOutputDevice.h"
 #include "DispatchQueue.h"
 #include "SampleQueue.h"
 #include "LatencyStatistics.h"
+#include "MetricsRegistry.h"
+#include "MetricsServer.h"
 #include "ReferenceTime.h"
+#include "TraceRecorder.h"
 #include "DeckLinkAPI.h"
 #include "com_ptr.h"
 #include "platform.h"
@@ -109,12 +141,24 @@ const bool					kWaitForReferenceToLock		= true;		// True if reference lock shoul
 const int					kOutputVideoPreroll			= 1;		// number of output preroll frames
 const int					kVideoDispatcherThreadCount	= 3;		// number of threads used by video processing dispatcher
 const int					kAudioDispatcherThreadCount	= 2;		// number of threads used by audio processing dispatcher
-const int					kPrintDispatcherThreadCount	= 1;		// number of threads used by print stdout dispatcher
 
 const bool					kPrintRollingAverage		= true;		// If true, display latency as rolling average, if false print latency for each frame
 const int					kRollingAverageSampleCount	= 300;		// Number of samples for calculating rolling average of latency
 const long					kRollingAverageUpdateRateMs	= 2000;		// Print rolling average every 2 seconds
 
+const size_t				kTraceSpanCapacity			= 65536;	// Number of most recent pipeline trace spans retained
+const char*					kTraceFilePath				= "InputLoopThrough.trace.json";
+const bool					kWriteTraceOnExit			= true;		// If true, write pipeline trace when application completes
+const long					kTraceRequestPollRateMs		= 100;		// Period to check for trace requests from SIGUSR1
+
+const uint16_t				kDefaultMetricsHttpPort			= 9464;		// Localhost port for Prometheus scraping
+const char*					kDefaultMetricsSharedMemoryName	= "/InputLoopThrough.metrics";
+const int					kMetricsSnapshotIntervalMs	= 1000;		// Period to update shared memory metrics snapshot
+const long					kAudioLevelUpdateRateMs		= 100;		// Period to publish audio level metrics
+
+const bool					kCompositeOverlays			= true;		// If true, composite overlay layers over each frame with the CPU compositor
+const unsigned				kCompositorThreadCount		= 0;		// Number of threads used to composite each frame, 0 for one per CPU
+
 const double				kProcessingAdditionalTimeMean		= 5.0;		// Mean additional time injected into video processing thread (ms)
 const double				kProcessingAdditionalTimeStdDev		= 0.1;		// Standard deviation of time injected into video processing thread (ms)
 
@@ -141,6 +185,9 @@ const std::map<BMDPixelFormat, const char*> kPixelFormats =
 	{ bmdFormat10BitRGBX,	"10-bit RGBX" },
 };
 
+// Latency histogram bucket upper bounds (ms)
+const std::vector<double>	kLatencyHistogramBuckets	= { 0.5, 1.0, 2.0, 4.0, 8.0, 16.0, 33.0, 50.0, 100.0, 200.0, 500.0 };
+
 struct ThreadNotifier
 {
 	std::mutex mutex;
@@ -194,6 +241,78 @@ std::normal_distribution<double> 								g_sleepDistribution(kProcessingAddition
 
 ThreadNotifier													g_printRollingAverageNotifier;
 ThreadNotifier													g_loopThroughSessionNotifier;
+ThreadNotifier													g_traceRequestNotifier;
+ThreadNotifier													g_audioLevelsNotifier;
+
+TraceRecorder													g_traceRecorder(kTraceSpanCapacity);
+volatile std::sig_atomic_t										g_traceRequested = 0;
+
+MetricsRegistry													g_metricsRegistry;
+
+MetricCounter&													g_droppedOnCaptureFramesMetric = g_metricsRegistry.addCounter("decklink_capture_dropped_frames_total", "Number of input frames dropped on capture");
+MetricGauge&													g_loopThroughActiveMetric = g_metricsRegistry.addGauge("decklink_loopthrough_active", "Set to 1 while loop-through session is running");
+MetricHistogram&												g_videoInputLatencyMetric = g_metricsRegistry.addHistogram("decklink_video_latency_milliseconds", "Video latency for each pipeline stage", kLatencyHistogramBuckets, "stage=\"input\"");
+MetricHistogram&												g_videoProcessingLatencyMetric = g_metricsRegistry.addHistogram("decklink_video_latency_milliseconds", "Video latency for each pipeline stage", kLatencyHistogramBuckets, "stage=\"processing\"");
+MetricHistogram&												g_videoOutputLatencyMetric = g_metricsRegistry.addHistogram("decklink_video_latency_milliseconds", "Video latency for each pipeline stage", kLatencyHistogramBuckets, "stage=\"output\"");
+MetricHistogram&												g_audioProcessingLatencyMetric = g_metricsRegistry.addHistogram("decklink_audio_processing_latency_milliseconds", "Audio packet processing latency", kLatencyHistogramBuckets);
+MetricFloatGauge&												g_momentaryLoudnessMetric = g_metricsRegistry.addFloatGauge("decklink_audio_loudness_lufs", "BS.1770 programme loudness", "window=\"momentary\"");
+MetricFloatGauge&												g_shortTermLoudnessMetric = g_metricsRegistry.addFloatGauge("decklink_audio_loudness_lufs", "BS.1770 programme loudness", "window=\"short_term\"");
+MetricFloatGauge&												g_integratedLoudnessMetric = g_metricsRegistry.addFloatGauge("decklink_audio_loudness_lufs", "BS.1770 programme loudness", "window=\"integrated\"");
+
+// Output frame completion result counters, the map is not modified after initialization so can be read without locking
+const std::map<BMDOutputFrameCompletionResult, MetricCounter*>	g_outputCompletionResultMetrics = []
+{
+	std::map<BMDOutputFrameCompletionResult, MetricCounter*> metrics;
+	for (auto& completionResult : kOutputCompletionResults)
+	{
+		std::string label = std::string("result=\"") + completionResult.second.first + "\"";
+		metrics[completionResult.first] = &g_metricsRegistry.addCounter("decklink_output_frames_total", "Number of output frames by completion result", label);
+	}
+	return metrics;
+}();
+
+// Audio level gauges for each channel that can be captured, levels are since the previous update
+struct AudioChannelMetrics
+{
+	MetricFloatGauge*	peak;
+	MetricFloatGauge*	rms;
+	MetricFloatGauge*	truePeak;
+};
+
+const std::vector<AudioChannelMetrics>							g_audioChannelMetrics = []
+{
+	std::vector<AudioChannelMetrics> metrics;
+	for (uint32_t channel = 1; channel <= kDefaultAudioChannelCount; channel++)
+	{
+		std::string label = "channel=\"" + std::to_string(channel) + "\"";
+		metrics.push_back({ &g_metricsRegistry.addFloatGauge("decklink_audio_peak_dbfs", "Audio sample peak level", label),
+							&g_metricsRegistry.addFloatGauge("decklink_audio_rms_dbfs", "Audio RMS level", label),
+							&g_metricsRegistry.addFloatGauge("decklink_audio_true_peak_dbtp", "Audio 4x oversampled true-peak level", label) });
+	}
+	return metrics;
+}();
+
+// Captured audio is metered in stream order by the input callback thread
+AudioLevelMeter													g_audioLevelMeter;
+
+// Captions are decoded in stream order by the input callback thread when enabled with --captions
+bool															g_decodeCaptions = false;
+CaptionDecoder													g_captionDecoder;
+unsigned														g_captionFrameCount = 0;
+
+// Metrics endpoints, set with --metrics-port and --metrics-shm
+uint16_t														g_metricsHttpPort = kDefaultMetricsHttpPort;
+std::string														g_metricsSharedMemoryName = kDefaultMetricsSharedMemoryName;
+int64_t															g_captionDecodeTotalNs = 0;
+int64_t															g_captionDecodeMaxNs = 0;
+
+// Overlay layers are recreated by the first frame processed after a format change.  A scene is not modified once
+// configured, frames composite from the scene current when they started, which the shared_ptr keeps alive.
+std::shared_ptr<const CompositorScene>							g_compositorScene;
+std::mutex														g_compositorSceneMutex;
+
+// Console output is deferred to the logger thread, so that printing never blocks callback or processing threads
+AsyncLogger														g_logger;
 
 struct FormatDescription
 {
@@ -212,18 +331,122 @@ bool operator!=(const FormatDescription& desc1, const FormatDescription& desc2)
 	return !operator==(desc1, desc2);
 }
 
-template<typename... Args>
-void dispatch_printf(DispatchQueue& dispatchQueue, const char* format, Args... args)
+bool compositeOverlays(IDeckLinkVideoFrame* videoFrame)
 {
-	int size = snprintf(NULL, 0, format, args...);
-	char* buf = new char[size + 1];
-	snprintf(buf, size + 1, format, args...);
+	// Composite the overlay layers over the captured frame in place, the captured frame is then scheduled for output.
+	// Returns false if compositing is disabled or the pixel format is not supported by the compositor.
+	void*				frameBytes;
+	uint32_t			width = (uint32_t)videoFrame->GetWidth();
+	uint32_t			height = (uint32_t)videoFrame->GetHeight();
+	BMDPixelFormat		pixelFormat = videoFrame->GetPixelFormat();
+
+	if (!kCompositeOverlays || !CpuCompositor::isPixelFormatSupported(pixelFormat) || (videoFrame->GetBytes(&frameBytes) != S_OK))
+		return false;
+
+	// The compositor threads are only started once the first frame is composited.  Frames from each dispatch thread
+	// are composited concurrently, sharing the compositor's threads.
+	static CpuCompositor compositor(kCompositorThreadCount);
 
-	dispatchQueue.dispatch([=]
+	std::shared_ptr<const CompositorScene> scene;
 	{
-		fprintf(stdout, "%s", buf);
-		delete [] buf;
-	});
+		// Only the scene lookup is locked, so that a format change is not held up behind a frame being composited
+		std::lock_guard<std::mutex> lock(g_compositorSceneMutex);
+
+		if (!g_compositorScene || !g_compositorScene->isConfiguredFor(width, height, pixelFormat))
+		{
+			std::shared_ptr<CompositorScene> newScene = std::make_shared<CompositorScene>();
+			if (!newScene->configure(width, height, pixelFormat))
+				return false;
+			g_compositorScene = newScene;
+		}
+		scene = g_compositorScene;
+	}
+
+	return compositor.composite(frameBytes, (uint32_t)videoFrame->GetRowBytes(), width, height, pixelFormat, scene->getLayers());
+}
+
+// Convert CEA-708 G0/G1 caption text (ASCII with a music note at 0x7F, then Latin-1) to UTF-8
+void captionTextToUTF8(const uint8_t* text, size_t length, char* utf8, size_t utf8Size)
+{
+	size_t out = 0;
+
+	for (size_t i = 0; i < length; i++)
+	{
+		uint8_t c = text[i];
+		size_t	size = (c == 0x7F) ? 3 : (c >= 0x80) ? 2 : 1;
+
+		if (out + size >= utf8Size)
+			break;
+
+		if (c == 0x7F)
+		{
+			utf8[out++] = (char)0xE2;
+			utf8[out++] = (char)0x99;
+			utf8[out++] = (char)0xAA;
+		}
+		else if (c >= 0x80)
+		{
+			utf8[out++] = (char)(0xC0 | (c >> 6));
+			utf8[out++] = (char)(0x80 | (c & 0x3F));
+		}
+		else
+			utf8[out++] = (char)c;
+	}
+
+	utf8[out] = '\0';
+}
+
+
+void decodeCaptions(IDeckLinkVideoFrame* videoFrame)
+{
+	// Decode the caption CDP of each captured frame, the decoder tracks CDP and DTVCC sequence counters so frames
+	// must be decoded in stream order
+	auto	startTime = std::chrono::steady_clock::now();
+	bool	decoded = g_captionDecoder.decode(videoFrame);
+	int64_t	decodeNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - startTime).count();
+
+	g_captionDecodeTotalNs += decodeNs;
+	g_captionDecodeMaxNs = std::max(g_captionDecodeMaxNs, decodeNs);
+
+	for (size_t i = 0; i < g_captionDecoder.getElementCount(); i++)
+	{
+		const CaptionElement& element = g_captionDecoder.getElement(i);
+
+		if (element.type == CaptionElement::kText)
+		{
+			char text[LogString::kMaxLength + 1];
+			captionTextToUTF8(element.bytes, element.length, text, sizeof(text));
+			g_logger.log("Captions: service %u \"%s\"\n", (unsigned)element.serviceNumber, LogString(text));
+		}
+		else
+		{
+			const char* name = CaptionDecoder::getCommandName(element.code);
+			if (name != nullptr)
+				g_logger.log("Captions: service %u %s\n", (unsigned)element.serviceNumber, name);
+			else
+				g_logger.log("Captions: service %u command 0x%02x\n", (unsigned)element.serviceNumber, (unsigned)element.code);
+		}
+	}
+
+	// Report caption presence and decode time once a second
+	double		frameRate = g_captionDecoder.getFrameRate();
+	unsigned	framesPerSecond = (frameRate > 0.0) ? (unsigned)(frameRate + 0.5) : 30;
+
+	if (++g_captionFrameCount < framesPerSecond)
+		return;
+
+	const CaptionDecoder::Statistics& statistics = g_captionDecoder.getStatistics();
+
+	g_logger.log("Captions: %s, last caption data %lld frames ago, decode %lld ns average %lld ns max, errors %llu CDP, %llu CDP sequence, %llu DTVCC\n",
+		!decoded ? "no CDP" : g_captionDecoder.isCaptionServiceActive() ? "service active" : "no active service",
+		(long long)g_captionDecoder.getFramesSinceCaptionData(),
+		(long long)(g_captionDecodeTotalNs / g_captionFrameCount), (long long)g_captionDecodeMaxNs,
+		(unsigned long long)statistics.invalidCDPs, (unsigned long long)statistics.sequenceErrors,
+		(unsigned long long)(statistics.dtvccPacketErrors + statistics.dtvccSequenceErrors));
+
+	g_captionFrameCount = 0;
+	g_captionDecodeTotalNs = 0;
+	g_captionDecodeMaxNs = 0;
 }
 
 void processVideo(std::shared_ptr<LoopThroughVideoFrame>& videoFrame, com_ptr<DeckLinkOutputDevice>& deckLinkOutput)
@@ -240,13 +463,20 @@ void processVideo(std::shared_ptr<LoopThroughVideoFrame>& videoFrame, com_ptr<De
 	if (!deckLinkOutput->isPlaybackActive())
 		return;
 
-	// Simulate doing something by using a busy wait loop
-	// This is more precise than sleeping
-	int delay = (int)std::round(g_sleepDistribution(g_randomEngine) * 1000);
-	auto target = std::chrono::steady_clock::now() + std::chrono::microseconds(delay);
-	uint32_t i = 0;
-	while (std::chrono::steady_clock::now() < target)
-		++i;
+	videoFrame->setProcessingStartReferenceTime(ReferenceTime::getSteadyClockUptimeCount());
+
+	if (!compositeOverlays(videoFrame->getVideoFramePtr()))
+	{
+		// Simulate doing something by using a busy wait loop
+		// This is more precise than sleeping
+		int delay = (int)std::round(g_sleepDistribution(g_randomEngine) * 1000);
+		auto target = std::chrono::steady_clock::now() + std::chrono::microseconds(delay);
+		uint32_t i = 0;
+		while (std::chrono::steady_clock::now() < target)
+			++i;
+	}
+
+	videoFrame->setProcessingEndReferenceTime(ReferenceTime::getSteadyClockUptimeCount());
 
 	// At end of function, remember to queue your output frame
 	deckLinkOutput->scheduleVideoFrame(std::move(videoFrame));
@@ -267,6 +497,8 @@ void processAudio(std::shared_ptr<LoopThroughAudioPacket>& audioPacket, com_ptr<
 	if (!deckLinkOutput->isPlaybackActive())
 		return;
 
+	audioPacket->setProcessingStartReferenceTime(ReferenceTime::getSteadyClockUptimeCount());
+
 	// Simulate doing something by using a busy wait loop
 	// This is more precise than sleeping
 	int delay = (int)std::round(g_sleepDistribution(g_randomEngine) * 1000);
@@ -275,6 +507,8 @@ void processAudio(std::shared_ptr<LoopThroughAudioPacket>& audioPacket, com_ptr<
 	while (std::chrono::steady_clock::now() < target)
 		++i;
 	
+	audioPacket->setProcessingEndReferenceTime(ReferenceTime::getSteadyClockUptimeCount());
+
 	// At end of function, remember to queue your output audio packet
 	deckLinkOutput->scheduleAudioPacket(std::move(audioPacket));
 }
@@ -297,15 +531,16 @@ std::string getDeckLinkDisplayName(com_ptr<IDeckLink> deckLink)
 	return displayNameString;
 }
 
-void printDroppedCaptureFrame(BMDTimeValue streamTime, BMDTimeValue frameDuration, DispatchQueue& printDispatchQueue)
+void printDroppedCaptureFrame(BMDTimeValue streamTime, BMDTimeValue frameDuration)
 {
 	++g_droppedOnCaptureFrameCount;
+	g_droppedOnCaptureFramesMetric.increment();
 
 	if (!kPrintRollingAverage)
-		dispatch_printf(printDispatchQueue, "Frame %d (dropped);\n", streamTime / frameDuration);
+		g_logger.log("Frame %lld (dropped);\n", (long long)(streamTime / frameDuration));
 }
 
-void printOutputCompletionResult(std::shared_ptr<LoopThroughVideoFrame> completedFrame, DispatchQueue& printDispatchQueue)
+void printOutputCompletionResult(std::shared_ptr<LoopThroughVideoFrame> completedFrame)
 {
 	const char*		completionResultString;
 	bool			frameDisplayed;
@@ -321,20 +556,40 @@ void printOutputCompletionResult(std::shared_ptr<LoopThroughVideoFrame> complete
 
 	if (frameDisplayed)
 	{
-		dispatch_printf(printDispatchQueue,
-						"Frame %d (%s); Latency: Input = %.2f ms, Processing = %.2f ms, Output = %.2f ms\n",
-						completedFrame->getVideoStreamTime() / completedFrame->getVideoFrameDuration(), completionResultString,
+		g_logger.log("Frame %lld (%s); Latency: Input = %.2f ms, Processing = %.2f ms, Output = %.2f ms\n",
+						(long long)(completedFrame->getVideoStreamTime() / completedFrame->getVideoFrameDuration()), completionResultString,
 						(double)completedFrame->getInputLatency() / ReferenceTime::kTicksPerMilliSec,
 						(double)completedFrame->getProcessingLatency() / ReferenceTime::kTicksPerMilliSec,
 						(double)completedFrame->getOutputLatency() / ReferenceTime::kTicksPerMilliSec);
 	}
 	else
 	{
-		dispatch_printf(printDispatchQueue, "Frame %d (%s);\n", completedFrame->getVideoStreamTime() / completedFrame->getVideoFrameDuration(), completionResultString);
+		g_logger.log("Frame %lld (%s);\n", (long long)(completedFrame->getVideoStreamTime() / completedFrame->getVideoFrameDuration()), completionResultString);
 	}
 }
 
-void updateCompletedFrameLatency(std::shared_ptr<LoopThroughVideoFrame> completedFrame, DispatchQueue& printDispatchQueue)
+void traceCompletedFrame(const std::shared_ptr<LoopThroughVideoFrame>& completedFrame)
+{
+	int64_t frameNumber = completedFrame->getVideoStreamTime() / completedFrame->getVideoFrameDuration();
+
+	g_traceRecorder.addSpan(TraceStage::VideoInput, frameNumber, completedFrame->getInputFrameStartReferenceTime(), completedFrame->getInputFrameArrivedReferenceTime());
+	g_traceRecorder.addSpan(TraceStage::VideoCallback, frameNumber, completedFrame->getInputFrameArrivedReferenceTime(), completedFrame->getInputFrameDispatchedReferenceTime());
+	g_traceRecorder.addSpan(TraceStage::VideoDispatchWait, frameNumber, completedFrame->getInputFrameDispatchedReferenceTime(), completedFrame->getProcessingStartReferenceTime());
+	g_traceRecorder.addSpan(TraceStage::VideoProcessing, frameNumber, completedFrame->getProcessingStartReferenceTime(), completedFrame->getProcessingEndReferenceTime());
+	g_traceRecorder.addSpan(TraceStage::VideoScheduleWait, frameNumber, completedFrame->getProcessingEndReferenceTime(), completedFrame->getOutputFrameScheduledReferenceTime());
+	g_traceRecorder.addSpan(TraceStage::VideoOutput, frameNumber, completedFrame->getOutputFrameScheduledReferenceTime(), completedFrame->getOutputFrameCompletedReferenceTime());
+}
+
+void traceScheduledAudioPacket(const std::shared_ptr<LoopThroughAudioPacket>& audioPacket, BMDTimeValue frameDuration)
+{
+	int64_t frameNumber = audioPacket->getAudioStreamTime() / frameDuration;
+
+	g_traceRecorder.addSpan(TraceStage::AudioDispatchWait, frameNumber, audioPacket->getInputPacketArrivedReferenceTime(), audioPacket->getProcessingStartReferenceTime());
+	g_traceRecorder.addSpan(TraceStage::AudioProcessing, frameNumber, audioPacket->getProcessingStartReferenceTime(), audioPacket->getProcessingEndReferenceTime());
+	g_traceRecorder.addSpan(TraceStage::AudioScheduleWait, frameNumber, audioPacket->getProcessingEndReferenceTime(), audioPacket->getOutputPacketScheduledReferenceTime());
+}
+
+void updateCompletedFrameLatency(std::shared_ptr<LoopThroughVideoFrame> completedFrame)
 {
 	bool frameDisplayed;
 	try
@@ -352,18 +607,26 @@ void updateCompletedFrameLatency(std::shared_ptr<LoopThroughVideoFrame> complete
 		g_videoInputLatencyStatistics.addSample(completedFrame->getInputLatency());
 		g_videoProcessingLatencyStatistics.addSample(completedFrame->getProcessingLatency());
 		g_videoOutputLatencyStatistics.addSample(completedFrame->getOutputLatency());
+
+		g_videoInputLatencyMetric.observe((double)completedFrame->getInputLatency() / ReferenceTime::kTicksPerMilliSec);
+		g_videoProcessingLatencyMetric.observe((double)completedFrame->getProcessingLatency() / ReferenceTime::kTicksPerMilliSec);
+		g_videoOutputLatencyMetric.observe((double)completedFrame->getOutputLatency() / ReferenceTime::kTicksPerMilliSec);
 	}
+
+	g_outputCompletionResultMetrics.at(completedFrame->getOutputCompletionResult())->increment();
 	
+	traceCompletedFrame(completedFrame);
+
 	g_outputFrameCount++;
 	++g_frameCompletionResultCount[completedFrame->getOutputCompletionResult()];
 	
 	if (!kPrintRollingAverage)
 	{
-		printOutputCompletionResult(std::move(completedFrame), printDispatchQueue);
+		printOutputCompletionResult(std::move(completedFrame));
 	}
 }
 
-void printRollingAverage(DispatchQueue& printDispatchQueue)
+void printRollingAverage(void)
 {
 	std::chrono::milliseconds	printRollingAveragePeriod(kRollingAverageUpdateRateMs);
 	
@@ -373,12 +636,16 @@ void printRollingAverage(DispatchQueue& printDispatchQueue)
 		if (!g_printRollingAverageNotifier.condition.wait_for(lock, printRollingAveragePeriod, [] { return g_printRollingAverageNotifier.isNotifiedLocked(); }))
 		{
 			// Timeout, print rolling average
-			dispatch_printf(printDispatchQueue,
-							"%d frames output; Average latency: Input = %.2f ms, Processing = %.2f ms, Output = %.2f ms\n",
+			g_logger.log("%d frames output; Average latency: Input = %.2f ms, Processing = %.2f ms, Output = %.2f ms\n",
 							g_outputFrameCount,
 							(double)g_videoInputLatencyStatistics.getRollingAverage() / ReferenceTime::kTicksPerMilliSec,
 							(double)g_videoProcessingLatencyStatistics.getRollingAverage() / ReferenceTime::kTicksPerMilliSec,
 							(double)g_videoOutputLatencyStatistics.getRollingAverage() / ReferenceTime::kTicksPerMilliSec);
+
+			AudioLoudness loudness;
+			g_audioLevelMeter.getLoudness(loudness);
+			g_logger.log("Audio loudness: Momentary = %.1f LUFS, Short-term = %.1f LUFS, Integrated = %.1f LUFS\n",
+							loudness.momentary, loudness.shortTerm, loudness.integrated);
 		}
 		else
 		{
@@ -387,10 +654,70 @@ void printRollingAverage(DispatchQueue& printDispatchQueue)
 	}
 }
 
-void printOutputSummary(DispatchQueue& printDispatchQueue)
+void publishAudioLevels(void)
+{
+	std::chrono::milliseconds		audioLevelUpdatePeriod(kAudioLevelUpdateRateMs);
+	std::vector<AudioChannelLevels>	channelLevels;
+	AudioLoudness					loudness;
+
+	while (true)
+	{
+		std::unique_lock<std::mutex> lock(g_audioLevelsNotifier.mutex);
+		if (g_audioLevelsNotifier.condition.wait_for(lock, audioLevelUpdatePeriod, [] { return g_audioLevelsNotifier.isNotifiedLocked(); }))
+			break;
+
+		g_audioLevelMeter.getChannelLevels(channelLevels);
+		g_audioLevelMeter.getLoudness(loudness);
+
+		for (size_t channel = 0; channel < std::min(channelLevels.size(), g_audioChannelMetrics.size()); channel++)
+		{
+			g_audioChannelMetrics[channel].peak->set(AudioLevelMeter::toDecibels(channelLevels[channel].peak));
+			g_audioChannelMetrics[channel].rms->set(AudioLevelMeter::toDecibels(channelLevels[channel].rms));
+			g_audioChannelMetrics[channel].truePeak->set(AudioLevelMeter::toDecibels(channelLevels[channel].truePeak));
+		}
+
+		g_momentaryLoudnessMetric.set(loudness.momentary);
+		g_shortTermLoudnessMetric.set(loudness.shortTerm);
+		g_integratedLoudnessMetric.set(loudness.integrated);
+	}
+}
+
+void writeTrace(void)
+{
+	if (g_traceRecorder.writeChromeTrace(kTraceFilePath))
+		g_logger.log("Pipeline trace written to %s\n", kTraceFilePath);
+	else
+		fprintf(stderr, "Unable to write pipeline trace to %s\n", kTraceFilePath);
+}
+
+void writeTraceOnRequest(void)
+{
+	std::chrono::milliseconds	traceRequestPollPeriod(kTraceRequestPollRateMs);
+
+	while (true)
+	{
+		std::unique_lock<std::mutex> lock(g_traceRequestNotifier.mutex);
+		if (g_traceRequestNotifier.condition.wait_for(lock, traceRequestPollPeriod, [] { return g_traceRequestNotifier.isNotifiedLocked(); }))
+			break;
+
+		if (g_traceRequested)
+		{
+			g_traceRequested = 0;
+			writeTrace();
+		}
+	}
+}
+
+void traceRequestHandler(int signum)
+{
+	if (signum == SIGUSR1)
+		g_traceRequested = 1;
+}
+
+void printOutputSummary(void)
 {
 	int displayedFrames = 0;
-	dispatch_printf(printDispatchQueue, "\nFrames dropped on capture: %d\n", g_droppedOnCaptureFrameCount);
+	g_logger.log("\nFrames dropped on capture: %d\n", g_droppedOnCaptureFrameCount);
 	for (auto completionResultIter : kOutputCompletionResults)
 	{
 		const char* completionResultString;
@@ -400,7 +727,7 @@ void printOutputSummary(DispatchQueue& printDispatchQueue)
 		
 		auto completionCountIter = g_frameCompletionResultCount.find(completionResultIter.first);
 		int frameCount = (completionCountIter != g_frameCompletionResultCount.end()) ? completionCountIter->second : 0;
-		dispatch_printf(printDispatchQueue, "Frames %s: %d\n", completionResultString, frameCount);
+		g_logger.log("Frames %s: %d\n", completionResultString, frameCount);
 		if (frameDisplayed)
 			displayedFrames += frameCount;
 	}
@@ -410,39 +737,40 @@ void printOutputSummary(DispatchQueue& printDispatchQueue)
 		BMDTimeValue stddev;
 		
 		std::tie(mean, stddev) = g_videoInputLatencyStatistics.getMeanAndStdDev();
-		dispatch_printf(printDispatchQueue,
-						"\nVideo Input Latency:\t\tMinimum = %6.2f ms, Maximum = %6.2f ms, Mean = %6.2f ms, StdDev = %.2f ms\n",
+		g_logger.log("\nVideo Input Latency:\t\tMinimum = %6.2f ms, Maximum = %6.2f ms, Mean = %6.2f ms, StdDev = %.2f ms\n",
 						(double)g_videoInputLatencyStatistics.getMinimum() / ReferenceTime::kTicksPerMilliSec,
 						(double)g_videoInputLatencyStatistics.getMaximum() / ReferenceTime::kTicksPerMilliSec,
 						(double)mean / ReferenceTime::kTicksPerMilliSec,
 						(double)stddev / ReferenceTime::kTicksPerMilliSec);
 		
 		std::tie(mean, stddev) = g_videoProcessingLatencyStatistics.getMeanAndStdDev();
-		dispatch_printf(printDispatchQueue,
-						"Video Processing Latency:\tMinimum = %6.2f ms, Maximum = %6.2f ms, Mean = %6.2f ms, StdDev = %.2f ms\n",
+		g_logger.log("Video Processing Latency:\tMinimum = %6.2f ms, Maximum = %6.2f ms, Mean = %6.2f ms, StdDev = %.2f ms\n",
 						(double)g_videoProcessingLatencyStatistics.getMinimum() / ReferenceTime::kTicksPerMilliSec,
 						(double)g_videoProcessingLatencyStatistics.getMaximum() / ReferenceTime::kTicksPerMilliSec,
 						(double)mean / ReferenceTime::kTicksPerMilliSec,
 						(double)stddev / ReferenceTime::kTicksPerMilliSec);
 
 		std::tie(mean, stddev) = g_videoOutputLatencyStatistics.getMeanAndStdDev();
-		dispatch_printf(printDispatchQueue,
-						"Video Output Latency:\t\tMinimum = %6.2f ms, Maximum = %6.2f ms, Mean = %6.2f ms, StdDev = %.2f ms\n",
+		g_logger.log("Video Output Latency:\t\tMinimum = %6.2f ms, Maximum = %6.2f ms, Mean = %6.2f ms, StdDev = %.2f ms\n",
 						(double)g_videoOutputLatencyStatistics.getMinimum() / ReferenceTime::kTicksPerMilliSec,
 						(double)g_videoOutputLatencyStatistics.getMaximum() / ReferenceTime::kTicksPerMilliSec,
 						(double)mean / ReferenceTime::kTicksPerMilliSec,
 						(double)stddev / ReferenceTime::kTicksPerMilliSec);
 		
 		std::tie(mean, stddev) = g_audioProcessingLatencyStatistics.getMeanAndStdDev();
-		dispatch_printf(printDispatchQueue,
-						"Audio Processing Latency:\tMinimum = %6.2f ms, Maximum = %6.2f ms, Mean = %6.2f ms, StdDev = %.2f ms\n",
+		g_logger.log("Audio Processing Latency:\tMinimum = %6.2f ms, Maximum = %6.2f ms, Mean = %6.2f ms, StdDev = %.2f ms\n",
 						(double)g_audioProcessingLatencyStatistics.getMinimum() / ReferenceTime::kTicksPerMilliSec,
 						(double)g_audioProcessingLatencyStatistics.getMaximum() / ReferenceTime::kTicksPerMilliSec,
 						(double)mean / ReferenceTime::kTicksPerMilliSec,
 						(double)stddev / ReferenceTime::kTicksPerMilliSec);	}
+
+	AudioLoudness loudness;
+	g_audioLevelMeter.getLoudness(loudness);
+	g_logger.log("\nAudio Integrated Loudness:\t%.1f LUFS, Maximum True-Peak = %.1f dBTP\n",
+					loudness.integrated, AudioLevelMeter::toDecibels(loudness.maxTruePeak));
 }
 
-void printReferenceStatus(com_ptr<DeckLinkOutputDevice>& deckLinkOutput, DispatchQueue& printDispatchQueue)
+void printReferenceStatus(com_ptr<DeckLinkOutputDevice>& deckLinkOutput)
 {
 	BMDDisplayMode referenceSignalDisplayMode;
 
@@ -456,17 +784,17 @@ void printReferenceStatus(com_ptr<DeckLinkOutputDevice>& deckLinkOutput, Dispatc
 			deckLinkOutput->getDeckLinkOutput()->GetDisplayMode(referenceSignalDisplayMode, referenceDeckLinkDisplayMode.releaseAndGetAddressOf());
 
 			referenceDeckLinkDisplayMode->GetName(&referenceDisplayModeName);
-			dispatch_printf(printDispatchQueue, "Reference signal locked to %s\n", DlToCString(referenceDisplayModeName));
+			g_logger.log("Reference signal locked to %s\n", LogString(DlToCString(referenceDisplayModeName)));
 			DeleteString(referenceDisplayModeName);
 		}
 		else
 		{
-			dispatch_printf(printDispatchQueue, "Reference signal locked\n");
+			g_logger.log("Reference signal locked\n");
 		}
 	}
 	else
 	{
-		dispatch_printf(printDispatchQueue, "Warning: Reference signal not locked, this will result in an indeterminate latency between runs.\n");
+		g_logger.log("Warning: Reference signal not locked, this will result in an indeterminate latency between runs.\n");
 	}
 }
 
@@ -481,9 +809,12 @@ HRESULT InputLoopThrough(void)
 
 	DispatchQueue 						videoDispatchQueue(kVideoDispatcherThreadCount);
 	DispatchQueue 						audioDispatchQueue(kAudioDispatcherThreadCount);
-	DispatchQueue						printDispatchQueue(kPrintDispatcherThreadCount);
 	
 	std::thread							printRollingAverageThread;
+	std::thread							traceRequestThread;
+	std::thread							publishAudioLevelsThread;
+
+	MetricsServer						metricsServer(g_metricsRegistry);
 
 	result = GetDeckLinkIterator(deckLinkIterator.releaseAndGetAddressOf());
 	if (result != S_OK)
@@ -538,7 +869,7 @@ HRESULT InputLoopThrough(void)
 						continue;
 					}
 					g_audioChannelCount = std::min((uint32_t)maxAudioChannels, g_audioChannelCount);
-					dispatch_printf(printDispatchQueue, "Using input device: %s\n", getDeckLinkDisplayName(deckLink).c_str());
+					g_logger.log("Using input device: %s\n", LogString(getDeckLinkDisplayName(deckLink).c_str()));
 				}
 
 				// If input device is half duplex, skip output discovery
@@ -557,7 +888,7 @@ HRESULT InputLoopThrough(void)
 
 				if (kOutputVideoPreroll < minimumPrerollFrames)
 				{
-					dispatch_printf(printDispatchQueue, "Warning: Specified video output preroll size is smaller than the minimum supported size; Changing preroll size from %d to %d.\n", kOutputVideoPreroll, minimumPrerollFrames);
+					g_logger.log("Warning: Specified video output preroll size is smaller than the minimum supported size; Changing preroll size from %d to %d.\n", kOutputVideoPreroll, (int)minimumPrerollFrames);
 				}
 				
 				int prerollFrames = std::max((int)minimumPrerollFrames, kOutputVideoPreroll);
@@ -573,7 +904,7 @@ HRESULT InputLoopThrough(void)
 				}
 				g_audioChannelCount = std::min((uint32_t)maxAudioChannels, g_audioChannelCount);
 				
-				dispatch_printf(printDispatchQueue, "Using output device: %s\n", getDeckLinkDisplayName(deckLink).c_str());
+				g_logger.log("Using output device: %s\n", LogString(getDeckLinkDisplayName(deckLink).c_str()));
 			}
 		}
 
@@ -589,6 +920,40 @@ HRESULT InputLoopThrough(void)
 		return E_FAIL;
 	}
 
+	if (g_audioLevelMeter.getLoudnessFirstChannel() + g_audioLevelMeter.getLoudnessChannelCount() > g_audioChannelCount)
+	{
+		fprintf(stderr, "Unable to meter loudness of channels %u-%u with %u audio channels\n",
+				g_audioLevelMeter.getLoudnessFirstChannel() + 1,
+				g_audioLevelMeter.getLoudnessFirstChannel() + g_audioLevelMeter.getLoudnessChannelCount(),
+				g_audioChannelCount);
+		return E_INVALIDARG;
+	}
+
+	// Serve metrics for scraping
+	if (!metricsServer.listenHttp(g_metricsHttpPort))
+	{
+		fprintf(stderr, "Unable to listen for metrics requests on port %u - %s, select another port with --metrics-port\n",
+				(unsigned)g_metricsHttpPort, strerror(errno));
+		return E_FAIL;
+	}
+
+	if (!metricsServer.createSharedMemory(g_metricsSharedMemoryName, kMetricsSnapshotIntervalMs))
+	{
+		if (errno == EEXIST)
+			fprintf(stderr, "Shared memory metrics snapshot %s is in use by another instance, select another name with --metrics-shm "
+					"or remove /dev/shm%s if it was left by an instance that did not exit cleanly\n",
+					g_metricsSharedMemoryName.c_str(), g_metricsSharedMemoryName.c_str());
+		else
+			fprintf(stderr, "Unable to create shared memory metrics snapshot %s - %s\n", g_metricsSharedMemoryName.c_str(), strerror(errno));
+		return E_FAIL;
+	}
+
+	metricsServer.start();
+
+	// Write pipeline trace when SIGUSR1 is received
+	signal(SIGUSR1, traceRequestHandler);
+	traceRequestThread = std::thread(writeTraceOnRequest);
+
 	std::mutex formatDescMutex;
 	FormatDescription formatDesc = { kInitialDisplayMode, false, kInitialPixelFormat };
 
@@ -620,13 +985,32 @@ HRESULT InputLoopThrough(void)
 			g_loopThroughSessionNotifier.condition.notify_all();
 		});
 
-		deckLinkInput->onVideoInputArrived([&](std::shared_ptr<LoopThroughVideoFrame> videoFrame) { videoDispatchQueue.dispatch(processVideo, videoFrame, deckLinkOutput); });
-		deckLinkInput->onAudioInputArrived([&](std::shared_ptr<LoopThroughAudioPacket> audioPacket) { audioDispatchQueue.dispatch(processAudio, audioPacket, deckLinkOutput); });
-		deckLinkInput->onVideoInputFrameDropped([&](BMDTimeValue streamTime, BMDTimeValue frameDuration, BMDTimeScale) { printDroppedCaptureFrame(streamTime, frameDuration, std::ref(printDispatchQueue)); });
+		deckLinkInput->onVideoInputArrived([&](std::shared_ptr<LoopThroughVideoFrame> videoFrame)
+		{
+			if (g_decodeCaptions)
+				decodeCaptions(videoFrame->getVideoFramePtr());
+
+			videoFrame->setInputFrameDispatchedReferenceTime(ReferenceTime::getSteadyClockUptimeCount());
+			videoDispatchQueue.dispatch(processVideo, videoFrame, deckLinkOutput);
+		});
+		deckLinkInput->onAudioInputArrived([&](std::shared_ptr<LoopThroughAudioPacket> audioPacket)
+		{
+			g_audioLevelMeter.processSamples(audioPacket->getBuffer(), (uint32_t)audioPacket->getSampleFrameCount());
+			audioDispatchQueue.dispatch(processAudio, audioPacket, deckLinkOutput);
+		});
+		deckLinkInput->onVideoInputFrameDropped([&](BMDTimeValue streamTime, BMDTimeValue frameDuration, BMDTimeScale) { printDroppedCaptureFrame(streamTime, frameDuration); });
 
 		// Register output callbacks
-		deckLinkOutput->onScheduledFrameCompleted([&](std::shared_ptr<LoopThroughVideoFrame> videoFrame) { updateCompletedFrameLatency(videoFrame, std::ref(printDispatchQueue)); });
-		deckLinkOutput->onAudioPacketScheduled([&](std::shared_ptr<LoopThroughAudioPacket> audioPacket) { g_audioProcessingLatencyStatistics.addSample(audioPacket->getProcessingLatency()); });
+		deckLinkOutput->onScheduledFrameCompleted([&](std::shared_ptr<LoopThroughVideoFrame> videoFrame) { updateCompletedFrameLatency(videoFrame); });
+		deckLinkOutput->onAudioPacketScheduled([&](std::shared_ptr<LoopThroughAudioPacket> audioPacket)
+		{
+			g_audioProcessingLatencyStatistics.addSample(audioPacket->getProcessingLatency());
+			g_audioProcessingLatencyMetric.observe((double)audioPacket->getProcessingLatency() / ReferenceTime::kTicksPerMilliSec);
+			traceScheduledAudioPacket(audioPacket, deckLinkOutput->getFrameDuration());
+		});
+
+		if (!g_audioLevelMeter.configure(g_audioChannelCount, kAudioSampleType))
+			fprintf(stderr, "Unable to meter %u audio channels\n", g_audioChannelCount);
 
 		if (!deckLinkInput->startCapture(currentFormatDesc.displayMode, currentFormatDesc.is3D, currentFormatDesc.pixelFormat, kAudioSampleType, g_audioChannelCount))
 		{
@@ -635,7 +1019,7 @@ HRESULT InputLoopThrough(void)
 		}
 
 		if (kWaitForReferenceToLock)
-			dispatch_printf(printDispatchQueue, "Waiting for reference to lock...\n");
+			g_logger.log("Waiting for reference to lock...\n");
 
 		if (!deckLinkOutput->startPlayback(currentFormatDesc.displayMode, currentFormatDesc.is3D, currentFormatDesc.pixelFormat, kAudioSampleType, g_audioChannelCount, kWaitForReferenceToLock))
 		{
@@ -648,17 +1032,21 @@ HRESULT InputLoopThrough(void)
 		}
 
 		deckLinkInput->setReadyForCapture();
+		g_loopThroughActiveMetric.set(1);
 
-		printReferenceStatus(deckLinkOutput, printDispatchQueue);
+		printReferenceStatus(deckLinkOutput);
 
-		dispatch_printf(printDispatchQueue, "Starting input loop-through, press <RETURN> to stop/exit\n");
+		g_logger.log("Starting input loop-through, press <RETURN> to stop/exit\n");
 
 		if (kPrintRollingAverage)
 		{
 			g_printRollingAverageNotifier.reset();
-			printRollingAverageThread = std::thread(printRollingAverage, std::ref(printDispatchQueue));
+			printRollingAverageThread = std::thread(printRollingAverage);
 		}
 
+		g_audioLevelsNotifier.reset();
+		publishAudioLevelsThread = std::thread(publishAudioLevels);
+
 		{
 			std::unique_lock<std::mutex> lock(g_loopThroughSessionNotifier.mutex);
 
@@ -676,10 +1064,15 @@ HRESULT InputLoopThrough(void)
 				printRollingAverageThread.join();
 		}
 	
+		g_audioLevelsNotifier.notify();
+		if (publishAudioLevelsThread.joinable())
+			publishAudioLevelsThread.join();
+
 		deckLinkInput->stopCapture();
 		deckLinkOutput->stopPlayback();
+		g_loopThroughActiveMetric.set(0);
 
-		printOutputSummary(printDispatchQueue);
+		printOutputSummary();
 
 		// Reset statistics
 		g_videoInputLatencyStatistics.reset();
@@ -704,9 +1097,8 @@ HRESULT InputLoopThrough(void)
 			{
 				try
 				{
-					dispatch_printf(printDispatchQueue,
-									"\nLoop-through video format changed to %s %s%s\n",
-									DlToCString(displayModeNameStr),
+					g_logger.log("\nLoop-through video format changed to %s %s%s\n",
+									LogString(DlToCString(displayModeNameStr)),
 									formatDesc.is3D ? "3D " : "",
 									kPixelFormats.at(formatDesc.pixelFormat));
 				}
@@ -724,15 +1116,120 @@ HRESULT InputLoopThrough(void)
 	if (userInputThread.joinable())
 		userInputThread.join();
 
-	dispatch_printf(printDispatchQueue, "\nInputLoopThrough complete\n\n");
+	g_traceRequestNotifier.notify();
+	if (traceRequestThread.joinable())
+		traceRequestThread.join();
+
+	if (kWriteTraceOnExit)
+		writeTrace();
+
+	g_logger.log("\nInputLoopThrough complete\n\n");
 
 	return result;
 }
 
+void printUsage(const char* name)
+{
+	printf("%s [options]\n"
+		   "\n"
+		   "Options:\n"
+		   "    -h, --help                Display this help message\n"
+		   "    -C, --captions            Decode and print CEA-708 captions from the ancillary data of each frame\n"
+		   "    -l, --loudness-channels <first>-<last>\n"
+		   "                              Measure loudness of a mono, stereo, 5.1 or 7.1 channel group in SMPTE order\n"
+		   "                              (default 1-2)\n"
+		   "    -p, --metrics-port <port> Localhost port to serve Prometheus metrics on (default %u)\n"
+		   "    -m, --metrics-shm <name>  POSIX shared memory object to publish the metrics snapshot to, must start\n"
+		   "                              with '/' (default %s)\n"
+		   "    -b, --benchmark <frames>  Composite <frames> synthetic frames in each supported pixel format and print\n"
+		   "                              the frame rate, without DeckLink devices\n"
+		   "    -s, --size <w>x<h>        Frame size for benchmark mode (default 3840x2160)\n"
+		   "    -t, --threads <count>     Compositor threads for benchmark mode (default one per CPU)\n"
+		   "    -a, --audio-benchmark <seconds>\n"
+		   "                              Meter <seconds> of synthetic audio for each supported channel count and\n"
+		   "                              sample type and print the levels and cost, without DeckLink devices\n",
+		   name, (unsigned)kDefaultMetricsHttpPort, kDefaultMetricsSharedMemoryName);
+}
+
 int main(int argc, const char * argv[])
 {
 	HRESULT		result;
 	int			exitStatus = EXIT_FAILURE;
+	unsigned	benchmarkFrames = 0;
+	unsigned	benchmarkWidth = 3840;
+	unsigned	benchmarkHeight = 2160;
+	unsigned	benchmarkThreads = 0;
+	unsigned	audioBenchmarkSeconds = 0;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if ((strcmp(argv[i], "--benchmark") == 0 || strcmp(argv[i], "-b") == 0) && (i + 1 < argc))
+			benchmarkFrames = (unsigned)strtoul(argv[++i], nullptr, 10);
+		else if ((strcmp(argv[i], "--audio-benchmark") == 0 || strcmp(argv[i], "-a") == 0) && (i + 1 < argc))
+			audioBenchmarkSeconds = (unsigned)strtoul(argv[++i], nullptr, 10);
+		else if ((strcmp(argv[i], "--threads") == 0 || strcmp(argv[i], "-t") == 0) && (i + 1 < argc))
+			benchmarkThreads = (unsigned)strtoul(argv[++i], nullptr, 10);
+		else if ((strcmp(argv[i], "--size") == 0 || strcmp(argv[i], "-s") == 0) && (i + 1 < argc))
+		{
+			if (sscanf(argv[++i], "%ux%u", &benchmarkWidth, &benchmarkHeight) != 2)
+			{
+				fprintf(stderr, "Invalid frame size: %s\n", argv[i]);
+				return EXIT_FAILURE;
+			}
+		}
+		else if (strcmp(argv[i], "--captions") == 0 || strcmp(argv[i], "-C") == 0)
+			g_decodeCaptions = true;
+		else if ((strcmp(argv[i], "--loudness-channels") == 0 || strcmp(argv[i], "-l") == 0) && (i + 1 < argc))
+		{
+			unsigned firstChannel, lastChannel;
+
+			if ((sscanf(argv[++i], "%u-%u", &firstChannel, &lastChannel) != 2) || (firstChannel == 0) || (lastChannel < firstChannel) ||
+				!g_audioLevelMeter.setLoudnessChannels(firstChannel - 1, lastChannel - firstChannel + 1))
+			{
+				fprintf(stderr, "Invalid loudness channels: %s\n", argv[i]);
+				return EXIT_FAILURE;
+			}
+		}
+		else if ((strcmp(argv[i], "--metrics-port") == 0 || strcmp(argv[i], "-p") == 0) && (i + 1 < argc))
+		{
+			char*			end;
+			unsigned long	port = strtoul(argv[++i], &end, 10);
+
+			if ((*end != '\0') || (port == 0) || (port > 65535))
+			{
+				fprintf(stderr, "Invalid metrics port: %s\n", argv[i]);
+				return EXIT_FAILURE;
+			}
+			g_metricsHttpPort = (uint16_t)port;
+		}
+		else if ((strcmp(argv[i], "--metrics-shm") == 0 || strcmp(argv[i], "-m") == 0) && (i + 1 < argc))
+		{
+			g_metricsSharedMemoryName = argv[++i];
+			if ((g_metricsSharedMemoryName.size() < 2) || (g_metricsSharedMemoryName[0] != '/') ||
+				(g_metricsSharedMemoryName.find('/', 1) != std::string::npos))
+			{
+				fprintf(stderr, "Invalid metrics shared memory name: %s\n", argv[i]);
+				return EXIT_FAILURE;
+			}
+		}
+		else if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0)
+		{
+			printUsage(argv[0]);
+			return EXIT_SUCCESS;
+		}
+		else
+		{
+			fprintf(stderr, "Unknown argument: %s\n", argv[i]);
+			printUsage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (benchmarkFrames > 0)
+		return RunCompositorBenchmark(benchmarkWidth, benchmarkHeight, benchmarkFrames, benchmarkThreads) ? EXIT_SUCCESS : EXIT_FAILURE;
+
+	if (audioBenchmarkSeconds > 0)
+		return RunAudioLevelMeterBenchmark(audioBenchmarkSeconds) ? EXIT_SUCCESS : EXIT_FAILURE;
 
 	result = InputLoopThrough();
 	if (result == S_OK)
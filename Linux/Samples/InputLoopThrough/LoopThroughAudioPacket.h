@@ -57,6 +57,8 @@ public:
 		m_deleter(deleter),
 		m_audioStreamTime(0),
 		m_inputPacketArrivedReferenceTime(0),
+		m_processingStartReferenceTime(0),
+		m_processingEndReferenceTime(0),
 		m_outputPacketScheduledReferenceTime(0)
 	{
 	}
@@ -84,11 +86,19 @@ public:
 	
 	void			setAudioStreamTime(const BMDTimeValue time) { m_audioStreamTime = time; }
 	void			setInputPacketArrivedReferenceTime(const BMDTimeValue time) { m_inputPacketArrivedReferenceTime = time; }
+	void			setProcessingStartReferenceTime(const BMDTimeValue time) { m_processingStartReferenceTime = time; }
+	void			setProcessingEndReferenceTime(const BMDTimeValue time) { m_processingEndReferenceTime = time; }
 	void			setOutputPacketScheduledReferenceTime(const BMDTimeValue time) { m_outputPacketScheduledReferenceTime = time; }
 
 	BMDTimeValue	getAudioStreamTime(void) const { return m_audioStreamTime; }
 	BMDTimeValue	getProcessingLatency(void) const { return m_outputPacketScheduledReferenceTime - m_inputPacketArrivedReferenceTime; }
 
+	// Reference times for each stage of the loop-through pipeline, for tracing
+	BMDTimeValue	getInputPacketArrivedReferenceTime(void) const { return m_inputPacketArrivedReferenceTime; }
+	BMDTimeValue	getProcessingStartReferenceTime(void) const { return m_processingStartReferenceTime; }
+	BMDTimeValue	getProcessingEndReferenceTime(void) const { return m_processingEndReferenceTime; }
+	BMDTimeValue	getOutputPacketScheduledReferenceTime(void) const { return m_outputPacketScheduledReferenceTime; }
+
 private:
 	void*			m_audioBuffer;
 	long			m_sampleFrameCount;
@@ -96,5 +106,7 @@ private:
 
 	BMDTimeValue	m_audioStreamTime;
 	BMDTimeValue	m_inputPacketArrivedReferenceTime;
+	BMDTimeValue	m_processingStartReferenceTime;
+	BMDTimeValue	m_processingEndReferenceTime;
 	BMDTimeValue	m_outputPacketScheduledReferenceTime;
 };
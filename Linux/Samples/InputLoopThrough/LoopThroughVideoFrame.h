@@ -52,6 +52,9 @@ public:
 		m_videoFrameDuration(0),
 		m_inputFrameStartReferenceTime(0),
 		m_inputFrameArrivedReferenceTime(0),
+		m_inputFrameDispatchedReferenceTime(0),
+		m_processingStartReferenceTime(0),
+		m_processingEndReferenceTime(0),
 		m_outputFrameScheduledReferenceTime(0),
 		m_outputFrameCompletedReferenceTime(0),
 		m_outputFrameCompletionResult(bmdOutputFrameDropped)
@@ -64,6 +67,9 @@ public:
 	void	setVideoFrameDuration(const BMDTimeValue duration) { m_videoFrameDuration = duration; }
 	void	setInputFrameStartReferenceTime(const BMDTimeValue time) { m_inputFrameStartReferenceTime = time; }
 	void	setInputFrameArrivedReferenceTime(const BMDTimeValue time) { m_inputFrameArrivedReferenceTime = time; }
+	void	setInputFrameDispatchedReferenceTime(const BMDTimeValue time) { m_inputFrameDispatchedReferenceTime = time; }
+	void	setProcessingStartReferenceTime(const BMDTimeValue time) { m_processingStartReferenceTime = time; }
+	void	setProcessingEndReferenceTime(const BMDTimeValue time) { m_processingEndReferenceTime = time; }
 	void	setOutputFrameScheduledReferenceTime(const BMDTimeValue time) { m_outputFrameScheduledReferenceTime = time; }
 	void	setOutputFrameCompletedReferenceTime(const BMDTimeValue time) { m_outputFrameCompletedReferenceTime = time; }
 	void	setOutputCompletionResult(const BMDOutputFrameCompletionResult result) { m_outputFrameCompletionResult = result; }
@@ -75,6 +81,15 @@ public:
 	BMDTimeValue					getProcessingLatency(void) const { return m_outputFrameScheduledReferenceTime - m_inputFrameArrivedReferenceTime; }
 	BMDTimeValue					getOutputLatency(void) const { return m_outputFrameCompletedReferenceTime - m_outputFrameScheduledReferenceTime; }
 	BMDOutputFrameCompletionResult	getOutputCompletionResult(void) const { return m_outputFrameCompletionResult; }
+
+	// Reference times for each stage of the loop-through pipeline, for tracing
+	BMDTimeValue					getInputFrameStartReferenceTime(void) const { return m_inputFrameStartReferenceTime; }
+	BMDTimeValue					getInputFrameArrivedReferenceTime(void) const { return m_inputFrameArrivedReferenceTime; }
+	BMDTimeValue					getInputFrameDispatchedReferenceTime(void) const { return m_inputFrameDispatchedReferenceTime; }
+	BMDTimeValue					getProcessingStartReferenceTime(void) const { return m_processingStartReferenceTime; }
+	BMDTimeValue					getProcessingEndReferenceTime(void) const { return m_processingEndReferenceTime; }
+	BMDTimeValue					getOutputFrameScheduledReferenceTime(void) const { return m_outputFrameScheduledReferenceTime; }
+	BMDTimeValue					getOutputFrameCompletedReferenceTime(void) const { return m_outputFrameCompletedReferenceTime; }
 	
 private:
 	com_ptr<IDeckLinkVideoFrame>	m_videoFrame;
@@ -83,6 +98,10 @@ private:
 	
 	BMDTimeValue					m_inputFrameStartReferenceTime;
 	BMDTimeValue					m_inputFrameArrivedReferenceTime;
+	BMDTimeValue					m_inputFrameDispatchedReferenceTime;
+
+	BMDTimeValue					m_processingStartReferenceTime;
+	BMDTimeValue					m_processingEndReferenceTime;
 
 	BMDTimeValue					m_outputFrameScheduledReferenceTime;
 	BMDTimeValue					m_outputFrameCompletedReferenceTime;
@@ -0,0 +1,155 @@
+/* -LICENSE-START-
+** Copyright (c) 2022 Blackmagic Design
+**  
+** Permission is hereby granted, free of charge, to any person or organization 
+** obtaining a copy of the software and accompanying documentation (the 
+** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+** and transmit the Software, and to prepare derivative works of the Software, 
+** and to permit third-parties to whom the Software is furnished to do so, in 
+** accordance with:
+** 
+** (1) if the Software is obtained from Blackmagic Design, the End User License 
+** Agreement for the Software Development Kit (“EULA”) available at 
+** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+** 
+** (2) if the Software is obtained from any third party, such licensing terms 
+** as notified by that third party,
+** 
+** and all subject to the following:
+** 
+** (3) the copyright notices in the Software and this entire statement, 
+** including the above license grant, this restriction and the following 
+** disclaimer, must be included in all copies of the Software, in whole or in 
+** part, and all derivative works of the Software, unless such copies or 
+** derivative works are solely in the form of machine-executable object code 
+** generated by a source language processor.
+** 
+** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+** DEALINGS IN THE SOFTWARE.
+** 
+** A copy of the Software is available free of charge at 
+** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+** 
+** -LICENSE-END-
+*/
+
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+// Metrics are registered once at startup, after which they can be updated from any thread without locks
+// or allocation.  The registry formats all metrics in Prometheus text exposition format on request.
+
+class MetricCounter
+{
+public:
+	MetricCounter() : m_value(0) { }
+
+	void				increment(uint64_t count = 1) { m_value.fetch_add(count, std::memory_order_relaxed); }
+	uint64_t			getValue(void) const { return m_value.load(std::memory_order_relaxed); }
+
+private:
+	std::atomic<uint64_t>	m_value;
+};
+
+class MetricGauge
+{
+public:
+	MetricGauge() : m_value(0) { }
+
+	void				set(int64_t value) { m_value.store(value, std::memory_order_relaxed); }
+	void				add(int64_t delta) { m_value.fetch_add(delta, std::memory_order_relaxed); }
+	int64_t				getValue(void) const { return m_value.load(std::memory_order_relaxed); }
+
+private:
+	std::atomic<int64_t>	m_value;
+};
+
+// Gauge for fractional values, eg. levels in decibels
+class MetricFloatGauge
+{
+public:
+	MetricFloatGauge() : m_value(0.0) { }
+
+	void				set(double value) { m_value.store(value, std::memory_order_relaxed); }
+	double				getValue(void) const { return m_value.load(std::memory_order_relaxed); }
+
+private:
+	std::atomic<double>	m_value;
+};
+
+class MetricHistogram
+{
+public:
+	// Bucket upper bounds must be in increasing order, an implicit +Inf bucket is added
+	MetricHistogram(const std::vector<double>& bucketBounds);
+
+	void				observe(double value);
+
+	size_t				getBucketCount(void) const { return m_bucketBounds.size(); }
+	double				getBucketBound(size_t bucket) const { return m_bucketBounds[bucket]; }
+	uint64_t			getCumulativeCount(size_t bucket) const;
+	uint64_t			getCount(void) const { return m_count.load(std::memory_order_relaxed); }
+	double				getSum(void) const;
+
+private:
+	std::vector<double>						m_bucketBounds;
+	std::unique_ptr<std::atomic<uint64_t>[]>	m_bucketCounts;
+	std::atomic<uint64_t>					m_count;
+	std::atomic<int64_t>					m_sumMicroUnits;		// Sum stored as fixed point so it can be updated atomically
+};
+
+class MetricsRegistry
+{
+public:
+	// Flattened sample of a metric, as written in Prometheus text format
+	struct MetricSample
+	{
+		std::string		name;				// Includes any labels
+		double			value;
+	};
+
+	MetricsRegistry() = default;
+	virtual ~MetricsRegistry() = default;
+
+	// Labels are in Prometheus format, eg "result=\"dropped\"", metrics with same name share help text
+	MetricCounter&		addCounter(const std::string& name, const std::string& help, const std::string& labels = "");
+	MetricGauge&		addGauge(const std::string& name, const std::string& help, const std::string& labels = "");
+	MetricFloatGauge&	addFloatGauge(const std::string& name, const std::string& help, const std::string& labels = "");
+	MetricHistogram&	addHistogram(const std::string& name, const std::string& help, const std::vector<double>& bucketBounds, const std::string& labels = "");
+
+	std::string			getPrometheusText(void);
+	void				getSamples(std::vector<MetricSample>& samples);
+
+private:
+	enum class MetricType { Counter, Gauge, FloatGauge, Histogram };
+
+	struct Metric
+	{
+		MetricType							type;
+		std::string							name;
+		std::string							help;
+		std::string							labels;
+		std::unique_ptr<MetricCounter>		counter;
+		std::unique_ptr<MetricGauge>		gauge;
+		std::unique_ptr<MetricFloatGauge>	floatGauge;
+		std::unique_ptr<MetricHistogram>	histogram;
+	};
+
+	std::mutex				m_mutex;
+	std::vector<Metric>		m_metrics;
+
+	void					addMetric(Metric&& metric);
+	static void				forEachSample(const Metric& metric, const std::function<void(const std::string&, double)>& sampleFunction);
+};
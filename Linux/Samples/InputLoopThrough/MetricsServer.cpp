@@ -0,0 +1,415 @@
+/* -LICENSE-START-
+** Copyright (c) 2022 Blackmagic Design
+**  
+** Permission is hereby granted, free of charge, to any person or organization 
+** obtaining a copy of the software and accompanying documentation (the 
+** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+** and transmit the Software, and to prepare derivative works of the Software, 
+** and to permit third-parties to whom the Software is furnished to do so, in 
+** accordance with:
+** 
+** (1) if the Software is obtained from Blackmagic Design, the End User License 
+** Agreement for the Software Development Kit (“EULA”) available at 
+** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+** 
+** (2) if the Software is obtained from any third party, such licensing terms 
+** as notified by that third party,
+** 
+** and all subject to the following:
+** 
+** (3) the copyright notices in the Software and this entire statement, 
+** including the above license grant, this restriction and the following 
+** disclaimer, must be included in all copies of the Software, in whole or in 
+** part, and all derivative works of the Software, unless such copies or 
+** derivative works are solely in the form of machine-executable object code 
+** generated by a source language processor.
+** 
+** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+** DEALINGS IN THE SOFTWARE.
+** 
+** A copy of the Software is available free of charge at 
+** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+** 
+** -LICENSE-END-
+*/
+
+#include <algorithm>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#include "MetricsServer.h"
+
+static const size_t	kMaxHttpRequestSize			= 4096;
+static const size_t	kMaxHttpConnections			= 16;
+static const int	kHttpRequestTimeoutMs		= 1000;
+static const int	kServerPollIntervalMs		= 100;
+
+static bool setNonBlocking(int socket)
+{
+	int flags = fcntl(socket, F_GETFL, 0);
+	return (flags >= 0) && (fcntl(socket, F_SETFL, flags | O_NONBLOCK) == 0);
+}
+
+MetricsServer::MetricsServer(MetricsRegistry& registry) :
+	m_registry(registry),
+	m_listenSocket(-1),
+	m_snapshot(nullptr),
+	m_snapshotIntervalMs(0),
+	m_stopServer(false)
+{
+}
+
+MetricsServer::~MetricsServer()
+{
+	stop();
+	closeConnections();
+
+	if (m_listenSocket >= 0)
+		close(m_listenSocket);
+
+	if (!m_socketPath.empty())
+		unlink(m_socketPath.c_str());
+
+	if (m_snapshot != nullptr)
+	{
+		munmap(m_snapshot, sizeof(MetricsSnapshot));
+		shm_unlink(m_sharedMemoryName.c_str());
+	}
+}
+
+bool MetricsServer::listenHttp(uint16_t port)
+{
+	struct sockaddr_in	address;
+	int					reuseAddress = 1;
+
+	m_listenSocket = socket(AF_INET, SOCK_STREAM, 0);
+	if (m_listenSocket < 0)
+		return false;
+
+	setsockopt(m_listenSocket, SOL_SOCKET, SO_REUSEADDR, &reuseAddress, sizeof(reuseAddress));
+
+	// Only accept connections from the local host
+	memset(&address, 0, sizeof(address));
+	address.sin_family		= AF_INET;
+	address.sin_port		= htons(port);
+	address.sin_addr.s_addr	= htonl(INADDR_LOOPBACK);
+
+	if ((bind(m_listenSocket, (struct sockaddr*)&address, sizeof(address)) < 0) ||
+		(listen(m_listenSocket, SOMAXCONN) < 0) || !setNonBlocking(m_listenSocket))
+	{
+		close(m_listenSocket);
+		m_listenSocket = -1;
+		return false;
+	}
+
+	return true;
+}
+
+bool MetricsServer::listenHttp(const std::string& socketPath)
+{
+	struct sockaddr_un	address;
+
+	if (socketPath.size() >= sizeof(address.sun_path))
+		return false;
+
+	m_listenSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (m_listenSocket < 0)
+		return false;
+
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+
+	// Remove stale socket from previous run
+	unlink(socketPath.c_str());
+
+	if ((bind(m_listenSocket, (struct sockaddr*)&address, sizeof(address)) < 0) ||
+		(listen(m_listenSocket, SOMAXCONN) < 0) || !setNonBlocking(m_listenSocket))
+	{
+		close(m_listenSocket);
+		m_listenSocket = -1;
+		return false;
+	}
+
+	m_socketPath = socketPath;
+	return true;
+}
+
+bool MetricsServer::createSharedMemory(const std::string& sharedMemoryName, int updateIntervalMs)
+{
+	int		sharedMemoryFd;
+	void*	mapping;
+
+	// Fail with EEXIST rather than share an object with another instance, which would overwrite its snapshot and
+	// unlink it on exit
+	sharedMemoryFd = shm_open(sharedMemoryName.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+	if (sharedMemoryFd < 0)
+		return false;
+
+	if (ftruncate(sharedMemoryFd, sizeof(MetricsSnapshot)) < 0)
+	{
+		int error = errno;
+		close(sharedMemoryFd);
+		shm_unlink(sharedMemoryName.c_str());
+		errno = error;
+		return false;
+	}
+
+	mapping = mmap(nullptr, sizeof(MetricsSnapshot), PROT_READ | PROT_WRITE, MAP_SHARED, sharedMemoryFd, 0);
+	if (mapping == MAP_FAILED)
+	{
+		int error = errno;
+		close(sharedMemoryFd);
+		shm_unlink(sharedMemoryName.c_str());
+		errno = error;
+		return false;
+	}
+
+	close(sharedMemoryFd);
+
+	m_sharedMemoryName		= sharedMemoryName;
+	m_snapshotIntervalMs	= updateIntervalMs;
+	m_snapshot				= static_cast<MetricsSnapshot*>(mapping);
+
+	m_snapshot->magic		= kMetricsSnapshotMagic;
+	m_snapshot->version		= kMetricsSnapshotVersion;
+	m_snapshot->maxSamples	= kMetricsSnapshotMaxSamples;
+	m_snapshot->sampleCount	= 0;
+	m_snapshot->sequence.store(0, std::memory_order_release);
+
+	updateSnapshot();
+
+	return true;
+}
+
+void MetricsServer::start()
+{
+	if (m_serverThread.joinable())
+		return;
+
+	m_stopServer = false;
+	m_serverThread = std::thread(&MetricsServer::serverThread, this);
+}
+
+void MetricsServer::stop()
+{
+	m_stopServer = true;
+
+	if (m_serverThread.joinable())
+		m_serverThread.join();
+}
+
+void MetricsServer::serverThread()
+{
+	auto					nextSnapshotTime = std::chrono::steady_clock::now();
+	std::vector<pollfd>		pollSockets;
+
+	while (!m_stopServer)
+	{
+		auto	now = std::chrono::steady_clock::now();
+		auto	wakeTime = now + std::chrono::milliseconds(kServerPollIntervalMs);
+
+		// Wake for the next snapshot or the earliest connection deadline, whichever is first
+		if (m_snapshot != nullptr)
+			wakeTime = std::min(wakeTime, nextSnapshotTime);
+		for (const HttpConnection& connection : m_connections)
+			wakeTime = std::min(wakeTime, connection.deadline);
+
+		int timeoutMs = (int)std::chrono::duration_cast<std::chrono::milliseconds>(wakeTime - now).count();
+
+		// The listen socket is polled first, followed by each connection waiting on its request or response
+		pollSockets.clear();
+		if (m_listenSocket >= 0)
+			pollSockets.push_back({ m_listenSocket, POLLIN, 0 });
+		for (const HttpConnection& connection : m_connections)
+			pollSockets.push_back({ connection.socket, (short)(connection.response.empty() ? POLLIN : POLLOUT), 0 });
+
+		if (pollSockets.empty())
+			std::this_thread::sleep_for(std::chrono::milliseconds(std::max(timeoutMs, 0)));
+		else if (poll(pollSockets.data(), pollSockets.size(), std::max(timeoutMs, 0)) < 0 && errno != EINTR)
+			break;
+
+		now = std::chrono::steady_clock::now();
+
+		size_t	pollIndex = 0;
+		bool	acceptPending = false;
+
+		if (m_listenSocket >= 0)
+			acceptPending = (pollSockets[pollIndex++].revents & POLLIN) != 0;
+
+		// Service the connections polled above, new connections are only appended after this
+		for (size_t i = 0; i < m_connections.size(); pollIndex++)
+		{
+			HttpConnection&	connection = m_connections[i];
+			short			events = pollSockets[pollIndex].revents;
+			bool			keepOpen = true;
+
+			if (events & (POLLERR | POLLNVAL))
+				keepOpen = false;
+			else if (events & (POLLIN | POLLHUP))
+				keepOpen = connection.response.empty() ? readRequest(connection) : writeResponse(connection);
+			else if (events & POLLOUT)
+				keepOpen = writeResponse(connection);
+
+			if (keepOpen && (now >= connection.deadline))
+				keepOpen = false;
+
+			if (keepOpen)
+			{
+				i++;
+				continue;
+			}
+
+			close(connection.socket);
+			m_connections.erase(m_connections.begin() + i);
+		}
+
+		if (acceptPending)
+			acceptConnections();
+
+		if ((m_snapshot != nullptr) && (now >= nextSnapshotTime))
+		{
+			updateSnapshot();
+			nextSnapshotTime += std::chrono::milliseconds(m_snapshotIntervalMs);
+			if (nextSnapshotTime < now)
+				nextSnapshotTime = now + std::chrono::milliseconds(m_snapshotIntervalMs);
+		}
+	}
+
+	closeConnections();
+}
+
+void MetricsServer::acceptConnections()
+{
+	while (true)
+	{
+		int connectionSocket = accept(m_listenSocket, nullptr, nullptr);
+		if (connectionSocket < 0)
+			return;
+
+		// Refuse connections beyond the limit rather than let them wait behind the others
+		if ((m_connections.size() >= kMaxHttpConnections) || !setNonBlocking(connectionSocket))
+		{
+			close(connectionSocket);
+			continue;
+		}
+
+		HttpConnection connection;
+		connection.socket		= connectionSocket;
+		connection.responseSent	= 0;
+		connection.deadline		= std::chrono::steady_clock::now() + std::chrono::milliseconds(kHttpRequestTimeoutMs);
+		m_connections.push_back(std::move(connection));
+	}
+}
+
+bool MetricsServer::readRequest(HttpConnection& connection)
+{
+	char buffer[kMaxHttpRequestSize];
+
+	// Read request headers, the request body is ignored
+	while (true)
+	{
+		ssize_t bytesRead = read(connection.socket, buffer, std::min(sizeof(buffer), kMaxHttpRequestSize - connection.request.size()));
+		if (bytesRead < 0)
+			return (errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR);
+		if (bytesRead == 0)
+			return false;
+
+		connection.request.append(buffer, bytesRead);
+
+		if ((connection.request.find("\r\n\r\n") != std::string::npos) || (connection.request.find("\n\n") != std::string::npos))
+			break;
+
+		if (connection.request.size() >= kMaxHttpRequestSize)
+			return false;
+	}
+
+	const std::string& request = connection.request;
+
+	if ((request.compare(0, 13, "GET /metrics ") == 0) || (request.compare(0, 6, "GET / ") == 0))
+	{
+		std::string body = m_registry.getPrometheusText();
+
+		connection.response =	"HTTP/1.1 200 OK\r\n"
+								"Content-Type: text/plain; version=0.0.4\r\n"
+								"Connection: close\r\n"
+								"Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+	}
+	else
+	{
+		connection.response =	"HTTP/1.1 404 Not Found\r\n"
+								"Connection: close\r\n"
+								"Content-Length: 0\r\n\r\n";
+	}
+
+	// Send as much as the socket accepts now, the rest when it is writable
+	return writeResponse(connection);
+}
+
+bool MetricsServer::writeResponse(HttpConnection& connection)
+{
+	while (connection.responseSent < connection.response.size())
+	{
+		ssize_t bytesWritten = send(connection.socket, connection.response.data() + connection.responseSent,
+									connection.response.size() - connection.responseSent, MSG_NOSIGNAL);
+		if (bytesWritten < 0)
+			return (errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR);
+
+		connection.responseSent += bytesWritten;
+	}
+
+	// Response complete, the connection is closed
+	return false;
+}
+
+void MetricsServer::closeConnections()
+{
+	for (const HttpConnection& connection : m_connections)
+		close(connection.socket);
+
+	m_connections.clear();
+}
+
+void MetricsServer::updateSnapshot()
+{
+	struct timespec	now;
+	uint64_t		sequence = m_snapshot->sequence.load(std::memory_order_relaxed);
+	size_t			sampleCount;
+
+	// Gather samples outside of the snapshot update so that readers retry for the shortest time
+	m_registry.getSamples(m_snapshotSamples);
+	sampleCount = std::min(m_snapshotSamples.size(), kMetricsSnapshotMaxSamples);
+
+	clock_gettime(CLOCK_REALTIME, &now);
+
+	m_snapshot->sequence.store(sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	for (size_t i = 0; i < sampleCount; i++)
+	{
+		strncpy(m_snapshot->samples[i].name, m_snapshotSamples[i].name.c_str(), kMetricsSnapshotNameLength - 1);
+		m_snapshot->samples[i].name[kMetricsSnapshotNameLength - 1] = '\0';
+		m_snapshot->samples[i].value = m_snapshotSamples[i].value;
+	}
+
+	m_snapshot->sampleCount	= (uint32_t)sampleCount;
+	m_snapshot->updateTime	= (int64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+
+	m_snapshot->sequence.store(sequence + 2, std::memory_order_release);
+}
@@ -0,0 +1,126 @@
+/* -LICENSE-START-
+** Copyright (c) 2022 Blackmagic Design
+**  
+** Permission is hereby granted, free of charge, to any person or organization 
+** obtaining a copy of the software and accompanying documentation (the 
+** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+** and transmit the Software, and to prepare derivative works of the Software, 
+** and to permit third-parties to whom the Software is furnished to do so, in 
+** accordance with:
+** 
+** (1) if the Software is obtained from Blackmagic Design, the End User License 
+** Agreement for the Software Development Kit (“EULA”) available at 
+** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+** 
+** (2) if the Software is obtained from any third party, such licensing terms 
+** as notified by that third party,
+** 
+** and all subject to the following:
+** 
+** (3) the copyright notices in the Software and this entire statement, 
+** including the above license grant, this restriction and the following 
+** disclaimer, must be included in all copies of the Software, in whole or in 
+** part, and all derivative works of the Software, unless such copies or 
+** derivative works are solely in the form of machine-executable object code 
+** generated by a source language processor.
+** 
+** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+** DEALINGS IN THE SOFTWARE.
+** 
+** A copy of the Software is available free of charge at 
+** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+** 
+** -LICENSE-END-
+*/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+
+#include "MetricsRegistry.h"
+
+// Layout of shared memory metrics snapshot.  Readers should map the shared memory object read-only and
+// retry if the sequence is odd or changes while reading the samples.
+const uint32_t	kMetricsSnapshotMagic		= 0x4d4c4b44;		// 'DKLM'
+const uint32_t	kMetricsSnapshotVersion		= 1;
+const size_t	kMetricsSnapshotMaxSamples	= 1024;
+const size_t	kMetricsSnapshotNameLength	= 120;
+
+struct MetricsSnapshotSample
+{
+	char					name[kMetricsSnapshotNameLength];
+	double					value;
+};
+
+struct MetricsSnapshot
+{
+	uint32_t				magic;
+	uint32_t				version;
+	std::atomic<uint64_t>	sequence;			// Odd while snapshot is being updated
+	int64_t					updateTime;			// CLOCK_REALTIME, milliseconds since epoch
+	uint32_t				sampleCount;
+	uint32_t				maxSamples;
+	MetricsSnapshotSample	samples[kMetricsSnapshotMaxSamples];
+};
+
+// The MetricsServer serves the registry in Prometheus text format over HTTP, on either a localhost TCP port or a
+// Unix domain socket, and periodically publishes a snapshot of all samples to a POSIX shared memory object.
+// Connections are non-blocking and polled together by the server thread, so a slow or idle client cannot hold up
+// other scrapes or the snapshot updates.
+class MetricsServer
+{
+public:
+	MetricsServer(MetricsRegistry& registry);
+	virtual ~MetricsServer();
+
+	// Listen on a TCP port (bound to loopback only) or a Unix domain socket path for HTTP scraping
+	bool				listenHttp(uint16_t port);
+	bool				listenHttp(const std::string& socketPath);
+
+	// Shared memory name must start with '/', eg "/InputLoopThrough.metrics".  Fails with errno set, to EEXIST if the
+	// object already exists
+	bool				createSharedMemory(const std::string& sharedMemoryName, int updateIntervalMs);
+
+	void				start(void);
+	void				stop(void);
+
+private:
+	struct HttpConnection
+	{
+		int										socket;
+		std::string								request;
+		std::string								response;
+		size_t									responseSent;
+		std::chrono::steady_clock::time_point	deadline;		// Closed if the response is not sent by then
+	};
+
+	MetricsRegistry&						m_registry;
+	int										m_listenSocket;
+	std::string								m_socketPath;
+	//
+	std::string								m_sharedMemoryName;
+	MetricsSnapshot*						m_snapshot;
+	int										m_snapshotIntervalMs;
+	std::vector<MetricsRegistry::MetricSample>	m_snapshotSamples;
+	//
+	std::vector<HttpConnection>				m_connections;
+	std::atomic<bool>						m_stopServer;
+	std::thread								m_serverThread;
+
+	void				serverThread(void);
+	void				acceptConnections(void);
+	bool				readRequest(HttpConnection& connection);
+	bool				writeResponse(HttpConnection& connection);
+	void				closeConnections(void);
+	void				updateSnapshot(void);
+};
@@ -0,0 +1,153 @@
+/* -LICENSE-START-
+** Copyright (c) 2022 Blackmagic Design
+**  
+** Permission is hereby granted, free of charge, to any person or organization 
+** obtaining a copy of the software and accompanying documentation (the 
+** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+** and transmit the Software, and to prepare derivative works of the Software, 
+** and to permit third-parties to whom the Software is furnished to do so, in 
+** accordance with:
+** 
+** (1) if the Software is obtained from Blackmagic Design, the End User License 
+** Agreement for the Software Development Kit (“EULA”) available at 
+** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+** 
+** (2) if the Software is obtained from any third party, such licensing terms 
+** as notified by that third party,
+** 
+** and all subject to the following:
+** 
+** (3) the copyright notices in the Software and this entire statement, 
+** including the above license grant, this restriction and the following 
+** disclaimer, must be included in all copies of the Software, in whole or in 
+** part, and all derivative works of the Software, unless such copies or 
+** derivative works are solely in the form of machine-executable object code 
+** generated by a source language processor.
+** 
+** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+** DEALINGS IN THE SOFTWARE.
+** 
+** A copy of the Software is available free of charge at 
+** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+** 
+** -LICENSE-END-
+*/
+
+#include <stdio.h>
+#include <inttypes.h>
+
+#include "TraceRecorder.h"
+#include "ReferenceTime.h"
+
+TraceRecorder::TraceRecorder(size_t capacity) :
+	m_capacity(1),
+	m_writeIndex(0)
+{
+	while (m_capacity < capacity)
+		m_capacity <<= 1;
+
+	m_spans.reset(new TraceSpan[m_capacity]);
+	reset();
+}
+
+void TraceRecorder::reset()
+{
+	for (uint64_t i = 0; i < m_capacity; i++)
+		m_spans[i].sequence.store(0, std::memory_order_relaxed);
+
+	m_writeIndex.store(0, std::memory_order_release);
+}
+
+void TraceRecorder::addSpan(TraceStage stage, int64_t frameNumber, BMDTimeValue startReferenceTime, BMDTimeValue endReferenceTime)
+{
+	uint64_t	writeIndex	= m_writeIndex.fetch_add(1, std::memory_order_relaxed);
+	TraceSpan&	span		= m_spans[writeIndex & (m_capacity - 1)];
+
+	// Sequence is odd while the span is being written and even with the write index once complete,
+	// the oldest span is overwritten once the ring is full
+	span.sequence.store((writeIndex << 1) | 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	span.stage.store((int)stage, std::memory_order_relaxed);
+	span.frameNumber.store(frameNumber, std::memory_order_relaxed);
+	span.startTime.store(startReferenceTime, std::memory_order_relaxed);
+	span.endTime.store(endReferenceTime, std::memory_order_relaxed);
+
+	span.sequence.store((writeIndex + 1) << 1, std::memory_order_release);
+}
+
+bool TraceRecorder::writeChromeTrace(const char* filePath)
+{
+	FILE*		traceFile;
+	uint64_t	writeIndex	= m_writeIndex.load(std::memory_order_acquire);
+	uint64_t	readIndex	= (writeIndex > m_capacity) ? writeIndex - m_capacity : 0;
+
+	traceFile = fopen(filePath, "w");
+	if (traceFile == nullptr)
+		return false;
+
+	fprintf(traceFile, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+	fprintf(traceFile, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"InputLoopThrough\"}}");
+
+	for (; readIndex < writeIndex; readIndex++)
+	{
+		TraceSpan&	span			= m_spans[readIndex & (m_capacity - 1)];
+		uint64_t	sequence		= span.sequence.load(std::memory_order_acquire);
+
+		int			stage			= span.stage.load(std::memory_order_relaxed);
+		int64_t		frameNumber		= span.frameNumber.load(std::memory_order_relaxed);
+		int64_t		startTime		= span.startTime.load(std::memory_order_relaxed);
+		int64_t		endTime			= span.endTime.load(std::memory_order_relaxed);
+
+		// Skip spans that are incomplete or were overwritten while reading
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if ((sequence != (readIndex + 1) << 1) || (span.sequence.load(std::memory_order_relaxed) != sequence))
+			continue;
+
+		if ((stage < 0) || (stage >= (int)TraceStage::Count))
+			continue;
+
+		// Frames overlap within a stage, eg. VideoProcessing runs on several dispatcher threads, so each span is written as
+		// an async begin/end pair keyed by frame number rather than a complete event on a single thread track.  The viewer
+		// then gives each stage its own track and stacks overlapping frames on separate rows.
+		// Chrome trace timestamps are in microseconds
+		for (int phase = 0; phase < 2; phase++)
+		{
+			fprintf(traceFile, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"%c\",\"id\":%" PRId64 ",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"args\":{\"frame\":%" PRId64 "}}",
+					getStageName((TraceStage)stage),
+					(stage < (int)TraceStage::AudioDispatchWait) ? "video" : "audio",
+					(phase == 0) ? 'b' : 'e',
+					frameNumber,
+					(double)((phase == 0) ? startTime : endTime) * 1000000.0 / ReferenceTime::kTimescale,
+					frameNumber);
+		}
+	}
+
+	fprintf(traceFile, "\n]}\n");
+	fclose(traceFile);
+
+	return true;
+}
+
+const char* TraceRecorder::getStageName(TraceStage stage)
+{
+	switch (stage)
+	{
+		case TraceStage::VideoInput:			return "Video input";
+		case TraceStage::VideoCallback:			return "Video callback";
+		case TraceStage::VideoDispatchWait:		return "Video dispatch wait";
+		case TraceStage::VideoProcessing:		return "Video processing";
+		case TraceStage::VideoScheduleWait:		return "Video schedule wait";
+		case TraceStage::VideoOutput:			return "Video output";
+		case TraceStage::AudioDispatchWait:		return "Audio dispatch wait";
+		case TraceStage::AudioProcessing:		return "Audio processing";
+		case TraceStage::AudioScheduleWait:		return "Audio schedule wait";
+		default:								return "Unknown";
+	}
+}
@@ -0,0 +1,93 @@
+/* -LICENSE-START-
+** Copyright (c) 2022 Blackmagic Design
+**  
+** Permission is hereby granted, free of charge, to any person or organization 
+** obtaining a copy of the software and accompanying documentation (the 
+** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+** and transmit the Software, and to prepare derivative works of the Software, 
+** and to permit third-parties to whom the Software is furnished to do so, in 
+** accordance with:
+** 
+** (1) if the Software is obtained from Blackmagic Design, the End User License 
+** Agreement for the Software Development Kit (“EULA”) available at 
+** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+** 
+** (2) if the Software is obtained from any third party, such licensing terms 
+** as notified by that third party,
+** 
+** and all subject to the following:
+** 
+** (3) the copyright notices in the Software and this entire statement, 
+** including the above license grant, this restriction and the following 
+** disclaimer, must be included in all copies of the Software, in whole or in 
+** part, and all derivative works of the Software, unless such copies or 
+** derivative works are solely in the form of machine-executable object code 
+** generated by a source language processor.
+** 
+** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+** DEALINGS IN THE SOFTWARE.
+** 
+** A copy of the Software is available free of charge at 
+** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+** 
+** -LICENSE-END-
+*/
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <stdint.h>
+#include "DeckLinkAPI.h"
+
+// Pipeline stages traced for each video frame and audio packet, each stage is displayed as a separate async track
+enum class TraceStage
+{
+	VideoInput,				// Start of frame on the wire to VideoInputFrameArrived callback
+	VideoCallback,			// VideoInputFrameArrived callback to dispatch to processing queue
+	VideoDispatchWait,		// Waiting in dispatch queue for a processing thread
+	VideoProcessing,		// processVideo
+	VideoScheduleWait,		// Waiting in output queue for ScheduleVideoFrame
+	VideoOutput,			// ScheduleVideoFrame to start of frame output on the wire
+	AudioDispatchWait,
+	AudioProcessing,
+	AudioScheduleWait,
+	Count
+};
+
+// The TraceRecorder keeps the most recent spans in a preallocated ring, so that recording a span never allocates
+// or blocks.  The ring can be written as a Chrome trace event JSON file, which can be opened with chrome://tracing
+// or the Perfetto UI (https://ui.perfetto.dev).
+class TraceRecorder
+{
+	struct TraceSpan
+	{
+		std::atomic<uint64_t>		sequence;		// Odd while span is being written
+		std::atomic<int>			stage;
+		std::atomic<int64_t>		frameNumber;
+		std::atomic<int64_t>		startTime;
+		std::atomic<int64_t>		endTime;
+	};
+
+public:
+	TraceRecorder(size_t capacity);
+	virtual ~TraceRecorder() = default;
+
+	void			addSpan(TraceStage stage, int64_t frameNumber, BMDTimeValue startReferenceTime, BMDTimeValue endReferenceTime);
+	void			reset(void);
+
+	// Write all spans in ring to file, should not be called from real-time threads
+	bool			writeChromeTrace(const char* filePath);
+
+	static const char*	getStageName(TraceStage stage);
+
+private:
+	std::unique_ptr<TraceSpan[]>	m_spans;
+	uint64_t						m_capacity;
+	std::atomic<uint64_t>			m_writeIndex;
+};
@@ -0,0 +1,446 @@
+/* -LICENSE-START-
+ ** Copyright (c) 2022 Blackmagic Design
+ **  
+ ** Permission is hereby granted, free of charge, to any person or organization 
+ ** obtaining a copy of the software and accompanying documentation (the 
+ ** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+ ** and transmit the Software, and to prepare derivative works of the Software, 
+ ** and to permit third-parties to whom the Software is furnished to do so, in 
+ ** accordance with:
+ ** 
+ ** (1) if the Software is obtained from Blackmagic Design, the End User License 
+ ** Agreement for the Software Development Kit (“EULA”) available at 
+ ** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+ ** 
+ ** (2) if the Software is obtained from any third party, such licensing terms 
+ ** as notified by that third party,
+ ** 
+ ** and all subject to the following:
+ ** 
+ ** (3) the copyright notices in the Software and this entire statement, 
+ ** including the above license grant, this restriction and the following 
+ ** disclaimer, must be included in all copies of the Software, in whole or in 
+ ** part, and all derivative works of the Software, unless such copies or 
+ ** derivative works are solely in the form of machine-executable object code 
+ ** generated by a source language processor.
+ ** 
+ ** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ ** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ ** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+ ** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+ ** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+ ** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ ** DEALINGS IN THE SOFTWARE.
+ ** 
+ ** A copy of the Software is available free of charge at 
+ ** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+ ** 
+ ** -LICENSE-END-
+ */
+
+//
+// CompositeBenchmark.cpp
+// LoopThroughWithOpenGLCompositing
+//
+
+#include "CompositeBenchmark.h"
+#include "CompositeRenderer.h"
+#include "GLExtensions.h"
+#include "HeadlessGLContext.h"
+#include "ReadbackPipeline.h"
+#include "TextureUploadRing.h"
+#include "V210Converter.h"
+#include <GL/glu.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+
+// Same pipeline depths as used by OpenGLComposite when the fast transfer extension is not available
+static const unsigned kBenchmarkUploadRingDepth = 3;
+static const unsigned kBenchmarkReadbackDepth = 2;
+
+static int64_t GetTimeNs()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (int64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+// Fill a UYVY frame with vertical bars of different luma and chroma so the upload and shader work on real data
+static void FillCaptureFrame(std::vector<uint8_t>& frame, unsigned width, unsigned height)
+{
+	for (unsigned y = 0; y < height; y++)
+	{
+		uint8_t* row = &frame[y * width * 2];
+		for (unsigned x = 0; x < width; x += 2)
+		{
+			unsigned bar = (x * 8) / width;
+			row[x*2 + 0] = (uint8_t)(64 + bar * 16);		// Cb
+			row[x*2 + 1] = (uint8_t)(16 + bar * 27);		// Y0
+			row[x*2 + 2] = (uint8_t)(192 - bar * 16);		// Cr
+			row[x*2 + 3] = (uint8_t)(16 + bar * 27);		// Y1
+		}
+	}
+}
+
+// Fill a v210 frame with vertical bars, as FillCaptureFrame does for UYVY
+static void FillCaptureFrameV210(std::vector<uint8_t>& frame, unsigned width, unsigned height)
+{
+	unsigned rowBytes = V210Converter::getRowBytes(width);
+
+	for (unsigned y = 0; y < height; y++)
+	{
+		uint32_t* row = (uint32_t*)&frame[y * rowBytes];
+		for (unsigned word = 0; word < rowBytes / 4; word++)
+		{
+			// Components in each word are coloured by the bar of the first pixel the word covers, the colours
+			// are within the RGB gamut so they survive conversion to RGB and back
+			unsigned x = (word / 4) * 6 + ((word % 4) * 3) / 2;
+			unsigned bar = (x < width) ? (x * 8) / width : 7;
+			uint32_t Y = 200 + bar * 90;
+			uint32_t Cb = 448 + bar * 16;
+			uint32_t Cr = 576 - bar * 16;
+
+			switch (word % 4)
+			{
+				case 0:		row[word] = Cb | (Y << 10) | (Cr << 20);	break;
+				case 1:		row[word] = Y | (Cb << 10) | (Y << 20);		break;
+				case 2:		row[word] = Cr | (Y << 10) | (Cb << 20);	break;
+				default:	row[word] = Y | (Cr << 10) | (Y << 20);		break;
+			}
+		}
+	}
+}
+
+static inline unsigned V210Component(uint32_t word, unsigned component)
+{
+	return (word >> (component * 10)) & 0x3ff;
+}
+
+static inline unsigned QuantizeUnorm10(float value)
+{
+	if (value < 0.0f)
+		value = 0.0f;
+	else if (value > 1.0f)
+		value = 1.0f;
+	return (unsigned)floorf(value * 1023.0f + 0.5f);
+}
+
+// CPU reference for the V210Converter unpack shader, converts v210 to RGB10_A2 pixels using the same arithmetic
+static void UnpackV210Frame(const uint8_t* packed, uint32_t* rgb, unsigned width, unsigned height)
+{
+	unsigned rowBytes = V210Converter::getRowBytes(width);
+
+	for (unsigned y = 0; y < height; y++)
+	{
+		const uint32_t* words = (const uint32_t*)(packed + y * rowBytes);
+		uint32_t* row = rgb + y * width;
+
+		for (unsigned x = 0; x < width; x++)
+		{
+			const uint32_t* w = words + (x / 6) * 4;
+			unsigned index = x % 6;
+			float Y, Cb, Cr;
+
+			switch (index)
+			{
+				case 0:	Y = V210Component(w[0], 1); Cb = V210Component(w[0], 0); Cr = V210Component(w[0], 2); break;
+				case 1:	Y = V210Component(w[1], 0);
+						Cb = (V210Component(w[0], 0) + V210Component(w[1], 1)) * 0.5f;
+						Cr = (V210Component(w[0], 2) + V210Component(w[2], 0)) * 0.5f; break;
+				case 2:	Y = V210Component(w[1], 2); Cb = V210Component(w[1], 1); Cr = V210Component(w[2], 0); break;
+				case 3:	Y = V210Component(w[2], 1);
+						Cb = (V210Component(w[1], 1) + V210Component(w[2], 2)) * 0.5f;
+						Cr = (V210Component(w[2], 0) + V210Component(w[3], 1)) * 0.5f; break;
+				case 4:	Y = V210Component(w[3], 0); Cb = V210Component(w[2], 2); Cr = V210Component(w[3], 1); break;
+				default:
+					Y = V210Component(w[3], 2);
+					if (x + 1 < width)
+					{
+						Cb = (V210Component(w[2], 2) + V210Component(w[4], 0)) * 0.5f;
+						Cr = (V210Component(w[3], 1) + V210Component(w[4], 2)) * 0.5f;
+					}
+					else
+					{
+						Cb = V210Component(w[2], 2);
+						Cr = V210Component(w[3], 1);
+					}
+					break;
+			}
+
+			Y = (Y - 64.0f) / 876.0f;
+			Cb = (Cb - 512.0f) / 896.0f;
+			Cr = (Cr - 512.0f) / 896.0f;
+
+			row[x] = QuantizeUnorm10(Y + 1.5748f * Cr) |
+					(QuantizeUnorm10(Y - 0.1873f * Cb - 0.4681f * Cr) << 10) |
+					(QuantizeUnorm10(Y + 1.8556f * Cb) << 20) |
+					(3u << 30);
+		}
+	}
+}
+
+// CPU reference for the V210Converter pack shader, converts RGB10_A2 pixels to v210 and flips the frame vertically
+static void PackV210Frame(const uint32_t* rgb, uint8_t* packed, unsigned width, unsigned height)
+{
+	unsigned rowBytes = V210Converter::getRowBytes(width);
+	unsigned paddedWidth = (rowBytes / 16) * 6;
+	std::vector<float> Y(paddedWidth), Cb(paddedWidth), Cr(paddedWidth);
+
+	for (unsigned y = 0; y < height; y++)
+	{
+		const uint32_t* row = rgb + (height - 1 - y) * width;
+		uint32_t* words = (uint32_t*)(packed + y * rowBytes);
+
+		// Pixels past the end of the row repeat the last pixel
+		for (unsigned x = 0; x < paddedWidth; x++)
+		{
+			uint32_t pixel = row[x < width ? x : width - 1];
+			float r = V210Component(pixel, 0) / 1023.0f;
+			float g = V210Component(pixel, 1) / 1023.0f;
+			float b = V210Component(pixel, 2) / 1023.0f;
+			float luma = 0.2126f * r + 0.7152f * g + 0.0722f * b;
+
+			Y[x] = 64.0f + 876.0f * luma;
+			Cb[x] = 512.0f + 896.0f * (b - luma) / 1.8556f;
+			Cr[x] = 512.0f + 896.0f * (r - luma) / 1.5748f;
+		}
+
+		for (unsigned group = 0; group < rowBytes / 16; group++)
+		{
+			unsigned x = group * 6;
+
+			float components[12] = {
+				(Cb[x] + Cb[x+1]) * 0.5f,	Y[x],		(Cr[x] + Cr[x+1]) * 0.5f,
+				Y[x+1],		(Cb[x+2] + Cb[x+3]) * 0.5f,	Y[x+2],
+				(Cr[x+2] + Cr[x+3]) * 0.5f,	Y[x+3],		(Cb[x+4] + Cb[x+5]) * 0.5f,
+				Y[x+4],		(Cr[x+4] + Cr[x+5]) * 0.5f,	Y[x+5]
+			};
+
+			for (unsigned word = 0; word < 4; word++)
+			{
+				uint32_t packedWord = 0;
+				for (unsigned component = 0; component < 3; component++)
+				{
+					float value = floorf(components[word * 3 + component] + 0.5f);
+					value = (value < 4.0f) ? 4.0f : (value > 1019.0f) ? 1019.0f : value;
+					packedWord |= (uint32_t)value << (component * 10);
+				}
+				words[group * 4 + word] = packedWord;
+			}
+		}
+	}
+}
+
+// Compare converting v210 to RGB and back in the GPU, including the synchronous upload and readback a CPU
+// implementation would avoid, against the CPU reference implementation
+static void RunV210ConversionComparison(V210Converter& converter, GLuint rgbTexture, const std::vector<uint8_t>& captureFrame,
+										unsigned width, unsigned height, unsigned frameCount)
+{
+	std::vector<uint8_t>	gpuFrame(captureFrame.size());
+	std::vector<uint8_t>	cpuFrame(captureFrame.size());
+	std::vector<uint32_t>	cpuRGB(width * height);
+	unsigned				maxDifference = 0;
+	int64_t					startTime;
+	double					gpuTimeMs;
+	double					cpuTimeMs;
+
+	startTime = GetTimeNs();
+	for (unsigned frame = 0; frame < frameCount; frame++)
+	{
+		glBindTexture(GL_TEXTURE_2D, converter.getPackedInputTexture());
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, converter.getPackedWidth(), height, GL_RGBA, GL_UNSIGNED_INT_2_10_10_10_REV, &captureFrame[0]);
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		converter.unpack();
+		converter.pack(rgbTexture);
+		glReadPixels(0, 0, converter.getPackedWidth(), height, GL_RGBA, GL_UNSIGNED_INT_2_10_10_10_REV, &gpuFrame[0]);
+	}
+	gpuTimeMs = (GetTimeNs() - startTime) / 1000000.0 / frameCount;
+	glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, 0);
+
+	startTime = GetTimeNs();
+	for (unsigned frame = 0; frame < frameCount; frame++)
+	{
+		UnpackV210Frame(&captureFrame[0], &cpuRGB[0], width, height);
+		PackV210Frame(&cpuRGB[0], &cpuFrame[0], width, height);
+	}
+	cpuTimeMs = (GetTimeNs() - startTime) / 1000000.0 / frameCount;
+
+	// Only compare the three components of each word, the alpha bits are padding
+	const uint32_t* gpuWords = (const uint32_t*)&gpuFrame[0];
+	const uint32_t* cpuWords = (const uint32_t*)&cpuFrame[0];
+	for (size_t i = 0; i < gpuFrame.size() / 4; i++)
+	{
+		for (unsigned component = 0; component < 3; component++)
+		{
+			unsigned difference = abs((int)V210Component(gpuWords[i], component) - (int)V210Component(cpuWords[i], component));
+			if (difference > maxDifference)
+				maxDifference = difference;
+		}
+	}
+
+	printf("v210 unpack and pack round trip, %u frames:\n", frameCount);
+	printf("  GPU (with upload and readback): %.3f ms/frame\n", gpuTimeMs);
+	printf("  CPU:                            %.3f ms/frame\n", cpuTimeMs);
+	printf("  Largest difference:             %u codes\n", maxDifference);
+}
+
+bool RunCompositeBenchmark(unsigned width, unsigned height, unsigned frameCount, bool v210)
+{
+	HeadlessGLContext					context;
+	TextureUploadRing*					uploadRing = NULL;
+	ReadbackPipeline*					readback = NULL;
+	CompositeRenderer					renderer;
+	V210Converter						converter;
+	TextureUploadRing::Statistics		uploadStatistics;
+	ReadbackPipeline::Statistics		readbackStatistics;
+	unsigned							captureRowBytes = v210 ? V210Converter::getRowBytes(width) : width * 2;
+	unsigned							outputRowBytes = v210 ? V210Converter::getRowBytes(width) : width * 4;
+	std::vector<uint8_t>				captureFrame(captureRowBytes * height);
+	std::vector<uint8_t>				outputFrame(outputRowBytes * height);
+	char								errorMessage[1024];
+	int64_t								captureCopyTimeNs = 0;
+	int64_t								uploadTimeNs = 0;
+	int64_t								renderTimeNs = 0;
+	int64_t								readbackTimeNs = 0;
+	int64_t								readbackWaitTimeNs = 0;
+	int64_t								readbackCopyTimeNs = 0;
+	int64_t								startTime;
+	int64_t								stageTime;
+	double								totalTimeSeconds;
+	bool								bSuccess = false;
+
+	if (! context.initialize() || ! context.makeCurrent())
+	{
+		fprintf(stderr, "Could not create a headless OpenGL context\n");
+		return false;
+	}
+
+	if (! ResolveGLExtensions(HeadlessGLContext::getProcAddress))
+	{
+		fprintf(stderr, "OpenGL extensions required by this application are not available\n");
+		return false;
+	}
+
+	const GLubyte* strExt = glGetString(GL_EXTENSIONS);
+	bool hasBufferStorage = gluCheckExtension((const GLubyte*)"GL_ARB_buffer_storage", strExt);
+	bool hasTimerQuery = gluCheckExtension((const GLubyte*)"GL_ARB_timer_query", strExt);
+
+	if (! renderer.initialize(width, height, v210 ? CompositeRenderer::kCaptureTextureRGB10 : CompositeRenderer::kCaptureTextureUYVY,
+							  35.0f / 30.0f, sizeof(errorMessage), errorMessage))
+	{
+		fprintf(stderr, "Could not initialize renderer: %s\n", errorMessage);
+		goto error;
+	}
+
+	if (v210 && ! converter.initialize(width, height, renderer.getCaptureTexture(), sizeof(errorMessage), errorMessage))
+	{
+		fprintf(stderr, "Could not initialize v210 converter: %s\n", errorMessage);
+		goto error;
+	}
+
+	uploadRing = new TextureUploadRing(kBenchmarkUploadRingDepth, captureRowBytes * height);
+	readback = new ReadbackPipeline(kBenchmarkReadbackDepth);
+
+	if (! uploadRing->initialize(hasBufferStorage, hasTimerQuery) ||
+		! (v210 ? readback->initialize(converter.getPackedWidth(), height, GL_RGBA, GL_UNSIGNED_INT_2_10_10_10_REV) : readback->initialize(width, height)))
+	{
+		fprintf(stderr, "Could not initialize pixel buffers\n");
+		goto error;
+	}
+
+	if (v210)
+		FillCaptureFrameV210(captureFrame, width, height);
+	else
+		FillCaptureFrame(captureFrame, width, height);
+
+	startTime = GetTimeNs();
+
+	for (unsigned frame = 0; frame < frameCount; frame++)
+	{
+		// Copy performed by the capture thread in the DeckLink input callback
+		stageTime = GetTimeNs();
+		uploadRing->writeFrame(&captureFrame[0], captureFrame.size());
+		captureCopyTimeNs += GetTimeNs() - stageTime;
+
+		stageTime = GetTimeNs();
+		if (v210)
+		{
+			if (uploadRing->uploadToTexture(converter.getPackedInputTexture(), converter.getPackedWidth(), height, GL_RGBA, GL_UNSIGNED_INT_2_10_10_10_REV))
+				converter.unpack();
+		}
+		else
+		{
+			uploadRing->uploadToTexture(renderer.getCaptureTexture(), width/2, height, GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV);
+		}
+		uploadTimeNs += GetTimeNs() - stageTime;
+
+		stageTime = GetTimeNs();
+		renderer.renderFrame(false);
+		if (v210)
+			converter.pack(renderer.getFrameBufferTexture());
+		renderTimeNs += GetTimeNs() - stageTime;
+
+		stageTime = GetTimeNs();
+		if (readback->isFull())
+		{
+			readback->completeReadback(&outputFrame[0], outputRowBytes, true);
+
+			readback->getStatistics(readbackStatistics);
+			readbackWaitTimeNs += (int64_t)(readbackStatistics.lastWaitTimeMs * 1000000.0);
+			readbackCopyTimeNs += (int64_t)(readbackStatistics.lastCopyTimeMs * 1000000.0);
+		}
+		readback->beginReadback();
+		readbackTimeNs += GetTimeNs() - stageTime;
+	}
+
+	// Drain the frames still being read back
+	stageTime = GetTimeNs();
+	while (readback->getPendingCount() > 0)
+		readback->completeReadback(&outputFrame[0], outputRowBytes, true);
+	readbackTimeNs += GetTimeNs() - stageTime;
+
+	totalTimeSeconds = (GetTimeNs() - startTime) / 1000000000.0;
+
+	uploadRing->getStatistics(uploadStatistics);
+
+	printf("Composited %u %s frames at %ux%u in %.3f seconds using %s: %.1f frames/s\n",
+			frameCount, v210 ? "10-bit v210" : "8-bit UYVY", width, height, totalTimeSeconds, (const char*)glGetString(GL_RENDERER), frameCount / totalTimeSeconds);
+	printf("  Upload ring depth:        %u (%s)\n", kBenchmarkUploadRingDepth, uploadRing->isPersistentlyMapped() ? "persistently mapped" : "mapped");
+	printf("  Readback pipeline depth:  %u\n", kBenchmarkReadbackDepth);
+	printf("  Capture copy:             %.3f ms/frame\n", captureCopyTimeNs / 1000000.0 / frameCount);
+	printf("  Texture upload:           %.3f ms/frame (%llu frames uploaded, %llu skipped)\n", uploadTimeNs / 1000000.0 / frameCount,
+			(unsigned long long)uploadStatistics.framesUploaded, (unsigned long long)uploadStatistics.framesSkipped);
+	printf("  Render:                   %.3f ms/frame\n", renderTimeNs / 1000000.0 / frameCount);
+	printf("  Readback:                 %.3f ms/frame (fence wait %.3f ms, buffer copy %.3f ms)\n",
+			readbackTimeNs / 1000000.0 / frameCount, readbackWaitTimeNs / 1000000.0 / frameCount, readbackCopyTimeNs / 1000000.0 / frameCount);
+
+	if (v210)
+		RunV210ConversionComparison(converter, renderer.getCaptureTexture(), captureFrame, width, height, frameCount);
+
+	bSuccess = true;
+
+error:
+	if (readback != NULL)
+	{
+		readback->cleanup();
+		delete readback;
+	}
+
+	if (uploadRing != NULL)
+	{
+		uploadRing->cleanup();
+		delete uploadRing;
+	}
+
+	converter.cleanup();
+	renderer.cleanup();
+	context.doneCurrent();
+
+	return bSuccess;
+}
@@ -0,0 +1,415 @@
+/* -LICENSE-START-
+ ** Copyright (c) 2022 Blackmagic Design
+ **  
+ ** Permission is hereby granted, free of charge, to any person or organization 
+ ** obtaining a copy of the software and accompanying documentation (the 
+ ** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+ ** and transmit the Software, and to prepare derivative works of the Software, 
+ ** and to permit third-parties to whom the Software is furnished to do so, in 
+ ** accordance with:
+ ** 
+ ** (1) if the Software is obtained from Blackmagic Design, the End User License 
+ ** Agreement for the Software Development Kit (“EULA”) available at 
+ ** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+ ** 
+ ** (2) if the Software is obtained from any third party, such licensing terms 
+ ** as notified by that third party,
+ ** 
+ ** and all subject to the following:
+ ** 
+ ** (3) the copyright notices in the Software and this entire statement, 
+ ** including the above license grant, this restriction and the following 
+ ** disclaimer, must be included in all copies of the Software, in whole or in 
+ ** part, and all derivative works of the Software, unless such copies or 
+ ** derivative works are solely in the form of machine-executable object code 
+ ** generated by a source language processor.
+ ** 
+ ** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ ** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ ** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+ ** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+ ** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+ ** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ ** DEALINGS IN THE SOFTWARE.
+ ** 
+ ** A copy of the Software is available free of charge at 
+ ** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+ ** 
+ ** -LICENSE-END-
+ */
+
+//
+// CompositeRenderer.cpp
+// LoopThroughWithOpenGLCompositing
+//
+
+#include "CompositeRenderer.h"
+#include "GLExtensions.h"
+#include <GL/glu.h>
+#include <stdio.h>
+
+CompositeRenderer::CompositeRenderer() :
+	mFrameWidth(0), mFrameHeight(0),
+	mCaptureFormat(kCaptureTextureUYVY),
+	mCaptureTexture(0),
+	mFBOTexture(0),
+	mIdFrameBuf(0),
+	mIdColorBuf(0),
+	mIdDepthBuf(0),
+	mProgram(0),
+	mFragmentShader(0),
+	mRotateAngle(0.0f),
+	mRotateAngleRate(0.0f)
+{
+}
+
+CompositeRenderer::~CompositeRenderer()
+{
+}
+
+bool CompositeRenderer::initialize(unsigned width, unsigned height, CaptureTextureFormat captureFormat, float rotateAngleRate, int errorMessageSize, char* errorMessage)
+{
+	// 10-bit capture is composited into a 10-bit frame buffer to keep the precision for playout
+	GLenum frameBufferFormat = (captureFormat == kCaptureTextureRGB10) ? GL_RGB10_A2 : GL_RGBA;
+
+	mFrameWidth = width;
+	mFrameHeight = height;
+	mCaptureFormat = captureFormat;
+	mRotateAngle = 0.0f;
+	mRotateAngleRate = rotateAngleRate;
+
+	// Prepare the shader used to perform colour space conversion on the video texture
+	if (! compileFragmentShader(errorMessageSize, errorMessage))
+		return false;
+
+	// Setup the scene
+	glShadeModel( GL_SMOOTH );					// Enable smooth shading
+	glClearColor( 0.0f, 0.0f, 0.0f, 0.5f );		// Black background
+	glClearDepth( 1.0f );						// Depth buffer setup
+	glEnable( GL_DEPTH_TEST );					// Enable depth testing
+	glDepthFunc( GL_LEQUAL );					// Type of depth test to do
+	glHint( GL_PERSPECTIVE_CORRECTION_HINT, GL_NICEST );
+
+	// Setup the texture which will hold the captured video frame pixels
+	glEnable(GL_TEXTURE_2D);
+	glGenTextures(1, &mCaptureTexture);
+	glBindTexture(GL_TEXTURE_2D, mCaptureTexture);
+
+	// Parameters to control how texels are sampled from the texture
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+
+	// Create texture with empty data, we will update it using glTexSubImage2D each frame.
+	// The captured video is YCbCr 4:2:2 packed into a UYVY macropixel.  OpenGL has no YCbCr format
+	// so treat it as RGBA 4:4:4:4 by halving the width and using GL_RGBA internal format.
+	// 10-bit capture is unpacked from v210 into this texture as RGB pixels by the V210Converter.
+	if (mCaptureFormat == kCaptureTextureRGB10)
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB10_A2, mFrameWidth, mFrameHeight, 0, GL_RGBA, GL_UNSIGNED_INT_2_10_10_10_REV, NULL);
+	else
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, mFrameWidth/2, mFrameHeight, 0, GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV, NULL);
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glDisable(GL_TEXTURE_2D);
+
+	// Create Frame Buffer Object (FBO) to perform off-screen rendering of scene.
+	// This allows the render to be done on a framebuffer with width and height exactly matching the video format.
+	glGenFramebuffersEXT(1, &mIdFrameBuf);
+	glGenRenderbuffersEXT(1, &mIdColorBuf);
+	glGenRenderbuffersEXT(1, &mIdDepthBuf);
+
+	glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, mIdFrameBuf);
+
+	// Texture for FBO
+	glGenTextures(1, &mFBOTexture);
+	glBindTexture(GL_TEXTURE_2D, mFBOTexture);
+	glTexImage2D(GL_TEXTURE_2D, 0, frameBufferFormat, mFrameWidth, mFrameHeight, 0, GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV, NULL);
+
+	// Attach a depth buffer
+	glBindRenderbufferEXT(GL_RENDERBUFFER_EXT, mIdDepthBuf);
+	glRenderbufferStorageEXT(GL_RENDERBUFFER_EXT, GL_DEPTH_COMPONENT, mFrameWidth, mFrameHeight);
+
+	glFramebufferRenderbufferEXT(GL_FRAMEBUFFER_EXT, GL_DEPTH_ATTACHMENT_EXT, GL_RENDERBUFFER_EXT, mIdDepthBuf);
+
+	// Attach the texture which stores the playback image
+	glFramebufferTexture2DEXT(GL_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT, GL_TEXTURE_2D, mFBOTexture, 0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glDisable(GL_TEXTURE_2D);
+
+	GLenum glStatus = glCheckFramebufferStatusEXT(GL_FRAMEBUFFER_EXT);
+	if (glStatus != GL_FRAMEBUFFER_COMPLETE_EXT)
+	{
+		snprintf(errorMessage, errorMessageSize, "Cannot initialize framebuffer.");
+		return false;
+	}
+
+	glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, 0);
+
+	return true;
+}
+
+void CompositeRenderer::cleanup()
+{
+	if (mIdFrameBuf != 0)
+	{
+		glDeleteFramebuffersEXT(1, &mIdFrameBuf);
+		glDeleteRenderbuffersEXT(1, &mIdColorBuf);
+		glDeleteRenderbuffersEXT(1, &mIdDepthBuf);
+		mIdFrameBuf = mIdColorBuf = mIdDepthBuf = 0;
+	}
+
+	if (mFBOTexture != 0)
+	{
+		glDeleteTextures(1, &mFBOTexture);
+		mFBOTexture = 0;
+	}
+
+	if (mCaptureTexture != 0)
+	{
+		glDeleteTextures(1, &mCaptureTexture);
+		mCaptureTexture = 0;
+	}
+
+	if (mProgram != 0)
+	{
+		glDeleteProgram(mProgram);
+		mProgram = 0;
+	}
+
+	if (mFragmentShader != 0)
+	{
+		glDeleteShader(mFragmentShader);
+		mFragmentShader = 0;
+	}
+}
+
+// Draw the captured video frame texture onto a box, rendering to the off-screen frame buffer.
+// The off-screen frame buffer is left bound so the rendered frame can be read back.
+void CompositeRenderer::renderFrame(bool hasNoInputSource)
+{
+	// Draw OpenGL scene to the off-screen frame buffer
+	glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, mIdFrameBuf);
+
+	// Setup view and projection
+	GLfloat aspectRatio = (GLfloat)mFrameWidth / (GLfloat)mFrameHeight;
+	glViewport (0, 0, mFrameWidth, mFrameHeight);
+	glMatrixMode( GL_PROJECTION );
+	glLoadIdentity();
+	gluPerspective( 45.0f, aspectRatio, 0.1f, 100.0f );
+	glMatrixMode( GL_MODELVIEW );
+	glLoadIdentity();
+
+	glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
+	glScalef( aspectRatio, 1.0f, 1.0f );			// Scale x for correct aspect ratio
+	glTranslatef( 0.0f, 0.0f, -4.0f );				// Move into screen
+	glRotatef( mRotateAngle, 1.0f, 1.0f, 1.0f );	// Rotate model around a vector
+	mRotateAngle -= mRotateAngleRate;				// update the rotation angle for next iteration
+
+	// Draw a colourful frame around the front face of the box
+	// (provides a pleasing nesting effect when you connect the playout output to the capture input)
+	glBegin(GL_QUAD_STRIP);
+	glColor3f( 1.0f, 0.0f, 0.0f );
+	glVertex3f( 1.2f,  1.2f, 1.0f);
+	glVertex3f( 1.0f,  1.0f, 1.0f);
+	glColor3f( 0.0f, 0.0f, 1.0f );
+	glVertex3f( 1.2f, -1.2f, 1.0f);
+	glVertex3f( 1.0f, -1.0f, 1.0f);
+	glColor3f( 0.0f, 1.0f, 0.0f );
+	glVertex3f(-1.2f, -1.2f, 1.0f);
+	glVertex3f(-1.0f, -1.0f, 1.0f);
+	glColor3f( 1.0f, 1.0f, 0.0f );
+	glVertex3f(-1.2f,  1.2f, 1.0f);
+	glVertex3f(-1.0f,  1.0f, 1.0f);
+	glColor3f( 1.0f, 0.0f, 0.0f );
+	glVertex3f( 1.2f,  1.2f, 1.0f);
+	glVertex3f( 1.0f,  1.0f, 1.0f);
+	glEnd();
+
+	if (hasNoInputSource)
+	{
+		// Draw a big X when no input is available on capture
+		glBegin( GL_QUADS );
+		glColor3f( 1.0f, 0.0f, 1.0f );
+		glVertex3f(  0.8f,  0.9f,  1.0f );
+		glVertex3f(  0.9f,  0.8f,  1.0f );
+		glColor3f( 1.0f, 1.0f, 0.0f );
+		glVertex3f( -0.8f, -0.9f,  1.0f );
+		glVertex3f( -0.9f, -0.8f,  1.0f );
+		glColor3f( 1.0f, 0.0f, 1.0f );
+		glVertex3f( -0.8f,  0.9f,  1.0f );
+		glVertex3f( -0.9f,  0.8f,  1.0f );
+		glColor3f( 1.0f, 1.0f, 0.0f );
+		glVertex3f(  0.8f, -0.9f,  1.0f );
+		glVertex3f(  0.9f, -0.8f,  1.0f );
+		glEnd();
+	}
+	else
+	{
+		// Pass texture unit 0 to the fragment shader as a uniform variable
+		glEnable(GL_TEXTURE_2D);
+		glBindTexture(GL_TEXTURE_2D, mCaptureTexture);
+		glUseProgram(mProgram);
+		GLint locCaptureTex = glGetUniformLocation(mProgram, (mCaptureFormat == kCaptureTextureRGB10) ? "RGBtex" : "UYVYtex");
+		glUniform1i(locCaptureTex, 0);		// Bind texture unit 0
+
+		// Draw front and back faces of box applying video texture to each face
+		glBegin(GL_QUADS);
+		glTexCoord2f(1.0f, 0.0f);	glVertex3f(  1.0f,  1.0f,  1.0f );		// Top right of front side
+		glTexCoord2f(0.0f, 0.0f);	glVertex3f( -1.0f,  1.0f,  1.0f );		// Top left of front side
+		glTexCoord2f(0.0f, 1.0f);	glVertex3f( -1.0f, -1.0f,  1.0f );		// Bottom left of front side
+		glTexCoord2f(1.0f, 1.0f);	glVertex3f(  1.0f, -1.0f,  1.0f );		// Bottom right of front side
+
+		glTexCoord2f(1.0f, 1.0f);	glVertex3f(  1.0f, -1.0f, -1.0f );		// Top right of back side
+		glTexCoord2f(0.0f, 1.0f);	glVertex3f( -1.0f, -1.0f, -1.0f );		// Top left of back side
+		glTexCoord2f(0.0f, 0.0f);	glVertex3f( -1.0f,  1.0f, -1.0f );		// Bottom left of back side
+		glTexCoord2f(1.0f, 0.0f);	glVertex3f(  1.0f,  1.0f, -1.0f );		// Bottom right of back side
+		glEnd();
+
+		// Draw left and right sides of box with partially transparent video texture
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		glBegin(GL_QUADS);
+		glTexCoord2f(0.1f, 0.0f);	glVertex3f( -1.0f,  1.0f,  1.0f );		// Top right of left side
+		glTexCoord2f(1.0f, 0.0f);	glVertex3f( -1.0f,  1.0f, -1.0f );		// Top left of left side
+		glTexCoord2f(1.0f, 1.0f);	glVertex3f( -1.0f, -1.0f, -1.0f );		// Bottom left of left side
+		glTexCoord2f(0.1f, 1.0f);	glVertex3f( -1.0f, -1.0f,  1.0f );		// Bottom right of left side
+
+		glTexCoord2f(1.0f, 0.0f);	glVertex3f(  1.0f,  1.0f, -1.0f );		// Top right of right side
+		glTexCoord2f(0.0f, 0.0f);	glVertex3f(  1.0f,  1.0f,  1.0f );		// Top left of right side
+		glTexCoord2f(0.0f, 1.0f);	glVertex3f(  1.0f, -1.0f,  1.0f );		// Bottom left of right side
+		glTexCoord2f(1.0f, 1.0f);	glVertex3f(  1.0f, -1.0f, -1.0f );		// Bottom right of right side
+		glEnd();
+		glDisable(GL_BLEND);
+
+		glUseProgram(0);
+		glDisable(GL_TEXTURE_2D);
+		glBindTexture(GL_TEXTURE_2D, 0);
+	}
+}
+
+// Setup fragment shader to take YCbCr 4:2:2 video texture in UYVY macropixel format
+// and perform colour space conversion to RGBA in the GPU.
+// The RGB capture texture unpacked from 10-bit video only needs the alpha applied.
+bool CompositeRenderer::compileFragmentShader(int errorMessageSize, char* errorMessage)
+{
+	GLsizei		errorBufferSize;
+	GLint		compileResult, linkResult;
+	const char*	rgbFragmentSource =
+		"#version 130 \n"
+		"uniform sampler2D RGBtex; \n"
+		"void main(void) \n"
+		"{\n"
+		"	gl_FragColor = vec4(texture2D(RGBtex, gl_TexCoord[0].st).rgb, 0.7); \n"
+		"}\n";
+	const char*	fragmentSource =
+		"#version 130 \n"
+		"uniform sampler2D UYVYtex; \n"		// UYVY macropixel texture passed as RGBA format
+
+		"vec4 rec709YCbCr2rgba(float Y, float Cb, float Cr, float a) \n"
+		"{ \n"
+		"	float r, g, b; \n"
+		// Y: Undo 1/256 texture value scaling and scale [16..235] to [0..1] range
+		// C: Undo 1/256 texture value scaling and scale [16..240] to [-0.5 .. + 0.5] range
+		"	Y = (Y * 256.0 - 16.0) / 219.0; \n"
+		"	Cb = (Cb * 256.0 - 16.0) / 224.0 - 0.5; \n"
+		"	Cr = (Cr * 256.0 - 16.0) / 224.0 - 0.5; \n"
+		// Convert to RGB using Rec.709 conversion matrix (see eq 26.7 in Poynton 2003)
+		"	r = Y + 1.5748 * Cr; \n"
+		"	g = Y - 0.1873 * Cb - 0.4681 * Cr; \n"
+		"	b = Y + 1.8556 * Cb; \n"
+		"	return vec4(r, g, b, a); \n"
+		"}\n"
+
+		// Perform bilinear interpolation between the provided components.
+		// The samples are expected as shown:
+		// ---------
+		// | X | Y |
+		// |---+---|
+		// | W | Z |
+		// ---------
+		"vec4 bilinear(vec4 W, vec4 X, vec4 Y, vec4 Z, vec2 weight) \n"
+		"{\n"
+		"	vec4 m0 = mix(W, Z, weight.x);\n"
+		"	vec4 m1 = mix(X, Y, weight.x);\n"
+		"	return mix(m0, m1, weight.y); \n"
+		"}\n"
+
+		// Gather neighboring YUV macropixels from the given texture coordinate
+		"void textureGatherYUV(sampler2D UYVYsampler, vec2 tc, out vec4 W, out vec4 X, out vec4 Y, out vec4 Z) \n"
+		"{\n"
+		"	ivec2 tx = ivec2(tc * textureSize(UYVYsampler, 0));\n"
+		"	ivec2 tmin = ivec2(0,0);\n"
+		"	ivec2 tmax = textureSize(UYVYsampler, 0) - ivec2(1,1);\n"
+		"	W = texelFetch(UYVYsampler, tx, 0); \n"
+		"	X = texelFetch(UYVYsampler, clamp(tx + ivec2(0,1), tmin, tmax), 0); \n"
+		"	Y = texelFetch(UYVYsampler, clamp(tx + ivec2(1,1), tmin, tmax), 0); \n"
+		"	Z = texelFetch(UYVYsampler, clamp(tx + ivec2(1,0), tmin, tmax), 0); \n"
+		"}\n"
+
+		"void main(void) \n"
+		"{\n"
+		/* The shader uses texelFetch to obtain the YUV macropixels to avoid unwanted interpolation
+		 * introduced by the GPU interpreting the YUV data as RGBA pixels.
+		 * The YUV macropixels are converted into individual RGB pixels and bilinear interpolation is applied. */
+		"	vec2 tc = gl_TexCoord[0].st; \n"
+		"	float alpha = 0.7; \n"
+
+		"	vec4 macro, macro_u, macro_r, macro_ur;\n"
+		"	vec4 pixel, pixel_r, pixel_u, pixel_ur; \n"
+		"	textureGatherYUV(UYVYtex, tc, macro, macro_u, macro_ur, macro_r);\n"
+
+		//   Select the components for the bilinear interpolation based on the texture coordinate
+		//   location within the YUV macropixel:
+		//   -----------------          ----------------------
+		//   | UY/VY | UY/VY |          | macro_u | macro_ur |
+		//   |-------|-------|    =>    |---------|----------|
+		//   | UY/VY | UY/VY |          | macro   | macro_r  |
+		//   |-------|-------|          ----------------------
+		//   | RG/BA | RG/BA |
+		//   -----------------
+		"	vec2 off = fract(tc * textureSize(UYVYtex, 0)); \n"
+		"	if (off.x > 0.5) { \n"			// right half of macropixel
+		"		pixel = rec709YCbCr2rgba(macro.a, macro.b, macro.r, alpha); \n"
+		"		pixel_r = rec709YCbCr2rgba(macro_r.g, macro_r.b, macro_r.r, alpha); \n"
+		"		pixel_u = rec709YCbCr2rgba(macro_u.a, macro_u.b, macro_u.r, alpha); \n"
+		"		pixel_ur = rec709YCbCr2rgba(macro_ur.g, macro_ur.b, macro_ur.r, alpha); \n"
+		"	} else { \n"					// left half & center of macropixel
+		"		pixel = rec709YCbCr2rgba(macro.g, macro.b, macro.r, alpha); \n"
+		"		pixel_r = rec709YCbCr2rgba(macro.a, macro.b, macro.r, alpha); \n"
+		"		pixel_u = rec709YCbCr2rgba(macro_u.g, macro_u.b, macro_u.r, alpha); \n"
+		"		pixel_ur = rec709YCbCr2rgba(macro_u.a, macro_u.b, macro_u.r, alpha); \n"
+		"	}\n"
+
+		"	gl_FragColor = bilinear(pixel, pixel_u, pixel_ur, pixel_r, off); \n"
+		"}\n";
+
+	if (mCaptureFormat == kCaptureTextureRGB10)
+		fragmentSource = rgbFragmentSource;
+
+	mFragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+
+	glShaderSource(mFragmentShader, 1, (const GLchar**)&fragmentSource, NULL);
+	glCompileShader(mFragmentShader);
+
+	glGetShaderiv(mFragmentShader, GL_COMPILE_STATUS, &compileResult);
+	if (compileResult == GL_FALSE)
+	{
+		glGetShaderInfoLog(mFragmentShader, errorMessageSize, &errorBufferSize, errorMessage);
+		return false;
+	}
+
+	mProgram = glCreateProgram();
+
+	glAttachShader(mProgram, mFragmentShader);
+	glLinkProgram(mProgram);
+
+	glGetProgramiv(mProgram, GL_LINK_STATUS, &linkResult);
+	if (linkResult == GL_FALSE)
+	{
+		glGetProgramInfoLog(mProgram, errorMessageSize, &errorBufferSize, errorMessage);
+		return false;
+	}
+
+	return true;
+}
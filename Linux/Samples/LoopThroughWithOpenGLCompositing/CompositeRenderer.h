@@ -0,0 +1,95 @@
+/* -LICENSE-START-
+ ** Copyright (c) 2022 Blackmagic Design
+ **  
+ ** Permission is hereby granted, free of charge, to any person or organization 
+ ** obtaining a copy of the software and accompanying documentation (the 
+ ** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+ ** and transmit the Software, and to prepare derivative works of the Software, 
+ ** and to permit third-parties to whom the Software is furnished to do so, in 
+ ** accordance with:
+ ** 
+ ** (1) if the Software is obtained from Blackmagic Design, the End User License 
+ ** Agreement for the Software Development Kit (“EULA”) available at 
+ ** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+ ** 
+ ** (2) if the Software is obtained from any third party, such licensing terms 
+ ** as notified by that third party,
+ ** 
+ ** and all subject to the following:
+ ** 
+ ** (3) the copyright notices in the Software and this entire statement, 
+ ** including the above license grant, this restriction and the following 
+ ** disclaimer, must be included in all copies of the Software, in whole or in 
+ ** part, and all derivative works of the Software, unless such copies or 
+ ** derivative works are solely in the form of machine-executable object code 
+ ** generated by a source language processor.
+ ** 
+ ** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ ** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ ** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+ ** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+ ** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+ ** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ ** DEALINGS IN THE SOFTWARE.
+ ** 
+ ** A copy of the Software is available free of charge at 
+ ** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+ ** 
+ ** -LICENSE-END-
+ */
+
+//
+// CompositeRenderer.h
+// LoopThroughWithOpenGLCompositing
+//
+
+#ifndef __COMPOSITE_RENDERER_H__
+#define __COMPOSITE_RENDERER_H__
+
+#include <GL/gl.h>
+
+// Renders the captured video texture onto a spinning box in an off-screen frame buffer matching the video
+// frame size.  Only OpenGL is used so the scene can be rendered in either the QGLWidget or a headless context.
+class CompositeRenderer
+{
+public:
+	// The capture texture holds either 8-bit UYVY macropixels as half width RGBA texels, or RGB pixels
+	// unpacked from 10-bit v210 video.  10-bit capture is also composited into a 10-bit frame buffer.
+	enum CaptureTextureFormat
+	{
+		kCaptureTextureUYVY,
+		kCaptureTextureRGB10
+	};
+
+	CompositeRenderer();
+	~CompositeRenderer();
+
+	// The OpenGL context must be current, errorMessage is set when false is returned
+	bool initialize(unsigned width, unsigned height, CaptureTextureFormat captureFormat, float rotateAngleRate, int errorMessageSize, char* errorMessage);
+	void cleanup();
+
+	// Render the next frame, leaving the off-screen frame buffer bound for readback
+	void renderFrame(bool hasNoInputSource);
+
+	GLuint getCaptureTexture() const { return mCaptureTexture; }
+	GLuint getFrameBufferTexture() const { return mFBOTexture; }
+	GLuint getFrameBuffer() const { return mIdFrameBuf; }
+
+private:
+	unsigned					mFrameWidth;
+	unsigned					mFrameHeight;
+	CaptureTextureFormat		mCaptureFormat;
+	GLuint						mCaptureTexture;
+	GLuint						mFBOTexture;
+	GLuint						mIdFrameBuf;
+	GLuint						mIdColorBuf;
+	GLuint						mIdDepthBuf;
+	GLuint						mProgram;
+	GLuint						mFragmentShader;
+	GLfloat						mRotateAngle;
+	GLfloat						mRotateAngleRate;
+
+	bool compileFragmentShader(int errorMessageSize, char* errorMessage);
+};
+
+#endif	// __COMPOSITE_RENDERER_H__
@@ -62,12 +62,22 @@ PFNGLGENBUFFERSPROC glGenBuffers;
 PFNGLDELETEBUFFERSPROC glDeleteBuffers;
 PFNGLBINDBUFFERPROC glBindBuffer;
 PFNGLBUFFERDATAPROC glBufferData;
+PFNGLMAPBUFFERRANGEPROC glMapBufferRange;
+PFNGLUNMAPBUFFERPROC glUnmapBuffer;
+PFNGLBUFFERSTORAGEPROC glBufferStorage;
+PFNGLGENQUERIESPROC glGenQueries;
+PFNGLDELETEQUERIESPROC glDeleteQueries;
+PFNGLBEGINQUERYPROC glBeginQuery;
+PFNGLENDQUERYPROC glEndQuery;
+PFNGLGETQUERYOBJECTUI64VPROC glGetQueryObjectui64v;
 PFNGLCREATESHADERPROC glCreateShader;
 PFNGLSHADERSOURCEPROC glShaderSource;
 PFNGLCOMPILESHADERPROC glCompileShader;
 PFNGLGETSHADERIVPROC glGetShaderiv;
 PFNGLGETSHADERINFOLOGPROC glGetShaderInfoLog;
 PFNGLCREATEPROGRAMPROC glCreateProgram;
+PFNGLDELETESHADERPROC glDeleteShader;
+PFNGLDELETEPROGRAMPROC glDeleteProgram;
 PFNGLATTACHSHADERPROC glAttachShader;
 PFNGLLINKPROGRAMPROC glLinkProgram;
 PFNGLGETPROGRAMIVPROC glGetProgramiv;
@@ -77,40 +87,63 @@ PFNGLGETUNIFORMLOCATIONPROC glGetUniformLocation;
 PFNGLUNIFORM1IPROC glUniform1i;
 PFNGLUNIFORM1FPROC glUniform1f;
 
+static const QGLContext* sResolveContext = NULL;
+
+static void* GetQGLContextProcAddress(const char* name)
+{
+	return (void*)sResolveContext->getProcAddress(name);
+}
+
 bool ResolveGLExtensions(const QGLContext* context)
 {
-	glGenFramebuffersEXT = (PFNGLGENFRAMEBUFFERSEXTPROC) context->getProcAddress("glGenFramebuffersEXT");
-	glGenRenderbuffersEXT = (PFNGLGENRENDERBUFFERSEXTPROC) context->getProcAddress("glGenRenderbuffersEXT");
-	glBindRenderbufferEXT = (PFNGLBINDRENDERBUFFEREXTPROC) context->getProcAddress("glBindRenderbufferEXT");
-	glRenderbufferStorageEXT = (PFNGLRENDERBUFFERSTORAGEEXTPROC) context->getProcAddress("glRenderbufferStorageEXT");
-	glDeleteFramebuffersEXT = (PFNGLDELETEFRAMEBUFFERSEXTPROC) context->getProcAddress("glDeleteFramebuffersEXT");
-	glDeleteRenderbuffersEXT = (PFNGLDELETERENDERBUFFERSEXTPROC) context->getProcAddress("glDeleteRenderbuffersEXT");
-	glBindFramebufferEXT = (PFNGLBINDFRAMEBUFFEREXTPROC) context->getProcAddress("glBindFramebufferEXT");
-	glFramebufferTexture2DEXT = (PFNGLFRAMEBUFFERTEXTURE2DEXTPROC) context->getProcAddress("glFramebufferTexture2DEXT");
-	glFramebufferRenderbufferEXT = (PFNGLFRAMEBUFFERRENDERBUFFEREXTPROC) context->getProcAddress("glFramebufferRenderbufferEXT");
-	glCheckFramebufferStatusEXT = (PFNGLCHECKFRAMEBUFFERSTATUSEXTPROC) context->getProcAddress("glCheckFramebufferStatusEXT");
-	glBlitFramebufferEXT = (PFNGLBLITFRAMEBUFFEREXTPROC) context->getProcAddress("glBlitFramebufferEXT");
-	glFenceSync = (PFNGLFENCESYNCPROC) context->getProcAddress("glFenceSync");
-	glClientWaitSync = (PFNGLCLIENTWAITSYNCPROC) context->getProcAddress("glClientWaitSync");
-	glDeleteSync = (PFNGLDELETESYNCPROC) context->getProcAddress("glDeleteSync");
-	glGenBuffers = (PFNGLGENBUFFERSPROC) context->getProcAddress("glGenBuffers");
-	glDeleteBuffers = (PFNGLDELETEBUFFERSPROC) context->getProcAddress("glDeleteBuffers");
-	glBindBuffer = (PFNGLBINDBUFFERPROC) context->getProcAddress("glBindBuffer");
-	glBufferData = (PFNGLBUFFERDATAPROC) context->getProcAddress("glBufferData");
-	glCreateShader = (PFNGLCREATESHADERPROC) context->getProcAddress("glCreateShader");
-	glShaderSource = (PFNGLSHADERSOURCEPROC) context->getProcAddress("glShaderSource");
-	glCompileShader = (PFNGLCOMPILESHADERPROC) context->getProcAddress("glCompileShader");
-	glGetShaderiv = (PFNGLGETSHADERIVPROC) context->getProcAddress("glGetShaderiv");
-	glGetShaderInfoLog = (PFNGLGETSHADERINFOLOGPROC) context->getProcAddress("glGetShaderInfoLog");
-	glCreateProgram = (PFNGLCREATEPROGRAMPROC) context->getProcAddress("glCreateProgram");
-	glAttachShader = (PFNGLATTACHSHADERPROC) context->getProcAddress("glAttachShader");
-	glLinkProgram = (PFNGLLINKPROGRAMPROC) context->getProcAddress("glLinkProgram");
-	glGetProgramiv = (PFNGLGETPROGRAMIVPROC) context->getProcAddress("glGetProgramiv");
-	glGetProgramInfoLog = (PFNGLGETPROGRAMINFOLOGPROC) context->getProcAddress("glGetProgramInfoLog");
-	glUseProgram = (PFNGLUSEPROGRAMPROC) context->getProcAddress("glUseProgram");
-	glGetUniformLocation = (PFNGLGETUNIFORMLOCATIONPROC) context->getProcAddress("glGetUniformLocation");
-	glUniform1i = (PFNGLUNIFORM1IPROC) context->getProcAddress("glUniform1i");
-	glUniform1f = (PFNGLUNIFORM1FPROC) context->getProcAddress("glUniform1f");
+	sResolveContext = context;
+	return ResolveGLExtensions(GetQGLContextProcAddress);
+}
+
+bool ResolveGLExtensions(GLProcAddressFunction getProcAddress)
+{
+	glGenFramebuffersEXT = (PFNGLGENFRAMEBUFFERSEXTPROC) getProcAddress("glGenFramebuffersEXT");
+	glGenRenderbuffersEXT = (PFNGLGENRENDERBUFFERSEXTPROC) getProcAddress("glGenRenderbuffersEXT");
+	glBindRenderbufferEXT = (PFNGLBINDRENDERBUFFEREXTPROC) getProcAddress("glBindRenderbufferEXT");
+	glRenderbufferStorageEXT = (PFNGLRENDERBUFFERSTORAGEEXTPROC) getProcAddress("glRenderbufferStorageEXT");
+	glDeleteFramebuffersEXT = (PFNGLDELETEFRAMEBUFFERSEXTPROC) getProcAddress("glDeleteFramebuffersEXT");
+	glDeleteRenderbuffersEXT = (PFNGLDELETERENDERBUFFERSEXTPROC) getProcAddress("glDeleteRenderbuffersEXT");
+	glBindFramebufferEXT = (PFNGLBINDFRAMEBUFFEREXTPROC) getProcAddress("glBindFramebufferEXT");
+	glFramebufferTexture2DEXT = (PFNGLFRAMEBUFFERTEXTURE2DEXTPROC) getProcAddress("glFramebufferTexture2DEXT");
+	glFramebufferRenderbufferEXT = (PFNGLFRAMEBUFFERRENDERBUFFEREXTPROC) getProcAddress("glFramebufferRenderbufferEXT");
+	glCheckFramebufferStatusEXT = (PFNGLCHECKFRAMEBUFFERSTATUSEXTPROC) getProcAddress("glCheckFramebufferStatusEXT");
+	glBlitFramebufferEXT = (PFNGLBLITFRAMEBUFFEREXTPROC) getProcAddress("glBlitFramebufferEXT");
+	glFenceSync = (PFNGLFENCESYNCPROC) getProcAddress("glFenceSync");
+	glClientWaitSync = (PFNGLCLIENTWAITSYNCPROC) getProcAddress("glClientWaitSync");
+	glDeleteSync = (PFNGLDELETESYNCPROC) getProcAddress("glDeleteSync");
+	glGenBuffers = (PFNGLGENBUFFERSPROC) getProcAddress("glGenBuffers");
+	glDeleteBuffers = (PFNGLDELETEBUFFERSPROC) getProcAddress("glDeleteBuffers");
+	glBindBuffer = (PFNGLBINDBUFFERPROC) getProcAddress("glBindBuffer");
+	glBufferData = (PFNGLBUFFERDATAPROC) getProcAddress("glBufferData");
+	glMapBufferRange = (PFNGLMAPBUFFERRANGEPROC) getProcAddress("glMapBufferRange");
+	glUnmapBuffer = (PFNGLUNMAPBUFFERPROC) getProcAddress("glUnmapBuffer");
+	glBufferStorage = (PFNGLBUFFERSTORAGEPROC) getProcAddress("glBufferStorage");
+	glGenQueries = (PFNGLGENQUERIESPROC) getProcAddress("glGenQueries");
+	glDeleteQueries = (PFNGLDELETEQUERIESPROC) getProcAddress("glDeleteQueries");
+	glBeginQuery = (PFNGLBEGINQUERYPROC) getProcAddress("glBeginQuery");
+	glEndQuery = (PFNGLENDQUERYPROC) getProcAddress("glEndQuery");
+	glGetQueryObjectui64v = (PFNGLGETQUERYOBJECTUI64VPROC) getProcAddress("glGetQueryObjectui64v");
+	glCreateShader = (PFNGLCREATESHADERPROC) getProcAddress("glCreateShader");
+	glShaderSource = (PFNGLSHADERSOURCEPROC) getProcAddress("glShaderSource");
+	glCompileShader = (PFNGLCOMPILESHADERPROC) getProcAddress("glCompileShader");
+	glGetShaderiv = (PFNGLGETSHADERIVPROC) getProcAddress("glGetShaderiv");
+	glGetShaderInfoLog = (PFNGLGETSHADERINFOLOGPROC) getProcAddress("glGetShaderInfoLog");
+	glCreateProgram = (PFNGLCREATEPROGRAMPROC) getProcAddress("glCreateProgram");
+	glDeleteShader = (PFNGLDELETESHADERPROC) getProcAddress("glDeleteShader");
+	glDeleteProgram = (PFNGLDELETEPROGRAMPROC) getProcAddress("glDeleteProgram");
+	glAttachShader = (PFNGLATTACHSHADERPROC) getProcAddress("glAttachShader");
+	glLinkProgram = (PFNGLLINKPROGRAMPROC) getProcAddress("glLinkProgram");
+	glGetProgramiv = (PFNGLGETPROGRAMIVPROC) getProcAddress("glGetProgramiv");
+	glGetProgramInfoLog = (PFNGLGETPROGRAMINFOLOGPROC) getProcAddress("glGetProgramInfoLog");
+	glUseProgram = (PFNGLUSEPROGRAMPROC) getProcAddress("glUseProgram");
+	glGetUniformLocation = (PFNGLGETUNIFORMLOCATIONPROC) getProcAddress("glGetUniformLocation");
+	glUniform1i = (PFNGLUNIFORM1IPROC) getProcAddress("glUniform1i");
+	glUniform1f = (PFNGLUNIFORM1FPROC) getProcAddress("glUniform1f");
 
 	return	glGenFramebuffersEXT
 			&& glGenRenderbuffersEXT
@@ -130,12 +163,20 @@ bool ResolveGLExtensions(const QGLContext* context)
 			&& glDeleteBuffers
 			&& glBindBuffer
 			&& glBufferData
+			&& glMapBufferRange
+			&& glUnmapBuffer
+			&& glGenQueries
+			&& glDeleteQueries
+			&& glBeginQuery
+			&& glEndQuery
 			&& glCreateShader
 			&& glShaderSource
 			&& glCompileShader
 			&& glGetShaderiv
 			&& glGetShaderInfoLog
 			&& glCreateProgram
+			&& glDeleteShader
+			&& glDeleteProgram
 			&& glAttachShader
 			&& glLinkProgram
 			&& glGetProgramiv
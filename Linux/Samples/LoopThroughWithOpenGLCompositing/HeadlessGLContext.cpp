@@ -0,0 +1,182 @@
+/* -LICENSE-START-
+ ** Copyright (c) 2022 Blackmagic Design
+ **  
+ ** Permission is hereby granted, free of charge, to any person or organization 
+ ** obtaining a copy of the software and accompanying documentation (the 
+ ** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+ ** and transmit the Software, and to prepare derivative works of the Software, 
+ ** and to permit third-parties to whom the Software is furnished to do so, in 
+ ** accordance with:
+ ** 
+ ** (1) if the Software is obtained from Blackmagic Design, the End User License 
+ ** Agreement for the Software Development Kit (“EULA”) available at 
+ ** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+ ** 
+ ** (2) if the Software is obtained from any third party, such licensing terms 
+ ** as notified by that third party,
+ ** 
+ ** and all subject to the following:
+ ** 
+ ** (3) the copyright notices in the Software and this entire statement, 
+ ** including the above license grant, this restriction and the following 
+ ** disclaimer, must be included in all copies of the Software, in whole or in 
+ ** part, and all derivative works of the Software, unless such copies or 
+ ** derivative works are solely in the form of machine-executable object code 
+ ** generated by a source language processor.
+ ** 
+ ** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ ** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ ** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+ ** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+ ** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+ ** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ ** DEALINGS IN THE SOFTWARE.
+ ** 
+ ** A copy of the Software is available free of charge at 
+ ** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+ ** 
+ ** -LICENSE-END-
+ */
+//
+// HeadlessGLContext.cpp
+// LoopThroughWithOpenGLCompositing
+//
+
+#include "HeadlessGLContext.h"
+#include <stdio.h>
+#include <string.h>
+
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+#define EGL_PLATFORM_SURFACELESS_MESA	0x31DD
+#endif
+
+typedef EGLDisplay (*PFN_eglGetPlatformDisplayEXT) (EGLenum platform, void* nativeDisplay, const EGLint* attributes);
+
+static bool hasExtension(const char* extensions, const char* name)
+{
+	size_t nameLength = strlen(name);
+
+	while (extensions != NULL && *extensions != '\0')
+	{
+		const char* end = strchr(extensions, ' ');
+		size_t length = (end != NULL) ? (size_t)(end - extensions) : strlen(extensions);
+
+		if ((length == nameLength) && (strncmp(extensions, name, length) == 0))
+			return true;
+
+		extensions = (end != NULL) ? end + 1 : NULL;
+	}
+
+	return false;
+}
+
+HeadlessGLContext::HeadlessGLContext() :
+	mDisplay(EGL_NO_DISPLAY),
+	mContext(EGL_NO_CONTEXT),
+	mSurface(EGL_NO_SURFACE)
+{
+}
+
+HeadlessGLContext::~HeadlessGLContext()
+{
+	if (mDisplay == EGL_NO_DISPLAY)
+		return;
+
+	eglMakeCurrent(mDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+
+	if (mSurface != EGL_NO_SURFACE)
+		eglDestroySurface(mDisplay, mSurface);
+
+	if (mContext != EGL_NO_CONTEXT)
+		eglDestroyContext(mDisplay, mContext);
+
+	eglTerminate(mDisplay);
+}
+
+bool HeadlessGLContext::initialize()
+{
+	const char*		clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+	EGLConfig		config;
+	EGLint			configCount;
+	EGLint			configAttributes[] =
+	{
+		EGL_SURFACE_TYPE,		EGL_PBUFFER_BIT,
+		EGL_RENDERABLE_TYPE,	EGL_OPENGL_BIT,
+		EGL_RED_SIZE,			8,
+		EGL_GREEN_SIZE,			8,
+		EGL_BLUE_SIZE,			8,
+		EGL_ALPHA_SIZE,			8,
+		EGL_NONE
+	};
+	EGLint			pbufferAttributes[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+
+	// Prefer the surfaceless platform so that no window system connection is attempted
+	if (hasExtension(clientExtensions, "EGL_MESA_platform_surfaceless") && hasExtension(clientExtensions, "EGL_EXT_platform_base"))
+	{
+		PFN_eglGetPlatformDisplayEXT getPlatformDisplay = (PFN_eglGetPlatformDisplayEXT)eglGetProcAddress("eglGetPlatformDisplayEXT");
+		if (getPlatformDisplay != NULL)
+			mDisplay = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+	}
+
+	if (mDisplay == EGL_NO_DISPLAY)
+		mDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+	if ((mDisplay == EGL_NO_DISPLAY) || ! eglInitialize(mDisplay, NULL, NULL))
+	{
+		fprintf(stderr, "Unable to initialize EGL display\n");
+		mDisplay = EGL_NO_DISPLAY;
+		return false;
+	}
+
+	// Desktop OpenGL with the compatibility profile is required for the fixed function scene rendering
+	if (! eglBindAPI(EGL_OPENGL_API))
+	{
+		fprintf(stderr, "EGL does not support the OpenGL API\n");
+		return false;
+	}
+
+	if (! eglChooseConfig(mDisplay, configAttributes, &config, 1, &configCount) || (configCount == 0))
+	{
+		// Surfaceless displays may not offer pbuffer configs
+		configAttributes[1] = 0;
+		if (! eglChooseConfig(mDisplay, configAttributes, &config, 1, &configCount) || (configCount == 0))
+		{
+			fprintf(stderr, "No suitable EGL config\n");
+			return false;
+		}
+	}
+
+	mContext = eglCreateContext(mDisplay, config, EGL_NO_CONTEXT, NULL);
+	if (mContext == EGL_NO_CONTEXT)
+	{
+		fprintf(stderr, "Unable to create EGL context\n");
+		return false;
+	}
+
+	if (! hasExtension(eglQueryString(mDisplay, EGL_EXTENSIONS), "EGL_KHR_surfaceless_context"))
+	{
+		mSurface = eglCreatePbufferSurface(mDisplay, config, pbufferAttributes);
+		if (mSurface == EGL_NO_SURFACE)
+		{
+			fprintf(stderr, "Unable to create EGL pbuffer surface\n");
+			return false;
+		}
+	}
+
+	return makeCurrent();
+}
+
+bool HeadlessGLContext::makeCurrent()
+{
+	return eglMakeCurrent(mDisplay, mSurface, mSurface, mContext) == EGL_TRUE;
+}
+
+void HeadlessGLContext::doneCurrent()
+{
+	eglMakeCurrent(mDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+}
+
+void* HeadlessGLContext::getProcAddress(const char* name)
+{
+	return (void*)eglGetProcAddress(name);
+}
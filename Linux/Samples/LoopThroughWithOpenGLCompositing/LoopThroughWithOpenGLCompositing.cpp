@@ -45,12 +45,12 @@
 #include "LoopThroughWithOpenGLCompositing.h"
 #include "OpenGLComposite.h"
 
-LoopThroughWithOpenGLCompositing::LoopThroughWithOpenGLCompositing() : QDialog(), pOpenGLComposite(NULL)
+LoopThroughWithOpenGLCompositing::LoopThroughWithOpenGLCompositing(BMDPixelFormat pixelFormat) : QDialog(), pOpenGLComposite(NULL)
 {
 	ui = new Ui::LoopThroughWithOpenGLCompositingDialog();
 	ui->setupUi(this);
 
-	pOpenGLComposite = new OpenGLComposite(this);
+	pOpenGLComposite = new OpenGLComposite(this, pixelFormat);
 
 	ui->verticalLayout->addWidget(pOpenGLComposite);
 
@@ -56,7 +56,7 @@ class OpenGLComposite;
 class LoopThroughWithOpenGLCompositing : public QDialog
 {
 public:
-	LoopThroughWithOpenGLCompositing();
+	LoopThroughWithOpenGLCompositing(BMDPixelFormat pixelFormat = bmdFormat8BitYUV);
 	~LoopThroughWithOpenGLCompositing();
 
 	void start();
@@ -1,6 +1,6 @@
 TEMPLATE  	= app
 LANGUAGE  	= C++
-CONFIG		+= qt opengl
+CONFIG		+= qt opengl c++11
 QT			+= opengl
 INCLUDEPATH =	../../include ../NVIDIA_GPUDirect/include
 contains(QT_ARCH, x86_64) {
@@ -8,20 +8,32 @@ contains(QT_ARCH, x86_64) {
 } else {
 	LIBDVP_PATH		= ../NVIDIA_GPUDirect/i386
 }
-LIBS				+= -lGLU -ldl -ldvp -L$$LIBDVP_PATH -Wl,-rpath=.:$$LIBDVP_PATH
+LIBS				+= -lGLU -lEGL -ldl -ldvp -L$$LIBDVP_PATH -Wl,-rpath=.:$$LIBDVP_PATH
 QMAKE_PRE_LINK		+= $$QMAKE_SYMBOLIC_LINK libdvp.so.1 $$LIBDVP_PATH/libdvp.so
 
 HEADERS 	=	../../include/DeckLinkAPIDispatch.cpp \
 				LoopThroughWithOpenGLCompositing.h \
 				OpenGLComposite.h \
+				CompositeBenchmark.h \
+				CompositeRenderer.h \
 				GLExtensions.h \
+				HeadlessGLContext.h \
+				ReadbackPipeline.h \
+				TextureUploadRing.h \
+				V210Converter.h \
 				VideoFrameTransfer.h
 
 SOURCES 	= 	main.cpp \
 				../../include/DeckLinkAPIDispatch.cpp \
 				LoopThroughWithOpenGLCompositing.cpp \
 				OpenGLComposite.cpp \
+				CompositeBenchmark.cpp \
+				CompositeRenderer.cpp \
 				GLExtensions.cpp \
+				HeadlessGLContext.cpp \
+				ReadbackPipeline.cpp \
+				TextureUploadRing.cpp \
+				V210Converter.cpp \
 				VideoFrameTransfer.cpp
 
 FORMS 		= 	LoopThroughWithOpenGLCompositing.ui
@@ -40,20 +40,58 @@
 
 #include "OpenGLComposite.h"
 #include "GLExtensions.h"
+#include "V210Converter.h"
 #include <GL/glu.h>
+#include <algorithm>
 
-OpenGLComposite::OpenGLComposite(QWidget *parent) :
+// Number of pixel buffers used to upload captured frames when the fast transfer extension is not available
+static const unsigned kCaptureUploadRingDepth = 3;
+
+// Number of rendered frames that can be in flight while being read back for playout when the fast transfer
+// extension is not available, set to 0 to read back each frame synchronously after rendering
+static const unsigned kPlayoutReadbackDepth = 2;
+
+// Fill a frame with black, 10-bit YCbCr video is black at Y = 64 and CbCr = 512
+static void FillBlackFrame(IDeckLinkVideoFrame* videoFrame)
+{
+	void*		pFrame;
+	uint32_t*	pWords;
+	long		frameBytes = videoFrame->GetRowBytes() * videoFrame->GetHeight();
+
+	videoFrame->GetBytes(&pFrame);
+
+	if (videoFrame->GetPixelFormat() != bmdFormat10BitYUV)
+	{
+		memset(pFrame, 0, frameBytes);			// 0 is black in RGBA format
+		return;
+	}
+
+	pWords = (uint32_t*)pFrame;
+	for (long i = 0; i < frameBytes / 4; i += 2)
+	{
+		pWords[i] = 512 | (64 << 10) | (512 << 20);		// Cb Y Cr
+		pWords[i + 1] = 64 | (512 << 10) | (64 << 20);	// Y Cb Y
+	}
+}
+
+OpenGLComposite::OpenGLComposite(QWidget *parent, BMDPixelFormat pixelFormat) :
 	QGLWidget(parent), mParent(parent),
 	mCaptureDelegate(NULL), mPlayoutDelegate(NULL),
 	mDLInput(NULL), mDLOutput(NULL),
 	mCaptureAllocator(NULL), mPlayoutAllocator(NULL),
 	mFrameWidth(0), mFrameHeight(0),
+	mPixelFormat(pixelFormat),
 	mHasNoInputSource(true),
 	mFastTransferExtensionAvailable(false),
-	mCaptureTexture(0),
-	mFBOTexture(0),
-	mRotateAngle(0.0f),
-	mRotateAngleRate(0.0f)
+	mRenderer(NULL),
+	mV210Converter(NULL),
+	mCaptureUploadRing(NULL),
+	mPlayoutReadback(NULL),
+	mRotateAngleRate(0.0f),
+	mUploadStatisticsFrames(0),
+	mUploadCopyTimeTotalMs(0.0), mUploadCopyTimeMaxMs(0.0),
+	mUploadSubmitTimeTotalMs(0.0), mUploadSubmitTimeMaxMs(0.0),
+	mUploadGPUTimeTotalMs(0.0), mUploadGPUTimeMaxMs(0.0)
 {
 	ResolveGLExtensions(context());
 
@@ -86,6 +124,42 @@ OpenGLComposite::~OpenGLComposite()
 		mCaptureAllocator = NULL;
 	}
 
+	if (mCaptureUploadRing != NULL)
+	{
+		makeCurrent();
+		mCaptureUploadRing->cleanup();
+
+		delete mCaptureUploadRing;
+		mCaptureUploadRing = NULL;
+	}
+
+	if (mPlayoutReadback != NULL)
+	{
+		makeCurrent();
+		mPlayoutReadback->cleanup();
+
+		delete mPlayoutReadback;
+		mPlayoutReadback = NULL;
+	}
+
+	if (mV210Converter != NULL)
+	{
+		makeCurrent();
+		mV210Converter->cleanup();
+
+		delete mV210Converter;
+		mV210Converter = NULL;
+	}
+
+	if (mRenderer != NULL)
+	{
+		makeCurrent();
+		mRenderer->cleanup();
+
+		delete mRenderer;
+		mRenderer = NULL;
+	}
+
 	// Cleanup for Playout
 	if (mDLOutput != NULL)
 	{
@@ -220,7 +294,7 @@ bool OpenGLComposite::InitDeckLink()
 	if (mFastTransferExtensionAvailable)
 	{
 		// Initialize fast video frame transfers
-		if (! VideoFrameTransfer::initialize(mFrameWidth, mFrameHeight, mCaptureTexture, mFBOTexture))
+		if (! VideoFrameTransfer::initialize(mFrameWidth, mFrameHeight, mRenderer->getCaptureTexture(), mRenderer->getFrameBufferTexture()))
 		{
 			QMessageBox::critical(NULL, "VideoFrameTransfer error.", "Cannot initialize video transfers.");
 			goto error;
@@ -234,10 +308,10 @@ bool OpenGLComposite::InitDeckLink()
 	if (mDLInput->SetVideoInputFrameMemoryAllocator(mCaptureAllocator) != S_OK)
 		goto error;
 
-	if (mDLInput->EnableVideoInput(displayMode, bmdFormat8BitYUV, bmdVideoInputFlagDefault) != S_OK)
+	if (mDLInput->EnableVideoInput(displayMode, mPixelFormat, bmdVideoInputFlagDefault) != S_OK)
 		goto error;
 
-	mCaptureDelegate = new CaptureDelegate();
+	mCaptureDelegate = new CaptureDelegate(mCaptureUploadRing);
 	if (mDLInput->SetCallback(mCaptureDelegate) != S_OK)
 		goto error;
 
@@ -259,8 +333,13 @@ bool OpenGLComposite::InitDeckLink()
 		// within the DeckLink API for DeckLink devices without this hardware conversion.
 		// If you want RGB 4:4:4 format to be played out "over the wire" in SDI, turn on the "Use 4:4:4 SDI" in the control
 		// panel or turn on the bmdDeckLinkConfig444SDIVideoOutput flag using the IDeckLinkConfiguration interface.
+		// For 10-bit video the frame is packed to v210 in the GPU, which also flips it the right way up.
 		IDeckLinkMutableVideoFrame* outputFrame;
-		if (mDLOutput->CreateVideoFrame(mFrameWidth, mFrameHeight, mFrameWidth*4, bmdFormat8BitBGRA, bmdFrameFlagFlipVertical, &outputFrame) != S_OK)
+		if (mPixelFormat == bmdFormat10BitYUV)
+			result = mDLOutput->CreateVideoFrame(mFrameWidth, mFrameHeight, V210Converter::getRowBytes(mFrameWidth), bmdFormat10BitYUV, bmdFrameFlagDefault, &outputFrame);
+		else
+			result = mDLOutput->CreateVideoFrame(mFrameWidth, mFrameHeight, mFrameWidth*4, bmdFormat8BitBGRA, bmdFrameFlagFlipVertical, &outputFrame);
+		if (result != S_OK)
 			goto error;
 
 		mDLOutputVideoFrameQueue.push_back(outputFrame);
@@ -329,10 +408,10 @@ void OpenGLComposite::paintGL ()
 {
 	// The DeckLink API provides IDeckLinkGLScreenPreviewHelper as a convenient way to view the playout video frames
 	// in a window.  However, it performs a copy from host memory to the GPU which is wasteful in this case since
-	// we already have the rendered frame to be played out sitting in the GPU in the mIdFrameBuf frame buffer.
+	// we already have the rendered frame to be played out sitting in the GPU in the renderer's off-screen frame buffer.
 
 	// Simply copy the off-screen frame buffer to on-screen frame buffer, scaling to the viewing window size.
-	glBindFramebufferEXT(GL_READ_FRAMEBUFFER, mIdFrameBuf);
+	glBindFramebufferEXT(GL_READ_FRAMEBUFFER, mRenderer->getFrameBuffer());
 	glBindFramebufferEXT(GL_DRAW_FRAMEBUFFER, 0);
 	glViewport(0, 0, mViewWidth, mViewHeight);
 	glBlitFramebufferEXT(0, 0, mFrameWidth, mFrameHeight, 0, 0, mViewWidth, mViewHeight, GL_COLOR_BUFFER_BIT, GL_LINEAR);
@@ -353,77 +432,68 @@ bool OpenGLComposite::InitOpenGLState()
 	if (! CheckOpenGLExtensions())
 		return false;
 
-	// Prepare the shader used to perform colour space conversion on the video texture
-	char compilerErrorMessage[1024];
-	if (! compileFragmentShader(sizeof(compilerErrorMessage), compilerErrorMessage))
-	{
-		QMessageBox::critical(NULL, compilerErrorMessage, "OpenGL Shader failed to compile");
-		return false;
-	}
-
-	// Setup the scene
-	glShadeModel( GL_SMOOTH );					// Enable smooth shading
-	glClearColor( 0.0f, 0.0f, 0.0f, 0.5f );		// Black background
-	glClearDepth( 1.0f );						// Depth buffer setup
-	glEnable( GL_DEPTH_TEST );					// Enable depth testing
-	glDepthFunc( GL_LEQUAL );					// Type of depth test to do
-	glHint( GL_PERSPECTIVE_CORRECTION_HINT, GL_NICEST );
-
 	if (! mFastTransferExtensionAvailable)
 	{
-		glGenBuffers(1, &mUnpinnedTextureBuffer);
-	}
-
-	// Setup the texture which will hold the captured video frame pixels
-	glEnable(GL_TEXTURE_2D);
-	glGenTextures(1, &mCaptureTexture);
-	glBindTexture(GL_TEXTURE_2D, mCaptureTexture);
-
-	// Parameters to control how texels are sampled from the texture
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
-
-	// Create texture with empty data, we will update it using glTexSubImage2D each frame.
-	// The captured video is YCbCr 4:2:2 packed into a UYVY macropixel.  OpenGL has no YCbCr format
-	// so treat it as RGBA 4:4:4:4 by halving the width and using GL_RGBA internal format.
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, mFrameWidth/2, mFrameHeight, 0, GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV, NULL);
+		// Captured frames are copied directly into a ring of mapped pixel buffers by the capture thread,
+		// keep the buffers persistently mapped when the driver supports immutable buffer storage
+		const GLubyte* strExt = glGetString(GL_EXTENSIONS);
+		bool hasBufferStorage = gluCheckExtension((const GLubyte*)"GL_ARB_buffer_storage", strExt);
+		bool hasTimerQuery = gluCheckExtension((const GLubyte*)"GL_ARB_timer_query", strExt);
 
-	glBindTexture(GL_TEXTURE_2D, 0);
-	glDisable(GL_TEXTURE_2D);
-
-	// Create Frame Buffer Object (FBO) to perform off-screen rendering of scene.
-	// This allows the render to be done on a framebuffer with width and height exactly matching the video format.
-	glGenFramebuffersEXT(1, &mIdFrameBuf);
-	glGenRenderbuffersEXT(1, &mIdColorBuf);
-	glGenRenderbuffersEXT(1, &mIdDepthBuf);
-
-	glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, mIdFrameBuf);
-
-	// Texture for FBO
-	glGenTextures(1, &mFBOTexture);
-	glBindTexture(GL_TEXTURE_2D, mFBOTexture);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, mFrameWidth, mFrameHeight, 0, GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV, NULL);
-
-	// Attach a depth buffer
-	glBindRenderbufferEXT(GL_RENDERBUFFER_EXT, mIdDepthBuf);
-	glRenderbufferStorageEXT(GL_RENDERBUFFER_EXT, GL_DEPTH_COMPONENT, mFrameWidth, mFrameHeight);
+		// The captured video is YCbCr 4:2:2 with 2 bytes per pixel, or v210 for 10-bit video
+		unsigned captureRowBytes = (mPixelFormat == bmdFormat10BitYUV) ? V210Converter::getRowBytes(mFrameWidth) : mFrameWidth * 2;
+		mCaptureUploadRing = new TextureUploadRing(kCaptureUploadRingDepth, captureRowBytes * mFrameHeight);
+		if (! mCaptureUploadRing->initialize(hasBufferStorage, hasTimerQuery))
+		{
+			QMessageBox::critical(NULL, "Cannot initialize capture pixel buffers.", "OpenGL initialization error.");
+			return false;
+		}
 
-	glFramebufferRenderbufferEXT(GL_FRAMEBUFFER_EXT, GL_DEPTH_ATTACHMENT_EXT, GL_RENDERBUFFER_EXT, mIdDepthBuf);
+		fprintf(stderr, "Using %u %s pixel buffers for capture upload\n", kCaptureUploadRingDepth,
+				mCaptureUploadRing->isPersistentlyMapped() ? "persistently mapped" : "mapped");
 
-	// Attach the texture which stores the playback image
-	glFramebufferTexture2DEXT(GL_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT, GL_TEXTURE_2D, mFBOTexture, 0);
-	glBindTexture(GL_TEXTURE_2D, 0);
-	glDisable(GL_TEXTURE_2D);
+		if (kPlayoutReadbackDepth > 0)
+		{
+			bool readbackSuccess;
+
+			// 10-bit frames are read back as v210 words packed in the GPU
+			mPlayoutReadback = new ReadbackPipeline(kPlayoutReadbackDepth);
+			if (mPixelFormat == bmdFormat10BitYUV)
+				readbackSuccess = mPlayoutReadback->initialize(V210Converter::getRowBytes(mFrameWidth) / 4, mFrameHeight, GL_RGBA, GL_UNSIGNED_INT_2_10_10_10_REV);
+			else
+				readbackSuccess = mPlayoutReadback->initialize(mFrameWidth, mFrameHeight);
+
+			if (! readbackSuccess)
+			{
+				QMessageBox::critical(NULL, "Cannot initialize playout pixel buffers.", "OpenGL initialization error.");
+				return false;
+			}
+		}
+	}
 
-	GLenum glStatus = glCheckFramebufferStatusEXT(GL_FRAMEBUFFER_EXT);
-	if (glStatus != GL_FRAMEBUFFER_COMPLETE_EXT)
+	// Setup the scene and the off-screen frame buffer the scene is rendered to
+	char errorMessage[1024];
+	mRenderer = new CompositeRenderer();
+	if (! mRenderer->initialize(mFrameWidth, mFrameHeight,
+								(mPixelFormat == bmdFormat10BitYUV) ? CompositeRenderer::kCaptureTextureRGB10 : CompositeRenderer::kCaptureTextureUYVY,
+								mRotateAngleRate, sizeof(errorMessage), errorMessage))
 	{
-		QMessageBox::critical(NULL, "Cannot initialize framebuffer.", "OpenGL initialization error.");
+		QMessageBox::critical(NULL, errorMessage, "OpenGL initialization error.");
 		return false;
 	}
 
+	if (mPixelFormat == bmdFormat10BitYUV)
+	{
+		// Captured v210 frames are unpacked into the renderer's capture texture, and the composited frame
+		// is packed back to v210 for playout
+		mV210Converter = new V210Converter();
+		if (! mV210Converter->initialize(mFrameWidth, mFrameHeight, mRenderer->getCaptureTexture(), sizeof(errorMessage), errorMessage))
+		{
+			QMessageBox::critical(NULL, errorMessage, "OpenGL initialization error.");
+			return false;
+		}
+	}
+
 	return true;
 }
 
@@ -433,6 +503,33 @@ bool OpenGLComposite::InitOpenGLState()
 void OpenGLComposite::VideoFrameArrived(IDeckLinkVideoInputFrame* inputFrame, bool hasNoInputSource)
 {
 	mHasNoInputSource = hasNoInputSource;
+
+	if (inputFrame == NULL)
+	{
+		// Frame was copied to the upload ring on the capture thread, upload the newest frame to the texture
+		if (mHasNoInputSource)
+			return;
+
+		mMutex.lock();
+
+		makeCurrent();
+		if (mV210Converter != NULL)
+		{
+			if (mCaptureUploadRing->uploadToTexture(mV210Converter->getPackedInputTexture(), mV210Converter->getPackedWidth(), mFrameHeight, GL_RGBA, GL_UNSIGNED_INT_2_10_10_10_REV))
+			{
+				mV210Converter->unpack();
+				UpdateUploadStatistics();
+			}
+		}
+		else if (mCaptureUploadRing->uploadToTexture(mRenderer->getCaptureTexture(), mFrameWidth/2, mFrameHeight, GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV))
+		{
+			UpdateUploadStatistics();
+		}
+
+		mMutex.unlock();
+		return;
+	}
+
 	if (mHasNoInputSource)
 	{
 		inputFrame->Release();
@@ -441,37 +538,46 @@ void OpenGLComposite::VideoFrameArrived(IDeckLinkVideoInputFrame* inputFrame, bo
 
 	mMutex.lock();
 
-	long textureSize = inputFrame->GetRowBytes() * inputFrame->GetHeight();
 	void* videoPixels;
 	inputFrame->GetBytes(&videoPixels);
 
 	makeCurrent();
 
-	if (mFastTransferExtensionAvailable)
-	{
-		if (! mCaptureAllocator->transferFrame(videoPixels, mCaptureTexture))
-			fprintf(stderr, "Capture: transferFrame() failed\n");
-	}
-	else
-	{
-		glEnable(GL_TEXTURE_2D);
+	if (! mCaptureAllocator->transferFrame(videoPixels, mRenderer->getCaptureTexture()))
+		fprintf(stderr, "Capture: transferFrame() failed\n");
 
-		// Use a straightforward texture buffer
-		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, mUnpinnedTextureBuffer);
-		glBufferData(GL_PIXEL_UNPACK_BUFFER, textureSize, videoPixels, GL_DYNAMIC_DRAW);
-		glBindTexture(GL_TEXTURE_2D, mCaptureTexture);
+	mMutex.unlock();
 
-		// NULL for last arg indicates use current GL_PIXEL_UNPACK_BUFFER target as texture data
-		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, mFrameWidth/2, mFrameHeight, GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV, NULL);
+	inputFrame->Release();
+}
 
-		glBindTexture(GL_TEXTURE_2D, 0);
-		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
-		glDisable(GL_TEXTURE_2D);
-	}
+// Accumulate the copy and upload times of each captured frame and report them once per second
+void OpenGLComposite::UpdateUploadStatistics()
+{
+	TextureUploadRing::Statistics statistics;
+	mCaptureUploadRing->getStatistics(statistics);
 
-	mMutex.unlock();
+	mUploadStatisticsFrames++;
+	mUploadCopyTimeTotalMs += statistics.lastCopyTimeMs;
+	mUploadCopyTimeMaxMs = std::max(mUploadCopyTimeMaxMs, statistics.lastCopyTimeMs);
+	mUploadSubmitTimeTotalMs += statistics.lastSubmitTimeMs;
+	mUploadSubmitTimeMaxMs = std::max(mUploadSubmitTimeMaxMs, statistics.lastSubmitTimeMs);
+	mUploadGPUTimeTotalMs += statistics.lastUploadTimeMs;
+	mUploadGPUTimeMaxMs = std::max(mUploadGPUTimeMaxMs, statistics.lastUploadTimeMs);
 
-	inputFrame->Release();
+	if ((BMDTimeValue)mUploadStatisticsFrames * mFrameDuration < mFrameTimescale)
+		return;
+
+	fprintf(stderr, "Capture upload: copy %.3f ms (max %.3f), submit %.3f ms (max %.3f), GPU %.3f ms (max %.3f), %llu skipped, %llu dropped\n",
+			mUploadCopyTimeTotalMs / mUploadStatisticsFrames, mUploadCopyTimeMaxMs,
+			mUploadSubmitTimeTotalMs / mUploadStatisticsFrames, mUploadSubmitTimeMaxMs,
+			mUploadGPUTimeTotalMs / mUploadStatisticsFrames, mUploadGPUTimeMaxMs,
+			(unsigned long long)statistics.framesSkipped, (unsigned long long)statistics.framesDropped);
+
+	mUploadStatisticsFrames = 0;
+	mUploadCopyTimeTotalMs = mUploadCopyTimeMaxMs = 0.0;
+	mUploadSubmitTimeTotalMs = mUploadSubmitTimeMaxMs = 0.0;
+	mUploadGPUTimeTotalMs = mUploadGPUTimeMaxMs = 0.0;
 }
 
 // Draw the captured video frame texture onto a box, rendering to the off-screen frame buffer.
@@ -491,118 +597,28 @@ void OpenGLComposite::PlayoutNextFrame(IDeckLinkVideoFrame* completedFrame, BMDO
 	// make GL context current
 	makeCurrent();
 
-	// Draw OpenGL scene to the off-screen frame buffer
-	glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, mIdFrameBuf);
-
-	// Setup view and projection
-	GLfloat aspectRatio = (GLfloat)mFrameWidth / (GLfloat)mFrameHeight;
-	glViewport (0, 0, mFrameWidth, mFrameHeight);
-	glMatrixMode( GL_PROJECTION );
-	glLoadIdentity();
-	gluPerspective( 45.0f, aspectRatio, 0.1f, 100.0f );
-	glMatrixMode( GL_MODELVIEW );
-	glLoadIdentity();
-
-	glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
-	glScalef( aspectRatio, 1.0f, 1.0f );			// Scale x for correct aspect ratio
-	glTranslatef( 0.0f, 0.0f, -4.0f );				// Move into screen
-	glRotatef( mRotateAngle, 1.0f, 1.0f, 1.0f );	// Rotate model around a vector
-	mRotateAngle -= mRotateAngleRate;				// update the rotation angle for next iteration
-	glFinish();										// Ensure changes to GL state are complete
-
-	// Draw a colourful frame around the front face of the box
-	// (provides a pleasing nesting effect when you connect the playout output to the capture input)
-	glBegin(GL_QUAD_STRIP);
-	glColor3f( 1.0f, 0.0f, 0.0f );
-	glVertex3f( 1.2f,  1.2f, 1.0f);
-	glVertex3f( 1.0f,  1.0f, 1.0f);
-	glColor3f( 0.0f, 0.0f, 1.0f );
-	glVertex3f( 1.2f, -1.2f, 1.0f);
-	glVertex3f( 1.0f, -1.0f, 1.0f);
-	glColor3f( 0.0f, 1.0f, 0.0f );
-	glVertex3f(-1.2f, -1.2f, 1.0f);
-	glVertex3f(-1.0f, -1.0f, 1.0f);
-	glColor3f( 1.0f, 1.0f, 0.0f );
-	glVertex3f(-1.2f,  1.2f, 1.0f);
-	glVertex3f(-1.0f,  1.0f, 1.0f);
-	glColor3f( 1.0f, 0.0f, 0.0f );
-	glVertex3f( 1.2f,  1.2f, 1.0f);
-	glVertex3f( 1.0f,  1.0f, 1.0f);
-	glEnd();
-
-	if (mHasNoInputSource)
-	{
-		// Draw a big X when no input is available on capture
-		glBegin( GL_QUADS );
-		glColor3f( 1.0f, 0.0f, 1.0f );
-		glVertex3f(  0.8f,  0.9f,  1.0f );
-		glVertex3f(  0.9f,  0.8f,  1.0f );
-		glColor3f( 1.0f, 1.0f, 0.0f );
-		glVertex3f( -0.8f, -0.9f,  1.0f );
-		glVertex3f( -0.9f, -0.8f,  1.0f );
-		glColor3f( 1.0f, 0.0f, 1.0f );
-		glVertex3f( -0.8f,  0.9f,  1.0f );
-		glVertex3f( -0.9f,  0.8f,  1.0f );
-		glColor3f( 1.0f, 1.0f, 0.0f );
-		glVertex3f(  0.8f, -0.9f,  1.0f );
-		glVertex3f(  0.9f, -0.8f,  1.0f );
-		glEnd();
-	}
-	else
+	if (mFastTransferExtensionAvailable)
 	{
-		if (mFastTransferExtensionAvailable)
-		{
-			// Signal that we're about to draw using mCaptureTexture onto mFBOTexture
-			mCaptureAllocator->beginTextureInUse();
-		}
+		glFinish();									// Ensure changes to GL state are complete
 
-		// Pass texture unit 0 to the fragment shader as a uniform variable
-		glEnable(GL_TEXTURE_2D);
-		glBindTexture(GL_TEXTURE_2D, mCaptureTexture);
-		glUseProgram(mProgram);
-		GLint locUYVYtex = glGetUniformLocation(mProgram, "UYVYtex");
-		glUniform1i(locUYVYtex, 0);		// Bind texture unit 0
-
-		// Draw front and back faces of box applying video texture to each face
-		glBegin(GL_QUADS);
-		glTexCoord2f(1.0f, 0.0f);	glVertex3f(  1.0f,  1.0f,  1.0f );		// Top right of front side
-		glTexCoord2f(0.0f, 0.0f);	glVertex3f( -1.0f,  1.0f,  1.0f );		// Top left of front side
-		glTexCoord2f(0.0f, 1.0f);	glVertex3f( -1.0f, -1.0f,  1.0f );		// Bottom left of front side
-		glTexCoord2f(1.0f, 1.0f);	glVertex3f(  1.0f, -1.0f,  1.0f );		// Bottom right of front side
-
-		glTexCoord2f(1.0f, 1.0f);	glVertex3f(  1.0f, -1.0f, -1.0f );		// Top right of back side
-		glTexCoord2f(0.0f, 1.0f);	glVertex3f( -1.0f, -1.0f, -1.0f );		// Top left of back side
-		glTexCoord2f(0.0f, 0.0f);	glVertex3f( -1.0f,  1.0f, -1.0f );		// Bottom left of back side
-		glTexCoord2f(1.0f, 0.0f);	glVertex3f(  1.0f,  1.0f, -1.0f );		// Bottom right of back side
-		glEnd();
-
-		// Draw left and right sides of box with partially transparent video texture
-		glEnable(GL_BLEND);
-		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-		glBegin(GL_QUADS);
-		glTexCoord2f(0.1f, 0.0f);	glVertex3f( -1.0f,  1.0f,  1.0f );		// Top right of left side
-		glTexCoord2f(1.0f, 0.0f);	glVertex3f( -1.0f,  1.0f, -1.0f );		// Top left of left side
-		glTexCoord2f(1.0f, 1.0f);	glVertex3f( -1.0f, -1.0f, -1.0f );		// Bottom left of left side
-		glTexCoord2f(0.1f, 1.0f);	glVertex3f( -1.0f, -1.0f,  1.0f );		// Bottom right of left side
-
-		glTexCoord2f(1.0f, 0.0f);	glVertex3f(  1.0f,  1.0f, -1.0f );		// Top right of right side
-		glTexCoord2f(0.0f, 0.0f);	glVertex3f(  1.0f,  1.0f,  1.0f );		// Top left of right side
-		glTexCoord2f(0.0f, 1.0f);	glVertex3f(  1.0f, -1.0f,  1.0f );		// Bottom left of right side
-		glTexCoord2f(1.0f, 1.0f);	glVertex3f(  1.0f, -1.0f, -1.0f );		// Bottom right of right side
-		glEnd();
-		glDisable(GL_BLEND);
-
-		glUseProgram(0);
-		glDisable(GL_TEXTURE_2D);
-		glBindTexture(GL_TEXTURE_2D, 0);
+		// Signal that we're about to draw using the capture texture onto the frame buffer texture
+		if (! mHasNoInputSource)
+			mCaptureAllocator->beginTextureInUse();
 	}
 
+	// Draw OpenGL scene to the off-screen frame buffer
+	mRenderer->renderFrame(mHasNoInputSource);
+
+	// Pack 10-bit frames to v210, the readback below then reads from the packed frame buffer
+	if (mV210Converter != NULL)
+		mV210Converter->pack(mRenderer->getFrameBufferTexture());
+
 	if (mFastTransferExtensionAvailable)
 	{
-		// Finished with mCaptureTexture
+		// Finished with the capture texture
 		mCaptureAllocator->endTextureInUse();
 
-		if (! mPlayoutAllocator->transferFrame(pFrame, mFBOTexture))
+		if (! mPlayoutAllocator->transferFrame(pFrame, mRenderer->getFrameBufferTexture()))
 			fprintf(stderr, "Playback: transferFrame() failed\n");
 
 		paintGL();
@@ -610,9 +626,26 @@ void OpenGLComposite::PlayoutNextFrame(IDeckLinkVideoFrame* completedFrame, BMDO
 		// Wait for transfer to system memory to complete
 		mPlayoutAllocator->waitForTransferComplete(pFrame);
 	}
+	else if (mPlayoutReadback != NULL)
+	{
+		// Copy the oldest frame still being read back into this output frame, then queue the frame just
+		// rendered.  The GPU renders and reads back this frame while earlier frames are played out.  Until
+		// the pipeline is primed there is no rendered frame to copy, so play out black rather than whatever
+		// the recycled output frame last held.
+		if (mPlayoutReadback->isFull())
+			mPlayoutReadback->completeReadback(pFrame, outputVideoFrame->GetRowBytes(), true);
+		else
+			FillBlackFrame(outputVideoFrame);
+
+		mPlayoutReadback->beginReadback();
+		paintGL();
+	}
 	else
 	{
-		glReadPixels(0, 0, mFrameWidth, mFrameHeight, GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV, pFrame);
+		if (mV210Converter != NULL)
+			glReadPixels(0, 0, mV210Converter->getPackedWidth(), mFrameHeight, GL_RGBA, GL_UNSIGNED_INT_2_10_10_10_REV, pFrame);
+		else
+			glReadPixels(0, 0, mFrameWidth, mFrameHeight, GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV, pFrame);
 		paintGL();
 	}
 
@@ -642,9 +675,7 @@ bool OpenGLComposite::Start()
 		mDLOutputVideoFrameQueue.pop_front();
 
 		// Start with a black frame for playout
-		void*	pFrame;
-		outputVideoFrame->GetBytes((void**)&pFrame);
-		memset(pFrame, 0, outputVideoFrame->GetRowBytes() * mFrameHeight);		// 0 is black in RGBA format
+		FillBlackFrame(outputVideoFrame);
 
 		if (mDLOutput->ScheduleVideoFrame(outputVideoFrame, (mTotalPlayoutFrames * mFrameDuration), mFrameDuration, mFrameTimescale) != S_OK)
 			return false;
@@ -666,119 +697,13 @@ bool OpenGLComposite::Stop()
 	mDLOutput->StopScheduledPlayback(0, NULL, 0);
 	mDLOutput->DisableVideoOutput();
 
-	return true;
-}
-
-// Setup fragment shader to take YCbCr 4:2:2 video texture in UYVY macropixel format
-// and perform colour space conversion to RGBA in the GPU.
-bool OpenGLComposite::compileFragmentShader(int errorMessageSize, char* errorMessage)
-{
-	GLsizei		errorBufferSize;
-	GLint		compileResult, linkResult;
-	const char*	fragmentSource =
-		"#version 130 \n"
-		"uniform sampler2D UYVYtex; \n"		// UYVY macropixel texture passed as RGBA format
-
-		"vec4 rec709YCbCr2rgba(float Y, float Cb, float Cr, float a) \n"
-		"{ \n"
-		"	float r, g, b; \n"
-		// Y: Undo 1/256 texture value scaling and scale [16..235] to [0..1] range
-		// C: Undo 1/256 texture value scaling and scale [16..240] to [-0.5 .. + 0.5] range
-		"	Y = (Y * 256.0 - 16.0) / 219.0; \n"
-		"	Cb = (Cb * 256.0 - 16.0) / 224.0 - 0.5; \n"
-		"	Cr = (Cr * 256.0 - 16.0) / 224.0 - 0.5; \n"
-		// Convert to RGB using Rec.709 conversion matrix (see eq 26.7 in Poynton 2003)
-		"	r = Y + 1.5748 * Cr; \n"
-		"	g = Y - 0.1873 * Cb - 0.4681 * Cr; \n"
-		"	b = Y + 1.8556 * Cb; \n"
-		"	return vec4(r, g, b, a); \n"
-		"}\n"
-
-		// Perform bilinear interpolation between the provided components.
-		// The samples are expected as shown:
-		// ---------
-		// | X | Y |
-		// |---+---|
-		// | W | Z |
-		// ---------
-		"vec4 bilinear(vec4 W, vec4 X, vec4 Y, vec4 Z, vec2 weight) \n"
-		"{\n"
-		"	vec4 m0 = mix(W, Z, weight.x);\n"
-		"	vec4 m1 = mix(X, Y, weight.x);\n"
-		"	return mix(m0, m1, weight.y); \n"
-		"}\n"
-
-		// Gather neighboring YUV macropixels from the given texture coordinate
-		"void textureGatherYUV(sampler2D UYVYsampler, vec2 tc, out vec4 W, out vec4 X, out vec4 Y, out vec4 Z) \n"
-		"{\n"
-		"	ivec2 tx = ivec2(tc * textureSize(UYVYsampler, 0));\n"
-		"	ivec2 tmin = ivec2(0,0);\n"
-		"	ivec2 tmax = textureSize(UYVYsampler, 0) - ivec2(1,1);\n"
-		"	W = texelFetch(UYVYsampler, tx, 0); \n"
-		"	X = texelFetch(UYVYsampler, clamp(tx + ivec2(0,1), tmin, tmax), 0); \n"
-		"	Y = texelFetch(UYVYsampler, clamp(tx + ivec2(1,1), tmin, tmax), 0); \n"
-		"	Z = texelFetch(UYVYsampler, clamp(tx + ivec2(1,0), tmin, tmax), 0); \n"
-		"}\n"
-
-		"void main(void) \n"
-		"{\n"
-		/* The shader uses texelFetch to obtain the YUV macropixels to avoid unwanted interpolation
-		 * introduced by the GPU interpreting the YUV data as RGBA pixels.
-		 * The YUV macropixels are converted into individual RGB pixels and bilinear interpolation is applied. */
-		"	vec2 tc = gl_TexCoord[0].st; \n"
-		"	float alpha = 0.7; \n"
-
-		"	vec4 macro, macro_u, macro_r, macro_ur;\n"
-		"	vec4 pixel, pixel_r, pixel_u, pixel_ur; \n"
-		"	textureGatherYUV(UYVYtex, tc, macro, macro_u, macro_ur, macro_r);\n"
-
-		//   Select the components for the bilinear interpolation based on the texture coordinate
-		//   location within the YUV macropixel:
-		//   -----------------          ----------------------
-		//   | UY/VY | UY/VY |          | macro_u | macro_ur |
-		//   |-------|-------|    =>    |---------|----------|
-		//   | UY/VY | UY/VY |          | macro   | macro_r  |
-		//   |-------|-------|          ----------------------
-		//   | RG/BA | RG/BA |
-		//   -----------------
-		"	vec2 off = fract(tc * textureSize(UYVYtex, 0)); \n"
-		"	if (off.x > 0.5) { \n"			// right half of macropixel
-		"		pixel = rec709YCbCr2rgba(macro.a, macro.b, macro.r, alpha); \n"
-		"		pixel_r = rec709YCbCr2rgba(macro_r.g, macro_r.b, macro_r.r, alpha); \n"
-		"		pixel_u = rec709YCbCr2rgba(macro_u.a, macro_u.b, macro_u.r, alpha); \n"
-		"		pixel_ur = rec709YCbCr2rgba(macro_ur.g, macro_ur.b, macro_ur.r, alpha); \n"
-		"	} else { \n"					// left half & center of macropixel
-		"		pixel = rec709YCbCr2rgba(macro.g, macro.b, macro.r, alpha); \n"
-		"		pixel_r = rec709YCbCr2rgba(macro.a, macro.b, macro.r, alpha); \n"
-		"		pixel_u = rec709YCbCr2rgba(macro_u.g, macro_u.b, macro_u.r, alpha); \n"
-		"		pixel_ur = rec709YCbCr2rgba(macro_u.a, macro_u.b, macro_u.r, alpha); \n"
-		"	}\n"
-
-		"	gl_FragColor = bilinear(pixel, pixel_u, pixel_ur, pixel_r, off); \n"
-		"}\n";
-
-	mFragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-
-	glShaderSource(mFragmentShader, 1, (const GLchar**)&fragmentSource, NULL);
-	glCompileShader(mFragmentShader);
-
-	glGetShaderiv(mFragmentShader, GL_COMPILE_STATUS, &compileResult);
-	if (compileResult == GL_FALSE)
+	// Frames still in the readback pipeline belong to this run, the next Start primes it again
+	if (mPlayoutReadback != NULL)
 	{
-		glGetShaderInfoLog(mFragmentShader, errorMessageSize, &errorBufferSize, errorMessage);
-		return false;
-	}
-
-	mProgram = glCreateProgram();
-
-	glAttachShader(mProgram, mFragmentShader);
-	glLinkProgram(mProgram);
-
-	glGetProgramiv(mProgram, GL_LINK_STATUS, &linkResult);
-	if (linkResult == GL_FALSE)
-	{
-		glGetProgramInfoLog(mProgram, errorMessageSize, &errorBufferSize, errorMessage);
-		return false;
+		mMutex.lock();
+		makeCurrent();
+		mPlayoutReadback->reset();
+		mMutex.unlock();
 	}
 
 	return true;
@@ -799,7 +724,8 @@ bool OpenGLComposite::CheckOpenGLExtensions()
 	strExt = glGetString (GL_EXTENSIONS);
 	hasFBO = gluCheckExtension ((const GLubyte*)"GL_EXT_framebuffer_object", strExt);
 
-	mFastTransferExtensionAvailable = VideoFrameTransfer::checkFastMemoryTransferAvailable();
+	// Fast transfers use textures sized for 8-bit video, 10-bit video uses the regular OpenGL transfers
+	mFastTransferExtensionAvailable = (mPixelFormat == bmdFormat8BitYUV) && VideoFrameTransfer::checkFastMemoryTransferAvailable();
 
 	if (!hasFBO)
 	{
@@ -965,8 +891,9 @@ HRESULT STDMETHODCALLTYPE	PinnedMemoryAllocator::Decommit ()
 ////////////////////////////////////////////
 // DeckLink Capture Delegate Class
 ////////////////////////////////////////////
-CaptureDelegate::CaptureDelegate() :
-	mRefCount(1)
+CaptureDelegate::CaptureDelegate(TextureUploadRing* uploadRing) :
+	mRefCount(1),
+	mUploadRing(uploadRing)
 {
 }
 
@@ -1000,6 +927,20 @@ HRESULT	CaptureDelegate::VideoInputFrameArrived(IDeckLinkVideoInputFrame* inputF
 
 	bool hasNoInputSource = (inputFrame->GetFlags() & bmdFrameHasNoInputSource) == bmdFrameHasNoInputSource;
 
+	if (mUploadRing != NULL)
+	{
+		// Copy the frame into a mapped pixel buffer here, so the GL thread only has to issue the texture upload
+		if (! hasNoInputSource)
+		{
+			void* videoPixels;
+			inputFrame->GetBytes(&videoPixels);
+			mUploadRing->writeFrame(videoPixels, inputFrame->GetRowBytes() * inputFrame->GetHeight());
+		}
+
+		emit captureFrameArrived(NULL, hasNoInputSource);
+		return S_OK;
+	}
+
 	// emit just adds a message to Qt's event queue since we're in a different thread, so add a reference
 	// to the input frame to prevent it getting released before the connected slot can process the frame.
 	inputFrame->AddRef();
@@ -43,6 +43,9 @@
 
 #include "DeckLinkAPI.h"
 #include "VideoFrameTransfer.h"
+#include "TextureUploadRing.h"
+#include "ReadbackPipeline.h"
+#include "CompositeRenderer.h"
 #include <QGLWidget>
 #include <QMutex>
 #include <QAtomicInt>
@@ -55,13 +58,15 @@
 class PlayoutDelegate;
 class CaptureDelegate;
 class PinnedMemoryAllocator;
+class V210Converter;
 
 class OpenGLComposite : public QGLWidget
 {
 	Q_OBJECT
 
 public:
-	OpenGLComposite(QWidget *parent = NULL);
+	// Video is captured and played out as 8-bit YUV (bmdFormat8BitYUV) or 10-bit YUV (bmdFormat10BitYUV)
+	OpenGLComposite(QWidget *parent = NULL, BMDPixelFormat pixelFormat = bmdFormat8BitYUV);
 	~OpenGLComposite();
 
 	bool InitDeckLink();
@@ -97,25 +102,30 @@ private:
 	unsigned								mTotalPlayoutFrames;
 	unsigned								mFrameWidth;
 	unsigned								mFrameHeight;
+	BMDPixelFormat							mPixelFormat;
 	bool									mHasNoInputSource;
 
 	// OpenGL data
 	bool									mFastTransferExtensionAvailable;
-	GLuint									mCaptureTexture;
-	GLuint									mFBOTexture;
-	GLuint									mUnpinnedTextureBuffer;
-	GLuint									mIdFrameBuf;
-	GLuint									mIdColorBuf;
-	GLuint									mIdDepthBuf;
-	GLuint									mProgram;
-	GLuint									mFragmentShader;
-	GLfloat									mRotateAngle;
+	CompositeRenderer*						mRenderer;
+	V210Converter*							mV210Converter;			// used for 10-bit video
+	TextureUploadRing*						mCaptureUploadRing;		// used when fast transfer extension is not available
+	ReadbackPipeline*						mPlayoutReadback;		// used when fast transfer extension is not available
 	GLfloat									mRotateAngleRate;
 	int										mViewWidth;
 	int										mViewHeight;
 
+	// Capture upload statistics, accumulated on the GL thread and reported once per second
+	unsigned								mUploadStatisticsFrames;
+	double									mUploadCopyTimeTotalMs;
+	double									mUploadCopyTimeMaxMs;
+	double									mUploadSubmitTimeTotalMs;
+	double									mUploadSubmitTimeMaxMs;
+	double									mUploadGPUTimeTotalMs;
+	double									mUploadGPUTimeMaxMs;
+
 	bool InitOpenGLState();
-	bool compileFragmentShader(int errorMessageSize, char* errorMessage);
+	void UpdateUploadStatistics();
 };
 
 ////////////////////////////////////////////
@@ -163,7 +173,7 @@ class CaptureDelegate : public QObject, public IDeckLinkInputCallback
 	Q_OBJECT
 
 public:
-	CaptureDelegate ();
+	CaptureDelegate (TextureUploadRing* uploadRing);
 
 	virtual HRESULT	STDMETHODCALLTYPE	QueryInterface (REFIID /*iid*/, LPVOID* /*ppv*/);
 	virtual ULONG	STDMETHODCALLTYPE	AddRef ();
@@ -173,10 +183,12 @@ public:
 	virtual HRESULT	STDMETHODCALLTYPE	VideoInputFormatChanged(BMDVideoInputFormatChangedEvents notificationEvents, IDeckLinkDisplayMode *newDisplayMode, BMDDetectedVideoInputFormatFlags detectedSignalFlags);
 
 signals:
+	// videoFrame is NULL when the frame has already been copied into the upload ring
 	void captureFrameArrived(IDeckLinkVideoInputFrame *videoFrame, bool hasNoInputSource);
 
 private:
 	QAtomicInt                              mRefCount;
+	TextureUploadRing*                      mUploadRing;
 };
 
 ////////////////////////////////////////////
@@ -0,0 +1,212 @@
+/* -LICENSE-START-
+ ** Copyright (c) 2022 Blackmagic Design
+ **  
+ ** Permission is hereby granted, free of charge, to any person or organization 
+ ** obtaining a copy of the software and accompanying documentation (the 
+ ** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+ ** and transmit the Software, and to prepare derivative works of the Software, 
+ ** and to permit third-parties to whom the Software is furnished to do so, in 
+ ** accordance with:
+ ** 
+ ** (1) if the Software is obtained from Blackmagic Design, the End User License 
+ ** Agreement for the Software Development Kit (“EULA”) available at 
+ ** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+ ** 
+ ** (2) if the Software is obtained from any third party, such licensing terms 
+ ** as notified by that third party,
+ ** 
+ ** and all subject to the following:
+ ** 
+ ** (3) the copyright notices in the Software and this entire statement, 
+ ** including the above license grant, this restriction and the following 
+ ** disclaimer, must be included in all copies of the Software, in whole or in 
+ ** part, and all derivative works of the Software, unless such copies or 
+ ** derivative works are solely in the form of machine-executable object code 
+ ** generated by a source language processor.
+ ** 
+ ** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ ** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ ** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+ ** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+ ** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+ ** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ ** DEALINGS IN THE SOFTWARE.
+ ** 
+ ** A copy of the Software is available free of charge at 
+ ** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+ ** 
+ ** -LICENSE-END-
+ */
+//
+// ReadbackPipeline.cpp
+// LoopThroughWithOpenGLCompositing
+//
+
+#include "ReadbackPipeline.h"
+#include <string.h>
+#include <time.h>
+
+ReadbackPipeline::ReadbackPipeline(unsigned depth) :
+	mSlots(depth),
+	mWidth(0),
+	mHeight(0),
+	mFormat(GL_BGRA),
+	mType(GL_UNSIGNED_INT_8_8_8_8_REV),
+	mNextSlot(0),
+	mPendingCount(0),
+	mFramesRead(0),
+	mLastWaitTimeNs(0),
+	mLastCopyTimeNs(0)
+{
+	for (std::vector<Slot>::iterator it = mSlots.begin(); it != mSlots.end(); ++it)
+	{
+		it->buffer = 0;
+		it->fence = NULL;
+	}
+}
+
+ReadbackPipeline::~ReadbackPipeline()
+{
+	// GL resources must be released by cleanup() while the context is current
+}
+
+bool ReadbackPipeline::initialize(unsigned width, unsigned height, GLenum format, GLenum type)
+{
+	mWidth = width;
+	mHeight = height;
+	mFormat = format;
+	mType = type;
+	mNextSlot = 0;
+	mPendingCount = 0;
+
+	for (std::vector<Slot>::iterator it = mSlots.begin(); it != mSlots.end(); ++it)
+	{
+		glGenBuffers(1, &it->buffer);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, it->buffer);
+		glBufferData(GL_PIXEL_PACK_BUFFER, mWidth * 4 * mHeight, NULL, GL_STREAM_READ);
+	}
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	return glGetError() == GL_NO_ERROR;
+}
+
+void ReadbackPipeline::cleanup()
+{
+	for (std::vector<Slot>::iterator it = mSlots.begin(); it != mSlots.end(); ++it)
+	{
+		if (it->fence != NULL)
+		{
+			glDeleteSync(it->fence);
+			it->fence = NULL;
+		}
+
+		if (it->buffer != 0)
+		{
+			glDeleteBuffers(1, &it->buffer);
+			it->buffer = 0;
+		}
+	}
+
+	mPendingCount = 0;
+}
+
+void ReadbackPipeline::reset()
+{
+	// The pack buffers are reused as they are, later reads are ordered after the discarded ones
+	for (std::vector<Slot>::iterator it = mSlots.begin(); it != mSlots.end(); ++it)
+	{
+		if (it->fence != NULL)
+		{
+			glDeleteSync(it->fence);
+			it->fence = NULL;
+		}
+	}
+
+	mNextSlot = 0;
+	mPendingCount = 0;
+}
+
+bool ReadbackPipeline::beginReadback()
+{
+	if (mSlots.empty() || isFull())
+		return false;
+
+	Slot& slot = mSlots[mNextSlot];
+
+	// NULL for last arg indicates read into the current GL_PIXEL_PACK_BUFFER target, this returns
+	// without waiting for rendering to complete
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+	glReadPixels(0, 0, mWidth, mHeight, mFormat, mType, NULL);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	// Flush so that the fence is guaranteed to signal while waiting for it from a later call
+	slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	glFlush();
+
+	mNextSlot = (mNextSlot + 1) % mSlots.size();
+	mPendingCount++;
+
+	return true;
+}
+
+bool ReadbackPipeline::completeReadback(void* destination, unsigned destinationRowBytes, bool waitForCompletion)
+{
+	if (mPendingCount == 0)
+		return false;
+
+	Slot&		slot = mSlots[(mNextSlot + mSlots.size() - mPendingCount) % mSlots.size()];
+	unsigned	rowBytes = mWidth * 4;
+	int64_t		startTime = getTimeNs();
+	GLenum		waitResult;
+
+	waitResult = glClientWaitSync(slot.fence, 0, waitForCompletion ? GL_TIMEOUT_IGNORED : 0);
+	if ((waitResult != GL_ALREADY_SIGNALED) && (waitResult != GL_CONDITION_SATISFIED))
+		return false;
+
+	glDeleteSync(slot.fence);
+	slot.fence = NULL;
+	mPendingCount--;
+
+	int64_t copyStartTime = getTimeNs();
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+
+	const char* pixels = (const char*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, rowBytes * mHeight, GL_MAP_READ_BIT);
+	if (pixels != NULL)
+	{
+		if (destinationRowBytes == rowBytes)
+		{
+			memcpy(destination, pixels, rowBytes * mHeight);
+		}
+		else
+		{
+			for (unsigned line = 0; line < mHeight; line++)
+				memcpy((char*)destination + line * destinationRowBytes, pixels + line * rowBytes, rowBytes);
+		}
+
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	}
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	mFramesRead++;
+	mLastWaitTimeNs = copyStartTime - startTime;
+	mLastCopyTimeNs = getTimeNs() - copyStartTime;
+
+	return pixels != NULL;
+}
+
+void ReadbackPipeline::getStatistics(Statistics& statistics) const
+{
+	statistics.framesRead		= mFramesRead;
+	statistics.lastWaitTimeMs	= mLastWaitTimeNs / 1000000.0;
+	statistics.lastCopyTimeMs	= mLastCopyTimeNs / 1000000.0;
+}
+
+int64_t ReadbackPipeline::getTimeNs()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (int64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
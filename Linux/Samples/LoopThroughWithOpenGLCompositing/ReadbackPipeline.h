@@ -0,0 +1,113 @@
+/* -LICENSE-START-
+ ** Copyright (c) 2022 Blackmagic Design
+ **  
+ ** Permission is hereby granted, free of charge, to any person or organization 
+ ** obtaining a copy of the software and accompanying documentation (the 
+ ** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+ ** and transmit the Software, and to prepare derivative works of the Software, 
+ ** and to permit third-parties to whom the Software is furnished to do so, in 
+ ** accordance with:
+ ** 
+ ** (1) if the Software is obtained from Blackmagic Design, the End User License 
+ ** Agreement for the Software Development Kit (“EULA”) available at 
+ ** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+ ** 
+ ** (2) if the Software is obtained from any third party, such licensing terms 
+ ** as notified by that third party,
+ ** 
+ ** and all subject to the following:
+ ** 
+ ** (3) the copyright notices in the Software and this entire statement, 
+ ** including the above license grant, this restriction and the following 
+ ** disclaimer, must be included in all copies of the Software, in whole or in 
+ ** part, and all derivative works of the Software, unless such copies or 
+ ** derivative works are solely in the form of machine-executable object code 
+ ** generated by a source language processor.
+ ** 
+ ** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ ** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ ** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+ ** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+ ** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+ ** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ ** DEALINGS IN THE SOFTWARE.
+ ** 
+ ** A copy of the Software is available free of charge at 
+ ** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+ ** 
+ ** -LICENSE-END-
+ */
+//
+// ReadbackPipeline.h
+// LoopThroughWithOpenGLCompositing
+//
+
+#ifndef __READBACK_PIPELINE_H__
+#define __READBACK_PIPELINE_H__
+
+#include "GLExtensions.h"
+#include <vector>
+#include <stdint.h>
+
+// Pipelined readback of rendered frames through pixel pack buffers.
+//
+// beginReadback() queues an asynchronous glReadPixels of the current read framebuffer into the next pack
+// buffer and inserts a fence, so it returns without waiting for rendering to complete.  completeReadback()
+// waits on the fence of the oldest queued frame, maps its buffer and copies the pixels out.  With a depth of
+// N, frame N is rendered while up to N previous frames are still being read back, at the cost of N frames
+// of additional latency.
+class ReadbackPipeline
+{
+public:
+	struct Statistics
+	{
+		uint64_t	framesRead;
+		double		lastWaitTimeMs;		// Time blocked on the oldest frame's fence
+		double		lastCopyTimeMs;		// Time to copy the mapped buffer into the destination
+	};
+
+	ReadbackPipeline(unsigned depth);
+	~ReadbackPipeline();
+
+	// Must be called with the GL context current.  Frames are read as 8-bit BGRA by default, the format and type
+	// can be set to read other 32-bit pixel formats such as GL_RGBA, GL_UNSIGNED_INT_2_10_10_10_REV for v210 words.
+	bool initialize(unsigned width, unsigned height, GLenum format = GL_BGRA, GLenum type = GL_UNSIGNED_INT_8_8_8_8_REV);
+	void cleanup();
+
+	// Discard any frames still being read back, the next frame completed is then the next one begun
+	void reset();
+
+	unsigned getDepth() const { return (unsigned)mSlots.size(); }
+	unsigned getPendingCount() const { return mPendingCount; }
+	bool isFull() const { return mPendingCount == mSlots.size(); }
+
+	// Queue readback of the currently bound read framebuffer, fails if all buffers are pending
+	bool beginReadback();
+
+	// Copy the oldest pending frame to destination, if waitForCompletion is false returns false when the frame is not ready
+	bool completeReadback(void* destination, unsigned destinationRowBytes, bool waitForCompletion);
+
+	void getStatistics(Statistics& statistics) const;
+
+private:
+	struct Slot
+	{
+		GLuint		buffer;
+		GLsync		fence;
+	};
+
+	static int64_t getTimeNs();
+
+	std::vector<Slot>	mSlots;
+	unsigned			mWidth;
+	unsigned			mHeight;
+	GLenum				mFormat;
+	GLenum				mType;
+	unsigned			mNextSlot;
+	unsigned			mPendingCount;
+	uint64_t			mFramesRead;
+	int64_t				mLastWaitTimeNs;
+	int64_t				mLastCopyTimeNs;
+};
+
+#endif	// __READBACK_PIPELINE_H__
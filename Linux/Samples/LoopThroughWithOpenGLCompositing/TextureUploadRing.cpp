@@ -0,0 +1,369 @@
+/* -LICENSE-START-
+ ** Copyright (c) 2022 Blackmagic Design
+ **  
+ ** Permission is hereby granted, free of charge, to any person or organization 
+ ** obtaining a copy of the software and accompanying documentation (the 
+ ** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+ ** and transmit the Software, and to prepare derivative works of the Software, 
+ ** and to permit third-parties to whom the Software is furnished to do so, in 
+ ** accordance with:
+ ** 
+ ** (1) if the Software is obtained from Blackmagic Design, the End User License 
+ ** Agreement for the Software Development Kit (“EULA”) available at 
+ ** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+ ** 
+ ** (2) if the Software is obtained from any third party, such licensing terms 
+ ** as notified by that third party,
+ ** 
+ ** and all subject to the following:
+ ** 
+ ** (3) the copyright notices in the Software and this entire statement, 
+ ** including the above license grant, this restriction and the following 
+ ** disclaimer, must be included in all copies of the Software, in whole or in 
+ ** part, and all derivative works of the Software, unless such copies or 
+ ** derivative works are solely in the form of machine-executable object code 
+ ** generated by a source language processor.
+ ** 
+ ** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ ** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ ** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+ ** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+ ** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+ ** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ ** DEALINGS IN THE SOFTWARE.
+ ** 
+ ** A copy of the Software is available free of charge at 
+ ** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+ ** 
+ ** -LICENSE-END-
+ */
+//
+// TextureUploadRing.cpp
+// LoopThroughWithOpenGLCompositing
+//
+
+#include "TextureUploadRing.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+TextureUploadRing::TextureUploadRing(unsigned slotCount, unsigned long slotSize) :
+	mSlots(slotCount),
+	mSlotSize(slotSize),
+	mInitialized(false),
+	mPersistentMapping(false),
+	mTimerQueries(false),
+	mNextSequence(0),
+	mFramesWritten(0),
+	mFramesUploaded(0),
+	mFramesSkipped(0),
+	mFramesDropped(0),
+	mLastCopyTimeNs(0),
+	mLastSubmitTimeNs(0),
+	mLastUploadTimeNs(0)
+{
+	for (std::vector<Slot>::iterator it = mSlots.begin(); it != mSlots.end(); ++it)
+	{
+		it->buffer = 0;
+		it->query = 0;
+		it->fence = NULL;
+		it->mappedAddress = NULL;
+		it->state = kSlotUnmapped;
+		it->sequence = 0;
+	}
+}
+
+TextureUploadRing::~TextureUploadRing()
+{
+	// GL resources must be released by cleanup() while the context is current
+}
+
+bool TextureUploadRing::initialize(bool persistentMapping, bool timerQueries)
+{
+	mPersistentMapping = persistentMapping && (glBufferStorage != NULL);
+	mTimerQueries = timerQueries && (glGetQueryObjectui64v != NULL);
+
+	for (std::vector<Slot>::iterator it = mSlots.begin(); it != mSlots.end(); ++it)
+	{
+		glGenBuffers(1, &it->buffer);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, it->buffer);
+
+		if (mPersistentMapping)
+		{
+			// Immutable storage stays mapped for the lifetime of the ring, coherent mapping means that
+			// no explicit flush or barrier is required before the buffer is used by an upload
+			glBufferStorage(GL_PIXEL_UNPACK_BUFFER, mSlotSize, NULL, GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT);
+		}
+		else
+		{
+			glBufferData(GL_PIXEL_UNPACK_BUFFER, mSlotSize, NULL, GL_STREAM_DRAW);
+		}
+
+		if (mTimerQueries)
+			glGenQueries(1, &it->query);
+
+		if (! mapSlot(*it))
+		{
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+			cleanup();
+			return false;
+		}
+	}
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	mInitialized = true;
+
+	return true;
+}
+
+void TextureUploadRing::cleanup()
+{
+	for (std::vector<Slot>::iterator it = mSlots.begin(); it != mSlots.end(); ++it)
+	{
+		if (it->fence != NULL)
+		{
+			glClientWaitSync(it->fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+			glDeleteSync(it->fence);
+			it->fence = NULL;
+		}
+
+		if (it->mappedAddress != NULL)
+		{
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, it->buffer);
+			glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+			it->mappedAddress = NULL;
+		}
+
+		if (it->buffer != 0)
+		{
+			glDeleteBuffers(1, &it->buffer);
+			it->buffer = 0;
+		}
+
+		if (it->query != 0)
+		{
+			glDeleteQueries(1, &it->query);
+			it->query = 0;
+		}
+
+		it->state = kSlotUnmapped;
+	}
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	mInitialized = false;
+}
+
+// Map the slot's buffer and make it available to the capture thread, the buffer must be bound to GL_PIXEL_UNPACK_BUFFER
+bool TextureUploadRing::mapSlot(Slot& slot)
+{
+	if (slot.mappedAddress == NULL)
+	{
+		GLbitfield access = mPersistentMapping ?
+			(GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT) :
+			(GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+
+		slot.mappedAddress = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, mSlotSize, access);
+		if (slot.mappedAddress == NULL)
+			return false;
+	}
+
+	slot.state.store(kSlotFree, std::memory_order_release);
+	return true;
+}
+
+bool TextureUploadRing::writeFrame(const void* pixels, unsigned long size)
+{
+	Slot*	writeSlot = NULL;
+	int64_t	startTime = getTimeNs();
+
+	if (size > mSlotSize)
+		return false;
+
+	// Prefer a free slot, otherwise replace the oldest frame that has not yet started uploading
+	for (std::vector<Slot>::iterator it = mSlots.begin(); it != mSlots.end() && writeSlot == NULL; ++it)
+	{
+		int expectedState = kSlotFree;
+		if (it->state.compare_exchange_strong(expectedState, kSlotWriting, std::memory_order_acquire))
+			writeSlot = &(*it);
+	}
+
+	while (writeSlot == NULL)
+	{
+		Slot* oldestSlot = NULL;
+
+		for (std::vector<Slot>::iterator it = mSlots.begin(); it != mSlots.end(); ++it)
+		{
+			if ((it->state.load(std::memory_order_relaxed) == kSlotFilled) &&
+				((oldestSlot == NULL) || (it->sequence.load(std::memory_order_relaxed) < oldestSlot->sequence.load(std::memory_order_relaxed))))
+				oldestSlot = &(*it);
+		}
+
+		if (oldestSlot == NULL)
+		{
+			// Every slot is being uploaded
+			mFramesDropped.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+
+		int expectedState = kSlotFilled;
+		if (oldestSlot->state.compare_exchange_strong(expectedState, kSlotWriting, std::memory_order_acquire))
+		{
+			writeSlot = oldestSlot;
+			mFramesSkipped.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	memcpy(writeSlot->mappedAddress, pixels, size);
+
+	writeSlot->sequence.store(++mNextSequence, std::memory_order_relaxed);
+	writeSlot->state.store(kSlotFilled, std::memory_order_release);
+
+	mFramesWritten.fetch_add(1, std::memory_order_relaxed);
+	mLastCopyTimeNs.store(getTimeNs() - startTime, std::memory_order_relaxed);
+
+	return true;
+}
+
+void TextureUploadRing::reclaimCompletedSlots()
+{
+	for (std::vector<Slot>::iterator it = mSlots.begin(); it != mSlots.end(); ++it)
+	{
+		if (it->state.load(std::memory_order_relaxed) == kSlotUploading)
+		{
+			GLenum waitResult = glClientWaitSync(it->fence, 0, 0);
+			if ((waitResult != GL_ALREADY_SIGNALED) && (waitResult != GL_CONDITION_SATISFIED))
+				continue;
+
+			glDeleteSync(it->fence);
+			it->fence = NULL;
+
+			if (mTimerQueries)
+			{
+				GLuint64 available = 0;
+				GLuint64 elapsedTime;
+
+				glGetQueryObjectui64v(it->query, GL_QUERY_RESULT_AVAILABLE, &available);
+				if (available)
+				{
+					glGetQueryObjectui64v(it->query, GL_QUERY_RESULT, &elapsedTime);
+					mLastUploadTimeNs.store((int64_t)elapsedTime, std::memory_order_relaxed);
+				}
+			}
+
+			it->state.store(kSlotUnmapped, std::memory_order_relaxed);
+		}
+
+		if (it->state.load(std::memory_order_relaxed) == kSlotUnmapped)
+		{
+			// The GPU has finished reading from the buffer, so it can be mapped unsynchronized
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, it->buffer);
+			if (! mapSlot(*it))
+				fprintf(stderr, "TextureUploadRing: Unable to map pixel buffer\n");
+		}
+	}
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+bool TextureUploadRing::uploadToTexture(GLuint texture, GLsizei width, GLsizei height, GLenum format, GLenum type)
+{
+	Slot*	uploadSlot = NULL;
+	int64_t	startTime = getTimeNs();
+
+	if (! mInitialized)
+		return false;
+
+	reclaimCompletedSlots();
+
+	// Claim the newest filled slot, the capture thread may take an old filled slot at the same time
+	while (uploadSlot == NULL)
+	{
+		Slot* newestSlot = NULL;
+
+		for (std::vector<Slot>::iterator it = mSlots.begin(); it != mSlots.end(); ++it)
+		{
+			if ((it->state.load(std::memory_order_relaxed) == kSlotFilled) &&
+				((newestSlot == NULL) || (it->sequence.load(std::memory_order_relaxed) > newestSlot->sequence.load(std::memory_order_relaxed))))
+				newestSlot = &(*it);
+		}
+
+		if (newestSlot == NULL)
+			return false;
+
+		int expectedState = kSlotFilled;
+		if (newestSlot->state.compare_exchange_strong(expectedState, kSlotUploading, std::memory_order_acquire))
+			uploadSlot = newestSlot;
+	}
+
+	// Return any older frames to the capture thread without uploading them.  Each slot is claimed before
+	// checking its sequence, since the capture thread may refill it with a newer frame in the meantime.
+	for (std::vector<Slot>::iterator it = mSlots.begin(); it != mSlots.end(); ++it)
+	{
+		int expectedState = kSlotFilled;
+		if ((&(*it) == uploadSlot) || ! it->state.compare_exchange_strong(expectedState, kSlotUploading, std::memory_order_acquire))
+			continue;
+
+		if (it->sequence.load(std::memory_order_relaxed) < uploadSlot->sequence.load(std::memory_order_relaxed))
+		{
+			it->state.store(kSlotFree, std::memory_order_release);
+			mFramesSkipped.fetch_add(1, std::memory_order_relaxed);
+		}
+		else
+		{
+			it->state.store(kSlotFilled, std::memory_order_release);
+		}
+	}
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, uploadSlot->buffer);
+
+	if (! mPersistentMapping)
+	{
+		uploadSlot->mappedAddress = NULL;
+		if (! glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER))
+		{
+			// Buffer contents were lost, eg. by a display mode change, so discard the frame
+			uploadSlot->state.store(kSlotUnmapped, std::memory_order_relaxed);
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+			return false;
+		}
+	}
+
+	glBindTexture(GL_TEXTURE_2D, texture);
+
+	if (mTimerQueries)
+		glBeginQuery(GL_TIME_ELAPSED, uploadSlot->query);
+
+	// NULL for last arg indicates use current GL_PIXEL_UNPACK_BUFFER target as texture data
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, format, type, NULL);
+
+	if (mTimerQueries)
+		glEndQuery(GL_TIME_ELAPSED);
+
+	uploadSlot->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	mFramesUploaded.fetch_add(1, std::memory_order_relaxed);
+	mLastSubmitTimeNs.store(getTimeNs() - startTime, std::memory_order_relaxed);
+
+	return true;
+}
+
+void TextureUploadRing::getStatistics(Statistics& statistics) const
+{
+	statistics.framesWritten		= mFramesWritten.load(std::memory_order_relaxed);
+	statistics.framesUploaded		= mFramesUploaded.load(std::memory_order_relaxed);
+	statistics.framesSkipped		= mFramesSkipped.load(std::memory_order_relaxed);
+	statistics.framesDropped		= mFramesDropped.load(std::memory_order_relaxed);
+	statistics.lastCopyTimeMs		= mLastCopyTimeNs.load(std::memory_order_relaxed) / 1000000.0;
+	statistics.lastSubmitTimeMs		= mLastSubmitTimeNs.load(std::memory_order_relaxed) / 1000000.0;
+	statistics.lastUploadTimeMs		= mLastUploadTimeNs.load(std::memory_order_relaxed) / 1000000.0;
+}
+
+int64_t TextureUploadRing::getTimeNs()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (int64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
@@ -0,0 +1,131 @@
+/* -LICENSE-START-
+ ** Copyright (c) 2022 Blackmagic Design
+ **  
+ ** Permission is hereby granted, free of charge, to any person or organization 
+ ** obtaining a copy of the software and accompanying documentation (the 
+ ** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+ ** and transmit the Software, and to prepare derivative works of the Software, 
+ ** and to permit third-parties to whom the Software is furnished to do so, in 
+ ** accordance with:
+ ** 
+ ** (1) if the Software is obtained from Blackmagic Design, the End User License 
+ ** Agreement for the Software Development Kit (“EULA”) available at 
+ ** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+ ** 
+ ** (2) if the Software is obtained from any third party, such licensing terms 
+ ** as notified by that third party,
+ ** 
+ ** and all subject to the following:
+ ** 
+ ** (3) the copyright notices in the Software and this entire statement, 
+ ** including the above license grant, this restriction and the following 
+ ** disclaimer, must be included in all copies of the Software, in whole or in 
+ ** part, and all derivative works of the Software, unless such copies or 
+ ** derivative works are solely in the form of machine-executable object code 
+ ** generated by a source language processor.
+ ** 
+ ** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ ** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ ** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+ ** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+ ** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+ ** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ ** DEALINGS IN THE SOFTWARE.
+ ** 
+ ** A copy of the Software is available free of charge at 
+ ** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+ ** 
+ ** -LICENSE-END-
+ */
+//
+// TextureUploadRing.h
+// LoopThroughWithOpenGLCompositing
+//
+
+#ifndef __TEXTURE_UPLOAD_RING_H__
+#define __TEXTURE_UPLOAD_RING_H__
+
+#include "GLExtensions.h"
+#include <atomic>
+#include <vector>
+#include <stdint.h>
+
+// Ring of pixel unpack buffers used to upload captured frames to a texture when the fast memory transfer
+// extensions are not available.
+//
+// Each slot's PBO is kept mapped while the slot is free, persistently when GL_ARB_buffer_storage is available,
+// otherwise it is re-mapped by the GL thread once the previous upload from the slot has completed.  The capture
+// thread copies a frame into a free slot without any GL calls or locks.  The GL thread then uploads the newest
+// filled slot into the texture with glTexSubImage2D and inserts a fence, so the slot is only reused once the
+// GPU has finished reading from it.  If the ring is full the capture thread overwrites the oldest frame that is
+// still waiting to be uploaded.
+class TextureUploadRing
+{
+public:
+	struct Statistics
+	{
+		uint64_t	framesWritten;
+		uint64_t	framesUploaded;
+		uint64_t	framesSkipped;			// Overwritten or superseded before upload
+		uint64_t	framesDropped;			// No free slot available
+		double		lastCopyTimeMs;			// Capture thread memcpy into the slot
+		double		lastSubmitTimeMs;		// GL thread time to issue the upload
+		double		lastUploadTimeMs;		// GPU time of the upload, if GL_ARB_timer_query is available
+	};
+
+	TextureUploadRing(unsigned slotCount, unsigned long slotSize);
+	~TextureUploadRing();
+
+	// Must be called with the GL context current.  The capture thread must not be writing during cleanup().
+	bool initialize(bool persistentMapping, bool timerQueries);
+	void cleanup();
+	bool uploadToTexture(GLuint texture, GLsizei width, GLsizei height, GLenum format, GLenum type);
+
+	// Can be called from any single producer thread, never makes GL calls
+	bool writeFrame(const void* pixels, unsigned long size);
+
+	bool isPersistentlyMapped() const { return mPersistentMapping; }
+	void getStatistics(Statistics& statistics) const;
+
+private:
+	enum SlotState
+	{
+		kSlotUnmapped,			// Free, waiting for GL thread to map it
+		kSlotFree,				// Mapped and available to the capture thread
+		kSlotWriting,			// Capture thread is copying into the slot
+		kSlotFilled,			// Holds a frame waiting for upload
+		kSlotUploading			// Upload has been issued and the fence has not yet signalled
+	};
+
+	struct Slot
+	{
+		GLuint					buffer;
+		GLuint					query;
+		GLsync					fence;
+		void*					mappedAddress;
+		std::atomic<int>		state;
+		std::atomic<uint64_t>	sequence;			// Order in which slots were filled
+	};
+
+	bool mapSlot(Slot& slot);
+	void reclaimCompletedSlots();
+	static int64_t getTimeNs();
+
+	std::vector<Slot>		mSlots;
+	unsigned long			mSlotSize;
+	bool					mInitialized;
+	bool					mPersistentMapping;
+	bool					mTimerQueries;
+	uint64_t				mNextSequence;		// Written by capture thread only
+
+	// Statistics, updated from both the capture and GL threads
+	std::atomic<uint64_t>	mFramesWritten;
+	std::atomic<uint64_t>	mFramesUploaded;
+	std::atomic<uint64_t>	mFramesSkipped;
+	std::atomic<uint64_t>	mFramesDropped;
+	std::atomic<int64_t>	mLastCopyTimeNs;
+	std::atomic<int64_t>	mLastSubmitTimeNs;
+	std::atomic<int64_t>	mLastUploadTimeNs;
+};
+
+#endif	// __TEXTURE_UPLOAD_RING_H__
@@ -0,0 +1,330 @@
+/* -LICENSE-START-
+ ** Copyright (c) 2022 Blackmagic Design
+ **  
+ ** Permission is hereby granted, free of charge, to any person or organization 
+ ** obtaining a copy of the software and accompanying documentation (the 
+ ** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+ ** and transmit the Software, and to prepare derivative works of the Software, 
+ ** and to permit third-parties to whom the Software is furnished to do so, in 
+ ** accordance with:
+ ** 
+ ** (1) if the Software is obtained from Blackmagic Design, the End User License 
+ ** Agreement for the Software Development Kit (“EULA”) available at 
+ ** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+ ** 
+ ** (2) if the Software is obtained from any third party, such licensing terms 
+ ** as notified by that third party,
+ ** 
+ ** and all subject to the following:
+ ** 
+ ** (3) the copyright notices in the Software and this entire statement, 
+ ** including the above license grant, this restriction and the following 
+ ** disclaimer, must be included in all copies of the Software, in whole or in 
+ ** part, and all derivative works of the Software, unless such copies or 
+ ** derivative works are solely in the form of machine-executable object code 
+ ** generated by a source language processor.
+ ** 
+ ** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ ** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ ** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+ ** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+ ** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+ ** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ ** DEALINGS IN THE SOFTWARE.
+ ** 
+ ** A copy of the Software is available free of charge at 
+ ** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+ ** 
+ ** -LICENSE-END-
+ */
+
+//
+// V210Converter.cpp
+// LoopThroughWithOpenGLCompositing
+//
+
+#include "V210Converter.h"
+#include "GLExtensions.h"
+#include <stdio.h>
+
+// v210 component order within each group of four words (6 pixels), component 0 is in the low bits of each word:
+//   word 0: Cb0 Y0  Cr0
+//   word 1: Y1  Cb2 Y2
+//   word 2: Cr2 Y3  Cb4
+//   word 3: Y4  Cr4 Y5
+// Components are Rec.709 video range, Y [64..940] and CbCr [64..960].
+
+// Each fragment is one RGB pixel of the unpacked frame
+static const char* kUnpackFragmentSource =
+	"#version 130 \n"
+	"uniform sampler2D packedTex; \n"
+	"uniform int frameWidth; \n"
+
+	"vec3 rec709YCbCr2rgb(float Y, vec2 CbCr) \n"
+	"{ \n"
+	"	Y = (Y - 64.0) / 876.0; \n"
+	"	CbCr = (CbCr - 512.0) / 896.0; \n"
+	"	return vec3(Y + 1.5748 * CbCr.y, Y - 0.1873 * CbCr.x - 0.4681 * CbCr.y, Y + 1.8556 * CbCr.x); \n"
+	"} \n"
+
+	// Fetch the three 10-bit components of a word as integer values
+	"vec3 fetchWord(int x, int y) \n"
+	"{ \n"
+	"	x = min(x, textureSize(packedTex, 0).x - 1); \n"
+	"	return floor(texelFetch(packedTex, ivec2(x, y), 0).rgb * 1023.0 + 0.5); \n"
+	"} \n"
+
+	"void main(void) \n"
+	"{ \n"
+	"	ivec2 pos = ivec2(gl_FragCoord.xy); \n"
+	"	int group = pos.x / 6; \n"
+	"	int index = pos.x - group * 6; \n"
+	"	vec3 w0 = fetchWord(group * 4 + 0, pos.y); \n"
+	"	vec3 w1 = fetchWord(group * 4 + 1, pos.y); \n"
+	"	vec3 w2 = fetchWord(group * 4 + 2, pos.y); \n"
+	"	vec3 w3 = fetchWord(group * 4 + 3, pos.y); \n"
+
+	// Chroma is co-sited with the even pixels, odd pixels interpolate the neighbouring chroma samples
+	"	vec2 c0 = vec2(w0.r, w0.b); \n"
+	"	vec2 c2 = vec2(w1.g, w2.r); \n"
+	"	vec2 c4 = vec2(w2.b, w3.g); \n"
+	"	vec2 c6 = c4; \n"
+	"	if (index == 5 && pos.x + 1 < frameWidth) { \n"
+	"		vec3 w4 = fetchWord(group * 4 + 4, pos.y); \n"
+	"		c6 = vec2(w4.r, w4.b); \n"
+	"	} \n"
+
+	"	float Y; \n"
+	"	vec2 CbCr; \n"
+	"	if (index == 0)      { Y = w0.g; CbCr = c0; } \n"
+	"	else if (index == 1) { Y = w1.r; CbCr = (c0 + c2) * 0.5; } \n"
+	"	else if (index == 2) { Y = w1.b; CbCr = c2; } \n"
+	"	else if (index == 3) { Y = w2.g; CbCr = (c2 + c4) * 0.5; } \n"
+	"	else if (index == 4) { Y = w3.r; CbCr = c4; } \n"
+	"	else                 { Y = w3.b; CbCr = (c4 + c6) * 0.5; } \n"
+
+	"	gl_FragColor = vec4(rec709YCbCr2rgb(Y, CbCr), 1.0); \n"
+	"} \n";
+
+// Each fragment is one v210 word of the packed frame
+static const char* kPackFragmentSource =
+	"#version 130 \n"
+	"uniform sampler2D rgbTex; \n"
+	"uniform int frameWidth; \n"
+
+	// Returns Y in x and CbCr in yz as video range 10-bit values
+	"vec3 rgb2rec709YCbCr(vec3 rgb) \n"
+	"{ \n"
+	"	float Y = dot(rgb, vec3(0.2126, 0.7152, 0.0722)); \n"
+	"	return vec3(64.0 + 876.0 * Y, 512.0 + 896.0 * (rgb.b - Y) / 1.8556, 512.0 + 896.0 * (rgb.r - Y) / 1.5748); \n"
+	"} \n"
+
+	"vec3 fetchPixel(int x, int y) \n"
+	"{ \n"
+	"	ivec2 size = textureSize(rgbTex, 0); \n"
+	"	return rgb2rec709YCbCr(clamp(texelFetch(rgbTex, ivec2(min(x, frameWidth - 1), size.y - 1 - y), 0).rgb, 0.0, 1.0)); \n"
+	"} \n"
+
+	"void main(void) \n"
+	"{ \n"
+	"	ivec2 pos = ivec2(gl_FragCoord.xy); \n"
+	"	int group = pos.x / 4; \n"
+	"	int word = pos.x - group * 4; \n"
+	"	int x = group * 6 + (word * 3) / 2; \n"
+
+	// Each word covers at most two pixel pairs starting at an even pixel, chroma for a pair is the average of its two pixels
+	"	vec3 p0 = fetchPixel(x & ~1, pos.y); \n"
+	"	vec3 p1 = fetchPixel((x & ~1) + 1, pos.y); \n"
+	"	vec3 p2 = fetchPixel((x & ~1) + 2, pos.y); \n"
+	"	vec3 p3 = fetchPixel((x & ~1) + 3, pos.y); \n"
+	"	vec2 ca = (p0.yz + p1.yz) * 0.5; \n"
+	"	vec2 cb = (p2.yz + p3.yz) * 0.5; \n"
+
+	"	vec3 components; \n"
+	"	if (word == 0)      components = vec3(ca.x, p0.x, ca.y); \n"		// Cb0 Y0 Cr0
+	"	else if (word == 1) components = vec3(p1.x, cb.x, p2.x); \n"		// Y1 Cb2 Y2
+	"	else if (word == 2) components = vec3(ca.y, p1.x, cb.x); \n"		// Cr2 Y3 Cb4
+	"	else                components = vec3(p0.x, ca.y, p1.x); \n"		// Y4 Cr4 Y5
+
+	// Keep within the legal range, 0-3 and 1020-1023 are reserved for timing references
+	"	gl_FragColor = vec4(clamp(floor(components + 0.5), 4.0, 1019.0) / 1023.0, 0.0); \n"
+	"} \n";
+
+V210Converter::V210Converter() :
+	mWidth(0), mHeight(0), mPackedWidth(0),
+	mPackedInputTexture(0),
+	mPackedOutputTexture(0),
+	mUnpackFrameBuf(0),
+	mPackFrameBuf(0),
+	mUnpackProgram(0),
+	mUnpackShader(0),
+	mPackProgram(0),
+	mPackShader(0)
+{
+}
+
+V210Converter::~V210Converter()
+{
+}
+
+bool V210Converter::initialize(unsigned width, unsigned height, GLuint unpackTarget, int errorMessageSize, char* errorMessage)
+{
+	mWidth = width;
+	mHeight = height;
+	mPackedWidth = getRowBytes(width) / 4;
+
+	if (! compileProgram(kUnpackFragmentSource, mUnpackShader, mUnpackProgram, errorMessageSize, errorMessage) ||
+		! compileProgram(kPackFragmentSource, mPackShader, mPackProgram, errorMessageSize, errorMessage))
+		return false;
+
+	// Packed textures hold one v210 word per texel, texels must be fetched without filtering
+	glGenTextures(1, &mPackedInputTexture);
+	glBindTexture(GL_TEXTURE_2D, mPackedInputTexture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB10_A2, mPackedWidth, mHeight, 0, GL_RGBA, GL_UNSIGNED_INT_2_10_10_10_REV, NULL);
+
+	glGenTextures(1, &mPackedOutputTexture);
+	glBindTexture(GL_TEXTURE_2D, mPackedOutputTexture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB10_A2, mPackedWidth, mHeight, 0, GL_RGBA, GL_UNSIGNED_INT_2_10_10_10_REV, NULL);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	glGenFramebuffersEXT(1, &mUnpackFrameBuf);
+	glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, mUnpackFrameBuf);
+	glFramebufferTexture2DEXT(GL_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT, GL_TEXTURE_2D, unpackTarget, 0);
+	if (glCheckFramebufferStatusEXT(GL_FRAMEBUFFER_EXT) != GL_FRAMEBUFFER_COMPLETE_EXT)
+	{
+		snprintf(errorMessage, errorMessageSize, "Cannot initialize v210 unpack framebuffer.");
+		return false;
+	}
+
+	glGenFramebuffersEXT(1, &mPackFrameBuf);
+	glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, mPackFrameBuf);
+	glFramebufferTexture2DEXT(GL_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT, GL_TEXTURE_2D, mPackedOutputTexture, 0);
+	if (glCheckFramebufferStatusEXT(GL_FRAMEBUFFER_EXT) != GL_FRAMEBUFFER_COMPLETE_EXT)
+	{
+		snprintf(errorMessage, errorMessageSize, "Cannot initialize v210 pack framebuffer.");
+		return false;
+	}
+
+	glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, 0);
+
+	return true;
+}
+
+void V210Converter::cleanup()
+{
+	if (mUnpackFrameBuf != 0)
+	{
+		glDeleteFramebuffersEXT(1, &mUnpackFrameBuf);
+		mUnpackFrameBuf = 0;
+	}
+
+	if (mPackFrameBuf != 0)
+	{
+		glDeleteFramebuffersEXT(1, &mPackFrameBuf);
+		mPackFrameBuf = 0;
+	}
+
+	if (mPackedInputTexture != 0)
+	{
+		glDeleteTextures(1, &mPackedInputTexture);
+		mPackedInputTexture = 0;
+	}
+
+	if (mPackedOutputTexture != 0)
+	{
+		glDeleteTextures(1, &mPackedOutputTexture);
+		mPackedOutputTexture = 0;
+	}
+
+	if (mUnpackProgram != 0)
+	{
+		glDeleteProgram(mUnpackProgram);
+		glDeleteShader(mUnpackShader);
+		mUnpackProgram = mUnpackShader = 0;
+	}
+
+	if (mPackProgram != 0)
+	{
+		glDeleteProgram(mPackProgram);
+		glDeleteShader(mPackShader);
+		mPackProgram = mPackShader = 0;
+	}
+}
+
+void V210Converter::unpack()
+{
+	drawFullFrame(mUnpackFrameBuf, mUnpackProgram, mPackedInputTexture, mWidth, mHeight);
+}
+
+void V210Converter::pack(GLuint sourceTexture)
+{
+	drawFullFrame(mPackFrameBuf, mPackProgram, sourceTexture, mPackedWidth, mHeight);
+}
+
+// Draw a quad covering the frame buffer so the fragment shader runs once for each texel of the target
+void V210Converter::drawFullFrame(GLuint frameBuffer, GLuint program, GLuint texture, unsigned width, unsigned height)
+{
+	glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, frameBuffer);
+	glViewport(0, 0, width, height);
+
+	glPushAttrib(GL_ENABLE_BIT);
+	glDisable(GL_DEPTH_TEST);
+	glDisable(GL_BLEND);
+
+	glMatrixMode(GL_PROJECTION);
+	glLoadIdentity();
+	glMatrixMode(GL_MODELVIEW);
+	glLoadIdentity();
+
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glUseProgram(program);
+	glUniform1i(glGetUniformLocation(program, program == mUnpackProgram ? "packedTex" : "rgbTex"), 0);
+	glUniform1i(glGetUniformLocation(program, "frameWidth"), mWidth);
+
+	glBegin(GL_QUADS);
+	glVertex2f(-1.0f, -1.0f);
+	glVertex2f( 1.0f, -1.0f);
+	glVertex2f( 1.0f,  1.0f);
+	glVertex2f(-1.0f,  1.0f);
+	glEnd();
+
+	glUseProgram(0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glPopAttrib();
+}
+
+bool V210Converter::compileProgram(const char* source, GLuint& shader, GLuint& program, int errorMessageSize, char* errorMessage)
+{
+	GLsizei		errorBufferSize;
+	GLint		compileResult, linkResult;
+
+	shader = glCreateShader(GL_FRAGMENT_SHADER);
+
+	glShaderSource(shader, 1, (const GLchar**)&source, NULL);
+	glCompileShader(shader);
+
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &compileResult);
+	if (compileResult == GL_FALSE)
+	{
+		glGetShaderInfoLog(shader, errorMessageSize, &errorBufferSize, errorMessage);
+		return false;
+	}
+
+	program = glCreateProgram();
+
+	glAttachShader(program, shader);
+	glLinkProgram(program);
+
+	glGetProgramiv(program, GL_LINK_STATUS, &linkResult);
+	if (linkResult == GL_FALSE)
+	{
+		glGetProgramInfoLog(program, errorMessageSize, &errorBufferSize, errorMessage);
+		return false;
+	}
+
+	return true;
+}
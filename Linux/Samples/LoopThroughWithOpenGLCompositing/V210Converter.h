@@ -0,0 +1,101 @@
+/* -LICENSE-START-
+ ** Copyright (c) 2022 Blackmagic Design
+ **  
+ ** Permission is hereby granted, free of charge, to any person or organization 
+ ** obtaining a copy of the software and accompanying documentation (the 
+ ** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+ ** and transmit the Software, and to prepare derivative works of the Software, 
+ ** and to permit third-parties to whom the Software is furnished to do so, in 
+ ** accordance with:
+ ** 
+ ** (1) if the Software is obtained from Blackmagic Design, the End User License 
+ ** Agreement for the Software Development Kit (“EULA”) available at 
+ ** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+ ** 
+ ** (2) if the Software is obtained from any third party, such licensing terms 
+ ** as notified by that third party,
+ ** 
+ ** and all subject to the following:
+ ** 
+ ** (3) the copyright notices in the Software and this entire statement, 
+ ** including the above license grant, this restriction and the following 
+ ** disclaimer, must be included in all copies of the Software, in whole or in 
+ ** part, and all derivative works of the Software, unless such copies or 
+ ** derivative works are solely in the form of machine-executable object code 
+ ** generated by a source language processor.
+ ** 
+ ** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ ** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ ** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+ ** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+ ** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+ ** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ ** DEALINGS IN THE SOFTWARE.
+ ** 
+ ** A copy of the Software is available free of charge at 
+ ** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+ ** 
+ ** -LICENSE-END-
+ */
+
+//
+// V210Converter.h
+// LoopThroughWithOpenGLCompositing
+//
+
+#ifndef __V210_CONVERTER_H__
+#define __V210_CONVERTER_H__
+
+#include <GL/gl.h>
+
+// Converts between 10-bit YCbCr 4:2:2 in v210 format and RGB textures in the GPU.
+//
+// v210 packs 6 pixels into four 32-bit words, each holding three 10-bit components.  A row of v210 is
+// uploaded as a texture with one RGB10_A2 texel per word, so each texel's red, green and blue channels
+// are the three components of the word.  unpack() renders that texture into an RGB texture of the video
+// frame size, pack() renders an RGB texture back into v210 words which can be read directly with
+// glReadPixels(GL_RGBA, GL_UNSIGNED_INT_2_10_10_10_REV) into a v210 video frame.
+class V210Converter
+{
+public:
+	V210Converter();
+	~V210Converter();
+
+	// Bytes per row of a v210 frame, rows are padded to a multiple of 48 pixels (128 bytes)
+	static unsigned getRowBytes(unsigned width) { return ((width + 47) / 48) * 128; }
+
+	// The OpenGL context must be current.  unpackTarget is the RGB texture unpack() renders to, it should be
+	// created with GL_RGB10_A2 or a floating point internal format to keep 10-bit precision.
+	bool initialize(unsigned width, unsigned height, GLuint unpackTarget, int errorMessageSize, char* errorMessage);
+	void cleanup();
+
+	// Texture to upload each captured v210 frame to, getRowBytes(width)/4 texels wide with format GL_RGBA
+	// and type GL_UNSIGNED_INT_2_10_10_10_REV
+	GLuint getPackedInputTexture() const { return mPackedInputTexture; }
+	unsigned getPackedWidth() const { return mPackedWidth; }
+
+	// Convert the packed input texture to RGB in the unpack target texture
+	void unpack();
+
+	// Convert the RGB source texture to v210, flipping it vertically so the first row read back is the top of
+	// the frame.  The packed frame buffer is left bound for readback of getPackedWidth() x height texels.
+	void pack(GLuint sourceTexture);
+
+private:
+	unsigned		mWidth;
+	unsigned		mHeight;
+	unsigned		mPackedWidth;
+	GLuint			mPackedInputTexture;
+	GLuint			mPackedOutputTexture;
+	GLuint			mUnpackFrameBuf;
+	GLuint			mPackFrameBuf;
+	GLuint			mUnpackProgram;
+	GLuint			mUnpackShader;
+	GLuint			mPackProgram;
+	GLuint			mPackShader;
+
+	bool compileProgram(const char* source, GLuint& shader, GLuint& program, int errorMessageSize, char* errorMessage);
+	void drawFullFrame(GLuint frameBuffer, GLuint program, GLuint texture, unsigned width, unsigned height);
+};
+
+#endif	// __V210_CONVERTER_H__
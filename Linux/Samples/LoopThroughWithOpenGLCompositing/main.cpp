@@ -43,13 +43,64 @@
 //
 
 #include <QApplication>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include "LoopThroughWithOpenGLCompositing.h"
+#include "CompositeBenchmark.h"
+
+static void	PrintUsage(const char* name)
+{
+	printf("%s [options]\n"
+		   "\n"
+		   "Options:\n"
+		   "    -h, --help                Display this help message\n"
+		   "    -v, --v210                Capture, composite and play out 10-bit YUV video\n"
+		   "    -b, --benchmark <frames>  Upload, composite and read back <frames> synthetic frames as fast as possible\n"
+		   "                              in a headless EGL context, without a DeckLink device or display\n"
+		   "    -s, --size <w>x<h>        Frame size for benchmark mode (default 1920x1080)\n", name);
+}
 
 int main(int argc, char *argv[])
 {
+	unsigned	benchmarkFrames = 0;
+	unsigned	benchmarkWidth = 1920;
+	unsigned	benchmarkHeight = 1080;
+	bool		v210 = false;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if ((strcmp(argv[i], "--benchmark") == 0 || strcmp(argv[i], "-b") == 0) && (i + 1 < argc))
+			benchmarkFrames = (unsigned)strtoul(argv[++i], NULL, 10);
+		else if ((strcmp(argv[i], "--size") == 0 || strcmp(argv[i], "-s") == 0) && (i + 1 < argc))
+		{
+			if (sscanf(argv[++i], "%ux%u", &benchmarkWidth, &benchmarkHeight) != 2)
+			{
+				fprintf(stderr, "Invalid frame size: %s\n", argv[i]);
+				return 1;
+			}
+		}
+		else if (strcmp(argv[i], "--v210") == 0 || strcmp(argv[i], "-v") == 0)
+			v210 = true;
+		else if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0)
+		{
+			PrintUsage(argv[0]);
+			return 0;
+		}
+		else
+		{
+			fprintf(stderr, "Unknown argument: %s\n", argv[i]);
+			PrintUsage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (benchmarkFrames > 0)
+		return RunCompositeBenchmark(benchmarkWidth, benchmarkHeight, benchmarkFrames, v210) ? 0 : 1;
+
 	QApplication app(argc, argv);
 
-	LoopThroughWithOpenGLCompositing loopThrough;
+	LoopThroughWithOpenGLCompositing loopThrough(v210 ? bmdFormat10BitYUV : bmdFormat8BitYUV);
 	loopThrough.start();
 
 	return app.exec();
@@ -0,0 +1,467 @@
+/* -LICENSE-START-
+** Copyright (c) 2022 Blackmagic Design
+**  
+** Permission is hereby granted, free of charge, to any person or organization 
+** obtaining a copy of the software and accompanying documentation (the 
+** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+** and transmit the Software, and to prepare derivative works of the Software, 
+** and to permit third-parties to whom the Software is furnished to do so, in 
+** accordance with:
+** 
+** (1) if the Software is obtained from Blackmagic Design, the End User License 
+** Agreement for the Software Development Kit (“EULA”) available at 
+** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+** 
+** (2) if the Software is obtained from any third party, such licensing terms 
+** as notified by that third party,
+** 
+** and all subject to the following:
+** 
+** (3) the copyright notices in the Software and this entire statement, 
+** including the above license grant, this restriction and the following 
+** disclaimer, must be included in all copies of the Software, in whole or in 
+** part, and all derivative works of the Software, unless such copies or 
+** derivative works are solely in the form of machine-executable object code 
+** generated by a source language processor.
+** 
+** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+** DEALINGS IN THE SOFTWARE.
+** 
+** A copy of the Software is available free of charge at 
+** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+** 
+** -LICENSE-END-
+*/
+
+//*************************************************************************************/
+// Note to developers:
+//
+// The Multiviewer sample captures 4, 9 or 16 DeckLink inputs and tiles them into a single
+// output frame, with a label, a tally border and audio meters drawn over each tile.
+//
+// Performance considerations:
+// * Each input is downscaled into its tile by MultiviewerRenderer, which splits the tiles
+//     into bands of rows on a pool of kRendererThreadCount threads.  1080p inputs into a
+//     2160p output are exactly 2:1 and use AVX2 or NEON box filtering, other input sizes
+//     use bilinear scaling.  Run with --benchmark to measure the renderer without devices
+// * Output frames are rendered by MultiviewerOutput's thread as soon as a scheduled frame
+//     completes, so the output runs at its own cadence, kOutputVideoPreroll frames ahead
+//
+// Additional considerations:
+// * Inputs do not need to be locked to the output or to each other.  Each input keeps only
+//     its latest frame, and every output frame uses the latest frame of every input, so
+//     inputs on a slower clock repeat frames and inputs on a faster clock skip frames.
+//     The counts of repeated and skipped frames are printed with the output statistics
+// * Inputs follow format detection and are always captured as 8-bit YUV
+// * Type "p <n>" or "v <n>" then <RETURN> to set tile n as program or preview, "c" to
+//     clear tally, or an empty line to exit
+//*************************************************************************************/
+
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdio.h>
+#include <string.h>
+
+#include "MultiviewerBenchmark.h"
+#include "MultiviewerInput.h"
+#include "MultiviewerOutput.h"
+#include "MultiviewerRenderer.h"
+#include "DeckLinkAPI.h"
+#include "com_ptr.h"
+#include "platform.h"
+
+const BMDDisplayMode		kOutputDisplayMode			= bmdMode4K2160p5994;
+const BMDDisplayMode		kInitialInputDisplayMode	= bmdModeHD1080p5994;
+const unsigned				kDefaultTileCount			= 16;
+const unsigned				kOutputVideoPreroll			= 3;		// number of output preroll frames
+const unsigned				kRendererThreadCount		= 0;		// Number of threads used to render each frame, 0 for one per CPU
+const long					kStatisticsUpdateRateMs		= 2000;		// Print output and frame sync statistics every 2 seconds
+
+// Frame sync state for each tile, only accessed by the output render thread
+struct TileFrameSync
+{
+	uint64_t	lastSequence;
+	uint64_t	repeatedFrames;
+	uint64_t	skippedFrames;
+};
+
+std::mutex						g_tallyMutex;
+std::vector<TallyState>			g_tallyStates;
+
+std::mutex						g_statisticsMutex;
+std::vector<TileFrameSync>		g_tileFrameSync;
+double							g_totalRenderTimeMs = 0.0;
+uint64_t						g_renderedFrameCount = 0;
+
+std::string getDeckLinkDisplayName(com_ptr<IDeckLink> deckLink)
+{
+	dlstring_t		displayName;
+	std::string		displayNameString;
+
+	if (deckLink->GetDisplayName(&displayName) == S_OK)
+	{
+		displayNameString = DlToStdString(displayName);
+		DeleteString(displayName);
+	}
+	else
+	{
+		displayNameString = "Unknown";
+	}
+
+	return displayNameString;
+}
+
+bool supportsOutputDisplayMode(com_ptr<IDeckLink>& deckLink)
+{
+	com_ptr<IDeckLinkOutput>	deckLinkOutput(IID_IDeckLinkOutput, deckLink);
+	bool						supported = false;
+
+	return deckLinkOutput &&
+		(deckLinkOutput->DoesSupportVideoMode(bmdVideoConnectionUnspecified, kOutputDisplayMode, bmdFormat8BitYUV,
+											  bmdNoVideoOutputConversion, bmdSupportedVideoModeDefault, nullptr, &supported) == S_OK) &&
+		supported;
+}
+
+void renderMultiviewerFrame(MultiviewerRenderer& renderer, std::vector<com_ptr<MultiviewerInput>>& inputs,
+							std::vector<MultiviewerTileSource>& sources, IDeckLinkMutableVideoFrame* outputFrame)
+{
+	std::vector<com_ptr<IDeckLinkVideoInputFrame>>	inputFrames(sources.size());
+	void*											outputBytes;
+
+	auto startTime = std::chrono::steady_clock::now();
+
+	if (outputFrame->GetBytes(&outputBytes) != S_OK)
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(g_tallyMutex);
+		for (unsigned tile = 0; tile < sources.size(); tile++)
+			sources[tile].tally = g_tallyStates[tile];
+	}
+
+	std::unique_lock<std::mutex> statisticsLock(g_statisticsMutex);
+
+	for (unsigned tile = 0; tile < inputs.size(); tile++)
+	{
+		MultiviewerTileSource&	source = sources[tile];
+		TileFrameSync&			frameSync = g_tileFrameSync[tile];
+		uint64_t				sequence;
+		void*					inputBytes = nullptr;
+
+		// Frame sync: repeat the latest frame when no new frame has arrived, skip any frames that arrived since the last output frame
+		source.hasSignal = inputs[tile]->getLatestFrame(inputFrames[tile], sequence) &&
+						   (inputFrames[tile]->GetPixelFormat() == bmdFormat8BitYUV) &&
+						   (inputFrames[tile]->GetBytes(&inputBytes) == S_OK);
+
+		if (sequence == frameSync.lastSequence)
+			frameSync.repeatedFrames++;
+		else if ((frameSync.lastSequence != 0) && (sequence > frameSync.lastSequence + 1))
+			frameSync.skippedFrames += sequence - frameSync.lastSequence - 1;
+		frameSync.lastSequence = sequence;
+
+		source.pixels = source.hasSignal ? (const uint8_t*)inputBytes : nullptr;
+		if (source.hasSignal)
+		{
+			source.rowBytes	= (uint32_t)inputFrames[tile]->GetRowBytes();
+			source.width	= (uint32_t)inputFrames[tile]->GetWidth();
+			source.height	= (uint32_t)inputFrames[tile]->GetHeight();
+		}
+
+		source.label = inputs[tile]->getLabel();
+		inputs[tile]->takeAudioPeakLevels(source.audioPeakLevels);
+	}
+
+	statisticsLock.unlock();
+
+	renderer.render((uint8_t*)outputBytes, (uint32_t)outputFrame->GetRowBytes(), (uint32_t)outputFrame->GetWidth(), (uint32_t)outputFrame->GetHeight(), sources);
+
+	std::chrono::duration<double, std::milli> renderTime = std::chrono::steady_clock::now() - startTime;
+
+	statisticsLock.lock();
+	g_totalRenderTimeMs += renderTime.count();
+	g_renderedFrameCount++;
+}
+
+void printStatistics(com_ptr<MultiviewerOutput>& output, unsigned inputCount)
+{
+	MultiviewerOutput::Statistics	outputStatistics;
+	std::string						frameSyncText;
+	double							averageRenderTimeMs;
+
+	output->getStatistics(outputStatistics);
+
+	{
+		std::lock_guard<std::mutex> lock(g_statisticsMutex);
+
+		averageRenderTimeMs = (g_renderedFrameCount > 0) ? g_totalRenderTimeMs / g_renderedFrameCount : 0.0;
+		g_totalRenderTimeMs = 0.0;
+		g_renderedFrameCount = 0;
+
+		for (unsigned tile = 0; tile < inputCount; tile++)
+		{
+			frameSyncText += "  " + std::to_string(tile + 1) + ": " + std::to_string(g_tileFrameSync[tile].repeatedFrames) +
+							 "/" + std::to_string(g_tileFrameSync[tile].skippedFrames);
+		}
+	}
+
+	printf("%llu frames output (%llu late, %llu dropped); Average render = %.2f ms; Repeated/skipped input frames:%s\n",
+			(unsigned long long)outputStatistics.framesScheduled, (unsigned long long)outputStatistics.framesDisplayedLate,
+			(unsigned long long)outputStatistics.framesDropped, averageRenderTimeMs, frameSyncText.c_str());
+}
+
+bool handleTallyCommand(const std::string& command, unsigned tileCount)
+{
+	char		action;
+	unsigned	tile = 0;
+
+	if ((sscanf(command.c_str(), " %c %u", &action, &tile) < 1) ||
+		((action != 'c') && ((tile < 1) || (tile > tileCount))))
+		return false;
+
+	std::lock_guard<std::mutex> lock(g_tallyMutex);
+
+	// Only one tile is on program and one on preview at a time
+	for (auto& tally : g_tallyStates)
+	{
+		if ((action == 'c') || ((action == 'p') && (tally == TallyState::Program)) || ((action == 'v') && (tally == TallyState::Preview)))
+			tally = TallyState::None;
+	}
+
+	if (action == 'p')
+		g_tallyStates[tile - 1] = TallyState::Program;
+	else if (action == 'v')
+		g_tallyStates[tile - 1] = TallyState::Preview;
+	else if (action != 'c')
+		return false;
+
+	return true;
+}
+
+HRESULT Multiviewer(unsigned tileCount)
+{
+	HRESULT								result;
+
+	com_ptr<IDeckLinkIterator>			deckLinkIterator;
+	com_ptr<IDeckLink>					deckLink;
+	std::vector<com_ptr<IDeckLink>>		deckLinks;
+	com_ptr<MultiviewerOutput>			output;
+	com_ptr<IDeckLink>					outputDeckLink;
+	std::vector<com_ptr<MultiviewerInput>>	inputs;
+
+	MultiviewerRenderer					renderer(tileCount, kRendererThreadCount);
+	std::vector<MultiviewerTileSource>	sources(tileCount);
+
+	std::mutex							sessionMutex;
+	std::condition_variable				sessionCondition;
+	bool								sessionComplete = false;
+
+	result = GetDeckLinkIterator(deckLinkIterator.releaseAndGetAddressOf());
+	if (result != S_OK)
+		return result;
+
+	while (deckLinkIterator->Next(deckLink.releaseAndGetAddressOf()) == S_OK)
+	{
+		com_ptr<IDeckLinkProfileAttributes>	deckLinkAttributes(IID_IDeckLinkProfileAttributes, deckLink);
+		int64_t								duplexMode;
+
+		// Only use devices in an active state
+		if (deckLinkAttributes &&
+			(deckLinkAttributes->GetInt(BMDDeckLinkDuplex, &duplexMode) == S_OK) &&
+			((BMDDuplexMode)duplexMode != bmdDuplexInactive))
+		{
+			deckLinks.push_back(deckLink);
+		}
+	}
+
+	// Use the first device that can play the output display mode as the output, and the remaining devices as inputs
+	for (auto& device : deckLinks)
+	{
+		if (supportsOutputDisplayMode(device))
+		{
+			try
+			{
+				output = make_com_ptr<MultiviewerOutput>(device, kOutputVideoPreroll);
+			}
+			catch (const std::exception& e)
+			{
+				fprintf(stderr, "%s\n", e.what());
+				continue;
+			}
+			outputDeckLink = device;
+			printf("Using output device: %s\n", getDeckLinkDisplayName(device).c_str());
+			break;
+		}
+	}
+
+	if (!output)
+	{
+		fprintf(stderr, "Unable to find an output device that supports the output display mode\n");
+		return E_FAIL;
+	}
+
+	for (auto& device : deckLinks)
+	{
+		com_ptr<IDeckLinkProfileAttributes>	deckLinkAttributes(IID_IDeckLinkProfileAttributes, device);
+		int64_t								duplexMode;
+		int64_t								videoIOSupport;
+		bool								supportsInputFormatDetection;
+
+		if (inputs.size() == tileCount)
+			break;
+
+		// A half duplex output device cannot also capture
+		if ((device == outputDeckLink) &&
+			((deckLinkAttributes->GetInt(BMDDeckLinkDuplex, &duplexMode) != S_OK) || ((BMDDuplexMode)duplexMode != bmdDuplexFull)))
+			continue;
+
+		// For scope of sample, only use input devices that support input format detection
+		if ((deckLinkAttributes->GetInt(BMDDeckLinkVideoIOSupport, &videoIOSupport) != S_OK) ||
+			(((BMDVideoIOSupport)videoIOSupport & bmdDeviceSupportsCapture) == 0) ||
+			(deckLinkAttributes->GetFlag(BMDDeckLinkSupportsInputFormatDetection, &supportsInputFormatDetection) != S_OK) ||
+			!supportsInputFormatDetection)
+			continue;
+
+		try
+		{
+			inputs.push_back(make_com_ptr<MultiviewerInput>(device, getDeckLinkDisplayName(device)));
+		}
+		catch (const std::exception& e)
+		{
+			fprintf(stderr, "%s\n", e.what());
+			continue;
+		}
+		printf("Using input device %u: %s\n", (unsigned)inputs.size(), getDeckLinkDisplayName(device).c_str());
+	}
+
+	if (inputs.empty())
+	{
+		fprintf(stderr, "Unable to find an input device\n");
+		return E_FAIL;
+	}
+
+	// Tiles without an input are drawn with no signal
+	for (unsigned tile = 0; tile < tileCount; tile++)
+	{
+		sources[tile].pixels			= nullptr;
+		sources[tile].hasSignal			= false;
+		sources[tile].label				= "Input " + std::to_string(tile + 1);
+		sources[tile].tally				= TallyState::None;
+		sources[tile].audioChannelCount	= (tile < inputs.size()) ? MultiviewerInput::kAudioChannelCount : 0;
+	}
+
+	g_tallyStates.assign(tileCount, TallyState::None);
+	g_tileFrameSync.assign(inputs.size(), TileFrameSync{ 0, 0, 0 });
+
+	for (unsigned i = 0; i < inputs.size(); i++)
+	{
+		if (!inputs[i]->startCapture(kInitialInputDisplayMode))
+		{
+			fprintf(stderr, "Unable to enable input %u\n", i + 1);
+			return E_ACCESSDENIED;
+		}
+	}
+
+	if (!output->startPlayback(kOutputDisplayMode, [&](IDeckLinkMutableVideoFrame* outputFrame) { renderMultiviewerFrame(renderer, inputs, sources, outputFrame); }))
+	{
+		fprintf(stderr, "Unable to enable output\n");
+		for (auto& input : inputs)
+			input->stopCapture();
+		return E_ACCESSDENIED;
+	}
+
+	printf("Rendering %u tiles with %u threads using %s scaling\n", tileCount, renderer.getThreadCount(), renderer.getScalerKernelName());
+	printf("Type \"p <n>\" or \"v <n>\" to set tile n as program or preview, \"c\" to clear tally, press <RETURN> to stop/exit\n");
+
+	std::thread statisticsThread([&]
+	{
+		std::unique_lock<std::mutex> lock(sessionMutex);
+		while (!sessionCondition.wait_for(lock, std::chrono::milliseconds(kStatisticsUpdateRateMs), [&] { return sessionComplete; }))
+			printStatistics(output, (unsigned)inputs.size());
+	});
+
+	std::string command;
+	while (std::getline(std::cin, command) && !command.empty())
+	{
+		if (!handleTallyCommand(command, tileCount))
+			fprintf(stderr, "Unknown command: %s\n", command.c_str());
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(sessionMutex);
+		sessionComplete = true;
+	}
+	sessionCondition.notify_all();
+	statisticsThread.join();
+
+	output->stopPlayback();
+	for (auto& input : inputs)
+		input->stopCapture();
+
+	printStatistics(output, (unsigned)inputs.size());
+	printf("\nMultiviewer complete\n\n");
+
+	return S_OK;
+}
+
+void printUsage(const char* name)
+{
+	printf("%s [options]\n"
+		   "\n"
+		   "Options:\n"
+		   "    -h, --help                Display this help message\n"
+		   "    -n, --tiles <count>       Number of tiles, 4, 9 or 16 (default 16)\n"
+		   "    -b, --benchmark <frames>  Render <frames> multiviewer frames from synthetic sources and print the\n"
+		   "                              frame rate, without DeckLink devices\n"
+		   "    -t, --threads <count>     Renderer threads for benchmark mode (default one per CPU)\n", name);
+}
+
+int main(int argc, const char * argv[])
+{
+	unsigned	tileCount = kDefaultTileCount;
+	unsigned	benchmarkFrames = 0;
+	unsigned	benchmarkThreads = 0;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if ((strcmp(argv[i], "--tiles") == 0 || strcmp(argv[i], "-n") == 0) && (i + 1 < argc))
+			tileCount = (unsigned)strtoul(argv[++i], nullptr, 10);
+		else if ((strcmp(argv[i], "--benchmark") == 0 || strcmp(argv[i], "-b") == 0) && (i + 1 < argc))
+			benchmarkFrames = (unsigned)strtoul(argv[++i], nullptr, 10);
+		else if ((strcmp(argv[i], "--threads") == 0 || strcmp(argv[i], "-t") == 0) && (i + 1 < argc))
+			benchmarkThreads = (unsigned)strtoul(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0)
+		{
+			printUsage(argv[0]);
+			return EXIT_SUCCESS;
+		}
+		else
+		{
+			fprintf(stderr, "Unknown argument: %s\n", argv[i]);
+			printUsage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (!MultiviewerRenderer::isTileCountSupported(tileCount))
+	{
+		fprintf(stderr, "Unsupported number of tiles %u, use 4, 9 or 16\n", tileCount);
+		return EXIT_FAILURE;
+	}
+
+	if (benchmarkFrames > 0)
+		return RunMultiviewerBenchmark(tileCount, benchmarkFrames, benchmarkThreads) ? EXIT_SUCCESS : EXIT_FAILURE;
+
+	return (Multiviewer(tileCount) == S_OK) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
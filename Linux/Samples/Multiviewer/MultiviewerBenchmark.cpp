@@ -0,0 +1,148 @@
+/* -LICENSE-START-
+** Copyright (c) 2022 Blackmagic Design
+**  
+** Permission is hereby granted, free of charge, to any person or organization 
+** obtaining a copy of the software and accompanying documentation (the 
+** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+** and transmit the Software, and to prepare derivative works of the Software, 
+** and to permit third-parties to whom the Software is furnished to do so, in 
+** accordance with:
+** 
+** (1) if the Software is obtained from Blackmagic Design, the End User License 
+** Agreement for the Software Development Kit (“EULA”) available at 
+** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+** 
+** (2) if the Software is obtained from any third party, such licensing terms 
+** as notified by that third party,
+** 
+** and all subject to the following:
+** 
+** (3) the copyright notices in the Software and this entire statement, 
+** including the above license grant, this restriction and the following 
+** disclaimer, must be included in all copies of the Software, in whole or in 
+** part, and all derivative works of the Software, unless such copies or 
+** derivative works are solely in the form of machine-executable object code 
+** generated by a source language processor.
+** 
+** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+** DEALINGS IN THE SOFTWARE.
+** 
+** A copy of the Software is available free of charge at 
+** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+** 
+** -LICENSE-END-
+*/
+
+#include <chrono>
+#include <cmath>
+#include <stdio.h>
+#include <vector>
+
+#include "MultiviewerBenchmark.h"
+#include "MultiviewerRenderer.h"
+
+static const uint32_t	kOutputWidth		= 3840;
+static const uint32_t	kOutputHeight		= 2160;
+static const double		kTargetFrameRate	= 60000.0 / 1001.0;
+
+// 75% colour bars as Y Cb Cr, white to black
+static const uint8_t	kColourBars[8][3] =
+{
+	{ 180, 128, 128 }, { 168, 44, 136 }, { 145, 147, 44 }, { 133, 63, 52 },
+	{ 63, 193, 204 }, { 51, 109, 212 }, { 28, 212, 120 }, { 16, 128, 128 },
+};
+
+// Colour bars with a bar offset for each source, so that the tiles can be told apart
+static void fillSourceFrame(std::vector<uint8_t>& pixels, uint32_t width, uint32_t height, unsigned sourceIndex)
+{
+	pixels.resize((size_t)width * 2 * height);
+
+	for (uint32_t y = 0; y < height; y++)
+	{
+		uint8_t* row = &pixels[(size_t)y * width * 2];
+		for (uint32_t x = 0; x < width; x += 2, row += 4)
+		{
+			const uint8_t* colour = kColourBars[(x * 8 / width + sourceIndex) % 8];
+			row[0] = colour[1];
+			row[1] = colour[0];
+			row[2] = colour[2];
+			row[3] = colour[0];
+		}
+	}
+}
+
+static double measureFrameRate(MultiviewerRenderer& renderer, std::vector<MultiviewerTileSource>& sources, std::vector<uint8_t>& frame, unsigned frameCount)
+{
+	auto startTime = std::chrono::steady_clock::now();
+
+	for (unsigned i = 0; i < frameCount; i++)
+	{
+		// Audio levels vary from frame to frame so that the meters are redrawn at different heights
+		for (unsigned tile = 0; tile < sources.size(); tile++)
+		{
+			for (unsigned channel = 0; channel < sources[tile].audioChannelCount; channel++)
+				sources[tile].audioPeakLevels[channel] = (float)(0.5 + 0.5 * sin((i + tile * 7 + channel * 3) * 0.1));
+		}
+
+		renderer.render(frame.data(), kOutputWidth * 2, kOutputWidth, kOutputHeight, sources);
+	}
+
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+	return frameCount / elapsed.count();
+}
+
+bool RunMultiviewerBenchmark(unsigned tileCount, unsigned frameCount, unsigned threadCount)
+{
+	const uint32_t	sourceSizes[][2] = { { 1920, 1080 }, { 1280, 720 } };
+	const char*		sourceNames[] = { "1080p", "720p" };
+
+	if (!MultiviewerRenderer::isTileCountSupported(tileCount))
+	{
+		fprintf(stderr, "Unsupported number of tiles %u, use 4, 9 or 16\n", tileCount);
+		return false;
+	}
+
+	MultiviewerRenderer					singleThreadRenderer(tileCount, 1);
+	MultiviewerRenderer					renderer(tileCount, threadCount);
+	std::vector<uint8_t>				frame((size_t)kOutputWidth * 2 * kOutputHeight);
+	std::vector<std::vector<uint8_t>>	sourcePixels(tileCount);
+	std::vector<MultiviewerTileSource>	sources(tileCount);
+
+	printf("Rendering %u %ux%u multiviewer frames of %u tiles with labels, tally and audio meters using %s scaling\n",
+			frameCount, kOutputWidth, kOutputHeight, tileCount, renderer.getScalerKernelName());
+
+	for (size_t i = 0; i < sizeof(sourceSizes) / sizeof(sourceSizes[0]); i++)
+	{
+		uint32_t sourceWidth = sourceSizes[i][0];
+		uint32_t sourceHeight = sourceSizes[i][1];
+
+		for (unsigned tile = 0; tile < tileCount; tile++)
+		{
+			fillSourceFrame(sourcePixels[tile], sourceWidth, sourceHeight, tile);
+
+			sources[tile].pixels			= sourcePixels[tile].data();
+			sources[tile].rowBytes			= sourceWidth * 2;
+			sources[tile].width				= sourceWidth;
+			sources[tile].height			= sourceHeight;
+			sources[tile].hasSignal			= true;
+			sources[tile].label				= "Input " + std::to_string(tile + 1) + " " + sourceNames[i];
+			sources[tile].tally				= (tile == 0) ? TallyState::Program : (tile == 1) ? TallyState::Preview : TallyState::None;
+			sources[tile].audioChannelCount	= 2;
+		}
+
+		double singleThreadFrameRate = measureFrameRate(singleThreadRenderer, sources, frame, frameCount);
+		double frameRate = measureFrameRate(renderer, sources, frame, frameCount);
+
+		printf("  %-6s sources  1 thread: %7.1f frames/s (%6.2f ms/frame)  %2u threads: %7.1f frames/s (%6.2f ms/frame)  %s\n",
+				sourceNames[i], singleThreadFrameRate, 1000.0 / singleThreadFrameRate,
+				renderer.getThreadCount(), frameRate, 1000.0 / frameRate,
+				(frameRate >= kTargetFrameRate) ? "real-time at 59.94 fps" : "below 59.94 fps");
+	}
+
+	return true;
+}
@@ -0,0 +1,239 @@
+/* -LICENSE-START-
+** Copyright (c) 2022 Blackmagic Design
+**  
+** Permission is hereby granted, free of charge, to any person or organization 
+** obtaining a copy of the software and accompanying documentation (the 
+** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+** and transmit the Software, and to prepare derivative works of the Software, 
+** and to permit third-parties to whom the Software is furnished to do so, in 
+** accordance with:
+** 
+** (1) if the Software is obtained from Blackmagic Design, the End User License 
+** Agreement for the Software Development Kit (“EULA”) available at 
+** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+** 
+** (2) if the Software is obtained from any third party, such licensing terms 
+** as notified by that third party,
+** 
+** and all subject to the following:
+** 
+** (3) the copyright notices in the Software and this entire statement, 
+** including the above license grant, this restriction and the following 
+** disclaimer, must be included in all copies of the Software, in whole or in 
+** part, and all derivative works of the Software, unless such copies or 
+** derivative works are solely in the form of machine-executable object code 
+** generated by a source language processor.
+** 
+** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+** DEALINGS IN THE SOFTWARE.
+** 
+** A copy of the Software is available free of charge at 
+** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+** 
+** -LICENSE-END-
+*/
+
+#include <stdexcept>
+#include <stdlib.h>
+
+#include "platform.h"
+#include "MultiviewerInput.h"
+
+MultiviewerInput::MultiviewerInput(com_ptr<IDeckLink>& deckLink, const std::string& deviceName) :
+	m_refCount(1),
+	m_deckLinkInput(IID_IDeckLinkInput, deckLink),
+	m_deviceName(deviceName),
+	m_frameSequence(0)
+{
+	if (!m_deckLinkInput)
+		throw std::runtime_error("DeckLink device does not have an input interface");
+
+	for (auto& peak : m_audioPeaks)
+		peak = 0;
+}
+
+// IUnknown methods
+
+HRESULT	MultiviewerInput::QueryInterface(REFIID iid, LPVOID *ppv)
+{
+	HRESULT result = S_OK;
+
+	if (ppv == nullptr)
+		return E_INVALIDARG;
+
+	if (iid == IID_IUnknown)
+	{
+		*ppv = this;
+		AddRef();
+	}
+	else if (iid == IID_IDeckLinkInputCallback)
+	{
+		*ppv = (IDeckLinkInputCallback*)this;
+		AddRef();
+	}
+	else
+	{
+		*ppv = nullptr;
+		result = E_NOINTERFACE;
+	}
+
+	return result;
+}
+
+ULONG MultiviewerInput::AddRef(void)
+{
+	return ++m_refCount;
+}
+
+ULONG MultiviewerInput::Release(void)
+{
+	ULONG newRefValue = --m_refCount;
+
+	if (newRefValue == 0)
+		delete this;
+
+	return newRefValue;
+}
+
+// IDeckLinkInputCallback methods
+
+HRESULT MultiviewerInput::VideoInputFrameArrived(IDeckLinkVideoInputFrame* videoFrame, IDeckLinkAudioInputPacket* audioPacket)
+{
+	if (videoFrame)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		// Keep a reference to the latest frame only, the previous frame is returned to the capture pool
+		if ((videoFrame->GetFlags() & bmdFrameHasNoInputSource) == 0)
+			m_latestFrame = videoFrame;
+		else
+			m_latestFrame = nullptr;
+
+		m_frameSequence++;
+	}
+
+	if (audioPacket)
+	{
+		void*		audioBytes;
+		long		sampleFrameCount = audioPacket->GetSampleFrameCount();
+		int32_t		packetPeaks[kAudioChannelCount] = { 0 };
+
+		if (audioPacket->GetBytes(&audioBytes) != S_OK)
+			return E_FAIL;
+
+		const int32_t* samples = (const int32_t*)audioBytes;
+		for (long i = 0; i < sampleFrameCount; i++)
+		{
+			for (unsigned channel = 0; channel < kAudioChannelCount; channel++, samples++)
+			{
+				// Magnitude of full scale negative sample is clamped to INT32_MAX
+				int32_t magnitude = (*samples == INT32_MIN) ? INT32_MAX : abs(*samples);
+				if (magnitude > packetPeaks[channel])
+					packetPeaks[channel] = magnitude;
+			}
+		}
+
+		for (unsigned channel = 0; channel < kAudioChannelCount; channel++)
+		{
+			int32_t peak = m_audioPeaks[channel].load(std::memory_order_relaxed);
+			while ((packetPeaks[channel] > peak) && !m_audioPeaks[channel].compare_exchange_weak(peak, packetPeaks[channel], std::memory_order_relaxed))
+			{ }
+		}
+	}
+
+	return S_OK;
+}
+
+HRESULT MultiviewerInput::VideoInputFormatChanged(BMDVideoInputFormatChangedEvents notificationEvents, IDeckLinkDisplayMode *newMode, BMDDetectedVideoInputFormatFlags /*detectedSignalFlags*/)
+{
+	// Tiles are always drawn from 8-bit YUV, so only a change of display mode needs the input to be restarted
+	if ((notificationEvents & bmdVideoInputDisplayModeChanged) == 0)
+		return S_OK;
+
+	m_deckLinkInput->PauseStreams();
+	m_deckLinkInput->EnableVideoInput(newMode->GetDisplayMode(), bmdFormat8BitYUV, bmdVideoInputEnableFormatDetection);
+	m_deckLinkInput->FlushStreams();
+	m_deckLinkInput->StartStreams();
+
+	setDisplayModeName(newMode);
+
+	return S_OK;
+}
+
+// Other methods
+
+bool MultiviewerInput::startCapture(BMDDisplayMode initialDisplayMode)
+{
+	com_ptr<IDeckLinkDisplayMode> deckLinkDisplayMode;
+
+	if (m_deckLinkInput->GetDisplayMode(initialDisplayMode, deckLinkDisplayMode.releaseAndGetAddressOf()) != S_OK)
+		return false;
+
+	setDisplayModeName(deckLinkDisplayMode.get());
+
+	if (m_deckLinkInput->SetCallback(this) != S_OK)
+		return false;
+
+	if (m_deckLinkInput->EnableVideoInput(initialDisplayMode, bmdFormat8BitYUV, bmdVideoInputEnableFormatDetection) != S_OK)
+		return false;
+
+	if (m_deckLinkInput->EnableAudioInput(bmdAudioSampleRate48kHz, bmdAudioSampleType32bitInteger, kAudioChannelCount) != S_OK)
+		return false;
+
+	return m_deckLinkInput->StartStreams() == S_OK;
+}
+
+void MultiviewerInput::stopCapture()
+{
+	m_deckLinkInput->StopStreams();
+
+	m_deckLinkInput->DisableVideoInput();
+	m_deckLinkInput->DisableAudioInput();
+
+	m_deckLinkInput->SetCallback(nullptr);
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_latestFrame = nullptr;
+}
+
+bool MultiviewerInput::getLatestFrame(com_ptr<IDeckLinkVideoInputFrame>& videoFrame, uint64_t& sequence)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	videoFrame = m_latestFrame;
+	sequence = m_frameSequence;
+
+	return (bool)videoFrame;
+}
+
+void MultiviewerInput::takeAudioPeakLevels(float peakLevels[kAudioChannelCount])
+{
+	for (unsigned channel = 0; channel < kAudioChannelCount; channel++)
+		peakLevels[channel] = (float)m_audioPeaks[channel].exchange(0, std::memory_order_relaxed) / (float)INT32_MAX;
+}
+
+std::string MultiviewerInput::getLabel()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_deviceName + " " + m_displayModeName;
+}
+
+void MultiviewerInput::setDisplayModeName(IDeckLinkDisplayMode* displayMode)
+{
+	dlstring_t	displayModeName;
+	std::string	displayModeNameString;
+
+	if (displayMode->GetName(&displayModeName) == S_OK)
+	{
+		displayModeNameString = DlToStdString(displayModeName);
+		DeleteString(displayModeName);
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_displayModeName = displayModeNameString;
+}
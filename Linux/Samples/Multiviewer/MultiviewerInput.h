@@ -0,0 +1,95 @@
+/* -LICENSE-START-
+** Copyright (c) 2022 Blackmagic Design
+**  
+** Permission is hereby granted, free of charge, to any person or organization 
+** obtaining a copy of the software and accompanying documentation (the 
+** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+** and transmit the Software, and to prepare derivative works of the Software, 
+** and to permit third-parties to whom the Software is furnished to do so, in 
+** accordance with:
+** 
+** (1) if the Software is obtained from Blackmagic Design, the End User License 
+** Agreement for the Software Development Kit (“EULA”) available at 
+** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+** 
+** (2) if the Software is obtained from any third party, such licensing terms 
+** as notified by that third party,
+** 
+** and all subject to the following:
+** 
+** (3) the copyright notices in the Software and this entire statement, 
+** including the above license grant, this restriction and the following 
+** disclaimer, must be included in all copies of the Software, in whole or in 
+** part, and all derivative works of the Software, unless such copies or 
+** derivative works are solely in the form of machine-executable object code 
+** generated by a source language processor.
+** 
+** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+** DEALINGS IN THE SOFTWARE.
+** 
+** A copy of the Software is available free of charge at 
+** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+** 
+** -LICENSE-END-
+*/
+
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <string>
+
+#include "DeckLinkAPI.h"
+#include "com_ptr.h"
+
+// A MultiviewerInput captures one DeckLink input in 8-bit YUV, following input format changes, and keeps only the
+// most recent frame.  The output renders whichever frame is latest when it needs one, so inputs on different clocks
+// are frame synchronised by repeating or skipping frames; the frame sequence number lets the caller count both.
+class MultiviewerInput : public IDeckLinkInputCallback
+{
+public:
+	static const unsigned	kAudioChannelCount = 2;
+
+	MultiviewerInput(com_ptr<IDeckLink>& deckLink, const std::string& deviceName);
+	virtual ~MultiviewerInput() = default;
+
+	// IUnknown interface
+	HRESULT	STDMETHODCALLTYPE QueryInterface(REFIID iid, LPVOID *ppv) override;
+	ULONG	STDMETHODCALLTYPE AddRef() override;
+	ULONG	STDMETHODCALLTYPE Release() override;
+
+	// IDeckLinkInputCallback interface
+	HRESULT	STDMETHODCALLTYPE VideoInputFormatChanged(BMDVideoInputFormatChangedEvents notificationEvents, IDeckLinkDisplayMode *newDisplayMode, BMDDetectedVideoInputFormatFlags detectedSignalFlags) override;
+	HRESULT	STDMETHODCALLTYPE VideoInputFrameArrived(IDeckLinkVideoInputFrame* videoFrame, IDeckLinkAudioInputPacket* audioPacket) override;
+
+	// Other methods
+	bool	startCapture(BMDDisplayMode initialDisplayMode);
+	void	stopCapture(void);
+
+	// Returns false if there is no valid frame, sequence increments for every captured frame
+	bool	getLatestFrame(com_ptr<IDeckLinkVideoInputFrame>& videoFrame, uint64_t& sequence);
+	// Linear peak level of each channel since the previous call
+	void	takeAudioPeakLevels(float peakLevels[kAudioChannelCount]);
+	// Device name and current display mode
+	std::string	getLabel(void);
+
+private:
+	std::atomic<ULONG>					m_refCount;
+	//
+	com_ptr<IDeckLinkInput>				m_deckLinkInput;
+	std::string							m_deviceName;
+	//
+	std::mutex							m_mutex;
+	com_ptr<IDeckLinkVideoInputFrame>	m_latestFrame;
+	uint64_t							m_frameSequence;
+	std::string							m_displayModeName;
+	//
+	std::atomic<int32_t>				m_audioPeaks[kAudioChannelCount];
+
+	void	setDisplayModeName(IDeckLinkDisplayMode* displayMode);
+};
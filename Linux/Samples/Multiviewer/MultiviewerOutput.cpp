@@ -0,0 +1,270 @@
+/* -LICENSE-START-
+** Copyright (c) 2022 Blackmagic Design
+**  
+** Permission is hereby granted, free of charge, to any person or organization 
+** obtaining a copy of the software and accompanying documentation (the 
+** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+** and transmit the Software, and to prepare derivative works of the Software, 
+** and to permit third-parties to whom the Software is furnished to do so, in 
+** accordance with:
+** 
+** (1) if the Software is obtained from Blackmagic Design, the End User License 
+** Agreement for the Software Development Kit (“EULA”) available at 
+** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+** 
+** (2) if the Software is obtained from any third party, such licensing terms 
+** as notified by that third party,
+** 
+** and all subject to the following:
+** 
+** (3) the copyright notices in the Software and this entire statement, 
+** including the above license grant, this restriction and the following 
+** disclaimer, must be included in all copies of the Software, in whole or in 
+** part, and all derivative works of the Software, unless such copies or 
+** derivative works are solely in the form of machine-executable object code 
+** generated by a source language processor.
+** 
+** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+** DEALINGS IN THE SOFTWARE.
+** 
+** A copy of the Software is available free of charge at 
+** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+** 
+** -LICENSE-END-
+*/
+
+#include <stdexcept>
+
+#include "platform.h"
+#include "MultiviewerOutput.h"
+
+// Frames in addition to the preroll, so that one frame can be rendered while another completes
+static const unsigned kFramePoolExtraFrames = 2;
+
+MultiviewerOutput::MultiviewerOutput(com_ptr<IDeckLink>& deckLink, unsigned prerollFrames) :
+	m_refCount(1),
+	m_deckLinkOutput(IID_IDeckLinkOutput, deckLink),
+	m_prerollFrames(prerollFrames),
+	m_frameDuration(0),
+	m_frameTimescale(0),
+	m_nextFrameTime(0),
+	m_stopRendering(false),
+	m_framesScheduled(0),
+	m_framesDisplayedLate(0),
+	m_framesDropped(0)
+{
+	if (!m_deckLinkOutput)
+		throw std::runtime_error("DeckLink device does not have an output interface");
+}
+
+// IUnknown methods
+
+HRESULT	MultiviewerOutput::QueryInterface(REFIID iid, LPVOID *ppv)
+{
+	HRESULT result = S_OK;
+
+	if (ppv == nullptr)
+		return E_INVALIDARG;
+
+	if (iid == IID_IUnknown)
+	{
+		*ppv = this;
+		AddRef();
+	}
+	else if (iid == IID_IDeckLinkVideoOutputCallback)
+	{
+		*ppv = (IDeckLinkVideoOutputCallback*)this;
+		AddRef();
+	}
+	else
+	{
+		*ppv = nullptr;
+		result = E_NOINTERFACE;
+	}
+
+	return result;
+}
+
+ULONG MultiviewerOutput::AddRef(void)
+{
+	return ++m_refCount;
+}
+
+ULONG MultiviewerOutput::Release(void)
+{
+	ULONG newRefValue = --m_refCount;
+
+	if (newRefValue == 0)
+		delete this;
+
+	return newRefValue;
+}
+
+// IDeckLinkVideoOutputCallback methods
+
+HRESULT MultiviewerOutput::ScheduledFrameCompleted(IDeckLinkVideoFrame* completedFrame, BMDOutputFrameCompletionResult result)
+{
+	if (result == bmdOutputFrameDisplayedLate)
+		m_framesDisplayedLate++;
+	else if (result == bmdOutputFrameDropped)
+		m_framesDropped++;
+
+	// Return the frame to the pool for the render thread
+	for (auto& poolFrame : m_framePool)
+	{
+		if ((IDeckLinkVideoFrame*)poolFrame.get() == completedFrame)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_freeFrames.push_back(poolFrame.get());
+			m_freeFrameCondition.notify_one();
+			break;
+		}
+	}
+
+	return S_OK;
+}
+
+HRESULT MultiviewerOutput::ScheduledPlaybackHasStopped()
+{
+	return S_OK;
+}
+
+// Other methods
+
+bool MultiviewerOutput::startPlayback(BMDDisplayMode displayMode, const RenderFrameCallback& renderFrame)
+{
+	com_ptr<IDeckLinkDisplayMode> deckLinkDisplayMode;
+
+	if (m_deckLinkOutput->GetDisplayMode(displayMode, deckLinkDisplayMode.releaseAndGetAddressOf()) != S_OK)
+		return false;
+
+	if (deckLinkDisplayMode->GetFrameRate(&m_frameDuration, &m_frameTimescale) != S_OK)
+		return false;
+
+	int32_t width = (int32_t)deckLinkDisplayMode->GetWidth();
+	int32_t height = (int32_t)deckLinkDisplayMode->GetHeight();
+
+	if (m_deckLinkOutput->SetScheduledFrameCompletionCallback(this) != S_OK)
+		return false;
+
+	if (m_deckLinkOutput->EnableVideoOutput(displayMode, bmdVideoOutputFlagDefault) != S_OK)
+		return false;
+
+	m_framePool.clear();
+	m_freeFrames.clear();
+
+	for (unsigned i = 0; i < m_prerollFrames + kFramePoolExtraFrames; i++)
+	{
+		com_ptr<IDeckLinkMutableVideoFrame> videoFrame;
+
+		if (m_deckLinkOutput->CreateVideoFrame(width, height, width * 2, bmdFormat8BitYUV, bmdFrameFlagDefault, videoFrame.releaseAndGetAddressOf()) != S_OK)
+		{
+			m_deckLinkOutput->DisableVideoOutput();
+			return false;
+		}
+
+		m_framePool.push_back(videoFrame);
+	}
+
+	m_renderFrameCallback	= renderFrame;
+	m_nextFrameTime			= 0;
+	m_stopRendering			= false;
+	m_framesScheduled		= 0;
+	m_framesDisplayedLate	= 0;
+	m_framesDropped			= 0;
+
+	// Preroll, then the render thread schedules each remaining frame as it becomes free
+	for (unsigned i = 0; i < m_framePool.size(); i++)
+	{
+		if ((i >= m_prerollFrames) || !renderAndScheduleFrame(m_framePool[i].get()))
+			m_freeFrames.push_back(m_framePool[i].get());
+	}
+
+	if (m_deckLinkOutput->StartScheduledPlayback(0, m_frameTimescale, 1.0) != S_OK)
+	{
+		m_deckLinkOutput->DisableVideoOutput();
+		return false;
+	}
+
+	m_renderThread = std::thread(&MultiviewerOutput::renderThread, this);
+
+	return true;
+}
+
+void MultiviewerOutput::stopPlayback()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopRendering = true;
+	}
+	m_freeFrameCondition.notify_all();
+
+	if (m_renderThread.joinable())
+		m_renderThread.join();
+
+	m_deckLinkOutput->StopScheduledPlayback(0, nullptr, 0);
+	m_deckLinkOutput->DisableVideoOutput();
+	m_deckLinkOutput->SetScheduledFrameCompletionCallback(nullptr);
+
+	m_freeFrames.clear();
+	m_framePool.clear();
+}
+
+void MultiviewerOutput::getStatistics(Statistics& statistics) const
+{
+	statistics.framesScheduled		= m_framesScheduled;
+	statistics.framesDisplayedLate	= m_framesDisplayedLate;
+	statistics.framesDropped		= m_framesDropped;
+}
+
+bool MultiviewerOutput::renderAndScheduleFrame(IDeckLinkMutableVideoFrame* videoFrame)
+{
+	BMDTimeValue	streamTime;
+	double			playbackSpeed;
+
+	m_renderFrameCallback(videoFrame);
+
+	// If rendering has fallen behind playout, skip ahead rather than scheduling frames that would be dropped
+	if ((m_deckLinkOutput->GetScheduledStreamTime(m_frameTimescale, &streamTime, &playbackSpeed) == S_OK) &&
+		(playbackSpeed > 0.0) && (m_nextFrameTime <= streamTime))
+	{
+		m_nextFrameTime = (streamTime / m_frameDuration + 1) * m_frameDuration;
+	}
+
+	if (m_deckLinkOutput->ScheduleVideoFrame(videoFrame, m_nextFrameTime, m_frameDuration, m_frameTimescale) != S_OK)
+		return false;
+
+	m_nextFrameTime += m_frameDuration;
+	m_framesScheduled++;
+
+	return true;
+}
+
+void MultiviewerOutput::renderThread()
+{
+	while (true)
+	{
+		IDeckLinkMutableVideoFrame* videoFrame;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_freeFrameCondition.wait(lock, [&] { return m_stopRendering || !m_freeFrames.empty(); });
+
+			if (m_stopRendering)
+				break;
+
+			videoFrame = m_freeFrames.front();
+			m_freeFrames.pop_front();
+		}
+
+		if (!renderAndScheduleFrame(videoFrame))
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_freeFrames.push_back(videoFrame);
+		}
+	}
+}
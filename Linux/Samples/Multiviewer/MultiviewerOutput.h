@@ -0,0 +1,110 @@
+/* -LICENSE-START-
+** Copyright (c) 2022 Blackmagic Design
+**  
+** Permission is hereby granted, free of charge, to any person or organization 
+** obtaining a copy of the software and accompanying documentation (the 
+** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+** and transmit the Software, and to prepare derivative works of the Software, 
+** and to permit third-parties to whom the Software is furnished to do so, in 
+** accordance with:
+** 
+** (1) if the Software is obtained from Blackmagic Design, the End User License 
+** Agreement for the Software Development Kit (“EULA”) available at 
+** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+** 
+** (2) if the Software is obtained from any third party, such licensing terms 
+** as notified by that third party,
+** 
+** and all subject to the following:
+** 
+** (3) the copyright notices in the Software and this entire statement, 
+** including the above license grant, this restriction and the following 
+** disclaimer, must be included in all copies of the Software, in whole or in 
+** part, and all derivative works of the Software, unless such copies or 
+** derivative works are solely in the form of machine-executable object code 
+** generated by a source language processor.
+** 
+** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+** DEALINGS IN THE SOFTWARE.
+** 
+** A copy of the Software is available free of charge at 
+** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+** 
+** -LICENSE-END-
+*/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "DeckLinkAPI.h"
+#include "com_ptr.h"
+
+// A MultiviewerOutput plays out 8-bit YUV frames at the native cadence of the output display mode.  Frames come
+// from a fixed pool, and the render thread fills each frame as soon as the completion of a previously scheduled
+// frame returns it to the pool, so rendering is paced by the output clock and runs the preroll ahead of playout.
+class MultiviewerOutput : public IDeckLinkVideoOutputCallback
+{
+public:
+	using RenderFrameCallback = std::function<void(IDeckLinkMutableVideoFrame*)>;
+
+	struct Statistics
+	{
+		uint64_t	framesScheduled;
+		uint64_t	framesDisplayedLate;
+		uint64_t	framesDropped;
+	};
+
+	MultiviewerOutput(com_ptr<IDeckLink>& deckLink, unsigned prerollFrames);
+	virtual ~MultiviewerOutput() = default;
+
+	// IUnknown interface
+	HRESULT	STDMETHODCALLTYPE QueryInterface(REFIID iid, LPVOID *ppv) override;
+	ULONG	STDMETHODCALLTYPE AddRef() override;
+	ULONG	STDMETHODCALLTYPE Release() override;
+
+	// IDeckLinkVideoOutputCallback interface
+	HRESULT	STDMETHODCALLTYPE ScheduledFrameCompleted(IDeckLinkVideoFrame* completedFrame, BMDOutputFrameCompletionResult result) override;
+	HRESULT	STDMETHODCALLTYPE ScheduledPlaybackHasStopped() override;
+
+	// Other methods
+	bool	startPlayback(BMDDisplayMode displayMode, const RenderFrameCallback& renderFrame);
+	void	stopPlayback(void);
+
+	void	getStatistics(Statistics& statistics) const;
+
+private:
+	std::atomic<ULONG>							m_refCount;
+	//
+	com_ptr<IDeckLinkOutput>					m_deckLinkOutput;
+	unsigned									m_prerollFrames;
+	BMDTimeValue								m_frameDuration;
+	BMDTimeScale								m_frameTimescale;
+	BMDTimeValue								m_nextFrameTime;
+	RenderFrameCallback							m_renderFrameCallback;
+	//
+	std::vector<com_ptr<IDeckLinkMutableVideoFrame>>	m_framePool;
+	std::deque<IDeckLinkMutableVideoFrame*>		m_freeFrames;
+	std::mutex									m_mutex;
+	std::condition_variable						m_freeFrameCondition;
+	bool										m_stopRendering;
+	std::thread									m_renderThread;
+	//
+	std::atomic<uint64_t>						m_framesScheduled;
+	std::atomic<uint64_t>						m_framesDisplayedLate;
+	std::atomic<uint64_t>						m_framesDropped;
+
+	bool	renderAndScheduleFrame(IDeckLinkMutableVideoFrame* videoFrame);
+	void	renderThread(void);
+};
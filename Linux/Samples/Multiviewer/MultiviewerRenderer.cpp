@@ -0,0 +1,658 @@
+/* -LICENSE-START-
+** Copyright (c) 2022 Blackmagic Design
+**  
+** Permission is hereby granted, free of charge, to any person or organization 
+** obtaining a copy of the software and accompanying documentation (the 
+** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+** and transmit the Software, and to prepare derivative works of the Software, 
+** and to permit third-parties to whom the Software is furnished to do so, in 
+** accordance with:
+** 
+** (1) if the Software is obtained from Blackmagic Design, the End User License 
+** Agreement for the Software Development Kit (“EULA”) available at 
+** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+** 
+** (2) if the Software is obtained from any third party, such licensing terms 
+** as notified by that third party,
+** 
+** and all subject to the following:
+** 
+** (3) the copyright notices in the Software and this entire statement, 
+** including the above license grant, this restriction and the following 
+** disclaimer, must be included in all copies of the Software, in whole or in 
+** part, and all derivative works of the Software, unless such copies or 
+** derivative works are solely in the form of machine-executable object code 
+** generated by a source language processor.
+** 
+** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+** DEALINGS IN THE SOFTWARE.
+** 
+** A copy of the Software is available free of charge at 
+** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+** 
+** -LICENSE-END-
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <string.h>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#include "MultiviewerRenderer.h"
+
+static const uint32_t	kBandRowCount		= 32;		// Rows of each tile scaled by a task
+static const float		kAudioMeterDecay	= 0.977f;	// Peak hold falls by about 0.2 dB each frame
+static const float		kAudioMeterRangeDb	= 60.0f;	// Bottom of the audio meter scale, dBFS
+
+// 8-bit Rec.709 colours as Y Cb Cr
+static const uint8_t	kBlack[3]			= { 16, 128, 128 };
+static const uint8_t	kWhite[3]			= { 235, 128, 128 };
+static const uint8_t	kRed[3]				= { 63, 102, 240 };
+static const uint8_t	kGreen[3]			= { 173, 42, 26 };
+static const uint8_t	kYellow[3]			= { 219, 16, 138 };
+static const uint8_t	kDarkGrey[3]		= { 40, 128, 128 };
+
+// 5x7 font for ASCII 32 to 95, lower case letters are drawn as upper case.  Each byte is one row, bit 4 is the left column.
+static const unsigned	kGlyphWidth			= 5;
+static const unsigned	kGlyphHeight		= 7;
+static const unsigned	kGlyphAdvance		= 6;
+
+static const uint8_t	kFont[64][kGlyphHeight] =
+{
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },		// space
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },		// !
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },		// "
+	{ 0x0a, 0x0a, 0x1f, 0x0a, 0x1f, 0x0a, 0x0a },		// #
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },		// $
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },		// %
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },		// &
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },		// quote
+	{ 0x02, 0x04, 0x08, 0x08, 0x08, 0x04, 0x02 },		// (
+	{ 0x08, 0x04, 0x02, 0x02, 0x02, 0x04, 0x08 },		// )
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },		// *
+	{ 0x00, 0x04, 0x04, 0x1f, 0x04, 0x04, 0x00 },		// +
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },		// ,
+	{ 0x00, 0x00, 0x00, 0x1f, 0x00, 0x00, 0x00 },		// -
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x0c, 0x0c },		// .
+	{ 0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00 },		// /
+	{ 0x0e, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0e },		// 0
+	{ 0x04, 0x0c, 0x04, 0x04, 0x04, 0x04, 0x0e },		// 1
+	{ 0x0e, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1f },		// 2
+	{ 0x1f, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0e },		// 3
+	{ 0x02, 0x06, 0x0a, 0x12, 0x1f, 0x02, 0x02 },		// 4
+	{ 0x1f, 0x10, 0x1e, 0x01, 0x01, 0x11, 0x0e },		// 5
+	{ 0x06, 0x08, 0x10, 0x1e, 0x11, 0x11, 0x0e },		// 6
+	{ 0x1f, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08 },		// 7
+	{ 0x0e, 0x11, 0x11, 0x0e, 0x11, 0x11, 0x0e },		// 8
+	{ 0x0e, 0x11, 0x11, 0x0f, 0x01, 0x02, 0x0c },		// 9
+	{ 0x00, 0x0c, 0x0c, 0x00, 0x0c, 0x0c, 0x00 },		// :
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },		// ;
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },		// <
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },		// =
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },		// >
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },		// ?
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },		// @
+	{ 0x0e, 0x11, 0x11, 0x1f, 0x11, 0x11, 0x11 },		// A
+	{ 0x1e, 0x11, 0x11, 0x1e, 0x11, 0x11, 0x1e },		// B
+	{ 0x0e, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0e },		// C
+	{ 0x1c, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1c },		// D
+	{ 0x1f, 0x10, 0x10, 0x1e, 0x10, 0x10, 0x1f },		// E
+	{ 0x1f, 0x10, 0x10, 0x1e, 0x10, 0x10, 0x10 },		// F
+	{ 0x0e, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0f },		// G
+	{ 0x11, 0x11, 0x11, 0x1f, 0x11, 0x11, 0x11 },		// H
+	{ 0x0e, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0e },		// I
+	{ 0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0c },		// J
+	{ 0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11 },		// K
+	{ 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1f },		// L
+	{ 0x11, 0x1b, 0x15, 0x15, 0x11, 0x11, 0x11 },		// M
+	{ 0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11 },		// N
+	{ 0x0e, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0e },		// O
+	{ 0x1e, 0x11, 0x11, 0x1e, 0x10, 0x10, 0x10 },		// P
+	{ 0x0e, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0d },		// Q
+	{ 0x1e, 0x11, 0x11, 0x1e, 0x14, 0x12, 0x11 },		// R
+	{ 0x0f, 0x10, 0x10, 0x0e, 0x01, 0x01, 0x1e },		// S
+	{ 0x1f, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04 },		// T
+	{ 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0e },		// U
+	{ 0x11, 0x11, 0x11, 0x11, 0x11, 0x0a, 0x04 },		// V
+	{ 0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0a },		// W
+	{ 0x11, 0x11, 0x0a, 0x04, 0x0a, 0x11, 0x11 },		// X
+	{ 0x11, 0x11, 0x11, 0x0a, 0x04, 0x04, 0x04 },		// Y
+	{ 0x1f, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1f },		// Z
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },		// [
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },		// backslash
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },		// ]
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },		// ^
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1f },		// _
+};
+
+// 2:1 box downscaling of UYVY, two source rows to one output row.  Rows are averaged first, then each output
+// pixel pair takes the average of two source pairs: Cb and Cr from both pairs, Y0 from the first pair, Y1 from the second.
+
+static void boxDownscaleScalar(const uint8_t* row0, const uint8_t* row1, uint8_t* output, uint32_t outputPixelCount)
+{
+	for (uint32_t x = 0; x < outputPixelCount; x += 2, row0 += 8, row1 += 8, output += 4)
+	{
+		uint8_t v[8];
+		for (unsigned i = 0; i < 8; i++)
+			v[i] = (uint8_t)((row0[i] + row1[i] + 1) >> 1);
+
+		output[0] = (uint8_t)((v[0] + v[4] + 1) >> 1);
+		output[1] = (uint8_t)((v[1] + v[3] + 1) >> 1);
+		output[2] = (uint8_t)((v[2] + v[6] + 1) >> 1);
+		output[3] = (uint8_t)((v[5] + v[7] + 1) >> 1);
+	}
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("avx2")))
+static void boxDownscaleAVX2(const uint8_t* row0, const uint8_t* row1, uint8_t* output, uint32_t outputPixelCount)
+{
+	// For each group of two source pairs (Cb0 Y0 Cr0 Y1 Cb2 Y2 Cr2 Y3), gather Cb0 Y0 Cr0 Y2 in the low half and
+	// Cb2 Y1 Cr2 Y3 in the high half of each 128-bit lane, so averaging the halves gives the output pair
+	const __m256i	pairShuffle = _mm256_setr_epi8(0, 1, 2, 5, 8, 9, 10, 13, 4, 3, 6, 7, 12, 11, 14, 15,
+												   0, 1, 2, 5, 8, 9, 10, 13, 4, 3, 6, 7, 12, 11, 14, 15);
+	uint32_t		x = 0;
+
+	for (; x + 16 <= outputPixelCount; x += 16, row0 += 64, row1 += 64, output += 32)
+	{
+		__m256i v0 = _mm256_avg_epu8(_mm256_loadu_si256((const __m256i*)row0), _mm256_loadu_si256((const __m256i*)row1));
+		__m256i v1 = _mm256_avg_epu8(_mm256_loadu_si256((const __m256i*)(row0 + 32)), _mm256_loadu_si256((const __m256i*)(row1 + 32)));
+
+		v0 = _mm256_shuffle_epi8(v0, pairShuffle);
+		v1 = _mm256_shuffle_epi8(v1, pairShuffle);
+
+		// Lane 0 holds output groups 0, 1, 4, 5 and lane 1 holds 2, 3, 6, 7, reorder them
+		__m256i result = _mm256_avg_epu8(_mm256_unpacklo_epi64(v0, v1), _mm256_unpackhi_epi64(v0, v1));
+		result = _mm256_permute4x64_epi64(result, _MM_SHUFFLE(3, 1, 2, 0));
+
+		_mm256_storeu_si256((__m256i*)output, result);
+	}
+
+	boxDownscaleScalar(row0, row1, output, outputPixelCount - x);
+}
+#elif defined(__aarch64__)
+static void boxDownscaleNEON(const uint8_t* row0, const uint8_t* row1, uint8_t* output, uint32_t outputPixelCount)
+{
+	uint32_t x = 0;
+
+	for (; x + 16 <= outputPixelCount; x += 16, row0 += 64, row1 += 64, output += 32)
+	{
+		// Deinterleave 16 source pairs into Cb, first Y, Cr and second Y
+		uint8x16x4_t	source0 = vld4q_u8(row0);
+		uint8x16x4_t	source1 = vld4q_u8(row1);
+		uint8x16_t		cb = vrhaddq_u8(source0.val[0], source1.val[0]);
+		uint8x16_t		cr = vrhaddq_u8(source0.val[2], source1.val[2]);
+		uint8x16_t		y = vrhaddq_u8(vrhaddq_u8(source0.val[1], source1.val[1]), vrhaddq_u8(source0.val[3], source1.val[3]));
+		uint8x8x4_t		result;
+
+		result.val[0] = vget_low_u8(vrhaddq_u8(vuzp1q_u8(cb, cb), vuzp2q_u8(cb, cb)));
+		result.val[1] = vget_low_u8(vuzp1q_u8(y, y));
+		result.val[2] = vget_low_u8(vrhaddq_u8(vuzp1q_u8(cr, cr), vuzp2q_u8(cr, cr)));
+		result.val[3] = vget_low_u8(vuzp2q_u8(y, y));
+
+		vst4_u8(output, result);
+	}
+
+	boxDownscaleScalar(row0, row1, output, outputPixelCount - x);
+}
+#endif
+
+// Bilinear scaling of UYVY.  Each output row is made by blending the two nearest source rows, then sampling the
+// blended row horizontally with precomputed byte offsets and 8-bit weights for each output sample.
+struct BilinearTaps
+{
+	uint32_t				sourceWidth;
+	uint32_t				outputWidth;
+	std::vector<uint32_t>	offsets;		// Byte offset of the left sample in the blended row
+	std::vector<uint16_t>	weights;		// Weight of the right sample, 0 to 256
+};
+
+static void addBilinearTap(BilinearTaps& taps, int64_t position, uint32_t sampleCount, uint32_t sampleStride, uint32_t sampleOffset)
+{
+	// Position is 16.16 fixed point, the left and right samples are the same at the edges
+	position = std::max(position, (int64_t)0);
+
+	uint32_t	index = (uint32_t)(position >> 16);
+	uint32_t	weight = (uint32_t)((position >> 8) & 0xff);
+
+	if (index >= sampleCount - 1)
+	{
+		index = sampleCount - 1;
+		weight = 0;
+	}
+
+	taps.offsets.push_back(index * sampleStride + sampleOffset);
+	taps.weights.push_back((uint16_t)weight);
+}
+
+// Taps for each output byte in UYVY order, luma and chroma are sampled at their own positions
+static void makeBilinearTaps(BilinearTaps& taps, uint32_t sourceWidth, uint32_t outputWidth)
+{
+	int64_t		step = ((int64_t)sourceWidth << 16) / outputWidth;
+	uint32_t	chromaCount = (sourceWidth + 1) / 2;
+
+	taps.sourceWidth = sourceWidth;
+	taps.outputWidth = outputWidth;
+	taps.offsets.clear();
+	taps.weights.clear();
+
+	for (uint32_t x = 0; x < outputWidth; x += 2)
+	{
+		// Pixel centres of the output pair, chroma is sited on the first pixel of each pair
+		int64_t position0 = step * x + step / 2 - 32768;
+		int64_t position1 = position0 + step;
+
+		addBilinearTap(taps, position0 / 2, chromaCount, 4, 0);
+		addBilinearTap(taps, position0, sourceWidth, 2, 1);
+		addBilinearTap(taps, position0 / 2, chromaCount, 4, 2);
+		addBilinearTap(taps, position1, sourceWidth, 2, 1);
+	}
+}
+
+// Blend two rows with a 7-bit weight for row1, 0 to 128, so that the AVX2 kernel can multiply bytes
+static void blendRowsScalar(const uint8_t* row0, const uint8_t* row1, unsigned rowWeight, uint8_t* output, uint32_t byteCount)
+{
+	for (uint32_t i = 0; i < byteCount; i++)
+		output[i] = (uint8_t)((row0[i] * (128 - rowWeight) + row1[i] * rowWeight + 64) >> 7);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("avx2")))
+static void blendRowsAVX2(const uint8_t* row0, const uint8_t* row1, unsigned rowWeight, uint8_t* output, uint32_t byteCount)
+{
+	// Interleaved row0 and row1 bytes are multiplied by interleaved weights and summed in pairs
+	const __m256i	weights = _mm256_set1_epi16((short)((rowWeight << 8) | (128 - rowWeight)));
+	const __m256i	rounding = _mm256_set1_epi16(64);
+	uint32_t		i = 0;
+
+	for (; i + 32 <= byteCount; i += 32)
+	{
+		__m256i a = _mm256_loadu_si256((const __m256i*)(row0 + i));
+		__m256i b = _mm256_loadu_si256((const __m256i*)(row1 + i));
+		__m256i low = _mm256_srli_epi16(_mm256_add_epi16(_mm256_maddubs_epi16(_mm256_unpacklo_epi8(a, b), weights), rounding), 7);
+		__m256i high = _mm256_srli_epi16(_mm256_add_epi16(_mm256_maddubs_epi16(_mm256_unpackhi_epi8(a, b), weights), rounding), 7);
+
+		_mm256_storeu_si256((__m256i*)(output + i), _mm256_packus_epi16(low, high));
+	}
+
+	blendRowsScalar(row0 + i, row1 + i, rowWeight, output + i, byteCount - i);
+}
+#elif defined(__aarch64__)
+static void blendRowsNEON(const uint8_t* row0, const uint8_t* row1, unsigned rowWeight, uint8_t* output, uint32_t byteCount)
+{
+	const uint8x8_t	weight0 = vdup_n_u8((uint8_t)(128 - rowWeight));
+	const uint8x8_t	weight1 = vdup_n_u8((uint8_t)rowWeight);
+	uint32_t		i = 0;
+
+	for (; i + 16 <= byteCount; i += 16)
+	{
+		uint8x16_t a = vld1q_u8(row0 + i);
+		uint8x16_t b = vld1q_u8(row1 + i);
+		uint16x8_t low = vmlal_u8(vmull_u8(vget_low_u8(a), weight0), vget_low_u8(b), weight1);
+		uint16x8_t high = vmlal_u8(vmull_u8(vget_high_u8(a), weight0), vget_high_u8(b), weight1);
+
+		vst1q_u8(output + i, vcombine_u8(vrshrn_n_u16(low, 7), vrshrn_n_u16(high, 7)));
+	}
+
+	blendRowsScalar(row0 + i, row1 + i, rowWeight, output + i, byteCount - i);
+}
+#endif
+
+static inline uint8_t bilinearSample(const uint8_t* blendedRow, uint32_t offset, uint32_t rightOffset, unsigned weight)
+{
+	const uint8_t* left = blendedRow + offset;
+	return (uint8_t)((left[0] * (256 - weight) + left[rightOffset] * weight + 128) >> 8);
+}
+
+static void bilinearScaleRow(const uint8_t* blendedRow, const BilinearTaps& taps, uint8_t* output)
+{
+	const uint32_t*	offsets = taps.offsets.data();
+	const uint16_t*	weights = taps.weights.data();
+
+	// The right sample is the next chroma sample (4 bytes) for Cb and Cr, or the next luma sample (2 bytes) for Y
+	for (size_t i = 0; i < taps.offsets.size(); i += 4)
+	{
+		output[i + 0] = bilinearSample(blendedRow, offsets[i + 0], 4, weights[i + 0]);
+		output[i + 1] = bilinearSample(blendedRow, offsets[i + 1], 2, weights[i + 1]);
+		output[i + 2] = bilinearSample(blendedRow, offsets[i + 2], 4, weights[i + 2]);
+		output[i + 3] = bilinearSample(blendedRow, offsets[i + 3], 2, weights[i + 3]);
+	}
+}
+
+// Drawing on UYVY frames, x and width must be even
+
+static void fillRect(uint8_t* frame, uint32_t rowBytes, uint32_t x, uint32_t y, uint32_t width, uint32_t height, const uint8_t colour[3])
+{
+	for (uint32_t row = y; row < y + height; row++)
+	{
+		uint8_t* pixels = frame + (size_t)row * rowBytes + x * 2;
+		for (uint32_t i = 0; i < width; i += 2, pixels += 4)
+		{
+			pixels[0] = colour[1];
+			pixels[1] = colour[0];
+			pixels[2] = colour[2];
+			pixels[3] = colour[0];
+		}
+	}
+}
+
+// Darken to a quarter of the brightness and saturation, for the background of text
+static void darkenRect(uint8_t* frame, uint32_t rowBytes, uint32_t x, uint32_t y, uint32_t width, uint32_t height)
+{
+	for (uint32_t row = y; row < y + height; row++)
+	{
+		uint8_t* pixels = frame + (size_t)row * rowBytes + x * 2;
+		for (uint32_t i = 0; i < width; i += 2, pixels += 4)
+		{
+			pixels[0] = (uint8_t)(96 + (pixels[0] >> 2));
+			pixels[1] = (uint8_t)(12 + (pixels[1] >> 2));
+			pixels[2] = (uint8_t)(96 + (pixels[2] >> 2));
+			pixels[3] = (uint8_t)(12 + (pixels[3] >> 2));
+		}
+	}
+}
+
+// Draw text with each font pixel as a scale x scale square, returns the width drawn.  scale must be even.
+static uint32_t drawText(uint8_t* frame, uint32_t rowBytes, uint32_t x, uint32_t y, uint32_t maxWidth, const char* text, uint32_t scale, const uint8_t colour[3])
+{
+	uint32_t width = 0;
+
+	for (; *text && (width + kGlyphWidth * scale <= maxWidth); text++, width += kGlyphAdvance * scale)
+	{
+		int character = toupper((unsigned char)*text);
+		if ((character < 32) || (character > 95))
+			character = '?';
+
+		const uint8_t* glyph = kFont[character - 32];
+
+		for (unsigned glyphRow = 0; glyphRow < kGlyphHeight; glyphRow++)
+		{
+			for (unsigned glyphColumn = 0; glyphColumn < kGlyphWidth; glyphColumn++)
+			{
+				if (glyph[glyphRow] & (0x10 >> glyphColumn))
+					fillRect(frame, rowBytes, x + width + glyphColumn * scale, y + glyphRow * scale, scale, scale, colour);
+			}
+		}
+	}
+
+	return width;
+}
+
+// MultiviewerRenderer
+
+MultiviewerRenderer::MultiviewerRenderer(unsigned tileCount, unsigned threadCount) :
+	m_gridSize((unsigned)lround(sqrt((double)tileCount))),
+	m_boxDownscaleFunction(boxDownscaleScalar),
+	m_blendRowsFunction(blendRowsScalar),
+	m_audioMeters(tileCount),
+	m_frame(nullptr),
+	m_rowBytes(0),
+	m_sources(nullptr),
+	m_tiles(tileCount),
+	m_bandsPerTile(0),
+	m_taskCount(0),
+	m_nextTask(0),
+	m_jobGeneration(0),
+	m_busyWorkers(0),
+	m_stopWorkers(false)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	if (__builtin_cpu_supports("avx2"))
+	{
+		m_boxDownscaleFunction = boxDownscaleAVX2;
+		m_blendRowsFunction = blendRowsAVX2;
+	}
+#elif defined(__aarch64__)
+	m_boxDownscaleFunction = boxDownscaleNEON;
+	m_blendRowsFunction = blendRowsNEON;
+#endif
+
+	for (auto& meter : m_audioMeters)
+		std::fill(meter.level, meter.level + MultiviewerTileSource::kMaxAudioChannels, 0.0f);
+
+	if (threadCount == 0)
+		threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+
+	for (unsigned i = 0; i < threadCount - 1; i++)
+		m_workerThreads.emplace_back(&MultiviewerRenderer::workerThread, this);
+}
+
+MultiviewerRenderer::~MultiviewerRenderer()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopWorkers = true;
+	}
+	m_workCondition.notify_all();
+
+	for (auto& worker : m_workerThreads)
+		worker.join();
+}
+
+bool MultiviewerRenderer::isTileCountSupported(unsigned tileCount)
+{
+	return (tileCount == 4) || (tileCount == 9) || (tileCount == 16);
+}
+
+const char* MultiviewerRenderer::getScalerKernelName() const
+{
+#if defined(__x86_64__) || defined(__i386__)
+	if (m_boxDownscaleFunction == boxDownscaleAVX2)
+		return "AVX2";
+#elif defined(__aarch64__)
+	if (m_boxDownscaleFunction == boxDownscaleNEON)
+		return "NEON";
+#endif
+	return "scalar";
+}
+
+void MultiviewerRenderer::render(uint8_t* frame, uint32_t rowBytes, uint32_t width, uint32_t height, const std::vector<MultiviewerTileSource>& sources)
+{
+	uint32_t tileWidth = (width / m_gridSize) & ~1u;
+	uint32_t tileHeight = height / m_gridSize;
+
+	if (sources.size() < m_tiles.size())
+		return;
+
+	for (unsigned i = 0; i < m_tiles.size(); i++)
+	{
+		m_tiles[i].x		= (i % m_gridSize) * tileWidth;
+		m_tiles[i].y		= (i / m_gridSize) * tileHeight;
+		m_tiles[i].width	= tileWidth;
+		m_tiles[i].height	= tileHeight;
+	}
+
+	m_frame			= frame;
+	m_rowBytes		= rowBytes;
+	m_sources		= &sources;
+	m_bandsPerTile	= (tileHeight + kBandRowCount - 1) / kBandRowCount;
+
+	// Any columns or rows left over when the frame does not divide evenly into tiles are black
+	if (tileWidth * m_gridSize < width)
+		fillRect(frame, rowBytes, tileWidth * m_gridSize, 0, (width - tileWidth * m_gridSize) & ~1u, height, kBlack);
+	if (tileHeight * m_gridSize < height)
+		fillRect(frame, rowBytes, 0, tileHeight * m_gridSize, width & ~1u, height - tileHeight * m_gridSize, kBlack);
+
+	parallelFor((unsigned)m_tiles.size() * m_bandsPerTile, [this](unsigned task) { scaleTileBand(task / m_bandsPerTile, task % m_bandsPerTile); });
+	parallelFor((unsigned)m_tiles.size(), [this](unsigned task) { drawTileOverlays(task); });
+}
+
+void MultiviewerRenderer::scaleTileBand(unsigned tileIndex, unsigned band)
+{
+	const TileRect&					tile = m_tiles[tileIndex];
+	const MultiviewerTileSource&	source = (*m_sources)[tileIndex];
+	uint32_t						startRow = band * kBandRowCount;
+	uint32_t						endRow = std::min(startRow + kBandRowCount, tile.height);
+
+	// Working buffers for bilinear scaling are kept by each thread, so that scaling does not allocate after the first frame
+	static thread_local BilinearTaps			taps = { 0, 0, {}, {} };
+	static thread_local std::vector<uint8_t>	blendedRow;
+
+	if (!source.pixels || !source.hasSignal || (source.width < 2) || (source.height < 1))
+	{
+		fillRect(m_frame, m_rowBytes, tile.x, tile.y + startRow, tile.width, endRow - startRow, kBlack);
+		return;
+	}
+
+	for (uint32_t row = startRow; row < endRow; row++)
+	{
+		uint8_t* output = m_frame + (size_t)(tile.y + row) * m_rowBytes + tile.x * 2;
+
+		if ((source.width == tile.width) && (source.height == tile.height))
+		{
+			memcpy(output, source.pixels + (size_t)row * source.rowBytes, tile.width * 2);
+		}
+		else if ((source.width == tile.width * 2) && (source.height == tile.height * 2))
+		{
+			const uint8_t* row0 = source.pixels + (size_t)row * 2 * source.rowBytes;
+			m_boxDownscaleFunction(row0, row0 + source.rowBytes, output, tile.width);
+		}
+		else
+		{
+			// Rows are sampled at pixel centres with 7-bit weights
+			int64_t		sourceY = ((int64_t)(2 * row + 1) * source.height * 128) / tile.height - 128;
+			uint32_t	y0 = (sourceY < 0) ? 0 : std::min((uint32_t)(sourceY >> 8), source.height - 1);
+			uint32_t	y1 = std::min(y0 + 1, source.height - 1);
+			unsigned	rowWeight = (sourceY < 0) ? 0 : (unsigned)(sourceY & 0xff) >> 1;
+
+			if ((taps.sourceWidth != source.width) || (taps.outputWidth != tile.width))
+				makeBilinearTaps(taps, source.width, tile.width);
+
+			blendedRow.resize(source.width * 2 + 4);
+			m_blendRowsFunction(source.pixels + (size_t)y0 * source.rowBytes, source.pixels + (size_t)y1 * source.rowBytes, rowWeight,
+					  blendedRow.data(), source.width * 2);
+			bilinearScaleRow(blendedRow.data(), taps, output);
+		}
+	}
+}
+
+void MultiviewerRenderer::drawTileOverlays(unsigned tileIndex)
+{
+	const TileRect&					tile = m_tiles[tileIndex];
+	const MultiviewerTileSource&	source = (*m_sources)[tileIndex];
+	AudioMeter&						meter = m_audioMeters[tileIndex];
+
+	// Sizes are multiples of an even scale so that every rectangle starts on a pixel pair
+	uint32_t	scale = std::max((tile.height / 180) & ~1u, 2u);
+	uint32_t	border = scale;
+	uint32_t	labelHeight = (kGlyphHeight + 4) * scale;
+
+	if ((tile.width < 16 * scale) || (tile.height < labelHeight + 4 * border))
+		return;
+
+	// Label along the bottom of the tile
+	uint32_t labelY = tile.y + tile.height - border - labelHeight;
+	darkenRect(m_frame, m_rowBytes, tile.x + border, labelY, tile.width - 2 * border, labelHeight);
+	drawText(m_frame, m_rowBytes, tile.x + border + 2 * scale, labelY + 2 * scale, tile.width - 2 * border - 4 * scale,
+			 source.label.c_str(), scale, kWhite);
+
+	if (!source.pixels || !source.hasSignal)
+	{
+		const char*	noSignal = "NO SIGNAL";
+		uint32_t	textScale = scale * 2;
+		uint32_t	textWidth = (uint32_t)strlen(noSignal) * kGlyphAdvance * textScale;
+
+		if (textWidth < tile.width)
+			drawText(m_frame, m_rowBytes, tile.x + ((tile.width - textWidth) / 2 & ~1u), tile.y + (tile.height - kGlyphHeight * textScale) / 2,
+					 textWidth, noSignal, textScale, kWhite);
+	}
+
+	// Audio meters on the right, above the label
+	unsigned	channelCount = std::min(source.audioChannelCount, MultiviewerTileSource::kMaxAudioChannels);
+	uint32_t	meterWidth = scale * 3;
+	uint32_t	meterHeight = tile.height / 2;
+	uint32_t	meterBottom = labelY - scale;
+
+	for (unsigned channel = 0; channel < channelCount; channel++)
+	{
+		uint32_t	meterX = tile.x + tile.width - border - scale - (channelCount - channel) * (meterWidth + scale);
+		float		peak = std::min(std::max(source.audioPeakLevels[channel], 0.0f), 1.0f);
+
+		meter.level[channel] = std::max(peak, meter.level[channel] * kAudioMeterDecay);
+
+		float		levelDb = (meter.level[channel] > 0.0f) ? 20.0f * log10f(meter.level[channel]) : -kAudioMeterRangeDb;
+		uint32_t	litHeight = (uint32_t)(std::min(std::max(levelDb + kAudioMeterRangeDb, 0.0f), kAudioMeterRangeDb) * meterHeight / kAudioMeterRangeDb);
+
+		fillRect(m_frame, m_rowBytes, meterX, meterBottom - meterHeight, meterWidth, meterHeight - litHeight, kDarkGrey);
+
+		// Green up to -18 dBFS, yellow up to -6 dBFS, red above
+		for (uint32_t row = meterHeight - litHeight; row < meterHeight; row++)
+		{
+			float rowDb = -kAudioMeterRangeDb * row / meterHeight;
+			fillRect(m_frame, m_rowBytes, meterX, meterBottom - meterHeight + row, meterWidth, 1,
+					 (rowDb > -6.0f) ? kRed : (rowDb > -18.0f) ? kYellow : kGreen);
+		}
+	}
+
+	// Tally border, or a black border to separate the tiles
+	const uint8_t* borderColour = (source.tally == TallyState::Program) ? kRed : (source.tally == TallyState::Preview) ? kGreen : kBlack;
+	uint32_t borderWidth = (source.tally == TallyState::None) ? border : border * 2;
+
+	fillRect(m_frame, m_rowBytes, tile.x, tile.y, tile.width, borderWidth, borderColour);
+	fillRect(m_frame, m_rowBytes, tile.x, tile.y + tile.height - borderWidth, tile.width, borderWidth, borderColour);
+	fillRect(m_frame, m_rowBytes, tile.x, tile.y, borderWidth, tile.height, borderColour);
+	fillRect(m_frame, m_rowBytes, tile.x + tile.width - borderWidth, tile.y, borderWidth, tile.height, borderColour);
+}
+
+// Worker pool, the calling thread runs tasks alongside the workers
+
+void MultiviewerRenderer::parallelFor(unsigned taskCount, const std::function<void(unsigned)>& task)
+{
+	m_task		= task;
+	m_taskCount	= taskCount;
+	m_nextTask	= 0;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_busyWorkers = (unsigned)m_workerThreads.size();
+		m_jobGeneration++;
+	}
+	m_workCondition.notify_all();
+
+	runTasks();
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_doneCondition.wait(lock, [&] { return m_busyWorkers == 0; });
+}
+
+void MultiviewerRenderer::runTasks()
+{
+	unsigned task;
+
+	while ((task = m_nextTask.fetch_add(1, std::memory_order_relaxed)) < m_taskCount)
+		m_task(task);
+}
+
+void MultiviewerRenderer::workerThread()
+{
+	uint64_t jobGeneration = 0;
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	while (true)
+	{
+		m_workCondition.wait(lock, [&] { return m_stopWorkers || m_jobGeneration != jobGeneration; });
+		if (m_stopWorkers)
+			break;
+
+		jobGeneration = m_jobGeneration;
+
+		lock.unlock();
+		runTasks();
+		lock.lock();
+
+		if (--m_busyWorkers == 0)
+			m_doneCondition.notify_all();
+	}
+}
@@ -0,0 +1,143 @@
+/* -LICENSE-START-
+** Copyright (c) 2022 Blackmagic Design
+**  
+** Permission is hereby granted, free of charge, to any person or organization 
+** obtaining a copy of the software and accompanying documentation (the 
+** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+** and transmit the Software, and to prepare derivative works of the Software, 
+** and to permit third-parties to whom the Software is furnished to do so, in 
+** accordance with:
+** 
+** (1) if the Software is obtained from Blackmagic Design, the End User License 
+** Agreement for the Software Development Kit (“EULA”) available at 
+** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+** 
+** (2) if the Software is obtained from any third party, such licensing terms 
+** as notified by that third party,
+** 
+** and all subject to the following:
+** 
+** (3) the copyright notices in the Software and this entire statement, 
+** including the above license grant, this restriction and the following 
+** disclaimer, must be included in all copies of the Software, in whole or in 
+** part, and all derivative works of the Software, unless such copies or 
+** derivative works are solely in the form of machine-executable object code 
+** generated by a source language processor.
+** 
+** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+** DEALINGS IN THE SOFTWARE.
+** 
+** A copy of the Software is available free of charge at 
+** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+** 
+** -LICENSE-END-
+*/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+
+enum class TallyState
+{
+	None,
+	Preview,
+	Program,
+};
+
+// Everything needed to draw one tile.  Pixels are 8-bit YUV (UYVY) and may be any size, they are scaled to fill
+// the tile.  When pixels is null or hasSignal is false the tile is drawn black with a "NO SIGNAL" label.
+struct MultiviewerTileSource
+{
+	static const unsigned	kMaxAudioChannels = 8;
+
+	const uint8_t*			pixels;
+	uint32_t				rowBytes;
+	uint32_t				width;
+	uint32_t				height;
+	bool					hasSignal;
+	std::string				label;
+	TallyState				tally;
+	unsigned				audioChannelCount;
+	float					audioPeakLevels[kMaxAudioChannels];		// Linear peak since the previous frame, 0.0 to 1.0
+};
+
+// The MultiviewerRenderer draws 4, 9 or 16 sources as a grid of tiles into an 8-bit YUV output frame.
+//
+// Sources are downscaled into their tiles by bands of rows on a pool of worker threads.  Exact 2:1 downscaling,
+// such as 1080p into the 16 tiles of a 2160p frame, uses AVX2 or NEON box filtering and 1:1 tiles are copied,
+// other sizes use bilinear scaling with SIMD blending of rows.  Labels, tally borders and audio meters are then drawn over each tile.
+class MultiviewerRenderer
+{
+public:
+	// threadCount includes the thread calling render(), 0 uses one thread per CPU
+	MultiviewerRenderer(unsigned tileCount, unsigned threadCount = 0);
+	virtual ~MultiviewerRenderer();
+
+	// sources must have getTileCount() entries
+	void					render(uint8_t* frame, uint32_t rowBytes, uint32_t width, uint32_t height, const std::vector<MultiviewerTileSource>& sources);
+
+	unsigned				getTileCount(void) const { return m_gridSize * m_gridSize; }
+	unsigned				getThreadCount(void) const { return (unsigned)m_workerThreads.size() + 1; }
+	const char*				getScalerKernelName(void) const;
+
+	static bool				isTileCountSupported(unsigned tileCount);
+
+private:
+	using BoxDownscaleFunction = void (*)(const uint8_t* row0, const uint8_t* row1, uint8_t* output, uint32_t outputPixelCount);
+	using BlendRowsFunction = void (*)(const uint8_t* row0, const uint8_t* row1, unsigned rowWeight, uint8_t* output, uint32_t byteCount);
+
+	struct TileRect
+	{
+		uint32_t			x;
+		uint32_t			y;
+		uint32_t			width;
+		uint32_t			height;
+	};
+
+	// Peak hold for each audio channel, decays between frames
+	struct AudioMeter
+	{
+		float				level[MultiviewerTileSource::kMaxAudioChannels];
+	};
+
+	unsigned							m_gridSize;
+	BoxDownscaleFunction				m_boxDownscaleFunction;
+	BlendRowsFunction					m_blendRowsFunction;
+	std::vector<AudioMeter>				m_audioMeters;
+	//
+	uint8_t*							m_frame;
+	uint32_t							m_rowBytes;
+	const std::vector<MultiviewerTileSource>*	m_sources;
+	std::vector<TileRect>				m_tiles;
+	uint32_t							m_bandsPerTile;
+	//
+	std::vector<std::thread>			m_workerThreads;
+	std::function<void(unsigned)>		m_task;
+	unsigned							m_taskCount;
+	std::atomic<unsigned>				m_nextTask;
+	std::mutex							m_mutex;
+	std::condition_variable				m_workCondition;
+	std::condition_variable				m_doneCondition;
+	uint64_t							m_jobGeneration;
+	unsigned							m_busyWorkers;
+	bool								m_stopWorkers;
+
+	void					parallelFor(unsigned taskCount, const std::function<void(unsigned)>& task);
+	void					runTasks(void);
+	void					workerThread(void);
+
+	void					scaleTileBand(unsigned tileIndex, unsigned band);
+	void					drawTileOverlays(unsigned tileIndex);
+};
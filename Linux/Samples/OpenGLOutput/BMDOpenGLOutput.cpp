@@ -43,18 +43,93 @@
 //
 
 #include "BMDOpenGLOutput.h"
+#include <stdio.h>
+#include <time.h>
 
-BMDOpenGLOutput::BMDOpenGLOutput()
-	: pFrameBuf(NULL), pDL(NULL), pDLOutput(NULL)
+// Number of rendered frames that can be in flight while being read back from the GPU,
+// set to 0 to read back each frame synchronously after rendering
+static const unsigned kReadbackPipelineDepth = 2;
+
+// Number of black frames scheduled before playback starts, this is the playout latency in frames
+static const unsigned kPrerollFrameCount = 3;
+
+// Number of output frames the render thread can fill ahead of the completion callback
+static const unsigned kRenderAheadFrameCount = 2;
+
+// Report errors in a message box when running with a GUI, otherwise to stderr
+static void ShowError(const char* title, const char* message)
+{
+	if (QApplication::instance() != NULL)
+		QMessageBox::critical(NULL, title, message);
+	else
+		fprintf(stderr, "%s %s\n", title, message);
+}
+
+static int64_t GetTimeNs()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (int64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+// Frame in host memory standing in for a DeckLink output frame when benchmarking without a device
+class HostVideoFrame : public IDeckLinkVideoFrame
+{
+private:
+	QAtomicInt	m_refCount;
+	long		m_width;
+	long		m_height;
+	void*		m_pBytes;
+
+public:
+	HostVideoFrame (long width, long height)
+		: m_refCount(1), m_width(width), m_height(height), m_pBytes(malloc(width * 4 * height)) {}
+	virtual ~HostVideoFrame () { free(m_pBytes); }
+
+	// IUnknown
+	virtual HRESULT	STDMETHODCALLTYPE	QueryInterface (REFIID /*iid*/, LPVOID *ppv) { *ppv = NULL; return E_NOINTERFACE; }
+	virtual ULONG	STDMETHODCALLTYPE	AddRef () { return (ULONG)(m_refCount.fetchAndAddAcquire(1) + 1); }
+	virtual ULONG	STDMETHODCALLTYPE	Release ()
+	{
+		int oldValue = m_refCount.fetchAndAddAcquire(-1);
+		if (oldValue == 1)
+			delete this;
+		return (ULONG)(oldValue - 1);
+	}
+
+	// IDeckLinkVideoFrame
+	virtual long			GetWidth () { return m_width; }
+	virtual long			GetHeight () { return m_height; }
+	virtual long			GetRowBytes () { return m_width * 4; }
+	virtual BMDPixelFormat	GetPixelFormat () { return bmdFormat8BitBGRA; }
+	virtual BMDFrameFlags	GetFlags () { return bmdFrameFlagFlipVertical; }
+	virtual HRESULT			GetBytes (void** buffer) { *buffer = m_pBytes; return S_OK; }
+	virtual HRESULT			GetTimecode (BMDTimecodeFormat /*format*/, IDeckLinkTimecode** /*timecode*/) { return S_FALSE; }
+	virtual HRESULT			GetAncillaryData (IDeckLinkVideoFrameAncillary** /*ancillary*/) { return S_FALSE; }
+};
+
+BMDOpenGLOutput::BMDOpenGLOutput(bool headless)
+	: pRenderDelegate(NULL), pRenderThread(NULL), pContext(NULL), pHeadlessContext(NULL), bContextValid(false),
+	  pReadback(NULL), uiFramesToSchedule(0), bStopRendering(false),
+	  renderTimeNs(0), readbackTimeNs(0), readbackWaitTimeNs(0), readbackCopyTimeNs(0),
+	  pDL(NULL), pDLOutput(NULL)
 {
-	QGLFormat fmt;
-	fmt.setRedBufferSize(8);
-	fmt.setGreenBufferSize(8);
-	fmt.setBlueBufferSize(8);
-	fmt.setAlphaBufferSize(8);
-	fmt.setDepthBufferSize(16);
-	pContext = new QGLWidget(fmt);
-	getGLExtensions().ResolveExtensions(pContext->context());
+	if (headless)
+	{
+		pHeadlessContext = new HeadlessGLContext();
+		bContextValid = pHeadlessContext->initialize() && getGLExtensions().ResolveExtensions(HeadlessGLContext::getProcAddress);
+	}
+	else
+	{
+		QGLFormat fmt;
+		fmt.setRedBufferSize(8);
+		fmt.setGreenBufferSize(8);
+		fmt.setBlueBufferSize(8);
+		fmt.setAlphaBufferSize(8);
+		fmt.setDepthBufferSize(16);
+		pContext = new QGLWidget(fmt);
+		bContextValid = getGLExtensions().ResolveExtensions(pContext->context());
+	}
 	pGLScene = new GLScene();
 }
 
@@ -81,41 +156,58 @@ BMDOpenGLOutput::~BMDOpenGLOutput()
 
 	delete pContext;
 	pContext = NULL;
+
+	delete pHeadlessContext;
+	pHeadlessContext = NULL;
+}
+
+bool BMDOpenGLOutput::MakeCurrent()
+{
+	if (pHeadlessContext != NULL)
+		return pHeadlessContext->makeCurrent();
+
+	pContext->makeCurrent();
+	return true;
+}
+
+void BMDOpenGLOutput::DoneCurrent()
+{
+	if (pHeadlessContext != NULL)
+		pHeadlessContext->doneCurrent();
+	else
+		pContext->doneCurrent();
 }
 
 void BMDOpenGLOutput::SetPreroll()
 {
 	IDeckLinkMutableVideoFrame* pDLVideoFrame = NULL;
+	void*						pFrame;
 
-	// Set 3 frame preroll
-	for (uint32_t i=0; i < 3; i++)
+	// Create the output frames that are rendered into and scheduled in turn.  The frames are owned by
+	// OutputFrames, ownership of the scheduled frames is shared with the DeckLink API.
+	for (uint32_t i=0; i < kPrerollFrameCount + kRenderAheadFrameCount; i++)
 	{
 		// Flip frame vertical, because OpenGL rendering starts from left bottom corner
 		if (pDLOutput->CreateVideoFrame(uiFrameWidth, uiFrameHeight, uiFrameWidth*4, bmdFormat8BitBGRA, bmdFrameFlagFlipVertical, &pDLVideoFrame) != S_OK)
-			goto bail;
+			return;
 
-		if (pDLOutput->ScheduleVideoFrame(pDLVideoFrame, (uiTotalFrames * frameDuration), frameDuration, frameTimescale) != S_OK)
-			goto bail;
+		OutputFrames.push_back(pDLVideoFrame);
 
-		/* The local reference to the IDeckLinkVideoFrame is released here, as the ownership has now been passed to
-		 *  the DeckLinkAPI via ScheduleVideoFrame.
-		 *
-		 * After the API has finished with the frame, it is returned to the application via ScheduledFrameCompleted.
-		 * In ScheduledFrameCompleted, this application updates the video frame and passes it to ScheduleVideoFrame,
-		 * returning ownership to the DeckLink API.
-		 */
-		pDLVideoFrame->Release();
-		pDLVideoFrame = NULL;
+		if (i >= kPrerollFrameCount)
+		{
+			// Frames not used for preroll are rendered into by the render thread
+			FreeFrameQueue.push_back(pDLVideoFrame);
+			continue;
+		}
 
-		uiTotalFrames++;
-	}
-	return;
+		// Preroll black frames
+		pDLVideoFrame->GetBytes(&pFrame);
+		memset(pFrame, 0, pDLVideoFrame->GetRowBytes() * uiFrameHeight);
 
-bail:
-	if (pDLVideoFrame)
-	{
-		pDLVideoFrame->Release();
-		pDLVideoFrame = NULL;
+		if (pDLOutput->ScheduleVideoFrame(pDLVideoFrame, (uiTotalFrames * frameDuration), frameDuration, frameTimescale) != S_OK)
+			return;
+
+		uiTotalFrames++;
 	}
 }
 
@@ -127,13 +219,13 @@ bool BMDOpenGLOutput::InitDeckLink()
 	pDLIterator = CreateDeckLinkIteratorInstance();
 	if (pDLIterator == NULL)
 	{
-		QMessageBox::critical(NULL,"This application requires the DeckLink drivers installed.", "Please install the Blackmagic DeckLink drivers to use the features of this application.");
+		ShowError("This application requires the DeckLink drivers installed.", "Please install the Blackmagic DeckLink drivers to use the features of this application.");
 		goto error;
 	}
 
 	if (pDLIterator->Next(&pDL) != S_OK)
 	{
-		QMessageBox::critical(NULL,"This application requires a DeckLink device.", "You will not be able to use the features of this application until a DeckLink device is installed.");
+		ShowError("This application requires a DeckLink device.", "You will not be able to use the features of this application until a DeckLink device is installed.");
 		goto error;
 	}
 	
@@ -194,13 +286,18 @@ bool BMDOpenGLOutput::InitOpenGL()
 	const GLubyte * strExt;
 	GLboolean isFBO;
 	
-	pContext->makeCurrent();
+	if (!bContextValid || !MakeCurrent())
+	{
+		ShowError("OpenGL initialization error.", "Cannot create OpenGL context.");
+		return false;
+	}
+
 	strExt = glGetString (GL_EXTENSIONS);
 	isFBO = gluCheckExtension ((const GLubyte*)"GL_EXT_framebuffer_object", strExt);
 	
 	if (!isFBO)
 	{
-		QMessageBox::critical(NULL,"OpenGL initialization error.", "OpenGL extention \"GL_EXT_framebuffer_object\" is not supported.");
+		ShowError("OpenGL initialization error.", "OpenGL extention \"GL_EXT_framebuffer_object\" is not supported.");
 		return false;
 	}
 
@@ -223,7 +320,7 @@ bool BMDOpenGLOutput::Start()
 	{
 		if (pDLDisplayModeIterator->Next(&pDLDisplayMode) != S_OK)
 		{
-			QMessageBox::critical(NULL,"DeckLink error.", "Cannot find video mode.");
+			ShowError("DeckLink error.", "Cannot find video mode.");
 			goto bail;
 		}
 	}
@@ -238,36 +335,19 @@ bool BMDOpenGLOutput::Start()
 		goto bail;
 	
 	uiTotalFrames = 0;
+	uiFramesToSchedule = 0;
 	
 	SetPreroll();
 
-	pContext->makeCurrent();
+	MakeCurrent();
 
 	pGLScene->InitScene();
 
-	glGenFramebuffersEXT(1, &idFrameBuf);
-	glGenRenderbuffersEXT(1, &idColorBuf);
-	glGenRenderbuffersEXT(1, &idDepthBuf);
-
-	glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, idFrameBuf);
-	
-	glBindRenderbufferEXT(GL_RENDERBUFFER_EXT, idColorBuf);
-	glRenderbufferStorageEXT(GL_RENDERBUFFER_EXT, GL_RGBA8, uiFrameWidth, uiFrameHeight);
-	glBindRenderbufferEXT(GL_RENDERBUFFER_EXT, idDepthBuf);
-	glRenderbufferStorageEXT(GL_RENDERBUFFER_EXT, GL_DEPTH_COMPONENT, uiFrameWidth, uiFrameHeight);
-
-	glFramebufferRenderbufferEXT(GL_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT, GL_RENDERBUFFER_EXT, idColorBuf);
-	glFramebufferRenderbufferEXT(GL_FRAMEBUFFER_EXT, GL_DEPTH_ATTACHMENT_EXT, GL_RENDERBUFFER_EXT, idDepthBuf);
-	
-	glStatus = glCheckFramebufferStatusEXT(GL_FRAMEBUFFER_EXT);
-	if (glStatus != GL_FRAMEBUFFER_COMPLETE_EXT)
-	{
-		QMessageBox::critical(NULL,"OpenGL initialization error.", "Cannot initialize framebuffer.");
+	if (!CreateFrameBuffer())
 		goto bail;
-	}
 
-	pFrameBuf = (char*)malloc((uiFrameWidth*4) * uiFrameHeight);
-	UpdateScene();
+	// The render thread fills the free output frames while the preroll frames play out
+	StartRenderThread();
 
 	pDLOutput->StartScheduledPlayback(0, 100, 1.0);
 	
@@ -294,54 +374,334 @@ bool BMDOpenGLOutput::Stop()
 {
 	pDLOutput->StopScheduledPlayback(0, NULL, 0);
 	pDLOutput->DisableVideoOutput();
-	
+
+	// The render thread releases the OpenGL resources before it exits
+	StopRenderThread();
+	ReleaseOutputFrames();
+
+	return true;
+}
+
+void BMDOpenGLOutput::StartRenderThread()
+{
+	pRenderThread = new RenderThread(this);
+
+	// The OpenGL context is only used by the render thread while it is running
+	DoneCurrent();
+#if QT_VERSION >= 0x050000
+	if (pContext != NULL)
+		pContext->context()->moveToThread(pRenderThread);
+#endif
+
+	bStopRendering = false;
+	pRenderThread->start();
+}
+
+void BMDOpenGLOutput::StopRenderThread()
+{
+	if (pRenderThread == NULL)
+		return;
+
 	Mutex.lock();
+	bStopRendering = true;
+	FrameQueueChanged.wakeAll();
+	Mutex.unlock();
+
+	pRenderThread->wait();
+
+	delete pRenderThread;
+	pRenderThread = NULL;
+}
+
+void BMDOpenGLOutput::ReleaseOutputFrames()
+{
+	Mutex.lock();
+
+	FreeFrameQueue.clear();
+	ReadyFrameQueue.clear();
+	BenchmarkScheduledQueue.clear();
+
+	for (std::vector<IDeckLinkVideoFrame*>::iterator it = OutputFrames.begin(); it != OutputFrames.end(); ++it)
+		(*it)->Release();
+	OutputFrames.clear();
+
+	Mutex.unlock();
+}
+
+// Create the off-screen frame buffer the scene is rendered to, and the buffers used to read it back
+bool BMDOpenGLOutput::CreateFrameBuffer()
+{
+	glGenFramebuffersEXT(1, &idFrameBuf);
+	glGenRenderbuffersEXT(1, &idColorBuf);
+	glGenRenderbuffersEXT(1, &idDepthBuf);
+
+	glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, idFrameBuf);
+	
+	glBindRenderbufferEXT(GL_RENDERBUFFER_EXT, idColorBuf);
+	glRenderbufferStorageEXT(GL_RENDERBUFFER_EXT, GL_RGBA8, uiFrameWidth, uiFrameHeight);
+	glBindRenderbufferEXT(GL_RENDERBUFFER_EXT, idDepthBuf);
+	glRenderbufferStorageEXT(GL_RENDERBUFFER_EXT, GL_DEPTH_COMPONENT, uiFrameWidth, uiFrameHeight);
+
+	glFramebufferRenderbufferEXT(GL_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT, GL_RENDERBUFFER_EXT, idColorBuf);
+	glFramebufferRenderbufferEXT(GL_FRAMEBUFFER_EXT, GL_DEPTH_ATTACHMENT_EXT, GL_RENDERBUFFER_EXT, idDepthBuf);
 	
+	glStatus = glCheckFramebufferStatusEXT(GL_FRAMEBUFFER_EXT);
+	if (glStatus != GL_FRAMEBUFFER_COMPLETE_EXT)
+	{
+		ShowError("OpenGL initialization error.", "Cannot initialize framebuffer.");
+		return false;
+	}
+
+	if (kReadbackPipelineDepth > 0)
+	{
+		pReadback = new ReadbackPipeline(kReadbackPipelineDepth);
+		if (! pReadback->initialize(uiFrameWidth, uiFrameHeight))
+		{
+			ShowError("OpenGL initialization error.", "Cannot initialize readback pixel buffers.");
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void BMDOpenGLOutput::DestroyFrameBuffer()
+{
 	glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, 0);
 
 	glDeleteRenderbuffersEXT(1, &idDepthBuf);
 	glDeleteRenderbuffersEXT(1, &idColorBuf);
 	glDeleteFramebuffersEXT(1, &idFrameBuf);
 
-	free(pFrameBuf);
-	pFrameBuf = NULL;
-
-	Mutex.unlock();
-	return true;
+	if (pReadback != NULL)
+	{
+		pReadback->cleanup();
+		delete pReadback;
+		pReadback = NULL;
+	}
 }
 
-void BMDOpenGLOutput::UpdateScene()
+void BMDOpenGLOutput::RenderLoop()
 {
+	IDeckLinkVideoFrame* pDLVideoFrame;
+
+	MakeCurrent();
+
 	Mutex.lock();
 
-	pContext->makeCurrent();
+	while (!bStopRendering)
+	{
+		if (FreeFrameQueue.empty())
+		{
+			FrameQueueChanged.wait(&Mutex);
+			continue;
+		}
+
+		pDLVideoFrame = FreeFrameQueue.front();
+		FreeFrameQueue.pop_front();
 
-	pGLScene->DrawScene(0, 0, uiFrameWidth, uiFrameHeight);
+		Mutex.unlock();
 
-	glReadPixels(0, 0, uiFrameWidth, uiFrameHeight, GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV, pFrameBuf);
+		RenderFrame(pDLVideoFrame);
+
+		Mutex.lock();
+
+		ReadyFrameQueue.push_back(pDLVideoFrame);
+		FrameQueueChanged.wakeAll();
+	}
 
 	Mutex.unlock();
+
+	DestroyFrameBuffer();
+	DoneCurrent();
+
+	// Hand the OpenGL context back to the thread owning its widget, only the thread a QObject lives in can move it
+#if QT_VERSION >= 0x050000
+	if (pContext != NULL)
+		pContext->context()->moveToThread(pContext->thread());
+#endif
+}
+
+// Render the next frame directly into the output frame memory
+void BMDOpenGLOutput::RenderFrame(IDeckLinkVideoFrame* pDLVideoFrame)
+{
+	void*		pFrame;
+	int64_t		stageTime;
+
+	pDLVideoFrame->GetBytes(&pFrame);
+
+	if (pReadback != NULL)
+	{
+		ReadbackPipeline::Statistics statistics;
+
+		// Keep the pipeline full, then copy out the oldest frame still being read back.
+		// The GPU renders and reads back the newer frames while the output frame is copied.
+		while (!pReadback->isFull())
+		{
+			stageTime = GetTimeNs();
+			pGLScene->DrawScene(0, 0, uiFrameWidth, uiFrameHeight);
+			renderTimeNs += GetTimeNs() - stageTime;
+
+			stageTime = GetTimeNs();
+			pReadback->beginReadback();
+			readbackTimeNs += GetTimeNs() - stageTime;
+		}
+
+		stageTime = GetTimeNs();
+		pReadback->completeReadback(pFrame, pDLVideoFrame->GetRowBytes(), true);
+		readbackTimeNs += GetTimeNs() - stageTime;
+
+		pReadback->getStatistics(statistics);
+		readbackWaitTimeNs += (int64_t)(statistics.lastWaitTimeMs * 1000000.0);
+		readbackCopyTimeNs += (int64_t)(statistics.lastCopyTimeMs * 1000000.0);
+	}
+	else
+	{
+		stageTime = GetTimeNs();
+		pGLScene->DrawScene(0, 0, uiFrameWidth, uiFrameHeight);
+		renderTimeNs += GetTimeNs() - stageTime;
+
+		stageTime = GetTimeNs();
+		glReadPixels(0, 0, uiFrameWidth, uiFrameHeight, GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV, pFrame);
+		readbackTimeNs += GetTimeNs() - stageTime;
+	}
 }
 
-void BMDOpenGLOutput::RenderToDevice(IDeckLinkVideoFrame* pDLVideoFrame)
+void BMDOpenGLOutput::ScheduleNextFrame(IDeckLinkVideoFrame* completedFrame, BMDOutputFrameCompletionResult result)
 {
+	IDeckLinkVideoFrame*	readyFrames[kPrerollFrameCount + kRenderAheadFrameCount];
+	uint32_t				readyFrameCount = 0;
+
+	// Return the completed frame to the render thread and take a rendered frame to replace it.  If the render
+	// thread fell behind, the missing frames are scheduled on a later callback once they have been rendered.
 	Mutex.lock();
 
-	void*	pFrame;
+	FreeFrameQueue.push_back(completedFrame);
+	uiFramesToSchedule++;
+
+	while (uiFramesToSchedule > 0 && !ReadyFrameQueue.empty())
+	{
+		readyFrames[readyFrameCount++] = ReadyFrameQueue.front();
+		ReadyFrameQueue.pop_front();
+		uiFramesToSchedule--;
+	}
+
+	FrameQueueChanged.wakeAll();
+	Mutex.unlock();
+
+	// If the last completed frame was late or dropped, bump the scheduled time further into the future
+	if (result == bmdOutputFrameDisplayedLate || result == bmdOutputFrameDropped)
+		uiTotalFrames += 2;
+
+	for (uint32_t i = 0; i < readyFrameCount; i++)
+	{
+		if (!ScheduleFrame(readyFrames[i]))
+		{
+			// Return the frame to the render thread so it stays in circulation
+			Mutex.lock();
+			FreeFrameQueue.push_back(readyFrames[i]);
+			uiFramesToSchedule++;
+			FrameQueueChanged.wakeAll();
+			Mutex.unlock();
+			continue;
+		}
+
+		uiTotalFrames++;
+	}
+}
+
+bool BMDOpenGLOutput::ScheduleFrame(IDeckLinkVideoFrame* pDLVideoFrame)
+{
+	// Without a DeckLink device, the frame completes immediately once it is played out by RunBenchmark()
+	if (pDLOutput == NULL)
+	{
+		BenchmarkScheduledQueue.push_back(pDLVideoFrame);
+		return true;
+	}
+
+	return pDLOutput->ScheduleVideoFrame(pDLVideoFrame, (uiTotalFrames * frameDuration), frameDuration, frameTimescale) == S_OK;
+}
+
+bool BMDOpenGLOutput::RunBenchmark(uint32_t width, uint32_t height, uint32_t frameCount)
+{
+	int64_t		callbackTimeNs = 0;
+	int64_t		callbackMaxTimeNs = 0;
+	int64_t		startTime;
+	int64_t		stageTime;
+	double		totalTimeSeconds;
+	const char*	rendererName;
+
+	if (!InitOpenGL())
+		return false;
 
-	pDLVideoFrame->GetBytes((void**)&pFrame);
+	rendererName = (const char*)glGetString(GL_RENDERER);
 
-	memcpy(pFrame, pFrameBuf, pDLVideoFrame->GetRowBytes() * uiFrameHeight);
+	uiFrameWidth = width;
+	uiFrameHeight = height;
+	uiTotalFrames = 0;
+	uiFramesToSchedule = 0;
 
-	if (pDLOutput->ScheduleVideoFrame(pDLVideoFrame, (uiTotalFrames * frameDuration), frameDuration, frameTimescale) != S_OK)
+	pGLScene->InitScene();
+
+	if (!CreateFrameBuffer())
 	{
+		DestroyFrameBuffer();
+		return false;
+	}
+
+	// Host memory frames stand in for the DeckLink output frames, the preroll frames are treated as scheduled
+	for (uint32_t i = 0; i < kPrerollFrameCount + kRenderAheadFrameCount; i++)
+	{
+		IDeckLinkVideoFrame* pFrame = new HostVideoFrame(uiFrameWidth, uiFrameHeight);
+
+		OutputFrames.push_back(pFrame);
+		if (i < kPrerollFrameCount)
+			BenchmarkScheduledQueue.push_back(pFrame);
+		else
+			FreeFrameQueue.push_back(pFrame);
+	}
+
+	startTime = GetTimeNs();
+
+	StartRenderThread();
+
+	for (uint32_t frame = 0; frame < frameCount; frame++)
+	{
+		IDeckLinkVideoFrame* completedFrame;
+
+		// Play out frames as soon as they are rendered, completing the oldest scheduled frame
+		Mutex.lock();
+		while (ReadyFrameQueue.empty())
+			FrameQueueChanged.wait(&Mutex);
+		completedFrame = BenchmarkScheduledQueue.front();
+		BenchmarkScheduledQueue.pop_front();
 		Mutex.unlock();
-		return;
+
+		stageTime = GetTimeNs();
+		ScheduleNextFrame(completedFrame, bmdOutputFrameCompleted);
+		stageTime = GetTimeNs() - stageTime;
+
+		callbackTimeNs += stageTime;
+		if (stageTime > callbackMaxTimeNs)
+			callbackMaxTimeNs = stageTime;
 	}
-	
-	uiTotalFrames++;
 
-	Mutex.unlock();
+	totalTimeSeconds = (GetTimeNs() - startTime) / 1000000000.0;
+
+	StopRenderThread();
+
+	// Frames rendered ahead of the last completed frame are included in the stage timings
+	printf("Rendered %u frames at %ux%u in %.3f seconds using %s: %.1f frames/s\n",
+			frameCount, uiFrameWidth, uiFrameHeight, totalTimeSeconds, rendererName, frameCount / totalTimeSeconds);
+	printf("  Readback pipeline depth:  %u\n", kReadbackPipelineDepth);
+	printf("  Render:                   %.3f ms/frame\n", renderTimeNs / 1000000.0 / frameCount);
+	printf("  Readback:                 %.3f ms/frame (fence wait %.3f ms, buffer copy %.3f ms)\n",
+			readbackTimeNs / 1000000.0 / frameCount, readbackWaitTimeNs / 1000000.0 / frameCount, readbackCopyTimeNs / 1000000.0 / frameCount);
+	printf("  Completion callback:      %.3f us/frame (max %.3f us)\n", callbackTimeNs / 1000.0 / frameCount, callbackMaxTimeNs / 1000.0);
+
+	ReleaseOutputFrames();
+
+	return true;
 }
 
 ////////////////////////////////////////////
@@ -380,9 +740,9 @@ ULONG RenderDelegate::Release ()
 	return (ULONG)(oldValue - 1);
 }
 
-HRESULT	RenderDelegate::ScheduledFrameCompleted (IDeckLinkVideoFrame* completedFrame, BMDOutputFrameCompletionResult /*result*/)
+HRESULT	RenderDelegate::ScheduledFrameCompleted (IDeckLinkVideoFrame* completedFrame, BMDOutputFrameCompletionResult result)
 {
-	m_pOwner->RenderToDevice(completedFrame);
+	m_pOwner->ScheduleNextFrame(completedFrame, result);
 	return S_OK;
 }
 
@@ -46,24 +46,50 @@
 #define __BMDOpenGLOutput_h__
 
 #include <QtOpenGL>
+#include <QThread>
+#include <QWaitCondition>
 #include <GL/glu.h>
+#include <deque>
+#include <vector>
 #include "GLExtensions.h"
 
 #include "DeckLinkAPI.h"
 #include "GLScene.h"
+#include "ReadbackPipeline.h"
+#include "HeadlessGLContext.h"
 
 class RenderDelegate;
+class RenderThread;
 
 class BMDOpenGLOutput
 {
 private:
 	RenderDelegate*		pRenderDelegate;
+	RenderThread*		pRenderThread;
 	QGLWidget*			pContext;
-	QMutex				Mutex;
+	HeadlessGLContext*	pHeadlessContext;
+	bool				bContextValid;
 	GLScene*			pGLScene;
 	GLenum				glStatus;
 	GLuint				idFrameBuf, idColorBuf, idDepthBuf;
-	char*				pFrameBuf;
+	ReadbackPipeline*	pReadback;
+
+	// Output frames are rendered into by the render thread, then scheduled by the completion callback.
+	// Mutex protects the frame queues, FrameQueueChanged is signalled whenever a frame is added to either queue.
+	QMutex								Mutex;
+	QWaitCondition						FrameQueueChanged;
+	std::vector<IDeckLinkVideoFrame*>	OutputFrames;
+	std::deque<IDeckLinkVideoFrame*>	FreeFrameQueue;
+	std::deque<IDeckLinkVideoFrame*>	ReadyFrameQueue;
+	std::deque<IDeckLinkVideoFrame*>	BenchmarkScheduledQueue;		// stands in for the DeckLink output in RunBenchmark()
+	uint32_t							uiFramesToSchedule;				// completed frames not yet replaced by a rendered frame
+	bool								bStopRendering;
+
+	// Render thread stage timings, used by RunBenchmark()
+	int64_t				renderTimeNs;
+	int64_t				readbackTimeNs;
+	int64_t				readbackWaitTimeNs;
+	int64_t				readbackCopyTimeNs;
 
 	// DeckLink
 	uint32_t					uiFrameWidth;
@@ -78,9 +104,19 @@ private:
 	uint32_t					uiTotalFrames;
 
 	void SetPreroll();
+	bool MakeCurrent();
+	void DoneCurrent();
+	bool CreateFrameBuffer();
+	void DestroyFrameBuffer();
+	void StartRenderThread();
+	void StopRenderThread();
+	void ReleaseOutputFrames();
+	void RenderFrame(IDeckLinkVideoFrame* pDLVideoFrame);
+	bool ScheduleFrame(IDeckLinkVideoFrame* pDLVideoFrame);
 
 public:
-	BMDOpenGLOutput();
+	// A headless output renders through an EGL context, without requiring a display or a QApplication
+	BMDOpenGLOutput(bool headless = false);
 	~BMDOpenGLOutput();
 
 	bool InitDeckLink();
@@ -89,10 +125,32 @@ public:
 	uint32_t GetFPS();
 
 	bool Start();
-	void UpdateScene();
 	bool Stop();
 
-	void RenderToDevice(IDeckLinkVideoFrame* pDLVideoFrame);
+	// Called on the render thread, renders into free output frames until Stop()
+	void RenderLoop();
+
+	// Called from the completion callback, returns the completed frame for rendering and schedules rendered frames
+	void ScheduleNextFrame(IDeckLinkVideoFrame* completedFrame, BMDOutputFrameCompletionResult result);
+
+	// Render and read back frames as fast as possible without a DeckLink device, reporting frames/s and stage timings
+	bool RunBenchmark(uint32_t width, uint32_t height, uint32_t frameCount);
+};
+
+////////////////////////////////////////////
+// Render Thread Class
+////////////////////////////////////////////
+
+class RenderThread : public QThread
+{
+private:
+	BMDOpenGLOutput*	m_pOwner;
+
+public:
+	RenderThread (BMDOpenGLOutput* pOwner) : m_pOwner(pOwner) {}
+
+protected:
+	virtual void run () { m_pOwner->RenderLoop(); }
 };
 
 ////////////////////////////////////////////
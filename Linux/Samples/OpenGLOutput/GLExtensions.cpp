@@ -44,18 +44,40 @@
 
 #include "GLExtensions.h"
 
+static const QGLContext* sResolveContext = NULL;
+
+static void* GetQGLContextProcAddress(const char *name)
+{
+	return (void*)sResolveContext->getProcAddress(QLatin1String(name));
+}
+
 bool GLExtensions::ResolveExtensions(const QGLContext *context)
 {
-	pGenFramebuffersEXT = (BMD_glGenFramebuffersEXT) context->getProcAddress(QLatin1String("glGenFramebuffersEXT"));
-	pGenRenderbuffersEXT = (BMD_glGenRenderbuffersEXT) context->getProcAddress(QLatin1String("glGenRenderbuffersEXT"));
-	pBindRenderbufferEXT = (BMD_glBindRenderbufferEXT) context->getProcAddress(QLatin1String("glBindRenderbufferEXT"));
-	pRenderbufferStorageEXT = (BMD_glRenderbufferStorageEXT) context->getProcAddress(QLatin1String("glRenderbufferStorageEXT"));
-	pDeleteFramebuffersEXT = (BMD_glDeleteFramebuffersEXT) context->getProcAddress(QLatin1String("glDeleteFramebuffersEXT"));
-	pDeleteRenderbuffersEXT = (BMD_glDeleteRenderbuffersEXT) context->getProcAddress(QLatin1String("glDeleteRenderbuffersEXT"));
-	pBindFramebufferEXT = (BMD_glBindFramebufferEXT) context->getProcAddress(QLatin1String("glBindFramebufferEXT"));
-	pFramebufferTexture2DEXT = (BMD_glFramebufferTexture2DEXT) context->getProcAddress(QLatin1String("glFramebufferTexture2DEXT"));
-	pFramebufferRenderbufferEXT = (BMD_glFramebufferRenderbufferEXT) context->getProcAddress(QLatin1String("glFramebufferRenderbufferEXT"));
-	pCheckFramebufferStatusEXT = (BMD_glCheckFramebufferStatusEXT) context->getProcAddress(QLatin1String("glCheckFramebufferStatusEXT"));
+	sResolveContext = context;
+	return ResolveExtensions(GetQGLContextProcAddress);
+}
+
+bool GLExtensions::ResolveExtensions(GLProcAddressFunction getProcAddress)
+{
+	pGenFramebuffersEXT = (BMD_glGenFramebuffersEXT) getProcAddress("glGenFramebuffersEXT");
+	pGenRenderbuffersEXT = (BMD_glGenRenderbuffersEXT) getProcAddress("glGenRenderbuffersEXT");
+	pBindRenderbufferEXT = (BMD_glBindRenderbufferEXT) getProcAddress("glBindRenderbufferEXT");
+	pRenderbufferStorageEXT = (BMD_glRenderbufferStorageEXT) getProcAddress("glRenderbufferStorageEXT");
+	pDeleteFramebuffersEXT = (BMD_glDeleteFramebuffersEXT) getProcAddress("glDeleteFramebuffersEXT");
+	pDeleteRenderbuffersEXT = (BMD_glDeleteRenderbuffersEXT) getProcAddress("glDeleteRenderbuffersEXT");
+	pBindFramebufferEXT = (BMD_glBindFramebufferEXT) getProcAddress("glBindFramebufferEXT");
+	pFramebufferTexture2DEXT = (BMD_glFramebufferTexture2DEXT) getProcAddress("glFramebufferTexture2DEXT");
+	pFramebufferRenderbufferEXT = (BMD_glFramebufferRenderbufferEXT) getProcAddress("glFramebufferRenderbufferEXT");
+	pCheckFramebufferStatusEXT = (BMD_glCheckFramebufferStatusEXT) getProcAddress("glCheckFramebufferStatusEXT");
+	pGenBuffers = (BMD_glGenBuffers) getProcAddress("glGenBuffers");
+	pDeleteBuffers = (BMD_glDeleteBuffers) getProcAddress("glDeleteBuffers");
+	pBindBuffer = (BMD_glBindBuffer) getProcAddress("glBindBuffer");
+	pBufferData = (BMD_glBufferData) getProcAddress("glBufferData");
+	pMapBufferRange = (BMD_glMapBufferRange) getProcAddress("glMapBufferRange");
+	pUnmapBuffer = (BMD_glUnmapBuffer) getProcAddress("glUnmapBuffer");
+	pFenceSync = (BMD_glFenceSync) getProcAddress("glFenceSync");
+	pClientWaitSync = (BMD_glClientWaitSync) getProcAddress("glClientWaitSync");
+	pDeleteSync = (BMD_glDeleteSync) getProcAddress("glDeleteSync");
 
 	return glGenFramebuffersEXT
 			&& glGenRenderbuffersEXT
@@ -66,5 +88,14 @@ bool GLExtensions::ResolveExtensions(const QGLContext *context)
 			&& glBindFramebufferEXT
 			&& glFramebufferTexture2DEXT
 			&& glFramebufferRenderbufferEXT
-			&& glCheckFramebufferStatusEXT;
+			&& glCheckFramebufferStatusEXT
+			&& glGenBuffers
+			&& glDeleteBuffers
+			&& glBindBuffer
+			&& glBufferData
+			&& glMapBufferRange
+			&& glUnmapBuffer
+			&& glFenceSync
+			&& glClientWaitSync
+			&& glDeleteSync;
 }
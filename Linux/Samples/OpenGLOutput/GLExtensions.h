@@ -68,6 +68,25 @@
 #define GL_COLOR_ATTACHMENT0_EXT	0x8CE0
 #define GL_DEPTH_ATTACHMENT_EXT		0x8D00
 
+#ifndef GL_PIXEL_PACK_BUFFER
+#define GL_PIXEL_PACK_BUFFER			0x88EB
+#endif
+#ifndef GL_STREAM_READ
+#define GL_STREAM_READ					0x88E1
+#endif
+#ifndef GL_MAP_READ_BIT
+#define GL_MAP_READ_BIT					0x0001
+#endif
+#ifndef GL_SYNC_GPU_COMMANDS_COMPLETE
+#define GL_SYNC_GPU_COMMANDS_COMPLETE	0x9117
+#define GL_ALREADY_SIGNALED				0x911A
+#define GL_TIMEOUT_EXPIRED				0x911B
+#define GL_CONDITION_SATISFIED			0x911C
+#define GL_WAIT_FAILED					0x911D
+#define GL_SYNC_FLUSH_COMMANDS_BIT		0x00000001
+#define GL_TIMEOUT_IGNORED				0xFFFFFFFFFFFFFFFFull
+#endif
+
 typedef void (APIENTRY *BMD_glGenFramebuffersEXT) (GLsizei, GLuint *);
 typedef void (APIENTRY *BMD_glGenRenderbuffersEXT) (GLsizei, GLuint *);
 typedef void (APIENTRY *BMD_glBindRenderbufferEXT) (GLenum, GLuint);
@@ -78,10 +97,22 @@ typedef void (APIENTRY *BMD_glBindFramebufferEXT) (GLenum, GLuint);
 typedef void (APIENTRY *BMD_glFramebufferTexture2DEXT) (GLenum, GLenum, GLenum, GLuint, GLint);
 typedef void (APIENTRY *BMD_glFramebufferRenderbufferEXT) (GLenum, GLenum, GLenum, GLuint);
 typedef GLenum (APIENTRY *BMD_glCheckFramebufferStatusEXT) (GLenum);
+typedef void (APIENTRY *BMD_glGenBuffers) (GLsizei, GLuint *);
+typedef void (APIENTRY *BMD_glDeleteBuffers) (GLsizei, const GLuint *);
+typedef void (APIENTRY *BMD_glBindBuffer) (GLenum, GLuint);
+typedef void (APIENTRY *BMD_glBufferData) (GLenum, GLsizeiptr, const GLvoid *, GLenum);
+typedef void* (APIENTRY *BMD_glMapBufferRange) (GLenum, GLintptr, GLsizeiptr, GLbitfield);
+typedef GLboolean (APIENTRY *BMD_glUnmapBuffer) (GLenum);
+typedef GLsync (APIENTRY *BMD_glFenceSync) (GLenum, GLbitfield);
+typedef GLenum (APIENTRY *BMD_glClientWaitSync) (GLsync, GLbitfield, GLuint64);
+typedef void (APIENTRY *BMD_glDeleteSync) (GLsync);
+
+typedef void* (*GLProcAddressFunction) (const char *name);
 
 struct GLExtensions
 {
 	bool ResolveExtensions(const QGLContext *context);
+	bool ResolveExtensions(GLProcAddressFunction getProcAddress);
 
 	BMD_glGenFramebuffersEXT pGenFramebuffersEXT;
 	BMD_glGenRenderbuffersEXT pGenRenderbuffersEXT;
@@ -93,6 +124,15 @@ struct GLExtensions
 	BMD_glFramebufferTexture2DEXT pFramebufferTexture2DEXT;
 	BMD_glFramebufferRenderbufferEXT pFramebufferRenderbufferEXT;
 	BMD_glCheckFramebufferStatusEXT pCheckFramebufferStatusEXT;
+	BMD_glGenBuffers pGenBuffers;
+	BMD_glDeleteBuffers pDeleteBuffers;
+	BMD_glBindBuffer pBindBuffer;
+	BMD_glBufferData pBufferData;
+	BMD_glMapBufferRange pMapBufferRange;
+	BMD_glUnmapBuffer pUnmapBuffer;
+	BMD_glFenceSync pFenceSync;
+	BMD_glClientWaitSync pClientWaitSync;
+	BMD_glDeleteSync pDeleteSync;
 };
 
 inline GLExtensions &getGLExtensions()
@@ -111,6 +151,15 @@ inline GLExtensions &getGLExtensions()
 #define glFramebufferTexture2DEXT getGLExtensions().pFramebufferTexture2DEXT
 #define glFramebufferRenderbufferEXT getGLExtensions().pFramebufferRenderbufferEXT
 #define glCheckFramebufferStatusEXT getGLExtensions().pCheckFramebufferStatusEXT
+#define glGenBuffers getGLExtensions().pGenBuffers
+#define glDeleteBuffers getGLExtensions().pDeleteBuffers
+#define glBindBuffer getGLExtensions().pBindBuffer
+#define glBufferData getGLExtensions().pBufferData
+#define glMapBufferRange getGLExtensions().pMapBufferRange
+#define glUnmapBuffer getGLExtensions().pUnmapBuffer
+#define glFenceSync getGLExtensions().pFenceSync
+#define glClientWaitSync getGLExtensions().pClientWaitSync
+#define glDeleteSync getGLExtensions().pDeleteSync
 
 #endif // __GLExtensions_h__
 
@@ -159,7 +159,7 @@ void GLScene::DrawScene(GLint x, GLint y, GLsizei w, GLsizei h)
 	glVertex3f(  1.0f, -1.0f, -1.0f );   // Bottom right of right side
 	glEnd();                             // Quads are complete
 	
-	glFinish();
+	// No glFinish() here, the readback of the frame waits for rendering to complete
 	
 	flRtri += 0.8f;     // Increase the rotation variable for the triangle
 	flRquad -= 0.60f;   // Decrease the rotation variable for the quad
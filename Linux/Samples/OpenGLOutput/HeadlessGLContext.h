@@ -0,0 +1,73 @@
+/* -LICENSE-START-
+ ** Copyright (c) 2022 Blackmagic Design
+ **  
+ ** Permission is hereby granted, free of charge, to any person or organization 
+ ** obtaining a copy of the software and accompanying documentation (the 
+ ** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+ ** and transmit the Software, and to prepare derivative works of the Software, 
+ ** and to permit third-parties to whom the Software is furnished to do so, in 
+ ** accordance with:
+ ** 
+ ** (1) if the Software is obtained from Blackmagic Design, the End User License 
+ ** Agreement for the Software Development Kit (“EULA”) available at 
+ ** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+ ** 
+ ** (2) if the Software is obtained from any third party, such licensing terms 
+ ** as notified by that third party,
+ ** 
+ ** and all subject to the following:
+ ** 
+ ** (3) the copyright notices in the Software and this entire statement, 
+ ** including the above license grant, this restriction and the following 
+ ** disclaimer, must be included in all copies of the Software, in whole or in 
+ ** part, and all derivative works of the Software, unless such copies or 
+ ** derivative works are solely in the form of machine-executable object code 
+ ** generated by a source language processor.
+ ** 
+ ** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ ** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ ** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+ ** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+ ** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+ ** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ ** DEALINGS IN THE SOFTWARE.
+ ** 
+ ** A copy of the Software is available free of charge at 
+ ** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+ ** 
+ ** -LICENSE-END-
+ */
+//
+// HeadlessGLContext.h
+// OpenGLOutput
+//
+
+#ifndef __HEADLESS_GL_CONTEXT_H__
+#define __HEADLESS_GL_CONTEXT_H__
+
+#include <EGL/egl.h>
+
+// OpenGL context created through EGL without a window system, for use on systems without a display.
+// The Mesa surfaceless platform and a surfaceless context are used when supported (eg. llvmpipe),
+// otherwise a small pbuffer surface is created.  All rendering should be to a framebuffer object.
+class HeadlessGLContext
+{
+public:
+	HeadlessGLContext();
+	~HeadlessGLContext();
+
+	bool initialize();
+	bool makeCurrent();
+	void doneCurrent();
+
+	bool isSurfaceless() const { return mSurface == EGL_NO_SURFACE; }
+
+	static void* getProcAddress(const char* name);
+
+private:
+	EGLDisplay		mDisplay;
+	EGLContext		mContext;
+	EGLSurface		mSurface;
+};
+
+#endif	// __HEADLESS_GL_CONTEXT_H__
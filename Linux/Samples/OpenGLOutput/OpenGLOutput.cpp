@@ -70,26 +70,12 @@ OpenGLOutput::OpenGLOutput()
 	if (!pOpenGLOutput->InitOpenGL())
 		exit(0);
 
-	pTimer = new QTimer(this);
-	connect(pTimer, SIGNAL(timeout()), this, SLOT(OnTimer()));
-
 	setWindowTitle("OpenGLOutput");
 	show();
 }
 
-void OpenGLOutput::OnTimer()
-{
-	pOpenGLOutput->UpdateScene();
-}
-
 OpenGLOutput::~OpenGLOutput()
 {
-	if (pTimer)
-	{
-		pTimer->stop();
-		delete pTimer;
-	}
-
 	if (pOpenGLOutput)
 	{
 		pOpenGLOutput->Stop();
@@ -111,9 +97,9 @@ void OpenGLOutput::start()
 {
 	if (pOpenGLOutput != NULL)
 	{
+		// Frames are rendered on a separate thread as the scheduled frames complete
 		if (!pOpenGLOutput->Start())
 			exit(0);
-		pTimer->start(1000 / pOpenGLOutput->GetFPS());
 	}
 }
 
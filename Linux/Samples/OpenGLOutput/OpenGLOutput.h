@@ -51,7 +51,6 @@
 #include <QWidget>
 #include <QGLWidget>
 #include <QGridLayout>
-#include <QTimer>
 
 #include "ui_OpenGLOutput.h"
 #include "BMDOpenGLOutput.h"
@@ -69,15 +68,11 @@ public:
 
 	void start();
 
-public slots:
-	void OnTimer();
-
 private:
 	Ui::OpenGLOutputDialog*	ui;
 	QGridLayout*			layout;
 	CDeckLinkGLWidget*		previewView;
 	BMDOpenGLOutput*		pOpenGLOutput;
-	QTimer*					pTimer;
 };
 
 #endif // __OPENGLOUTPUT_H__
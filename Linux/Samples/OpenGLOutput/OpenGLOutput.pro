@@ -3,19 +3,23 @@ LANGUAGE  	= C++
 CONFIG		+= qt opengl
 QT			+= opengl
 INCLUDEPATH =	../../include 
-LIBS		+= -lGLU -ldl
+LIBS		+= -lGLU -lEGL -ldl
 
 HEADERS 	=	OpenGLOutput.h \
     CDeckLinkGLWidget.h \
     BMDOpenGLOutput.h \
     GLScene.h \
-    GLExtensions.h
+    GLExtensions.h \
+    ReadbackPipeline.h \
+    HeadlessGLContext.h
 SOURCES 	= 	main.cpp \
             	../../include/DeckLinkAPIDispatch.cpp \
             	OpenGLOutput.cpp \
     CDeckLinkGLWidget.cpp \
     BMDOpenGLOutput.cpp \
     GLScene.cpp \
-    GLExtensions.cpp
+    GLExtensions.cpp \
+    ReadbackPipeline.cpp \
+    HeadlessGLContext.cpp
 
 FORMS 		= 	OpenGLOutput.ui
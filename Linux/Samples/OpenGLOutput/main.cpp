@@ -43,10 +43,95 @@
 //
 
 #include <QApplication>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 #include "OpenGLOutput.h"
 
+static volatile sig_atomic_t	gStopHeadless = 0;
+
+static void	StopHeadless(int)
+{
+	gStopHeadless = 1;
+}
+
+static void	PrintUsage(const char* name)
+{
+	printf("%s [options]\n"
+		   "\n"
+		   "Options:\n"
+		   "    -h, --help                Display this help message\n"
+		   "    -n, --headless            Play out without a display, rendering through an EGL context\n"
+		   "    -b, --benchmark <frames>  Render and read back <frames> as fast as possible without a DeckLink device\n"
+		   "    -s, --size <w>x<h>        Frame size for benchmark mode (default 1920x1080)\n", name);
+}
+
+// Play out using a headless OpenGL context, without a QApplication, until interrupted
+static int	RunHeadless()
+{
+	BMDOpenGLOutput		openGLOutput(true);
+
+	if (!openGLOutput.InitDeckLink() || !openGLOutput.InitOpenGL() || !openGLOutput.Start())
+		return 1;
+
+	signal(SIGINT, StopHeadless);
+	signal(SIGTERM, StopHeadless);
+
+	printf("Playing out headless, press Ctrl+C to stop\n");
+
+	// Frames are rendered on the output's render thread as the scheduled frames complete
+	while (!gStopHeadless)
+		usleep(100000);
+
+	openGLOutput.Stop();
+	return 0;
+}
+
 int main(int argc, char *argv[])
 {
+	bool		headless = false;
+	uint32_t	benchmarkFrames = 0;
+	uint32_t	benchmarkWidth = 1920;
+	uint32_t	benchmarkHeight = 1080;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--headless") == 0 || strcmp(argv[i], "-n") == 0)
+			headless = true;
+		else if ((strcmp(argv[i], "--benchmark") == 0 || strcmp(argv[i], "-b") == 0) && (i + 1 < argc))
+			benchmarkFrames = (uint32_t)strtoul(argv[++i], NULL, 10);
+		else if ((strcmp(argv[i], "--size") == 0 || strcmp(argv[i], "-s") == 0) && (i + 1 < argc))
+		{
+			if (sscanf(argv[++i], "%ux%u", &benchmarkWidth, &benchmarkHeight) != 2)
+			{
+				fprintf(stderr, "Invalid frame size: %s\n", argv[i]);
+				return 1;
+			}
+		}
+		else if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0)
+		{
+			PrintUsage(argv[0]);
+			return 0;
+		}
+		else
+		{
+			fprintf(stderr, "Unknown argument: %s\n", argv[i]);
+			PrintUsage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (benchmarkFrames > 0)
+	{
+		BMDOpenGLOutput openGLOutput(true);
+		return openGLOutput.RunBenchmark(benchmarkWidth, benchmarkHeight, benchmarkFrames) ? 0 : 1;
+	}
+
+	if (headless)
+		return RunHeadless();
+
 	QApplication app(argc, argv);
 	if (!QGLFormat::hasOpenGL() || !QGLPixelBuffer::hasOpenGLPbuffers()) {
 		QMessageBox::critical(0, "OpenGL pbuffers",
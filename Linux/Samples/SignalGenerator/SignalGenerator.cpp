@@ -40,6 +40,7 @@
 
 #include "SignalGenerator.h"
 #include "SignalGeneratorEvents.h"
+#include "AsyncLogger.h"
 #include "DeckLinkOutputDevice.h"
 #include "DeckLinkDeviceDiscovery.h"
 #include "DeckLinkOpenGLWidget.h"
@@ -65,6 +66,9 @@ static uint32_t gHD75pcColourBars[8] =
 	0x3fcc3fc1, 0x33d4336d, 0x1c781cd4, 0x10801080
 };
 
+// Output frame messages are printed from the scheduled frame completion thread, defer formatting to logger thread
+static AsyncLogger gLogger;
+
 // Audio channels supported
 static const int gAudioChannels[] = { 2, 8, 16 };
 
@@ -716,7 +720,7 @@ void SignalGenerator::scheduleNextFrame(bool prerolling)
 		}
 	}
 
-	printf("Output frame: %02d:%02d:%02d:%03d\n", timeCode->hours(), timeCode->minutes(), timeCode->seconds(), timeCode->frames());
+	gLogger.log("Output frame: %02d:%02d:%02d:%03d\n", timeCode->hours(), timeCode->minutes(), timeCode->seconds(), timeCode->frames());
 
 	result = deckLinkOutput->ScheduleVideoFrame(currentFrame.get(), (totalFramesScheduled * frameDuration), frameDuration, frameTimescale);
 	if (result != S_OK)
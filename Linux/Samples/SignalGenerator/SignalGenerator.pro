@@ -22,6 +22,7 @@ DEFINES += QT_DEPRECATED_WARNINGS
 
 HEADERS 	=	SignalGenerator.h \
 				SignalGeneratorEvents.h \
+				AsyncLogger.h \
 				com_ptr.h \
 				DeckLinkDeviceDiscovery.h \
 				DeckLinkOutputDevice.h \
@@ -30,6 +31,7 @@ HEADERS 	=	SignalGenerator.h \
 
 SOURCES 	= 	main.cpp \
 				../../include/DeckLinkAPIDispatch.cpp \
+				AsyncLogger.cpp \
 				DeckLinkDeviceDiscovery.cpp \
 				DeckLinkOutputDevice.cpp \
 				DeckLinkOpenGLWidget.cpp \
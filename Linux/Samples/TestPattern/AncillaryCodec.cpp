@@ -0,0 +1,539 @@
+/* -LICENSE-START-
+** Copyright (c) 2022 Blackmagic Design
+**  
+** Permission is hereby granted, free of charge, to any person or organization 
+** obtaining a copy of the software and accompanying documentation (the 
+** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+** and transmit the Software, and to prepare derivative works of the Software, 
+** and to permit third-parties to whom the Software is furnished to do so, in 
+** accordance with:
+** 
+** (1) if the Software is obtained from Blackmagic Design, the End User License 
+** Agreement for the Software Development Kit (“EULA”) available at 
+** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+** 
+** (2) if the Software is obtained from any third party, such licensing terms 
+** as notified by that third party,
+** 
+** and all subject to the following:
+** 
+** (3) the copyright notices in the Software and this entire statement, 
+** including the above license grant, this restriction and the following 
+** disclaimer, must be included in all copies of the Software, in whole or in 
+** part, and all derivative works of the Software, unless such copies or 
+** derivative works are solely in the form of machine-executable object code 
+** generated by a source language processor.
+** 
+** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+** DEALINGS IN THE SOFTWARE.
+** 
+** A copy of the Software is available free of charge at 
+** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+** 
+** -LICENSE-END-
+*/
+
+#include <string.h>
+#include "AncillaryCodec.h"
+
+// SMPTE 2010 payload_descriptor, version 1 in a single packet
+static const uint8_t	kSCTE104PayloadDescriptor	= 0x08;
+
+// SCTE 104 multiple_operation_message header up to and including num_ops, without the timestamp data
+static const size_t		kSCTE104HeaderSize			= 12;
+static const size_t		kSCTE104OperationHeaderSize	= 4;
+static const size_t		kSCTE104SpliceRequestSize	= 14;
+
+// Size of the SCTE 104 timestamp() data for each time_type
+static const uint8_t	kSCTE104TimestampSizes[4]	= { 0, 6, 4, 2 };
+
+static const uint32_t	kAFDBarDataSize				= 8;
+static const uint32_t	kPayloadIdentifierSize		= 4;
+static const uint32_t	kTimecodeSize				= 16;
+
+typedef bool (*AncillaryEncodeFunction)(const AncillaryPayload& payload, AncillaryPacketBuffer* packet);
+typedef bool (*AncillaryDecodeFunction)(const uint8_t* data, uint32_t size, AncillaryPayload* payload);
+
+static inline uint16_t readUInt16(const uint8_t* p)
+{
+	return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+static inline uint8_t* writeUInt16(uint8_t* p, uint16_t value)
+{
+	*p++ = (uint8_t)(value >> 8);
+	*p++ = (uint8_t)value;
+	return p;
+}
+
+// SMPTE 352
+
+static bool encodePayloadIdentifier(const AncillaryPayload& payload, AncillaryPacketBuffer* packet)
+{
+	memcpy(packet->data, payload.payloadIdentifier.bytes, kPayloadIdentifierSize);
+	packet->size = kPayloadIdentifierSize;
+	return true;
+}
+
+static bool decodePayloadIdentifier(const uint8_t* data, uint32_t size, AncillaryPayload* payload)
+{
+	memcpy(payload->payloadIdentifier.bytes, data, kPayloadIdentifierSize);
+	return true;
+}
+
+// SMPTE 2016-3, AFD and aspect ratio in word 1, the bar data flags in word 4 then two 16-bit bar values
+
+static bool encodeAFDBarData(const AncillaryPayload& payload, AncillaryPacketBuffer* packet)
+{
+	const AFDBarData& afd = payload.afdBarData;
+	uint8_t* p = packet->data;
+
+	if (afd.afd > 0xF || afd.barFlags > 0xF)
+		return false;
+
+	*p++ = (uint8_t)((afd.afd << 3) | (afd.aspectRatio16x9 ? 0x04 : 0x00));
+	*p++ = 0;
+	*p++ = 0;
+	*p++ = (uint8_t)(afd.barFlags << 4);
+	p = writeUInt16(p, afd.barValue1);
+	p = writeUInt16(p, afd.barValue2);
+
+	packet->size = kAFDBarDataSize;
+	return true;
+}
+
+static bool decodeAFDBarData(const uint8_t* data, uint32_t size, AncillaryPayload* payload)
+{
+	AFDBarData& afd = payload->afdBarData;
+
+	afd.afd				= (data[0] >> 3) & 0xF;
+	afd.aspectRatio16x9	= (data[0] & 0x04) != 0;
+	afd.barFlags		= data[3] >> 4;
+	afd.barValue1		= readUInt16(data + 4);
+	afd.barValue2		= readUInt16(data + 6);
+
+	// Top and bottom bars exclude left and right bars
+	return (afd.barFlags & 0x3) == 0 || (afd.barFlags & 0xC) == 0;
+}
+
+// SMPTE 2010 payload descriptor followed by a SCTE 104 multiple_operation_message
+
+static bool encodeSCTE104(const AncillaryPayload& payload, AncillaryPacketBuffer* packet)
+{
+	const SCTE104Message& message = payload.scte104;
+	uint8_t* p = packet->data;
+
+	if (message.timeType > SCTE104Message::kTimeTypeGPI || message.operationCount > SCTE104Message::kMaximumOperations)
+		return false;
+
+	size_t timestampSize = kSCTE104TimestampSizes[message.timeType];
+	size_t messageSize = kSCTE104HeaderSize + timestampSize;
+	for (uint8_t i = 0; i < message.operationCount; i++)
+	{
+		if (message.operations[i].dataLength > SCTE104Operation::kMaximumDataSize)
+			return false;
+		messageSize += kSCTE104OperationHeaderSize + message.operations[i].dataLength;
+	}
+
+	if (messageSize + 1 > AncillaryPacketBuffer::kMaximumSize)
+		return false;
+
+	*p++ = kSCTE104PayloadDescriptor;
+	p = writeUInt16(p, 0xFFFF);
+	p = writeUInt16(p, (uint16_t)messageSize);
+	*p++ = 0;											// protocol_version
+	*p++ = message.asIndex;
+	*p++ = message.messageNumber;
+	p = writeUInt16(p, message.dpiPIDIndex);
+	*p++ = 0;											// SCTE35_protocol_version
+	*p++ = message.timeType;
+	memcpy(p, message.timestamp, timestampSize);
+	p += timestampSize;
+	*p++ = message.operationCount;
+
+	for (uint8_t i = 0; i < message.operationCount; i++)
+	{
+		const SCTE104Operation& operation = message.operations[i];
+		p = writeUInt16(p, operation.opID);
+		p = writeUInt16(p, operation.dataLength);
+		memcpy(p, operation.data, operation.dataLength);
+		p += operation.dataLength;
+	}
+
+	packet->size = (uint8_t)(messageSize + 1);
+	return true;
+}
+
+static bool decodeSCTE104(const uint8_t* data, uint32_t size, AncillaryPayload* payload)
+{
+	SCTE104Message& message = payload->scte104;
+
+	// Messages continued across packets are not supported
+	if ((data[0] & 0x04) != 0)
+		return false;
+
+	const uint8_t* p = data + 1;
+	const uint8_t* end = data + size;
+
+	if (readUInt16(p) != 0xFFFF)
+		return false;
+
+	uint16_t messageSize = readUInt16(p + 2);
+	if (messageSize < kSCTE104HeaderSize || messageSize > size - 1)
+		return false;
+	end = p + messageSize;
+
+	message.asIndex			= p[5];
+	message.messageNumber	= p[6];
+	message.dpiPIDIndex		= readUInt16(p + 7);
+	message.timeType		= p[10];
+	p += 11;
+
+	if (message.timeType > SCTE104Message::kTimeTypeGPI)
+		return false;
+
+	size_t timestampSize = kSCTE104TimestampSizes[message.timeType];
+	if ((size_t)(end - p) < timestampSize + 1)
+		return false;
+	memcpy(message.timestamp, p, timestampSize);
+	p += timestampSize;
+
+	message.operationCount = *p++;
+	if (message.operationCount > SCTE104Message::kMaximumOperations)
+		return false;
+
+	for (uint8_t i = 0; i < message.operationCount; i++)
+	{
+		SCTE104Operation& operation = message.operations[i];
+
+		if ((size_t)(end - p) < kSCTE104OperationHeaderSize)
+			return false;
+		operation.opID			= readUInt16(p);
+		operation.dataLength	= readUInt16(p + 2);
+		p += kSCTE104OperationHeaderSize;
+
+		if (operation.dataLength > SCTE104Operation::kMaximumDataSize || (size_t)(end - p) < operation.dataLength)
+			return false;
+		memcpy(operation.data, p, operation.dataLength);
+		p += operation.dataLength;
+	}
+
+	return true;
+}
+
+// SMPTE 12-2, each word carries a time code nibble in bits 4-7 and a distributed binary bit in bit 3
+
+static bool encodeTimecode(const AncillaryPayload& payload, AncillaryPacketBuffer* packet)
+{
+	const AncillaryTimecode& timecode = payload.timecode;
+	uint8_t nibbles[8];
+
+	if (timecode.hours > 23 || timecode.minutes > 59 || timecode.seconds > 59 || timecode.frames > 39)
+		return false;
+
+	nibbles[0] = timecode.frames % 10;
+	nibbles[1] = (uint8_t)((timecode.frames / 10) | (timecode.dropFrame ? 0x4 : 0) | (timecode.colorFrame ? 0x8 : 0));
+	nibbles[2] = timecode.seconds % 10;
+	nibbles[3] = (uint8_t)((timecode.seconds / 10) | (timecode.fieldMark ? 0x8 : 0));
+	nibbles[4] = timecode.minutes % 10;
+	nibbles[5] = (uint8_t)((timecode.minutes / 10) | ((timecode.binaryGroupFlags & 0x1) << 3));
+	nibbles[6] = timecode.hours % 10;
+	nibbles[7] = (uint8_t)((timecode.hours / 10) | ((timecode.binaryGroupFlags & 0x6) << 1));
+
+	// Time code and binary group nibbles alternate, DBB1 is in words 1-8 and DBB2 in words 9-16
+	for (unsigned i = 0; i < 8; i++)
+	{
+		uint8_t userBits = (uint8_t)((timecode.userBits >> (i * 4)) & 0xF);
+		uint8_t dbb = (i < 4) ? timecode.type : timecode.dbb2;
+		unsigned dbbBit = (i % 4) * 2;
+
+		packet->data[i * 2]		= (uint8_t)((nibbles[i] << 4) | (((dbb >> dbbBit) & 1) << 3));
+		packet->data[i * 2 + 1]	= (uint8_t)((userBits << 4) | (((dbb >> (dbbBit + 1)) & 1) << 3));
+	}
+
+	packet->size = kTimecodeSize;
+	return true;
+}
+
+static bool decodeTimecode(const uint8_t* data, uint32_t size, AncillaryPayload* payload)
+{
+	AncillaryTimecode& timecode = payload->timecode;
+	uint8_t nibbles[8];
+
+	timecode.type = 0;
+	timecode.dbb2 = 0;
+	timecode.userBits = 0;
+	for (unsigned i = 0; i < 8; i++)
+	{
+		unsigned dbbBit = (i % 4) * 2;
+		uint8_t dbbBits = (uint8_t)((((data[i * 2] >> 3) & 1) << dbbBit) | (((data[i * 2 + 1] >> 3) & 1) << (dbbBit + 1)));
+
+		nibbles[i] = data[i * 2] >> 4;
+		timecode.userBits |= (uint32_t)(data[i * 2 + 1] >> 4) << (i * 4);
+		if (i < 4)
+			timecode.type |= dbbBits;
+		else
+			timecode.dbb2 |= dbbBits;
+	}
+
+	timecode.frames				= (uint8_t)((nibbles[1] & 0x3) * 10 + nibbles[0]);
+	timecode.dropFrame			= (nibbles[1] & 0x4) != 0;
+	timecode.colorFrame			= (nibbles[1] & 0x8) != 0;
+	timecode.seconds			= (uint8_t)((nibbles[3] & 0x7) * 10 + nibbles[2]);
+	timecode.fieldMark			= (nibbles[3] & 0x8) != 0;
+	timecode.minutes			= (uint8_t)((nibbles[5] & 0x7) * 10 + nibbles[4]);
+	timecode.hours				= (uint8_t)((nibbles[7] & 0x3) * 10 + nibbles[6]);
+	timecode.binaryGroupFlags	= (uint8_t)(((nibbles[5] >> 3) & 0x1) | ((nibbles[7] >> 1) & 0x6));
+
+	return nibbles[0] <= 9 && nibbles[2] <= 9 && nibbles[4] <= 9 && nibbles[6] <= 9 &&
+		timecode.seconds <= 59 && timecode.minutes <= 59 && timecode.hours <= 23;
+}
+
+namespace
+{
+
+struct AncillaryCodec
+{
+	uint8_t					did;
+	uint8_t					sdid;
+	const char*				name;
+	uint32_t				minimumSize;
+	uint32_t				maximumSize;
+	AncillaryEncodeFunction	encode;
+	AncillaryDecodeFunction	decode;
+};
+
+// Indexed by AncillaryPayloadType
+const AncillaryCodec kCodecs[kAncillaryPayloadTypeCount] =
+{
+	{ 0x00, 0x00, "Unknown",		0,								0,									NULL,						NULL },
+	{ 0x41, 0x01, "VPID",			kPayloadIdentifierSize,			kPayloadIdentifierSize,				encodePayloadIdentifier,	decodePayloadIdentifier },
+	{ 0x41, 0x05, "AFD",			kAFDBarDataSize,				kAFDBarDataSize,					encodeAFDBarData,			decodeAFDBarData },
+	{ 0x41, 0x07, "SCTE-104",		1 + kSCTE104HeaderSize,			AncillaryPacketBuffer::kMaximumSize,	encodeSCTE104,				decodeSCTE104 },
+	{ 0x60, 0x60, "ATC",			kTimecodeSize,					kTimecodeSize,						encodeTimecode,				decodeTimecode },
+};
+
+// Each DID with a codec has a row mapping SDID to payload type, row 0 is all unknown
+class DispatchTable
+{
+public:
+	static const size_t kMaximumRows = kAncillaryPayloadTypeCount;
+
+	DispatchTable()
+	{
+		size_t rowCount = 1;
+
+		memset(m_rowByDID, 0, sizeof(m_rowByDID));
+		memset(m_typeBySDID, 0, sizeof(m_typeBySDID));
+
+		for (int type = kAncillaryPayloadUnknown + 1; type < kAncillaryPayloadTypeCount; type++)
+		{
+			const AncillaryCodec& codec = kCodecs[type];
+			if (m_rowByDID[codec.did] == 0)
+				m_rowByDID[codec.did] = (uint8_t)rowCount++;
+			m_typeBySDID[m_rowByDID[codec.did]][codec.sdid] = (uint8_t)type;
+		}
+	}
+
+	AncillaryPayloadType lookup(uint8_t did, uint8_t sdid) const
+	{
+		return (AncillaryPayloadType)m_typeBySDID[m_rowByDID[did]][sdid];
+	}
+
+private:
+	uint8_t		m_rowByDID[256];
+	uint8_t		m_typeBySDID[kMaximumRows][256];
+};
+
+const DispatchTable kDispatchTable;
+
+}
+
+void SCTE104EncodeSpliceRequest(const SCTE104SpliceRequest& request, SCTE104Operation* operation)
+{
+	uint8_t* p = operation->data;
+
+	*p++ = request.spliceInsertType;
+	*p++ = (uint8_t)(request.spliceEventID >> 24);
+	*p++ = (uint8_t)(request.spliceEventID >> 16);
+	*p++ = (uint8_t)(request.spliceEventID >> 8);
+	*p++ = (uint8_t)request.spliceEventID;
+	p = writeUInt16(p, request.uniqueProgramID);
+	p = writeUInt16(p, request.preRollTimeMs);
+	p = writeUInt16(p, request.breakDuration);
+	*p++ = request.availNum;
+	*p++ = request.availsExpected;
+	*p++ = request.autoReturn ? 1 : 0;
+
+	operation->opID = kSCTE104OpSpliceRequest;
+	operation->dataLength = kSCTE104SpliceRequestSize;
+}
+
+bool SCTE104DecodeSpliceRequest(const SCTE104Operation& operation, SCTE104SpliceRequest* request)
+{
+	const uint8_t* p = operation.data;
+
+	if (operation.opID != kSCTE104OpSpliceRequest || operation.dataLength < kSCTE104SpliceRequestSize)
+		return false;
+
+	request->spliceInsertType	= p[0];
+	request->spliceEventID		= ((uint32_t)p[1] << 24) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 8) | p[4];
+	request->uniqueProgramID	= readUInt16(p + 5);
+	request->preRollTimeMs		= readUInt16(p + 7);
+	request->breakDuration		= readUInt16(p + 9);
+	request->availNum			= p[11];
+	request->availsExpected		= p[12];
+	request->autoReturn			= p[13] != 0;
+
+	return true;
+}
+
+bool EncodeAncillaryPayload(const AncillaryPayload& payload, AncillaryPacketBuffer* packet)
+{
+	if (payload.type <= kAncillaryPayloadUnknown || payload.type >= kAncillaryPayloadTypeCount)
+		return false;
+
+	const AncillaryCodec& codec = kCodecs[payload.type];
+
+	packet->did = codec.did;
+	packet->sdid = codec.sdid;
+	return codec.encode(payload, packet);
+}
+
+AncillaryPayloadType GetAncillaryPayloadType(uint8_t did, uint8_t sdid)
+{
+	return kDispatchTable.lookup(did, sdid);
+}
+
+const char* GetAncillaryPayloadName(AncillaryPayloadType type)
+{
+	if (type < kAncillaryPayloadUnknown || type >= kAncillaryPayloadTypeCount)
+		type = kAncillaryPayloadUnknown;
+	return kCodecs[type].name;
+}
+
+bool DecodeAncillaryPayload(AncillaryPayloadType type, const uint8_t* data, uint32_t size, AncillaryPayload* payload)
+{
+	if (type <= kAncillaryPayloadUnknown || type >= kAncillaryPayloadTypeCount)
+		return false;
+
+	const AncillaryCodec& codec = kCodecs[type];
+
+	if (size < codec.minimumSize || size > codec.maximumSize)
+		return false;
+
+	payload->type = type;
+	return codec.decode(data, size, payload);
+}
+
+AncillaryDecoder::AncillaryDecoder()
+{
+	memset(&m_statistics, 0, sizeof(m_statistics));
+}
+
+size_t AncillaryDecoder::decode(IDeckLinkVideoFrame* videoFrame, AncillaryPayload* payloads, size_t maximumPayloads)
+{
+	IDeckLinkVideoFrameAncillaryPackets*	framePackets = NULL;
+	IDeckLinkAncillaryPacketIterator*		iterator = NULL;
+	IDeckLinkAncillaryPacket*				packet = NULL;
+	size_t									count = 0;
+
+	if (videoFrame->QueryInterface(IID_IDeckLinkVideoFrameAncillaryPackets, (void**)&framePackets) != S_OK)
+		return 0;
+
+	if (framePackets->GetPacketIterator(&iterator) != S_OK)
+		goto bail;
+
+	// Only the DID and SDID of packets without a codec are read
+	while (iterator->Next(&packet) == S_OK)
+	{
+		AncillaryPayloadType	type = GetAncillaryPayloadType(packet->GetDID(), packet->GetSDID());
+		const void*				data = NULL;
+		uint32_t				size = 0;
+
+		m_statistics.packets++;
+
+		if (type == kAncillaryPayloadUnknown)
+			m_statistics.unknown++;
+		else if (count == maximumPayloads)
+			m_statistics.dropped++;
+		else if (packet->GetBytes(bmdAncillaryPacketFormatUInt8, &data, &size) == S_OK &&
+				 DecodeAncillaryPayload(type, (const uint8_t*)data, size, &payloads[count]))
+		{
+			payloads[count++].lineNumber = packet->GetLineNumber();
+			m_statistics.decoded++;
+		}
+		else
+			m_statistics.malformed++;
+
+		packet->Release();
+	}
+
+bail:
+	if (iterator != NULL)
+		iterator->Release();
+	framePackets->Release();
+	return count;
+}
+
+OutputAncillaryPacket::OutputAncillaryPacket(uint32_t lineNumber) :
+	m_refCount(1),
+	m_lineNumber(lineNumber)
+{
+	memset(&m_buffer, 0, sizeof(m_buffer));
+}
+
+HRESULT OutputAncillaryPacket::QueryInterface(REFIID iid, LPVOID *ppv)
+{
+	*ppv = NULL;
+	return E_NOINTERFACE;
+}
+
+ULONG OutputAncillaryPacket::AddRef(void)
+{
+	return __sync_add_and_fetch(&m_refCount, 1);
+}
+
+ULONG OutputAncillaryPacket::Release(void)
+{
+	int32_t newRefValue = __sync_sub_and_fetch(&m_refCount, 1);
+	if (newRefValue == 0)
+		delete this;
+	return newRefValue;
+}
+
+HRESULT OutputAncillaryPacket::GetBytes(BMDAncillaryPacketFormat format, const void** data, uint32_t* size)
+{
+	if (format != bmdAncillaryPacketFormatUInt8)
+		return E_NOTIMPL;
+	if (data)
+		*data = m_buffer.data;
+	if (size)
+		*size = m_buffer.size;
+	return S_OK;
+}
+
+uint8_t OutputAncillaryPacket::GetDID(void)
+{
+	return m_buffer.did;
+}
+
+uint8_t OutputAncillaryPacket::GetSDID(void)
+{
+	return m_buffer.sdid;
+}
+
+uint32_t OutputAncillaryPacket::GetLineNumber(void)
+{
+	return m_lineNumber;
+}
+
+uint8_t OutputAncillaryPacket::GetDataStreamIndex(void)
+{
+	return 0;
+}
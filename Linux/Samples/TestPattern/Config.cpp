@@ -53,6 +53,9 @@ BMDConfig::BMDConfig() :
 	m_outputFlags(bmdVideoOutputFlagDefault),
 	m_pixelFormat(bmdFormat8BitYUV),
 	m_output444(false),
+	m_spliceEventFile(),
+	m_spliceEventSocket(),
+	m_spliceLoopbackTest(false),
 	m_deckLinkName(),
 	m_displayModeName()
 {
@@ -72,7 +75,7 @@ bool BMDConfig::ParseArguments(int argc,  char** argv)
 	int		ch;
 	bool	displayHelp = false;
 
-	while ((ch = getopt(argc, argv, "d:?h3c:s:f:a:m:n:p:t:")) != -1)
+	while ((ch = getopt(argc, argv, "d:?h3c:s:f:a:m:n:p:t:e:u:l")) != -1)
 	{
 		switch (ch)
 		{
@@ -120,12 +123,35 @@ bool BMDConfig::ParseArguments(int argc,  char** argv)
 				m_outputFlags |= bmdVideoOutputDualStream3D;
 				break;
 
+			case 'e':
+				m_spliceEventFile = optarg;
+				break;
+
+			case 'u':
+				m_spliceEventSocket = optarg;
+				break;
+
+			case 'l':
+				m_spliceLoopbackTest = true;
+				break;
+
 			case '?':
 			case 'h':
 				displayHelp = true;
 		}
 	}
 
+	// The splice loopback test does not use a device
+	if (m_spliceLoopbackTest && !displayHelp)
+	{
+		if (m_spliceEventFile == NULL)
+		{
+			fprintf(stderr, "The splice loopback test requires a splice event file\n");
+			return false;
+		}
+		return true;
+	}
+
 	if (m_deckLinkIndex < 0)
 	{
 		fprintf(stderr, "You must select a device\n");
@@ -343,10 +369,19 @@ bail:
 		"    -c <channels>        Audio Channels (2, 8 or 16 - default is 2)\n"
 		"    -s <depth>           Audio Sample Depth (16 or 32 - default is 16)\n"
 		"    -3                   Playback Stereoscopic 3D (Requires 3D Hardware support)\n"
+		"    -e <filename>        Insert the SCTE-104 splice events of a file\n"
+		"    -u <socket path>     Insert SCTE-104 splice events sent as datagrams to a local socket\n"
+		"    -l                   Check the schedule of the -e splice event file by decoding its packets, without a device\n"
+		"\n"
+		"Splice events are one per line or datagram:\n"
+		"\n"
+		"    <frame|HH:MM:SS:FF|+seconds> <start|start-immediate|end|end-immediate|cancel> event=<id>\n"
+		"        [program=<id>] [duration=<seconds>] [preroll=<ms>] [avail=<num>] [avails=<expected>] [noreturn]\n"
 		"\n"
 		"Output a test pattern eg:\n"
 		"\n"
 		"    TestPattern -d 0 -m 2 \n"
+		"    TestPattern -d 0 -m 2 -e breaks.txt -u /tmp/TestPattern.sock\n"
 	);
 
 	if (deckLinkIterator != NULL)
@@ -371,13 +406,17 @@ void BMDConfig::DisplayConfiguration()
 		" - Video mode: %s %s\n"
 		" - Pixel format: %s\n"
 		" - Audio channels: %u\n"
-		" - Audio sample depth: %u bit \n",
+		" - Audio sample depth: %u bit \n"
+		" - Splice events: %s%s%s\n",
 		m_deckLinkName,
 		m_displayModeName,
 		(m_outputFlags & bmdVideoOutputDualStream3D) ? "3D" : "",
 		GetPixelFormatName(m_pixelFormat),
 		m_audioChannels,
-		m_audioSampleDepth
+		m_audioSampleDepth,
+		m_spliceEventFile ? m_spliceEventFile : "",
+		(m_spliceEventFile && m_spliceEventSocket) ? ", " : "",
+		m_spliceEventSocket ? m_spliceEventSocket : (m_spliceEventFile ? "" : "none")
 	);
 }
 
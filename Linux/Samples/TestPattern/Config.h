@@ -66,6 +66,10 @@ public:
 	const char*				m_videoOutputFile;
 	const char*				m_audioOutputFile;
 
+	const char*				m_spliceEventFile;
+	const char*				m_spliceEventSocket;
+	bool					m_spliceLoopbackTest;
+
 private:
 	char*					m_deckLinkName;
 	char*					m_displayModeName;
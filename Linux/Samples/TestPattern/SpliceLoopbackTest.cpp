@@ -0,0 +1,274 @@
+/* -LICENSE-START-
+** Copyright (c) 2022 Blackmagic Design
+**  
+** Permission is hereby granted, free of charge, to any person or organization 
+** obtaining a copy of the software and accompanying documentation (the 
+** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+** and transmit the Software, and to prepare derivative works of the Software, 
+** and to permit third-parties to whom the Software is furnished to do so, in 
+** accordance with:
+** 
+** (1) if the Software is obtained from Blackmagic Design, the End User License 
+** Agreement for the Software Development Kit (“EULA”) available at 
+** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+** 
+** (2) if the Software is obtained from any third party, such licensing terms 
+** as notified by that third party,
+** 
+** and all subject to the following:
+** 
+** (3) the copyright notices in the Software and this entire statement, 
+** including the above license grant, this restriction and the following 
+** disclaimer, must be included in all copies of the Software, in whole or in 
+** part, and all derivative works of the Software, unless such copies or 
+** derivative works are solely in the form of machine-executable object code 
+** generated by a source language processor.
+** 
+** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+** DEALINGS IN THE SOFTWARE.
+** 
+** A copy of the Software is available free of charge at 
+** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+** 
+** -LICENSE-END-
+*/
+
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#include "SpliceLoopbackTest.h"
+#include "SpliceScheduler.h"
+
+static const BMDTimeValue	kFrameDuration			= 1001;
+static const BMDTimeScale	kTimeScale				= 30000;
+static const uint32_t		kRepeatIntervalFrames	= 30;
+static const size_t			kMaximumPacketsPerFrame	= 4;
+
+namespace
+{
+
+// Frame stand-in holding the attached packets, iterated by AncillaryDecoder as a capture of the output would be
+class LoopbackVideoFrame : public IDeckLinkVideoFrame, public IDeckLinkVideoFrameAncillaryPackets, public IDeckLinkAncillaryPacketIterator
+{
+public:
+	LoopbackVideoFrame() : m_count(0), m_next(0) { }
+
+	virtual HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid, LPVOID *ppv)
+	{
+		if (memcmp(&iid, &IID_IDeckLinkVideoFrameAncillaryPackets, sizeof(REFIID)) == 0)
+		{
+			*ppv = static_cast<IDeckLinkVideoFrameAncillaryPackets*>(this);
+			return S_OK;
+		}
+		*ppv = NULL;
+		return E_NOINTERFACE;
+	}
+	virtual ULONG STDMETHODCALLTYPE AddRef(void) { return 1; }
+	virtual ULONG STDMETHODCALLTYPE Release(void) { return 1; }
+
+	// IDeckLinkVideoFrame
+	virtual long STDMETHODCALLTYPE GetWidth(void) { return 1920; }
+	virtual long STDMETHODCALLTYPE GetHeight(void) { return 1080; }
+	virtual long STDMETHODCALLTYPE GetRowBytes(void) { return 1920 * 2; }
+	virtual BMDPixelFormat STDMETHODCALLTYPE GetPixelFormat(void) { return bmdFormat8BitYUV; }
+	virtual BMDFrameFlags STDMETHODCALLTYPE GetFlags(void) { return bmdFrameFlagDefault; }
+	virtual HRESULT STDMETHODCALLTYPE GetBytes(void** buffer) { return E_NOTIMPL; }
+	virtual HRESULT STDMETHODCALLTYPE GetTimecode(BMDTimecodeFormat format, IDeckLinkTimecode** timecode) { return S_FALSE; }
+	virtual HRESULT STDMETHODCALLTYPE GetAncillaryData(IDeckLinkVideoFrameAncillary** ancillary) { return E_NOTIMPL; }
+
+	// IDeckLinkVideoFrameAncillaryPackets
+	virtual HRESULT STDMETHODCALLTYPE GetPacketIterator(IDeckLinkAncillaryPacketIterator** iterator)
+	{
+		m_next = 0;
+		*iterator = this;
+		return S_OK;
+	}
+	virtual HRESULT STDMETHODCALLTYPE GetFirstPacketByID(uint8_t DID, uint8_t SDID, IDeckLinkAncillaryPacket** packet) { return E_NOTIMPL; }
+	virtual HRESULT STDMETHODCALLTYPE AttachPacket(IDeckLinkAncillaryPacket* packet)
+	{
+		if (m_count == kMaximumPacketsPerFrame)
+			return E_OUTOFMEMORY;
+		m_packets[m_count++] = packet;
+		return S_OK;
+	}
+	virtual HRESULT STDMETHODCALLTYPE DetachPacket(IDeckLinkAncillaryPacket* packet) { return E_NOTIMPL; }
+	virtual HRESULT STDMETHODCALLTYPE DetachAllPackets(void) { m_count = 0; return S_OK; }
+
+	// IDeckLinkAncillaryPacketIterator
+	virtual HRESULT STDMETHODCALLTYPE Next(IDeckLinkAncillaryPacket** packet)
+	{
+		if (m_next == m_count)
+		{
+			*packet = NULL;
+			return S_FALSE;
+		}
+		*packet = m_packets[m_next++];
+		(*packet)->AddRef();
+		return S_OK;
+	}
+
+private:
+	IDeckLinkAncillaryPacket*	m_packets[kMaximumPacketsPerFrame];
+	size_t						m_count;
+	size_t						m_next;
+};
+
+struct EventResult
+{
+	unsigned	messages;
+	int64_t		firstFrame;
+	int64_t		lastFrame;
+	unsigned	errors;
+};
+
+const char* getSpliceInsertTypeName(uint8_t spliceInsertType)
+{
+	static const char* kNames[] = { "reserved", "start", "start-immediate", "end", "end-immediate", "cancel" };
+	return (spliceInsertType < sizeof(kNames) / sizeof(kNames[0])) ? kNames[spliceInsertType] : "reserved";
+}
+
+}
+
+// Edge cases checked after the file's events: a pre-roll longer than the time before the splice, which starts on
+// the first frame, an end sharing its start's ID, an immediate splice and a pre-roll shorter than the repeat interval
+static const char* kBuiltInEvents[] =
+{
+	"100 start event=4 preroll=8000",
+	"400 end event=4 preroll=4000",
+	"450 start-immediate event=5",
+	"600 start event=6 preroll=500",
+};
+
+// The frame a freshly loaded scheduler sends first, messages due before it are moved up to it
+static const int64_t kFirstScheduledFrame = 0;
+
+static bool checkSchedule(SpliceScheduler& scheduler, const std::vector<SpliceEvent>& events, const char* source)
+{
+	LoopbackVideoFrame						frame;
+	AncillaryDecoder						decoder;
+	OutputAncillaryPacket*					packets[kMaximumPacketsPerFrame];
+	AncillaryPacketBuffer*					buffers[kMaximumPacketsPerFrame];
+	AncillaryPayload						payloads[kMaximumPacketsPerFrame];
+	std::vector<EventResult>				results;
+	int64_t									lastSpliceFrame = 0;
+	unsigned								unmatched = 0;
+	bool									success = true;
+
+	results.resize(events.size(), EventResult { 0, -1, -1, 0 });
+	for (const SpliceEvent& event : events)
+		lastSpliceFrame = std::max(lastSpliceFrame, event.spliceFrame);
+
+	for (size_t i = 0; i < kMaximumPacketsPerFrame; i++)
+	{
+		packets[i] = new OutputAncillaryPacket();
+		buffers[i] = &packets[i]->getBuffer();
+	}
+
+	printf("Scheduling %zu splice events from %s onto %lld frames at 29.97 fps\n",
+			events.size(), source, (long long)(lastSpliceFrame + 1));
+
+	// The schedule as playout attaches it, then decoded as a capture of the output would be
+	for (int64_t frameNumber = 0; frameNumber <= lastSpliceFrame; frameNumber++)
+	{
+		size_t count = scheduler.getPacketsForFrame(frameNumber, buffers, kMaximumPacketsPerFrame);
+
+		frame.DetachAllPackets();
+		for (size_t i = 0; i < count; i++)
+			frame.AttachPacket(packets[i]);
+
+		size_t decodedCount = decoder.decode(&frame, payloads, kMaximumPacketsPerFrame);
+
+		for (size_t i = 0; i < decodedCount; i++)
+		{
+			SCTE104SpliceRequest request;
+
+			if (payloads[i].type != kAncillaryPayloadSCTE104 || !SCTE104DecodeSpliceRequest(payloads[i].scte104.operations[0], &request))
+			{
+				unmatched++;
+				continue;
+			}
+
+			// Events are identified by their ID and type, an end usually shares the ID of its start
+			size_t index;
+			for (index = 0; index < events.size(); index++)
+			{
+				if (events[index].spliceEventID == request.spliceEventID && events[index].spliceInsertType == request.spliceInsertType)
+					break;
+			}
+			if (index == events.size())
+			{
+				unmatched++;
+				continue;
+			}
+
+			EventResult& result = results[index];
+			if (frameNumber + scheduler.preRollTimeToFrames(request.preRollTimeMs) != events[index].spliceFrame)
+				result.errors++;
+			if (result.firstFrame < 0)
+				result.firstFrame = frameNumber;
+			result.lastFrame = frameNumber;
+			result.messages++;
+		}
+	}
+
+	for (size_t i = 0; i < events.size(); i++)
+	{
+		const SpliceEvent&	event = events[i];
+		const EventResult&	result = results[i];
+		int64_t				expectedFirstFrame = std::max(event.spliceFrame - (int64_t)event.preRollFrames, kFirstScheduledFrame);
+		bool				passed = result.messages > 0 && result.errors == 0 && result.firstFrame == expectedFirstFrame &&
+									 result.lastFrame <= event.spliceFrame;
+
+		printf("  Event %u %-15s splice frame %6lld: %u messages, frames %lld to %lld, %u pre-roll errors  %s\n",
+				event.spliceEventID, getSpliceInsertTypeName(event.spliceInsertType), (long long)event.spliceFrame,
+				result.messages, (long long)result.firstFrame, (long long)result.lastFrame, result.errors,
+				passed ? "ok" : "FAILED");
+		success &= passed;
+	}
+
+	SpliceScheduler::Statistics statistics = scheduler.getStatistics();
+	const AncillaryDecoder::Statistics& decoderStatistics = decoder.getStatistics();
+
+	printf("  %llu messages sent, %llu missed, %llu late events, %llu malformed packets, %u unmatched messages\n",
+			(unsigned long long)statistics.messagesSent, (unsigned long long)statistics.messagesMissed,
+			(unsigned long long)statistics.eventsLate, (unsigned long long)decoderStatistics.malformed, unmatched);
+
+	for (size_t i = 0; i < kMaximumPacketsPerFrame; i++)
+		packets[i]->Release();
+
+	return success && statistics.messagesMissed == 0 && decoderStatistics.malformed == 0 && unmatched == 0;
+}
+
+bool RunSpliceLoopbackTest(const char* eventFile)
+{
+	SpliceScheduler				fileScheduler(kFrameDuration, kTimeScale, kRepeatIntervalFrames);
+	SpliceScheduler				builtInScheduler(kFrameDuration, kTimeScale, kRepeatIntervalFrames);
+	std::vector<SpliceEvent>	builtInEvents;
+
+	if (!fileScheduler.loadFile(eventFile))
+		return false;
+
+	for (const char* line : kBuiltInEvents)
+	{
+		SpliceEvent event;
+
+		if (!builtInScheduler.parseEvent(line, &event) || !builtInScheduler.addEvent(event))
+		{
+			fprintf(stderr, "Unable to schedule built-in splice event \"%s\"\n", line);
+			return false;
+		}
+		builtInEvents.push_back(event);
+	}
+
+	bool fileSuccess = checkSchedule(fileScheduler, fileScheduler.getFileEvents(), eventFile);
+	bool builtInSuccess = checkSchedule(builtInScheduler, builtInEvents, "the built-in edge cases");
+
+	return fileSuccess && builtInSuccess;
+}
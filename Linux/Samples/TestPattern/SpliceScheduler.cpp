@@ -0,0 +1,441 @@
+/* -LICENSE-START-
+** Copyright (c) 2022 Blackmagic Design
+**  
+** Permission is hereby granted, free of charge, to any person or organization 
+** obtaining a copy of the software and accompanying documentation (the 
+** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+** and transmit the Software, and to prepare derivative works of the Software, 
+** and to permit third-parties to whom the Software is furnished to do so, in 
+** accordance with:
+** 
+** (1) if the Software is obtained from Blackmagic Design, the End User License 
+** Agreement for the Software Development Kit (“EULA”) available at 
+** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+** 
+** (2) if the Software is obtained from any third party, such licensing terms 
+** as notified by that third party,
+** 
+** and all subject to the following:
+** 
+** (3) the copyright notices in the Software and this entire statement, 
+** including the above license grant, this restriction and the following 
+** disclaimer, must be included in all copies of the Software, in whole or in 
+** part, and all derivative works of the Software, unless such copies or 
+** derivative works are solely in the form of machine-executable object code 
+** generated by a source language processor.
+** 
+** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+** DEALINGS IN THE SOFTWARE.
+** 
+** A copy of the Software is available free of charge at 
+** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+** 
+** -LICENSE-END-
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "SpliceScheduler.h"
+
+static const size_t		kMaximumLineLength		= 256;
+static const int		kListenPollTimeoutMs	= 100;
+
+static bool isImmediateType(uint8_t spliceInsertType)
+{
+	return spliceInsertType == kSCTE104SpliceStartImmediate ||
+		spliceInsertType == kSCTE104SpliceEndImmediate ||
+		spliceInsertType == kSCTE104SpliceCancel;
+}
+
+// Blank lines and comments carry no event
+static bool isEventLine(const char* line)
+{
+	line += strspn(line, " \t\r\n");
+	return *line != '\0' && *line != '#';
+}
+
+SpliceScheduler::SpliceScheduler(BMDTimeValue frameDuration, BMDTimeScale timeScale, uint32_t repeatIntervalFrames) :
+	m_frameDuration(frameDuration),
+	m_timeScale(timeScale),
+	m_framesPerSecond((uint32_t)((timeScale + frameDuration - 1) / frameDuration)),
+	m_repeatIntervalFrames(std::max<uint32_t>(repeatIntervalFrames, 1)),
+	m_nextFrame(0),
+	m_messageNumber(0),
+	m_socket(-1),
+	m_listening(false)
+{
+	memset(&m_statistics, 0, sizeof(m_statistics));
+}
+
+SpliceScheduler::~SpliceScheduler()
+{
+	stopListening();
+}
+
+bool SpliceScheduler::loadFile(const char* path)
+{
+	FILE*		file = fopen(path, "r");
+	char		line[kMaximumLineLength];
+	unsigned	lineNumber = 0;
+	bool		success = true;
+
+	if (file == NULL)
+	{
+		fprintf(stderr, "Unable to open splice event file %s\n", path);
+		return false;
+	}
+
+	while (fgets(line, sizeof(line), file) != NULL)
+	{
+		SpliceEvent event;
+
+		++lineNumber;
+		if (!isEventLine(line))
+			continue;
+
+		if (!parseEvent(line, &event))
+		{
+			fprintf(stderr, "%s:%u: Invalid splice event\n", path, lineNumber);
+			success = false;
+			break;
+		}
+
+		m_fileEvents.push_back(event);
+	}
+
+	fclose(file);
+
+	if (success)
+		reset();
+
+	return success;
+}
+
+bool SpliceScheduler::startListening(const char* socketPath)
+{
+	struct sockaddr_un	address;
+
+	if (strlen(socketPath) >= sizeof(address.sun_path))
+	{
+		fprintf(stderr, "Splice event socket path %s is too long\n", socketPath);
+		return false;
+	}
+
+	m_socket = socket(AF_UNIX, SOCK_DGRAM, 0);
+	if (m_socket < 0)
+	{
+		fprintf(stderr, "Unable to create splice event socket\n");
+		return false;
+	}
+
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	strcpy(address.sun_path, socketPath);
+
+	// Replace a socket left behind by an earlier run
+	unlink(socketPath);
+	if (bind(m_socket, (struct sockaddr*)&address, sizeof(address)) != 0)
+	{
+		fprintf(stderr, "Unable to bind splice event socket %s\n", socketPath);
+		close(m_socket);
+		m_socket = -1;
+		return false;
+	}
+
+	m_socketPath = socketPath;
+	m_listening = true;
+	m_listenThread = std::thread(&SpliceScheduler::listen, this);
+	return true;
+}
+
+void SpliceScheduler::stopListening()
+{
+	if (!m_listening)
+		return;
+
+	m_listening = false;
+	m_listenThread.join();
+
+	close(m_socket);
+	m_socket = -1;
+	unlink(m_socketPath.c_str());
+}
+
+void SpliceScheduler::listen()
+{
+	char datagram[kMaximumLineLength * 4];
+
+	while (m_listening)
+	{
+		struct pollfd pollDescriptor = { m_socket, POLLIN, 0 };
+
+		if (poll(&pollDescriptor, 1, kListenPollTimeoutMs) <= 0)
+			continue;
+
+		ssize_t size = recv(m_socket, datagram, sizeof(datagram) - 1, 0);
+		if (size <= 0)
+			continue;
+		datagram[size] = '\0';
+
+		// A datagram may carry several events, one per line
+		char* savePointer = NULL;
+		for (char* line = strtok_r(datagram, "\n", &savePointer); line != NULL; line = strtok_r(NULL, "\n", &savePointer))
+		{
+			SpliceEvent event;
+
+			if (!isEventLine(line))
+				continue;
+
+			if (!parseEvent(line, &event))
+				fprintf(stderr, "Invalid splice event \"%s\"\n", line);
+			else if (!addEvent(event))
+				fprintf(stderr, "Splice event %u is too late to be scheduled\n", event.spliceEventID);
+		}
+	}
+}
+
+void SpliceScheduler::reset()
+{
+	std::lock_guard<std::mutex> guard(m_mutex);
+
+	m_transmissions.clear();
+	m_nextFrame = 0;
+
+	for (const SpliceEvent& event : m_fileEvents)
+		addEventLocked(event);
+}
+
+bool SpliceScheduler::parseEvent(const char* line, SpliceEvent* event)
+{
+	char		buffer[kMaximumLineLength];
+	char*		savePointer = NULL;
+	char*		token;
+	bool		haveEventID = false;
+	uint32_t	preRollMs = kDefaultPreRollMs;
+
+	strncpy(buffer, line, sizeof(buffer) - 1);
+	buffer[sizeof(buffer) - 1] = '\0';
+
+	memset(event, 0, sizeof(*event));
+	event->availsExpected = 1;
+	event->autoReturn = true;
+
+	// Splice time
+	token = strtok_r(buffer, " \t\r\n", &savePointer);
+	if (token == NULL)
+		return false;
+
+	if (token[0] == '+')
+	{
+		double seconds = strtod(token + 1, NULL);
+		std::lock_guard<std::mutex> guard(m_mutex);
+		event->spliceFrame = m_nextFrame + llround(seconds * m_timeScale / m_frameDuration);
+	}
+	else if (strchr(token, ':') != NULL)
+	{
+		unsigned	hours, minutes, seconds, frames;
+		char		separator;
+
+		if (sscanf(token, "%u:%u:%u%c%u", &hours, &minutes, &seconds, &separator, &frames) != 5 ||
+			(separator != ':' && separator != ';') || minutes > 59 || seconds > 59 || frames >= m_framesPerSecond)
+			return false;
+
+		int64_t totalMinutes = hours * 60 + minutes;
+		event->spliceFrame = (totalMinutes * 60 + seconds) * m_framesPerSecond + frames;
+
+		// Drop frame time code skips the first 2 frame numbers (4 at 59.94) of each minute except every tenth,
+		// it only exists for the 29.97 and 59.94 rates, integer 30 and 60 fps modes count every frame
+		if (separator == ';')
+		{
+			if ((m_framesPerSecond != 30 && m_framesPerSecond != 60) || m_timeScale % m_frameDuration == 0)
+				return false;
+			event->spliceFrame -= (m_framesPerSecond / 15) * (totalMinutes - totalMinutes / 10);
+		}
+	}
+	else
+	{
+		char* end;
+		event->spliceFrame = strtoll(token, &end, 10);
+		if (*end != '\0' || event->spliceFrame < 0)
+			return false;
+	}
+
+	// Splice type
+	token = strtok_r(NULL, " \t\r\n", &savePointer);
+	if (token == NULL)
+		return false;
+
+	if (!strcmp(token, "start"))
+		event->spliceInsertType = kSCTE104SpliceStartNormal;
+	else if (!strcmp(token, "start-immediate"))
+		event->spliceInsertType = kSCTE104SpliceStartImmediate;
+	else if (!strcmp(token, "end"))
+		event->spliceInsertType = kSCTE104SpliceEndNormal;
+	else if (!strcmp(token, "end-immediate"))
+		event->spliceInsertType = kSCTE104SpliceEndImmediate;
+	else if (!strcmp(token, "cancel"))
+		event->spliceInsertType = kSCTE104SpliceCancel;
+	else
+		return false;
+
+	// Options
+	while ((token = strtok_r(NULL, " \t\r\n", &savePointer)) != NULL)
+	{
+		char* value = strchr(token, '=');
+
+		if (value != NULL)
+			*value++ = '\0';
+
+		if (!strcmp(token, "noreturn") && value == NULL)
+			event->autoReturn = false;
+		else if (value == NULL)
+			return false;
+		else if (!strcmp(token, "event"))
+		{
+			event->spliceEventID = (uint32_t)strtoul(value, NULL, 0);
+			haveEventID = true;
+		}
+		else if (!strcmp(token, "program"))
+			event->uniqueProgramID = (uint16_t)strtoul(value, NULL, 0);
+		else if (!strcmp(token, "duration"))
+			event->breakDuration = (uint16_t)std::min(lround(strtod(value, NULL) * 10.0), 0xFFFFL);
+		else if (!strcmp(token, "preroll"))
+			preRollMs = (uint32_t)strtoul(value, NULL, 0);
+		else if (!strcmp(token, "avail"))
+			event->availNum = (uint8_t)strtoul(value, NULL, 0);
+		else if (!strcmp(token, "avails"))
+			event->availsExpected = (uint8_t)strtoul(value, NULL, 0);
+		else
+			return false;
+	}
+
+	if (!haveEventID || preRollMs > 0xFFFF)
+		return false;
+
+	event->preRollFrames = isImmediateType(event->spliceInsertType) ? 0 : (uint32_t)preRollTimeToFrames((uint16_t)preRollMs);
+	return true;
+}
+
+bool SpliceScheduler::addEvent(const SpliceEvent& event)
+{
+	std::lock_guard<std::mutex> guard(m_mutex);
+	return addEventLocked(event);
+}
+
+bool SpliceScheduler::addEventLocked(const SpliceEvent& event)
+{
+	std::vector<int64_t> frames;
+
+	if (event.spliceFrame < m_nextFrame)
+	{
+		m_statistics.eventsLate++;
+		return false;
+	}
+
+	// The first message goes out on the next frame if its pre-roll has already started, then repeats keep their
+	// place in the interval from the pre-roll start
+	int64_t firstFrame = event.spliceFrame - event.preRollFrames;
+
+	if (event.preRollFrames == 0 || firstFrame >= event.spliceFrame)
+		frames.push_back(std::max(event.spliceFrame, m_nextFrame));
+	else
+	{
+		frames.push_back(std::max(firstFrame, m_nextFrame));
+		for (int64_t frame = firstFrame + m_repeatIntervalFrames; frame < event.spliceFrame; frame += m_repeatIntervalFrames)
+		{
+			if (frame > frames.back())
+				frames.push_back(frame);
+		}
+	}
+
+	for (int64_t frame : frames)
+	{
+		AncillaryPayload		payload;
+		SCTE104SpliceRequest	request;
+		Transmission			transmission;
+
+		memset(&payload, 0, sizeof(payload));
+		payload.type = kAncillaryPayloadSCTE104;
+		payload.scte104.messageNumber = m_messageNumber++;
+		payload.scte104.timeType = SCTE104Message::kTimeTypeNone;
+		payload.scte104.operationCount = 1;
+
+		request.spliceInsertType	= event.spliceInsertType;
+		request.spliceEventID		= event.spliceEventID;
+		request.uniqueProgramID		= event.uniqueProgramID;
+		request.preRollTimeMs		= framesToPreRollTime(event.spliceFrame - frame);
+		request.breakDuration		= event.breakDuration;
+		request.availNum			= event.availNum;
+		request.availsExpected		= event.availsExpected;
+		request.autoReturn			= event.autoReturn;
+		SCTE104EncodeSpliceRequest(request, &payload.scte104.operations[0]);
+
+		transmission.frame = frame;
+		if (!EncodeAncillaryPayload(payload, &transmission.packet))
+			return false;
+
+		auto position = std::upper_bound(m_transmissions.begin(), m_transmissions.end(), frame,
+			[](int64_t value, const Transmission& other) { return value < other.frame; });
+		m_transmissions.insert(position, transmission);
+	}
+
+	m_statistics.eventsScheduled++;
+	return true;
+}
+
+size_t SpliceScheduler::getPacketsForFrame(int64_t frame, AncillaryPacketBuffer* const* buffers, size_t maximumPackets)
+{
+	std::lock_guard<std::mutex> guard(m_mutex);
+	size_t count = 0;
+
+	m_nextFrame = frame + 1;
+
+	while (!m_transmissions.empty() && m_transmissions.front().frame < frame)
+	{
+		m_statistics.messagesMissed++;
+		m_transmissions.pop_front();
+	}
+
+	while (!m_transmissions.empty() && m_transmissions.front().frame == frame)
+	{
+		if (count < maximumPackets)
+		{
+			memcpy(buffers[count++], &m_transmissions.front().packet, sizeof(AncillaryPacketBuffer));
+			m_statistics.messagesSent++;
+		}
+		else
+			m_statistics.messagesMissed++;
+		m_transmissions.pop_front();
+	}
+
+	return count;
+}
+
+int64_t SpliceScheduler::preRollTimeToFrames(uint16_t preRollTimeMs) const
+{
+	return llround(preRollTimeMs * (double)m_timeScale / (m_frameDuration * 1000.0));
+}
+
+uint16_t SpliceScheduler::framesToPreRollTime(int64_t frames) const
+{
+	return (uint16_t)std::min<int64_t>(llround(frames * m_frameDuration * 1000.0 / m_timeScale), 0xFFFF);
+}
+
+SpliceScheduler::Statistics SpliceScheduler::getStatistics()
+{
+	std::lock_guard<std::mutex> guard(m_mutex);
+	return m_statistics;
+}
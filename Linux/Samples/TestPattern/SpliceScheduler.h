@@ -0,0 +1,143 @@
+/* -LICENSE-START-
+** Copyright (c) 2022 Blackmagic Design
+**  
+** Permission is hereby granted, free of charge, to any person or organization 
+** obtaining a copy of the software and accompanying documentation (the 
+** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+** and transmit the Software, and to prepare derivative works of the Software, 
+** and to permit third-parties to whom the Software is furnished to do so, in 
+** accordance with:
+** 
+** (1) if the Software is obtained from Blackmagic Design, the End User License 
+** Agreement for the Software Development Kit (“EULA”) available at 
+** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+** 
+** (2) if the Software is obtained from any third party, such licensing terms 
+** as notified by that third party,
+** 
+** and all subject to the following:
+** 
+** (3) the copyright notices in the Software and this entire statement, 
+** including the above license grant, this restriction and the following 
+** disclaimer, must be included in all copies of the Software, in whole or in 
+** part, and all derivative works of the Software, unless such copies or 
+** derivative works are solely in the form of machine-executable object code 
+** generated by a source language processor.
+** 
+** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+** DEALINGS IN THE SOFTWARE.
+** 
+** A copy of the Software is available free of charge at 
+** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+** 
+** -LICENSE-END-
+*/
+
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "DeckLinkAPI.h"
+#include "AncillaryCodec.h"
+
+// A timed SCTE-104 splice request, in output frames from the start of playback
+struct SpliceEvent
+{
+	int64_t		spliceFrame;
+	uint32_t	preRollFrames;			// First message is sent this many frames before the splice, 0 for immediate types
+	uint8_t		spliceInsertType;
+	uint32_t	spliceEventID;
+	uint16_t	uniqueProgramID;
+	uint16_t	breakDuration;			// Tenths of a second
+	uint8_t		availNum;
+	uint8_t		availsExpected;
+	bool		autoReturn;
+};
+
+// Schedules SCTE-104 splice requests onto output frames.
+//
+// Events are read from a file, one per line, or from datagrams sent to a local socket, one event per datagram:
+//
+//     <time> <start|start-immediate|end|end-immediate|cancel> event=<id> [program=<id>] [duration=<seconds>]
+//         [preroll=<ms>] [avail=<num>] [avails=<expected>] [noreturn]
+//
+// where <time> is an output frame number, a time code HH:MM:SS:FF (HH:MM:SS;FF for drop frame) from the start of
+// playback, or +<seconds> from the next frame to be scheduled.  Each event is encoded into all of its SMPTE 2010
+// packets when it is added: for normal splices the first is sent the pre-roll time before the splice point and is
+// repeated every repeat interval, each with the pre-roll time remaining, so the scheduling thread only copies the
+// packets due on each frame.
+class SpliceScheduler
+{
+public:
+	struct Statistics
+	{
+		uint64_t	eventsScheduled;
+		uint64_t	eventsLate;			// Splice point already scheduled when the event arrived
+		uint64_t	messagesSent;
+		uint64_t	messagesMissed;		// Due on a frame that could not carry them
+	};
+
+	static const uint32_t kDefaultPreRollMs = 4000;
+
+	SpliceScheduler(BMDTimeValue frameDuration, BMDTimeScale timeScale, uint32_t repeatIntervalFrames);
+	~SpliceScheduler();
+
+	// Events from a file are added again whenever the scheduler is reset
+	bool				loadFile(const char* path);
+	bool				startListening(const char* socketPath);
+	void				stopListening();
+
+	// Restart from frame 0, for a restart of playback
+	void				reset();
+
+	bool				parseEvent(const char* line, SpliceEvent* event);
+	bool				addEvent(const SpliceEvent& event);
+
+	// Called once for each frame in order from the scheduling thread, copies the packets due on the frame into buffers
+	// and returns their number.  Packets beyond maximumPackets are counted as missed.
+	size_t				getPacketsForFrame(int64_t frame, AncillaryPacketBuffer* const* buffers, size_t maximumPackets);
+
+	// Number of frames from frame to the splice point for a message carrying preRollTimeMs
+	int64_t				preRollTimeToFrames(uint16_t preRollTimeMs) const;
+
+	Statistics			getStatistics();
+	const std::vector<SpliceEvent>&	getFileEvents() const { return m_fileEvents; }
+
+private:
+	struct Transmission
+	{
+		int64_t					frame;
+		AncillaryPacketBuffer	packet;
+	};
+
+	uint16_t			framesToPreRollTime(int64_t frames) const;
+	bool				addEventLocked(const SpliceEvent& event);
+	void				listen();
+
+	BMDTimeValue				m_frameDuration;
+	BMDTimeScale				m_timeScale;
+	uint32_t					m_framesPerSecond;
+	uint32_t					m_repeatIntervalFrames;
+
+	std::mutex					m_mutex;
+	std::deque<Transmission>	m_transmissions;	// Ordered by frame
+	std::vector<SpliceEvent>	m_fileEvents;
+	int64_t						m_nextFrame;
+	uint8_t						m_messageNumber;
+	Statistics					m_statistics;
+
+	int							m_socket;
+	std::string					m_socketPath;
+	std::thread					m_listenThread;
+	std::atomic<bool>			m_listening;
+};
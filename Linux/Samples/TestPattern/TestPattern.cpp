@@ -53,6 +53,7 @@
 #include <arpa/inet.h>
 
 #include "TestPattern.h"
+#include "SpliceLoopbackTest.h"
 #include "VideoFrame3D.h"
 
 pthread_mutex_t			sleepMutex;
@@ -88,6 +89,12 @@ int main(int argc, char *argv[])
 		goto bail;
 	}
 
+	if (config.m_spliceLoopbackTest)
+	{
+		exitStatus = RunSpliceLoopbackTest(config.m_spliceEventFile) ? 0 : 1;
+		goto bail;
+	}
+
 	generator = new TestPattern(&config);
 
 	if (!generator->Run())
@@ -121,7 +128,9 @@ TestPattern::TestPattern(BMDConfig *config) :
 	m_videoFrameBars(),
 	m_outputSignal(kOutputSignalDrop),
 	m_audioBuffer(),
-	m_audioSampleRate(bmdAudioSampleRate48kHz)
+	m_audioSampleRate(bmdAudioSampleRate48kHz),
+	m_spliceScheduler(),
+	m_spliceCueFrames()
 {
 }
 
@@ -205,6 +214,28 @@ bool TestPattern::Run()
 		goto bail;
 	}
 
+	// Messages are repeated once a second during the pre-roll of each splice
+	if (m_config->m_spliceEventFile != NULL || m_config->m_spliceEventSocket != NULL)
+	{
+		BMDTimeValue	frameDuration;
+		BMDTimeScale	frameTimescale;
+
+		if (m_config->m_outputFlags & bmdVideoOutputDualStream3D)
+		{
+			fprintf(stderr, "Splice events cannot be inserted into 3D output\n");
+			goto bail;
+		}
+
+		m_displayMode->GetFrameRate(&frameDuration, &frameTimescale);
+		m_spliceScheduler = new SpliceScheduler(frameDuration, frameTimescale, (uint32_t)((frameTimescale + frameDuration - 1) / frameDuration));
+
+		if (m_config->m_spliceEventFile != NULL && !m_spliceScheduler->loadFile(m_config->m_spliceEventFile))
+			goto bail;
+
+		if (m_config->m_spliceEventSocket != NULL && !m_spliceScheduler->startListening(m_config->m_spliceEventSocket))
+			goto bail;
+	}
+
 	m_config->DisplayConfiguration();
 
 	// Provide this class as a delegate to the audio and video output interfaces
@@ -230,6 +261,12 @@ bool TestPattern::Run()
 	printf("\n");
 
 bail:
+	if (m_spliceScheduler != NULL)
+	{
+		delete m_spliceScheduler;
+		m_spliceScheduler = NULL;
+	}
+
 	if (displayModeName != NULL)
 		free(displayModeName);
 
@@ -340,6 +377,15 @@ void TestPattern::StartRunning()
 		frame3D = NULL;
 	}
 
+	if (m_spliceScheduler != NULL)
+	{
+		if (!CreateSpliceCueFrames())
+			goto bail;
+
+		// Frame numbers restart with playback
+		m_spliceScheduler->reset();
+	}
+
 	// Begin video preroll by scheduling a second of frames in hardware
 	m_totalFramesScheduled = 0;
 	m_totalFramesDropped = 0;
@@ -392,6 +438,16 @@ void TestPattern::StopRunning()
 	if (m_audioBuffer != NULL)
 		free(m_audioBuffer);
 	m_audioBuffer = NULL;
+
+	ReleaseSpliceCueFrames();
+
+	if (m_spliceScheduler != NULL)
+	{
+		SpliceScheduler::Statistics statistics = m_spliceScheduler->getStatistics();
+		fprintf(stderr, "Splice events: %llu scheduled, %llu late, %llu SCTE-104 messages sent, %llu missed\n",
+			(unsigned long long)statistics.eventsScheduled, (unsigned long long)statistics.eventsLate,
+			(unsigned long long)statistics.messagesSent, (unsigned long long)statistics.messagesMissed);
+	}
 }
 
 void TestPattern::ScheduleNextFrame(bool prerolling)
@@ -403,37 +459,28 @@ void TestPattern::ScheduleNextFrame(bool prerolling)
 		if (m_running == false)
 			return;
 	}
+	bool					scheduleBars;
+	IDeckLinkVideoFrame*	frame;
+
 	if (m_outputSignal == kOutputSignalPip)
 	{
-		if ((m_totalFramesScheduled % m_framesPerSecond) == 0)
-		{
-			// On each second, schedule a frame of bars
-			if (m_deckLinkOutput->ScheduleVideoFrame(m_videoFrameBars, (m_totalFramesScheduled * m_frameDuration), m_frameDuration, m_frameTimescale) != S_OK)
-				return;
-		}
-		else
-		{
-			// Schedue frames of black
-			if (m_deckLinkOutput->ScheduleVideoFrame(m_videoFrameBlack, (m_totalFramesScheduled * m_frameDuration), m_frameDuration, m_frameTimescale) != S_OK)
-				return;
-		}
+		// On each second, schedule a frame of bars, otherwise frames of black
+		scheduleBars = (m_totalFramesScheduled % m_framesPerSecond) == 0;
 	}
 	else
 	{
-		if ((m_totalFramesScheduled % m_framesPerSecond) == 0)
-		{
-			// On each second, schedule a frame of black
-			if (m_deckLinkOutput->ScheduleVideoFrame(m_videoFrameBlack, (m_totalFramesScheduled * m_frameDuration), m_frameDuration, m_frameTimescale) != S_OK)
-				return;
-		}
-		else
-		{
-			// Schedue frames of color bars
-			if (m_deckLinkOutput->ScheduleVideoFrame(m_videoFrameBars, (m_totalFramesScheduled * m_frameDuration), m_frameDuration, m_frameTimescale) != S_OK)
-				return;
-		}
+		// On each second, schedule a frame of black, otherwise frames of color bars
+		scheduleBars = (m_totalFramesScheduled % m_framesPerSecond) != 0;
 	}
 
+	frame = scheduleBars ? m_videoFrameBars : m_videoFrameBlack;
+
+	if (m_spliceScheduler != NULL)
+		frame = AttachSpliceMessages(frame, scheduleBars);
+
+	if (m_deckLinkOutput->ScheduleVideoFrame(frame, (m_totalFramesScheduled * m_frameDuration), m_frameDuration, m_frameTimescale) != S_OK)
+		return;
+
 	m_totalFramesScheduled += 1;
 }
 
@@ -460,6 +507,94 @@ void TestPattern::WriteNextAudioSamples()
 	}
 }
 
+bool TestPattern::CreateSpliceCueFrames()
+{
+	for (size_t i = 0; i < kSpliceCueFramesPerPattern * 2; i++)
+	{
+		SpliceCueFrame& cueFrame = m_spliceCueFrames[i];
+
+		cueFrame.bars = (i >= kSpliceCueFramesPerPattern);
+		cueFrame.inUse = false;
+
+		if (CreateFrame(&cueFrame.frame, cueFrame.bars ? FillForwardColourBars : FillBlack) != S_OK)
+			return false;
+
+		if (cueFrame.frame->QueryInterface(IID_IDeckLinkVideoFrameAncillaryPackets, (void**)&cueFrame.ancillaryPackets) != S_OK)
+		{
+			fprintf(stderr, "Could not get ancillary packet store for splice events\n");
+			return false;
+		}
+
+		for (size_t j = 0; j < kMaxSplicePacketsPerFrame; j++)
+			cueFrame.packets[j] = new OutputAncillaryPacket();
+	}
+
+	return true;
+}
+
+void TestPattern::ReleaseSpliceCueFrames()
+{
+	for (SpliceCueFrame& cueFrame : m_spliceCueFrames)
+	{
+		if (cueFrame.ancillaryPackets != NULL)
+		{
+			cueFrame.ancillaryPackets->DetachAllPackets();
+			cueFrame.ancillaryPackets->Release();
+		}
+
+		if (cueFrame.frame != NULL)
+			cueFrame.frame->Release();
+
+		for (OutputAncillaryPacket*& packet : cueFrame.packets)
+		{
+			if (packet != NULL)
+				packet->Release();
+			packet = NULL;
+		}
+
+		cueFrame.ancillaryPackets = NULL;
+		cueFrame.frame = NULL;
+	}
+}
+
+IDeckLinkVideoFrame* TestPattern::AttachSpliceMessages(IDeckLinkVideoFrame* frame, bool bars)
+{
+	SpliceCueFrame*			cueFrame = NULL;
+	AncillaryPacketBuffer*	buffers[kMaxSplicePacketsPerFrame] = {};
+	size_t					count;
+
+	// Frames are scheduled and completed on the same thread once playback starts, so inUse needs no lock
+	for (SpliceCueFrame& candidate : m_spliceCueFrames)
+	{
+		if (!candidate.inUse && candidate.bars == bars)
+		{
+			cueFrame = &candidate;
+			break;
+		}
+	}
+
+	if (cueFrame == NULL)
+	{
+		// No copy is free, any packets due on this frame are counted as missed
+		m_spliceScheduler->getPacketsForFrame(m_totalFramesScheduled, buffers, 0);
+		return frame;
+	}
+
+	for (size_t i = 0; i < kMaxSplicePacketsPerFrame; i++)
+		buffers[i] = &cueFrame->packets[i]->getBuffer();
+
+	count = m_spliceScheduler->getPacketsForFrame(m_totalFramesScheduled, buffers, kMaxSplicePacketsPerFrame);
+	if (count == 0)
+		return frame;
+
+	cueFrame->ancillaryPackets->DetachAllPackets();
+	for (size_t i = 0; i < count; i++)
+		cueFrame->ancillaryPackets->AttachPacket(cueFrame->packets[i]);
+
+	cueFrame->inUse = true;
+	return cueFrame->frame;
+}
+
 HRESULT TestPattern::CreateFrame(IDeckLinkVideoFrame** frame, void (*fillFunc)(IDeckLinkVideoFrame*))
 {
 	HRESULT						result;
@@ -555,6 +690,12 @@ HRESULT TestPattern::ScheduledFrameCompleted(IDeckLinkVideoFrame* completedFrame
 	++m_totalFramesCompleted;
 	PrintStatusLine();
 
+	for (SpliceCueFrame& cueFrame : m_spliceCueFrames)
+	{
+		if (cueFrame.frame == completedFrame)
+			cueFrame.inUse = false;
+	}
+
 	// When a video frame has been released by the API, schedule another video frame to be output
 	ScheduleNextFrame(false);
 	return S_OK;
@@ -620,8 +761,8 @@ void FillSine(void* audioBuffer, unsigned long samplesToWrite, unsigned long cha
 void FillColourBars(IDeckLinkVideoFrame* theFrame, bool reverse)
 {
 	unsigned int*	nextWord;
-	unsigned long	width;
-	unsigned long	height;
+	long			width;
+	long			height;
 	unsigned int	bars[8] = {0xEA80EA80, 0xD292D210, 0xA910A9A5, 0x90229035, 0x6ADD6ACA, 0x51EF515A, 0x286D28EF, 0x10801080};
 
 	theFrame->GetBytes((void**)&nextWord);
@@ -42,7 +42,9 @@
 #include <condition_variable>
 
 #include "DeckLinkAPI.h"
+#include "AncillaryCodec.h"
 #include "Config.h"
+#include "SpliceScheduler.h"
 
 enum OutputSignal
 {
@@ -50,6 +52,20 @@ enum OutputSignal
 	kOutputSignalDrop		= 1
 };
 
+// The black and bars frames are scheduled many times over, so a frame carrying SCTE-104 packets is taken from a pool
+// of copies and returned to it when the frame completes
+static const size_t		kSpliceCueFramesPerPattern	= 4;
+static const size_t		kMaxSplicePacketsPerFrame	= 2;
+
+struct SpliceCueFrame
+{
+	IDeckLinkVideoFrame*					frame;
+	IDeckLinkVideoFrameAncillaryPackets*	ancillaryPackets;
+	OutputAncillaryPacket*					packets[kMaxSplicePacketsPerFrame];
+	bool									bars;
+	bool									inUse;
+};
+
 
 class TestPattern : public IDeckLinkVideoOutputCallback, public IDeckLinkAudioOutputCallback
 {
@@ -82,6 +98,9 @@ private:
 	std::mutex				m_mutex;
 	std::condition_variable	m_stoppedCondition;
 
+	SpliceScheduler*		m_spliceScheduler;
+	SpliceCueFrame			m_spliceCueFrames[kSpliceCueFramesPerPattern * 2];
+
 	~TestPattern();
 
 	// Signal Generator Implementation
@@ -90,6 +109,10 @@ private:
 	void			ScheduleNextFrame(bool prerolling);
 	void			WriteNextAudioSamples();
 
+	bool			CreateSpliceCueFrames();
+	void			ReleaseSpliceCueFrames();
+	IDeckLinkVideoFrame*	AttachSpliceMessages(IDeckLinkVideoFrame* frame, bool bars);
+
 	void			PrintStatusLine();
 
 public:
@@ -0,0 +1,915 @@
+/* -LICENSE-START-
+** Copyright (c) 2022 Blackmagic Design
+**  
+** Permission is hereby granted, free of charge, to any person or organization 
+** obtaining a copy of the software and accompanying documentation (the 
+** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+** and transmit the Software, and to prepare derivative works of the Software, 
+** and to permit third-parties to whom the Software is furnished to do so, in 
+** accordance with:
+** 
+** (1) if the Software is obtained from Blackmagic Design, the End User License 
+** Agreement for the Software Development Kit (“EULA”) available at 
+** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+** 
+** (2) if the Software is obtained from any third party, such licensing terms 
+** as notified by that third party,
+** 
+** and all subject to the following:
+** 
+** (3) the copyright notices in the Software and this entire statement, 
+** including the above license grant, this restriction and the following 
+** disclaimer, must be included in all copies of the Software, in whole or in 
+** part, and all derivative works of the Software, unless such copies or 
+** derivative works are solely in the form of machine-executable object code 
+** generated by a source language processor.
+** 
+** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+** DEALINGS IN THE SOFTWARE.
+** 
+** A copy of the Software is available free of charge at 
+** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+** 
+** -LICENSE-END-
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#include "VideoScopeAnalyzer.h"
+
+static const unsigned	kBandsPerThread		= 4;			// Bands of sampled rows for each thread, to balance the load
+static const uint32_t	kSumTaskEntries		= 16384;		// Scope entries summed by each task
+static const int32_t	kBlack				= 64;			// 10-bit limited range code values
+static const int32_t	kWhite				= 940;
+static const int32_t	kNeutralChroma		= 512;
+static const int32_t	kGamutMinimum		= 20;			// -5% and 105% of black to white, EBU R 103
+static const int32_t	kGamutMaximum		= 984;
+static const uint32_t	kBlackLevel			= kBlack / 4;
+static const uint32_t	kWhiteLevel			= kWhite / 4;
+static const unsigned	kCountSegments		= 4;			// Segments of each row counted in turn
+
+// Rec.709 conversion between limited range YCbCr and limited range RGB code values, Q12 fixed point
+static const int32_t	kFixedPointShift	= 12;
+static const int32_t	kFixedPointRound	= 1 << (kFixedPointShift - 1);
+static const double		kChromaToLuma		= 876.0 / 896.0;
+static const int32_t	kCrToR				= (int32_t)(1.5748 * kChromaToLuma * 4096.0 + 0.5);
+static const int32_t	kCbToG				= (int32_t)(0.1873 * kChromaToLuma * 4096.0 + 0.5);
+static const int32_t	kCrToG				= (int32_t)(0.4681 * kChromaToLuma * 4096.0 + 0.5);
+static const int32_t	kCbToB				= (int32_t)(1.8556 * kChromaToLuma * 4096.0 + 0.5);
+static const int32_t	kRToY				= (int32_t)(0.2126 * 4096.0 + 0.5);
+static const int32_t	kGToY				= (int32_t)(0.7152 * 4096.0 + 0.5);
+static const int32_t	kBToY				= 4096 - kRToY - kGToY;
+static const int32_t	kBYToCb				= (int32_t)(1.0 / (1.8556 * kChromaToLuma) * 4096.0 + 0.5);
+static const int32_t	kRYToCr				= (int32_t)(1.0 / (1.5748 * kChromaToLuma) * 4096.0 + 0.5);
+static const int32_t	kFullToLimited		= (int32_t)((kWhite - kBlack) / 255.0 * 4096.0 + 0.5);
+
+// Location of each pixel's luma, and each pixel pair's chroma, in a group of 6 v210 pixels as word and shift
+static const uint8_t	kV210LumaWord[6]	= { 0, 1, 1, 2, 3, 3 };
+static const uint8_t	kV210LumaShift[6]	= { 10, 0, 20, 10, 0, 20 };
+static const uint8_t	kV210CbWord[3]		= { 0, 1, 2 };
+static const uint8_t	kV210CbShift[3]		= { 0, 10, 20 };
+static const uint8_t	kV210CrWord[3]		= { 0, 2, 3 };
+static const uint8_t	kV210CrShift[3]		= { 20, 0, 10 };
+
+static inline bool is8BitFormat(BMDPixelFormat pixelFormat)
+{
+	return (pixelFormat == bmdFormat8BitYUV) || (pixelFormat == bmdFormat8BitBGRA);
+}
+
+static inline uint8_t toLevel(int32_t value)
+{
+	return (uint8_t)(std::min(std::max(value, 0), 1023) >> 2);
+}
+
+static inline bool isOutOfGamut(int32_t value)
+{
+	return (value < kGamutMinimum) || (value > kGamutMaximum);
+}
+
+static inline bool isRGBFormat(BMDPixelFormat pixelFormat)
+{
+	return (pixelFormat == bmdFormat10BitRGB) || (pixelFormat == bmdFormat8BitBGRA);
+}
+
+// Unpack kernels
+//
+// Extract count samples of each component from the words at offsets in the row, shifted right by shifts, and
+// scale them to 10-bit limited range code values.  10-bit RGB words are big-endian.
+
+static inline uint16_t unpackComponent(const uint8_t* word, uint32_t shift, BMDPixelFormat pixelFormat)
+{
+	uint32_t value;
+
+	memcpy(&value, word, sizeof(value));
+
+	if (pixelFormat == bmdFormat10BitRGB)
+		value = __builtin_bswap32(value);
+
+	value >>= shift;
+
+	switch (pixelFormat)
+	{
+		case bmdFormat8BitYUV:		return (uint16_t)((value & 0xff) << 2);
+		case bmdFormat8BitBGRA:		return (uint16_t)(kBlack + (((value & 0xff) * kFullToLimited + kFixedPointRound) >> kFixedPointShift));
+		default:					return (uint16_t)(value & 0x3ff);
+	}
+}
+
+static void unpackSamplesScalar(const uint8_t* row, const uint32_t* const offsets[3], const uint32_t* const shifts[3], uint32_t count, BMDPixelFormat pixelFormat, uint16_t* const components[3])
+{
+	for (unsigned component = 0; component < 3; component++)
+	{
+		for (uint32_t i = 0; i < count; i++)
+			components[component][i] = unpackComponent(row + offsets[component][i], shifts[component][i], pixelFormat);
+	}
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("avx2")))
+static void unpackSamplesAVX2(const uint8_t* row, const uint32_t* const offsets[3], const uint32_t* const shifts[3], uint32_t count, BMDPixelFormat pixelFormat, uint16_t* const components[3])
+{
+	const __m256i	byteSwap = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+												3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+	const __m256i	mask = _mm256_set1_epi32(is8BitFormat(pixelFormat) ? 0xff : 0x3ff);
+	const __m256i	fullToLimited = _mm256_set1_epi32(kFullToLimited);
+	const __m256i	round = _mm256_set1_epi32(kFixedPointRound);
+	const __m256i	black = _mm256_set1_epi32(kBlack);
+	uint32_t		vectorCount = count & ~7u;
+
+	for (unsigned component = 0; component < 3; component++)
+	{
+		for (uint32_t i = 0; i < vectorCount; i += 8)
+		{
+			__m256i word = _mm256_i32gather_epi32((const int*)row, _mm256_loadu_si256((const __m256i*)(offsets[component] + i)), 1);
+
+			if (pixelFormat == bmdFormat10BitRGB)
+				word = _mm256_shuffle_epi8(word, byteSwap);
+
+			__m256i value = _mm256_and_si256(_mm256_srlv_epi32(word, _mm256_loadu_si256((const __m256i*)(shifts[component] + i))), mask);
+
+			if (pixelFormat == bmdFormat8BitYUV)
+				value = _mm256_slli_epi32(value, 2);
+			else if (pixelFormat == bmdFormat8BitBGRA)
+				value = _mm256_add_epi32(black, _mm256_srli_epi32(_mm256_add_epi32(_mm256_mullo_epi32(value, fullToLimited), round), kFixedPointShift));
+
+			__m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(value, value), 0x08);
+			_mm_storeu_si128((__m128i*)(components[component] + i), _mm256_castsi256_si128(packed));
+		}
+
+		for (uint32_t i = vectorCount; i < count; i++)
+			components[component][i] = unpackComponent(row + offsets[component][i], shifts[component][i], pixelFormat);
+	}
+}
+#endif
+
+// Conversion kernels
+//
+// Convert count samples of 10-bit components to levels of Y, Cb, Cr, R, G and B, and return the number of samples
+// out of gamut.  All kernels use the same fixed point arithmetic so give identical results.
+
+static uint32_t convertYCbCrScalar(const uint16_t* const components[3], uint32_t count, uint8_t* const levels[6])
+{
+	uint32_t gamutErrors = 0;
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		int32_t y = components[0][i];
+		int32_t cb = components[1][i] - kNeutralChroma;
+		int32_t cr = components[2][i] - kNeutralChroma;
+
+		int32_t r = y + ((kCrToR * cr + kFixedPointRound) >> kFixedPointShift);
+		int32_t g = y - ((kCbToG * cb + kCrToG * cr + kFixedPointRound) >> kFixedPointShift);
+		int32_t b = y + ((kCbToB * cb + kFixedPointRound) >> kFixedPointShift);
+
+		levels[0][i] = toLevel(y);
+		levels[1][i] = toLevel(cb + kNeutralChroma);
+		levels[2][i] = toLevel(cr + kNeutralChroma);
+		levels[3][i] = toLevel(r);
+		levels[4][i] = toLevel(g);
+		levels[5][i] = toLevel(b);
+
+		if (isOutOfGamut(r) || isOutOfGamut(g) || isOutOfGamut(b))
+			gamutErrors++;
+	}
+
+	return gamutErrors;
+}
+
+static uint32_t convertRGBScalar(const uint16_t* const components[3], uint32_t count, uint8_t* const levels[6])
+{
+	uint32_t gamutErrors = 0;
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		int32_t r = components[0][i];
+		int32_t g = components[1][i];
+		int32_t b = components[2][i];
+
+		int32_t y = (kRToY * r + kGToY * g + kBToY * b + kFixedPointRound) >> kFixedPointShift;
+		int32_t cb = kNeutralChroma + ((kBYToCb * (b - y) + kFixedPointRound) >> kFixedPointShift);
+		int32_t cr = kNeutralChroma + ((kRYToCr * (r - y) + kFixedPointRound) >> kFixedPointShift);
+
+		levels[0][i] = toLevel(y);
+		levels[1][i] = toLevel(cb);
+		levels[2][i] = toLevel(cr);
+		levels[3][i] = toLevel(r);
+		levels[4][i] = toLevel(g);
+		levels[5][i] = toLevel(b);
+
+		if (isOutOfGamut(r) || isOutOfGamut(g) || isOutOfGamut(b))
+			gamutErrors++;
+	}
+
+	return gamutErrors;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("avx2")))
+static inline void storeLevelsAVX2(__m256i values, uint8_t* levels)
+{
+	// Negative values saturate to 0 and values above 1023 to 255
+	__m256i packed = _mm256_packus_epi32(_mm256_srai_epi32(values, 2), _mm256_setzero_si256());
+	packed = _mm256_packus_epi16(packed, _mm256_setzero_si256());
+	__m128i combined = _mm_unpacklo_epi32(_mm256_castsi256_si128(packed), _mm256_extracti128_si256(packed, 1));
+	_mm_storel_epi64((__m128i*)levels, combined);
+}
+
+__attribute__((target("avx2")))
+static inline uint32_t countOutOfGamutAVX2(__m256i r, __m256i g, __m256i b)
+{
+	const __m256i minimum = _mm256_set1_epi32(kGamutMinimum);
+	const __m256i maximum = _mm256_set1_epi32(kGamutMaximum);
+
+	__m256i outOfGamut = _mm256_or_si256(_mm256_or_si256(_mm256_cmpgt_epi32(minimum, r), _mm256_cmpgt_epi32(r, maximum)),
+										 _mm256_or_si256(_mm256_cmpgt_epi32(minimum, g), _mm256_cmpgt_epi32(g, maximum)));
+	outOfGamut = _mm256_or_si256(outOfGamut, _mm256_or_si256(_mm256_cmpgt_epi32(minimum, b), _mm256_cmpgt_epi32(b, maximum)));
+
+	return (uint32_t)__builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(outOfGamut)));
+}
+
+__attribute__((target("avx2")))
+static inline __m256i fixedPointProductAVX2(__m256i product)
+{
+	return _mm256_srai_epi32(_mm256_add_epi32(product, _mm256_set1_epi32(kFixedPointRound)), kFixedPointShift);
+}
+
+__attribute__((target("avx2")))
+static uint32_t convertYCbCrAVX2(const uint16_t* const components[3], uint32_t count, uint8_t* const levels[6])
+{
+	const __m256i	neutral = _mm256_set1_epi32(kNeutralChroma);
+	uint32_t		gamutErrors = 0;
+	uint32_t		i = 0;
+
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256i y = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(components[0] + i)));
+		__m256i cb = _mm256_sub_epi32(_mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(components[1] + i))), neutral);
+		__m256i cr = _mm256_sub_epi32(_mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(components[2] + i))), neutral);
+
+		__m256i r = _mm256_add_epi32(y, fixedPointProductAVX2(_mm256_mullo_epi32(cr, _mm256_set1_epi32(kCrToR))));
+		__m256i g = _mm256_sub_epi32(y, fixedPointProductAVX2(_mm256_add_epi32(_mm256_mullo_epi32(cb, _mm256_set1_epi32(kCbToG)),
+																				 _mm256_mullo_epi32(cr, _mm256_set1_epi32(kCrToG)))));
+		__m256i b = _mm256_add_epi32(y, fixedPointProductAVX2(_mm256_mullo_epi32(cb, _mm256_set1_epi32(kCbToB))));
+
+		storeLevelsAVX2(y, levels[0] + i);
+		storeLevelsAVX2(_mm256_add_epi32(cb, neutral), levels[1] + i);
+		storeLevelsAVX2(_mm256_add_epi32(cr, neutral), levels[2] + i);
+		storeLevelsAVX2(r, levels[3] + i);
+		storeLevelsAVX2(g, levels[4] + i);
+		storeLevelsAVX2(b, levels[5] + i);
+
+		gamutErrors += countOutOfGamutAVX2(r, g, b);
+	}
+
+	const uint16_t* const	remainingComponents[3] = { components[0] + i, components[1] + i, components[2] + i };
+	uint8_t* const			remainingLevels[6] = { levels[0] + i, levels[1] + i, levels[2] + i, levels[3] + i, levels[4] + i, levels[5] + i };
+
+	return gamutErrors + convertYCbCrScalar(remainingComponents, count - i, remainingLevels);
+}
+
+__attribute__((target("avx2")))
+static uint32_t convertRGBAVX2(const uint16_t* const components[3], uint32_t count, uint8_t* const levels[6])
+{
+	const __m256i	neutral = _mm256_set1_epi32(kNeutralChroma);
+	uint32_t		gamutErrors = 0;
+	uint32_t		i = 0;
+
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256i r = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(components[0] + i)));
+		__m256i g = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(components[1] + i)));
+		__m256i b = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(components[2] + i)));
+
+		__m256i y = fixedPointProductAVX2(_mm256_add_epi32(_mm256_add_epi32(_mm256_mullo_epi32(r, _mm256_set1_epi32(kRToY)),
+																			_mm256_mullo_epi32(g, _mm256_set1_epi32(kGToY))),
+														   _mm256_mullo_epi32(b, _mm256_set1_epi32(kBToY))));
+		__m256i cb = _mm256_add_epi32(neutral, fixedPointProductAVX2(_mm256_mullo_epi32(_mm256_sub_epi32(b, y), _mm256_set1_epi32(kBYToCb))));
+		__m256i cr = _mm256_add_epi32(neutral, fixedPointProductAVX2(_mm256_mullo_epi32(_mm256_sub_epi32(r, y), _mm256_set1_epi32(kRYToCr))));
+
+		storeLevelsAVX2(y, levels[0] + i);
+		storeLevelsAVX2(cb, levels[1] + i);
+		storeLevelsAVX2(cr, levels[2] + i);
+		storeLevelsAVX2(r, levels[3] + i);
+		storeLevelsAVX2(g, levels[4] + i);
+		storeLevelsAVX2(b, levels[5] + i);
+
+		gamutErrors += countOutOfGamutAVX2(r, g, b);
+	}
+
+	const uint16_t* const	remainingComponents[3] = { components[0] + i, components[1] + i, components[2] + i };
+	uint8_t* const			remainingLevels[6] = { levels[0] + i, levels[1] + i, levels[2] + i, levels[3] + i, levels[4] + i, levels[5] + i };
+
+	return gamutErrors + convertRGBScalar(remainingComponents, count - i, remainingLevels);
+}
+#elif defined(__aarch64__)
+static inline void storeLevelsNEON(int32x4_t low, int32x4_t high, uint8_t* levels)
+{
+	// Negative values saturate to 0 and values above 1023 to 255
+	uint16x8_t values = vcombine_u16(vqmovun_s32(vshrq_n_s32(low, 2)), vqmovun_s32(vshrq_n_s32(high, 2)));
+	vst1_u8(levels, vqmovn_u16(values));
+}
+
+static inline uint32x4_t outOfGamutNEON(int32x4_t r, int32x4_t g, int32x4_t b)
+{
+	const int32x4_t minimum = vdupq_n_s32(kGamutMinimum);
+	const int32x4_t maximum = vdupq_n_s32(kGamutMaximum);
+
+	uint32x4_t outOfGamut = vorrq_u32(vorrq_u32(vcltq_s32(r, minimum), vcgtq_s32(r, maximum)),
+									  vorrq_u32(vcltq_s32(g, minimum), vcgtq_s32(g, maximum)));
+	return vorrq_u32(outOfGamut, vorrq_u32(vcltq_s32(b, minimum), vcgtq_s32(b, maximum)));
+}
+
+static inline int32x4_t fixedPointProductNEON(int32x4_t product)
+{
+	return vshrq_n_s32(vaddq_s32(product, vdupq_n_s32(kFixedPointRound)), kFixedPointShift);
+}
+
+static inline void loadComponentsNEON(const uint16_t* components, int32x4_t& low, int32x4_t& high)
+{
+	uint16x8_t values = vld1q_u16(components);
+	low = vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(values)));
+	high = vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(values)));
+}
+
+static uint32_t convertYCbCrNEON(const uint16_t* const components[3], uint32_t count, uint8_t* const levels[6])
+{
+	uint32_t	gamutErrors = 0;
+	uint32_t	i = 0;
+
+	for (; i + 8 <= count; i += 8)
+	{
+		int32x4_t	y[2], cb[2], cr[2], r[2], g[2], b[2];
+		uint32x4_t	outOfGamut[2];
+
+		loadComponentsNEON(components[0] + i, y[0], y[1]);
+		loadComponentsNEON(components[1] + i, cb[0], cb[1]);
+		loadComponentsNEON(components[2] + i, cr[0], cr[1]);
+
+		for (unsigned half = 0; half < 2; half++)
+		{
+			int32x4_t chromaB = vsubq_s32(cb[half], vdupq_n_s32(kNeutralChroma));
+			int32x4_t chromaR = vsubq_s32(cr[half], vdupq_n_s32(kNeutralChroma));
+
+			r[half] = vaddq_s32(y[half], fixedPointProductNEON(vmulq_n_s32(chromaR, kCrToR)));
+			g[half] = vsubq_s32(y[half], fixedPointProductNEON(vmlaq_n_s32(vmulq_n_s32(chromaB, kCbToG), chromaR, kCrToG)));
+			b[half] = vaddq_s32(y[half], fixedPointProductNEON(vmulq_n_s32(chromaB, kCbToB)));
+			outOfGamut[half] = outOfGamutNEON(r[half], g[half], b[half]);
+		}
+
+		storeLevelsNEON(y[0], y[1], levels[0] + i);
+		storeLevelsNEON(cb[0], cb[1], levels[1] + i);
+		storeLevelsNEON(cr[0], cr[1], levels[2] + i);
+		storeLevelsNEON(r[0], r[1], levels[3] + i);
+		storeLevelsNEON(g[0], g[1], levels[4] + i);
+		storeLevelsNEON(b[0], b[1], levels[5] + i);
+
+		gamutErrors += vaddvq_u32(vshrq_n_u32(outOfGamut[0], 31)) + vaddvq_u32(vshrq_n_u32(outOfGamut[1], 31));
+	}
+
+	const uint16_t* const	remainingComponents[3] = { components[0] + i, components[1] + i, components[2] + i };
+	uint8_t* const			remainingLevels[6] = { levels[0] + i, levels[1] + i, levels[2] + i, levels[3] + i, levels[4] + i, levels[5] + i };
+
+	return gamutErrors + convertYCbCrScalar(remainingComponents, count - i, remainingLevels);
+}
+
+static uint32_t convertRGBNEON(const uint16_t* const components[3], uint32_t count, uint8_t* const levels[6])
+{
+	uint32_t	gamutErrors = 0;
+	uint32_t	i = 0;
+
+	for (; i + 8 <= count; i += 8)
+	{
+		int32x4_t	y[2], cb[2], cr[2], r[2], g[2], b[2];
+		uint32x4_t	outOfGamut[2];
+
+		loadComponentsNEON(components[0] + i, r[0], r[1]);
+		loadComponentsNEON(components[1] + i, g[0], g[1]);
+		loadComponentsNEON(components[2] + i, b[0], b[1]);
+
+		for (unsigned half = 0; half < 2; half++)
+		{
+			y[half] = fixedPointProductNEON(vmlaq_n_s32(vmlaq_n_s32(vmulq_n_s32(r[half], kRToY), g[half], kGToY), b[half], kBToY));
+			cb[half] = vaddq_s32(vdupq_n_s32(kNeutralChroma), fixedPointProductNEON(vmulq_n_s32(vsubq_s32(b[half], y[half]), kBYToCb)));
+			cr[half] = vaddq_s32(vdupq_n_s32(kNeutralChroma), fixedPointProductNEON(vmulq_n_s32(vsubq_s32(r[half], y[half]), kRYToCr)));
+			outOfGamut[half] = outOfGamutNEON(r[half], g[half], b[half]);
+		}
+
+		storeLevelsNEON(y[0], y[1], levels[0] + i);
+		storeLevelsNEON(cb[0], cb[1], levels[1] + i);
+		storeLevelsNEON(cr[0], cr[1], levels[2] + i);
+		storeLevelsNEON(r[0], r[1], levels[3] + i);
+		storeLevelsNEON(g[0], g[1], levels[4] + i);
+		storeLevelsNEON(b[0], b[1], levels[5] + i);
+
+		gamutErrors += vaddvq_u32(vshrq_n_u32(outOfGamut[0], 31)) + vaddvq_u32(vshrq_n_u32(outOfGamut[1], 31));
+	}
+
+	const uint16_t* const	remainingComponents[3] = { components[0] + i, components[1] + i, components[2] + i };
+	uint8_t* const			remainingLevels[6] = { levels[0] + i, levels[1] + i, levels[2] + i, levels[3] + i, levels[4] + i, levels[5] + i };
+
+	return gamutErrors + convertRGBScalar(remainingComponents, count - i, remainingLevels);
+}
+#endif
+
+// VideoScopeAnalyzer
+
+VideoScopeAnalyzer::VideoScopeAnalyzer(uint32_t waveformColumns, uint32_t horizontalStep, uint32_t verticalStep, unsigned threadCount) :
+	m_horizontalStep(std::max(horizontalStep, 1u)),
+	m_verticalStep(std::max(verticalStep, 1u)),
+	m_unpackFunction(unpackSamplesScalar),
+	m_convertYCbCrFunction(convertYCbCrScalar),
+	m_convertRGBFunction(convertRGBScalar),
+	m_samplePixelFormat(bmdFormat8BitYUV),
+	m_taskCount(0),
+	m_nextTask(0),
+	m_jobGeneration(0),
+	m_busyWorkers(0),
+	m_stopWorkers(false)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	if (__builtin_cpu_supports("avx2"))
+	{
+		m_unpackFunction = unpackSamplesAVX2;
+		m_convertYCbCrFunction = convertYCbCrAVX2;
+		m_convertRGBFunction = convertRGBAVX2;
+	}
+#elif defined(__aarch64__)
+	// There is no NEON gather, so samples are unpacked with the scalar kernel
+	m_convertYCbCrFunction = convertYCbCrNEON;
+	m_convertRGBFunction = convertRGBNEON;
+#endif
+
+	if (threadCount == 0)
+		threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+
+	waveformColumns = std::max(waveformColumns, 1u);
+
+	for (VideoScopeData* data : { &m_data, &m_latestData })
+	{
+		data->waveformColumns = waveformColumns;
+		data->lumaWaveform.assign(VideoScopeData::kLevels * waveformColumns, 0);
+		data->rgbParade.assign(3 * VideoScopeData::kLevels * waveformColumns, 0);
+		data->vectorscope.assign(VideoScopeData::kLevels * VideoScopeData::kLevels, 0);
+		data->histograms.assign(4 * VideoScopeData::kLevels, 0);
+		data->sampleCount = 0;
+		data->gamutErrorCount = 0;
+		data->frameCount = 0;
+		data->width = 0;
+		data->height = 0;
+		data->pixelFormat = bmdFormat8BitYUV;
+	}
+
+	m_scratch.resize(threadCount);
+	for (auto& scratch : m_scratch)
+	{
+		scratch.lumaWaveform.assign(m_data.lumaWaveform.size(), 0);
+		scratch.rgbParade.assign(m_data.rgbParade.size(), 0);
+		scratch.vectorscope.assign(m_data.vectorscope.size(), 0);
+		scratch.sampleCount = 0;
+		scratch.gamutErrorCount = 0;
+		scratch.used = false;
+	}
+
+	for (unsigned i = 0; i < threadCount - 1; i++)
+		m_workerThreads.emplace_back(&VideoScopeAnalyzer::workerThread, this, i);
+}
+
+VideoScopeAnalyzer::~VideoScopeAnalyzer()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopWorkers = true;
+	}
+	m_workCondition.notify_all();
+
+	for (auto& worker : m_workerThreads)
+		worker.join();
+}
+
+bool VideoScopeAnalyzer::isPixelFormatSupported(BMDPixelFormat pixelFormat)
+{
+	return (pixelFormat == bmdFormat8BitYUV) || (pixelFormat == bmdFormat10BitYUV) ||
+		(pixelFormat == bmdFormat10BitRGB) || (pixelFormat == bmdFormat8BitBGRA);
+}
+
+const char* VideoScopeAnalyzer::getConversionKernelName() const
+{
+#if defined(__x86_64__) || defined(__i386__)
+	if (m_convertYCbCrFunction == convertYCbCrAVX2)
+		return "AVX2";
+#elif defined(__aarch64__)
+	if (m_convertYCbCrFunction == convertYCbCrNEON)
+		return "NEON";
+#endif
+	return "scalar";
+}
+
+bool VideoScopeAnalyzer::analyze(IDeckLinkVideoFrame* videoFrame)
+{
+	void* pixels;
+
+	if (videoFrame->GetBytes(&pixels) != S_OK)
+		return false;
+
+	return analyze(pixels, (uint32_t)videoFrame->GetRowBytes(), (uint32_t)videoFrame->GetWidth(), (uint32_t)videoFrame->GetHeight(), videoFrame->GetPixelFormat());
+}
+
+bool VideoScopeAnalyzer::analyze(const void* pixels, uint32_t rowBytes, uint32_t width, uint32_t height, BMDPixelFormat pixelFormat)
+{
+	if (!isPixelFormatSupported(pixelFormat) || (width == 0) || (height == 0))
+		return false;
+
+	if ((width != m_data.width) || (pixelFormat != m_samplePixelFormat) || m_sampleColumns.empty())
+		buildSampleLayout(width, pixelFormat);
+
+	m_job.pixels			= (const uint8_t*)pixels;
+	m_job.rowBytes			= rowBytes;
+	m_job.width				= width;
+	m_job.height			= height;
+	m_job.pixelFormat		= pixelFormat;
+	m_job.sampledRowCount	= (height + m_verticalStep - 1) / m_verticalStep;
+	m_job.bandCount			= std::min(m_job.sampledRowCount, getThreadCount() * kBandsPerThread);
+
+	parallelFor(m_job.bandCount, [this](unsigned threadIndex, unsigned band) { analyzeBand(threadIndex, band); });
+
+	uint32_t lumaTaskCount = (uint32_t)((m_data.lumaWaveform.size() + kSumTaskEntries - 1) / kSumTaskEntries);
+	uint32_t sumTaskCount = lumaTaskCount * 4 + (uint32_t)((m_data.vectorscope.size() + kSumTaskEntries - 1) / kSumTaskEntries);
+
+	parallelFor(sumTaskCount, [this](unsigned, unsigned task) { sumScopes(task); });
+
+	m_data.sampleCount = 0;
+	m_data.gamutErrorCount = 0;
+	for (auto& scratch : m_scratch)
+	{
+		m_data.sampleCount += scratch.sampleCount;
+		m_data.gamutErrorCount += scratch.gamutErrorCount;
+		scratch.sampleCount = 0;
+		scratch.gamutErrorCount = 0;
+		scratch.used = false;
+	}
+
+	// Histograms are the sums of the rows of the waveforms
+	const uint32_t columns = m_data.waveformColumns;
+	for (uint32_t component = 0; component < 4; component++)
+	{
+		const uint32_t* waveform = (component == 0) ? m_data.lumaWaveform.data() : m_data.rgbParade.data() + (component - 1) * VideoScopeData::kLevels * columns;
+
+		for (uint32_t level = 0; level < VideoScopeData::kLevels; level++, waveform += columns)
+		{
+			uint32_t count = 0;
+			for (uint32_t column = 0; column < columns; column++)
+				count += waveform[column];
+			m_data.histograms[component * VideoScopeData::kLevels + level] = count;
+		}
+	}
+
+	m_data.frameCount++;
+	m_data.width = width;
+	m_data.height = height;
+	m_data.pixelFormat = pixelFormat;
+
+	{
+		std::lock_guard<std::mutex> lock(m_latestDataMutex);
+		std::swap(m_data, m_latestData);
+	}
+
+	// Keep the frame count and width, the scopes are overwritten by the next frame
+	m_data.frameCount = m_latestData.frameCount;
+	m_data.width = m_latestData.width;
+
+	return true;
+}
+
+void VideoScopeAnalyzer::buildSampleLayout(uint32_t width, BMDPixelFormat pixelFormat)
+{
+	uint32_t sampleCount = (width + m_horizontalStep - 1) / m_horizontalStep;
+
+	m_sampleColumns.resize(sampleCount);
+	for (auto& offsets : m_sampleOffsets)
+		offsets.resize(sampleCount);
+	for (auto& shifts : m_sampleShifts)
+		shifts.resize(sampleCount);
+
+	for (uint32_t i = 0, x = 0; i < sampleCount; i++, x += m_horizontalStep)
+	{
+		uint32_t offsets[3];
+		uint32_t shifts[3];
+
+		switch (pixelFormat)
+		{
+			case bmdFormat8BitYUV:
+				// Cb Y0 Cr Y1 in one word for each pair of pixels
+				offsets[0] = offsets[1] = offsets[2] = (x / 2) * 4;
+				shifts[0] = (x & 1) ? 24 : 8;
+				shifts[1] = 0;
+				shifts[2] = 16;
+				break;
+
+			case bmdFormat10BitYUV:
+			{
+				// Groups of 6 pixels in 4 words
+				uint32_t group = (x / 6) * 16;
+				uint32_t pixel = x % 6;
+				uint32_t pair = pixel / 2;
+				offsets[0] = group + kV210LumaWord[pixel] * 4;
+				offsets[1] = group + kV210CbWord[pair] * 4;
+				offsets[2] = group + kV210CrWord[pair] * 4;
+				shifts[0] = kV210LumaShift[pixel];
+				shifts[1] = kV210CbShift[pair];
+				shifts[2] = kV210CrShift[pair];
+				break;
+			}
+
+			case bmdFormat10BitRGB:
+				// 2 padding bits then R G B, once byte swapped
+				offsets[0] = offsets[1] = offsets[2] = x * 4;
+				shifts[0] = 20;
+				shifts[1] = 10;
+				shifts[2] = 0;
+				break;
+
+			default:
+				// B G R A
+				offsets[0] = offsets[1] = offsets[2] = x * 4;
+				shifts[0] = 16;
+				shifts[1] = 8;
+				shifts[2] = 0;
+				break;
+		}
+
+		for (unsigned component = 0; component < 3; component++)
+		{
+			m_sampleOffsets[component][i] = offsets[component];
+			m_sampleShifts[component][i] = shifts[component];
+		}
+
+		m_sampleColumns[i] = (uint16_t)((uint64_t)x * m_data.waveformColumns / width);
+	}
+
+	for (auto& scratch : m_scratch)
+	{
+		for (auto& components : scratch.components)
+			components.resize(sampleCount);
+		for (auto& levels : scratch.levels)
+			levels.resize(sampleCount);
+	}
+
+	m_samplePixelFormat = pixelFormat;
+}
+
+bool VideoScopeAnalyzer::getLatestData(VideoScopeData& data)
+{
+	std::lock_guard<std::mutex> lock(m_latestDataMutex);
+
+	if (m_latestData.frameCount == 0)
+		return false;
+
+	data = m_latestData;
+	return true;
+}
+
+void VideoScopeAnalyzer::analyzeBand(unsigned threadIndex, unsigned band)
+{
+	ThreadScratch&	scratch = m_scratch[threadIndex];
+	uint32_t		firstRow = band * m_job.sampledRowCount / m_job.bandCount;
+	uint32_t		endRow = (band + 1) * m_job.sampledRowCount / m_job.bandCount;
+	uint32_t		sampleCount = (uint32_t)m_sampleColumns.size();
+	uint32_t		columns = m_data.waveformColumns;
+	uint32_t		planeSize = VideoScopeData::kLevels * columns;
+	ConvertFunction	convertFunction = isRGBFormat(m_job.pixelFormat) ? m_convertRGBFunction : m_convertYCbCrFunction;
+
+	const uint32_t* const	offsets[3] = { m_sampleOffsets[0].data(), m_sampleOffsets[1].data(), m_sampleOffsets[2].data() };
+	const uint32_t* const	shifts[3] = { m_sampleShifts[0].data(), m_sampleShifts[1].data(), m_sampleShifts[2].data() };
+	uint16_t* const			components[3] = { scratch.components[0].data(), scratch.components[1].data(), scratch.components[2].data() };
+	uint8_t* const			levels[6] = { scratch.levels[0].data(), scratch.levels[1].data(), scratch.levels[2].data(),
+										  scratch.levels[3].data(), scratch.levels[4].data(), scratch.levels[5].data() };
+	uint32_t*				lumaWaveform = scratch.lumaWaveform.data();
+	uint32_t*				redWaveform = scratch.rgbParade.data();
+	uint32_t*				greenWaveform = redWaveform + planeSize;
+	uint32_t*				blueWaveform = greenWaveform + planeSize;
+	uint32_t*				vectorscope = scratch.vectorscope.data();
+	const uint16_t*			sampleColumns = m_sampleColumns.data();
+
+	uint32_t				segmentLength = sampleCount / kCountSegments;
+
+	auto countSample = [&](uint32_t i)
+	{
+		uint32_t column = sampleColumns[i];
+
+		lumaWaveform[levels[0][i] * columns + column]++;
+		redWaveform[levels[3][i] * columns + column]++;
+		greenWaveform[levels[4][i] * columns + column]++;
+		blueWaveform[levels[5][i] * columns + column]++;
+		vectorscope[levels[2][i] * VideoScopeData::kLevels + levels[1][i]]++;
+	};
+
+	scratch.used = true;
+
+	for (uint32_t sampledRow = firstRow; sampledRow < endRow; sampledRow++)
+	{
+		m_unpackFunction(m_job.pixels + (size_t)sampledRow * m_verticalStep * m_job.rowBytes, offsets, shifts, sampleCount, m_job.pixelFormat, components);
+		scratch.gamutErrorCount += convertFunction(components, sampleCount, levels);
+
+		// Neighbouring samples are often equal, counting samples from each segment in turn keeps several
+		// independent counters in flight
+		for (uint32_t i = 0; i < segmentLength; i++)
+		{
+			for (unsigned segment = 0; segment < kCountSegments; segment++)
+				countSample(i + segment * segmentLength);
+		}
+
+		for (uint32_t i = segmentLength * kCountSegments; i < sampleCount; i++)
+			countSample(i);
+	}
+
+	scratch.sampleCount += (uint64_t)sampleCount * (endRow - firstRow);
+}
+
+void VideoScopeAnalyzer::sumScopes(unsigned task)
+{
+	uint32_t	lumaTaskCount = (uint32_t)((m_data.lumaWaveform.size() + kSumTaskEntries - 1) / kSumTaskEntries);
+	uint32_t*	destination;
+	size_t		size;
+	size_t		offset;
+
+	// Tasks cover the luma waveform, the three waveforms of the parade, then the vectorscope
+	if (task < lumaTaskCount * 4)
+	{
+		size = m_data.lumaWaveform.size();
+		offset = (size_t)(task % lumaTaskCount) * kSumTaskEntries;
+		destination = (task < lumaTaskCount) ? m_data.lumaWaveform.data() : m_data.rgbParade.data() + (task / lumaTaskCount - 1) * size;
+	}
+	else
+	{
+		size = m_data.vectorscope.size();
+		offset = (size_t)(task - lumaTaskCount * 4) * kSumTaskEntries;
+		destination = m_data.vectorscope.data();
+	}
+
+	size_t count = std::min((size_t)kSumTaskEntries, size - offset);
+	std::fill(destination + offset, destination + offset + count, 0);
+
+	for (auto& scratch : m_scratch)
+	{
+		if (!scratch.used)
+			continue;
+
+		uint32_t* source;
+		if (destination == m_data.vectorscope.data())
+			source = scratch.vectorscope.data();
+		else if (destination == m_data.lumaWaveform.data())
+			source = scratch.lumaWaveform.data();
+		else
+			source = scratch.rgbParade.data() + (destination - m_data.rgbParade.data());
+
+		for (size_t i = offset; i < offset + count; i++)
+		{
+			destination[i] += source[i];
+			source[i] = 0;
+		}
+	}
+}
+
+void VideoScopeAnalyzer::summarize(const VideoScopeData& data, VideoScopeSummary& summary)
+{
+	const uint32_t*	lumaHistogram = data.histograms.data();
+	uint64_t		sampleCount = 0;
+	uint64_t		levelSum = 0;
+	uint64_t		belowBlackCount = 0;
+	uint64_t		aboveWhiteCount = 0;
+	uint32_t		minimumLevel = VideoScopeData::kLevels - 1;
+	uint32_t		maximumLevel = 0;
+
+	for (uint32_t level = 0; level < VideoScopeData::kLevels; level++)
+	{
+		uint32_t count = lumaHistogram[level];
+		if (count == 0)
+			continue;
+
+		minimumLevel = std::min(minimumLevel, level);
+		maximumLevel = std::max(maximumLevel, level);
+		sampleCount += count;
+		levelSum += (uint64_t)level * count;
+
+		if (level < kBlackLevel)
+			belowBlackCount += count;
+		else if (level > kWhiteLevel)
+			aboveWhiteCount += count;
+	}
+
+	// Levels are the centre of their range of code values
+	auto levelToPercent = [](double level) { return ((level * 4.0 + 1.5) - kBlack) * 100.0 / (kWhite - kBlack); };
+
+	if (sampleCount == 0)
+	{
+		summary = VideoScopeSummary();
+		return;
+	}
+
+	summary.lumaMinimum			= levelToPercent(minimumLevel);
+	summary.lumaAverage			= levelToPercent((double)levelSum / sampleCount);
+	summary.lumaMaximum			= levelToPercent(maximumLevel);
+	summary.belowBlackPercent	= belowBlackCount * 100.0 / sampleCount;
+	summary.aboveWhitePercent	= aboveWhiteCount * 100.0 / sampleCount;
+	summary.gamutErrorPercent	= data.gamutErrorCount * 100.0 / sampleCount;
+}
+
+void VideoScopeAnalyzer::renderDensity(const uint32_t* counts, uint32_t width, uint32_t height, uint8_t* image)
+{
+	uint32_t maximumCount = *std::max_element(counts, counts + (size_t)width * height);
+	double scale = (maximumCount > 0) ? 255.0 / std::log1p((double)maximumCount) : 0.0;
+
+	for (uint32_t y = 0; y < height; y++)
+	{
+		const uint32_t*	countRow = counts + (size_t)y * width;
+		uint8_t*		imageRow = image + (size_t)(height - 1 - y) * width;
+
+		for (uint32_t x = 0; x < width; x++)
+			imageRow[x] = (uint8_t)std::lround(std::log1p((double)countRow[x]) * scale);
+	}
+}
+
+// Worker pool, the calling thread runs tasks alongside the workers and uses the last scratch
+
+void VideoScopeAnalyzer::parallelFor(unsigned taskCount, const std::function<void(unsigned, unsigned)>& task)
+{
+	m_task		= task;
+	m_taskCount	= taskCount;
+	m_nextTask	= 0;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_busyWorkers = (unsigned)m_workerThreads.size();
+		m_jobGeneration++;
+	}
+	m_workCondition.notify_all();
+
+	runTasks((unsigned)m_workerThreads.size());
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_doneCondition.wait(lock, [&] { return m_busyWorkers == 0; });
+}
+
+void VideoScopeAnalyzer::runTasks(unsigned threadIndex)
+{
+	unsigned task;
+
+	while ((task = m_nextTask.fetch_add(1, std::memory_order_relaxed)) < m_taskCount)
+		m_task(threadIndex, task);
+}
+
+void VideoScopeAnalyzer::workerThread(unsigned threadIndex)
+{
+	uint64_t jobGeneration = 0;
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	while (true)
+	{
+		m_workCondition.wait(lock, [&] { return m_stopWorkers || m_jobGeneration != jobGeneration; });
+		if (m_stopWorkers)
+			break;
+
+		jobGeneration = m_jobGeneration;
+
+		lock.unlock();
+		runTasks(threadIndex);
+		lock.lock();
+
+		if (--m_busyWorkers == 0)
+			m_doneCondition.notify_all();
+	}
+}
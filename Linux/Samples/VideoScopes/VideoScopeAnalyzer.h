@@ -0,0 +1,183 @@
+/* -LICENSE-START-
+** Copyright (c) 2022 Blackmagic Design
+**  
+** Permission is hereby granted, free of charge, to any person or organization 
+** obtaining a copy of the software and accompanying documentation (the 
+** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+** and transmit the Software, and to prepare derivative works of the Software, 
+** and to permit third-parties to whom the Software is furnished to do so, in 
+** accordance with:
+** 
+** (1) if the Software is obtained from Blackmagic Design, the End User License 
+** Agreement for the Software Development Kit (“EULA”) available at 
+** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+** 
+** (2) if the Software is obtained from any third party, such licensing terms 
+** as notified by that third party,
+** 
+** and all subject to the following:
+** 
+** (3) the copyright notices in the Software and this entire statement, 
+** including the above license grant, this restriction and the following 
+** disclaimer, must be included in all copies of the Software, in whole or in 
+** part, and all derivative works of the Software, unless such copies or 
+** derivative works are solely in the form of machine-executable object code 
+** generated by a source language processor.
+** 
+** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+** DEALINGS IN THE SOFTWARE.
+** 
+** A copy of the Software is available free of charge at 
+** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+** 
+** -LICENSE-END-
+*/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+#include "DeckLinkAPI.h"
+
+// Scopes of one analysed frame.  Levels are 10-bit limited range code values divided by 4, so black is level 16 and
+// white is level 235 for Y and for R, G and B, and neutral chroma is level 128.  RGB frames are converted to YCbCr
+// and YCbCr frames to RGB with Rec.709 coefficients, so every frame has all of the scopes.
+struct VideoScopeData
+{
+	static const uint32_t	kLevels = 256;
+
+	uint32_t				waveformColumns;
+	std::vector<uint32_t>	lumaWaveform;		// kLevels rows of waveformColumns, indexed by level * waveformColumns + column
+	std::vector<uint32_t>	rgbParade;			// R, G and B waveforms in turn, each laid out as lumaWaveform
+	std::vector<uint32_t>	vectorscope;		// kLevels rows of kLevels, indexed by Cr level * kLevels + Cb level
+	std::vector<uint32_t>	histograms;			// Y, R, G and B histograms in turn, kLevels each
+	uint64_t				sampleCount;
+	uint64_t				gamutErrorCount;	// Samples with R, G or B outside the EBU R 103 tolerance of -5% to 105%
+	uint64_t				frameCount;			// Number of frames analysed, including this one
+	uint32_t				width;
+	uint32_t				height;
+	BMDPixelFormat			pixelFormat;
+};
+
+// Summary of a frame's scopes for logging or a metrics exporter, levels are percent of black to white
+struct VideoScopeSummary
+{
+	double					lumaMinimum;
+	double					lumaAverage;
+	double					lumaMaximum;
+	double					belowBlackPercent;	// Percent of samples with Y below black
+	double					aboveWhitePercent;	// Percent of samples with Y above white
+	double					gamutErrorPercent;
+};
+
+// The VideoScopeAnalyzer builds a luma waveform, an RGB parade, a vectorscope and histograms from 8-bit YUV (UYVY),
+// 10-bit YUV (v210), 10-bit RGB (r210) or 8-bit BGRA frames.
+//
+// Every horizontalStep'th pixel of every verticalStep'th row is sampled.  Sampled rows are split into bands that are
+// processed in parallel by a pool of worker threads and the calling thread.  Each sampled row is unpacked to 10-bit
+// components by gathering the words that hold them through a table of offsets and shifts, built when the frame
+// width or pixel format changes, and converted to levels of all six components, with AVX2 or NEON when the CPU
+// supports it.  Levels are counted into scopes private to the thread, so no atomics are needed, interleaving four
+// segments of the row so that runs of equal samples do not serialise on the same counter.  The private scopes are
+// then summed in parallel into the frame's scopes and histograms are taken from the waveforms.
+//
+// analyze() may only be called from one thread at a time.  getLatestData() is thread-safe, so a UI or exporter
+// can take the scopes of the most recent frame on its own timer.
+class VideoScopeAnalyzer
+{
+public:
+	// threadCount includes the thread calling analyze(), 0 uses one thread per CPU
+	VideoScopeAnalyzer(uint32_t waveformColumns = 256, uint32_t horizontalStep = 2, uint32_t verticalStep = 2, unsigned threadCount = 0);
+	virtual ~VideoScopeAnalyzer();
+
+	// Returns false if the pixel format is unsupported
+	bool					analyze(const void* pixels, uint32_t rowBytes, uint32_t width, uint32_t height, BMDPixelFormat pixelFormat);
+	bool					analyze(IDeckLinkVideoFrame* videoFrame);
+
+	// Returns false if no frame has been analysed
+	bool					getLatestData(VideoScopeData& data);
+
+	unsigned				getThreadCount(void) const { return (unsigned)m_workerThreads.size() + 1; }
+	const char*				getConversionKernelName(void) const;
+
+	static bool				isPixelFormatSupported(BMDPixelFormat pixelFormat);
+	static void				summarize(const VideoScopeData& data, VideoScopeSummary& summary);
+
+	// Draw scope counts as an 8-bit greyscale image with a logarithmic intensity scale, the highest level at the
+	// top.  image must have width * height bytes.
+	static void				renderDensity(const uint32_t* counts, uint32_t width, uint32_t height, uint8_t* image);
+
+private:
+	using UnpackFunction = void (*)(const uint8_t* row, const uint32_t* const offsets[3], const uint32_t* const shifts[3], uint32_t count, BMDPixelFormat pixelFormat, uint16_t* const components[3]);
+	using ConvertFunction = uint32_t (*)(const uint16_t* const components[3], uint32_t count, uint8_t* const levels[6]);
+
+	// Per thread rows and scopes, the scopes are cleared as they are summed
+	struct ThreadScratch
+	{
+		std::vector<uint16_t>	components[3];		// Y Cb Cr or R G B of each sampled pixel, 10-bit
+		std::vector<uint8_t>	levels[6];			// Y Cb Cr R G B levels of each sampled pixel
+		std::vector<uint32_t>	lumaWaveform;
+		std::vector<uint32_t>	rgbParade;
+		std::vector<uint32_t>	vectorscope;
+		uint64_t				sampleCount;
+		uint64_t				gamutErrorCount;
+		bool					used;
+	};
+
+	struct AnalyzeJob
+	{
+		const uint8_t*			pixels;
+		uint32_t				rowBytes;
+		uint32_t				width;
+		uint32_t				height;
+		BMDPixelFormat			pixelFormat;
+		uint32_t				sampledRowCount;
+		uint32_t				bandCount;
+	};
+
+	uint32_t					m_horizontalStep;
+	uint32_t					m_verticalStep;
+	UnpackFunction				m_unpackFunction;
+	ConvertFunction				m_convertYCbCrFunction;
+	ConvertFunction				m_convertRGBFunction;
+	std::vector<ThreadScratch>	m_scratch;
+	std::vector<uint16_t>		m_sampleColumns;		// Waveform column of each sampled pixel
+	std::vector<uint32_t>		m_sampleOffsets[3];		// Byte offset in the row of the 32-bit word holding each component
+	std::vector<uint32_t>		m_sampleShifts[3];		// Shift of each component in its word
+	BMDPixelFormat				m_samplePixelFormat;
+	AnalyzeJob					m_job;
+	VideoScopeData				m_data;
+	//
+	std::mutex					m_latestDataMutex;
+	VideoScopeData				m_latestData;
+	//
+	std::vector<std::thread>			m_workerThreads;
+	std::function<void(unsigned, unsigned)>	m_task;
+	unsigned							m_taskCount;
+	std::atomic<unsigned>				m_nextTask;
+	std::mutex							m_mutex;
+	std::condition_variable				m_workCondition;
+	std::condition_variable				m_doneCondition;
+	uint64_t							m_jobGeneration;
+	unsigned							m_busyWorkers;
+	bool								m_stopWorkers;
+
+	void					analyzeBand(unsigned threadIndex, unsigned band);
+	void					sumScopes(unsigned task);
+	void					buildSampleLayout(uint32_t width, BMDPixelFormat pixelFormat);
+
+	// Worker pool, the task is called with the index of the thread running it
+	void					parallelFor(unsigned taskCount, const std::function<void(unsigned, unsigned)>& task);
+	void					runTasks(unsigned threadIndex);
+	void					workerThread(unsigned threadIndex);
+};
@@ -0,0 +1,391 @@
+/* -LICENSE-START-
+** Copyright (c) 2022 Blackmagic Design
+**  
+** Permission is hereby granted, free of charge, to any person or organization 
+** obtaining a copy of the software and accompanying documentation (the 
+** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+** and transmit the Software, and to prepare derivative works of the Software, 
+** and to permit third-parties to whom the Software is furnished to do so, in 
+** accordance with:
+** 
+** (1) if the Software is obtained from Blackmagic Design, the End User License 
+** Agreement for the Software Development Kit (“EULA”) available at 
+** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+** 
+** (2) if the Software is obtained from any third party, such licensing terms 
+** as notified by that third party,
+** 
+** and all subject to the following:
+** 
+** (3) the copyright notices in the Software and this entire statement, 
+** including the above license grant, this restriction and the following 
+** disclaimer, must be included in all copies of the Software, in whole or in 
+** part, and all derivative works of the Software, unless such copies or 
+** derivative works are solely in the form of machine-executable object code 
+** generated by a source language processor.
+** 
+** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+** DEALINGS IN THE SOFTWARE.
+** 
+** A copy of the Software is available free of charge at 
+** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+** 
+** -LICENSE-END-
+*/
+
+//*************************************************************************************/
+// Note to developers:
+//
+// The VideoScopes sample captures a DeckLink input and builds a luma waveform, an RGB
+// parade, a vectorscope and histograms of the latest frame, as a confidence monitor
+// without external scope hardware.
+//
+// Performance considerations:
+// * VideoScopeAnalyzer samples every second pixel of every second row by default, splits
+//     the sampled rows into bands on a pool of kAnalyzerThreadCount threads and converts
+//     them with AVX2 or NEON.  Run with --benchmark to measure the analyzer at 2160p
+//     without devices
+// * Analysis runs on its own thread and always takes the latest captured frame, so if
+//     analysis is slower than the input frame rate frames are skipped rather than queued
+//
+// Additional considerations:
+// * The input follows format detection and is captured in the detected colour space and
+//     bit depth, so the scopes show the levels of the signal itself
+// * The scope data is copied out of the analyzer with getLatestData(), which can be
+//     called from a UI or metrics exporter thread at its own rate.  With --output, the
+//     scopes are written as greyscale PGM images every kStatisticsUpdateRateMs
+// * Press <RETURN> to exit
+//*************************************************************************************/
+
+
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdio.h>
+#include <string.h>
+
+#include "VideoScopeAnalyzer.h"
+#include "VideoScopesBenchmark.h"
+#include "VideoScopesInput.h"
+#include "DeckLinkAPI.h"
+#include "com_ptr.h"
+#include "platform.h"
+
+const BMDDisplayMode		kInitialInputDisplayMode	= bmdModeHD1080p5994;
+const uint32_t				kWaveformColumns			= 256;
+const uint32_t				kHorizontalStep				= 2;		// Sample every second pixel
+const uint32_t				kVerticalStep				= 2;		// of every second row
+const unsigned				kAnalyzerThreadCount		= 0;		// Number of threads used to analyse each frame, 0 for one per CPU
+const long					kStatisticsUpdateRateMs		= 2000;		// Print scope summary every 2 seconds
+const uint32_t				kDefaultBenchmarkWidth		= 3840;
+const uint32_t				kDefaultBenchmarkHeight		= 2160;
+
+std::string getDeckLinkDisplayName(com_ptr<IDeckLink> deckLink)
+{
+	dlstring_t		displayName;
+	std::string		displayNameString;
+
+	if (deckLink->GetDisplayName(&displayName) == S_OK)
+	{
+		displayNameString = DlToStdString(displayName);
+		DeleteString(displayName);
+	}
+	else
+	{
+		displayNameString = "Unknown";
+	}
+
+	return displayNameString;
+}
+
+const char* getPixelFormatName(BMDPixelFormat pixelFormat)
+{
+	switch (pixelFormat)
+	{
+		case bmdFormat8BitYUV:		return "8-bit YUV";
+		case bmdFormat10BitYUV:		return "10-bit YUV";
+		case bmdFormat10BitRGB:		return "10-bit RGB";
+		case bmdFormat8BitBGRA:		return "8-bit BGRA";
+		default:					return "unsupported";
+	}
+}
+
+bool writeDensityImage(const std::string& path, const uint32_t* counts, uint32_t width, uint32_t height)
+{
+	std::vector<uint8_t>	image(width * height);
+	FILE*					file = fopen(path.c_str(), "wb");
+
+	if (!file)
+		return false;
+
+	VideoScopeAnalyzer::renderDensity(counts, width, height, image.data());
+
+	fprintf(file, "P5\n%u %u\n255\n", width, height);
+	bool written = fwrite(image.data(), 1, image.size(), file) == image.size();
+
+	return (fclose(file) == 0) && written;
+}
+
+bool writeScopeImages(const std::string& prefix, const VideoScopeData& data)
+{
+	const uint32_t	waveformSize = data.waveformColumns * VideoScopeData::kLevels;
+	const char*		paradeNames[] = { "red", "green", "blue" };
+
+	if (!writeDensityImage(prefix + "_waveform.pgm", data.lumaWaveform.data(), data.waveformColumns, VideoScopeData::kLevels) ||
+		!writeDensityImage(prefix + "_vectorscope.pgm", data.vectorscope.data(), VideoScopeData::kLevels, VideoScopeData::kLevels))
+		return false;
+
+	for (unsigned component = 0; component < 3; component++)
+	{
+		if (!writeDensityImage(prefix + "_parade_" + paradeNames[component] + ".pgm", &data.rgbParade[component * waveformSize],
+							   data.waveformColumns, VideoScopeData::kLevels))
+			return false;
+	}
+
+	return true;
+}
+
+void printSummary(VideoScopeAnalyzer& analyzer, com_ptr<VideoScopesInput>& input, const std::string& outputPrefix,
+				  uint64_t& lastFrameCount, uint64_t skippedFrames, double averageAnalysisTimeMs)
+{
+	VideoScopeData		data;
+	VideoScopeSummary	summary;
+
+	if (!analyzer.getLatestData(data))
+	{
+		printf("No input signal\n");
+		return;
+	}
+
+	VideoScopeAnalyzer::summarize(data, summary);
+
+	printf("%s %s: %llu frames analysed (%llu skipped), average %.2f ms; Luma %.1f%% / %.1f%% / %.1f%% (min/avg/max), "
+		   "%.2f%% below black, %.2f%% above white; %.2f%% gamut errors\n",
+			input->getDisplayModeName().c_str(), getPixelFormatName(data.pixelFormat),
+			(unsigned long long)(data.frameCount - lastFrameCount), (unsigned long long)skippedFrames, averageAnalysisTimeMs,
+			summary.lumaMinimum, summary.lumaAverage, summary.lumaMaximum,
+			summary.belowBlackPercent, summary.aboveWhitePercent, summary.gamutErrorPercent);
+
+	lastFrameCount = data.frameCount;
+
+	if (!outputPrefix.empty() && !writeScopeImages(outputPrefix, data))
+		fprintf(stderr, "Unable to write scope images to %s\n", outputPrefix.c_str());
+}
+
+HRESULT VideoScopes(int deviceIndex, const std::string& outputPrefix)
+{
+	HRESULT								result;
+
+	com_ptr<IDeckLinkIterator>			deckLinkIterator;
+	com_ptr<IDeckLink>					deckLink;
+	com_ptr<VideoScopesInput>			input;
+	int									index = 0;
+
+	VideoScopeAnalyzer					analyzer(kWaveformColumns, kHorizontalStep, kVerticalStep, kAnalyzerThreadCount);
+
+	std::mutex							sessionMutex;
+	std::condition_variable				sessionCondition;
+	bool								sessionComplete = false;
+
+	std::mutex							statisticsMutex;
+	uint64_t							skippedFrames = 0;
+	uint64_t							analysedFrames = 0;
+	double								totalAnalysisTimeMs = 0.0;
+
+	result = GetDeckLinkIterator(deckLinkIterator.releaseAndGetAddressOf());
+	if (result != S_OK)
+		return result;
+
+	// Use the requested device, or the first device that can capture with input format detection
+	while (deckLinkIterator->Next(deckLink.releaseAndGetAddressOf()) == S_OK)
+	{
+		com_ptr<IDeckLinkProfileAttributes>	deckLinkAttributes(IID_IDeckLinkProfileAttributes, deckLink);
+		int64_t								videoIOSupport;
+		bool								supportsInputFormatDetection;
+
+		if ((deviceIndex >= 0) && (index++ != deviceIndex))
+			continue;
+
+		if (!deckLinkAttributes ||
+			(deckLinkAttributes->GetInt(BMDDeckLinkVideoIOSupport, &videoIOSupport) != S_OK) ||
+			(((BMDVideoIOSupport)videoIOSupport & bmdDeviceSupportsCapture) == 0) ||
+			(deckLinkAttributes->GetFlag(BMDDeckLinkSupportsInputFormatDetection, &supportsInputFormatDetection) != S_OK) ||
+			!supportsInputFormatDetection)
+			continue;
+
+		try
+		{
+			input = make_com_ptr<VideoScopesInput>(deckLink);
+		}
+		catch (const std::exception& e)
+		{
+			fprintf(stderr, "%s\n", e.what());
+			continue;
+		}
+		printf("Using input device: %s\n", getDeckLinkDisplayName(deckLink).c_str());
+		break;
+	}
+
+	if (!input)
+	{
+		fprintf(stderr, "Unable to find an input device that supports input format detection\n");
+		return E_FAIL;
+	}
+
+	if (!input->startCapture(kInitialInputDisplayMode))
+	{
+		fprintf(stderr, "Unable to enable input\n");
+		return E_ACCESSDENIED;
+	}
+
+	printf("Analysing with %u threads using %s conversion, press <RETURN> to stop/exit\n",
+			analyzer.getThreadCount(), analyzer.getConversionKernelName());
+
+	std::thread analysisThread([&]
+	{
+		uint64_t	lastSequence = 0;
+
+		std::unique_lock<std::mutex> lock(sessionMutex);
+		while (!sessionComplete)
+		{
+			com_ptr<IDeckLinkVideoInputFrame>	videoFrame;
+			uint64_t							sequence;
+
+			lock.unlock();
+
+			bool hasFrame = input->getLatestFrame(videoFrame, sequence);
+			if (hasFrame && (sequence != lastSequence))
+			{
+				auto startTime = std::chrono::steady_clock::now();
+				bool analysed = analyzer.analyze(videoFrame.get());
+				std::chrono::duration<double, std::milli> analysisTime = std::chrono::steady_clock::now() - startTime;
+
+				std::lock_guard<std::mutex> statisticsLock(statisticsMutex);
+				if ((lastSequence != 0) && (sequence > lastSequence + 1))
+					skippedFrames += sequence - lastSequence - 1;
+				if (analysed)
+				{
+					totalAnalysisTimeMs += analysisTime.count();
+					analysedFrames++;
+				}
+			}
+			lastSequence = sequence;
+
+			lock.lock();
+			// Wait for the next frame when the latest frame has been analysed
+			if (!hasFrame || (sequence == lastSequence))
+				sessionCondition.wait_for(lock, std::chrono::milliseconds(1), [&] { return sessionComplete; });
+		}
+	});
+
+	std::thread statisticsThread([&]
+	{
+		uint64_t	lastFrameCount = 0;
+
+		std::unique_lock<std::mutex> lock(sessionMutex);
+		while (!sessionCondition.wait_for(lock, std::chrono::milliseconds(kStatisticsUpdateRateMs), [&] { return sessionComplete; }))
+		{
+			uint64_t	intervalSkippedFrames;
+			double		averageAnalysisTimeMs;
+
+			{
+				std::lock_guard<std::mutex> statisticsLock(statisticsMutex);
+				intervalSkippedFrames = skippedFrames;
+				averageAnalysisTimeMs = (analysedFrames > 0) ? totalAnalysisTimeMs / analysedFrames : 0.0;
+				skippedFrames = 0;
+				analysedFrames = 0;
+				totalAnalysisTimeMs = 0.0;
+			}
+
+			printSummary(analyzer, input, outputPrefix, lastFrameCount, intervalSkippedFrames, averageAnalysisTimeMs);
+		}
+	});
+
+	std::string line;
+	std::getline(std::cin, line);
+
+	{
+		std::lock_guard<std::mutex> lock(sessionMutex);
+		sessionComplete = true;
+	}
+	sessionCondition.notify_all();
+	statisticsThread.join();
+	analysisThread.join();
+
+	input->stopCapture();
+
+	printf("\nVideoScopes complete\n\n");
+
+	return S_OK;
+}
+
+void printUsage(const char* name)
+{
+	printf("%s [options]\n"
+		   "\n"
+		   "Options:\n"
+		   "    -h, --help                Display this help message\n"
+		   "    -d, --device <index>      Input device index (default first device with input format detection)\n"
+		   "    -o, --output <prefix>     Write the waveform, RGB parade and vectorscope as <prefix>_*.pgm images\n"
+		   "                              every %ld seconds\n"
+		   "    -b, --benchmark <frames>  Analyse <frames> synthetic frames in each pixel format and print the\n"
+		   "                              frame rate, without DeckLink devices\n"
+		   "    -s, --size <W>x<H>        Frame size for benchmark mode (default %ux%u)\n"
+		   "    -t, --threads <count>     Analyzer threads for benchmark mode (default one per CPU)\n",
+		   name, kStatisticsUpdateRateMs / 1000, kDefaultBenchmarkWidth, kDefaultBenchmarkHeight);
+}
+
+int main(int argc, const char * argv[])
+{
+	int			deviceIndex = -1;
+	std::string	outputPrefix;
+	unsigned	benchmarkFrames = 0;
+	unsigned	benchmarkThreads = 0;
+	uint32_t	benchmarkWidth = kDefaultBenchmarkWidth;
+	uint32_t	benchmarkHeight = kDefaultBenchmarkHeight;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if ((strcmp(argv[i], "--device") == 0 || strcmp(argv[i], "-d") == 0) && (i + 1 < argc))
+			deviceIndex = atoi(argv[++i]);
+		else if ((strcmp(argv[i], "--output") == 0 || strcmp(argv[i], "-o") == 0) && (i + 1 < argc))
+			outputPrefix = argv[++i];
+		else if ((strcmp(argv[i], "--benchmark") == 0 || strcmp(argv[i], "-b") == 0) && (i + 1 < argc))
+			benchmarkFrames = (unsigned)strtoul(argv[++i], nullptr, 10);
+		else if ((strcmp(argv[i], "--threads") == 0 || strcmp(argv[i], "-t") == 0) && (i + 1 < argc))
+			benchmarkThreads = (unsigned)strtoul(argv[++i], nullptr, 10);
+		else if ((strcmp(argv[i], "--size") == 0 || strcmp(argv[i], "-s") == 0) && (i + 1 < argc))
+		{
+			if ((sscanf(argv[++i], "%ux%u", &benchmarkWidth, &benchmarkHeight) != 2) || (benchmarkWidth == 0) || (benchmarkHeight == 0))
+			{
+				fprintf(stderr, "Invalid frame size: %s\n", argv[i]);
+				return EXIT_FAILURE;
+			}
+		}
+		else if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0)
+		{
+			printUsage(argv[0]);
+			return EXIT_SUCCESS;
+		}
+		else
+		{
+			fprintf(stderr, "Unknown argument: %s\n", argv[i]);
+			printUsage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (benchmarkFrames > 0)
+		return RunVideoScopesBenchmark(benchmarkWidth, benchmarkHeight, benchmarkFrames, benchmarkThreads) ? EXIT_SUCCESS : EXIT_FAILURE;
+
+	return (VideoScopes(deviceIndex, outputPrefix) == S_OK) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
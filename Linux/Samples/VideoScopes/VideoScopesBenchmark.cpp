@@ -0,0 +1,221 @@
+/* -LICENSE-START-
+** Copyright (c) 2022 Blackmagic Design
+**  
+** Permission is hereby granted, free of charge, to any person or organization 
+** obtaining a copy of the software and accompanying documentation (the 
+** "Software") to use, reproduce, display, distribute, sub-license, execute, 
+** and transmit the Software, and to prepare derivative works of the Software, 
+** and to permit third-parties to whom the Software is furnished to do so, in 
+** accordance with:
+** 
+** (1) if the Software is obtained from Blackmagic Design, the End User License 
+** Agreement for the Software Development Kit (“EULA”) available at 
+** https://www.blackmagicdesign.com/EULA/DeckLinkSDK; or
+** 
+** (2) if the Software is obtained from any third party, such licensing terms 
+** as notified by that third party,
+** 
+** and all subject to the following:
+** 
+** (3) the copyright notices in the Software and this entire statement, 
+** including the above license grant, this restriction and the following 
+** disclaimer, must be included in all copies of the Software, in whole or in 
+** part, and all derivative works of the Software, unless such copies or 
+** derivative works are solely in the form of machine-executable object code 
+** generated by a source language processor.
+** 
+** (4) THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+** FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT 
+** SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE 
+** FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE, 
+** ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+** DEALINGS IN THE SOFTWARE.
+** 
+** A copy of the Software is available free of charge at 
+** https://www.blackmagicdesign.com/desktopvideo_sdk under the EULA.
+** 
+** -LICENSE-END-
+*/
+
+#include <chrono>
+#include <cmath>
+#include <stdio.h>
+#include <vector>
+
+#include "VideoScopeAnalyzer.h"
+#include "VideoScopesBenchmark.h"
+
+static const double		kTargetFrameRate	= 60.0;
+
+// 75% colour bars as R G B, white to black
+static const double		kColourBars[8][3] =
+{
+	{ 0.75, 0.75, 0.75 }, { 0.75, 0.75, 0.0 }, { 0.0, 0.75, 0.75 }, { 0.0, 0.75, 0.0 },
+	{ 0.75, 0.0, 0.75 }, { 0.75, 0.0, 0.0 }, { 0.0, 0.0, 0.75 }, { 0.0, 0.0, 0.0 },
+};
+
+// Limited range 10-bit code values of each pixel in R G B and Y Cb Cr, colour bars above a grey ramp
+struct TestPixel
+{
+	uint16_t	rgb[3];
+	uint16_t	ycbcr[3];
+};
+
+static TestPixel makeTestPixel(uint32_t x, uint32_t y, uint32_t width, uint32_t height)
+{
+	double		rgb[3];
+	TestPixel	pixel;
+
+	if (y < height * 3 / 4)
+	{
+		for (unsigned i = 0; i < 3; i++)
+			rgb[i] = kColourBars[x * 8 / width][i];
+	}
+	else
+	{
+		rgb[0] = rgb[1] = rgb[2] = (double)x / (width - 1);
+	}
+
+	double luma = 0.2126 * rgb[0] + 0.7152 * rgb[1] + 0.0722 * rgb[2];
+	double ycbcr[3] = { luma, (rgb[2] - luma) / 1.8556, (rgb[0] - luma) / 1.5748 };
+
+	for (unsigned i = 0; i < 3; i++)
+		pixel.rgb[i] = (uint16_t)std::lround(64.0 + rgb[i] * 876.0);
+
+	pixel.ycbcr[0] = (uint16_t)std::lround(64.0 + ycbcr[0] * 876.0);
+	pixel.ycbcr[1] = (uint16_t)std::lround(512.0 + ycbcr[1] * 896.0);
+	pixel.ycbcr[2] = (uint16_t)std::lround(512.0 + ycbcr[2] * 896.0);
+
+	return pixel;
+}
+
+static uint32_t getRowBytes(uint32_t width, BMDPixelFormat pixelFormat)
+{
+	switch (pixelFormat)
+	{
+		case bmdFormat8BitYUV:		return width * 2;
+		case bmdFormat10BitYUV:		return ((width + 47) / 48) * 128;
+		default:					return width * 4;
+	}
+}
+
+static void fillTestFrame(std::vector<uint8_t>& frame, uint32_t width, uint32_t height, BMDPixelFormat pixelFormat)
+{
+	uint32_t rowBytes = getRowBytes(width, pixelFormat);
+
+	frame.assign((size_t)rowBytes * height, 0);
+
+	for (uint32_t y = 0; y < height; y++)
+	{
+		uint8_t*	row = &frame[(size_t)y * rowBytes];
+		uint32_t*	words = (uint32_t*)row;
+
+		for (uint32_t x = 0; x < width; x++)
+		{
+			TestPixel pixel = makeTestPixel(x, y, width, height);
+
+			switch (pixelFormat)
+			{
+				case bmdFormat8BitYUV:
+					// Chroma is taken from the first pixel of each pair
+					row[x * 2 + 1] = (uint8_t)(pixel.ycbcr[0] >> 2);
+					if ((x & 1) == 0)
+					{
+						row[x * 2] = (uint8_t)(pixel.ycbcr[1] >> 2);
+						row[x * 2 + 2] = (uint8_t)(pixel.ycbcr[2] >> 2);
+					}
+					break;
+
+				case bmdFormat10BitYUV:
+				{
+					// Cb0 Y0 Cr0 | Y1 Cb2 Y2 | Cr2 Y3 Cb4 | Y4 Cr4 Y5, chroma from the first pixel of each pair
+					static const uint8_t	kLumaSlot[6] = { 1, 3, 5, 7, 9, 11 };
+					static const uint8_t	kCbSlot[3] = { 0, 4, 8 };
+					static const uint8_t	kCrSlot[3] = { 2, 6, 10 };
+					uint32_t*				group = words + (x / 6) * 4;
+					uint32_t				pixelInGroup = x % 6;
+
+					auto setSlot = [group](unsigned slot, uint16_t value) { group[slot / 3] |= (uint32_t)value << ((slot % 3) * 10); };
+
+					setSlot(kLumaSlot[pixelInGroup], pixel.ycbcr[0]);
+					if ((pixelInGroup & 1) == 0)
+					{
+						setSlot(kCbSlot[pixelInGroup / 2], pixel.ycbcr[1]);
+						setSlot(kCrSlot[pixelInGroup / 2], pixel.ycbcr[2]);
+					}
+					break;
+				}
+
+				case bmdFormat10BitRGB:
+					words[x] = __builtin_bswap32(((uint32_t)pixel.rgb[0] << 20) | ((uint32_t)pixel.rgb[1] << 10) | pixel.rgb[2]);
+					break;
+
+				case bmdFormat8BitBGRA:
+					for (unsigned i = 0; i < 3; i++)
+						row[x * 4 + 2 - i] = (uint8_t)std::lround((pixel.rgb[i] - 64) * 255.0 / 876.0);
+					row[x * 4 + 3] = 255;
+					break;
+
+				default:
+					break;
+			}
+		}
+	}
+}
+
+static double measureFrameRate(VideoScopeAnalyzer& analyzer, const std::vector<uint8_t>& frame, uint32_t width, uint32_t height,
+							   BMDPixelFormat pixelFormat, unsigned frameCount)
+{
+	uint32_t rowBytes = getRowBytes(width, pixelFormat);
+
+	// First frame sizes the analyzer's working rows
+	analyzer.analyze(frame.data(), rowBytes, width, height, pixelFormat);
+
+	auto startTime = std::chrono::steady_clock::now();
+
+	for (unsigned i = 0; i < frameCount; i++)
+		analyzer.analyze(frame.data(), rowBytes, width, height, pixelFormat);
+
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+	return frameCount / elapsed.count();
+}
+
+bool RunVideoScopesBenchmark(uint32_t width, uint32_t height, unsigned frameCount, unsigned threadCount)
+{
+	const BMDPixelFormat	pixelFormats[] = { bmdFormat8BitYUV, bmdFormat10BitYUV, bmdFormat10BitRGB, bmdFormat8BitBGRA };
+	const char*				pixelFormatNames[] = { "8-bit YUV", "10-bit YUV", "10-bit RGB", "8-bit BGRA" };
+	VideoScopeAnalyzer		analyzer(256, 2, 2, threadCount);
+	VideoScopeAnalyzer		fullAnalyzer(256, 1, 1, threadCount);
+	std::vector<uint8_t>	frame;
+
+	if ((width < 8) || (height < 4))
+	{
+		fprintf(stderr, "Frame size %ux%u is too small\n", width, height);
+		return false;
+	}
+
+	printf("Analysing %u %ux%u frames of 75%% colour bars with %u threads using %s conversion\n",
+			frameCount, width, height, analyzer.getThreadCount(), analyzer.getConversionKernelName());
+
+	for (size_t i = 0; i < sizeof(pixelFormats) / sizeof(pixelFormats[0]); i++)
+	{
+		VideoScopeData		data;
+		VideoScopeSummary	summary;
+
+		fillTestFrame(frame, width, height, pixelFormats[i]);
+
+		double frameRate = measureFrameRate(analyzer, frame, width, height, pixelFormats[i], frameCount);
+		double fullFrameRate = measureFrameRate(fullAnalyzer, frame, width, height, pixelFormats[i], frameCount);
+
+		analyzer.getLatestData(data);
+		VideoScopeAnalyzer::summarize(data, summary);
+
+		printf("  %-10s  Luma %5.1f%% to %5.1f%%, gamut errors %.2f%%  1/4 sampled: %7.1f frames/s (%6.2f ms/frame)  all pixels: %7.1f frames/s (%6.2f ms/frame)  %s\n",
+				pixelFormatNames[i], summary.lumaMinimum, summary.lumaMaximum, summary.gamutErrorPercent,
+				frameRate, 1000.0 / frameRate, fullFrameRate, 1000.0 / fullFrameRate,
+				(frameRate >= kTargetFrameRate) ? "real-time at 60 fps" : "below 60 fps");
+	}
+
+	return true;
+}